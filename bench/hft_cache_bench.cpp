@@ -0,0 +1,221 @@
+#include "benchmark_suite.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs every combination of the listed targets, thread counts, batch sizes,
+// read ratios and skews, one result per line. Equal arguments issue equal
+// operations, so two builds can be compared run for run.
+//
+//   hft_cache_bench --target=radial,btree --threads=1,4 --batch=1,64 --format=csv
+//
+// With --replay it plays a recorded trace instead, once for every
+// combination of the listed cache sizes and TTL scales:
+//
+//   hft_cache_bench --replay=open.trace --speed=1 --max-nodes=50000,200000 --l1-capacity=1000,4000
+
+namespace {
+
+using namespace hft_cache;
+
+void usage(std::ostream& out) {
+    out << "usage: hft_cache_bench [options]\n"
+           "  --target=LIST      radial, multi_level, btree, skip_list, bloom, counting_bloom,\n"
+           "                     cuckoo, node_pool, advanced_pool, or all (default radial)\n"
+           "  --threads=LIST     workers (default 1)\n"
+           "  --batch=LIST       operations per call (default 1)\n"
+           "  --read-ratio=LIST  share of calls that read (default 0.5)\n"
+           "  --zipf=LIST        symbol skew, 0 for uniform (default 0.99)\n"
+           "  --ops=N            timed calls per worker (default 100000)\n"
+           "  --warmup=N         untimed calls per worker first (default 10000)\n"
+           "  --symbols=N        distinct symbols (default 64)\n"
+           "  --keys=N           keys per symbol, all preloaded (default 256)\n"
+           "  --rate=R           calls per second per worker, open loop; 0 for closed loop (default 0)\n"
+           "  --pin              pin worker i to CPU i\n"
+           "  --seed=N           workload seed (default 1)\n"
+           "  --format=json|csv  JSON lines or CSV with a header (default json)\n"
+           "replay mode:\n"
+           "  --replay=PATH      play the trace at PATH against radial or multi_level (default multi_level)\n"
+           "  --speed=S          1 at recorded speed, 2 twice as fast, 0 as fast as possible (default 1)\n"
+           "  --max-nodes=LIST   CacheConfig::max_nodes (default 10000)\n"
+           "  --l1-capacity=LIST CacheConfig::l1_capacity (default 1000)\n"
+           "  --ttl-scale=LIST   multiplies each insert's time to live (default 1)\n"
+           "  --threads and --pin as above; symbols are split between the workers\n";
+}
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+template <typename T>
+bool parse_list(const std::string& list, std::vector<T>& out) {
+    out.clear();
+    for (const std::string& item : split(list)) {
+        std::istringstream in(item);
+        T value;
+        if (!(in >> value) || !in.eof()) return false;
+        out.push_back(value);
+    }
+    return !out.empty();
+}
+
+template <typename T>
+bool parse_value(const std::string& text, T& out) {
+    std::vector<T> values;
+    if (!parse_list(text, values) || values.size() != 1) return false;
+    out = values[0];
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    WorkloadOptions base;
+    std::vector<BenchmarkTarget> targets = {BenchmarkTarget::RADIAL};
+    std::vector<size_t> threads = {1};
+    std::vector<size_t> batches = {1};
+    std::vector<double> read_ratios = {base.read_ratio};
+    std::vector<double> skews = {base.zipf_skew};
+    bool csv = false;
+    std::string replay_path;
+    bool target_given = false;
+    double speed = 1.0;
+    std::vector<size_t> max_nodes = {CacheConfig().max_nodes};
+    std::vector<size_t> l1_capacities = {CacheConfig().l1_capacity};
+    std::vector<double> ttl_scales = {1.0};
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? std::string() : arg.substr(equals + 1);
+        bool ok = true;
+
+        if (name == "--help" || name == "-h") {
+            usage(std::cout);
+            return 0;
+        } else if (name == "--target") {
+            targets.clear();
+            for (const std::string& item : split(value)) {
+                if (item == "all") {
+                    for (size_t t = 0; t < static_cast<size_t>(BenchmarkTarget::COUNT); ++t)
+                        targets.push_back(static_cast<BenchmarkTarget>(t));
+                    continue;
+                }
+                BenchmarkTarget target;
+                ok = ok && parse_benchmark_target(item, target);
+                if (ok) targets.push_back(target);
+            }
+            ok = ok && !targets.empty();
+            target_given = true;
+        } else if (name == "--threads") {
+            ok = parse_list(value, threads);
+        } else if (name == "--batch") {
+            ok = parse_list(value, batches);
+        } else if (name == "--read-ratio") {
+            ok = parse_list(value, read_ratios);
+        } else if (name == "--zipf") {
+            ok = parse_list(value, skews);
+        } else if (name == "--ops") {
+            ok = parse_value(value, base.operations);
+        } else if (name == "--warmup") {
+            ok = parse_value(value, base.warmup);
+        } else if (name == "--symbols") {
+            ok = parse_value(value, base.symbols);
+        } else if (name == "--keys") {
+            ok = parse_value(value, base.keys_per_symbol);
+        } else if (name == "--rate") {
+            ok = parse_value(value, base.rate);
+        } else if (name == "--seed") {
+            ok = parse_value(value, base.seed);
+        } else if (name == "--pin") {
+            base.pin_threads = true;
+        } else if (name == "--replay") {
+            replay_path = value;
+            ok = !value.empty();
+        } else if (name == "--speed") {
+            ok = parse_value(value, speed) && speed >= 0.0;
+        } else if (name == "--max-nodes") {
+            ok = parse_list(value, max_nodes);
+        } else if (name == "--l1-capacity") {
+            ok = parse_list(value, l1_capacities);
+        } else if (name == "--ttl-scale") {
+            ok = parse_list(value, ttl_scales);
+        } else if (name == "--format") {
+            ok = value == "json" || value == "csv";
+            csv = value == "csv";
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << "hft_cache_bench: bad argument '" << arg << "'\n";
+            usage(std::cerr);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!replay_path.empty()) {
+        ReplayTarget replay_target = ReplayTarget::MULTI_LEVEL;
+        if (target_given) {
+            if (targets.size() != 1 ||
+                (targets[0] != BenchmarkTarget::RADIAL && targets[0] != BenchmarkTarget::MULTI_LEVEL)) {
+                std::cerr << "hft_cache_bench: --replay takes --target=radial or --target=multi_level\n";
+                return EXIT_FAILURE;
+            }
+            if (targets[0] == BenchmarkTarget::RADIAL) replay_target = ReplayTarget::RADIAL;
+        }
+        Trace trace;
+        if (!load_trace(replay_path, trace)) {
+            std::cerr << "hft_cache_bench: cannot read trace '" << replay_path << "'\n";
+            return EXIT_FAILURE;
+        }
+
+        if (csv) std::cout << replay_csv_header() << "\n";
+        for (size_t nodes : max_nodes) {
+            for (size_t l1_capacity : l1_capacities) {
+                for (double ttl_scale : ttl_scales) {
+                    ReplayOptions options;
+                    options.target = replay_target;
+                    options.config.max_nodes = nodes;
+                    options.config.l1_capacity = l1_capacity;
+                    options.speed = speed;
+                    options.ttl_scale = ttl_scale;
+                    options.threads = threads[0];
+                    options.pin_threads = base.pin_threads;
+                    ReplayResult result = replay_trace(trace, options);
+                    std::cout << (csv ? format_csv(result) : format_json(result)) << std::endl;
+                }
+            }
+        }
+        return 0;
+    }
+
+    if (csv) std::cout << csv_header() << "\n";
+    for (BenchmarkTarget target : targets) {
+        for (size_t thread_count : threads) {
+            for (size_t batch : batches) {
+                for (double read_ratio : read_ratios) {
+                    for (double skew : skews) {
+                        WorkloadOptions options = base;
+                        options.target = target;
+                        options.threads = thread_count;
+                        options.batch = batch;
+                        options.read_ratio = read_ratio;
+                        options.zipf_skew = skew;
+                        WorkloadResult result = run_workload(options);
+                        std::cout << (csv ? format_csv(result) : format_json(result)) << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
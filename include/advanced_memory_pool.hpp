@@ -1,9 +1,11 @@
 #pragma once
 
 #include "node.hpp"
+#include "node_pool.hpp"
+#include "magazine_cache.hpp"
 #include "config.hpp"
 #include <vector>
-#include <stack>
+#include <string>
 #include <atomic>
 #include <thread>
 #include <memory>
@@ -12,27 +14,30 @@
 namespace hft_cache {
 
 /**
- * @brief Advanced memory pool with object recycling and per-thread optimization
- * 
- * Provides high-performance memory allocation with reduced fragmentation,
- * per-thread free lists, and automatic defragmentation.
+ * @brief Node pool with per-thread magazines over a lock-free depot
+ *
+ * Nodes are carved from slabs, up to config.max_nodes, and recycled through
+ * a MagazineCache of config.memory_pool_magazine_rounds rounds: allocation
+ * and deallocation touch only the calling thread's magazines until one runs
+ * empty or full. Aligned blocks are cached separately for reuse.
  */
 class AdvancedMemoryPool {
 public:
-    explicit AdvancedMemoryPool(const CacheConfig& config);
+    // numa_node >= 0 binds every slab to that node
+    explicit AdvancedMemoryPool(const CacheConfig& config, int numa_node = -1);
     ~AdvancedMemoryPool();
 
-    // Core allocation operations
+    // Core allocation operations; allocate_node returns nullptr at the limit
     Node* allocate_node();
     void deallocate_node(Node* node);
     void* allocate_aligned(size_t size, size_t alignment);
     void deallocate_aligned(void* ptr);
     
     // Memory management
-    void defragment();
-    void compact();
-    void resize_pool(size_t new_size);
-    void clear();
+    void defragment();                  // frees aligned blocks not in use
+    void compact();                     // also parks this thread's magazines in the depot
+    void resize_pool(size_t new_size);  // node limit; never below what is already carved
+    void clear();                       // frees every aligned block, in use or not
     
     // Statistics and monitoring
     size_t get_total_allocated() const;
@@ -40,31 +45,17 @@ public:
     size_t get_free_list_size() const;
     double get_fragmentation_ratio() const;
     size_t get_pool_size() const;
+    MagazineCache::Stats get_magazine_stats() const { return nodes_.stats(); }
+    bool owns(const Node* node) const { return nodes_.owns(node); }
     
-    // Performance optimization
-    void optimize_for_thread(size_t thread_id);
-    void preallocate_for_thread(size_t thread_id, size_t count);
-    void cleanup_thread_resources(size_t thread_id);
+    // Performance optimization; magazines are per thread, so these act on
+    // the calling thread
+    void preallocate(size_t count);
+    void release_thread_cache();
 
 private:
     CacheConfig config_;
-    
-    // Main pool
-    std::vector<Node*> main_pool_;
-    std::atomic<size_t> pool_index_{0};
-    std::atomic<size_t> total_allocated_{0};
-    std::atomic<size_t> total_deallocated_{0};
-    
-    // Per-thread free lists
-    struct ThreadFreeList {
-        std::stack<Node*> free_nodes;
-        std::mutex mutex;
-        std::atomic<size_t> allocation_count{0};
-        std::atomic<size_t> deallocation_count{0};
-    };
-    
-    std::vector<std::unique_ptr<ThreadFreeList>> thread_free_lists_;
-    size_t thread_count_;
+    MagazinePool<Node> nodes_;
     
     // Aligned allocation pool
     struct AlignedBlock {
@@ -75,26 +66,19 @@ private:
     };
     
     std::vector<AlignedBlock> aligned_blocks_;
-    std::mutex aligned_mutex_;
-    
-    // Helper methods
-    size_t get_thread_id() const;
-    ThreadFreeList* get_thread_free_list(size_t thread_id);
-    void initialize_thread_free_lists();
-    void cleanup_thread_free_lists();
+    mutable std::mutex aligned_mutex_;
     
-    // Memory management helpers
-    void* allocate_aligned_internal(size_t size, size_t alignment);
-    void deallocate_aligned_internal(void* ptr);
     void defragment_aligned_blocks();
-    
-    // Statistics
-    void update_statistics(size_t thread_id, bool is_allocation);
-    double calculate_fragmentation() const;
 };
 
 /**
  * @brief NUMA-aware memory pool
+ *
+ * One AdvancedMemoryPool per NUMA node, each with slabs bound to its node
+ * and an equal share of config.max_nodes. allocate_node_on_numa(-1) uses
+ * the preferred node when one is set and the calling thread's node
+ * otherwise. The inherited allocate_node and deallocate_node use a plain
+ * unbound pool.
  */
 class NUMAMemoryPool : public AdvancedMemoryPool {
 public:
@@ -111,16 +95,21 @@ public:
     double get_numa_utilization(int numa_node) const;
     
 private:
-    std::vector<std::unique_ptr<AdvancedMemoryPool>> numa_pools_;
+    std::vector<std::unique_ptr<AdvancedMemoryPool>> numa_pools_;  // by node id; nullptr for ids without memory
     std::atomic<int> preferred_numa_node_{-1};
     std::vector<std::atomic<size_t>> numa_allocation_counts_;
     
-    void initialize_numa_pools();
+    void initialize_numa_pools(const CacheConfig& config);
     int get_numa_node_for_thread() const;
+    AdvancedMemoryPool* pool_for(int numa_node) const;
 };
 
 /**
- * @brief Lock-free memory pool for high-concurrency scenarios
+ * @brief Fixed pool with one shared lock-free free list
+ *
+ * A NodePool without magazines: every allocation and deallocation is a CAS
+ * on the same head. Kept as the baseline the magazine pools are measured
+ * against.
  */
 class LockFreeMemoryPool {
 public:
@@ -130,52 +119,46 @@ public:
     // Lock-free operations
     Node* allocate_node_lock_free();
     void deallocate_node_lock_free(Node* node);
+    bool owns(const Node* node) const { return pool_.owns(node); }
     
-    // Statistics
+    // Statistics; allocated counts every allocation made
     size_t get_available_nodes() const;
     size_t get_allocated_nodes() const;
     bool is_empty() const;
     bool is_full() const;
 
 private:
-    CacheConfig config_;
-    
-    // Lock-free pool using atomic operations
-    struct PoolNode {
-        std::atomic<PoolNode*> next;
-        Node data;
-    };
-    
-    std::atomic<PoolNode*> free_list_head_{nullptr};
+    NodePool pool_;
     std::atomic<size_t> allocated_count_{0};
-    std::atomic<size_t> total_count_{0};
-    
-    std::vector<PoolNode> pool_nodes_;
-    
-    // Helper methods
-    PoolNode* pop_free_node();
-    void push_free_node(PoolNode* node);
-    void initialize_pool();
+    std::atomic<size_t> deallocated_count_{0};
 };
 
 /**
  * @brief Hierarchical memory pool with multiple allocation strategies
+ *
+ * L1 is an AdvancedMemoryPool, so in the common case an allocation is a
+ * pop from the calling thread's magazine. L2 is a shared lock-free pool and
+ * L3 the heap. allocate_node skips a level that ran dry until a node is
+ * handed back to it, so falling through costs a probe per level only when
+ * that level first empties, not on every call.
  */
 class HierarchicalMemoryPool {
 public:
     explicit HierarchicalMemoryPool(const CacheConfig& config);
     ~HierarchicalMemoryPool();
 
+    Node* allocate_node();
+
     // Hierarchical allocation
-    Node* allocate_node_fast();      // From L1 (fastest)
-    Node* allocate_node_standard();  // From L2 (standard)
-    Node* allocate_node_slow();      // From L3 (slowest, but guaranteed)
+    Node* allocate_node_fast();      // L1: magazines, depot, then slab
+    Node* allocate_node_standard();  // L2: one shared free list
+    Node* allocate_node_slow();      // L3: the heap; always succeeds
     
     void deallocate_node(Node* node);
     
-    // Pool management
+    // Pool management: parks this thread's magazines in the depot and lets
+    // allocate_node try every level again
     void rebalance_pools();
-    void optimize_allocation_strategy();
     
     // Statistics
     struct PoolStats {
@@ -192,19 +175,53 @@ public:
 private:
     CacheConfig config_;
     
-    // Three-level hierarchy
-    std::unique_ptr<LockFreeMemoryPool> l1_pool_;      // Fastest, smallest
-    std::unique_ptr<AdvancedMemoryPool> l2_pool_;      // Standard, medium
-    std::unique_ptr<NUMAMemoryPool> l3_pool_;          // Slowest, largest
-    
-    // Statistics
-    mutable std::atomic<size_t> l1_allocations_{0};
-    mutable std::atomic<size_t> l2_allocations_{0};
-    mutable std::atomic<size_t> l3_allocations_{0};
+    std::unique_ptr<AdvancedMemoryPool> l1_pool_;
+    std::unique_ptr<LockFreeMemoryPool> l2_pool_;
     
-    // Strategy selection
-    Node* select_allocation_strategy();
-    void update_allocation_statistics(int level);
+    // L1 counts per thread in its magazines
+    std::atomic<size_t> l2_allocations_{0};
+    std::atomic<size_t> l3_allocations_{0};
+    std::atomic<bool> l1_dry_{false};
+    std::atomic<bool> l2_dry_{false};
+};
+
+/**
+ * @brief Allocation latency of one allocator, as a log-linear histogram
+ *
+ * Below 4 ns each nanosecond has a bucket; above, each power of two is
+ * split into four. A sample is the mean over a burst of BURST calls, since
+ * a single allocation is shorter than the clock read that times it.
+ */
+struct AllocationLatencyHistogram {
+    static constexpr size_t BUCKETS = 4 * 40;
+    static constexpr size_t BURST = 8;
+
+    std::string allocator;
+    size_t threads = 0;
+    uint64_t counts[BUCKETS] = {};
+    uint64_t samples = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+
+    void record(uint64_t ns);
+    // Upper bound of the bucket holding quantile q
+    uint64_t percentile_ns(double q) const;
+    double mean_ns() const { return samples ? static_cast<double>(total_ns) / samples : 0.0; }
+};
+
+struct AllocatorBenchmarkResult {
+    AllocationLatencyHistogram allocate;
+    AllocationLatencyHistogram release;
 };
 
+/**
+ * @brief Times allocation and release through every node allocator
+ *
+ * Each of threads workers repeatedly takes batch nodes and hands them back,
+ * rounds times, against new/delete, a std::stack under a mutex (the old
+ * per-thread free lists), LockFreeMemoryPool, NodePool with and without
+ * magazines, and AdvancedMemoryPool.
+ */
+std::vector<AllocatorBenchmarkResult> benchmark_node_allocators(size_t threads, size_t rounds, size_t batch = 64);
+
 } // namespace hft_cache 
\ No newline at end of file
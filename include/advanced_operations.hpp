@@ -3,6 +3,9 @@
 
 #include "radial_circular_list.hpp"
 #include "config.hpp"
+#include "market_data.hpp"
+#include "symbol_statistics.hpp"
+#include <cmath>
 #include <functional>
 #include <vector>
 #include <algorithm>
@@ -11,208 +14,262 @@
 #include <unordered_map>
 
 // Range query operations
+//
+// Served from the symbol's SymbolIndex when it keeps the order asked for
+// (see RadialCircularList::enable_index); otherwise the symbol's heap
+// shards are copied one at a time and filtered here. Either way the
+// results are copies taken under the index or shard lock, in key order, so
+// nothing returned can be recycled under the caller.
 class RangeOperations {
 private:
     RadialCircularList& cache_;
-    
-public:
-    explicit RangeOperations(RadialCircularList& cache) : cache_(cache) {}
-    
-    // Get nodes within value range
-    std::vector<Node*> get_range(const std::string& symbol, double min_value, double max_value) {
-        std::vector<Node*> results;
-        // Implementation would iterate through all nodes for the symbol
-        // and filter by value range
+    SymbolRegistry& symbols_;
+
+    const SymbolIndex* index_for(SymbolId symbol, unsigned kind) const {
+        const SymbolIndex* index = cache_.index(symbol);
+        return index && index->covers(kind) ? index : nullptr;
+    }
+
+    // Fallback: every queued node of symbol that satisfies keep
+    template <typename Keep>
+    std::vector<Node> scan(SymbolId symbol, Keep&& keep) const {
+        std::vector<Node> results;
+        if (symbol == INVALID_SYMBOL_ID) return results;
+        for (size_t shard = 0; shard < cache_.snapshot_shards(); ++shard) {
+            cache_.snapshot_shard(symbol, shard, results);
+        }
+        results.erase(std::remove_if(results.begin(), results.end(), [&keep](const Node& node) { return !keep(node); }),
+                      results.end());
         return results;
     }
-    
-    // Get nodes within priority range
-    std::vector<Node*> get_by_priority_range(const std::string& symbol, int min_priority, int max_priority) {
-        std::vector<Node*> results;
-        // Implementation would filter by priority range
+
+public:
+    explicit RangeOperations(RadialCircularList& cache) : cache_(cache), symbols_(SymbolRegistry::global()) {}
+
+    // Indexes symbol for the queries below; see RadialCircularList::enable_index
+    bool enable_index(const std::string& symbol, unsigned kinds = SymbolIndex::ALL) {
+        return cache_.enable_index(symbol, kinds);
+    }
+
+    // Get nodes within value range, inclusive, by ascending value
+    std::vector<Node> get_range(SymbolId symbol, double min_value, double max_value) const {
+        std::vector<Node> results;
+        if (const SymbolIndex* index = index_for(symbol, SymbolIndex::BY_VALUE)) {
+            index->values_between(min_value, max_value, results);
+            return results;
+        }
+        results = scan(symbol, [=](const Node& n) { return n.value >= min_value && n.value <= max_value; });
+        std::sort(results.begin(), results.end(), [](const Node& a, const Node& b) { return a.value < b.value; });
         return results;
     }
-    
-    // Get nodes within timestamp range
-    std::vector<Node*> get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time) {
-        std::vector<Node*> results;
-        // Implementation would filter by timestamp range
+    std::vector<Node> get_range(const std::string& symbol, double min_value, double max_value) const {
+        return get_range(symbols_.find(symbol), min_value, max_value);
+    }
+
+    // Get nodes within priority range, inclusive, by ascending priority
+    std::vector<Node> get_by_priority_range(SymbolId symbol, int min_priority, int max_priority) const {
+        std::vector<Node> results;
+        if (const SymbolIndex* index = index_for(symbol, SymbolIndex::BY_PRIORITY)) {
+            index->priorities_between(min_priority, max_priority, results);
+            return results;
+        }
+        results = scan(symbol, [=](const Node& n) { return n.priority >= min_priority && n.priority <= max_priority; });
+        std::sort(results.begin(), results.end(),
+                  [](const Node& a, const Node& b) { return a.priority < b.priority; });
         return results;
     }
-    
-    // Get top N nodes by priority
-    std::vector<Node*> get_top_n(const std::string& symbol, size_t n) {
-        std::vector<Node*> results;
-        // Implementation would get top N priority nodes
+    std::vector<Node> get_by_priority_range(const std::string& symbol, int min_priority, int max_priority) const {
+        return get_by_priority_range(symbols_.find(symbol), min_priority, max_priority);
+    }
+
+    // Get nodes created within a CoarseClock range, inclusive, oldest first
+    std::vector<Node> get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time) const {
+        std::vector<Node> results;
+        if (const SymbolIndex* index = index_for(symbol, SymbolIndex::BY_TIME)) {
+            index->created_between(start_time, end_time, results);
+            return results;
+        }
+        results = scan(symbol, [=](const Node& n) { return n.timestamp_ns >= start_time && n.timestamp_ns <= end_time; });
+        std::sort(results.begin(), results.end(),
+                  [](const Node& a, const Node& b) { return a.timestamp_ns < b.timestamp_ns; });
         return results;
     }
-    
-    // Get nodes with custom predicate
-    std::vector<Node*> get_by_predicate(const std::string& symbol, 
-                                       std::function<bool(const Node*)> predicate) {
-        std::vector<Node*> results;
-        // Implementation would apply custom predicate
+    std::vector<Node> get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time) const {
+        return get_by_timestamp_range(symbols_.find(symbol), start_time, end_time);
+    }
+
+    // Get top N nodes by priority, highest first, without popping them
+    std::vector<Node> get_top_n(SymbolId symbol, size_t n) const {
+        std::vector<Node> results;
+        if (const SymbolIndex* index = index_for(symbol, SymbolIndex::BY_PRIORITY)) {
+            index->top_priority(n, results);
+            return results;
+        }
+        results = scan(symbol, [](const Node&) { return true; });
+        auto higher = [](const Node& a, const Node& b) { return a.priority > b.priority; };
+        size_t keep = std::min(n, results.size());
+        std::partial_sort(results.begin(), results.begin() + keep, results.end(), higher);
+        results.resize(keep);
         return results;
     }
+    std::vector<Node> get_top_n(const std::string& symbol, size_t n) const {
+        return get_top_n(symbols_.find(symbol), n);
+    }
+
+    // Get nodes with custom predicate; no index can help, so this always scans
+    std::vector<Node> get_by_predicate(const std::string& symbol, std::function<bool(const Node*)> predicate) const {
+        return scan(symbols_.find(symbol), [&predicate](const Node& n) { return predicate(&n); });
+    }
 };
 
 // Aggregation operations
+//
+// Backed by a SymbolStatistics attached as one of the cache's observers, so
+// every query is a constant-time read of a running aggregate rather than a
+// scan. It sits alongside a PersistentCache's write-ahead log, so restores
+// and replays keep it current, and destroying it detaches only its own
+// statistics. Only nodes inserted while this object exists are counted,
+// and it must be destroyed before the cache.
 class AggregationOperations {
 private:
     RadialCircularList& cache_;
-    
+    SymbolRegistry& symbols_;
+    SymbolStatistics stats_;
+
 public:
-    explicit AggregationOperations(RadialCircularList& cache) : cache_(cache) {}
-    
-    // Calculate average value for a symbol
-    double get_average_value(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        if (nodes.empty()) return 0.0;
-        
-        double sum = std::accumulate(nodes.begin(), nodes.end(), 0.0,
-            [](double acc, const Node* node) { return acc + node->value; });
-        return sum / nodes.size();
+    explicit AggregationOperations(RadialCircularList& cache)
+        : cache_(cache), symbols_(SymbolRegistry::global()) {
+        cache_.attach_observer(&stats_);
     }
-    
-    // Calculate median value for a symbol
-    double get_median_value(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        if (nodes.empty()) return 0.0;
-        
-        std::vector<double> values;
-        values.reserve(nodes.size());
-        for (const auto* node : nodes) {
-            values.push_back(node->value);
-        }
-        
-        std::sort(values.begin(), values.end());
-        size_t n = values.size();
-        if (n % 2 == 0) {
-            return (values[n/2 - 1] + values[n/2]) / 2.0;
-        } else {
-            return values[n/2];
-        }
-    }
-    
+
+    ~AggregationOperations() { cache_.detach_observer(&stats_); }
+
+    AggregationOperations(const AggregationOperations&) = delete;
+    AggregationOperations& operator=(const AggregationOperations&) = delete;
+
+    SymbolSummary summary(SymbolId symbol) const { return stats_.summary(symbol); }
+    SymbolSummary summary(const std::string& symbol) const { return stats_.summary(symbols_.find(symbol)); }
+
+    // Calculate average value for a symbol
+    double get_average_value(const std::string& symbol) const { return summary(symbol).average; }
+
+    // Median value for a symbol, within the sketch's relative accuracy
+    double get_median_value(const std::string& symbol) const { return summary(symbol).median; }
+
     // Calculate standard deviation
-    double get_std_deviation(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        if (nodes.size() < 2) return 0.0;
-        
-        double mean = get_average_value(symbol);
-        double variance = 0.0;
-        
-        for (const auto* node : nodes) {
-            double diff = node->value - mean;
-            variance += diff * diff;
-        }
-        variance /= (nodes.size() - 1);
-        
-        return std::sqrt(variance);
-    }
-    
+    double get_std_deviation(const std::string& symbol) const { return summary(symbol).std_deviation; }
+
     // Get min and max values
-    std::pair<double, double> get_min_max(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        if (nodes.empty()) return {0.0, 0.0};
-        
-        auto [min_it, max_it] = std::minmax_element(nodes.begin(), nodes.end(),
-            [](const Node* a, const Node* b) { return a->value < b->value; });
-        
-        return {(*min_it)->value, (*max_it)->value};
+    std::pair<double, double> get_min_max(const std::string& symbol) const {
+        SymbolSummary s = summary(symbol);
+        return {s.min_value, s.max_value};
     }
-    
+
     // Get count of nodes for a symbol
-    size_t get_count(const std::string& symbol) {
-        return get_all_nodes(symbol).size();
-    }
-    
+    size_t get_count(const std::string& symbol) const { return summary(symbol).count; }
+
     // Get sum of values for a symbol
-    double get_sum(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        return std::accumulate(nodes.begin(), nodes.end(), 0.0,
-            [](double acc, const Node* node) { return acc + node->value; });
-    }
-    
+    double get_sum(const std::string& symbol) const { return summary(symbol).sum; }
+
     // Get weighted average by priority
-    double get_weighted_average(const std::string& symbol) {
-        auto nodes = get_all_nodes(symbol);
-        if (nodes.empty()) return 0.0;
-        
-        double weighted_sum = 0.0;
-        double total_weight = 0.0;
-        
-        for (const auto* node : nodes) {
-            double weight = static_cast<double>(node->priority + 1); // Avoid zero weight
-            weighted_sum += node->value * weight;
-            total_weight += weight;
-        }
-        
-        return total_weight > 0 ? weighted_sum / total_weight : 0.0;
-    }
+    double get_weighted_average(const std::string& symbol) const { return summary(symbol).weighted_average; }
 
-private:
-    std::vector<Node*> get_all_nodes(const std::string& symbol) {
-        std::vector<Node*> nodes;
-        // Implementation would collect all nodes for the symbol
-        // This is a placeholder - actual implementation would depend on cache structure
-        return nodes;
-    }
+    SymbolStatistics& statistics() { return stats_; }
 };
 
 // Pattern matching and search operations
+//
+// These match on symbol names or on arbitrary node fields, so no index can
+// serve them: each walks every symbol in the registry and copies the
+// queued nodes of the ones that match, shard by shard, like the
+// RangeOperations fallback. Cost is linear in the symbols interned plus the
+// nodes copied; keep them off the hot path.
 class SearchOperations {
 private:
     RadialCircularList& cache_;
-    
+    SymbolRegistry& symbols_;
+
+    // Every queued node of every symbol whose name satisfies match, then
+    // filtered by keep
+    template <typename Match, typename Keep>
+    std::vector<Node> scan_symbols(Match&& match, Keep&& keep) const {
+        std::vector<Node> results;
+        size_t count = symbols_.size();
+        for (SymbolId symbol = 0; symbol < count; ++symbol) {
+            if (!match(symbols_.name(symbol))) continue;
+            size_t first = results.size();
+            for (size_t shard = 0; shard < cache_.snapshot_shards(); ++shard) {
+                cache_.snapshot_shard(symbol, shard, results);
+            }
+            results.erase(std::remove_if(results.begin() + first, results.end(),
+                                         [&keep](const Node& node) { return !keep(node); }),
+                          results.end());
+        }
+        return results;
+    }
+
+    // Levenshtein distance over bytes, two rows
+    static size_t edit_distance(const std::string& a, const std::string& b) {
+        std::vector<size_t> previous(b.size() + 1), current(b.size() + 1);
+        std::iota(previous.begin(), previous.end(), size_t(0));
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = i;
+            for (size_t j = 1; j <= b.size(); ++j) {
+                size_t substitute = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitute});
+            }
+            previous.swap(current);
+        }
+        return previous[b.size()];
+    }
+
 public:
-    explicit SearchOperations(RadialCircularList& cache) : cache_(cache) {}
-    
-    // Search by regex pattern in symbol names
-    std::vector<Node*> search_by_pattern(const std::string& pattern) {
-        std::vector<Node*> results;
+    explicit SearchOperations(RadialCircularList& cache) : cache_(cache), symbols_(SymbolRegistry::global()) {}
+
+    // Nodes of every symbol whose name contains a match for pattern
+    // (ECMAScript syntax); throws std::regex_error on a bad pattern
+    std::vector<Node> search_by_pattern(const std::string& pattern) const {
         std::regex regex_pattern(pattern);
-        
-        // Implementation would iterate through all symbols and match against pattern
-        // This is a placeholder
-        return results;
+        return scan_symbols([&regex_pattern](const std::string& name) { return std::regex_search(name, regex_pattern); },
+                            [](const Node&) { return true; });
     }
-    
-    // Fuzzy search for symbols
-    std::vector<Node*> fuzzy_search(const std::string& query, double threshold = 0.8) {
-        std::vector<Node*> results;
-        
-        // Implementation would use string similarity algorithms
-        // like Levenshtein distance or Jaro-Winkler
-        return results;
+
+    // Nodes of every symbol at least threshold similar to query, where
+    // similarity is 1 - edit distance / length of the longer name
+    std::vector<Node> fuzzy_search(const std::string& query, double threshold = 0.8) const {
+        return scan_symbols(
+            [&query, threshold](const std::string& name) {
+                size_t longest = std::max(name.size(), query.size());
+                if (longest == 0) return true;
+                double similarity = 1.0 - static_cast<double>(edit_distance(name, query)) / static_cast<double>(longest);
+                return similarity >= threshold;
+            },
+            [](const Node&) { return true; });
     }
-    
-    // Search by custom predicate
-    std::vector<Node*> search_by_predicate(std::function<bool(const Node*)> predicate) {
-        std::vector<Node*> results;
-        
-        // Implementation would apply predicate to all nodes
-        return results;
+
+    // Nodes of any symbol that satisfy predicate
+    std::vector<Node> search_by_predicate(std::function<bool(const Node*)> predicate) const {
+        return scan_symbols([](const std::string&) { return true; },
+                            [&predicate](const Node& node) { return predicate(&node); });
     }
     
     // Search for nodes with similar values
-    std::vector<Node*> search_similar_values(double target_value, double tolerance) {
+    std::vector<Node> search_similar_values(double target_value, double tolerance) const {
         return search_by_predicate([target_value, tolerance](const Node* node) {
             return std::abs(node->value - target_value) <= tolerance;
         });
     }
     
     // Search for nodes with high priority
-    std::vector<Node*> search_high_priority(int min_priority) {
+    std::vector<Node> search_high_priority(int min_priority) const {
         return search_by_predicate([min_priority](const Node* node) {
             return node->priority >= min_priority;
         });
     }
     
     // Search for recent nodes
-    std::vector<Node*> search_recent(uint64_t max_age_ns) {
-        uint64_t current_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+    std::vector<Node> search_recent(uint64_t max_age_ns) const {
+        uint64_t current_time = CoarseClock::now();
         
         return search_by_predicate([current_time, max_age_ns](const Node* node) {
             return (current_time - node->timestamp_ns) <= max_age_ns;
@@ -227,80 +284,93 @@ private:
     RangeOperations range_ops_;
     AggregationOperations agg_ops_;
     SearchOperations search_ops_;
+    MarketDataEngine market_;
+    SymbolRegistry& symbols_;
     
 public:
-    explicit AdvancedCacheOperations(RadialCircularList& cache) 
-        : cache_(cache), range_ops_(cache), agg_ops_(cache), search_ops_(cache) {}
-    
-    // Get statistical summary for a symbol
-    struct SymbolSummary {
-        size_t count;
-        double average;
-        double median;
-        double std_deviation;
-        std::pair<double, double> min_max;
-        double weighted_average;
-    };
+    explicit AdvancedCacheOperations(RadialCircularList& cache, const CacheConfig& config = CacheConfig())
+        : cache_(cache), range_ops_(cache), agg_ops_(cache), search_ops_(cache),
+          market_(config.trade_window_capacity), symbols_(SymbolRegistry::global()) {}
     
-    SymbolSummary get_symbol_summary(const std::string& symbol) {
-        return {
-            agg_ops_.get_count(symbol),
-            agg_ops_.get_average_value(symbol),
-            agg_ops_.get_median_value(symbol),
-            agg_ops_.get_std_deviation(symbol),
-            agg_ops_.get_min_max(symbol),
-            agg_ops_.get_weighted_average(symbol)
-        };
-    }
+    // Get statistical summary for a symbol. Constant time and allocation
+    // free, so it can be polled across the whole universe.
+    using SymbolSummary = ::SymbolSummary;
+
+    SymbolSummary get_symbol_summary(SymbolId symbol) const { return agg_ops_.summary(symbol); }
+    SymbolSummary get_symbol_summary(const std::string& symbol) const { return agg_ops_.summary(symbol); }
     
-    // Get top symbols by activity
-    std::vector<std::pair<std::string, size_t>> get_top_symbols_by_activity(size_t limit = 10) {
+    // Symbols holding the most values, busiest first. Reads one summary per
+    // interned symbol, so it is linear in the registry, not the cache.
+    std::vector<std::pair<std::string, size_t>> get_top_symbols_by_activity(size_t limit = 10) const {
         std::vector<std::pair<std::string, size_t>> results;
-        // Implementation would track symbol activity and return top ones
+        size_t count = symbols_.size();
+        for (SymbolId symbol = 0; symbol < count; ++symbol) {
+            size_t held = agg_ops_.summary(symbol).count;
+            if (held) results.emplace_back(symbols_.name(symbol), held);
+        }
+        auto busier = [](const auto& a, const auto& b) { return a.second > b.second; };
+        size_t keep = std::min(limit, results.size());
+        std::partial_sort(results.begin(), results.begin() + keep, results.end(), busier);
+        results.resize(keep);
         return results;
     }
     
-    // Get symbols with high volatility
-    std::vector<std::pair<std::string, double>> get_volatile_symbols(double threshold = 0.1) {
+    // Symbols whose held values have a coefficient of variation (sample
+    // standard deviation over the mean's magnitude) of at least threshold,
+    // most volatile first. Symbols with fewer than two values or a zero
+    // mean are skipped.
+    std::vector<std::pair<std::string, double>> get_volatile_symbols(double threshold = 0.1) const {
         std::vector<std::pair<std::string, double>> results;
-        // Implementation would calculate volatility and return symbols above threshold
+        size_t count = symbols_.size();
+        for (SymbolId symbol = 0; symbol < count; ++symbol) {
+            SymbolSummary s = agg_ops_.summary(symbol);
+            if (s.count < 2 || s.average == 0.0) continue;
+            double variation = s.std_deviation / std::abs(s.average);
+            if (variation >= threshold) results.emplace_back(symbols_.name(symbol), variation);
+        }
+        std::sort(results.begin(), results.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
         return results;
     }
     
-    // Get correlation between symbols
-    double get_correlation(const std::string& symbol1, const std::string& symbol2) {
-        // Implementation would calculate correlation coefficient
-        return 0.0;
+    // Market data feed. TWAP, VWAP and depth are maintained incrementally
+    // from these, never by scanning the cache.
+    void on_trade(const std::string& symbol, double price, double quantity, uint64_t timestamp_ns = CoarseClock::now()) {
+        market_.on_trade(symbols_.intern(symbol), price, quantity, timestamp_ns);
     }
-    
+
+    void on_book_update(const std::string& symbol, BookSide side, double price, size_t quantity) {
+        market_.on_book_update(symbols_.intern(symbol), side, price, quantity);
+    }
+
     // Get market depth for a symbol
-    struct MarketDepth {
-        std::vector<std::pair<double, size_t>> bids;  // price, quantity
-        std::vector<std::pair<double, size_t>> asks;  // price, quantity
-    };
-    
+    using MarketDepth = ::MarketDepth;
+
     MarketDepth get_market_depth(const std::string& symbol, size_t levels = 10) {
         MarketDepth depth;
-        // Implementation would aggregate orders by price level
+        market_.depth(symbols_.find(symbol), levels, depth);
         return depth;
     }
+
+    // Reuses depth's storage, so a steady poll does not allocate
+    void get_market_depth(SymbolId symbol, size_t levels, MarketDepth& depth) const {
+        market_.depth(symbol, levels, depth);
+    }
     
     // Get time-weighted average price (TWAP)
     double get_twap(const std::string& symbol, uint64_t window_ns) {
-        // Implementation would calculate TWAP over the specified window
-        return 0.0;
+        return market_.twap(symbols_.find(symbol), window_ns);
     }
     
     // Get volume-weighted average price (VWAP)
     double get_vwap(const std::string& symbol, uint64_t window_ns) {
-        // Implementation would calculate VWAP over the specified window
-        return 0.0;
+        return market_.vwap(symbols_.find(symbol), window_ns);
     }
-    
+
     // Get access to individual operation classes
     RangeOperations& range_operations() { return range_ops_; }
     AggregationOperations& aggregation_operations() { return agg_ops_; }
     SearchOperations& search_operations() { return search_ops_; }
+    MarketDataEngine& market_data() { return market_; }
 };
 
 #endif 
\ No newline at end of file
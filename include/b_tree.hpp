@@ -1,6 +1,10 @@
 #pragma once
 
 #include "node.hpp"
+#include "config.hpp"
+#include "symbol_registry.hpp"
+#include "magazine_cache.hpp"
+#include <string>
 #include <vector>
 #include <atomic>
 #include <memory>
@@ -9,97 +13,226 @@
 
 namespace hft_cache {
 
-constexpr int B_TREE_ORDER = 64; // High order for better cache performance
+constexpr int B_TREE_ORDER = 64; // Children per inner node; every node holds up to B_TREE_ORDER - 1 keys
 
 /**
- * @brief B-tree node for efficient range queries
+ * @brief B+-tree node header: inline keys and an optimistic lock
+ *
+ * Keys are (symbol id, value) pairs kept sorted in fixed arrays inside the
+ * node, so a search touches one node per level and no key is behind a
+ * pointer. version packs an obsolete bit (bit 0), a lock bit (bit 1) and a
+ * change counter above them. Readers note the version, read without
+ * locking and check it again before trusting what they read; a writer
+ * locks by moving the version on with a CAS from the value it read, so a
+ * successful upgrade also proves the node has not changed since. Fields
+ * are relaxed atomics so the racing reads stay well-defined, as in SeqLock.
  */
 struct BTreeNode {
-    std::vector<Node*> keys;
-    std::vector<std::atomic<BTreeNode*>> children;
-    std::atomic<bool> is_leaf{true};
-    std::atomic<size_t> key_count{0};
-    
-    BTreeNode() {
-        keys.resize(B_TREE_ORDER - 1, nullptr);
-        children.resize(B_TREE_ORDER, nullptr);
+    static constexpr size_t MAX_KEYS = B_TREE_ORDER - 1;
+
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint32_t> count{0};
+    const bool is_leaf;
+    std::atomic<SymbolId> symbols[MAX_KEYS];
+    std::atomic<double> values[MAX_KEYS];
+
+    explicit BTreeNode(bool leaf) : is_leaf(leaf) {}
+
+    size_t size() const { return std::min<size_t>(count.load(std::memory_order_relaxed), MAX_KEYS); }
+    bool full() const { return size() == MAX_KEYS; }
+
+    bool key_less(size_t i, SymbolId symbol, double value) const {
+        SymbolId key = symbols[i].load(std::memory_order_relaxed);
+        return key < symbol || (key == symbol && values[i].load(std::memory_order_relaxed) < value);
+    }
+    bool key_equals(size_t i, SymbolId symbol, double value) const {
+        return symbols[i].load(std::memory_order_relaxed) == symbol &&
+               values[i].load(std::memory_order_relaxed) == value;
+    }
+    // First slot whose key is not below (symbol, value)
+    size_t lower_bound(SymbolId symbol, double value) const {
+        size_t low = 0, high = size();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (key_less(mid, symbol, value)) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+    void copy_key(size_t to, const BTreeNode& from, size_t index) {
+        symbols[to].store(from.symbols[index].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        values[to].store(from.values[index].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // Optimistic lock coupling. A false return means restart from the root.
+    bool read_lock(uint64_t& seen) const {
+        seen = version.load(std::memory_order_acquire);
+        return (seen & 3) == 0;
+    }
+    bool validate(uint64_t seen) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version.load(std::memory_order_relaxed) == seen;
+    }
+    bool upgrade(uint64_t& seen) {
+        if (!version.compare_exchange_strong(seen, seen + 2, std::memory_order_acquire)) return false;
+        // Readers that see any store below also see the lock bit
+        std::atomic_thread_fence(std::memory_order_release);
+        seen += 2;
+        return true;
     }
-    
-    ~BTreeNode() = default;
+    void unlock() { version.fetch_add(2, std::memory_order_release); }
+};
+
+/**
+ * @brief Leaf: keys, their entries and a link to the next leaf in key order
+ */
+struct BTreeLeaf : BTreeNode {
+    std::atomic<Node*> entries[MAX_KEYS];
+    std::atomic<BTreeLeaf*> next{nullptr};
+
+    BTreeLeaf() : BTreeNode(true) {}
+
+    void insert_at(size_t pos, SymbolId symbol, double value, Node* entry);
+    void erase_at(size_t pos);
+    // Moves the upper half into right, which takes over the link; the
+    // separator is the largest key left here
+    void split(BTreeLeaf& right, SymbolId& separator_symbol, double& separator_value);
+};
+
+/**
+ * @brief Inner node: keys[i] is no smaller than any key under children[i]
+ * and no larger than any key under children[i + 1]
+ */
+struct BTreeInner : BTreeNode {
+    std::atomic<BTreeNode*> children[MAX_KEYS + 1];
+
+    BTreeInner() : BTreeNode(false) {}
+
+    // Places separator at slot and right just after it, as the new sibling of children[slot]
+    void insert_child(size_t slot, SymbolId separator_symbol, double separator_value, BTreeNode* right);
+    void split(BTreeInner& right, SymbolId& separator_symbol, double& separator_value);
 };
 
 /**
- * @brief Lock-free B-tree for efficient range queries and ordered traversal
- * 
- * Provides O(log n) time complexity for insert, delete, and search operations
- * with excellent cache locality and efficient range queries.
+ * @brief Concurrent B+-tree keyed on (symbol id, value), for range queries
+ * and ordered traversal
+ *
+ * Lookups and scans never write shared memory: they descend with
+ * optimistic lock coupling and restart if a node changed under them.
+ * Writers lock only the nodes they modify, splitting full nodes on the way
+ * down so a split never has to climb back up. Leaves are linked, so a range
+ * query is one descent followed by a walk along the leaf chain; each leaf
+ * is read consistently, but a range that spans leaves is not one snapshot.
+ *
+ * The tree owns the Nodes inserted into it. remove hands a node to
+ * EpochManager::retire, so a pointer returned by a lookup or scan stays
+ * valid while the caller holds an EpochGuard. Removal leaves emptied leaves
+ * in place rather than merging them. clear, the destructor and Iterator
+ * must not race with other operations.
  */
 class LockFreeBTree {
 public:
     explicit LockFreeBTree(const CacheConfig& config);
     ~LockFreeBTree();
 
-    // Core operations
+    // Core operations; keys are ordered by (symbol id, value) and the string
+    // overloads resolve through SymbolRegistry::global(). Equal keys are
+    // allowed; find and remove act on the first of them.
     bool insert(Node* node);
+    Node* find(SymbolId symbol, double value);
     Node* find(const std::string& symbol, double value);
+    bool remove(SymbolId symbol, double value);
     bool remove(const std::string& symbol, double value);
     void clear();
-    
-    // Range queries
+
+    // Range queries. The buffer overloads write at most capacity nodes,
+    // in value order, and return how many they wrote; they never allocate.
+    size_t get_range(SymbolId symbol, double min_value, double max_value, Node** out, size_t capacity);
+    size_t get_by_priority_range(SymbolId symbol, int min_priority, int max_priority, Node** out, size_t capacity);
+    size_t get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time, Node** out,
+                                  size_t capacity);
+    std::vector<Node*> get_range(SymbolId symbol, double min_value, double max_value);
     std::vector<Node*> get_range(const std::string& symbol, double min_value, double max_value);
+    std::vector<Node*> get_by_priority_range(SymbolId symbol, int min_priority, int max_priority);
     std::vector<Node*> get_by_priority_range(const std::string& symbol, int min_priority, int max_priority);
+    std::vector<Node*> get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time);
     std::vector<Node*> get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time);
-    
-    // Ordered operations
+
+    // Ordered operations. Value order is the tree's own; priority and
+    // timestamp order sort the symbol's entries after the walk.
+    size_t get_sorted_by_value(SymbolId symbol, Node** out, size_t capacity);
+    std::vector<Node*> get_sorted_by_value(SymbolId symbol);
     std::vector<Node*> get_sorted_by_value(const std::string& symbol);
+    std::vector<Node*> get_sorted_by_priority(SymbolId symbol);
     std::vector<Node*> get_sorted_by_priority(const std::string& symbol);
+    std::vector<Node*> get_sorted_by_timestamp(SymbolId symbol);
     std::vector<Node*> get_sorted_by_timestamp(const std::string& symbol);
-    
+
     // Statistics
     size_t size() const;
     int get_height() const;
-    double get_fill_factor() const;
-    
-    // Iteration
+    double get_fill_factor() const;  // entries over leaf slots
+
+    // Walks the leaf chain in key order; not safe against concurrent writers
     class Iterator {
     public:
-        Iterator(BTreeNode* root);
+        explicit Iterator(const BTreeLeaf* leaf);
         Iterator& operator++();
         Node* operator*();
         bool operator!=(const Iterator& other) const;
-        
+
     private:
-        std::vector<BTreeNode*> stack_;
-        std::vector<size_t> indices_;
-        void push_left(BTreeNode* node);
+        const BTreeLeaf* leaf_;
+        size_t index_ = 0;
+        void skip_empty();
     };
-    
+
     Iterator begin();
     Iterator end();
 
+    // Checks key order along the leaf chain and the entry count; for tests
+    bool validate_tree() const;
+
 private:
+    enum class Attempt { RESTART, DONE, FAILED };
+
     CacheConfig config_;
     std::atomic<BTreeNode*> root_{nullptr};
+    BTreeLeaf* first_leaf_ = nullptr;  // splits move keys rightwards, so the first leaf never changes
     std::atomic<size_t> size_{0};
     std::atomic<int> height_{0};
-    
+    std::atomic<size_t> leaf_count_{0};
+    // Tree nodes come from per-thread magazines rather than the heap
+    MagazinePool<BTreeLeaf> leaf_cache_;
+    MagazinePool<BTreeInner> inner_cache_;
+
     // Helper methods
-    BTreeNode* find_leaf(const std::string& symbol, double value);
-    bool insert_into_leaf(BTreeNode* leaf, Node* node);
-    void split_node(BTreeNode* parent, size_t child_index);
-    void merge_nodes(BTreeNode* parent, size_t child_index);
-    void rebalance_tree(BTreeNode* node);
-    
+    // Leaf that holds, or would hold, the first key not below (symbol,
+    // value), read-locked in version; nullptr means restart
+    BTreeLeaf* seek(SymbolId symbol, double value, uint64_t& version) const;
+    Attempt try_insert(Node* node);
+    Attempt try_remove(SymbolId symbol, double value);
+    void grow_root(BTreeNode* left, SymbolId separator_symbol, double separator_value, BTreeNode* right);
+    // Calls visit(symbol, value, node) for entries in key order from the
+    // first not below (symbol, value) until it returns false
+    template <typename Visit>
+    void walk(SymbolId symbol, double value, Visit&& visit) const;
+    template <typename Keep>
+    size_t collect(SymbolId symbol, double from, double to, Node** out, size_t capacity, Keep&& keep) const;
+    template <typename Keep>
+    std::vector<Node*> collect(SymbolId symbol, double from, double to, Keep&& keep) const;
+
     // Memory management
-    BTreeNode* allocate_node();
-    void deallocate_node(BTreeNode* node);
+    BTreeLeaf* allocate_leaf();
+    BTreeInner* allocate_inner();
     void cleanup_tree(BTreeNode* node);
-    
+
     // Validation and debugging
-    bool validate_tree() const;
     void print_tree() const;
-    int calculate_height(BTreeNode* node) const;
-    size_t calculate_size(BTreeNode* node) const;
+    int calculate_height(const BTreeNode* node) const;
 };
 
 /**
@@ -108,12 +241,14 @@ private:
 class ThreadSafeBTree : public LockFreeBTree {
 public:
     explicit ThreadSafeBTree(const CacheConfig& config);
-    
+
     // Thread-safe operations
     bool insert_thread_safe(Node* node);
+    Node* find_thread_safe(SymbolId symbol, double value);
     Node* find_thread_safe(const std::string& symbol, double value);
+    bool remove_thread_safe(SymbolId symbol, double value);
     bool remove_thread_safe(const std::string& symbol, double value);
-    
+
 private:
     mutable std::atomic<size_t> concurrent_readers_{0};
     mutable std::atomic<size_t> concurrent_writers_{0};
@@ -126,17 +261,17 @@ class PooledBTree : public LockFreeBTree {
 public:
     explicit PooledBTree(const CacheConfig& config);
     ~PooledBTree();
-    
+
     // Memory pool operations
-    BTreeNode* allocate_node_from_pool();
-    void deallocate_node_to_pool(BTreeNode* node);
+    BTreeLeaf* allocate_node_from_pool();
+    void deallocate_node_to_pool(BTreeLeaf* node);
     void defragment_pool();
-    
+
 private:
-    std::vector<BTreeNode*> node_pool_;
+    std::vector<BTreeLeaf*> node_pool_;
     std::atomic<size_t> pool_index_{0};
     size_t pool_size_;
-    
+
     void initialize_pool();
     void cleanup_pool();
 };
@@ -147,18 +282,18 @@ private:
 class CompressedBTree : public LockFreeBTree {
 public:
     explicit CompressedBTree(const CacheConfig& config);
-    
+
     // Compression operations
     void compress_node(BTreeNode* node);
     void decompress_node(BTreeNode* node);
     double get_compression_ratio() const;
-    
+
 private:
     std::atomic<size_t> compressed_nodes_{0};
     std::atomic<size_t> total_nodes_{0};
-    
+
     bool should_compress_node(BTreeNode* node) const;
     void apply_compression(BTreeNode* node);
 };
 
-} // namespace hft_cache 
\ No newline at end of file
+} // namespace hft_cache
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "config.hpp"
+#include "metrics.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hft_cache {
+
+/**
+ * @brief SplitMix64: a small, fast generator with a 64-bit state
+ *
+ * Every benchmark worker owns one seeded from the run's seed and its index,
+ * so workloads are reproducible and no two threads share generator state.
+ */
+class BenchmarkRng {
+public:
+    explicit BenchmarkRng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * n) >> 64); }
+
+private:
+    uint64_t state_;
+};
+
+/**
+ * @brief Zipf-distributed ranks over [0, n)
+ *
+ * Rank r is drawn with probability proportional to 1 / (r + 1)^skew, by a
+ * binary search of the cumulative table built at construction. A skew of 0
+ * is uniform; 0.99 is the usual model of a few hot symbols.
+ */
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t n, double skew);
+
+    size_t operator()(BenchmarkRng& rng) const;
+    size_t size() const { return cdf_.size(); }
+    // Probability of rank r
+    double probability(size_t rank) const;
+
+private:
+    std::vector<double> cdf_;
+};
+
+enum class BenchmarkTarget {
+    RADIAL,           // RadialCircularList: insert / get_highest_priority
+    MULTI_LEVEL,      // MultiLevelCache: insert / get_highest_priority
+    BTREE,            // LockFreeBTree: remove + insert / find
+    SKIP_LIST,        // LockFreeSkipList: remove + insert / find
+    BLOOM,            // BloomFilter: add / might_contain
+    COUNTING_BLOOM,   // CountingBloomFilter: remove + add / might_contain
+    CUCKOO,           // CuckooFilter: remove + add / might_contain
+    NODE_POOL,        // NodePool with magazines: allocate + release
+    ADVANCED_POOL,    // AdvancedMemoryPool: allocate_node + deallocate_node
+    COUNT
+};
+
+const char* benchmark_target_name(BenchmarkTarget target);
+// Accepts the names benchmark_target_name returns; false for anything else
+bool parse_benchmark_target(const std::string& name, BenchmarkTarget& target);
+
+/**
+ * @brief One benchmark configuration
+ *
+ * Each call is batch operations of one kind, read with probability
+ * read_ratio, on symbols drawn from a Zipf distribution and keys drawn
+ * uniformly from keys_per_symbol. The pools have no reads; every call
+ * takes batch nodes and gives them back.
+ *
+ * With rate 0 each worker issues calls back to back and a call's latency
+ * is its service time. With a rate each worker follows a fixed schedule of
+ * rate calls per second and a call's latency runs from when the schedule
+ * said it should start, so a stall is charged to every call queued behind
+ * it instead of being hidden by the calls that were never issued during it
+ * (coordinated omission).
+ */
+struct WorkloadOptions {
+    BenchmarkTarget target = BenchmarkTarget::RADIAL;
+    size_t threads = 1;
+    size_t operations = 100000;  // calls per worker, after warmup
+    size_t warmup = 10000;       // untimed calls per worker
+    size_t symbols = 64;
+    size_t keys_per_symbol = 256;  // preloaded per symbol; the key space of lookups
+    double zipf_skew = 0.99;
+    double read_ratio = 0.5;
+    size_t batch = 1;             // operations per call
+    double rate = 0.0;            // calls per second per worker; 0 is closed loop
+    bool pin_threads = false;     // worker i on CPU i modulo the CPU count
+    uint64_t seed = 1;
+};
+
+struct WorkloadResult {
+    WorkloadOptions options;
+    double seconds = 0.0;       // wall time of the timed phase
+    uint64_t calls = 0;
+    uint64_t reads = 0;         // read operations, batch per read call
+    uint64_t writes = 0;
+    uint64_t read_hits = 0;     // reads that found something
+    uint64_t failed_writes = 0; // writes the target refused, e.g. for a full pool
+    uint64_t checksum = 0;      // mix of every operation issued; equal seeds agree
+    double throughput = 0.0;    // operations per second over all workers
+    LatencySummary read_latency;   // per call, in ns
+    LatencySummary write_latency;
+};
+
+/**
+ * @brief Builds the target, preloads it and runs the workload
+ *
+ * Every worker's operations are generated before the clock starts, so the
+ * timed loop does nothing but issue calls and read the clock; a long run
+ * cycles through the first 2^18 operations again. Workers start together
+ * behind a barrier.
+ */
+WorkloadResult run_workload(const WorkloadOptions& options);
+
+// One JSON object per result, on one line
+std::string format_json(const WorkloadResult& result);
+std::string csv_header();
+std::string format_csv(const WorkloadResult& result);
+
+/**
+ * @brief A captured sequence of cache calls, for replaying real load
+ *
+ * Events are in time order and name their symbol and phase (say "open",
+ * "midday", "close") by index into the trace's tables, so a capture can
+ * label the stretches it wants reported separately. On disk a trace is a
+ * header, the two name tables and the events as fixed 40-byte records,
+ * written and read by the same build on the same architecture.
+ */
+struct TraceEvent {
+    enum Kind : uint16_t {
+        INSERT = 1,
+        GET = 2,  // get_highest_priority
+    };
+
+    uint64_t offset_ns;  // since the start of the trace
+    double value;
+    uint64_t ttl_ns;     // inserts; 0 takes CacheConfig::default_expiry_seconds
+    int32_t priority;
+    uint16_t kind;
+    uint16_t phase;
+    uint32_t symbol;
+    uint32_t reserved;
+};
+
+struct Trace {
+    static constexpr uint64_t MAGIC = 0x3143525454464848ull;  // "HHFTTRC1"
+    static constexpr uint32_t VERSION = 1;
+
+    std::vector<std::string> symbols;
+    std::vector<std::string> phases;
+    std::vector<TraceEvent> events;
+
+    // Index of name in the table, appending it the first time
+    uint32_t symbol(const std::string& name);
+    uint16_t phase(const std::string& name);
+    void insert(uint64_t offset_ns, uint32_t symbol, double value, int priority, uint64_t ttl_ns, uint16_t phase = 0);
+    void get(uint64_t offset_ns, uint32_t symbol, uint16_t phase = 0);
+};
+
+bool save_trace(const std::string& path, const Trace& trace);
+// False if the file is missing, truncated, from another format version,
+// names a symbol or phase it does not define, or goes back in time
+bool load_trace(const std::string& path, Trace& trace);
+
+enum class ReplayTarget { RADIAL, MULTI_LEVEL };
+
+struct ReplayOptions {
+    ReplayTarget target = ReplayTarget::MULTI_LEVEL;
+    CacheConfig config;          // what is being sized: max_nodes, l1_capacity, ...
+    double speed = 1.0;          // 1 replays at recorded speed, 2 twice as fast; 0 as fast as possible
+    double ttl_scale = 1.0;      // multiplies every insert's time to live
+    size_t threads = 1;          // symbols are split between workers; each keeps its events in order
+    bool pin_threads = false;
+};
+
+struct ReplayPhaseResult {
+    std::string phase;
+    uint64_t inserts = 0;
+    uint64_t gets = 0;
+    uint64_t get_hits = 0;
+    uint64_t failed_inserts = 0;
+    double seconds = 0.0;      // first call of the phase to the last one's return
+    double throughput = 0.0;   // calls per second over that span
+    LatencySummary insert_latency;
+    LatencySummary get_latency;
+};
+
+struct ReplayTierStats {
+    uint64_t items = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    double hit_ratio = 0.0;  // over the lookups that reached the tier
+};
+
+struct ReplayResult {
+    ReplayOptions options;
+    std::vector<ReplayPhaseResult> phases;  // in trace phase order, empty ones dropped
+    ReplayPhaseResult total;
+    bool has_tiers = false;                 // MULTI_LEVEL only
+    ReplayTierStats l1, l2, l3;
+};
+
+/**
+ * @brief Plays trace against a cache built from options.config
+ *
+ * At a speed each call is issued when the trace says, scaled, and its
+ * latency is measured from that moment, so a cache that falls behind the
+ * recorded load shows it in the tail rather than by quietly replaying
+ * slower. At speed 0 calls go back to back and latency is service time.
+ */
+ReplayResult replay_trace(const Trace& trace, const ReplayOptions& options);
+
+std::string format_json(const ReplayResult& result);
+std::string replay_csv_header();
+// One row per phase, then one for the whole trace
+std::string format_csv(const ReplayResult& result);
+
+} // namespace hft_cache
@@ -1,60 +1,84 @@
 #pragma once
 
+#include "simd_kernels.hpp"
+#include "spin_lock.hpp"
 #include <vector>
 #include <atomic>
 #include <string>
 #include <functional>
 #include <cstdint>
 #include <cmath>
+#include <memory>
 
 namespace hft_cache {
 
 /**
- * @brief Bloom filter for efficient membership testing
- * 
- * Reduces cache misses by quickly determining if a key might be in the cache
- * before performing expensive lookups.
+ * @brief Cache-line-blocked Bloom filter for efficient membership testing
+ *
+ * Lets a lookup that will miss skip the expensive path. A key's hash picks
+ * one 64-byte block by fastrange (a multiply and shift, no divide) and sets
+ * one bit in each of the block's eight words, so add and might_contain
+ * touch a single cache line whatever the false positive rate. The in-word
+ * positions come from the low 32 bits of the hash times eight odd salts,
+ * which the AVX2 probe computes for all eight words at once. Keys are
+ * hashed once, by the caller if it already has a well-mixed 64-bit hash,
+ * and might_contain_many prefetches a batch's blocks before probing them.
+ *
+ * add and the probes may run concurrently: bits are set with relaxed
+ * fetch_or and never cleared except by clear and resize, which must not
+ * race with anything.
  */
 class BloomFilter {
 public:
-    explicit BloomFilter(size_t expected_elements, double false_positive_rate = 0.01);
+    static constexpr size_t BLOCK_WORDS = 8;  // one bit per word per key, so k = 8
+
+    explicit BloomFilter(size_t expected_elements, double false_positive_rate = 0.01,
+                         SIMDLevel level = detect_simd_level());
     ~BloomFilter() = default;
 
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+
     // Core operations
-    void add(const std::string& key);
-    bool might_contain(const std::string& key) const;
+    void add(uint64_t hash);
+    bool might_contain(uint64_t hash) const;
+    void add(const std::string& key) { add(hash_key(key)); }
+    bool might_contain(const std::string& key) const { return might_contain(hash_key(key)); }
+    // out[i] answers hashes[i]; returns how many might be present
+    size_t might_contain_many(const uint64_t* hashes, size_t n, bool* out) const;
     void clear();
-    
+
+    // MurmurHash3 for strings; the fmix64 finalizer for integer keys
+    static uint64_t hash_key(const std::string& key);
+    static uint64_t hash_key(uint64_t key);
+
     // Statistics
     size_t get_bit_array_size() const;
     size_t get_hash_function_count() const;
     size_t get_added_elements() const;
+    // Estimate from the average load per block
     double get_current_false_positive_rate() const;
-    
-    // Configuration
+    SIMDLevel simd_level() const { return level_; }
+
+    // Configuration. Both drop everything added so far; callers re-add.
     void resize(size_t new_expected_elements, double new_false_positive_rate = 0.01);
     void optimize_for_workload(size_t actual_elements);
 
+    struct alignas(64) Block {
+        std::atomic<uint64_t> words[BLOCK_WORDS];
+    };
+
 private:
-    std::vector<std::atomic<uint64_t>> bit_array_;
-    size_t hash_function_count_;
-    size_t bit_array_size_;
+    std::unique_ptr<Block[]> blocks_;
+    size_t block_count_ = 0;
+    SIMDLevel level_;
+    bool (*probe_)(const Block& block, uint32_t key);
     std::atomic<size_t> added_elements_{0};
-    
-    // Hash functions
-    uint64_t hash1(const std::string& key) const;
-    uint64_t hash2(const std::string& key) const;
-    uint64_t hash3(const std::string& key) const;
-    uint64_t hash4(const std::string& key) const;
-    
-    // Helper methods
-    void set_bit(size_t index);
-    bool get_bit(size_t index) const;
-    size_t calculate_optimal_size(size_t elements, double false_positive_rate) const;
-    size_t calculate_optimal_hash_count(size_t elements, size_t size) const;
-    
-    // MurmurHash3 implementation for better distribution
-    uint64_t murmur_hash3_64(const std::string& key, uint64_t seed) const;
+
+    size_t block_of(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * static_cast<uint64_t>(block_count_)) >> 32);
+    }
+    void allocate(size_t elements, double false_positive_rate);
 };
 
 /**
@@ -75,39 +99,137 @@ private:
 
 /**
  * @brief Counting Bloom filter for deletion support
+ *
+ * One 8-bit counter per position, so it costs eight times a BloomFilter of
+ * the same rate and a counter stuck at 255 can no longer be decremented.
+ * CuckooFilter offers the same interface at a fraction of the space.
  */
 class CountingBloomFilter {
 public:
     explicit CountingBloomFilter(size_t expected_elements, double false_positive_rate = 0.01);
     ~CountingBloomFilter() = default;
 
-    // Core operations
-    void add(const std::string& key);
-    bool might_contain(const std::string& key) const;
-    bool remove(const std::string& key);
+    // Core operations; hashes as from BloomFilter::hash_key
+    void add(uint64_t hash);
+    bool might_contain(uint64_t hash) const;
+    bool remove(uint64_t hash);
+    void add(const std::string& key) { add(BloomFilter::hash_key(key)); }
+    bool might_contain(const std::string& key) const { return might_contain(BloomFilter::hash_key(key)); }
+    bool remove(const std::string& key) { return remove(BloomFilter::hash_key(key)); }
     void clear();
     
     // Statistics
     size_t get_counter_array_size() const;
     size_t get_max_counter_value() const;
+    // Share of counters that have saturated
     double get_saturation_rate() const;
+    size_t memory_bytes() const { return counter_array_size_; }
 
 private:
-    std::vector<std::atomic<uint8_t>> counter_array_;
+    std::unique_ptr<std::atomic<uint8_t>[]> counter_array_;
     size_t hash_function_count_;
     size_t counter_array_size_;
     std::atomic<size_t> added_elements_{0};
     
-    // Hash functions (same as BloomFilter)
-    uint64_t hash1(const std::string& key) const;
-    uint64_t hash2(const std::string& key) const;
-    uint64_t hash3(const std::string& key) const;
-    uint64_t hash4(const std::string& key) const;
-    
     // Helper methods
     void increment_counter(size_t index);
     bool decrement_counter(size_t index);
     uint8_t get_counter(size_t index) const;
 };
 
+/**
+ * @brief Concurrent cuckoo filter: membership with real deletes
+ *
+ * Each key is a 16-bit fingerprint stored in one of two buckets of four
+ * slots, and a bucket is a single 64-bit word, so a lookup is two word
+ * loads and a SWAR compare. The second bucket is the first XOR a hash of
+ * the fingerprint, so a fingerprint can move between its buckets without
+ * the key. Removing a key clears its fingerprint, which unlike a counter
+ * never saturates. Fingerprints are a fixed 16 bits, so at the 95% load
+ * the table is sized for that is about 17 bits a key for a rate of
+ * 2 * 4 / 2^16, roughly 1e-4; there is no rate to choose.
+ *
+ * Like a counting filter, adding a key twice needs two removes, and
+ * removing a key that was never added may remove another key that shares
+ * its fingerprint and buckets.
+ *
+ * Lookups take no lock. Writers serialize on a SpinLock; an insert that
+ * finds both buckets full evicts fingerprints along a random walk of up to
+ * MAX_KICKS hops, with version_ odd for the length of the walk. A lookup
+ * that finds nothing retries if the version moved, so a fingerprint in
+ * transit between buckets is never missed. A walk that runs out of kicks
+ * parks the fingerprint it holds in victim_; further adds fail until a
+ * remove makes room for it.
+ */
+class CuckooFilter {
+public:
+    static constexpr size_t SLOTS = 4;  // 16-bit fingerprints per 64-bit bucket
+    static constexpr size_t MAX_KICKS = 500;
+    static constexpr double MAX_LOAD = 0.95;
+
+    explicit CuckooFilter(size_t expected_elements);
+
+    CuckooFilter(const CuckooFilter&) = delete;
+    CuckooFilter& operator=(const CuckooFilter&) = delete;
+
+    // Core operations; hashes as from BloomFilter::hash_key. add fails
+    // only when the table is too full to place the fingerprint.
+    bool add(uint64_t hash);
+    bool might_contain(uint64_t hash) const;
+    bool remove(uint64_t hash);
+    bool add(const std::string& key) { return add(BloomFilter::hash_key(key)); }
+    bool might_contain(const std::string& key) const { return might_contain(BloomFilter::hash_key(key)); }
+    bool remove(const std::string& key) { return remove(BloomFilter::hash_key(key)); }
+    // Must not race with other operations
+    void clear();
+
+    // Statistics
+    size_t size() const { return count_.load(std::memory_order_relaxed); }
+    size_t get_bucket_count() const { return mask_ + 1; }
+    // Occupied share of the slots
+    double get_saturation_rate() const;
+    double get_current_false_positive_rate() const;
+    size_t memory_bytes() const { return get_bucket_count() * sizeof(uint64_t); }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    size_t mask_ = 0;                       // bucket count is a power of two
+    std::atomic<uint64_t> version_{0};      // odd while a walk holds a fingerprint
+    std::atomic<uint64_t> victim_{0};       // bucket << 16 | fingerprint, 0 if none
+    std::atomic<size_t> count_{0};
+    SpinLock write_lock_;
+    uint64_t random_state_ = 0x9E3779B97F4A7C15ULL;  // under write_lock_
+
+    static uint16_t fingerprint(uint64_t hash);
+    size_t alternate(size_t bucket, uint16_t fingerprint) const;
+    // Writer side: store into an empty slot, or clear a matching one
+    bool place(size_t bucket, uint16_t fingerprint);
+    bool erase(size_t bucket, uint16_t fingerprint);
+    uint64_t next_random();
+};
+
+/**
+ * @brief Per-operation cost of one deletable membership filter
+ */
+struct MembershipBenchmarkResult {
+    std::string filter;
+    size_t keys = 0;
+    double bits_per_key = 0.0;
+    double insert_ns = 0.0;
+    double lookup_hit_ns = 0.0;
+    double lookup_miss_ns = 0.0;
+    double remove_ns = 0.0;
+    double false_positive_rate = 0.0;  // measured on keys never added
+
+    double lookups_per_second() const { return lookup_hit_ns > 0.0 ? 1e9 / lookup_hit_ns : 0.0; }
+};
+
+/**
+ * @brief Sizes CountingBloomFilter for keys at the given rate and
+ * CuckooFilter for keys at its fixed one, fills them, then times lookups of
+ * present and absent keys and the removal of every key
+ */
+std::vector<MembershipBenchmarkResult> benchmark_membership_filters(size_t keys = 100000,
+                                                                    double false_positive_rate = 0.01);
+
 } // namespace hft_cache 
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef CACHE_OBSERVER_HPP
+#define CACHE_OBSERVER_HPP
+
+#include "epoch_reclamation.hpp"
+#include "node.hpp"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+// Hook for structures that mirror what a cache currently holds.
+//
+// on_insert runs before the node is queued and on_remove runs before its
+// slot goes back to the pool, so for any one node the two calls are always
+// ordered. A failed push is reported as an insert followed by a remove.
+// Both are called on the inserting, popping or sweeping thread, so
+// implementations must be thread-safe and cheap.
+class CacheObserver {
+public:
+    virtual ~CacheObserver() = default;
+    virtual void on_insert(const Node& node) = 0;
+    virtual void on_remove(const Node& node) = 0;
+};
+
+// Every observer attached to one cache, told about each node in attach
+// order.
+//
+// The attached set is an immutable array behind an atomic pointer, rebuilt
+// under a mutex by attach and detach, which are rare; the array it replaces
+// is retired through the EpochManager. active() is what a cache hands down
+// its hot paths: nullptr with nothing attached, the observer itself with
+// one, and this list with more, so a lone observer costs what a single
+// slot did. Observers are matched by identity, so one owner can never
+// detach another.
+class CacheObserverList : public CacheObserver {
+public:
+    static constexpr size_t MAX_OBSERVERS = 8;
+
+    CacheObserverList() = default;
+    ~CacheObserverList() override { delete set_.load(std::memory_order_relaxed); }
+
+    CacheObserverList(const CacheObserverList&) = delete;
+    CacheObserverList& operator=(const CacheObserverList&) = delete;
+
+    // False if observer is null, already attached or the list is full
+    bool attach(CacheObserver* observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Set* current = set_.load(std::memory_order_relaxed);
+        size_t count = current ? current->count : 0;
+        if (!observer || count == MAX_OBSERVERS) return false;
+        for (size_t i = 0; i < count; ++i) {
+            if (current->observers[i] == observer) return false;
+        }
+        Set* next = new Set;
+        for (size_t i = 0; i < count; ++i) next->observers[i] = current->observers[i];
+        next->observers[count] = observer;
+        next->count = count + 1;
+        publish(next, current);
+        return true;
+    }
+
+    // False if observer was not attached. A notification already running
+    // may still reach it, so it must outlive any operation in flight.
+    bool detach(CacheObserver* observer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Set* current = set_.load(std::memory_order_relaxed);
+        if (!current) return false;
+        Set* next = new Set;
+        next->count = 0;
+        for (size_t i = 0; i < current->count; ++i) {
+            if (current->observers[i] != observer) next->observers[next->count++] = current->observers[i];
+        }
+        if (next->count == current->count) {
+            delete next;
+            return false;
+        }
+        if (next->count == 0) {
+            delete next;
+            next = nullptr;
+        }
+        publish(next, current);
+        return true;
+    }
+
+    bool attached(const CacheObserver* observer) const {
+        EpochGuard guard;
+        const Set* current = set_.load(std::memory_order_acquire);
+        for (size_t i = 0; current && i < current->count; ++i) {
+            if (current->observers[i] == observer) return true;
+        }
+        return false;
+    }
+
+    CacheObserver* active() const { return active_.load(std::memory_order_acquire); }
+
+    void on_insert(const Node& node) override {
+        EpochGuard guard;
+        const Set* current = set_.load(std::memory_order_acquire);
+        for (size_t i = 0; current && i < current->count; ++i) current->observers[i]->on_insert(node);
+    }
+
+    void on_remove(const Node& node) override {
+        EpochGuard guard;
+        const Set* current = set_.load(std::memory_order_acquire);
+        for (size_t i = 0; current && i < current->count; ++i) current->observers[i]->on_remove(node);
+    }
+
+private:
+    struct Set {
+        size_t count;
+        CacheObserver* observers[MAX_OBSERVERS];
+    };
+
+    // With mutex_ held
+    void publish(Set* next, const Set* previous) {
+        set_.store(next, std::memory_order_release);
+        CacheObserver* lone = next && next->count == 1 ? next->observers[0] : nullptr;
+        active_.store(next && next->count > 1 ? this : lone, std::memory_order_release);
+        if (previous) EpochManager::global().retire(const_cast<Set*>(previous));
+    }
+
+    std::atomic<const Set*> set_{nullptr};
+    std::atomic<CacheObserver*> active_{nullptr};
+    std::mutex mutex_;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Monotonic nanosecond clock for node timestamps and expiry deadlines.
+//
+// On x86 with an invariant TSC, now() is a single rdtsc scaled to
+// nanoseconds with a fixed-point multiply; the scale is calibrated against
+// steady_clock once, on first use. Elsewhere it falls back to
+// steady_clock. Readings share the steady_clock epoch either way, so they
+// only compare against other CoarseClock readings, never wall time.
+class CoarseClock {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        const State& clock = state();
+        if (clock.use_tsc) {
+            unsigned __int128 elapsed = static_cast<unsigned __int128>(__rdtsc() - clock.base_tsc) * clock.mult;
+            return clock.base_ns + static_cast<uint64_t>(elapsed >> SHIFT);
+        }
+#endif
+        return steady_ns();
+    }
+
+    // Absolute deadline ttl_seconds from now
+    static uint64_t deadline_after(double ttl_seconds) {
+        return now() + static_cast<uint64_t>(ttl_seconds * 1'000'000'000);
+    }
+
+    static bool uses_tsc() { return state().use_tsc; }
+
+    // Raw reading for timing an interval: rdtscp, which waits for earlier
+    // instructions to finish before it reads the counter, or steady_clock
+    // nanoseconds without an invariant TSC. Only differences mean anything.
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (state().use_tsc) {
+            unsigned aux;
+            return __rdtscp(&aux);
+        }
+#endif
+        return steady_ns();
+    }
+
+    static uint64_t ticks_to_ns(uint64_t ticks) {
+#if defined(__x86_64__) || defined(__i386__)
+        const State& clock = state();
+        if (clock.use_tsc) return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * clock.mult) >> SHIFT);
+#endif
+        return ticks;
+    }
+
+private:
+    static constexpr unsigned SHIFT = 32;
+
+    struct State {
+        bool use_tsc = false;
+        uint64_t base_tsc = 0;
+        uint64_t base_ns = 0;
+        uint64_t mult = 0;  // nanoseconds per tick, as a 32.32 fixed-point value
+    };
+
+    static uint64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static const State& state() {
+        static const State clock = calibrate();
+        return clock;
+    }
+
+    static State calibrate() {
+        State clock;
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        // CPUID 0x80000007 EDX bit 8: TSC ticks at a constant rate in every P/C-state
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8))) return clock;
+
+        uint64_t start_ns = steady_ns();
+        uint64_t start_tsc = __rdtsc();
+        uint64_t end_ns;
+        do {
+            end_ns = steady_ns();
+        } while (end_ns - start_ns < CALIBRATION_NS);
+        uint64_t end_tsc = __rdtsc();
+        if (end_tsc <= start_tsc) return clock;
+
+        clock.mult = static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(end_ns - start_ns) << SHIFT) / (end_tsc - start_tsc));
+        clock.base_tsc = end_tsc;
+        clock.base_ns = end_ns;
+        clock.use_tsc = clock.mult != 0;
+#endif
+        return clock;
+    }
+
+    static constexpr uint64_t CALIBRATION_NS = 2'000'000;
+};
+
+#endif
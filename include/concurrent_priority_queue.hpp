@@ -0,0 +1,334 @@
+#ifndef CONCURRENT_PRIORITY_QUEUE_HPP
+#define CONCURRENT_PRIORITY_QUEUE_HPP
+
+#include "node.hpp"
+#include "spin_lock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fixed-capacity binary max-heap on Node::priority. The priority is copied
+// next to the pointer so sifting never dereferences a Node. The array is
+// allocated once in the constructor; push fails instead of growing.
+// Not thread-safe on its own.
+class BoundedHeap {
+private:
+    struct Entry {
+        int priority;
+        Node* node;
+    };
+
+    std::unique_ptr<Entry[]> entries_;
+    size_t capacity_;
+    size_t size_ = 0;
+
+    void sift_up(size_t index) {
+        Entry entry = entries_[index];
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (entries_[parent].priority >= entry.priority) break;
+            entries_[index] = entries_[parent];
+            index = parent;
+        }
+        entries_[index] = entry;
+    }
+
+    void sift_down(size_t index) {
+        Entry entry = entries_[index];
+        while (true) {
+            size_t child = 2 * index + 1;
+            if (child >= size_) break;
+            if (child + 1 < size_ && entries_[child + 1].priority > entries_[child].priority) ++child;
+            if (entries_[child].priority <= entry.priority) break;
+            entries_[index] = entries_[child];
+            index = child;
+        }
+        entries_[index] = entry;
+    }
+
+public:
+    explicit BoundedHeap(size_t capacity) : entries_(new Entry[capacity]), capacity_(capacity) {}
+
+    bool push(Node* node) {
+        if (size_ >= capacity_) return false;
+        entries_[size_] = Entry{node->priority, node};
+        sift_up(size_++);
+        return true;
+    }
+
+    Node* pop() {
+        if (size_ == 0) return nullptr;
+        Node* top = entries_[0].node;
+        if (--size_ > 0) {
+            entries_[0] = entries_[size_];
+            sift_down(0);
+        }
+        return top;
+    }
+
+    // Appends as many of nodes as fit and restores the heap, by Floyd's
+    // O(n) rebuild when the batch is large next to what is queued
+    size_t push_bulk(Node* const* nodes, size_t count) {
+        size_t taken = std::min(count, capacity_ - size_);
+        size_t start = size_;
+        for (size_t i = 0; i < taken; ++i) entries_[size_ + i] = Entry{nodes[i]->priority, nodes[i]};
+        size_ += taken;
+        if (taken > start) {
+            for (size_t i = size_ / 2; i-- > 0;) sift_down(i);
+        } else {
+            for (size_t i = start; i < size_; ++i) sift_up(i);
+        }
+        return taken;
+    }
+
+    // Drops the nodes pred selects, up to limit, handing each to sink, then
+    // rebuilds the heap in O(n). Entries past the limit are not visited.
+    template <typename Pred, typename Sink>
+    size_t remove_if(Pred&& pred, Sink&& sink, size_t limit) {
+        size_t kept = 0;
+        size_t removed = 0;
+        size_t index = 0;
+        for (; index < size_ && removed < limit; ++index) {
+            if (pred(entries_[index].node)) {
+                sink(entries_[index].node);
+                ++removed;
+            } else {
+                entries_[kept++] = entries_[index];
+            }
+        }
+        for (; index < size_; ++index) entries_[kept++] = entries_[index];
+        size_ = kept;
+        if (removed) {
+            for (size_t i = size_ / 2; i-- > 0;) sift_down(i);
+        }
+        return removed;
+    }
+
+    // Visits every queued node in array order
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (size_t i = 0; i < size_; ++i) fn(static_cast<const Node&>(*entries_[i].node));
+    }
+
+    // Pulls the root line in for writing ahead of a push or pop
+    void prefetch() const { __builtin_prefetch(entries_.get(), 1); }
+
+    Node* top() const { return size_ ? entries_[0].node : nullptr; }
+    int top_priority() const { return entries_[0].priority; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+};
+
+// Per-symbol priority queue that stays fast under many writers.
+//
+// The queue is split into shards, each a BoundedHeap behind its own
+// SpinLock, with the shard's top priority published in an atomic. A push
+// goes to the calling thread's home shard; if that shard is locked or full
+// it moves on to the next one, so writers on a hot symbol spread out
+// instead of queueing on one cache line. A pop reads every shard's
+// published top, locks the best one and checks that its top did not drop
+// while it waited. If it did, the pop rescans.
+//
+// With one shard this is an exact heap. With more shards, pops that run
+// with no concurrent pushes still drain in strict priority order; under
+// concurrency a pop can only miss entries whose push is still in flight.
+// Storage is fixed at construction: capacity is split evenly across shards
+// and a push only fails once every shard is full.
+class ConcurrentPriorityQueue {
+private:
+    static constexpr int64_t EMPTY_PRIORITY = std::numeric_limits<int64_t>::min();
+
+    struct alignas(64) Shard {
+        SpinLock lock;
+        std::atomic<int64_t> top_priority{EMPTY_PRIORITY};
+        std::atomic<size_t> size{0};
+        BoundedHeap heap;
+        explicit Shard(size_t capacity) : heap(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t capacity_;
+
+    // Stable per-thread index so each writer keeps hitting the same shard
+    static size_t thread_slot() {
+        static std::atomic<size_t> next_slot{0};
+        thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    // Caller holds shard.lock
+    static void publish(Shard& shard) {
+        shard.top_priority.store(shard.heap.empty() ? EMPTY_PRIORITY : shard.heap.top_priority(),
+                                 std::memory_order_release);
+        shard.size.store(shard.heap.size(), std::memory_order_relaxed);
+    }
+
+    static bool push_locked(Shard& shard, Node* node) {
+        if (!shard.heap.push(node)) return false;
+        publish(shard);
+        return true;
+    }
+
+public:
+    explicit ConcurrentPriorityQueue(size_t capacity, size_t num_shards = 1) : capacity_(capacity) {
+        if (num_shards == 0) num_shards = 1;
+        size_t per_shard = (capacity + num_shards - 1) / num_shards;
+        shards_.reserve(num_shards);
+        for (size_t i = 0; i < num_shards; ++i) {
+            shards_.push_back(std::make_unique<Shard>(per_shard));
+        }
+    }
+
+    ConcurrentPriorityQueue(const ConcurrentPriorityQueue&) = delete;
+    ConcurrentPriorityQueue& operator=(const ConcurrentPriorityQueue&) = delete;
+
+    bool push(Node* node) {
+        size_t count = shards_.size();
+        size_t home = thread_slot() % count;
+
+        // First pass never waits: skip shards that are busy or full
+        for (size_t i = 0; i < count; ++i) {
+            Shard& shard = *shards_[(home + i) % count];
+            if (!shard.lock.try_lock()) continue;
+            bool pushed = push_locked(shard, node);
+            shard.lock.unlock();
+            if (pushed) return true;
+        }
+
+        // Everything was contended or full: wait for each shard in turn
+        for (size_t i = 0; i < count; ++i) {
+            Shard& shard = *shards_[(home + i) % count];
+            std::lock_guard<SpinLock> guard(shard.lock);
+            if (push_locked(shard, node)) return true;
+        }
+        return false;
+    }
+
+    Node* pop() {
+        while (true) {
+            Shard* best = nullptr;
+            int64_t best_priority = EMPTY_PRIORITY;
+            for (auto& shard : shards_) {
+                int64_t priority = shard->top_priority.load(std::memory_order_acquire);
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    best = shard.get();
+                }
+            }
+            if (!best) return nullptr;
+
+            std::lock_guard<SpinLock> guard(best->lock);
+            if (best->heap.empty() || best->heap.top_priority() < best_priority) continue;
+            Node* node = best->heap.pop();
+            publish(*best);
+            return node;
+        }
+    }
+
+    // Pops up to count nodes into out in priority order. A shard whose top
+    // wins is drained under one lock for as long as it stays ahead of every
+    // other shard's published top, so with one shard the whole run is a
+    // single lock. Returns how many were popped.
+    size_t pop_bulk(Node** out, size_t count) {
+        size_t popped = 0;
+        while (popped < count) {
+            Shard* best = nullptr;
+            int64_t best_priority = EMPTY_PRIORITY;
+            int64_t runner_up = EMPTY_PRIORITY;
+            for (auto& shard : shards_) {
+                int64_t priority = shard->top_priority.load(std::memory_order_acquire);
+                if (priority > best_priority) {
+                    runner_up = best_priority;
+                    best_priority = priority;
+                    best = shard.get();
+                } else if (priority > runner_up) {
+                    runner_up = priority;
+                }
+            }
+            if (!best) break;
+
+            std::lock_guard<SpinLock> guard(best->lock);
+            if (best->heap.empty() || best->heap.top_priority() < best_priority) continue;
+            do {
+                out[popped++] = best->heap.pop();
+            } while (popped < count && !best->heap.empty() && best->heap.top_priority() >= runner_up);
+            publish(*best);
+        }
+        return popped;
+    }
+
+    // Warms the calling thread's home shard, where its next push lands
+    void prefetch() const {
+        const Shard& shard = *shards_[thread_slot() % shards_.size()];
+        __builtin_prefetch(&shard, 1);
+        shard.heap.prefetch();
+    }
+
+    // Bulk insert for restores: spreads nodes over the shards, locking each
+    // once. Returns how many were queued; the rest found no room.
+    size_t push_bulk(Node* const* nodes, size_t count) {
+        size_t pushed = 0;
+        size_t shard_count = shards_.size();
+        size_t home = thread_slot() % shard_count;
+        for (size_t i = 0; i < shard_count && pushed < count; ++i) {
+            Shard& shard = *shards_[(home + i) % shard_count];
+            size_t share = (count - pushed + (shard_count - i) - 1) / (shard_count - i);
+            std::lock_guard<SpinLock> guard(shard.lock);
+            pushed += shard.heap.push_bulk(nodes + pushed, share);
+            publish(shard);
+        }
+        // Shards that filled up early leave a remainder for the ones with room
+        for (size_t i = 0; i < shard_count && pushed < count; ++i) {
+            Shard& shard = *shards_[(home + i) % shard_count];
+            std::lock_guard<SpinLock> guard(shard.lock);
+            pushed += shard.heap.push_bulk(nodes + pushed, count - pushed);
+            publish(shard);
+        }
+        return pushed;
+    }
+
+    // Bulk removal for background expiry; locks one shard at a time
+    template <typename Pred, typename Sink>
+    size_t remove_if(Pred&& pred, Sink&& sink, size_t limit) {
+        size_t removed = 0;
+        for (auto& shard : shards_) {
+            if (removed >= limit) break;
+            std::lock_guard<SpinLock> guard(shard->lock);
+            removed += shard->heap.remove_if(pred, sink, limit - removed);
+            publish(*shard);
+        }
+        return removed;
+    }
+
+    // Visits one shard's nodes under its lock, so fn must be short. Pushes
+    // skip a locked shard, so only pops and sweeps of that shard wait.
+    template <typename Fn>
+    void visit_shard(size_t index, Fn&& fn) {
+        Shard& shard = *shards_[index];
+        std::lock_guard<SpinLock> guard(shard.lock);
+        shard.heap.for_each(fn);
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards_) total += shard->size.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    bool empty() const {
+        for (const auto& shard : shards_) {
+            if (shard->top_priority.load(std::memory_order_acquire) != EMPTY_PRIORITY) return false;
+        }
+        return true;
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t num_shards() const { return shards_.size(); }
+};
+
+#endif
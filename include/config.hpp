@@ -11,12 +11,16 @@ struct CacheConfig {
     size_t cleanup_interval_ms = 1000;  // Background cleanup interval
     size_t max_memory_mb = 1024;        // Maximum memory usage
     bool enable_memory_pool = true;
+    size_t node_magazine_rounds = 32;        // Per-thread NodePool magazine size; 0 keeps one shared free list
+    size_t memory_pool_magazine_rounds = 64; // AdvancedMemoryPool magazine size
     
     // Performance tuning
     size_t num_worker_threads = 4;
     size_t batch_size = 100;
-    size_t hash_table_buckets = 256;
+    size_t hash_table_buckets = 256;    // Deprecated, unused: the global SymbolRegistry grows online
     size_t heap_initial_capacity = 1024;
+    size_t priority_queue_shards = 1;   // Per-symbol heap shards; 1 keeps pops strictly ordered
+    size_t list_shards = 0;             // ShardedRadialCircularList shards; 0 = one per hardware thread
     
     // NUMA settings
     bool enable_numa = true;
@@ -26,6 +30,7 @@ struct CacheConfig {
     bool enable_metrics = true;
     size_t metrics_interval_ms = 5000;
     std::string metrics_file = "cache_metrics.log";
+    std::string metrics_region_path;    // Shared MetricsRegion file, e.g. /dev/shm/hft_cache_metrics; empty keeps it private
     
     // Error handling
     bool enable_error_recovery = true;
@@ -37,6 +42,44 @@ struct CacheConfig {
     bool enable_lazy_cleanup = true;
     size_t max_expired_nodes_per_cleanup = 1000;
     
+    // Multi-level cache
+    size_t l1_capacity = 1000;              // Nodes resident in the L1 hot tier
+    size_t l1_entries_per_symbol = 4;       // Top-k kept per symbol in L1 (at most 8)
+    size_t l2_capacity = 10000;
+    size_t l3_capacity = 100000;
+    int l1_min_priority = 0;                // Lowest priority admitted to L1
+    uint64_t l1_max_age_ns = 1'000'000'000;
+    uint64_t l2_max_age_ns = 60'000'000'000;
+    size_t management_interval_ms = 100;    // MultiLevelCache background pass
+    std::string disk_cache_path = "./cache_data";
+    size_t l3_segment_bytes = 64 << 20;     // mmap'd L3 log segment size
+    double l3_compaction_threshold = 0.5;   // Sealed segments below this live share are rewritten
+    bool l3_compression = false;            // Compaction rewrites live L3 entries as ColumnCodec blocks
+    // TinyLFU tiering; frequencies are per symbol, 0-15, halved every
+    // frequency_sample_factor * sketch width accesses
+    bool enable_frequency_tiering = true;
+    size_t frequency_sample_factor = 10;
+    uint32_t l1_promote_frequency = 3;      // Minimum for an L2 hit to be copied up into L1
+    uint32_t l1_demote_frequency = 1;       // L1 entries below this move down to L2
+    uint32_t l2_demote_frequency = 1;       // Old L2 entries below this move down to L3
+    
+    // Market data
+    size_t trade_window_capacity = 4096;  // Trades kept per symbol for TWAP/VWAP windows
+    
+    // Persistence: PersistentCache write-ahead log, under <checkpoint dir>/wal
+    bool enable_wal = false;
+    size_t wal_buffer_entries = 4096;       // Per-thread ring, rounded up to a power of two
+    size_t wal_group_commit_us = 1000;      // Longest a logged change waits to be written
+    size_t wal_fsync_batch = 16;            // Group commits per fsync; 0 syncs only on demand
+    size_t wal_segment_bytes = 64 << 20;
+    size_t restore_threads = 0;             // Checkpoint restore workers; 0 uses every hardware thread
+    bool checkpoint_compression = false;    // Write checkpoints as ColumnCodec blocks
+    
+    // Security: SecurityManager audit records are queued here and written
+    // to the audit log in batches by a background thread
+    size_t audit_ring_entries = 4096;       // Rounded up to a power of two; records past it are dropped
+    size_t audit_flush_interval_ms = 10;
+    
     // Threading
     bool enable_lock_free_operations = true;
     size_t spin_count_before_yield = 1000;
@@ -48,7 +91,7 @@ struct CacheConfig {
                max_memory_mb > 0 &&
                num_worker_threads > 0 &&
                batch_size > 0 &&
-               hash_table_buckets > 0;
+               priority_queue_shards > 0;
     }
 };
 
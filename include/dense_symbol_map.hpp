@@ -0,0 +1,83 @@
+#ifndef DENSE_SYMBOL_MAP_HPP
+#define DENSE_SYMBOL_MAP_HPP
+
+#include "symbol_registry.hpp"
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Dense SymbolId -> T index.
+//
+// SymbolIds are small consecutive integers, so a lookup is a direct index
+// into a chunked array instead of a hash probe: the chunk directory stays
+// hot in cache and a hit costs the slot line plus the value itself.
+// Chunks and values are created on first use and published with a CAS;
+// a thread that loses the race frees its copy and uses the winner's.
+// Values are never moved or freed before the map is destroyed.
+template <typename T>
+class DenseSymbolMap {
+private:
+    static constexpr size_t CHUNK_BITS = 10;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t MAX_CHUNKS = SymbolRegistry::MAX_SYMBOLS >> CHUNK_BITS;
+
+    struct Chunk {
+        std::atomic<T*> slots[CHUNK_SIZE];
+        Chunk() { for (auto& slot : slots) slot.store(nullptr, std::memory_order_relaxed); }
+    };
+
+    std::unique_ptr<std::atomic<Chunk*>[]> chunks_;
+    std::atomic<size_t> size_{0};
+
+    Chunk* get_or_create_chunk(size_t index) {
+        Chunk* chunk = chunks_[index].load(std::memory_order_acquire);
+        if (chunk) return chunk;
+        Chunk* fresh = new Chunk();
+        if (chunks_[index].compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) return fresh;
+        delete fresh;
+        return chunk;
+    }
+
+public:
+    DenseSymbolMap() : chunks_(new std::atomic<Chunk*>[MAX_CHUNKS]) {
+        for (size_t i = 0; i < MAX_CHUNKS; ++i) chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~DenseSymbolMap() {
+        for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+            Chunk* chunk = chunks_[i].load(std::memory_order_relaxed);
+            if (!chunk) continue;
+            for (auto& slot : chunk->slots) delete slot.load(std::memory_order_relaxed);
+            delete chunk;
+        }
+    }
+
+    DenseSymbolMap(const DenseSymbolMap&) = delete;
+    DenseSymbolMap& operator=(const DenseSymbolMap&) = delete;
+
+    T* get(SymbolId id) const {
+        if (id >= SymbolRegistry::MAX_SYMBOLS) return nullptr;
+        Chunk* chunk = chunks_[id >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk ? chunk->slots[id & (CHUNK_SIZE - 1)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Returns the value for id, constructing it from args on first use.
+    template <typename... Args>
+    T* get_or_create(SymbolId id, Args&&... args) {
+        if (id >= SymbolRegistry::MAX_SYMBOLS) return nullptr;
+        std::atomic<T*>& slot = get_or_create_chunk(id >> CHUNK_BITS)->slots[id & (CHUNK_SIZE - 1)];
+        T* value = slot.load(std::memory_order_acquire);
+        if (value) return value;
+        T* fresh = new T(std::forward<Args>(args)...);
+        if (slot.compare_exchange_strong(value, fresh, std::memory_order_acq_rel)) {
+            size_.fetch_add(1, std::memory_order_relaxed);
+            return fresh;
+        }
+        delete fresh;
+        return value;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+};
+
+#endif
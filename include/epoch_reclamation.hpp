@@ -0,0 +1,91 @@
+#ifndef EPOCH_RECLAMATION_HPP
+#define EPOCH_RECLAMATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Epoch-based safe memory reclamation shared by the lock-free structures.
+//
+// A thread reads shared pointers only inside a critical section opened by an
+// EpochGuard. Memory that has been unlinked is handed to retire() instead of
+// being freed; it sits in the retiring thread's bag, stamped with the global
+// epoch, and is freed during a later collect() once the epoch has advanced
+// twice. The epoch only advances when every thread inside a critical section
+// has observed the current one, so nothing a reader could still hold is ever
+// freed under it. Retiring is a vector push; frees are batched every
+// COLLECT_THRESHOLD retires, off the call that did the unlink.
+class EpochManager {
+public:
+    using Deleter = void (*)(void*);
+
+    static constexpr size_t COLLECT_THRESHOLD = 64;
+
+    static EpochManager& global();
+
+    void enter();
+    void exit();
+    bool in_critical_section() const;
+
+    uint64_t current_epoch() const { return epoch_.load(std::memory_order_acquire); }
+    // Memory retired at retire_epoch may be freed once this returns true.
+    bool is_safe(uint64_t retire_epoch) const { return current_epoch() >= retire_epoch + 2; }
+    // Advances the global epoch if every active thread has seen the current one.
+    bool try_advance();
+
+    void retire(void* ptr, Deleter deleter);
+    template <typename T>
+    void retire(T* ptr) {
+        retire(static_cast<void*>(ptr), [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    // Frees whatever this thread (and any exited thread) retired that is now safe.
+    void collect();
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+private:
+    struct Retired {
+        void* ptr;
+        Deleter deleter;
+        uint64_t epoch;
+    };
+
+    struct alignas(64) ThreadRecord {
+        std::atomic<uint64_t> epoch{0};  // 0 while outside a critical section
+        std::atomic<bool> in_use{true};
+        ThreadRecord* next = nullptr;
+        unsigned depth = 0;              // guard nesting, owner-only
+        std::vector<Retired> bag;        // owner-only
+    };
+
+    friend struct EpochThreadHandle;
+
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<ThreadRecord*> records_{nullptr};
+    std::mutex orphan_mutex_;
+    std::vector<Retired> orphans_;       // bags left behind by exited threads
+    std::atomic<bool> has_orphans_{false};
+
+    EpochManager() = default;
+
+    ThreadRecord& local();
+    ThreadRecord* acquire_record();
+    void release_record(ThreadRecord* record);
+    static void free_safe(std::vector<Retired>& bag, uint64_t epoch);
+};
+
+// RAII critical section. Nests freely; only the outermost guard publishes.
+class EpochGuard {
+public:
+    EpochGuard() { EpochManager::global().enter(); }
+    ~EpochGuard() { EpochManager::global().exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <exception>
 #include <string>
 #include <functional>
+#include <map>
 #include <vector>
 #include <atomic>
 #include <mutex>
@@ -27,6 +28,9 @@ enum class ErrorType {
     CONFIGURATION_ERROR,
     RECOVERY_FAILED,
     METRICS_ERROR,
+    CACHE_FULL,
+    OPERATION_FAILED,
+    DISK_IO_ERROR,
     UNKNOWN_ERROR
 };
 
@@ -65,7 +69,7 @@ class ErrorHandler {
 private:
     CacheConfig config_;
     std::vector<ErrorInfo> error_history_;
-    std::mutex error_mutex_;
+    mutable std::mutex error_mutex_;
     std::atomic<uint64_t> total_errors_{0};
     std::atomic<uint64_t> recovery_attempts_{0};
     std::atomic<uint64_t> successful_recoveries_{0};
@@ -123,6 +127,14 @@ private:
     std::string generate_stack_trace() const;
     void check_error_thresholds();
     void trigger_emergency_mode();
+    
+    // Default recovery strategies
+    bool handle_memory_allocation_failure(const ErrorInfo& error);
+    bool handle_memory_corruption(const ErrorInfo& error);
+    bool handle_thread_contention(const ErrorInfo& error);
+    bool handle_data_corruption(const ErrorInfo& error);
+    bool handle_numa_error(const ErrorInfo& error);
+    bool perform_default_recovery(const ErrorInfo& error);
 };
 
 // Global error handler instance
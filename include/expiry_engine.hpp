@@ -0,0 +1,59 @@
+#ifndef EXPIRY_ENGINE_HPP
+#define EXPIRY_ENGINE_HPP
+
+#include "spin_lock.hpp"
+#include "symbol_registry.hpp"
+#include "timer_wheel.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Proactive expiry for a cache's per-symbol heaps.
+//
+// Insert paths call schedule() when a push lowers a symbol's earliest
+// pending deadline, which for a steady TTL is once per symbol per purge,
+// not once per insert. Requests land in a small spin-locked buffer; run()
+// moves them into a TimerWheel, advances it to now, and calls the purge
+// callback for each symbol that has come due. The callback removes the
+// symbol's expired nodes, returns their slots to the pool and reports the
+// next deadline still pending so the symbol can be rescheduled.
+//
+// run() is meant for a single background thread (MemoryManager's cleanup
+// worker) and is bounded by its budget; a symbol the budget cut short is
+// picked up again on the next pass.
+class ExpiryEngine {
+public:
+    // (symbol, now, max nodes to remove, next deadline out) -> nodes removed.
+    // next is left at UINT64_MAX when nothing needs rescheduling.
+    using PurgeFn = std::function<size_t(SymbolId, uint64_t, size_t, uint64_t&)>;
+
+    explicit ExpiryEngine(PurgeFn purge);
+
+    ExpiryEngine(const ExpiryEngine&) = delete;
+    ExpiryEngine& operator=(const ExpiryEngine&) = delete;
+
+    // Any thread.
+    void schedule(SymbolId symbol, uint64_t deadline_ns);
+
+    // Purges up to max_nodes expired nodes that were due by now_ns and
+    // returns how many went. Returns 0 at once if another run is active.
+    size_t run(uint64_t now_ns, size_t max_nodes);
+
+    uint64_t total_expired() const { return total_expired_.load(std::memory_order_relaxed); }
+
+private:
+    PurgeFn purge_;
+    std::mutex run_mutex_;
+    TimerWheel wheel_;                      // guarded by run_mutex_
+    std::vector<TimerWheel::Entry> due_;    // fired but not yet purged; guarded by run_mutex_
+    std::vector<TimerWheel::Entry> drained_;  // swapped with incoming_ each run
+
+    SpinLock incoming_lock_;
+    std::vector<TimerWheel::Entry> incoming_;
+
+    std::atomic<uint64_t> total_expired_{0};
+};
+
+#endif
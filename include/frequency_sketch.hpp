@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace hft_cache {
+
+/**
+ * @brief Count-min sketch of 4-bit counters with periodic aging (the TinyLFU filter)
+ *
+ * Each 64-bit word packs sixteen counters. A key hashes to one word per row
+ * and one counter per row within it, so an increment touches four words and
+ * frequency() is the minimum of four counters, saturating at 15. After
+ * sample_factor increments per slot of width every counter is halved, so
+ * popularity decays and a symbol that went quiet loses its standing within
+ * a few sample periods. Updates are relaxed CAS loops: concurrent callers
+ * may lose the odd increment, which only adds to the sketch's estimation
+ * error.
+ */
+class FrequencySketch {
+public:
+    static constexpr uint32_t MAX_FREQUENCY = 15;
+
+    explicit FrequencySketch(size_t expected_entries, size_t sample_factor = 10);
+
+    FrequencySketch(const FrequencySketch&) = delete;
+    FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+    void increment(uint64_t key);
+    uint32_t frequency(uint64_t key) const;
+
+    size_t sample_size() const { return sample_size_; }
+    size_t agings() const { return agings_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t ROWS = 4;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> table_;
+    size_t mask_;
+    size_t sample_size_;
+    std::atomic<size_t> additions_{0};
+    std::atomic<size_t> agings_{0};
+
+    static uint64_t mix(uint64_t key, size_t row);
+    bool increment_at(size_t word, size_t counter);
+    void age();
+};
+
+} // namespace hft_cache
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "dense_symbol_map.hpp"
+#include "frequency_sketch.hpp"
+#include "node.hpp"
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hft_cache {
+
+/**
+ * @brief Symbol-indexed L1 tier: a small top-k array per symbol under CLOCK admission
+ *
+ * Each symbol keeps at most entries_per_symbol nodes in a fixed array, so a
+ * lookup is a dense index plus a scan of a handful of slots. Total residency
+ * is bounded by a CLOCK ring of capacity slots: a hit sets the slot's
+ * reference bit, and admitting into a full tier advances the hand, clearing
+ * bits until it finds an unreferenced victim. Each step of the hand clears
+ * one bit, so admission is constant time amortized.
+ *
+ * Nodes handed in are owned by the tier until they come back out of admit,
+ * pop, evict_one, remove or drain; the tier deletes whatever it still holds
+ * when it is destroyed, so callers whose nodes come from a pool must drain
+ * it first. Callers that hand out pointers from peek or pop are responsible
+ * for retiring unlinked nodes rather than freeing them.
+ * Locks: the ring lock is only taken to claim or sweep slots, before any
+ * symbol lock; lookups and removals take only their symbol's lock.
+ */
+class HotTier {
+public:
+    static constexpr size_t MAX_ENTRIES_PER_SYMBOL = 8;
+
+    HotTier(size_t capacity, size_t entries_per_symbol);
+    ~HotTier();
+
+    HotTier(const HotTier&) = delete;
+    HotTier& operator=(const HotTier&) = delete;
+
+    /**
+     * @brief Admits node, taking ownership on success
+     *
+     * A symbol that is already full only admits a node of higher priority
+     * than its lowest entry, which is displaced. When the ring is full the
+     * CLOCK victim is unlinked. Either way the displaced node is returned in
+     * evicted, which can be set even when admission itself fails.
+     *
+     * With a sketch, a tier that has to evict becomes a TinyLFU filter: the
+     * victim only goes if the candidate's symbol is strictly more frequent,
+     * otherwise the candidate is turned away and the victim stays. Free
+     * slots are always taken, so the first touches of a new symbol land
+     * while there is room.
+     */
+    bool admit(Node* node, Node*& evicted, const FrequencySketch* sketch = nullptr);
+
+    // Highest-priority live entry for symbol, left in place; marks it referenced
+    Node* peek(SymbolId symbol);
+    // Unlinks and returns the entry peek would return, or nullptr
+    Node* pop(SymbolId symbol);
+    // Unlinks the entry with this value and returns it, or nullptr
+    Node* remove(SymbolId symbol, double value);
+    // Unlinks the next CLOCK victim, or returns nullptr when empty
+    Node* evict_one();
+    // Unlinks every entry into out
+    void drain(std::vector<Node*>& out);
+
+    // Visits up to limit occupied slots from a cursor of its own, unlinking
+    // entries for which pred(const Node&) holds into out. Successive calls
+    // walk the whole ring, so a background pass covers it incrementally.
+    template <typename Pred>
+    size_t evict_if(Pred&& pred, std::vector<Node*>& out, size_t limit);
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<bool> occupied{false};
+        std::atomic<bool> referenced{false};
+        SymbolId symbol = INVALID_SYMBOL_ID;  // written and read under ring_lock_
+    };
+
+    struct Entries {
+        SpinLock lock;
+        uint32_t count = 0;
+        Node* nodes[MAX_ENTRIES_PER_SYMBOL];
+        uint32_t slots[MAX_ENTRIES_PER_SYMBOL];
+    };
+
+    size_t capacity_;
+    size_t entries_per_symbol_;
+    std::unique_ptr<Slot[]> ring_;
+    size_t hand_ = 0;
+    size_t scan_cursor_ = 0;  // evict_if position, under ring_lock_
+    SpinLock ring_lock_;
+    DenseSymbolMap<Entries> entries_;
+    std::atomic<size_t> size_{0};
+
+    // With ring_lock_ held: advances the hand to a free slot (if want_free)
+    // or an unreferenced victim, unlinking the victim into evicted. Returns
+    // the slot index, or capacity_ if want_free is false and the tier is
+    // empty, or if sketch rates the victim at least as high as candidate.
+    size_t sweep(bool want_free, Node*& evicted, SymbolId candidate = INVALID_SYMBOL_ID,
+                 const FrequencySketch* sketch = nullptr);
+    // With the entry's lock held
+    Node* unlink(Entries& entries, uint32_t index);
+    // With the entry's lock held: index of the highest-priority live
+    // entry, or entries.count if none
+    static uint32_t best(const Entries& entries, uint64_t now);
+};
+
+template <typename Pred>
+size_t HotTier::evict_if(Pred&& pred, std::vector<Node*>& out, size_t limit) {
+    std::lock_guard<SpinLock> ring_lock(ring_lock_);
+    size_t removed = 0;
+    for (size_t visited = 0; visited < capacity_ && limit > 0; ++visited) {
+        size_t index = scan_cursor_;
+        scan_cursor_ = scan_cursor_ + 1 == capacity_ ? 0 : scan_cursor_ + 1;
+        Slot& slot = ring_[index];
+        if (!slot.occupied.load(std::memory_order_acquire)) continue;
+        --limit;
+        Entries* entries = entries_.get(slot.symbol);
+        if (!entries) continue;
+        std::lock_guard<SpinLock> lock(entries->lock);
+        for (uint32_t i = 0; i < entries->count; ++i) {
+            if (entries->slots[i] == index) {
+                if (pred(static_cast<const Node&>(*entries->nodes[i]))) {
+                    out.push_back(unlink(*entries, i));
+                    ++removed;
+                }
+                break;
+            }
+        }
+    }
+    return removed;
+}
+
+} // namespace hft_cache
@@ -0,0 +1,80 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include "clock.hpp"
+#include <cstdint>
+
+// Compile-time switch for hot-path timing, set by the HFT_INSTRUMENTATION
+// CMake option:
+//
+//   0   timers are empty and the recording macros expand to nothing
+//   1   every timed operation is timed (the default)
+//   N   one operation in N is timed, counted per thread
+//
+// A timer reads CoarseClock::ticks, an rdtscp scaled by the calibration
+// CoarseClock already does, instead of a pair of chrono clock calls. When
+// sampling, only timed operations reach MetricsCollector, so its counts are
+// of the sample while its percentiles and rates still describe the whole.
+#ifndef HFT_INSTRUMENTATION
+#define HFT_INSTRUMENTATION 1
+#endif
+
+static_assert(HFT_INSTRUMENTATION >= 0, "HFT_INSTRUMENTATION is 0, 1 or a sampling interval");
+
+namespace instrumentation {
+
+constexpr uint32_t SAMPLE_EVERY = HFT_INSTRUMENTATION;
+
+// True for the operations this thread should time
+inline bool sample() {
+    if constexpr (SAMPLE_EVERY <= 1) {
+        return SAMPLE_EVERY == 1;
+    } else {
+        thread_local uint32_t countdown = 0;
+        if (countdown) {
+            --countdown;
+            return false;
+        }
+        countdown = SAMPLE_EVERY - 1;
+        return true;
+    }
+}
+
+} // namespace instrumentation
+
+// Times from construction to each elapsed_ns call, if this operation was
+// sampled; otherwise sampled() is false and elapsed_ns is 0. With
+// instrumentation compiled out the object is empty and both are constants.
+class LatencyTimer {
+public:
+#if HFT_INSTRUMENTATION
+    LatencyTimer() : start_(instrumentation::sample() ? CoarseClock::ticks() | 1 : 0) {}
+    bool sampled() const { return start_ != 0; }
+    uint64_t elapsed_ns() const { return sampled() ? CoarseClock::ticks_to_ns(CoarseClock::ticks() - start_) : 0; }
+
+private:
+    uint64_t start_;  // low bit set, so a sampled timer is never 0
+#else
+    constexpr bool sampled() const { return false; }
+    constexpr uint64_t elapsed_ns() const { return 0; }
+#endif
+};
+
+// Calls record(elapsed_ns) when the scope ends, if it was sampled
+template <typename Record>
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Record record) : record_(record) {}
+    ~ScopedLatency() {
+        if (timer_.sampled()) record_(timer_.elapsed_ns());
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    LatencyTimer timer_;
+    Record record_;
+};
+
+#endif
@@ -1,74 +1,158 @@
 #ifndef LOCKFREE_MAP_HPP
 #define LOCKFREE_MAP_HPP
 
-#include "midpoint.hpp"
+#include "epoch_reclamation.hpp"
 #include <atomic>
-#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 
+// Open-addressed string-keyed table with linear probing.
+//
+// Lookups never lock: they load the current slot array, compare the cached
+// 64-bit hash stored in each slot and only touch the key string on a hash
+// match, so a hit costs the slot line plus the entry line that holds the
+// value. Creating a key is rare (once per ticker per session) and
+// serializes on writer_mutex_. Past a 1/2 load factor the writer builds a
+// table twice the size from the cached hashes and publishes it with a single
+// pointer store. Readers probe inside an EpochGuard, and the old array is
+// retired through the EpochManager, so it is freed only after every reader
+// that could still be probing it has left its critical section.
+template <typename Value>
 class LockFreeHashTable {
 private:
-    struct BucketNode {
+    struct Entry {
+        uint64_t hash;
         std::string key;
-        MidpointNode* value;
-        std::atomic<BucketNode*> next;
-        BucketNode(const std::string& k, size_t cap) : key(k), value(new MidpointNode(cap)), next(nullptr) {}
+        Value value;
+        template <typename... Args>
+        Entry(uint64_t h, const std::string& k, Args&&... args)
+            : hash(h), key(k), value(std::forward<Args>(args)...) {}
     };
-    static constexpr size_t BUCKETS = 64;
-    std::array<std::atomic<BucketNode*>, BUCKETS> buckets;
 
-    size_t hash(const std::string& key) const {
+    struct Slot {
+        std::atomic<uint64_t> hash{0};  // 0 marks an empty slot
+        std::atomic<Entry*> entry{nullptr};
+    };
+
+    struct Table {
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+        explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::atomic<Table*> table_;
+    std::atomic<size_t> size_{0};
+    std::mutex writer_mutex_;
+
+    static uint64_t hash(const std::string& key) {
         constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
         constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
         uint64_t h = FNV_OFFSET;
-        for (char c : key) { h ^= static_cast<uint64_t>(c); h *= FNV_PRIME; }
-        return h % BUCKETS;
+        for (char c : key) { h ^= static_cast<uint64_t>(static_cast<unsigned char>(c)); h *= FNV_PRIME; }
+        return h ? h : 1;
     }
 
-public:
-    LockFreeHashTable(size_t capacity_per_bucket) {
-        for (auto& bucket : buckets) bucket.store(nullptr, std::memory_order_relaxed);
+    static size_t round_up_pow2(size_t n) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
     }
 
-    ~LockFreeHashTable() {
-        for (auto& bucket : buckets) {
-            BucketNode* node = bucket.load(std::memory_order_relaxed);
-            while (node) {
-                BucketNode* next = node->next.load(std::memory_order_relaxed);
-                delete node->value;
-                delete node;
-                node = next;
+    static Entry* find_in(const Table* table, uint64_t h, const std::string& key) {
+        size_t index = h & table->mask;
+        while (true) {
+            const Slot& slot = table->slots[index];
+            uint64_t slot_hash = slot.hash.load(std::memory_order_acquire);
+            if (slot_hash == 0) return nullptr;
+            if (slot_hash == h) {
+                Entry* entry = slot.entry.load(std::memory_order_relaxed);
+                if (entry->key == key) return entry;
             }
+            index = (index + 1) & table->mask;
         }
     }
 
-    MidpointNode* get_or_create(const std::string& key, size_t capacity) {
-        size_t index = hash(key);
-        BucketNode* head = buckets[index].load(std::memory_order_acquire);
-        while (head) {
-            if (head->key == key) return head->value;
-            head = head->next.load(std::memory_order_acquire);
+    // Writer-only: place an entry into a table that has a free slot.
+    static void place(Table* table, Entry* entry) {
+        size_t index = entry->hash & table->mask;
+        while (table->slots[index].hash.load(std::memory_order_relaxed) != 0) {
+            index = (index + 1) & table->mask;
         }
-        BucketNode* new_node = new BucketNode(key, capacity);
-        while (true) {
-            head = buckets[index].load(std::memory_order_acquire);
-            new_node->next.store(head, std::memory_order_relaxed);
-            if (buckets[index].compare_exchange_weak(head, new_node, std::memory_order_acq_rel)) {
-                return new_node->value;
+        table->slots[index].entry.store(entry, std::memory_order_relaxed);
+        table->slots[index].hash.store(entry->hash, std::memory_order_release);
+    }
+
+    // Writer-only: double the table, reusing cached hashes.
+    void grow(Table* current) {
+        size_t capacity = (current->mask + 1) * 2;
+        Table* next = new Table(capacity);
+        for (size_t i = 0; i <= current->mask; ++i) {
+            if (current->slots[i].hash.load(std::memory_order_relaxed) != 0) {
+                place(next, current->slots[i].entry.load(std::memory_order_relaxed));
             }
-            std::this_thread::yield();
         }
+        table_.store(next, std::memory_order_release);
+        EpochManager::global().retire(current);
     }
 
-    MidpointNode* get(const std::string& key) const {
-        size_t index = hash(key);
-        BucketNode* head = buckets[index].load(std::memory_order_acquire);
-        while (head) {
-            if (head->key == key) return head->value;
-            head = head->next.load(std::memory_order_acquire);
+public:
+    // initial_capacity is the starting slot count (rounded up to a power of two);
+    // the table doubles whenever it becomes half full.
+    explicit LockFreeHashTable(size_t initial_capacity) : table_(new Table(round_up_pow2(initial_capacity))) {}
+
+    ~LockFreeHashTable() {
+        Table* table = table_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= table->mask; ++i) {
+            if (table->slots[i].hash.load(std::memory_order_relaxed) != 0) {
+                delete table->slots[i].entry.load(std::memory_order_relaxed);
+            }
         }
-        return nullptr;
+        delete table;
+    }
+
+    LockFreeHashTable(const LockFreeHashTable&) = delete;
+    LockFreeHashTable& operator=(const LockFreeHashTable&) = delete;
+
+    // Returns the value for key, constructing it from args if it is missing.
+    template <typename... Args>
+    Value* get_or_create(const std::string& key, Args&&... args) {
+        uint64_t h = hash(key);
+        {
+            EpochGuard guard;
+            if (Entry* entry = find_in(table_.load(std::memory_order_acquire), h, key)) return &entry->value;
+        }
+
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        Table* table = table_.load(std::memory_order_relaxed);
+        if (Entry* entry = find_in(table, h, key)) return &entry->value;
+
+        size_t count = size_.load(std::memory_order_relaxed) + 1;
+        if (count * 2 > table->mask + 1) {
+            grow(table);
+            table = table_.load(std::memory_order_relaxed);
+        }
+        Entry* entry = new Entry(h, key, std::forward<Args>(args)...);
+        place(table, entry);
+        size_.store(count, std::memory_order_release);
+        return &entry->value;
+    }
+
+    Value* get(const std::string& key) const {
+        EpochGuard guard;
+        Entry* entry = find_in(table_.load(std::memory_order_acquire), hash(key), key);
+        return entry ? &entry->value : nullptr;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t capacity() const {
+        EpochGuard guard;
+        return table_.load(std::memory_order_acquire)->mask + 1;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
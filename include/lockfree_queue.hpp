@@ -1,10 +1,15 @@
 #ifndef LOCKFREE_QUEUE_HPP
 #define LOCKFREE_QUEUE_HPP
 
+#include "epoch_reclamation.hpp"
 #include <atomic>
 #include <memory>
 #include <thread>
 
+// Michael-Scott queue. Every operation runs inside an EpochGuard and a
+// dequeued dummy node is retired through the EpochManager rather than freed
+// or recycled on the spot, so a thread still reading head->next can never
+// see the node reused underneath it.
 template<typename T>
 class LockFreeQueue {
 private:
@@ -19,18 +24,11 @@ private:
     std::atomic<Node*> head_;
     std::atomic<Node*> tail_;
     
-    // Memory management
-    std::atomic<Node*> free_list_;
-    std::atomic<size_t> free_count_;
-    static constexpr size_t MAX_FREE_NODES = 1000;
-    
 public:
     LockFreeQueue() {
         Node* dummy = new Node();
         head_.store(dummy);
         tail_.store(dummy);
-        free_list_.store(nullptr);
-        free_count_.store(0);
     }
     
     ~LockFreeQueue() {
@@ -41,14 +39,6 @@ public:
             delete current;
             current = next;
         }
-        
-        // Clean up free list
-        current = free_list_.load();
-        while (current) {
-            Node* next = current->next.load();
-            delete current;
-            current = next;
-        }
     }
     
     // Non-copyable
@@ -56,7 +46,8 @@ public:
     LockFreeQueue& operator=(const LockFreeQueue&) = delete;
     
     void enqueue(const T& value) {
-        Node* new_node = allocate_node(value);
+        Node* new_node = new Node(value);
+        EpochGuard guard;
         
         while (true) {
             Node* tail = tail_.load(std::memory_order_acquire);
@@ -83,6 +74,7 @@ public:
     }
     
     bool dequeue(T& value) {
+        EpochGuard guard;
         while (true) {
             Node* head = head_.load(std::memory_order_acquire);
             Node* tail = tail_.load(std::memory_order_acquire);
@@ -104,7 +96,7 @@ public:
                     if (head_.compare_exchange_weak(head, next,
                                                   std::memory_order_release,
                                                   std::memory_order_relaxed)) {
-                        deallocate_node(head);
+                        EpochManager::global().retire(head);
                         return true;
                     }
                 }
@@ -114,12 +106,14 @@ public:
     }
     
     bool empty() const {
+        EpochGuard guard;
         Node* head = head_.load(std::memory_order_acquire);
         Node* tail = tail_.load(std::memory_order_acquire);
         return head == tail && head->next.load(std::memory_order_acquire) == nullptr;
     }
     
     size_t size() const {
+        EpochGuard guard;
         size_t count = 0;
         Node* current = head_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire);
         while (current) {
@@ -128,45 +122,6 @@ public:
         }
         return count;
     }
-
-private:
-    Node* allocate_node(const T& value) {
-        // Try to reuse from free list first
-        Node* free_node = free_list_.load(std::memory_order_acquire);
-        while (free_node) {
-            Node* next = free_node->next.load(std::memory_order_acquire);
-            if (free_list_.compare_exchange_weak(free_node, next,
-                                               std::memory_order_release,
-                                               std::memory_order_relaxed)) {
-                free_count_.fetch_sub(1, std::memory_order_relaxed);
-                free_node->data = value;
-                free_node->next.store(nullptr, std::memory_order_relaxed);
-                return free_node;
-            }
-        }
-        
-        // Allocate new node
-        return new Node(value);
-    }
-    
-    void deallocate_node(Node* node) {
-        if (!node) return;
-        
-        size_t current_free = free_count_.load(std::memory_order_relaxed);
-        if (current_free < MAX_FREE_NODES) {
-            Node* old_head = free_list_.load(std::memory_order_acquire);
-            node->next.store(old_head, std::memory_order_relaxed);
-            if (free_list_.compare_exchange_weak(old_head, node,
-                                               std::memory_order_release,
-                                               std::memory_order_relaxed)) {
-                free_count_.fetch_add(1, std::memory_order_relaxed);
-                return;
-            }
-        }
-        
-        // Free list is full or CAS failed, delete the node
-        delete node;
-    }
 };
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,364 @@
+#ifndef MAGAZINE_CACHE_HPP
+#define MAGAZINE_CACHE_HPP
+
+#include "numa_memory.hpp"
+#include "spin_lock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Per-thread object caches over a lock-free depot, after Bonwick's magazines.
+//
+// A magazine is an array of up to `rounds` free objects. Each thread holds
+// two: allocate pops from the loaded one and release pushes onto it, with
+// no atomic and no lock. When the loaded magazine runs empty (or full) the
+// thread swaps in its other one, and only when both are used up does it
+// trade with the depot: Treiber stacks of full and empty magazines whose
+// 64-bit heads pack a tag next to a 32-bit index, so a reused magazine
+// cannot pass for an unchanged head (ABA). With no full magazine in the
+// depot, refill loads one straight from the backing allocator; with no room
+// for another magazine, spill hands a full one back to it. So a thread
+// touches shared state at most once per `rounds` operations, and a
+// producer/consumer pair just ping-pongs magazines through the depot.
+//
+// A thread's magazines go back to the depot when it exits, so free objects
+// are out of other threads' reach only while a live thread caches them: at
+// most 2 * rounds per thread. A pool that must hand out its last object to
+// whoever asks should size rounds with that in mind. The first MAX_CACHES
+// threads get their own cache; any beyond that share one behind a SpinLock.
+class MagazineCache {
+public:
+    // How far an allocation may reach before it gives up
+    enum Tier {
+        THREAD,   // this thread's magazines only
+        DEPOT,    // also the depot's full magazines
+        BACKING,  // also refill from the backing allocator
+    };
+
+    using Refill = std::function<size_t(void** out, size_t count)>;
+    using Spill = std::function<void(void* const* objects, size_t count)>;
+
+    struct Stats {
+        size_t rounds = 0;
+        size_t magazines = 0;
+        size_t full_magazines = 0;   // in the depot
+        size_t empty_magazines = 0;  // in the depot
+        size_t caches = 0;           // threads holding a cache of their own
+        uint64_t allocations = 0;
+        uint64_t releases = 0;
+        uint64_t depot_allocations = 0;  // allocations that took a full magazine from the depot
+        uint64_t depot_releases = 0;     // releases that parked a full magazine there
+        uint64_t refills = 0;            // magazines loaded from the backing allocator
+        uint64_t refilled_objects = 0;
+        uint64_t spilled_objects = 0;
+    };
+
+    MagazineCache(size_t rounds, Refill refill, Spill spill);
+    ~MagazineCache();
+
+    MagazineCache(const MagazineCache&) = delete;
+    MagazineCache& operator=(const MagazineCache&) = delete;
+
+    // nullptr once every tier up to reach is exhausted
+    void* allocate(Tier reach = BACKING) {
+        Cache* cache = local_cache();
+        if (cache == &overflow_) {
+            std::lock_guard<SpinLock> guard(overflow_lock_);
+            return allocate_from(*cache, reach);
+        }
+        return allocate_from(*cache, reach);
+    }
+
+    void release(void* object) {
+        Cache* cache = local_cache();
+        if (cache == &overflow_) {
+            std::lock_guard<SpinLock> guard(overflow_lock_);
+            release_to(*cache, object);
+            return;
+        }
+        release_to(*cache, object);
+    }
+
+    // Parks the calling thread's cached objects in the depot, where any
+    // thread can take them
+    void flush();
+
+    Stats stats() const;
+    size_t rounds() const { return rounds_; }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr size_t MAX_CACHES = 256;
+    static constexpr size_t CHUNK_MAGAZINES = 64;
+    static constexpr size_t MAX_CHUNKS = 4096;
+
+    struct Magazine {
+        void** rounds = nullptr;
+        uint32_t count = 0;
+        uint32_t index = 0;
+        std::atomic<uint32_t> next{NIL};  // depot link
+    };
+
+    struct MagazineChunk {
+        Magazine magazines[CHUNK_MAGAZINES];
+        std::unique_ptr<void*[]> rounds;
+    };
+
+    // Only the owning thread writes a cache; the counters are atomics so
+    // stats() can read them, but are bumped with a plain load and store
+    struct alignas(64) Cache {
+        Magazine* loaded = nullptr;
+        Magazine* previous = nullptr;
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> releases{0};
+        uint32_t slot = 0;
+        uint32_t next_free = NIL;  // free cache list, under register_mutex_
+    };
+
+    struct Binding {
+        uint64_t owner;
+        Cache* cache;
+    };
+    struct ThreadBindings;
+
+    size_t rounds_;
+    Refill refill_;
+    Spill spill_;
+    uint64_t id_;  // tells thread-local bindings of different caches apart
+
+    std::unique_ptr<MagazineChunk> chunks_[MAX_CHUNKS];
+    std::atomic<size_t> magazine_count_{0};
+    std::mutex grow_mutex_;
+
+    alignas(64) std::atomic<uint64_t> full_head_;
+    alignas(64) std::atomic<uint64_t> empty_head_;
+    alignas(64) std::atomic<size_t> full_count_{0};
+    std::atomic<size_t> empty_count_{0};
+
+    std::unique_ptr<Cache> caches_[MAX_CACHES];
+    size_t cache_count_ = 0;
+    uint32_t free_caches_ = NIL;
+    mutable std::mutex register_mutex_;
+    Cache overflow_;
+    SpinLock overflow_lock_;
+
+    std::atomic<uint64_t> depot_allocations_{0};
+    std::atomic<uint64_t> depot_releases_{0};
+    std::atomic<uint64_t> refills_{0};
+    std::atomic<uint64_t> refilled_objects_{0};
+    std::atomic<uint64_t> spilled_objects_{0};
+
+    static uint64_t pack(uint64_t tag, uint32_t index) { return (tag << 32) | index; }
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static Binding& last_binding() {
+        thread_local Binding last{0, nullptr};
+        return last;
+    }
+
+    Cache* local_cache() {
+        Binding& last = last_binding();
+        return last.owner == id_ ? last.cache : bind();
+    }
+
+    void* allocate_from(Cache& cache, Tier reach) {
+        Magazine* loaded = cache.loaded;
+        if (loaded->count == 0) return allocate_slow(cache, reach);
+        bump(cache.allocations);
+        return loaded->rounds[--loaded->count];
+    }
+
+    void release_to(Cache& cache, void* object) {
+        Magazine* loaded = cache.loaded;
+        if (loaded->count == rounds_) {
+            release_slow(cache, object);
+            return;
+        }
+        bump(cache.releases);
+        loaded->rounds[loaded->count++] = object;
+    }
+
+    static ThreadBindings& thread_bindings();
+    Cache* bind();
+    Cache* claim();
+    void* allocate_slow(Cache& cache, Tier reach);
+    void release_slow(Cache& cache, void* object);
+    // Returns a cache's magazines to the depot and the cache to the free list
+    void detach(Cache* cache);
+
+    Magazine& magazine(uint32_t index) {
+        return chunks_[index / CHUNK_MAGAZINES]->magazines[index % CHUNK_MAGAZINES];
+    }
+    Magazine* new_magazine();
+    Magazine* take_empty();
+    void push(std::atomic<uint64_t>& head, std::atomic<size_t>& count, Magazine* magazine);
+    Magazine* pop(std::atomic<uint64_t>& head, std::atomic<size_t>& count);
+    // Parks a magazine on the depot stack its contents call for
+    void park(Magazine* magazine);
+};
+
+// Objects of one type carved from slabs and recycled through a MagazineCache.
+//
+// create constructs in a free slot and destroy runs the destructor before
+// the slot goes back, so cached slots hold no live objects. Slabs start at
+// initial_objects and double, up to limit objects in all; memory goes back
+// to the system only when the pool is destroyed, and objects still live at
+// that point are not destroyed. owns is a scan of at most MAX_SLABS ranges.
+// Slabs are NumaSlabs; with home_node set each one is bound to that node,
+// otherwise its pages go wherever they are first touched.
+template <typename T>
+class MagazinePool {
+public:
+    static constexpr size_t MAX_SLABS = 48;
+
+    explicit MagazinePool(size_t rounds = 64, size_t initial_objects = 1024, size_t limit = SIZE_MAX,
+                          int home_node = -1)
+        : next_slab_objects_(initial_objects ? initial_objects : 1), limit_(limit), home_node_(home_node),
+          cache_(rounds ? rounds : 1,
+                 [this](void** out, size_t count) { return carve(out, count); },
+                 [this](void* const* objects, size_t count) { take_back(objects, count); }) {}
+
+    MagazinePool(const MagazinePool&) = delete;
+    MagazinePool& operator=(const MagazinePool&) = delete;
+
+    // nullptr past limit, or past reach
+    template <typename... Args>
+    T* create(Args&&... args) {
+        return construct(cache_.allocate(), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    T* create_within(MagazineCache::Tier reach, Args&&... args) {
+        return construct(cache_.allocate(reach), std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        object->~T();
+        cache_.release(object);
+    }
+
+    bool owns(const void* object) const {
+        const unsigned char* at = static_cast<const unsigned char*>(object);
+        size_t count = slab_count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            if (at >= slabs_[i].begin && at < slabs_[i].begin + slabs_[i].objects * sizeof(T)) return true;
+        }
+        return false;
+    }
+
+    // Makes room for objects slots in all now, so the first allocations
+    // do not pay for slabs
+    void reserve(size_t objects) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t total = carved_ + uncarved_;
+        if (total < objects) grow(objects - total);
+    }
+
+    // Raising the limit lets a pool that ran out grow again
+    void set_limit(size_t limit) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = limit;
+    }
+
+    // Slots carved from slabs so far, live or cached
+    size_t carved() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return carved_;
+    }
+
+    size_t limit() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return limit_;
+    }
+
+    void flush() { cache_.flush(); }
+    MagazineCache::Stats stats() const { return cache_.stats(); }
+
+private:
+    struct Slab {
+        NumaSlab memory;
+        unsigned char* begin = nullptr;
+        size_t objects = 0;
+    };
+
+    mutable std::mutex mutex_;
+    Slab slabs_[MAX_SLABS];
+    std::atomic<size_t> slab_count_{0};
+    size_t next_slab_objects_;
+    size_t limit_;
+    int home_node_;
+    // Carving walks the slabs in order; current_/used_ is where it stands
+    size_t current_ = 0;
+    size_t used_ = 0;
+    size_t carved_ = 0;
+    size_t uncarved_ = 0;
+    std::unique_ptr<void*[]> spare_;  // spilled slots, handed out before fresh ones
+    size_t spare_size_ = 0;
+    size_t spare_capacity_ = 0;
+    MagazineCache cache_;
+
+    template <typename... Args>
+    T* construct(void* slot, Args&&... args) {
+        return slot ? new (slot) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Adds a slab of at least at_least objects, or whatever the limit
+    // leaves; false if it leaves none
+    bool grow(size_t at_least) {
+        size_t count = slab_count_.load(std::memory_order_relaxed);
+        size_t room = limit_ > carved_ + uncarved_ ? limit_ - carved_ - uncarved_ : 0;
+        if (count == MAX_SLABS || room == 0) return false;
+        size_t objects = std::min(std::max(next_slab_objects_, at_least), room);
+        // Page aligned, which covers any alignof(T)
+        slabs_[count].memory = NumaSlab(objects * sizeof(T));
+        if (home_node_ >= 0) slabs_[count].memory.bind(0, objects * sizeof(T), home_node_);
+        slabs_[count].begin = static_cast<unsigned char*>(slabs_[count].memory.data());
+        slabs_[count].objects = objects;
+        uncarved_ += objects;
+        next_slab_objects_ = objects * 2;
+        slab_count_.store(count + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t carve(void** out, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t given = 0;
+        while (given < count && spare_size_) out[given++] = spare_[--spare_size_];
+        while (given < count) {
+            if (uncarved_ == 0 && !grow(count - given)) break;
+            if (used_ == slabs_[current_].objects) {
+                ++current_;
+                used_ = 0;
+            }
+            size_t take = std::min(count - given, slabs_[current_].objects - used_);
+            for (size_t i = 0; i < take; ++i) out[given++] = slabs_[current_].begin + (used_ + i) * sizeof(T);
+            used_ += take;
+            uncarved_ -= take;
+            carved_ += take;
+        }
+        return given;
+    }
+
+    void take_back(void* const* objects, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spare_size_ + count > spare_capacity_) {
+            size_t capacity = std::max(spare_capacity_ * 2, spare_size_ + count);
+            std::unique_ptr<void*[]> grown(new void*[capacity]);
+            std::copy(spare_.get(), spare_.get() + spare_size_, grown.get());
+            spare_ = std::move(grown);
+            spare_capacity_ = capacity;
+        }
+        std::copy(objects, objects + count, spare_.get() + spare_size_);
+        spare_size_ += count;
+    }
+};
+
+#endif
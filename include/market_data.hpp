@@ -0,0 +1,126 @@
+#ifndef MARKET_DATA_HPP
+#define MARKET_DATA_HPP
+
+#include "clock.hpp"
+#include "dense_symbol_map.hpp"
+#include "spin_lock.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Best levels first on both sides
+struct MarketDepth {
+    std::vector<std::pair<double, size_t>> bids;  // price, quantity
+    std::vector<std::pair<double, size_t>> asks;  // price, quantity
+};
+
+enum class BookSide { BID, ASK };
+
+// Recent trades for one symbol with prefix sums for windowed averages.
+//
+// Every trade records the running totals of price * quantity, quantity and
+// the price-time integral as they stood when it arrived, so the sums over
+// any suffix of the ring are one subtraction. Finding where a window starts
+// resumes from where the previous query started; for the usual pattern of
+// the same window polled as time moves forward that is a step or two,
+// otherwise it falls back to a binary search. The ring starts small and
+// doubles up to capacity, then drops the oldest trade; a window reaching
+// further back than that is computed over what is retained. Totals are
+// rebased once per capacity trades so the subtractions keep their
+// precision over a long session. Not thread-safe.
+class TradeWindow {
+public:
+    explicit TradeWindow(size_t capacity = 4096);
+
+    // Timestamps are CoarseClock nanoseconds; one older than the last trade
+    // is treated as arriving at the same instant
+    void add(uint64_t timestamp_ns, double price, double quantity);
+
+    // Volume-weighted price of the trades at or after now - window; 0 if none
+    double vwap(uint64_t now_ns, uint64_t window_ns);
+    // Average of the last traded price over [now - window, now]; 0 before the first trade
+    double twap(uint64_t now_ns, uint64_t window_ns);
+
+    size_t size() const { return static_cast<size_t>(head_ - tail_); }
+
+private:
+    struct Trade {
+        uint64_t timestamp_ns;
+        double price;
+        double notional_before;  // sum of price * quantity before this trade
+        double quantity_before;
+        double integral_at;      // price-time integral up to timestamp_ns
+    };
+
+    std::vector<Trade> ring_;
+    size_t capacity_;
+    uint64_t head_ = 0;  // sequence of the next trade
+    uint64_t tail_ = 0;  // sequence of the oldest retained trade
+    uint64_t hint_ = 0;  // where the last window started
+    uint64_t since_rebase_ = 0;
+    double notional_total_ = 0.0;
+    double quantity_total_ = 0.0;
+
+    Trade& at(uint64_t sequence) { return ring_[sequence & (ring_.size() - 1)]; }
+    void grow();
+    void rebase();
+    // Sequence of the first retained trade at or after t, head_ if none
+    uint64_t first_at_or_after(uint64_t t);
+};
+
+// Price-level book for one symbol.
+//
+// Each side is a flat array sorted so the best level is at the back: bids
+// ascending, asks descending. Most updates touch the top of the book, so
+// inserting or erasing a level only shifts the handful of better levels
+// behind it, and a depth snapshot copies just the levels asked for.
+// Not thread-safe.
+class OrderBook {
+public:
+    // Sets the resting quantity at a price; 0 removes the level
+    void update(BookSide side, double price, size_t quantity);
+    void clear();
+
+    // Fills out with up to levels per side, reusing its storage
+    void snapshot(size_t levels, MarketDepth& out) const;
+
+    size_t levels(BookSide side) const { return side == BookSide::BID ? bids_.size() : asks_.size(); }
+
+private:
+    std::vector<std::pair<double, size_t>> bids_;
+    std::vector<std::pair<double, size_t>> asks_;
+};
+
+// Per-symbol trade windows and books, fed from the market data handler.
+// Every symbol has its own SpinLock, so updates and queries on different
+// symbols never contend and a query costs one lock plus the arithmetic.
+class MarketDataEngine {
+public:
+    explicit MarketDataEngine(size_t trades_per_symbol = 4096) : trades_per_symbol_(trades_per_symbol) {}
+
+    MarketDataEngine(const MarketDataEngine&) = delete;
+    MarketDataEngine& operator=(const MarketDataEngine&) = delete;
+
+    void on_trade(SymbolId symbol, double price, double quantity, uint64_t timestamp_ns = CoarseClock::now());
+    void on_book_update(SymbolId symbol, BookSide side, double price, size_t quantity);
+    void clear_book(SymbolId symbol);
+
+    double twap(SymbolId symbol, uint64_t window_ns, uint64_t now_ns = CoarseClock::now());
+    double vwap(SymbolId symbol, uint64_t window_ns, uint64_t now_ns = CoarseClock::now());
+    void depth(SymbolId symbol, size_t levels, MarketDepth& out) const;
+
+private:
+    struct SymbolMarket {
+        SpinLock lock;
+        TradeWindow trades;
+        OrderBook book;
+
+        explicit SymbolMarket(size_t capacity) : trades(capacity) {}
+    };
+
+    DenseSymbolMap<SymbolMarket> markets_;
+    size_t trades_per_symbol_;
+};
+
+#endif
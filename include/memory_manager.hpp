@@ -2,7 +2,9 @@
 #define MEMORY_MANAGER_HPP
 
 #include "config.hpp"
+#include "expiry_engine.hpp"
 #include "node.hpp"
+#include "node_pool.hpp"
 #include <atomic>
 #include <thread>
 #include <vector>
@@ -34,16 +36,21 @@ private:
     std::atomic<bool> shutdown_{false};
     std::thread cleanup_thread_;
     
-    // Memory pool
-    std::vector<Node*> node_pool_;
-    std::atomic<size_t> pool_index_{0};
+    // Memory pool: one slab partitioned per NUMA node. Nodes past its
+    // capacity come from numa_allocate and are tracked in memory_blocks_.
+    std::unique_ptr<NodePool> node_pool_;
     std::atomic<size_t> allocated_nodes_{0};
     
     // Background cleanup
     std::queue<Node*> expired_nodes_;
-    std::mutex expired_mutex_;
+    mutable std::mutex expired_mutex_;
     std::condition_variable cleanup_cv_;
     
+    // Timer-wheel expiry for the caches sharing this cleanup thread
+    std::vector<ExpiryEngine*> expiry_engines_;
+    std::mutex engines_mutex_;
+    size_t next_engine_ = 0;
+    
     // Memory tracking
     std::atomic<size_t> total_memory_usage_{0};
     std::vector<MemoryBlock> memory_blocks_;
@@ -56,6 +63,7 @@ private:
     std::atomic<uint64_t> allocations_{0};
     std::atomic<uint64_t> deallocations_{0};
     std::atomic<uint64_t> cleanup_cycles_{0};
+    std::atomic<uint64_t> expired_purged_{0};
 
 public:
     explicit MemoryManager(const CacheConfig& config);
@@ -71,6 +79,12 @@ public:
     void stop_cleanup_thread();
     void cleanup_expired_nodes();
     
+    // Each cleanup pass also advances every registered engine. Passes are
+    // capped at max_expired_nodes_per_cleanup nodes in total. Unregister an
+    // engine before its cache goes away; this waits out a pass in flight.
+    void register_expiry_engine(ExpiryEngine* engine);
+    void unregister_expiry_engine(ExpiryEngine* engine);
+    
     // Memory monitoring
     size_t get_memory_usage() const { return total_memory_usage_.load(); }
     size_t get_allocated_nodes() const { return allocated_nodes_.load(); }
@@ -86,6 +100,7 @@ public:
         uint64_t allocations;
         uint64_t deallocations;
         uint64_t cleanup_cycles;
+        uint64_t expired_purged;
         size_t memory_usage;
         size_t allocated_nodes;
         size_t expired_nodes_queue_size;
@@ -103,6 +118,7 @@ private:
     void* allocate_on_numa(size_t size, int numa_node);
     void deallocate_from_numa(void* ptr, size_t size, int numa_node);
     bool should_cleanup() const;
+    void free_node(Node* node);
 };
 
 #endif 
\ No newline at end of file
@@ -2,88 +2,193 @@
 #define METRICS_HPP
 
 #include "config.hpp"
+#include "instrumentation.hpp"
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <thread>
+#include <memory>
 #include <mutex>
 #include <fstream>
 #include <map>
 #include <functional>
 
+struct MetricsRegion;
+class MetricsRegionWriter;
+
+// Operations whose latency MetricsCollector keeps a histogram of
+enum class MetricOp : uint8_t {
+    INSERT,
+    RETRIEVE,
+    BATCH_INSERT,
+    BATCH_RETRIEVE,
+    LOCK_WAIT,  // record_thread_contention
+    COUNT
+};
+
+const char* metric_op_name(MetricOp op);
+
+// Log-linear latency histogram in the HdrHistogram layout. Below
+// 2^SUB_BITS ns every nanosecond has a bucket; above, each power of two is
+// split into 2^SUB_BITS buckets, so a percentile is within 1/2^SUB_BITS
+// (about 3%) of a recorded value. Values from 2^(MAX_EXPONENT + 1) ns,
+// about 36 minutes, share the last bucket. Plain counters: this is
+// the merged, copyable form; recording threads keep atomic shards.
+struct LatencyHistogram {
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr size_t BUCKETS = size_t(MAX_EXPONENT - SUB_BITS + 2) << SUB_BITS;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+
+    static size_t bucket_of(uint64_t ns) {
+        if (ns < (uint64_t(1) << SUB_BITS)) return static_cast<size_t>(ns);
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+        if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+        unsigned shift = exponent - SUB_BITS;
+        return (size_t(shift + 1) << SUB_BITS) + static_cast<size_t>((ns >> shift) - (uint64_t(1) << SUB_BITS));
+    }
+    // Largest value that lands in bucket
+    static uint64_t upper_bound_ns(size_t bucket);
+
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram& other);
+    // Upper bound of the bucket holding quantile q, capped at max_ns
+    uint64_t percentile_ns(double q) const;
+    double mean_ns() const { return count ? static_cast<double>(total_ns) / count : 0.0; }
+};
+
+// What snapshots and history keep of a histogram
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+
+    static LatencySummary of(const LatencyHistogram& histogram);
+};
+
+// A point-in-time copy of the counters, merged across recording threads.
+// Plain values, so snapshots copy and store freely.
 struct CacheMetrics {
     // Performance metrics
-    std::atomic<uint64_t> total_inserts{0};
-    std::atomic<uint64_t> total_retrieves{0};
-    std::atomic<uint64_t> total_batch_inserts{0};
-    std::atomic<uint64_t> total_batch_retrieves{0};
-    
+    uint64_t total_inserts = 0;
+    uint64_t total_retrieves = 0;
+    uint64_t total_batch_inserts = 0;
+    uint64_t total_batch_retrieves = 0;
+    uint64_t total_batch_items = 0;
+
     // Latency metrics (in nanoseconds)
-    std::atomic<uint64_t> total_insert_latency{0};
-    std::atomic<uint64_t> total_retrieve_latency{0};
-    std::atomic<uint64_t> total_batch_insert_latency{0};
-    std::atomic<uint64_t> total_batch_retrieve_latency{0};
-    
+    uint64_t total_insert_latency = 0;
+    uint64_t total_retrieve_latency = 0;
+    uint64_t total_batch_insert_latency = 0;
+    uint64_t total_batch_retrieve_latency = 0;
+    LatencySummary latency[static_cast<size_t>(MetricOp::COUNT)];
+
     // Error metrics
-    std::atomic<uint64_t> insert_errors{0};
-    std::atomic<uint64_t> retrieve_errors{0};
-    std::atomic<uint64_t> memory_errors{0};
-    std::atomic<uint64_t> recovery_attempts{0};
-    
+    uint64_t insert_errors = 0;
+    uint64_t retrieve_errors = 0;
+    uint64_t memory_errors = 0;
+    uint64_t recovery_attempts = 0;
+
     // Memory metrics
-    std::atomic<size_t> current_memory_usage{0};
-    std::atomic<size_t> peak_memory_usage{0};
-    std::atomic<size_t> allocated_nodes{0};
-    std::atomic<size_t> expired_nodes{0};
-    
+    size_t current_memory_usage = 0;
+    size_t peak_memory_usage = 0;
+    size_t allocated_nodes = 0;
+    size_t expired_nodes = 0;
+
     // Cache hit/miss metrics
-    std::atomic<uint64_t> cache_hits{0};
-    std::atomic<uint64_t> cache_misses{0};
-    
+    uint64_t cache_hits = 0;
+    uint64_t cache_misses = 0;
+
     // Threading metrics
-    std::atomic<uint64_t> thread_contention_count{0};
-    std::atomic<uint64_t> lock_wait_time{0};
-    
+    uint64_t thread_contention_count = 0;
+    uint64_t lock_wait_time = 0;
+
     // NUMA metrics
-    std::atomic<uint64_t> numa_allocations{0};
-    std::atomic<uint64_t> cross_numa_accesses{0};
+    uint64_t numa_allocations = 0;
+    uint64_t cross_numa_accesses = 0;
+
+    const LatencySummary& latency_of(MetricOp op) const { return latency[static_cast<size_t>(op)]; }
+    double average_latency(MetricOp op) const { return latency_of(op).mean_ns; }
+    double hit_rate() const;
+    double error_rate() const;
 };
 
+// Records cache operations without shared writes on the hot path.
+//
+// Each recording thread gets a cache-line-aligned shard holding a latency
+// histogram per MetricOp and its own hit, miss and error counts. Only that
+// thread writes the shard, with relaxed loads and stores rather than
+// read-modify-writes, so record_insert and record_retrieve cost a
+// thread-local lookup, a bucket index and a handful of stores on a line no
+// other core touches. get_current_metrics merges the shards; the merge is
+// not one instant, but each counter it reads is whole. Rare events (memory,
+// errors named by string, recovery, NUMA) stay shared atomics.
+//
+// A thread's shard outlives the thread and is handed to the next thread
+// that binds, so counts are never lost and the shard count stays at the
+// peak number of recording threads. The collector must outlive every
+// thread still recording into it.
+//
+// Every interval the metrics thread merges once and publishes the result,
+// with the active alert bits, into a MetricsRegion: the history ring that
+// get_historical_data and MetricsReader read without locking. Set
+// CacheConfig::metrics_region_path to map it from a file an external agent
+// can poll. The merge takes shards_mutex_ only long enough to copy the
+// shard list, so it never holds up a thread binding its first record.
 class MetricsCollector {
-private:
-    CacheConfig config_;
-    CacheMetrics metrics_;
-    std::atomic<bool> shutdown_{false};
-    std::thread metrics_thread_;
-    std::mutex file_mutex_;
-    std::ofstream metrics_file_;
-    
-    // Historical data for trend analysis
+public:
     struct MetricsSnapshot {
         std::chrono::steady_clock::time_point timestamp;
         CacheMetrics metrics;
     };
-    
-    std::vector<MetricsSnapshot> historical_data_;
-    std::mutex history_mutex_;
-    static constexpr size_t MAX_HISTORY_SIZE = 1000;
-    
+
+    // Bits of MetricsSample::alerts
+    enum Alert : uint64_t {
+        ALERT_INSERT_LATENCY = 1ull << 0,
+        ALERT_RETRIEVE_LATENCY = 1ull << 1,
+        ALERT_MEMORY = 1ull << 2,
+        ALERT_ERROR_RATE = 1ull << 3,
+    };
+
     // Alert thresholds
     struct AlertThresholds {
-        uint64_t max_latency_ns = 1000000;  // 1ms
+        uint64_t max_latency_ns = 1000000;  // 1ms, against p99
         size_t max_memory_mb = 1024;
         uint64_t max_error_rate = 1000;
         double max_cpu_usage = 80.0;
-    } thresholds_;
+    };
 
-public:
     explicit MetricsCollector(const CacheConfig& config);
     ~MetricsCollector();
-    
-    // Metric recording
-    void record_insert(uint64_t latency_ns, bool success = true);
-    void record_retrieve(uint64_t latency_ns, bool success = true, bool hit = true);
+
+    MetricsCollector(const MetricsCollector&) = delete;
+    MetricsCollector& operator=(const MetricsCollector&) = delete;
+
+    // Metric recording. The per-operation calls are inline: the whole hot
+    // path is a few instructions once the thread is bound.
+    void record_insert(uint64_t latency_ns, bool success = true) {
+        if (!enabled_.load(std::memory_order_relaxed)) return;
+        ThreadShard& shard = local_shard();
+        record_latency(shard.ops[static_cast<size_t>(MetricOp::INSERT)], latency_ns);
+        if (!success) bump(shard.insert_errors);
+    }
+    void record_retrieve(uint64_t latency_ns, bool success = true, bool hit = true) {
+        if (!enabled_.load(std::memory_order_relaxed)) return;
+        ThreadShard& shard = local_shard();
+        record_latency(shard.ops[static_cast<size_t>(MetricOp::RETRIEVE)], latency_ns);
+        bump(hit ? shard.hits : shard.misses);
+        if (!success) bump(shard.retrieve_errors);
+    }
     void record_batch_insert(uint64_t latency_ns, size_t batch_size, bool success = true);
     void record_batch_retrieve(uint64_t latency_ns, size_t batch_size, bool success = true);
     void record_memory_usage(size_t usage_bytes);
@@ -91,35 +196,132 @@ public:
     void record_recovery_attempt();
     void record_thread_contention(uint64_t wait_time_ns);
     void record_numa_allocation(bool cross_numa = false);
-    
+    // Folds in accesses counted elsewhere, e.g. RadialCircularList::cross_numa_accesses
+    void record_cross_numa_access(uint64_t count = 1);
+
     // Metrics retrieval
     CacheMetrics get_current_metrics() const;
+    // Published samples still in the region's ring, oldest first
     std::vector<MetricsSnapshot> get_historical_data() const;
-    
+    const MetricsRegion& metrics_region() const;
+    // All threads' samples for op, merged
+    LatencyHistogram get_latency_histogram(MetricOp op) const;
+    LatencySummary get_latency(MetricOp op) const { return LatencySummary::of(get_latency_histogram(op)); }
+    size_t thread_shards() const;
+
     // Performance calculations
     double get_average_insert_latency() const;
     double get_average_retrieve_latency() const;
     double get_cache_hit_rate() const;
     double get_error_rate() const;
     double get_memory_utilization() const;
-    
+
     // Alerts and monitoring
     bool check_alerts() const;
     std::vector<std::string> get_active_alerts() const;
-    
+
     // Reporting
     void generate_report(const std::string& filename = "") const;
     void export_metrics(const std::string& filename) const;
-    
+
     // Configuration
     void set_alert_thresholds(const AlertThresholds& thresholds);
     void enable_metrics_collection(bool enable = true);
 
 private:
+    static constexpr size_t OPS = static_cast<size_t>(MetricOp::COUNT);
+
+    // One operation's samples in a shard; counts mirror LatencyHistogram,
+    // and the sample count is their sum, taken at merge
+    struct OpShard {
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+        std::atomic<uint64_t> counts[LatencyHistogram::BUCKETS] = {};
+    };
+
+    struct alignas(64) ThreadShard {
+        OpShard ops[OPS];
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> insert_errors{0};
+        std::atomic<uint64_t> retrieve_errors{0};
+        std::atomic<uint64_t> batch_items{0};
+        ThreadShard* next_free = nullptr;  // under shards_mutex_
+    };
+
+    struct Binding {
+        uint64_t owner;
+        ThreadShard* shard;
+    };
+    struct ThreadBindings;
+
+    CacheConfig config_;
+    std::atomic<bool> enabled_;
+    uint64_t id_;  // tells thread-local bindings of different collectors apart
+    std::vector<std::unique_ptr<ThreadShard>> shards_;
+    ThreadShard* free_shards_ = nullptr;
+    mutable std::mutex shards_mutex_;
+
+    // Rare events, shared
+    std::atomic<uint64_t> memory_errors_{0};
+    std::atomic<uint64_t> recovery_attempts_{0};
+    std::atomic<size_t> current_memory_usage_{0};
+    std::atomic<size_t> peak_memory_usage_{0};
+    std::atomic<uint64_t> numa_allocations_{0};
+    std::atomic<uint64_t> cross_numa_accesses_{0};
+
+    std::atomic<bool> shutdown_{false};
+    std::thread metrics_thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    mutable std::mutex file_mutex_;
+    std::ofstream metrics_file_;
+
+    // History, published by the metrics thread alone
+    std::unique_ptr<MetricsRegionWriter> region_;
+    uint64_t active_alerts_ = 0;  // metrics thread only
+
+    AlertThresholds thresholds_;
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+    static Binding& last_binding() {
+        thread_local Binding last{0, nullptr};
+        return last;
+    }
+    ThreadShard& local_shard() {
+        Binding& last = last_binding();
+        return last.owner == id_ ? *last.shard : bind();
+    }
+    static void record_latency(OpShard& op, uint64_t latency_ns) {
+        bump(op.counts[LatencyHistogram::bucket_of(latency_ns)]);
+        bump(op.total_ns, latency_ns);
+        if (latency_ns > op.max_ns.load(std::memory_order_relaxed)) {
+            op.max_ns.store(latency_ns, std::memory_order_relaxed);
+        }
+    }
+
+    // Shards are never freed before the collector, so the copy can be read
+    // after the lock is dropped
+    std::vector<const ThreadShard*> shard_list() const;
+    static LatencyHistogram merge_latency(const std::vector<const ThreadShard*>& shards, MetricOp op);
+
+    static ThreadBindings& thread_bindings();
+    ThreadShard& bind();
+    // Hands a departing thread's shard to the next thread that binds
+    void detach(ThreadShard* shard);
+
+    void start_metrics_thread();
+    void stop_metrics_thread();
+    void open_metrics_file();
     void metrics_worker();
-    void write_metrics_to_file();
-    void update_historical_data();
-    void check_and_trigger_alerts();
+    void write_metrics_to_file(const CacheMetrics& metrics);
+    void publish(const CacheMetrics& metrics, uint64_t alerts);
+    void check_and_trigger_alerts(const CacheMetrics& metrics, uint64_t alerts);
+    uint64_t alert_bits(const CacheMetrics& metrics) const;
+    std::vector<std::string> alerts_for(const CacheMetrics& metrics) const;
+    double memory_utilization(const CacheMetrics& metrics) const;
     std::string format_metrics() const;
     void rotate_metrics_file();
 };
@@ -127,15 +329,41 @@ private:
 // Global metrics instance
 extern MetricsCollector* g_metrics;
 
-// Convenience macros for metrics recording
+// Convenience macros for metrics recording, all compiled out with
+// HFT_INSTRUMENTATION=0. HFT_TIMED_SCOPE(insert) records the enclosing
+// scope; HFT_LATENCY_TIMER(t) and HFT_RECORD_LATENCY(t, retrieve, ...) time
+// paths with several exits, passing any extra arguments through. Both time
+// one call in N when HFT_INSTRUMENTATION is N > 1.
+#define HFT_CONCAT_INNER(a, b) a##b
+#define HFT_CONCAT(a, b) HFT_CONCAT_INNER(a, b)
+#define HFT_LATENCY_TIMER(name) [[maybe_unused]] LatencyTimer name
+
+#if HFT_INSTRUMENTATION
+#define HFT_RECORD_LATENCY(timer, operation, ...) \
+    do { \
+        if ((timer).sampled() && g_metrics) g_metrics->record_##operation((timer).elapsed_ns(), ##__VA_ARGS__); \
+    } while (0)
+
+#define HFT_TIMED_SCOPE(operation) \
+    ScopedLatency HFT_CONCAT(hft_timed_scope_, __LINE__)([](uint64_t ns) { \
+        if (g_metrics) g_metrics->record_##operation(ns); \
+    })
+
 #define RECORD_METRIC(metric, value) \
     if (g_metrics) g_metrics->record_##metric(value)
 
+// Older form, timing from a chrono time point the caller took
 #define RECORD_LATENCY(operation, start_time) \
     do { \
         auto end_time = std::chrono::high_resolution_clock::now(); \
         auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count(); \
         if (g_metrics) g_metrics->record_##operation(latency); \
     } while(0)
+#else
+#define HFT_RECORD_LATENCY(timer, operation, ...) do { } while (0)
+#define HFT_TIMED_SCOPE(operation) do { } while (0)
+#define RECORD_METRIC(metric, value) do { } while (0)
+#define RECORD_LATENCY(operation, start_time) do { (void)(start_time); } while (0)
+#endif
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,108 @@
+#ifndef METRICS_REGION_HPP
+#define METRICS_REGION_HPP
+
+#include "metrics.hpp"
+#include "seqlock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One interval's merged metrics as the collector publishes them
+struct MetricsSample {
+    uint64_t sequence = 0;   // 1 for the first sample of a region, then consecutive
+    uint64_t steady_ns = 0;  // steady_clock, for spacing samples
+    uint64_t unix_ns = 0;    // system_clock, for labelling them
+    uint64_t alerts = 0;     // MetricsCollector::Alert bits active at the time
+    CacheMetrics metrics;
+};
+
+// Fixed binary layout of the published metrics: a header and a ring of the
+// last HISTORY samples, each behind its own seqlock. The metrics thread is
+// the only writer; readers in this or another process copy samples out and
+// retry on a torn read, so a monitoring agent polling the region never
+// takes a lock or writes a line the collector or the cache threads use.
+// Built with the same compiler and flags on both sides; MAGIC, VERSION and
+// sample_bytes catch a mismatch.
+struct MetricsRegion {
+    static constexpr uint64_t MAGIC = 0x3152544D54464848ull;  // "HHFTMTR1"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HISTORY = 1024;
+    static_assert((HISTORY & (HISTORY - 1)) == 0, "HISTORY must be a power of two");
+
+    std::atomic<uint64_t> magic{0};  // stored last, once the rest is in place
+    uint32_t version = VERSION;
+    uint32_t history = HISTORY;
+    uint64_t sample_bytes = sizeof(MetricsSample);
+    uint64_t interval_ms = 0;
+    alignas(64) std::atomic<uint64_t> published{0};
+    alignas(64) SeqLock<MetricsSample> samples[HISTORY];
+
+    SeqLock<MetricsSample>& slot(uint64_t sequence) { return samples[(sequence - 1) & (HISTORY - 1)]; }
+    const SeqLock<MetricsSample>& slot(uint64_t sequence) const { return samples[(sequence - 1) & (HISTORY - 1)]; }
+};
+
+// Owns a MetricsRegion: mapped shared from a file (e.g. under /dev/shm)
+// when given a path, anonymous otherwise. If the file cannot be created
+// the region falls back to anonymous memory and shared() is false.
+class MetricsRegionWriter {
+public:
+    MetricsRegionWriter(const std::string& path, uint64_t interval_ms);
+    ~MetricsRegionWriter();
+
+    MetricsRegionWriter(const MetricsRegionWriter&) = delete;
+    MetricsRegionWriter& operator=(const MetricsRegionWriter&) = delete;
+
+    bool shared() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+    const MetricsRegion& region() const { return *region_; }
+
+    // Single writer only. Fills in sample.sequence.
+    void publish(MetricsSample sample);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    MetricsRegion* region_ = nullptr;
+};
+
+// Read side, usable from any process that can map the region. Reads
+// never block the writer.
+class MetricsReader {
+public:
+    // Maps a region file read-only; valid() is false if it is missing,
+    // short or from an incompatible build
+    explicit MetricsReader(const std::string& path);
+    // Reads a region already in this process
+    explicit MetricsReader(const MetricsRegion& region) : region_(&region) {}
+    ~MetricsReader();
+
+    MetricsReader(const MetricsReader&) = delete;
+    MetricsReader& operator=(const MetricsReader&) = delete;
+
+    bool valid() const { return region_ != nullptr; }
+    uint64_t published() const;
+    uint64_t interval_ms() const { return region_ ? region_->interval_ms : 0; }
+
+    // The newest sample; false before the first is published
+    bool latest(MetricsSample& out) const;
+    // Up to max_samples of the newest samples still in the ring, oldest
+    // first; returns how many were appended to out
+    size_t history(std::vector<MetricsSample>& out, size_t max_samples = MetricsRegion::HISTORY) const;
+
+private:
+    // Copies sample number sequence, or returns false once it has been
+    // overwritten
+    bool read(uint64_t sequence, MetricsSample& out) const;
+
+    const MetricsRegion* region_ = nullptr;
+    void* mapping_ = nullptr;
+    size_t mapped_ = 0;
+};
+
+// Prometheus text exposition of a sample, for an agent to serve on its
+// scrape endpoint
+std::string format_prometheus(const MetricsSample& sample);
+
+#endif
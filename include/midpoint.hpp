@@ -1,25 +1,173 @@
 #ifndef MIDPOINT_HPP
 #define MIDPOINT_HPP
 
-#include "lockfree_heap.hpp"
+#include "cache_observer.hpp"
+#include "concurrent_priority_queue.hpp"
+#include "node_pool.hpp"
+#include "secondary_index.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 
 class MidpointNode {
 private:
-    LockFreeHeap nodes;
+    ConcurrentPriorityQueue nodes;
+    NodePool* pool;  // owner of the nodes pushed here; nullptr for heap-allocated nodes
+    int home;        // NUMA node of the writer that created it, where its heaps were first touched
+    // Lower bound on the deadlines still queued, UINT64_MAX when none are tracked
+    std::atomic<uint64_t> earliest_deadline{UINT64_MAX};
+    // Set at most once and owned from then on; nullptr while unindexed
+    std::atomic<SymbolIndex*> index_{nullptr};
+
+    void unindex(const Node* node) {
+        if (SymbolIndex* index = index_.load(std::memory_order_acquire)) index->erase(node);
+    }
+
+    void discard(Node* node, CacheObserver* observer) {
+        if (observer) observer->on_remove(*node);
+        unindex(node);
+        if (pool) {
+            pool->release(node);
+        } else {
+            delete node;
+        }
+    }
 
 public:
-    MidpointNode(size_t capacity) : nodes(capacity) {}
+    // shards > 1 spreads concurrent writers on this symbol over several heaps
+    MidpointNode(size_t capacity, size_t shards = 1, NodePool* node_pool = nullptr, int home_node = 0)
+        : nodes(capacity, shards), pool(node_pool), home(home_node) {}
+
+    ~MidpointNode() { delete index_.load(std::memory_order_relaxed); }
+
+    MidpointNode(const MidpointNode&) = delete;
+    MidpointNode& operator=(const MidpointNode&) = delete;
+
+    int home_node() const { return home; }
+
+    // Starts keeping the orders in kinds (SymbolIndex::Kind bits) for nodes
+    // queued from now on. Returns false if an index already exists and does
+    // not cover kinds; the first index set is the one kept.
+    bool enable_index(unsigned kinds) {
+        SymbolIndex* current = index_.load(std::memory_order_acquire);
+        if (!current) {
+            SymbolIndex* fresh = new SymbolIndex(kinds, nodes.capacity());
+            if (index_.compare_exchange_strong(current, fresh, std::memory_order_acq_rel)) return true;
+            delete fresh;
+        }
+        return current->covers(kinds);
+    }
+    const SymbolIndex* index() const { return index_.load(std::memory_order_acquire); }
+
+    // Nodes enter the index before they are queued and leave it before their
+    // slot is given back, the same order the observer sees
+    bool add_node(Node* node) {
+        SymbolIndex* index = index_.load(std::memory_order_acquire);
+        if (index) index->insert(node);
+        if (nodes.push(node)) return true;
+        if (index) index->erase(node);
+        return false;
+    }
+    // Queues a prefix of nodes, returning its length; the caller notes deadlines
+    size_t add_bulk(Node* const* batch, size_t count) {
+        SymbolIndex* index = index_.load(std::memory_order_acquire);
+        if (index) {
+            for (size_t i = 0; i < count; ++i) index->insert(batch[i]);
+        }
+        size_t pushed = nodes.push_bulk(batch, count);
+        if (index) {
+            for (size_t i = pushed; i < count; ++i) index->erase(batch[i]);
+        }
+        return pushed;
+    }
+
+    void prefetch() const { nodes.prefetch(); }
+
+    size_t shard_count() const { return nodes.num_shards(); }
+    size_t capacity() const { return nodes.capacity(); }
+
+    // Visits the nodes queued in one heap shard, under that shard's lock
+    template <typename Fn>
+    void visit_shard(size_t shard, Fn&& fn) { nodes.visit_shard(shard, fn); }
 
-    bool add_node(Node* node) { return nodes.push(node); }
+    // Drops one queued node with this value, if there is one
+    bool remove_value(double value, CacheObserver* observer = nullptr) {
+        return nodes.remove_if([value](Node* node) { return node->value == value; },
+                               [this, observer](Node* node) { discard(node, observer); }, 1) != 0;
+    }
+
+    // Drops every queued node, live or not
+    size_t clear(CacheObserver* observer = nullptr) {
+        return nodes.remove_if([](Node*) { return true; }, [this, observer](Node* node) { discard(node, observer); },
+                               SIZE_MAX);
+    }
 
-    Node* get_highest_priority_node() {
-        while (!nodes.empty()) {
-            Node* node = nodes.pop();
-            if (!node->is_expired()) return node;
-            delete node;  // Simple reclamation
+    // Call after add_node. Returns true when deadline_ns is the new earliest
+    // and the expiry engine has to be told.
+    bool note_deadline(uint64_t deadline_ns) {
+        uint64_t current = earliest_deadline.load(std::memory_order_relaxed);
+        while (deadline_ns < current) {
+            if (earliest_deadline.compare_exchange_weak(current, deadline_ns, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // observer, when set, hears about the expired nodes dropped on the way;
+    // reporting the returned node is left to the caller
+    Node* get_highest_priority_node(CacheObserver* observer = nullptr) {
+        uint64_t now = CoarseClock::now();
+        while (Node* node = nodes.pop()) {
+            if (!node->is_expired(now)) {
+                unindex(node);
+                return node;
+            }
+            discard(node, observer);
         }
         return nullptr;
     }
+
+    // Batch form: writes up to count live nodes to out, best first, and
+    // returns how many. Expired nodes met on the way are dropped as above.
+    size_t get_highest_priority_nodes(Node** out, size_t count, uint64_t now, CacheObserver* observer = nullptr) {
+        size_t live = 0;
+        while (live < count) {
+            size_t popped = nodes.pop_bulk(out + live, count - live);
+            if (popped == 0) break;
+            for (size_t i = live, end = live + popped; i < end; ++i) {
+                Node* node = out[i];
+                if (node->is_expired(now)) {
+                    discard(node, observer);
+                    continue;
+                }
+                unindex(node);
+                out[live++] = node;
+            }
+        }
+        return live;
+    }
+
+    // Removes up to limit expired nodes and returns them to the pool. Sets
+    // next_deadline when this call took over the task of rescheduling,
+    // which is the earliest surviving deadline, or now if limit cut the
+    // sweep short.
+    size_t purge_expired(uint64_t now, size_t limit, uint64_t& next_deadline, CacheObserver* observer = nullptr) {
+        // Reset first: a push that lands after this is either seen by the
+        // sweep or lowers the bound again and schedules itself
+        earliest_deadline.store(UINT64_MAX, std::memory_order_seq_cst);
+        uint64_t earliest = UINT64_MAX;
+        size_t removed = nodes.remove_if(
+            [now, &earliest](Node* node) {
+                if (node->is_expired(now)) return true;
+                earliest = std::min(earliest, node->deadline_ns);
+                return false;
+            },
+            [this, observer](Node* node) { discard(node, observer); }, limit);
+        if (removed >= limit) earliest = now;
+        if (earliest != UINT64_MAX && note_deadline(earliest)) next_deadline = earliest;
+        return removed;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,13 +1,23 @@
 #pragma once
 
 #include "radial_circular_list.hpp"
-#include "lockfree_queue.hpp"
+#include "frequency_sketch.hpp"
+#include "hot_tier.hpp"
+#include "node_pool.hpp"
+#include "segment_store.hpp"
 #include "persistent_cache.hpp"
+#include "column_codec.hpp"
+#include "bloom_filter.hpp"
 #include "config.hpp"
 #include <memory>
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <set>
 
 namespace hft_cache {
 
@@ -17,32 +27,60 @@ class DiskBackedCache;
 /**
  * @brief Multi-level cache architecture for optimal performance
  * 
- * L1: Hot data in lock-free queue (fastest access)
+ * L1: Hot data in a symbol-indexed HotTier (fastest access)
  * L2: Warm data in radial circular list
- * L3: Cold data on disk (persistent)
+ * L3: Cold data in an mmap'd append-only segment log (persistent)
+ *
+ * get_highest_priority pops, as RadialCircularList does, from the first
+ * level holding the symbol. An L1 or L2 hit is retired to its level's pool
+ * and stays readable for as long as the caller holds an EpochGuard. An L3
+ * hit is removed from the log and decoded into a thread-local node that the
+ * next L3 lookup on the same thread overwrites.
+ *
+ * L1 nodes come from a NodePool of twice l1_capacity, the slack covering
+ * slots still in limbo, so inserts and promotions never touch the heap.
  */
 class MultiLevelCache {
 public:
     explicit MultiLevelCache(const CacheConfig& config);
     ~MultiLevelCache();
 
-    // Core operations
+    // Core operations; the string overloads resolve through SymbolRegistry::global()
+    bool insert(double value, SymbolId symbol, int priority, double expiry_seconds = 60.0);
     bool insert(double value, const std::string& symbol, int priority, double expiry_seconds = 60.0);
+    Node* get_highest_priority(SymbolId symbol);
     Node* get_highest_priority(const std::string& symbol);
+    bool remove(SymbolId symbol, double value);
     bool remove(const std::string& symbol, double value);
     void clear();
 
-    // Level-specific operations
-    bool promote_to_l1(Node* node);
+    // Level-specific operations; each copies node, which the caller keeps
+    bool promote_to_l1(const Node& node);
     bool demote_to_l2(Node* node);
     bool demote_to_l3(Node* node);
     
-    // Statistics and monitoring
+    // Statistics and monitoring. A lookup counts as a miss at every level
+    // it fell through, so each level's hit ratio is over the lookups that
+    // reached it.
     struct LevelStats {
         std::atomic<size_t> item_count{0};
         std::atomic<size_t> hit_count{0};
         std::atomic<size_t> miss_count{0};
-        std::atomic<uint64_t> total_access_time_ns{0};
+        std::atomic<uint64_t> total_access_time_ns{0};  // over sampled accesses, see HFT_INSTRUMENTATION
+
+        LevelStats() = default;
+        // Snapshot; the fields are read one at a time
+        LevelStats(const LevelStats& other)
+            : item_count(other.item_count.load(std::memory_order_relaxed)),
+              hit_count(other.hit_count.load(std::memory_order_relaxed)),
+              miss_count(other.miss_count.load(std::memory_order_relaxed)),
+              total_access_time_ns(other.total_access_time_ns.load(std::memory_order_relaxed)) {}
+
+        double hit_ratio() const {
+            size_t hits = hit_count.load(std::memory_order_relaxed);
+            size_t lookups = hits + miss_count.load(std::memory_order_relaxed);
+            return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0.0;
+        }
     };
 
     LevelStats get_l1_stats() const;
@@ -62,10 +100,14 @@ private:
     CacheConfig config_;
     
     // Cache levels
-    LockFreeQueue<Node*> l1_cache_;           // Hot data (fastest)
+    NodePool l1_pool_;                             // L1 node slots; outlives l1_cache_
+    HotTier l1_cache_;                             // Hot data (fastest)
     std::unique_ptr<RadialCircularList> l2_cache_; // Warm data
     std::unique_ptr<DiskBackedCache> l3_cache_;    // Cold data (persistent)
     
+    // Per-symbol access frequency (TinyLFU) behind admission and demotion
+    FrequencySketch frequency_;
+    
     // Statistics
     mutable LevelStats l1_stats_;
     mutable LevelStats l2_stats_;
@@ -80,6 +122,11 @@ private:
     void eviction_policy_l1();
     void eviction_policy_l2();
     void eviction_policy_l3();
+    // Moves a node unlinked from L1 down a level, or retires it
+    void demote_from_l1(Node* node);
+    // After an L2 hit on a hot symbol, pulls its next L2 entry up so the
+    // following read is an L1 hit
+    void promote_next_to_l1(SymbolId symbol);
     
     // Background worker
     void background_management_worker();
@@ -89,38 +136,188 @@ private:
     bool should_demote_to_l2(const Node* node) const;
     bool should_demote_to_l3(const Node* node) const;
     
-    // Access tracking
-    void record_access(Node* node, uint64_t access_time_ns);
+    // Access tracking: every insert and lookup feeds the frequency sketch;
+    // hits also add their latency to the level that served them
+    void record_access(SymbolId symbol, LevelStats* level, uint64_t access_time_ns);
+    // Background pass moving cooled-down L1 entries to L2
     void update_access_patterns();
+    const FrequencySketch* admission_sketch() const;
 };
 
 /**
  * @brief Disk-backed cache for L3 storage
+ *
+ * Entries live only in a SegmentStore of memory-mapped segment files; RAM
+ * holds just an index from (symbol, value) to a 64-bit record location, so
+ * L3 can be far larger than memory and a hit reads straight from the page
+ * cache. Writes and removals append (a removal writes a tombstone) and
+ * flush_to_disk msyncs only what was appended since the last flush.
+ * compact() rewrites sealed segments that have gone mostly dead and is run
+ * from the MultiLevelCache background pass. Reopening the directory
+ * replays the segments to rebuild the index.
+ *
+ * With l3_compression set, compaction rewrites the live entries of a
+ * segment as per-symbol ColumnCodec blocks of up to L3_BLOCK_ROWS entries
+ * sorted by timestamp, and the index points at (block, row). A hit then
+ * decodes the whole block, which is cheap next to a page fault and pays
+ * for itself in page-cache footprint on cold data. codec_stats() reports
+ * the ratio and throughput.
+ *
+ * A blocked Bloom filter over (symbol, value) keys, and over symbols for
+ * retrieve_any, answers most misses before index_mutex_ is taken. Removal
+ * leaves its bits set, so the filter only ever errs towards a lookup.
+ * Compaction and reloading build a fresh filter from the index and swap it
+ * in, retiring the old one through the EpochManager, so bits of removed
+ * entries do not pile up under churn.
+ *
+ * insert copies the node, so the caller keeps ownership. retrieve decodes
+ * into a per-thread Node that stays valid until that thread's next
+ * retrieve; use the Node& overload to keep a copy.
  */
 class DiskBackedCache {
 public:
     explicit DiskBackedCache(const CacheConfig& config);
     ~DiskBackedCache();
 
-    bool insert(Node* node);
+    bool insert(const Node* node);
+    Node* retrieve(SymbolId symbol, double value);
     Node* retrieve(const std::string& symbol, double value);
+    bool retrieve(SymbolId symbol, double value, Node& out);
+    // Highest-priority unexpired entry for symbol, ties to the larger value
+    Node* retrieve_any(SymbolId symbol);
+    bool remove(SymbolId symbol, double value);
     bool remove(const std::string& symbol, double value);
     void clear();
+    // Hints the kernel to page in the entry ahead of a retrieve
+    void prefetch(SymbolId symbol, double value);
 
     // Disk operations
     bool flush_to_disk();
     bool load_from_disk();
+    // Rewrites up to max_segments sealed segments below the live threshold
+    size_t compact(size_t max_segments = 1);
     size_t get_disk_size() const;
+    size_t size() const;
+
+    struct CodecStats {
+        size_t blocks = 0;
+        size_t rows = 0;
+        size_t raw_bytes = 0;      // what the rows took as single records
+        size_t encoded_bytes = 0;
+        uint64_t encode_ns = 0;
+        uint64_t decode_ns = 0;    // spent decoding blocks, by lookups, loads and compaction
+        size_t decoded_rows = 0;
+
+        double compression_ratio() const { return encoded_bytes ? static_cast<double>(raw_bytes) / encoded_bytes : 0.0; }
+        double encode_rows_per_us() const { return encode_ns ? rows * 1e3 / encode_ns : 0.0; }
+        double decode_rows_per_us() const { return decode_ns ? decoded_rows * 1e3 / decode_ns : 0.0; }
+    };
+    CodecStats codec_stats() const;
 
 private:
     CacheConfig config_;
     std::string disk_path_;
-    std::unordered_map<std::string, Node*> memory_index_;
-    std::atomic<size_t> disk_size_{0};
-    
+    // Keyed by (symbol id, value) so lookups never format a string key
+    struct DiskKey {
+        SymbolId symbol;
+        double value;
+        bool operator==(const DiskKey& other) const { return symbol == other.symbol && value == other.value; }
+    };
+    struct DiskKeyHash {
+        size_t operator()(const DiskKey& key) const {
+            uint64_t bits;
+            std::memcpy(&bits, &key.value, sizeof(bits));
+            return std::hash<uint64_t>()(bits ^ (static_cast<uint64_t>(key.symbol) * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+    static uint64_t filter_hash(SymbolId symbol, double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return BloomFilter::hash_key(bits ^ (static_cast<uint64_t>(symbol) * 0x9e3779b97f4a7c15ULL));
+    }
+    static uint64_t filter_hash(SymbolId symbol) {
+        return BloomFilter::hash_key(static_cast<uint64_t>(symbol) ^ 0xc2b2ae3d27d4eb4fULL);
+    }
+
+    // Where an entry lives: a single record, or one row of a block. The
+    // priority is carried along so the entry can be found in ranked_; it
+    // takes no part in comparing locations.
+    struct DiskEntry {
+        SegmentStore::Location location;
+        uint32_t row;
+        int32_t priority = 0;
+        bool operator==(const DiskEntry& other) const { return location == other.location && row == other.row; }
+        bool operator!=(const DiskEntry& other) const { return !(*this == other); }
+    };
+    static constexpr uint32_t SINGLE_RECORD = UINT32_MAX;
+
+    // On-disk payload ahead of the ticker bytes
+    struct NodeRecord {
+        double value;
+        uint64_t timestamp_ns;
+        uint64_t deadline_ns;
+        int32_t priority;
+        uint16_t symbol_length;
+        uint16_t reserved;
+    };
+    // Block payload: this, the ticker padded to 8 bytes, then one codec
+    // block with lifetimes (deadline - timestamp) in its second column
+    struct BlockRecord {
+        uint32_t rows;
+        uint16_t symbol_length;
+        uint16_t reserved;
+    };
+    static constexpr uint16_t RECORD_PUT = 1;
+    static constexpr uint16_t RECORD_TOMBSTONE = 2;
+    static constexpr uint16_t RECORD_BLOCK = 3;
+    static constexpr size_t L3_BLOCK_ROWS = 256;
+
+    SegmentStore store_;
+    std::unordered_map<DiskKey, DiskEntry, DiskKeyHash> index_;
+    // Every indexed entry of a symbol, highest priority first
+    struct RankedEntry {
+        int32_t priority;
+        double value;
+        uint64_t deadline_ns;
+        bool operator<(const RankedEntry& other) const {
+            return priority != other.priority ? priority > other.priority : value > other.value;
+        }
+    };
+    std::unordered_map<SymbolId, std::set<RankedEntry>> ranked_;
+    mutable std::shared_mutex index_mutex_;  // shared for reads, exclusive for appends
+    std::atomic<BloomFilter*> filter_;       // added to and swapped under index_mutex_, probed without it
+    std::mutex compaction_mutex_;
+
+    std::atomic<size_t> codec_blocks_{0};
+    std::atomic<size_t> codec_rows_{0};
+    std::atomic<size_t> codec_raw_bytes_{0};
+    std::atomic<size_t> codec_encoded_bytes_{0};
+    std::atomic<uint64_t> codec_encode_ns_{0};
+    std::atomic<uint64_t> codec_decode_ns_{0};
+    std::atomic<size_t> codec_decoded_rows_{0};
+
     // Serialization helpers
-    bool serialize_node(const Node* node, std::ofstream& file);
-    Node* deserialize_node(std::ifstream& file);
+    SegmentStore::Location append_record(uint16_t kind, const Node& node);
+    static bool decode_record(const uint8_t* payload, uint32_t length, Node& out);
+    // Decodes a block's rows into columns and its ticker into symbol
+    bool decode_block(const uint8_t* payload, uint32_t length, ColumnCodec::Columns& columns, SymbolId& symbol);
+    bool read_entry(const DiskEntry& entry, Node& out);
+    void release_entry(const DiskEntry& entry);
+    bool might_hold(uint64_t hash) const {
+        EpochGuard guard;
+        return filter_.load(std::memory_order_acquire)->might_contain(hash);
+    }
+    // Replaces the filter with one built from the index; called with
+    // compaction_mutex_ and index_mutex_ held, the latter shared or
+    // exclusive, so appends cannot add to the filter being replaced
+    void rebuild_filter();
+    // Points key at entry, releasing and unranking whatever it replaces
+    void replace_location(const DiskKey& key, const DiskEntry& entry, uint64_t deadline_ns);
+    // Drops key from the index and ranked_, releasing its location
+    void erase_entry(std::unordered_map<DiskKey, DiskEntry, DiskKeyHash>::iterator it);
+    // Re-encodes the live entries of segment id as blocks; false if an
+    // append failed and the segment must be kept
+    bool compact_into_blocks(uint32_t id, bool keep_tombstones);
 };
 
 } // namespace hft_cache 
\ No newline at end of file
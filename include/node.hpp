@@ -1,26 +1,46 @@
 #ifndef NODE_HPP
 #define NODE_HPP
 
-#include <chrono>
+#include "clock.hpp"
+#include "symbol_registry.hpp"
+#include <cstdint>
 
-class Node {
+// Cache entry. Times are CoarseClock nanoseconds, and expiry is stored as
+// an absolute deadline so the check is one compare against a clock reading
+// the caller can share across a whole scan. The record is exactly 32 bytes,
+// two to a cache line; building with HFT_CACHE_ALIGNED_NODES pads each node
+// to its own line instead, for deployments where neighbouring hot nodes are
+// written from different cores.
+#ifdef HFT_CACHE_ALIGNED_NODES
+#define HFT_NODE_ALIGNMENT 64
+#else
+#define HFT_NODE_ALIGNMENT 8
+#endif
+
+class alignas(HFT_NODE_ALIGNMENT) Node {
 public:
     double value;
-    int priority;
     uint64_t timestamp_ns;
-    uint64_t expiry_time_ns;
+    uint64_t deadline_ns;
+    int32_t priority;
+    SymbolId symbol;
 
     Node(double val = 0.0, int prio = 0, double expiry = 60.0)
-        : value(val), priority(prio),
-          timestamp_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(
-              std::chrono::high_resolution_clock::now().time_since_epoch()).count()),
-          expiry_time_ns(static_cast<uint64_t>(expiry * 1'000'000'000)) {}
-
-    bool is_expired() const {
-        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-        return (now_ns - timestamp_ns) > expiry_time_ns;
+        : value(val), timestamp_ns(CoarseClock::now()),
+          deadline_ns(timestamp_ns + static_cast<uint64_t>(expiry * 1'000'000'000)),
+          priority(prio), symbol(INVALID_SYMBOL_ID) {}
+
+    // Restamps the node as created now with the given time-to-live
+    void stamp(double expiry_seconds) {
+        timestamp_ns = CoarseClock::now();
+        deadline_ns = timestamp_ns + static_cast<uint64_t>(expiry_seconds * 1'000'000'000);
     }
+
+    bool is_expired(uint64_t now_ns) const { return now_ns > deadline_ns; }
+    bool is_expired() const { return is_expired(CoarseClock::now()); }
 };
 
-#endif
\ No newline at end of file
+static_assert(sizeof(Node) == 32 || sizeof(Node) == HFT_NODE_ALIGNMENT,
+              "Node must stay packed to 32 bytes or one full cache line");
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include "epoch_reclamation.hpp"
+#include "magazine_cache.hpp"
+#include "node.hpp"
+#include "numa_memory.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed slab of Nodes with lock-free free lists.
+//
+// All slots live in one NumaSlab mapped at construction; allocate and
+// release never touch the heap afterwards. Free slots form a Treiber stack
+// of 32-bit indices. The head packs a 32-bit tag next to the index, and
+// every successful CAS bumps the tag, so a slot that is popped and pushed
+// back between another thread's load and CAS cannot be mistaken for an
+// unchanged head (ABA).
+//
+// With numa_partitions > 1 the slab is split into that many contiguous
+// partitions, one per NUMA node, each bound to its node and with its own
+// free list and limbo. allocate serves a thread from its own node's
+// partition and only takes from another once that one is exhausted, which
+// remote_allocations() counts. A slot always goes back to the partition it
+// came from.
+//
+// A node that readers may still hold goes through retire() instead of
+// release(): it is parked on a limbo stack stamped with the current epoch
+// and only returns to the free list once the EpochManager says no guard
+// can still see it. Limbo is drained in bulk when the free list runs dry.
+//
+// With magazine_rounds set, allocate and release go through a MagazineCache
+// in front of each free list, so a thread only touches the shared head once
+// per magazine. Up to 2 * magazine_rounds free slots then sit with each
+// thread that has used the pool, out of other threads' reach until that
+// thread exits or calls flush(), so allocate can fail a little before every
+// slot is in use. Retired slots and allocate_bulk still use the free list.
+class NodePool {
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct alignas(64) Partition {
+        std::atomic<uint64_t> head{0};
+        alignas(64) std::atomic<uint32_t> limbo{NIL};
+        uint32_t first = 0;  // slots [first, end)
+        uint32_t end = 0;
+        int node = 0;
+        std::unique_ptr<MagazineCache> magazines;
+    };
+
+    NumaSlab memory_;
+    Node* slab_;
+    size_t capacity_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;  // free-list or limbo link
+    std::unique_ptr<uint64_t[]> retire_epoch_;       // valid while a slot is in limbo
+    std::unique_ptr<Partition[]> partitions_;
+    size_t partition_count_;
+    size_t partition_slots_;            // slots per partition; the last may have fewer
+    std::unique_ptr<uint8_t[]> local_;  // partition by node id, for node ids up to max_node
+    size_t local_count_ = 0;
+    std::atomic<uint64_t> remote_allocations_{0};
+
+    static uint64_t pack(uint64_t tag, uint32_t index) { return (tag << 32) | index; }
+
+    Partition& partition_of(uint32_t index) { return partitions_[index / partition_slots_]; }
+
+    Partition& local_partition() {
+        if (partition_count_ == 1) return partitions_[0];
+        size_t node = static_cast<size_t>(NumaTopology::current_node());
+        return partitions_[node < local_count_ ? local_[node] : 0];
+    }
+
+    Node* pop_free(Partition& partition) {
+        uint64_t head = partition.head.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t index = static_cast<uint32_t>(head);
+            if (index == NIL) return nullptr;
+            uint32_t next = next_[index].load(std::memory_order_relaxed);
+            if (partition.head.compare_exchange_weak(head, pack((head >> 32) + 1, next),
+                                                     std::memory_order_acquire, std::memory_order_acquire)) {
+                return &slab_[index];
+            }
+        }
+    }
+
+    // Pushes the chain first..last (already linked through next_, all in
+    // one partition) onto that partition's free list.
+    void push_free(uint32_t first, uint32_t last) {
+        std::atomic<uint64_t>& head_ref = partition_of(first).head;
+        uint64_t head = head_ref.load(std::memory_order_relaxed);
+        do {
+            next_[last].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        } while (!head_ref.compare_exchange_weak(head, pack((head >> 32) + 1, first),
+                                                 std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Limbo is push-only apart from reclaim()'s exchange, so it needs no tag.
+    void push_limbo(uint32_t first, uint32_t last) {
+        std::atomic<uint32_t>& limbo = partition_of(first).limbo;
+        uint32_t head = limbo.load(std::memory_order_relaxed);
+        do {
+            next_[last].store(head, std::memory_order_relaxed);
+        } while (!limbo.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    size_t allocate_bulk_from(Partition& partition, Node** out, size_t count);
+    size_t reclaim(Partition& partition);
+    // Another partition's slot, once the caller's own is exhausted
+    Node* allocate_remote(Partition& local);
+
+    // MagazineCache backing: whole chains off a partition's free list and back onto it
+    size_t refill_magazine(Partition& partition, void** out, size_t count);
+    void spill_magazine(void* const* nodes, size_t count);
+
+public:
+    explicit NodePool(size_t capacity, size_t magazine_rounds = 0, size_t numa_partitions = 1);
+    ~NodePool();
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    // Returns a free slot, or nullptr once every slot is in use or still in limbo.
+    Node* allocate() {
+        Partition& local = local_partition();
+        Node* node;
+        if (local.magazines) {
+            node = static_cast<Node*>(local.magazines->allocate());
+        } else {
+            node = pop_free(local);
+            if (!node && reclaim(local)) node = pop_free(local);
+        }
+        if (!node && partition_count_ > 1) node = allocate_remote(local);
+        return node;
+    }
+
+    // Takes up to count free slots with one CAS per partition, for bulk
+    // loads that would otherwise hammer the head once per node. The walk
+    // down the chain only reads links; if another thread moved the head
+    // meanwhile, the tag makes the CAS fail and the walk is redone.
+    size_t allocate_bulk(Node** out, size_t count) {
+        Partition& local = local_partition();
+        size_t taken = allocate_bulk_from(local, out, count);
+        for (size_t i = 0; taken < count && i < partition_count_; ++i) {
+            if (&partitions_[i] == &local) continue;
+            size_t remote = allocate_bulk_from(partitions_[i], out + taken, count - taken);
+            if (remote) remote_allocations_.fetch_add(remote, std::memory_order_relaxed);
+            taken += remote;
+        }
+        return taken;
+    }
+
+    // Returns a slot no other thread can reference straight to the free list.
+    void release(Node* node) {
+        uint32_t index = static_cast<uint32_t>(node - slab_);
+        Partition& partition = partition_of(index);
+        if (partition.magazines) {
+            partition.magazines->release(node);
+            return;
+        }
+        push_free(index, index);
+    }
+
+    // Returns a slot that readers may still hold; it is reused only after
+    // every EpochGuard open at this point has closed.
+    void retire(Node* node) {
+        uint32_t index = static_cast<uint32_t>(node - slab_);
+        retire_epoch_[index] = EpochManager::global().current_epoch();
+        push_limbo(index, index);
+    }
+
+    // retire for a batch: one epoch read, and one CAS per run of slots
+    // from the same partition
+    void retire_bulk(Node* const* nodes, size_t count) {
+        if (count == 0) return;
+        uint64_t epoch = EpochManager::global().current_epoch();
+        uint32_t first = static_cast<uint32_t>(nodes[0] - slab_);
+        uint32_t last = first;
+        retire_epoch_[first] = epoch;
+        for (size_t i = 1; i < count; ++i) {
+            uint32_t index = static_cast<uint32_t>(nodes[i] - slab_);
+            retire_epoch_[index] = epoch;
+            if (&partition_of(index) != &partition_of(first)) {
+                push_limbo(first, last);
+                first = index;
+            } else {
+                next_[last].store(index, std::memory_order_relaxed);
+            }
+            last = index;
+        }
+        push_limbo(first, last);
+    }
+
+    // Moves every limbo slot that is now safe back to the free lists.
+    size_t reclaim();
+
+    // Hands the calling thread's cached slots back for any thread to take
+    void flush() {
+        for (size_t i = 0; i < partition_count_; ++i) {
+            if (partitions_[i].magazines) partitions_[i].magazines->flush();
+        }
+    }
+    const MagazineCache* magazines(size_t partition = 0) const { return partitions_[partition].magazines.get(); }
+
+    bool owns(const Node* node) const { return node >= slab_ && node < slab_ + capacity_; }
+    size_t capacity() const { return capacity_; }
+
+    size_t partition_count() const { return partition_count_; }
+    // NUMA node of the partition a slot belongs to
+    int node_of(const Node* node) const {
+        return partitions_[static_cast<size_t>(node - slab_) / partition_slots_].node;
+    }
+    uint64_t remote_allocations() const { return remote_allocations_.load(std::memory_order_relaxed); }
+    bool huge_pages() const { return memory_.huge_pages(); }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef NUMA_MEMORY_HPP
+#define NUMA_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// NUMA nodes as libnuma numbers them. Without libnuma, or on a machine it
+// reports as having one node, there is a single node 0.
+class NumaTopology {
+public:
+    // Nodes with memory, in increasing id order; never empty
+    static const std::vector<int>& nodes();
+    static size_t node_count() { return nodes().size(); }
+    static int max_node();
+
+    // Node the calling thread runs on. Cached per thread and re-read every
+    // RECHECK_CALLS calls, which follows a thread the scheduler moves
+    // without paying for getcpu on every call.
+    static int current_node() {
+        thread_local int node = -1;
+        thread_local uint32_t calls = 0;
+        if (node < 0 || ++calls == RECHECK_CALLS) {
+            node = lookup_current_node();
+            calls = 0;
+        }
+        return node;
+    }
+
+private:
+    static constexpr uint32_t RECHECK_CALLS = 4096;
+    static int lookup_current_node();
+};
+
+// Anonymous memory for node slabs.
+//
+// Slabs of at least HUGE_PAGE_BYTES are mapped 2 MB aligned and rounded to
+// whole huge pages: explicit hugetlb pages when the system has some
+// reserved, transparent huge pages (MADV_HUGEPAGE) otherwise. Nothing is
+// touched here, so pages land where bind() says or, for unbound ranges,
+// on the node of the thread that first writes them. Smaller slabs use
+// normal pages.
+class NumaSlab {
+public:
+    static constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+    NumaSlab() = default;
+    explicit NumaSlab(size_t bytes);
+    ~NumaSlab();
+
+    NumaSlab(NumaSlab&& other) noexcept;
+    NumaSlab& operator=(NumaSlab&& other) noexcept;
+    NumaSlab(const NumaSlab&) = delete;
+    NumaSlab& operator=(const NumaSlab&) = delete;
+
+    // Places [offset, offset + bytes) on node, for pages not touched yet.
+    // Only whole pages inside the range are bound; a page it shares with a
+    // neighbour goes wherever it is first touched. False without libnuma.
+    bool bind(size_t offset, size_t bytes, int node);
+
+    void* data() const { return data_; }
+    size_t size() const { return bytes_; }
+    bool huge_pages() const { return huge_; }
+
+private:
+    void* data_ = nullptr;
+    size_t bytes_ = 0;    // as asked for
+    size_t mapped_ = 0;   // what munmap gets
+    void* mapping_ = nullptr;
+    bool huge_ = false;
+
+    void release();
+};
+
+#endif
@@ -2,15 +2,19 @@
 #define PERSISTENT_CACHE_HPP
 
 #include "radial_circular_list.hpp"
+#include "write_ahead_log.hpp"
 #include "config.hpp"
 #include <fstream>
 #include <filesystem>
 #include <chrono>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <queue>
 
+// Timestamps are wall-clock nanoseconds since the Unix epoch
 struct CheckpointMetadata {
     uint64_t timestamp;
     size_t node_count;
@@ -20,281 +24,202 @@ struct CheckpointMetadata {
     uint64_t base_checkpoint_timestamp;  // For incremental checkpoints
 };
 
-class PersistentCache {
+// What the last checkpoint cost. max_shard_hold_ns is the longest the
+// snapshot kept any one heap shard locked, which bounds how long an insert
+// or pop on that shard could have waited for it.
+struct CheckpointStats {
+    size_t node_count = 0;
+    size_t symbol_count = 0;
+    size_t bytes_written = 0;
+    uint64_t snapshot_ns = 0;      // copying out of the cache
+    uint64_t duration_ns = 0;      // request to durable file
+    uint64_t max_shard_hold_ns = 0;
+    size_t raw_bytes = 0;          // what the sections take as fixed-size records
+    uint64_t encode_ns = 0;        // in the codec, sorting included
+    bool compressed = false;
+    bool direct_io = false;
+    bool success = false;
+
+    double compression_ratio() const { return bytes_written ? static_cast<double>(raw_bytes) / bytes_written : 0.0; }
+    double encode_mb_per_s() const { return encode_ns ? raw_bytes * 1e3 / encode_ns : 0.0; }
+};
+
+// What the last restore cost; threads is how many workers rebuilt the heaps
+struct RestoreStats {
+    size_t node_count = 0;
+    size_t symbol_count = 0;
+    size_t threads = 0;
+    size_t bytes_read = 0;
+    size_t raw_bytes = 0;      // the same sections as fixed-size records
+    uint64_t decode_ns = 0;    // in the codec, summed over workers
+    uint64_t duration_ns = 0;  // open to last node queued
+    bool compressed = false;
+    bool success = false;
+
+    double decode_mb_per_s() const { return decode_ns ? raw_bytes * 1e3 / decode_ns : 0.0; }
+};
+
+class CheckpointFile;
+
+// Checkpoints a live RadialCircularList without pausing it.
+//
+// A checkpoint is an epoch-versioned snapshot: the background thread takes
+// a cut time, then walks the symbols copying one heap shard at a time into
+// a private buffer, skipping nodes stamped after the cut. Only that shard
+// is locked during its copy and pushes skip locked shards, so inserts keep
+// flowing. It is fuzzy across shards (a node popped mid-walk may or may not
+// be in it) but never holds anything newer than the cut, which is what a
+// log replay from the cut needs. The copy is then written out in large
+// aligned blocks, with O_DIRECT where the filesystem takes it, and synced
+// before the checkpoint counts as done.
+//
+// Each symbol gets its own section, located through an offset table at the
+// end of the file and carrying its own checksum. A restore maps the file,
+// verifies the sections in parallel, then has restore_threads workers pull
+// chunks of records straight out of the mapping into pool slots, queueing
+// each chunk with one lock per heap shard. Nothing is parsed into an
+// intermediate buffer, and a file that fails verification leaves the cache
+// untouched.
+//
+// With compression on (checkpoint_compression, or enable_compression) each
+// section is stored as ColumnCodec blocks instead. Workers decode a block
+// at a time into thread-local columns and bulk load from those.
+//
+// checkpoint_to_disk and incremental_checkpoint only hand the request to
+// the background thread; wait_for_checkpoint blocks until it has finished.
+//
+// With enable_wal set, every insert and removal is also logged to a
+// WriteAheadLog under <checkpoint dir>/wal. The cache attaches itself as
+// one of the list's observers for this, alongside any others, and a
+// restore detaches only itself while it runs. Expired nodes dropped by a sweep are not logged, since replay
+// expires them again. Checkpoint and log share one clock, so recovery
+// loads the newest full checkpoint at or before the target and replays
+// the log from its cut. An incremental checkpoint then just seals the
+// current log segment. A full checkpoint drops segments older than the
+// oldest full checkpoint still on disk.
+class PersistentCache : public CacheObserver {
 private:
     RadialCircularList& cache_;
     CacheConfig config_;
     std::string checkpoint_dir_;
+    std::atomic<bool> compression_;
     std::atomic<bool> checkpoint_in_progress_{false};
     std::thread checkpoint_thread_;
     std::atomic<bool> shutdown_{false};
-    
+
+    // Background requests; checkpoint_in_progress_ admits one at a time
+    struct CheckpointRequest {
+        std::string filename;
+        bool incremental = false;
+    };
+    CheckpointRequest pending_request_;
+    bool request_pending_ = false;
+    std::mutex request_mutex_;
+    std::condition_variable request_cv_;
+    std::condition_variable done_cv_;
+    std::atomic<uint64_t> auto_interval_ns_{0};
+
     // Checkpoint management
     std::queue<CheckpointMetadata> checkpoint_history_;
-    std::mutex checkpoint_mutex_;
+    mutable std::mutex checkpoint_mutex_;
+    CheckpointStats last_stats_;
+    RestoreStats last_restore_;
     static constexpr size_t MAX_CHECKPOINT_HISTORY = 10;
-    
-    // Incremental checkpointing
+
+    // Incremental checkpointing: CoarseClock cut of the last full checkpoint
     std::atomic<uint64_t> last_checkpoint_timestamp_{0};
-    std::vector<std::pair<uint64_t, std::string>> modified_nodes_;
-    std::mutex modification_mutex_;
+    std::atomic<uint64_t> last_checkpoint_wall_ns_{0};
+
+    // Write-ahead log; CoarseClock + wall_offset_ is the wall clock both it
+    // and checkpoint cuts are stamped with. The background thread re-anchors
+    // the offset about once a second and before each checkpoint, so stamps
+    // step by at most the drift since the last anchor.
+    std::unique_ptr<WriteAheadLog> wal_;
+    std::atomic<uint64_t> wall_offset_;
 
 public:
-    PersistentCache(RadialCircularList& cache, const CacheConfig& config, 
-                   const std::string& checkpoint_dir = "./checkpoints")
-        : cache_(cache), config_(config), checkpoint_dir_(checkpoint_dir) {
-        
-        std::filesystem::create_directories(checkpoint_dir_);
-        start_checkpoint_thread();
-    }
-    
-    ~PersistentCache() {
-        shutdown_.store(true);
-        if (checkpoint_thread_.joinable()) {
-            checkpoint_thread_.join();
-        }
-    }
-    
-    // Full checkpoint operations
-    bool checkpoint_to_disk(const std::string& filename = "") {
-        if (checkpoint_in_progress_.load()) {
-            return false;  // Already in progress
-        }
-        
-        std::string checkpoint_file = filename.empty() ? 
-            generate_checkpoint_filename() : filename;
-        
-        return perform_checkpoint(checkpoint_file, false);
-    }
-    
-    bool restore_from_disk(const std::string& filename) {
-        if (!std::filesystem::exists(filename)) {
-            return false;
-        }
-        
-        return perform_restore(filename);
-    }
-    
-    // Incremental checkpointing
-    bool incremental_checkpoint() {
-        if (checkpoint_in_progress_.load()) {
-            return false;
-        }
-        
-        std::string checkpoint_file = generate_incremental_filename();
-        return perform_checkpoint(checkpoint_file, true);
-    }
-    
+    PersistentCache(RadialCircularList& cache, const CacheConfig& config,
+                   const std::string& checkpoint_dir = "./checkpoints");
+    ~PersistentCache();
+
+    // Full checkpoint operations; false if one is already running
+    bool checkpoint_to_disk(const std::string& filename = "");
+    bool restore_from_disk(const std::string& filename);
+
+    // Incremental checkpointing: nodes inserted since the last full checkpoint
+    bool incremental_checkpoint();
+
+    // Blocks until no checkpoint is running; returns whether the last one succeeded
+    bool wait_for_checkpoint();
+    CheckpointStats last_checkpoint_stats() const;
+    RestoreStats last_restore_stats() const;
+
     // Point-in-time recovery
-    bool point_in_time_recovery(uint64_t timestamp) {
-        auto checkpoint_file = find_checkpoint_at_time(timestamp);
-        if (checkpoint_file.empty()) {
-            return false;
-        }
-        
-        return perform_restore(checkpoint_file);
-    }
-    
+    bool point_in_time_recovery(uint64_t timestamp);
+
+    // Write-ahead log; sync_wal returns once everything logged so far is on disk
+    bool sync_wal();
+    const WriteAheadLog* wal() const { return wal_.get(); }
+    void on_insert(const Node& node) override;
+    void on_remove(const Node& node) override;
+
     // Checkpoint management
-    std::vector<CheckpointMetadata> list_checkpoints() const {
-        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
-        std::vector<CheckpointMetadata> checkpoints;
-        std::queue<CheckpointMetadata> temp_queue = checkpoint_history_;
-        
-        while (!temp_queue.empty()) {
-            checkpoints.push_back(temp_queue.front());
-            temp_queue.pop();
-        }
-        
-        return checkpoints;
-    }
-    
-    bool delete_checkpoint(const std::string& filename) {
-        std::filesystem::path filepath = std::filesystem::path(checkpoint_dir_) / filename;
-        if (std::filesystem::exists(filepath)) {
-            return std::filesystem::remove(filepath);
-        }
-        return false;
-    }
-    
+    std::vector<CheckpointMetadata> list_checkpoints() const;
+    bool delete_checkpoint(const std::string& filename);
+
     // Automatic checkpointing
-    void enable_auto_checkpoint(std::chrono::seconds interval) {
-        // Implementation would schedule periodic checkpoints
-    }
-    
-    void disable_auto_checkpoint() {
-        // Implementation would stop automatic checkpoints
-    }
-    
-    // Compression support
-    void enable_compression(bool enable = true) {
-        // Implementation would enable/disable checkpoint compression
-    }
-    
-    // Encryption support
-    void enable_encryption(const std::string& key) {
-        // Implementation would enable checkpoint encryption
-    }
+    void enable_auto_checkpoint(std::chrono::seconds interval);
+    void disable_auto_checkpoint();
+
+    // Columnar, block-compressed checkpoints from the next one on; restores
+    // read either kind
+    void enable_compression(bool enable = true);
+
+    // Checkpoints are never encrypted: this build has no cipher, so the
+    // call is refused with a CONFIGURATION_ERROR and returns false rather
+    // than leaving a caller believing its checkpoints are protected
+    bool enable_encryption(const std::string& key);
 
 private:
-    void start_checkpoint_thread() {
-        checkpoint_thread_ = std::thread([this]() {
-            while (!shutdown_.load()) {
-                // Background checkpoint processing
-                std::this_thread::sleep_for(std::chrono::seconds(1));
-            }
-        });
-    }
-    
-    std::string generate_checkpoint_filename() const {
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-            now.time_since_epoch()).count();
-        
-        return std::string("checkpoint_") + std::to_string(timestamp) + ".dat";
-    }
-    
-    std::string generate_incremental_filename() const {
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-            now.time_since_epoch()).count();
-        
-        return std::string("incremental_") + std::to_string(timestamp) + ".dat";
-    }
-    
-    bool perform_checkpoint(const std::string& filename, bool incremental) {
-        checkpoint_in_progress_.store(true);
-        
-        try {
-            std::filesystem::path filepath = std::filesystem::path(checkpoint_dir_) / filename;
-            std::ofstream file(filepath, std::ios::binary);
-            
-            if (!file.is_open()) {
-                checkpoint_in_progress_.store(false);
-                return false;
-            }
-            
-            // Write checkpoint header
-            write_checkpoint_header(file, incremental);
-            
-            // Write cache data
-            write_cache_data(file, incremental);
-            
-            // Update metadata
-            update_checkpoint_metadata(filename, incremental);
-            
-            checkpoint_in_progress_.store(false);
-            return true;
-            
-        } catch (const std::exception& e) {
-            checkpoint_in_progress_.store(false);
-            return false;
-        }
-    }
-    
-    bool perform_restore(const std::string& filename) {
-        try {
-            std::ifstream file(filename, std::ios::binary);
-            
-            if (!file.is_open()) {
-                return false;
-            }
-            
-            // Read checkpoint header
-            auto header = read_checkpoint_header(file);
-            
-            // Clear current cache
-            clear_cache();
-            
-            // Restore cache data
-            restore_cache_data(file, header);
-            
-            return true;
-            
-        } catch (const std::exception& e) {
-            return false;
-        }
-    }
-    
-    void write_checkpoint_header(std::ofstream& file, bool incremental) {
-        // Write checkpoint format version
-        uint32_t version = 1;
-        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-        
-        // Write checkpoint type
-        uint8_t type = incremental ? 1 : 0;
-        file.write(reinterpret_cast<const char*>(&type), sizeof(type));
-        
-        // Write timestamp
-        auto now = std::chrono::system_clock::now();
-        auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-            now.time_since_epoch()).count();
-        file.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-        
-        // Write node count placeholder
-        uint64_t node_count = 0;  // Will be updated later
-        file.write(reinterpret_cast<const char*>(&node_count), sizeof(node_count));
-    }
-    
-    void write_cache_data(std::ofstream& file, bool incremental) {
-        // Implementation would serialize all cache data
-        // This is a placeholder for the actual serialization logic
-    }
-    
-    void update_checkpoint_metadata(const std::string& filename, bool incremental) {
-        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
-        
-        CheckpointMetadata metadata;
-        metadata.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        metadata.filename = filename;
-        metadata.is_incremental = incremental;
-        
-        checkpoint_history_.push(metadata);
-        
-        // Maintain history size
-        while (checkpoint_history_.size() > MAX_CHECKPOINT_HISTORY) {
-            checkpoint_history_.pop();
-        }
-    }
-    
     struct CheckpointHeader {
         uint32_t version;
         uint8_t type;
-        uint64_t timestamp;
+        uint64_t timestamp;       // wall-clock ns of the cut
+        uint64_t base_timestamp;  // wall-clock ns of the full checkpoint an incremental builds on
         uint64_t node_count;
+        uint64_t symbol_count;
+    };
+
+    void start_checkpoint_thread();
+    void checkpoint_worker();
+    bool request_checkpoint(const std::string& filename, bool incremental);
+    std::string generate_checkpoint_filename() const;
+    std::string generate_incremental_filename() const;
+
+    bool perform_checkpoint(const std::string& filename, bool incremental);
+    bool perform_restore(const std::string& filename);
+
+    void update_checkpoint_metadata(const std::string& filename, bool incremental, const CheckpointHeader& header);
+    // Queues every live record of a verified file, in parallel
+    size_t restore_cache_data(const CheckpointFile& file, RestoreStats& stats);
+    size_t restore_worker_count(size_t work_items) const;
+    void clear_cache();
+    // Every checkpoint file in checkpoint_dir_ whose header reads, by path
+    std::vector<std::pair<std::string, CheckpointHeader>> read_checkpoint_headers() const;
+    // Newest full checkpoint taken at or before timestamp, or ""
+    std::string find_checkpoint_at_time(uint64_t timestamp) const;
+
+    uint64_t wall_time(uint64_t coarse_ns) const { return coarse_ns + wall_offset_.load(std::memory_order_relaxed); }
+    void reanchor_wall_clock();
+    // Applies logged changes with after < timestamp <= until to the cache
+    size_t replay_wal(uint64_t after, uint64_t until);
+    // Restores must not log the changes they make
+    void set_logging(bool enabled);
+    struct LoggingPause {
+        PersistentCache& owner;
+        explicit LoggingPause(PersistentCache& cache) : owner(cache) { owner.set_logging(false); }
+        ~LoggingPause() { owner.set_logging(true); }
     };
-    
-    CheckpointHeader read_checkpoint_header(std::ifstream& file) {
-        CheckpointHeader header;
-        
-        file.read(reinterpret_cast<char*>(&header.version), sizeof(header.version));
-        file.read(reinterpret_cast<char*>(&header.type), sizeof(header.type));
-        file.read(reinterpret_cast<char*>(&header.timestamp), sizeof(header.timestamp));
-        file.read(reinterpret_cast<char*>(&header.node_count), sizeof(header.node_count));
-        
-        return header;
-    }
-    
-    void restore_cache_data(std::ifstream& file, const CheckpointHeader& header) {
-        // Implementation would deserialize and restore cache data
-        // This is a placeholder for the actual deserialization logic
-    }
-    
-    void clear_cache() {
-        // Implementation would clear the current cache
-        // This is a placeholder
-    }
-    
-    std::string find_checkpoint_at_time(uint64_t timestamp) const {
-        // Implementation would find the closest checkpoint to the given timestamp
-        return "";
-    }
-    
-    void record_node_modification(uint64_t timestamp, const std::string& node_id) {
-        std::lock_guard<std::mutex> lock(modification_mutex_);
-        modified_nodes_.emplace_back(timestamp, node_id);
-    }
 };
 
-#endif 
\ No newline at end of file
+#endif
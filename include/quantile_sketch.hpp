@@ -0,0 +1,141 @@
+#ifndef QUANTILE_SKETCH_HPP
+#define QUANTILE_SKETCH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Streaming quantile sketch with bounded relative error that supports removal.
+//
+// Values are counted in logarithmic buckets, bucket i covering
+// (gamma^(i-1), gamma^i], so any estimate is within relative_accuracy of a
+// value that was really added. Counts are kept densely over the range of
+// buckets seen so far; a symbol trading between 100 and 200 needs about 70
+// of them at the default accuracy, and the array only grows (and allocates)
+// when a value lands outside that range.
+//
+// The median is tracked incrementally: a cursor sits on the bucket holding
+// the lower-median rank, with the count below it. Every add or remove moves
+// that rank by at most one, so the cursor only steps over empty buckets and
+// median() is a single lookup. Values at or below MIN_VALUE share the
+// lowest bucket. Not thread-safe.
+class QuantileSketch {
+public:
+    static constexpr double MIN_VALUE = 1e-9;
+
+    explicit QuantileSketch(double relative_accuracy = 0.005)
+        : gamma_((1.0 + relative_accuracy) / (1.0 - relative_accuracy)),
+          log_gamma_(std::log(gamma_)) {}
+
+    void add(double value) {
+        int32_t bucket = bucket_of(value);
+        ensure(bucket);
+        ++counts_[bucket - offset_];
+        if (total_ == 0) {
+            cursor_ = bucket;
+            below_ = 0;
+        } else if (bucket < cursor_) {
+            ++below_;
+        }
+        ++total_;
+        settle();
+    }
+
+    // Returns false, changing nothing, if no value in value's bucket is held
+    bool remove(double value) {
+        int32_t bucket = bucket_of(value);
+        if (at(bucket) == 0) return false;
+        --counts_[bucket - offset_];
+        --total_;
+        if (bucket < cursor_) --below_;
+        settle();
+        return true;
+    }
+
+    uint64_t count() const { return total_; }
+
+    double median() const { return total_ ? value_of(cursor_) : 0.0; }
+
+    // Linear in the number of buckets; median() is the constant-time path
+    double quantile(double q) const {
+        if (total_ == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total_ - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen > rank) return value_of(offset_ + static_cast<int32_t>(i));
+        }
+        return value_of(offset_ + static_cast<int32_t>(counts_.size()) - 1);
+    }
+
+    double min() const {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i]) return value_of(offset_ + static_cast<int32_t>(i));
+        }
+        return 0.0;
+    }
+
+    double max() const {
+        for (size_t i = counts_.size(); i-- > 0;) {
+            if (counts_[i]) return value_of(offset_ + static_cast<int32_t>(i));
+        }
+        return 0.0;
+    }
+
+private:
+    double gamma_;
+    double log_gamma_;
+    std::vector<uint32_t> counts_;
+    int32_t offset_ = 0;  // bucket index of counts_[0]
+    uint64_t total_ = 0;
+    int32_t cursor_ = 0;  // bucket holding rank (total_ - 1) / 2
+    uint64_t below_ = 0;  // values in buckets below cursor_
+
+    int32_t bucket_of(double value) const {
+        return static_cast<int32_t>(std::ceil(std::log(std::max(value, MIN_VALUE)) / log_gamma_));
+    }
+
+    // Midpoint of the bucket in relative terms, which is what bounds the error
+    double value_of(int32_t bucket) const {
+        return 2.0 * std::exp(bucket * log_gamma_) / (gamma_ + 1.0);
+    }
+
+    uint32_t at(int32_t bucket) const {
+        int64_t index = static_cast<int64_t>(bucket) - offset_;
+        return index >= 0 && index < static_cast<int64_t>(counts_.size()) ? counts_[index] : 0;
+    }
+
+    void ensure(int32_t bucket) {
+        if (counts_.empty()) {
+            counts_.assign(64, 0);
+            offset_ = bucket - 32;
+            return;
+        }
+        int32_t end = offset_ + static_cast<int32_t>(counts_.size());
+        if (bucket >= offset_ && bucket < end) return;
+        // Grow to at least double so a drifting price reallocates rarely
+        int32_t span = static_cast<int32_t>(counts_.size());
+        int32_t low = std::min(offset_, bucket - span / 2);
+        int32_t high = std::max(end, bucket + span / 2 + 1);
+        std::vector<uint32_t> grown(static_cast<size_t>(high - low), 0);
+        std::copy(counts_.begin(), counts_.end(), grown.begin() + (offset_ - low));
+        counts_.swap(grown);
+        offset_ = low;
+    }
+
+    void settle() {
+        if (total_ == 0) return;
+        uint64_t rank = (total_ - 1) / 2;
+        while (below_ > rank) {
+            --cursor_;
+            below_ -= at(cursor_);
+        }
+        while (below_ + at(cursor_) <= rank) {
+            below_ += at(cursor_);
+            ++cursor_;
+        }
+    }
+};
+
+#endif
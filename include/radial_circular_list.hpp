@@ -1,28 +1,194 @@
 #ifndef RADIAL_CIRCULAR_LIST_HPP
 #define RADIAL_CIRCULAR_LIST_HPP
 
-#include "lockfree_map.hpp"
+#include "cache_observer.hpp"
+#include "dense_symbol_map.hpp"
+#include "epoch_reclamation.hpp"
+#include "expiry_engine.hpp"
+#include "midpoint.hpp"
+#include "node_pool.hpp"
+#include "span.hpp"
+#include "symbol_registry.hpp"
+#include "config.hpp"
+#include <algorithm>
 #include <atomic>
-#ifdef __linux__
-#include <numa.h>
-#endif
+#include <string>
+#include <tuple>
+#include <vector>
+
+// One entry of a batch insert, laid out flat so a feed handler can decode
+// a packet straight into an array of them
+struct InsertRecord {
+    double value;
+    SymbolId symbol;
+    int32_t priority;
+    double expiry_seconds;
+};
 
 class RadialCircularList {
 private:
-    LockFreeHashTable midpoints;
+    SymbolRegistry& symbols;
+    DenseSymbolMap<MidpointNode> midpoints;
     size_t max_nodes;
-    std::atomic<size_t> total_nodes;
-    std::vector<Node*> node_pool;
-    std::atomic<size_t> pool_index;
+    size_t heap_capacity;
+    size_t heap_shards;
+    NodePool node_pool;
+    ExpiryEngine expiry;
+    CacheObserverList observers;
+    bool numa_split;  // more than one NUMA node in play, so accesses can cross
+    std::atomic<uint64_t> cross_numa{0};
+
+    MidpointNode* create_midpoint(SymbolId midpoint) {
+        return midpoints.get_or_create(midpoint, heap_capacity, heap_shards, &node_pool,
+                                       numa_split ? NumaTopology::current_node() : 0);
+    }
+    void note_access(const MidpointNode* mid) {
+        if (numa_split && mid->home_node() != NumaTopology::current_node()) {
+            cross_numa.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool push_node(SymbolId midpoint, MidpointNode* mid, Node* node);
+    // Sorts batch positions by symbol, keeping arrival order within one,
+    // into a buffer reused by the calling thread; each key is the symbol in
+    // the high half and the position in the low half
+    template <typename SymbolOf>
+    static const uint64_t* group_by_symbol(size_t count, SymbolOf&& symbol_of);
+    size_t purge_expired(SymbolId midpoint, uint64_t now, size_t limit, uint64_t& next_deadline);
 
 public:
+    explicit RadialCircularList(const CacheConfig& config);
     RadialCircularList(size_t max = 1000);
     ~RadialCircularList();
 
+    // SymbolId overloads skip the string hash entirely; ids come from
+    // SymbolRegistry::global().intern(). The string overloads intern on
+    // insert and look up (without interning) on reads.
+    //
+    // A node returned by get_highest_priority has already been handed back to
+    // the pool through NodePool::retire, so it stays readable for as long as
+    // the caller holds an EpochGuard and is recycled some time after that.
+    // Take the guard before the call: without one, another thread's reclaim
+    // may recycle the node before it is read. A caller that only compares
+    // the result against nullptr needs no guard.
+    bool insert(double value, SymbolId midpoint, int priority = 0, double expiry_time = 60.0);
     bool insert(double value, const std::string& midpoint, int priority = 0, double expiry_time = 60.0);
-    bool insert_batch(const std::vector<std::tuple<double, std::string, int, double>>& batch);
+    Node* get_highest_priority(SymbolId midpoint);
     Node* get_highest_priority(const std::string& midpoint);
+
+    // Batch paths for packet-sized bursts. Records are grouped by symbol so
+    // each symbol is resolved once and its heap is locked once per group;
+    // the whole batch shares one clock reading, and the next group's heap is
+    // prefetched while the current one is queued. Slots for the batch are
+    // taken from the pool up front, all or nothing: insert_batch returns 0
+    // without queueing anything if the pool cannot cover it, and otherwise
+    // the number queued, short only where a heap was full.
+    size_t insert_batch(Span<const InsertRecord> batch);
+    // out[i] gets the best live node for midpoints[i], or nullptr; a symbol
+    // named k times gets its k best, in the order the requests came. Nodes
+    // are retired as by get_highest_priority. out must be at least as long
+    // as midpoints; returns the number of non-null results.
+    size_t get_highest_priority_batch(Span<const SymbolId> midpoints, Span<Node*> out);
+    // Vector forms of the above
+    bool insert_batch(const std::vector<std::tuple<double, SymbolId, int, double>>& batch);
+    bool insert_batch(const std::vector<std::tuple<double, std::string, int, double>>& batch);
+    std::vector<Node*> get_highest_priority_batch(const std::vector<SymbolId>& midpoints);
     std::vector<Node*> get_highest_priority_batch(const std::vector<std::string>& midpoints);
+
+    // Bulk load for restores: fill(Node&, i) writes record i of count into a
+    // pool slot and returns false to skip it. Slots are taken from the pool
+    // a chunk at a time and each chunk is queued with one lock per heap
+    // shard, and the symbol's expiry is scheduled once at the end. Several
+    // threads may load the same or different symbols at once. Returns the
+    // number queued, which falls short only if the pool or heap fills.
+    template <typename Fill>
+    size_t insert_bulk(SymbolId midpoint, size_t count, Fill&& fill);
+
+    // Drops one queued node with this value, reporting it to the observer
+    bool remove(SymbolId midpoint, double value);
+    bool remove(const std::string& midpoint, double value);
+    // Drops every queued node, reporting each to the observer
+    size_t clear();
+
+    // Copies the nodes queued for midpoint in one heap shard into out, under
+    // that shard's lock only; inserts carry on into the other shards. out is
+    // reserved up front so nothing allocates while the lock is held. Shards
+    // are numbered below snapshot_shards(); returns the number copied.
+    size_t snapshot_shard(SymbolId midpoint, size_t shard, std::vector<Node>& out);
+    size_t snapshot_shards() const { return heap_shards ? heap_shards : 1; }
+
+    // Expired nodes are also swept proactively: register this with
+    // MemoryManager::register_expiry_engine (and unregister before the list
+    // is destroyed), or drive it directly with expiry_engine().run().
+    ExpiryEngine& expiry_engine() { return expiry; }
+
+    // Secondary indexes. enable_index has midpoint keep its queued nodes in
+    // the orders named by kinds (SymbolIndex::Kind bits), updated on the
+    // same insert, pop, expiry, remove and clear paths as the heaps, so
+    // range queries need not scan. Like the observer, nodes already queued
+    // are not replayed. Returns false if the symbol cannot be created or
+    // already has an index that does not keep these orders. index returns
+    // nullptr for a symbol without one.
+    bool enable_index(SymbolId midpoint, unsigned kinds = SymbolIndex::ALL);
+    bool enable_index(const std::string& midpoint, unsigned kinds = SymbolIndex::ALL);
+    const SymbolIndex* index(SymbolId midpoint) const {
+        const MidpointNode* mid = midpoints.get(midpoint);
+        return mid ? mid->index() : nullptr;
+    }
+
+    // Observers are told about every node that enters or leaves, including
+    // expired nodes dropped by a pop or a sweep. Nodes already queued when
+    // one is attached are not replayed. Up to
+    // CacheObserverList::MAX_OBSERVERS may be attached at once; attach
+    // refuses a duplicate or a full list, and detach only removes the
+    // observer it is given. A detached observer must outlive any operation
+    // that was running at the time.
+    bool attach_observer(CacheObserver* cache_observer) { return observers.attach(cache_observer); }
+    bool detach_observer(CacheObserver* cache_observer) { return observers.detach(cache_observer); }
+
+    // With config.enable_numa the node pool is split per NUMA node and each
+    // symbol belongs to the node of the thread that first wrote it. These
+    // count inserts and pops on a symbol from another node, and nodes a
+    // thread had to take from another node's partition; both stay 0 on a
+    // single-node machine. MetricsCollector::record_cross_numa_access folds
+    // them into CacheMetrics.
+    uint64_t cross_numa_accesses() const { return cross_numa.load(std::memory_order_relaxed); }
+    uint64_t remote_node_allocations() const { return node_pool.remote_allocations(); }
 };
 
+template <typename Fill>
+size_t RadialCircularList::insert_bulk(SymbolId midpoint, size_t count, Fill&& fill) {
+    MidpointNode* mid = create_midpoint(midpoint);
+    if (!mid) return 0;
+    note_access(mid);
+    constexpr size_t CHUNK = 256;
+    Node* chunk[CHUNK];
+    CacheObserver* watcher = observers.active();
+    uint64_t earliest = UINT64_MAX;
+    size_t inserted = 0;
+    size_t next = 0;
+    while (next < count) {
+        size_t taken = node_pool.allocate_bulk(chunk, std::min(CHUNK, count - next));
+        if (taken == 0) break;
+        size_t filled = 0;
+        while (filled < taken && next < count) {
+            Node& node = *chunk[filled];
+            if (!fill(node, next++)) continue;
+            node.symbol = midpoint;
+            if (watcher) watcher->on_insert(node);
+            if (node.deadline_ns < earliest) earliest = node.deadline_ns;
+            ++filled;
+        }
+        size_t pushed = mid->add_bulk(chunk, filled);
+        inserted += pushed;
+        for (size_t i = pushed; i < taken; ++i) {
+            if (i < filled && watcher) watcher->on_remove(*chunk[i]);
+            node_pool.release(chunk[i]);
+        }
+        if (pushed < filled) break;
+    }
+    if (earliest != UINT64_MAX && mid->note_deadline(earliest)) expiry.schedule(midpoint, earliest);
+    return inserted;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef SECONDARY_INDEX_HPP
+#define SECONDARY_INDEX_HPP
+
+#include "node.hpp"
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Orders one symbol's queued nodes by value, creation time or priority, so
+// range queries are a binary search plus a copy instead of a scan of the
+// heaps.
+//
+// Each order is a flat array of node pointers sorted on (key, address),
+// reserved to the symbol's heap capacity so maintaining it never
+// allocates; insert is a binary search and a memmove, and erase finds its
+// exact entry by the same search. Entries at either end are added and
+// erased in constant time, which covers time order under expiry and
+// priority order under pops. Anywhere else the memmove makes insert and
+// erase linear in the symbol's depth: about 0.1 us per order at 1024
+// entries and 0.7 us at 16384 (SymbolIndexMaintenanceCost prints them). A
+// tree would make the middle logarithmic but scatter the nodes that range
+// queries copy out contiguously. The owning MidpointNode inserts a node
+// before it is queued and erases it before its slot is released or
+// retired, so every pointer held here is to a live node whose fields do not
+// change. Writers and readers of a symbol serialize on its SpinLock, and
+// queries copy nodes out rather than hand back pointers into the pool.
+class SymbolIndex {
+public:
+    enum Kind : unsigned {
+        BY_VALUE = 1u << 0,
+        BY_TIME = 1u << 1,      // Node::timestamp_ns
+        BY_PRIORITY = 1u << 2,
+        ALL = BY_VALUE | BY_TIME | BY_PRIORITY,
+    };
+
+    SymbolIndex(unsigned kinds, size_t capacity);
+
+    SymbolIndex(const SymbolIndex&) = delete;
+    SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+    unsigned kinds() const { return kinds_; }
+    bool covers(unsigned kinds) const { return (kinds_ & kinds) == kinds; }
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+    void insert(Node* node);
+    void erase(const Node* node);
+
+    // Append copies of the matching nodes to out in key order, bounds
+    // inclusive, and return how many were copied; 0 if the order is not
+    // kept. out is grown before the lock is taken, never while it is held.
+    size_t values_between(double min_value, double max_value, std::vector<Node>& out) const;
+    size_t created_between(uint64_t start_ns, uint64_t end_ns, std::vector<Node>& out) const;
+    size_t priorities_between(int min_priority, int max_priority, std::vector<Node>& out) const;
+    // Highest priority first
+    size_t top_priority(size_t n, std::vector<Node>& out) const;
+
+private:
+    using Iterator = std::vector<Node*>::const_iterator;
+
+    // Live entries are nodes[head, size): erasing the first entry only
+    // advances head, and the gap is reclaimed once the reservation fills
+    struct Order {
+        std::vector<Node*> nodes;
+        size_t head = 0;
+        void reserve(size_t capacity) { nodes.reserve(capacity); }
+        Iterator begin() const { return nodes.begin() + static_cast<std::ptrdiff_t>(head); }
+        Iterator end() const { return nodes.end(); }
+        template <typename Key>
+        void insert(Node* node, Key key);
+        template <typename Key>
+        bool erase(const Node* node, Key key);
+    };
+
+    // Copies [first, last) of order as picked by bounds(order.begin(),
+    // order.end()) under the lock, retrying once out has room
+    template <typename Bounds>
+    size_t copy_out(const Order& order, std::vector<Node>& out, bool reverse, Bounds&& bounds) const;
+
+    const unsigned kinds_;
+    mutable SpinLock lock_;
+    std::atomic<size_t> size_{0};
+    Order by_value_;
+    Order by_time_;
+    Order by_priority_;
+};
+
+#endif
@@ -2,16 +2,18 @@
 #define SECURITY_MANAGER_HPP
 
 #include "config.hpp"
+#include "symbol_registry.hpp"
 #include <string>
 #include <unordered_map>
 #include <chrono>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
-#include <functional>
-#include <random>
-#include <crypto++/sha.h>
-#include <crypto++/hex.h>
 
 enum class OperationType {
     READ,
@@ -23,6 +25,10 @@ enum class OperationType {
     CONFIG_ACCESS
 };
 
+constexpr uint32_t operation_bit(OperationType operation) {
+    return uint32_t(1) << static_cast<unsigned>(operation);
+}
+
 enum class PermissionLevel {
     NONE,
     READ_ONLY,
@@ -40,6 +46,7 @@ struct UserCredentials {
     std::chrono::system_clock::time_point last_login;
     bool is_active;
     std::vector<std::string> allowed_symbols;  // For symbol-specific permissions
+    uint64_t ops_per_second = 0;               // Per session; 0 takes the default limit
 };
 
 struct AuditLogEntry {
@@ -52,16 +59,129 @@ struct AuditLogEntry {
     std::string error_message;
 };
 
+// Everything one user may do, precomputed from their UserCredentials.
+//
+// A token is immutable once published. Every policy change builds a new one
+// and swaps it into the user's slot; the old one is retired through the
+// EpochManager, so a check that loaded it under an EpochGuard can finish
+// with it. A check is a mask test plus, for symbol-scoped users, one bit
+// test over SymbolIds.
+struct CapabilityToken {
+    std::string username;
+    uint64_t version = 0;          // Policy changes to this user, counting from 1
+    uint32_t operations = 0;       // operation_bit of every allowed OperationType; 0 when inactive
+    bool active = false;
+    bool all_symbols = true;       // No allowed_symbols list
+    std::vector<uint64_t> symbols; // Bit i set: SymbolId i allowed
+    double ops_per_second = 0.0;   // Per session token bucket; 0 is unlimited
+    double burst = 0.0;            // Bucket depth
+
+    bool allows(OperationType operation) const {
+        return (operations & operation_bit(operation)) != 0;
+    }
+
+    // A symbol-scoped token refuses INVALID_SYMBOL_ID, which is what a
+    // lookup of a never-interned ticker returns
+    bool allows_symbol(SymbolId symbol) const {
+        if (all_symbols) return true;
+        size_t word = symbol >> 6;
+        return word < symbols.size() && ((symbols[word] >> (symbol & 63)) & 1);
+    }
+};
+
+// Refilled by elapsed time, up to burst. Not thread-safe: each
+// SecuritySession owns one, and the legacy allow_operation keeps its
+// buckets under rate_limit_mutex_.
+struct TokenBucket {
+    double tokens = 0.0;
+    uint64_t refilled_ns = 0;  // 0 until first use, which starts the bucket full
+
+    bool try_take(double ops_per_second, double burst, uint64_t now_ns);
+};
+
+// A user's view of the SecurityManager for one thread.
+//
+// Holds the user's token slot, which lives as long as the manager, and a
+// private token bucket, so authorize() and allow() on a session take no
+// lock and touch no shared cache line but the slot's pointer. Rate limits
+// therefore apply per session: a user with four sessions may issue four
+// times their ops_per_second. Sessions are movable but must not be shared
+// between threads or outlive their SecurityManager.
+class SecuritySession {
+public:
+    SecuritySession() = default;
+
+    bool valid() const { return slot_ != nullptr; }
+    const std::string& username() const { return username_; }
+
+private:
+    friend class SecurityManager;
+
+    const std::atomic<const CapabilityToken*>* slot_ = nullptr;
+    std::string username_;
+    TokenBucket bucket_;
+};
+
 class SecurityManager {
 private:
+    // Why an authorization was refused, as recorded in the audit ring
+    enum class AuditReason : uint8_t {
+        UNKNOWN_USER,
+        INACTIVE,
+        PERMISSION,
+        SYMBOL,
+        RATE_LIMIT
+    };
+
+    // A refused check, fixed-size so that queueing one is a copy, not an
+    // allocation. Usernames longer than the buffer are truncated.
+    struct AuditRecord {
+        std::chrono::system_clock::time_point timestamp;
+        char username[39];
+        uint8_t username_length;
+        OperationType operation;
+        AuditReason reason;
+        SymbolId symbol;
+    };
+
+    // Bounded multi-producer queue (Vyukov): a producer claims a cell with
+    // one CAS and publishes it with one release store, and fails instead of
+    // waiting when the ring is full. One thread at a time drains it, under
+    // audit_mutex_.
+    class AuditRing {
+    public:
+        explicit AuditRing(size_t capacity);
+
+        bool try_push(const AuditRecord& record);
+        bool try_pop(AuditRecord& record);
+
+    private:
+        struct Cell {
+            std::atomic<uint64_t> sequence;
+            AuditRecord record;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+        alignas(64) std::atomic<uint64_t> enqueue_{0};
+        alignas(64) uint64_t dequeue_{0};
+    };
+
+    struct TokenSlot {
+        std::atomic<const CapabilityToken*> token{nullptr};
+    };
+
     CacheConfig config_;
     std::unordered_map<std::string, UserCredentials> users_;
-    std::unordered_map<std::string, std::atomic<uint64_t>> rate_limiters_;
-    std::vector<AuditLogEntry> audit_log_;
+    // One per user, never removed, so sessions can hold the slot
+    std::unordered_map<std::string, std::unique_ptr<TokenSlot>> slots_;
+    std::unordered_map<std::string, TokenBucket> rate_limiters_;
+    std::unordered_map<std::string, uint64_t> client_rate_limits_;
+    std::deque<AuditLogEntry> audit_log_;
     std::mutex users_mutex_;
-    std::mutex audit_mutex_;
+    mutable std::mutex audit_mutex_;
     std::mutex rate_limit_mutex_;
-    
+
     // Rate limiting configuration
     struct RateLimitConfig {
         uint64_t max_requests_per_second;
@@ -69,299 +189,101 @@ private:
         uint64_t max_requests_per_hour;
         std::chrono::seconds window_size;
     };
-    
+
     RateLimitConfig default_rate_limit_{1000, 60000, 3600000, std::chrono::seconds(1)};
-    
+
     // Encryption
     std::string encryption_key_;
     bool encryption_enabled_{false};
 
+    // Async audit log
+    AuditRing audit_ring_;
+    std::atomic<uint64_t> audit_dropped_{0};
+    std::mutex flusher_mutex_;
+    std::condition_variable flusher_cv_;
+    bool stop_flusher_ = false;
+    std::thread audit_flusher_;
+
 public:
-    explicit SecurityManager(const CacheConfig& config) : config_(config) {
-        initialize_default_users();
-    }
-    
+    explicit SecurityManager(const CacheConfig& config);
+    ~SecurityManager();
+
+    SecurityManager(const SecurityManager&) = delete;
+    SecurityManager& operator=(const SecurityManager&) = delete;
+
     // Authentication
-    bool authenticate_user(const std::string& username, const std::string& password) {
-        std::lock_guard<std::mutex> lock(users_mutex_);
-        
-        auto it = users_.find(username);
-        if (it == users_.end()) {
-            log_audit_entry(username, "AUTHENTICATION", "User not found", false, "User does not exist");
-            return false;
-        }
-        
-        UserCredentials& user = it->second;
-        if (!user.is_active) {
-            log_audit_entry(username, "AUTHENTICATION", "User inactive", false, "Account disabled");
-            return false;
-        }
-        
-        std::string hashed_password = hash_password(password, user.salt);
-        if (hashed_password != user.password_hash) {
-            log_audit_entry(username, "AUTHENTICATION", "Invalid password", false, "Password mismatch");
-            return false;
-        }
-        
-        user.last_login = std::chrono::system_clock::now();
-        log_audit_entry(username, "AUTHENTICATION", "Login successful", true, "");
-        return true;
-    }
-    
+    bool authenticate_user(const std::string& username, const std::string& password);
+
+    // Sessions: the lock-free path for checks in front of cache operations.
+    // open_session authenticates; an invalid session refuses everything.
+    SecuritySession open_session(const std::string& username, const std::string& password);
+    // Without a symbol the check names none in particular, so symbol
+    // scoping does not apply
+    bool authorize(SecuritySession& session, OperationType operation);
+    bool authorize(SecuritySession& session, OperationType operation, SymbolId symbol);
+    // Takes one token from the session's bucket
+    bool allow(SecuritySession& session, OperationType operation);
+    // The token a session currently sees; valid while the caller holds an EpochGuard
+    const CapabilityToken* current_token(const SecuritySession& session) const;
+
     // Authorization
-    bool authorize_operation(const std::string& username, OperationType operation, 
-                           const std::string& symbol = "") {
-        std::lock_guard<std::mutex> lock(users_mutex_);
-        
-        auto it = users_.find(username);
-        if (it == users_.end()) {
-            return false;
-        }
-        
-        UserCredentials& user = it->second;
-        if (!user.is_active) {
-            return false;
-        }
-        
-        // Check permission level
-        if (!has_permission(user.permission_level, operation)) {
-            log_audit_entry(username, "AUTHORIZATION", "Insufficient permissions", false, 
-                          "Operation not allowed for permission level");
-            return false;
-        }
-        
-        // Check symbol-specific permissions
-        if (!symbol.empty() && !user.allowed_symbols.empty()) {
-            if (std::find(user.allowed_symbols.begin(), user.allowed_symbols.end(), symbol) 
-                == user.allowed_symbols.end()) {
-                log_audit_entry(username, "AUTHORIZATION", "Symbol access denied", false, 
-                              "Symbol not in allowed list");
-                return false;
-            }
-        }
-        
-        return true;
-    }
-    
+    bool authorize_operation(const std::string& username, OperationType operation,
+                           const std::string& symbol = "");
+
     // Rate limiting
-    bool allow_operation(const std::string& client_id, OperationType operation) {
-        std::string rate_limit_key = client_id + "_" + std::to_string(static_cast<int>(operation));
-        
-        std::lock_guard<std::mutex> lock(rate_limit_mutex_);
-        
-        auto& rate_limiter = rate_limiters_[rate_limit_key];
-        uint64_t current_count = rate_limiter.load();
-        
-        if (current_count >= default_rate_limit_.max_requests_per_second) {
-            log_audit_entry(client_id, "RATE_LIMIT", "Rate limit exceeded", false, 
-                          "Too many requests per second");
-            return false;
-        }
-        
-        rate_limiter.fetch_add(1);
-        return true;
-    }
-    
-    void set_rate_limit(const std::string& client_id, uint64_t ops_per_second) {
-        std::lock_guard<std::mutex> lock(rate_limit_mutex_);
-        // Implementation would update rate limits for specific clients
-    }
-    
+    bool allow_operation(const std::string& client_id, OperationType operation);
+    // Per client for allow_operation; for a user, also their sessions' limit.
+    // 0 restores the default.
+    void set_rate_limit(const std::string& client_id, uint64_t ops_per_second);
+
     // User management
-    bool create_user(const std::string& username, const std::string& password, 
-                    PermissionLevel permission_level) {
-        std::lock_guard<std::mutex> lock(users_mutex_);
-        
-        if (users_.find(username) != users_.end()) {
-            return false;  // User already exists
-        }
-        
-        std::string salt = generate_salt();
-        std::string password_hash = hash_password(password, salt);
-        
-        UserCredentials user;
-        user.username = username;
-        user.password_hash = password_hash;
-        user.salt = salt;
-        user.permission_level = permission_level;
-        user.created_at = std::chrono::system_clock::now();
-        user.is_active = true;
-        
-        users_[username] = user;
-        
-        log_audit_entry("SYSTEM", "USER_CREATION", "User created", true, 
-                       "Created user: " + username);
-        return true;
-    }
-    
-    bool update_user_permissions(const std::string& username, PermissionLevel new_level) {
-        std::lock_guard<std::mutex> lock(users_mutex_);
-        
-        auto it = users_.find(username);
-        if (it == users_.end()) {
-            return false;
-        }
-        
-        it->second.permission_level = new_level;
-        
-        log_audit_entry("SYSTEM", "PERMISSION_UPDATE", "Permissions updated", true, 
-                       "Updated permissions for: " + username);
-        return true;
-    }
-    
-    bool deactivate_user(const std::string& username) {
-        std::lock_guard<std::mutex> lock(users_mutex_);
-        
-        auto it = users_.find(username);
-        if (it == users_.end()) {
-            return false;
-        }
-        
-        it->second.is_active = false;
-        
-        log_audit_entry("SYSTEM", "USER_DEACTIVATION", "User deactivated", true, 
-                       "Deactivated user: " + username);
-        return true;
-    }
-    
+    bool create_user(const std::string& username, const std::string& password,
+                    PermissionLevel permission_level);
+    bool update_user_permissions(const std::string& username, PermissionLevel new_level);
+    bool deactivate_user(const std::string& username);
+    // Empty allows every symbol
+    bool set_allowed_symbols(const std::string& username, const std::vector<std::string>& symbols);
+
     // Audit logging
-    void log_audit_entry(const std::string& username, const std::string& operation, 
-                        const std::string& details, bool success, const std::string& error_message) {
-        std::lock_guard<std::mutex> lock(audit_mutex_);
-        
-        AuditLogEntry entry;
-        entry.username = username;
-        entry.operation = operation;
-        entry.details = details;
-        entry.timestamp = std::chrono::system_clock::now();
-        entry.success = success;
-        entry.error_message = error_message;
-        
-        audit_log_.push_back(entry);
-        
-        // Maintain audit log size
-        if (audit_log_.size() > 10000) {
-            audit_log_.erase(audit_log_.begin());
-        }
-    }
-    
-    std::vector<AuditLogEntry> get_audit_log(const std::string& username = "", 
-                                            size_t limit = 100) const {
-        std::lock_guard<std::mutex> lock(audit_mutex_);
-        
-        std::vector<AuditLogEntry> filtered_log;
-        for (const auto& entry : audit_log_) {
-            if (username.empty() || entry.username == username) {
-                filtered_log.push_back(entry);
-                if (filtered_log.size() >= limit) break;
-            }
-        }
-        
-        return filtered_log;
-    }
-    
+    void log_audit_entry(const std::string& username, const std::string& operation,
+                        const std::string& details, bool success, const std::string& error_message);
+    // Entries written so far. Authorization outcomes are queued and reach the
+    // log within audit_flush_interval_ms; flush_audit_log() writes them now.
+    std::vector<AuditLogEntry> get_audit_log(const std::string& username = "",
+                                            size_t limit = 100) const;
+    void flush_audit_log();
+    // Records lost to a full ring
+    uint64_t dropped_audit_entries() const { return audit_dropped_.load(std::memory_order_relaxed); }
+
     // Encryption
-    void enable_encryption(const std::string& key) {
-        encryption_key_ = key;
-        encryption_enabled_ = true;
-    }
-    
-    void disable_encryption() {
-        encryption_enabled_ = false;
-        encryption_key_.clear();
-    }
-    
-    std::string encrypt_data(const std::string& data) {
-        if (!encryption_enabled_) {
-            return data;
-        }
-        
-        // Implementation would use encryption_key_ to encrypt data
-        // This is a placeholder
-        return data;
-    }
-    
-    std::string decrypt_data(const std::string& encrypted_data) {
-        if (!encryption_enabled_) {
-            return encrypted_data;
-        }
-        
-        // Implementation would use encryption_key_ to decrypt data
-        // This is a placeholder
-        return encrypted_data;
-    }
-    
+    void enable_encryption(const std::string& key);
+    void disable_encryption();
+    std::string encrypt_data(const std::string& data);
+    std::string decrypt_data(const std::string& encrypted_data);
+
     // Security checks
-    bool validate_input(const std::string& input) {
-        // Check for SQL injection, XSS, etc.
-        if (input.find("'") != std::string::npos || 
-            input.find(";") != std::string::npos ||
-            input.find("<script>") != std::string::npos) {
-            return false;
-        }
-        return true;
-    }
-    
-    bool is_suspicious_activity(const std::string& username) {
-        // Check for unusual patterns
-        auto recent_logs = get_audit_log(username, 100);
-        int failed_attempts = 0;
-        
-        for (const auto& entry : recent_logs) {
-            if (!entry.success && entry.operation == "AUTHENTICATION") {
-                failed_attempts++;
-            }
-        }
-        
-        return failed_attempts > 5;  // More than 5 failed attempts
-    }
+    bool validate_input(const std::string& input);
+    bool is_suspicious_activity(const std::string& username);
 
 private:
-    void initialize_default_users() {
-        // Create default admin user
-        create_user("admin", "admin123", PermissionLevel::SUPER_ADMIN);
-        
-        // Create default read-only user
-        create_user("reader", "reader123", PermissionLevel::READ_ONLY);
-    }
-    
-    bool has_permission(PermissionLevel user_level, OperationType operation) {
-        switch (operation) {
-            case OperationType::READ:
-                return user_level >= PermissionLevel::READ_ONLY;
-            case OperationType::WRITE:
-                return user_level >= PermissionLevel::READ_WRITE;
-            case OperationType::DELETE:
-                return user_level >= PermissionLevel::ADMIN;
-            case OperationType::ADMIN:
-            case OperationType::BATCH_OPERATION:
-            case OperationType::METRICS_ACCESS:
-            case OperationType::CONFIG_ACCESS:
-                return user_level >= PermissionLevel::ADMIN;
-            default:
-                return false;
-        }
-    }
-    
-    std::string generate_salt() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 255);
-        
-        std::string salt;
-        salt.reserve(16);
-        for (int i = 0; i < 16; ++i) {
-            salt += static_cast<char>(dis(gen));
-        }
-        
-        return salt;
-    }
-    
-    std::string hash_password(const std::string& password, const std::string& salt) {
-        // Implementation would use proper cryptographic hashing
-        // This is a placeholder - in production, use bcrypt, Argon2, or similar
-        return password + salt;  // Simplified for demonstration
-    }
+    void initialize_default_users();
+    bool has_permission(PermissionLevel user_level, OperationType operation);
+    std::string generate_salt();
+    std::string hash_password(const std::string& password, const std::string& salt);
+
+    // Builds the user's token from their credentials and swaps it in.
+    // Called with users_mutex_ held.
+    void publish_token(const UserCredentials& user);
+    // Checks token, queueing an audit record if it refuses; symbol is null
+    // when the check names no symbol
+    bool check_token(const CapabilityToken* token, const std::string& username,
+                     OperationType operation, const SymbolId* symbol);
+    void queue_audit(const std::string& username, OperationType operation, SymbolId symbol,
+                     AuditReason reason);
+    // Moves queued records into audit_log_; called with audit_mutex_ held
+    void drain_audit_ring();
+    void append_audit_entry(AuditLogEntry entry);
+    void audit_flusher_loop();
 };
 
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace hft_cache {
+
+/**
+ * @brief Append-only record log over memory-mapped, fixed-size segment files
+ *
+ * Records are appended to the active segment with a memcpy into its shared
+ * mapping, so a write never issues a syscall and survives a process crash
+ * once it is in the page cache; flush() msyncs only what was appended since
+ * the last flush. Each record carries a 16-byte header with a checksum, and
+ * recovery stops at the first header that does not verify, which drops a
+ * torn tail. When a record no longer matters the owner calls release(), and
+ * sealed segments whose live share drops below a threshold are rewritten
+ * forward and deleted by the owner's compaction.
+ *
+ * A Location packs the segment id and byte offset into 64 bits, which is
+ * all an in-memory index needs to hold per entry. Mappings are advised
+ * MADV_RANDOM since reads come through an index; prefetch() issues
+ * MADV_WILLNEED for a record ahead of its read. Not thread-safe: the owner
+ * serializes writers and keeps readers out of any segment it drops.
+ */
+class SegmentStore {
+public:
+    using Location = uint64_t;
+    static constexpr Location INVALID_LOCATION = UINT64_MAX;
+    static constexpr size_t HEADER_BYTES = 16;
+
+    SegmentStore(const std::string& directory, size_t segment_bytes);
+    ~SegmentStore();
+
+    SegmentStore(const SegmentStore&) = delete;
+    SegmentStore& operator=(const SegmentStore&) = delete;
+
+    // Returns INVALID_LOCATION if the record cannot be written
+    Location append(uint16_t kind, const void* payload, uint32_t length);
+
+    // Pointer into the mapping, valid until the segment is dropped
+    const uint8_t* payload(Location location, uint32_t* length = nullptr, uint16_t* kind = nullptr) const;
+
+    // Marks a record's bytes dead for compaction accounting; a record packing
+    // several entries releases 1/parts of itself per entry
+    void release(Location location, uint32_t parts = 1);
+
+    void prefetch(Location location) const;
+
+    // Visits every record of one segment in append order, starting at
+    // offset; fn(Location, kind, payload, length) returns false to stop.
+    // Returns the offset to resume from, or 0 once the segment is done.
+    template <typename Fn>
+    size_t scan_segment(uint32_t id, size_t offset, size_t max_records, Fn&& fn) const;
+
+    // Ids of every segment, oldest first, via fn(uint32_t)
+    template <typename Fn>
+    void for_each_segment(Fn&& fn) const {
+        for (const auto& entry : segments_) fn(entry.first);
+    }
+
+    // Oldest sealed segment whose live share is below threshold, or 0
+    uint32_t compaction_candidate(double threshold) const;
+    bool has_segment_before(uint32_t id) const;
+    void drop_segment(uint32_t id);
+
+    // Reopens every segment file in the directory, recovering its write offset
+    void open_existing();
+    // msync the bytes appended since the last flush
+    bool flush(bool synchronous = true);
+    // Deletes every segment and starts an empty one on the next append
+    void clear();
+
+    size_t bytes_on_disk() const;
+    size_t live_bytes() const;
+    size_t segment_count() const { return segments_.size(); }
+
+    static uint32_t segment_of(Location location) { return static_cast<uint32_t>(location >> 40); }
+    static size_t offset_of(Location location) { return static_cast<size_t>(location & ((uint64_t(1) << 40) - 1)); }
+
+private:
+    struct Segment {
+        uint32_t id = 0;
+        int fd = -1;
+        uint8_t* base = nullptr;
+        size_t capacity = 0;
+        size_t write_offset = 0;
+        size_t flushed_offset = 0;
+        size_t live_bytes = 0;
+    };
+
+    std::string directory_;
+    size_t segment_bytes_;
+    std::map<uint32_t, std::unique_ptr<Segment>> segments_;
+    Segment* active_ = nullptr;
+    uint32_t next_id_ = 1;
+
+    std::string path_for(uint32_t id) const;
+    Segment* open_segment(uint32_t id, bool create);
+    void close_segment(Segment& segment);
+    size_t recover_offset(const Segment& segment) const;
+    Segment* find(uint32_t id) const;
+    // Header of the record at offset if it verifies, else false
+    bool read_header(const Segment& segment, size_t offset, uint16_t& kind, uint32_t& length) const;
+
+    static size_t record_bytes(uint32_t length) { return (HEADER_BYTES + length + 7) & ~size_t(7); }
+    static Location make_location(uint32_t id, size_t offset) { return (static_cast<uint64_t>(id) << 40) | offset; }
+};
+
+template <typename Fn>
+size_t SegmentStore::scan_segment(uint32_t id, size_t offset, size_t max_records, Fn&& fn) const {
+    const Segment* segment = find(id);
+    if (!segment) return 0;
+    for (size_t visited = 0; visited < max_records; ++visited) {
+        uint16_t kind;
+        uint32_t length;
+        if (offset >= segment->write_offset || !read_header(*segment, offset, kind, length)) return 0;
+        if (!fn(make_location(id, offset), kind, segment->base + offset + HEADER_BYTES, length)) {
+            return offset + record_bytes(length);
+        }
+        offset += record_bytes(length);
+    }
+    return offset < segment->write_offset ? offset : 0;
+}
+
+} // namespace hft_cache
@@ -0,0 +1,63 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer seqlock around a trivially copyable value.
+//
+// The writer bumps the sequence to odd, stores the payload and bumps it back
+// to even; readers copy the payload and retry if the sequence was odd or
+// moved underneath them. Readers never write the line, so any number of them
+// can poll a value without slowing the writer down. The payload is held as
+// relaxed atomic words, which keeps the racing copy well-defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> words_[WORDS];
+
+public:
+    explicit SeqLock(const T& initial = T()) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &initial, sizeof(T));
+        for (size_t i = 0; i < WORDS; ++i) words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+
+    // Single writer only.
+    void store(const T& value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) words_[i].store(buffer[i], std::memory_order_relaxed);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t buffer[WORDS];
+        while (true) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                cpu_relax();
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; ++i) buffer[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) break;
+        }
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef SHARDED_RADIAL_CIRCULAR_LIST_HPP
+#define SHARDED_RADIAL_CIRCULAR_LIST_HPP
+
+#include "concurrent_priority_queue.hpp"
+#include "config.hpp"
+#include "dense_symbol_map.hpp"
+#include "numa_memory.hpp"
+#include "seqlock.hpp"
+#include "symbol_registry.hpp"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Shared-nothing variant of RadialCircularList for feeds where every symbol
+// has exactly one producing thread.
+//
+// Symbol `id` lives in shard `id % num_shards()`. A shard owns its node slab
+// and its per-symbol heaps and is written only by the thread that owns the
+// symbols routed to it, so insert and get_highest_priority use plain loads
+// and stores: no atomic RMWs, no locks and no cache line shared with another
+// shard. Any other thread reads through peek_highest_priority, which copies
+// the symbol's current top out of a seqlock republished whenever that top
+// changes, and never writes to the shard.
+class ShardedRadialCircularList {
+private:
+    struct SymbolHeap {
+        BoundedHeap heap;
+        SeqLock<Node> top;  // copy of heap.top(); symbol is INVALID_SYMBOL_ID when empty
+        explicit SymbolHeap(size_t capacity) : heap(capacity) {}
+        void publish();
+    };
+
+    // The slab's free slots are a plain index stack: only the owner
+    // allocates and releases, so recycling needs no atomics at all. The
+    // slab is mapped untouched and filled in on the owner's first warm()
+    // or insert, so its pages land on the NUMA node the owner runs on, not
+    // the one that built the list.
+    struct alignas(64) Shard {
+        NumaSlab memory;
+        Node* pool;
+        std::unique_ptr<uint32_t[]> free_slots;
+        size_t pool_capacity;
+        size_t free_count = 0;
+        int home_node = -1;                   // owner's node at first touch; -1 until then
+        std::atomic<size_t> live{0};          // owner-written with plain stores
+        std::atomic<uint64_t> cross_numa{0};  // owner calls from another node, plain stores too
+        DenseSymbolMap<SymbolHeap> heaps;     // keyed by id / num_shards()
+
+        explicit Shard(size_t capacity)
+            : memory(capacity * sizeof(Node)), pool(static_cast<Node*>(memory.data())), pool_capacity(capacity) {}
+
+        void touch();
+        void note_access() {
+            if (home_node < 0) {
+                touch();
+            } else if (NumaTopology::node_count() > 1 && NumaTopology::current_node() != home_node) {
+                cross_numa.store(cross_numa.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+        Node* allocate() { return free_count ? &pool[free_slots[--free_count]] : nullptr; }
+        void release(Node* node) { free_slots[free_count++] = static_cast<uint32_t>(node - pool); }
+        bool owns(const Node* node) const { return node >= pool && node < pool + pool_capacity; }
+    };
+
+    SymbolRegistry& symbols;
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t heap_capacity;
+
+    SymbolHeap* find_heap(SymbolId symbol) const {
+        return shards[shard_of(symbol)]->heaps.get(symbol / shards.size());
+    }
+
+public:
+    explicit ShardedRadialCircularList(const CacheConfig& config);
+
+    size_t num_shards() const { return shards.size(); }
+    size_t shard_of(SymbolId symbol) const { return symbol % shards.size(); }
+
+    // Owner thread of the symbol's shard only.
+    //
+    // warm faults in the shard's slab and creates the symbol's heap, so the
+    // first insert pays for neither; call it for each owned symbol before
+    // latency matters. Returns false if the heap cannot be created.
+    bool warm(SymbolId symbol);
+    bool insert(double value, SymbolId symbol, int priority = 0, double expiry_time = 60.0);
+    bool insert(double value, const std::string& symbol, int priority = 0, double expiry_time = 60.0);
+    Node* get_highest_priority(SymbolId symbol);
+    Node* get_highest_priority(const std::string& symbol);
+    // Returns a popped node's slot to its shard; expired nodes are recycled internally.
+    void release(Node* node);
+
+    // Any thread. Copies the current unexpired top into out; returns false if there is none.
+    bool peek_highest_priority(SymbolId symbol, Node& out) const;
+    bool peek_highest_priority(const std::string& symbol, Node& out) const;
+
+    size_t size() const;
+    // Owner calls from a NUMA node other than the shard's home; peeks are
+    // not counted, since they never write to the shard
+    uint64_t cross_numa_accesses() const;
+};
+
+#endif
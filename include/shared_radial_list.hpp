@@ -0,0 +1,115 @@
+#ifndef SHARED_RADIAL_LIST_HPP
+#define SHARED_RADIAL_LIST_HPP
+
+#include "config.hpp"
+#include "node.hpp"
+#include "seqlock.hpp"
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// RadialCircularList laid out in a named POSIX shared-memory segment, so
+// strategy processes can read the cache without an IPC hop.
+//
+// Everything lives in the segment and refers to everything else by index:
+// a slab of Nodes with a tagged Treiber free list, an open-addressed symbol
+// table, and one bounded heap of (priority, slot) entries per symbol behind
+// a SpinLock. Each symbol's current top is republished into a SeqLock on
+// every change, so peek_highest_priority is a lock-free copy. Both the
+// locks and the free list are plain lock-free atomics, which work the same
+// across processes mapping the same pages.
+//
+// One process creates the segment and ingests; it alone interns symbols
+// and inserts. Any process that attaches may peek or pop. A pop copies the
+// node out before its slot goes back on the free list, which keeps slot
+// reuse safe without cross-process epochs; the copy is 32 bytes straight
+// out of shared memory. Symbol ids here are dense ids from the segment's
+// own table, not SymbolRegistry ids, since those differ per process.
+// Times are CoarseClock readings, which share the system-wide
+// steady_clock epoch. A process that dies while holding a symbol's lock
+// leaves that symbol locked.
+class SharedRadialList {
+public:
+    static constexpr size_t MAX_NAME = 15;  // ticker bytes per symbol table slot
+
+    // Writer: creates segment name (e.g. "/hft_l2"), replacing any earlier
+    // one, with config.max_nodes node slots and room for max_symbols
+    // symbols of heap_capacity nodes each (0: max_nodes / 10, as in
+    // RadialCircularList). The segment is sparse until touched. Removed
+    // from the namespace when the writer is destroyed; processes still
+    // attached keep their mapping.
+    SharedRadialList(const std::string& name, const CacheConfig& config, size_t max_symbols = 256,
+                     size_t heap_capacity = 0);
+    // Reader: attaches to a segment created by another process
+    explicit SharedRadialList(const std::string& name);
+    ~SharedRadialList();
+
+    SharedRadialList(const SharedRadialList&) = delete;
+    SharedRadialList& operator=(const SharedRadialList&) = delete;
+
+    // False if the segment could not be created or attached, or was built
+    // with another layout
+    bool valid() const { return header_ != nullptr; }
+    bool writer() const { return writer_; }
+
+    // Writer only. INVALID_SYMBOL_ID if the name is too long or the table is full.
+    SymbolId intern(const std::string& symbol);
+    SymbolId find(const std::string& symbol) const;
+    size_t symbol_count() const;
+
+    // Writer only
+    bool insert(double value, SymbolId symbol, int priority = 0, double expiry_time = 60.0);
+    bool insert(double value, const std::string& symbol, int priority = 0, double expiry_time = 60.0);
+
+    // Pops the best live node for symbol into out, dropping expired ones on
+    // the way. Any attached process.
+    bool get_highest_priority(SymbolId symbol, Node& out);
+    bool get_highest_priority(const std::string& symbol, Node& out);
+    // Copies the best queued node without taking it or any lock; false if
+    // the symbol is empty or its top has expired
+    bool peek_highest_priority(SymbolId symbol, Node& out) const;
+
+    // Drops every expired node queued for symbol
+    size_t purge_expired(SymbolId symbol);
+
+    size_t size(SymbolId symbol) const;
+    size_t free_slots() const;
+    size_t capacity() const;
+
+private:
+    struct Header;
+    struct SymbolSlot;
+    struct HeapEntry {
+        int32_t priority;
+        uint32_t node;
+    };
+
+    Header* header_ = nullptr;
+    std::atomic<uint32_t>* index_ = nullptr;  // name hash -> symbol id + 1, 0 when empty
+    SymbolSlot* symbols_ = nullptr;
+    HeapEntry* heaps_ = nullptr;
+    Node* nodes_ = nullptr;
+    std::atomic<uint32_t>* links_ = nullptr;  // free-list next, by slot
+    void* mapping_ = nullptr;
+    size_t mapped_ = 0;
+    std::string name_;
+    bool writer_ = false;
+
+    bool map(int fd, size_t bytes);
+    void locate();
+
+    SymbolSlot* slot(SymbolId symbol) const;
+    HeapEntry* heap_of(SymbolId symbol) const;
+
+    uint32_t allocate();
+    void release(uint32_t node);
+
+    // Caller holds the symbol's lock
+    bool heap_push(SymbolSlot& slot, HeapEntry* heap, HeapEntry entry);
+    uint32_t heap_pop(SymbolSlot& slot, HeapEntry* heap);
+    void publish_top(SymbolSlot& slot, const HeapEntry* heap);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hft_cache {
+
+/**
+ * @brief Instruction-set tiers the column kernels are built for
+ */
+enum class SIMDLevel { SCALAR = 0, AVX2 = 1, AVX512 = 2 };
+
+/**
+ * @brief Column-scan kernels for one instruction-set tier
+ *
+ * Every kernel works on plain contiguous columns. The select_* kernels
+ * write the ascending indices of matching elements to out, which must have
+ * room for n entries, and return how many they wrote. The AVX2 and AVX-512
+ * variants are compiled with per-function target attributes, so the binary
+ * runs on any x86-64 and only executes what the CPU reports it supports.
+ */
+struct SIMDKernels {
+    SIMDLevel level;
+    size_t vector_bytes;  // 0 for the scalar tier
+
+    // Elements with now_ns > deadline, i.e. Node::is_expired(now_ns)
+    size_t (*select_expired)(const uint64_t* deadlines, size_t n, uint64_t now_ns, uint32_t* out);
+    // Elements with lo <= value <= hi
+    size_t (*select_value_range)(const double* values, size_t n, double lo, double hi, uint32_t* out);
+    size_t (*select_priority_range)(const int32_t* priorities, size_t n, int32_t lo, int32_t hi, uint32_t* out);
+    // Index of the first maximum, or n when the column is empty
+    size_t (*argmax_priority)(const int32_t* priorities, size_t n);
+    // Index of the first slot equal to key, or n
+    size_t (*find_pointer)(const void* const* items, size_t n, const void* key);
+};
+
+/**
+ * @brief Best tier this CPU and OS support
+ */
+SIMDLevel detect_simd_level();
+
+/**
+ * @brief Kernels for the requested tier, clamped to what the CPU supports
+ */
+const SIMDKernels& simd_kernels(SIMDLevel level);
+
+/**
+ * @brief Kernels for detect_simd_level(), resolved once
+ */
+const SIMDKernels& active_simd_kernels();
+
+const char* simd_level_name(SIMDLevel level);
+
+} // namespace hft_cache
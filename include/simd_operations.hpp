@@ -1,99 +1,204 @@
 #pragma once
 
-#include "node.hpp"
-#include <vector>
-#include <immintrin.h> // For AVX/AVX2/AVX-512
+#include "config.hpp"
+#include "dense_symbol_map.hpp"
+#include "node_pool.hpp"
+#include "simd_kernels.hpp"
+#include "spin_lock.hpp"
+#include <atomic>
+#include <cstdlib>
 #include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace hft_cache {
 
 /**
- * @brief SIMD operations for vectorized cache operations
- * 
- * Provides vectorized operations for batch processing, priority updates,
- * expiry checks, and value calculations using AVX/AVX2/AVX-512 instructions.
+ * @brief Minimal allocator handing out 64-byte aligned storage, so every
+ * column starts on a cache line and vector loads never split one at the head
+ */
+template <typename T>
+struct CacheLineAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t ALIGNMENT{64};
+
+    CacheLineAllocator() = default;
+    template <typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), ALIGNMENT)); }
+    void deallocate(T* ptr, size_t) { ::operator delete(ptr, ALIGNMENT); }
+
+    template <typename U>
+    bool operator==(const CacheLineAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using AlignedColumn = std::vector<T, CacheLineAllocator<T>>;
+
+/**
+ * @brief Structure-of-arrays view of one symbol's entries
+ *
+ * Values, priorities and deadlines live in separate contiguous columns so a
+ * scan over one field streams only that field through the cache and maps
+ * directly onto vector lanes. A fourth column keeps the Node each entry
+ * came from. Removal swaps the last entry into the hole, so order is not
+ * preserved. Not thread-safe on its own.
+ */
+class SymbolColumns {
+public:
+    void append(Node* node);
+    void remove_at(size_t index);
+    // indices must be ascending, as the select kernels produce them
+    void remove_indices(const uint32_t* indices, size_t count);
+
+    size_t size() const { return nodes_.size(); }
+    bool empty() const { return nodes_.empty(); }
+    void set_priority(size_t index, int32_t priority) { priorities_[index] = priority; }
+
+    const double* values() const { return values_.data(); }
+    const int32_t* priorities() const { return priorities_.data(); }
+    const uint64_t* deadlines() const { return deadlines_.data(); }
+    const void* const* slots() const { return reinterpret_cast<const void* const*>(nodes_.data()); }
+    Node* node(size_t index) const { return nodes_[index]; }
+
+private:
+    AlignedColumn<double> values_;
+    AlignedColumn<int32_t> priorities_;
+    AlignedColumn<uint64_t> deadlines_;
+    AlignedColumn<Node*> nodes_;
+};
+
+/**
+ * @brief Vectorized scans over a per-symbol column store of caller-owned nodes
+ *
+ * Nodes are registered with vectorized_insert_batch and stay owned by the
+ * caller; expiry hands the expired ones back rather than freeing them. The
+ * kernel tier is picked once at construction from the running CPU (or
+ * forced lower for comparisons). Each symbol's columns sit behind their own
+ * SpinLock, so operations on different symbols never contend.
  */
 class SIMDOperations {
 public:
     explicit SIMDOperations(const CacheConfig& config);
+    SIMDOperations(const CacheConfig& config, SIMDLevel level);
     ~SIMDOperations() = default;
 
+    SIMDOperations(const SIMDOperations&) = delete;
+    SIMDOperations& operator=(const SIMDOperations&) = delete;
+
     // Batch operations
+    bool insert(Node* node);
     void vectorized_insert_batch(const std::vector<Node*>& nodes);
-    void vectorized_priority_update(const std::vector<std::pair<Node*, int>>& updates);
-    void vectorized_expiry_check();
-    void vectorized_value_calculation();
-    
+    // Returns how many of the nodes were found; each found node's priority is updated too
+    size_t vectorized_priority_update(const std::vector<std::pair<Node*, int>>& updates);
+    // Drops every node past its deadline and returns them to the caller
+    std::vector<Node*> vectorized_expiry_check(uint64_t now_ns = CoarseClock::now());
+    bool remove(Node* node);
+
     // SIMD-enabled search operations
     std::vector<Node*> vectorized_search_by_symbol(const std::string& symbol);
     std::vector<Node*> vectorized_search_by_value_range(double min_value, double max_value);
+    std::vector<Node*> vectorized_search_by_value_range(SymbolId symbol, double min_value, double max_value);
     std::vector<Node*> vectorized_search_by_priority_range(int min_priority, int max_priority);
-    
+    std::vector<Node*> vectorized_search_by_priority_range(SymbolId symbol, int min_priority, int max_priority);
+    // Highest-priority node for the symbol; take_ also removes it from the store
+    Node* vectorized_highest_priority(SymbolId symbol);
+    Node* take_highest_priority(SymbolId symbol);
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    SIMDLevel level() const { return kernels_.level; }
+
     // Performance monitoring
+    // Share of scanned elements handled in full vector lanes rather than scalar tails
     double get_simd_utilization() const;
     size_t get_vectorized_operations_count() const;
     void reset_performance_counters();
 
 private:
+    struct SymbolStore {
+        SpinLock lock;
+        SymbolColumns columns;
+    };
+
     CacheConfig config_;
+    const SIMDKernels& kernels_;
+    DenseSymbolMap<SymbolStore> stores_;
+    std::atomic<size_t> size_{0};
     std::atomic<size_t> vectorized_ops_count_{0};
     std::atomic<size_t> total_ops_count_{0};
-    
-    // SIMD helper methods
-    bool check_avx_support() const;
-    bool check_avx2_support() const;
-    bool check_avx512_support() const;
-    
-    // Vectorized implementations
-    void vectorized_insert_avx2(const std::vector<Node*>& nodes);
-    void vectorized_insert_avx512(const std::vector<Node*>& nodes);
-    void vectorized_priority_update_avx2(const std::vector<std::pair<Node*, int>>& updates);
-    void vectorized_expiry_check_avx2();
-    
-    // Memory alignment helpers
-    void* aligned_alloc(size_t size, size_t alignment);
-    void aligned_free(void* ptr);
-    
-    // SIMD data structures
-    struct AlignedNode {
-        alignas(32) double value;
-        alignas(32) int priority;
-        alignas(32) uint64_t timestamp;
-        alignas(32) uint64_t expiry;
-        alignas(32) char symbol[32];
-    };
+
+    void record_scan(size_t elements, size_t element_bytes);
+    template <typename Fn>
+    void for_each_store(Fn&& fn);
+    template <typename Select>
+    void collect(SymbolStore& store, Select&& select, std::vector<Node*>& out);
 };
 
 /**
- * @brief SIMD-enabled cache with vectorized operations
+ * @brief Kernel timings for one tier against the scalar tier
+ */
+struct SIMDBenchmarkResult {
+    SIMDLevel level;
+    size_t elements;
+    double scalar_ns[4];   // expiry scan, value range, priority range, argmax
+    double vector_ns[4];
+
+    double speedup(size_t kernel) const { return scalar_ns[kernel] / vector_ns[kernel]; }
+    // Geometric mean across the four kernels
+    double mean_speedup() const;
+};
+
+/**
+ * @brief Times every column kernel on synthetic columns of the given size
+ */
+SIMDBenchmarkResult benchmark_simd_kernels(SIMDLevel level, size_t elements = 4096, size_t rounds = 200);
+
+/**
+ * @brief Priority cache whose per-symbol storage is the SIMD column store
+ *
+ * Nodes come from a fixed NodePool. A node returned by get_highest_priority
+ * or get_batch follows the RadialCircularList contract: it stays readable
+ * while the caller holds an EpochGuard.
  */
 class SIMDCache {
 public:
     explicit SIMDCache(const CacheConfig& config);
+    SIMDCache(const CacheConfig& config, SIMDLevel level);
     ~SIMDCache();
 
     // Core operations with SIMD optimization
+    bool insert(double value, SymbolId symbol, int priority, double expiry_seconds = 60.0);
     bool insert(double value, const std::string& symbol, int priority, double expiry_seconds = 60.0);
+    Node* get_highest_priority(SymbolId symbol);
     Node* get_highest_priority(const std::string& symbol);
     bool remove(const std::string& symbol, double value);
-    
+
     // Batch operations
     bool insert_batch(const std::vector<std::tuple<double, std::string, int, double>>& items);
+    // Looks up (symbol, value) pairs without removing them; misses come back as nullptr
     std::vector<Node*> get_batch(const std::vector<std::pair<std::string, double>>& keys);
-    
-    // SIMD-specific operations
-    void optimize_for_simd();
-    void vectorize_data_layout();
+
+    // Removes expired entries and returns their slots to the pool
+    size_t expire(uint64_t now_ns = CoarseClock::now());
+
+    size_t size() const { return simd_ops_->size(); }
+    SIMDOperations& operations() { return *simd_ops_; }
+
+    // Measured speedup of this cache's kernel tier over scalar, from
+    // benchmark_simd_kernels; 1.0 on the scalar tier. Computed on first call.
     double get_simd_performance_improvement() const;
 
 private:
     CacheConfig config_;
+    NodePool pool_;
     std::unique_ptr<SIMDOperations> simd_ops_;
-    std::vector<AlignedNode> aligned_nodes_;
-    
-    // SIMD optimization
-    void align_data_for_simd();
-    void reorder_data_for_cache_locality();
+    mutable std::atomic<double> performance_improvement_{0.0};
 };
 
-} // namespace hft_cache 
\ No newline at end of file
+} // namespace hft_cache
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "node.hpp"
+#include "config.hpp"
+#include "symbol_registry.hpp"
+#include "magazine_cache.hpp"
+#include <string>
 #include <atomic>
 #include <vector>
-#include <random>
 #include <memory>
 #include <cstdint>
 
@@ -12,92 +15,201 @@ namespace hft_cache {
 constexpr int MAX_LEVEL = 32;
 
 /**
- * @brief Lock-free skip list node
+ * @brief Skip list tower: the entry, its ordering key and level next pointers
+ *
+ * Towers are allocated to fit their height, so next has level entries
+ * even though only the first is declared; SkipTowerArena sizes them. The
+ * low bit of a next word marks this tower as deleted at that level, and a
+ * mark on next[0] is what makes the entry logically gone. symbol and
+ * priority are copied from data at insert, so a search compares keys
+ * without touching the Node.
  */
 struct SkipNode {
+    static constexpr uintptr_t MARK = 1;
+
     Node* data;
-    std::atomic<SkipNode*> next[MAX_LEVEL];
+    SymbolId symbol;
+    int32_t priority;
     int level;
-    
-    SkipNode(Node* node_data, int node_level) 
-        : data(node_data), level(node_level) {
-        for (int i = 0; i < MAX_LEVEL; ++i) {
-            next[i].store(nullptr);
-        }
+    // Inserter and remover each add one when done with the tower; the second retires it
+    std::atomic<uint32_t> handoffs{0};
+    std::atomic<uintptr_t> next[1];
+
+    SkipNode(Node* node_data, int node_level)
+        : data(node_data), symbol(node_data ? node_data->symbol : INVALID_SYMBOL_ID),
+          priority(node_data ? node_data->priority : 0), level(node_level) {}
+
+    static constexpr size_t bytes_for(int level) {
+        return sizeof(SkipNode) + static_cast<size_t>(level - 1) * sizeof(std::atomic<uintptr_t>);
     }
-    
-    ~SkipNode() = default;
+    static SkipNode* pointer(uintptr_t word) { return reinterpret_cast<SkipNode*>(word & ~MARK); }
+    static bool marked(uintptr_t word) { return (word & MARK) != 0; }
+    static uintptr_t word(const SkipNode* node) { return reinterpret_cast<uintptr_t>(node); }
+
+    bool deleted() const { return marked(next[0].load(std::memory_order_acquire)); }
+};
+
+/**
+ * @brief Slab arena for skip list towers, one MagazinePool per height class
+ *
+ * Heights round up to a power of two (1, 2, 4 ... MAX_LEVEL), so a tower
+ * wastes at most half its pointers instead of carrying all MAX_LEVEL of
+ * them. One arena serves every list in the process: retired towers are
+ * freed from an EpochManager deleter, which cannot name the list they came
+ * from. It is never destroyed, so such frees stay safe at exit.
+ */
+class SkipTowerArena {
+public:
+    static constexpr int CLASSES = 6;
+
+    static SkipTowerArena& global();
+
+    // nullptr once the class's pool is exhausted
+    SkipNode* create(Node* data, int level);
+    void destroy(SkipNode* tower);
+
+    // Carves level-1 towers up front, the height three in four draw
+    void reserve(size_t towers);
+    // Hands this thread's cached towers back to the shared depots
+    void flush();
+
+    static int class_of(int level);
+
+private:
+    template <int Height>
+    struct Storage {
+        alignas(SkipNode) unsigned char bytes[SkipNode::bytes_for(Height)];
+    };
+
+    MagazinePool<Storage<1>> height_1_{64, 4096};
+    MagazinePool<Storage<2>> height_2_{32, 1024};
+    MagazinePool<Storage<4>> height_4_{16, 256};
+    MagazinePool<Storage<8>> height_8_{8, 64};
+    MagazinePool<Storage<16>> height_16_{4, 16};
+    MagazinePool<Storage<32>> height_32_{4, 16};
+
+    SkipTowerArena() = default;
 };
 
 /**
  * @brief Lock-free skip list for efficient priority-based operations
- * 
- * Provides O(log n) average time complexity for insert, delete, and search operations
- * while maintaining thread safety through lock-free techniques.
+ *
+ * Entries are ordered by symbol, then priority from highest, with the
+ * Node's address breaking ties, so a symbol's entries are contiguous and its
+ * best ones come first: get_highest_priority and get_top_n are one descent
+ * to the symbol followed by a walk along level 0, and a priority range is a
+ * descent to its upper bound. Lookups by value or time walk the symbol's
+ * entries from there.
+ *
+ * Inserts link a tower bottom-up with CAS and removes mark it top-down, in
+ * the style of Fraser and Herlihy-Shavit; searches that meet a marked tower
+ * unlink it, and readers never write. The list owns the Nodes inserted into
+ * it: a removed entry's Node and tower are handed to
+ * EpochManager::retire, so a pointer returned by a lookup or scan stays
+ * valid while the caller holds an EpochGuard. Tower heights come from a
+ * per-thread xorshift generator with p = 1/4. clear, the destructor and
+ * Iterator must not race with other operations.
  */
 class LockFreeSkipList {
 public:
     explicit LockFreeSkipList(const CacheConfig& config);
     ~LockFreeSkipList();
 
-    // Core operations
+    LockFreeSkipList(const LockFreeSkipList&) = delete;
+    LockFreeSkipList& operator=(const LockFreeSkipList&) = delete;
+
+    // Core operations; the string overloads resolve through
+    // SymbolRegistry::global(). insert fails for a Node already in the list
+    // or without a symbol; find and remove act on the symbol's
+    // highest-priority entry with that value.
     bool insert(Node* node);
+    Node* find(SymbolId symbol, double value);
     Node* find(const std::string& symbol, double value);
+    bool remove(SymbolId symbol, double value);
     bool remove(const std::string& symbol, double value);
     void clear();
-    
-    // Priority-based operations
+
+    // Priority-based operations, highest priority first. Nothing is
+    // removed. The buffer overload writes at most n nodes and never
+    // allocates.
+    Node* get_highest_priority(SymbolId symbol);
     Node* get_highest_priority(const std::string& symbol);
+    size_t get_top_n(SymbolId symbol, size_t n, Node** out);
+    std::vector<Node*> get_top_n(SymbolId symbol, size_t n);
     std::vector<Node*> get_top_n(const std::string& symbol, size_t n);
+    std::vector<Node*> get_by_priority_range(SymbolId symbol, int min_priority, int max_priority);
     std::vector<Node*> get_by_priority_range(const std::string& symbol, int min_priority, int max_priority);
-    
-    // Range queries
+
+    // Range queries; these filter the symbol's entries, in priority order
+    std::vector<Node*> get_range(SymbolId symbol, double min_value, double max_value);
     std::vector<Node*> get_range(const std::string& symbol, double min_value, double max_value);
+    std::vector<Node*> get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time);
     std::vector<Node*> get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time);
-    
+
     // Statistics
     size_t size() const;
     int get_max_level() const;
     double get_average_level() const;
-    
-    // Iteration
+
+    // Walks level 0 in key order, skipping deleted entries; not safe
+    // against concurrent writers
     class Iterator {
     public:
-        Iterator(SkipNode* current);
+        explicit Iterator(SkipNode* current);
         Iterator& operator++();
         Node* operator*();
         bool operator!=(const Iterator& other) const;
-        
+
     private:
         SkipNode* current_;
+        void skip_deleted();
     };
-    
+
     Iterator begin();
     Iterator end();
 
+    // Checks key order on every level, tower heights and the entry count; for tests
+    bool validate_skip_list() const;
+
+protected:
+    // A tower for data that is not linked anywhere yet
+    SkipNode* allocate_tower(Node* data, int level);
+    void release_tower(SkipNode* tower);
+
 private:
+    struct Key {
+        SymbolId symbol;
+        int32_t priority;
+        const Node* data;
+    };
+
     CacheConfig config_;
     SkipNode* head_;
-    SkipNode* tail_;
     std::atomic<size_t> size_{0};
     std::atomic<int> max_level_{1};
-    
-    // Random number generation for level assignment
-    mutable std::mt19937 rng_;
-    mutable std::uniform_real_distribution<double> dist_;
-    
+    std::atomic<size_t> total_levels_{0};
+
     // Helper methods
-    int random_level() const;
-    SkipNode* find_node(const std::string& symbol, double value, SkipNode** update = nullptr);
-    bool insert_node(SkipNode* new_node, SkipNode** update);
-    bool remove_node(const std::string& symbol, double value, SkipNode** update);
-    
+    static int random_level();
+    static bool before(const SkipNode* node, const Key& key);
+    // Fills preds and succs for the lowest levels levels, unlinking marked
+    // towers on the way; true if succs[0] holds key.data
+    bool find_node(const Key& key, SkipNode** preds, SkipNode** succs, int levels);
+    bool insert_node(SkipNode* tower);
+    // Marks tower top-down; true for the caller whose mark deleted it
+    static bool mark_tower(SkipNode* tower);
+    void finish(SkipNode* tower);
+    // Calls visit(tower) for live entries in key order from the first not
+    // below key until it returns false; the caller holds an EpochGuard
+    template <typename Visit>
+    void walk(const Key& from, Visit&& visit) const;
+    template <typename Keep>
+    std::vector<Node*> collect(SymbolId symbol, int max_priority, Keep&& keep) const;
+
     // Memory management
-    void cleanup_node(SkipNode* node);
     void cleanup_all_nodes();
-    
+
     // Validation
-    bool validate_skip_list() const;
     void print_skip_list() const;
 };
 
@@ -110,7 +222,9 @@ public:
     
     // Thread-safe operations with additional guarantees
     bool insert_thread_safe(Node* node);
+    Node* find_thread_safe(SymbolId symbol, double value);
     Node* find_thread_safe(const std::string& symbol, double value);
+    bool remove_thread_safe(SymbolId symbol, double value);
     bool remove_thread_safe(const std::string& symbol, double value);
     
 private:
@@ -127,17 +241,14 @@ public:
     ~PooledSkipList();
     
     // Memory pool operations
+    // Towers come from SkipTowerArena, as the base list's do; these expose
+    // it for callers that build towers by hand
     SkipNode* allocate_node(Node* data, int level);
     void deallocate_node(SkipNode* node);
     void defragment_pool();
-    
+
 private:
-    std::vector<std::vector<SkipNode*>> node_pools_; // Pool per level
-    std::atomic<size_t> pool_index_{0};
     size_t pool_size_;
-    
-    void initialize_pools();
-    void cleanup_pools();
 };
 
 } // namespace hft_cache 
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Non-owning view of a contiguous array, the C++17 stand-in for std::span.
+// Lets batch APIs take the caller's buffers, whether a std::vector, a C
+// array or a pointer into a packet, without copying or allocating.
+template <typename T>
+class Span {
+private:
+    // U arrays can be viewed as T: the same type, or T adds const
+    template <typename U>
+    using Compatible = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>;
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    constexpr Span() = default;
+    constexpr Span(T* data, size_t size) : data_(data), size_(size) {}
+    template <typename U, size_t N, typename = Compatible<U>>
+    constexpr Span(U (&array)[N]) : data_(array), size_(N) {}
+    template <typename U, typename = Compatible<U>>
+    Span(std::vector<U>& vector) : data_(vector.data()), size_(vector.size()) {}
+    template <typename U, typename = Compatible<const U>>
+    Span(const std::vector<U>& vector) : data_(vector.data()), size_(vector.size()) {}
+    template <typename U, typename = Compatible<U>>
+    constexpr Span(Span<U> other) : data_(other.data()), size_(other.size()) {}
+
+    constexpr T* data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr T& operator[](size_t index) const { return data_[index]; }
+    constexpr T* begin() const { return data_; }
+    constexpr T* end() const { return data_ + size_; }
+
+    constexpr Span subspan(size_t offset, size_t count) const { return Span(data_ + offset, count); }
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SPIN_LOCK_HPP
+#define SPIN_LOCK_HPP
+
+#include <atomic>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Test-and-test-and-set lock for critical sections of a few dozen
+// instructions. Waiters spin on a plain load so the line stays shared, and
+// fall back to yielding after SPINS_BEFORE_YIELD rounds so an oversubscribed
+// core does not starve a preempted holder. Satisfies Lockable, so it works
+// with std::lock_guard and std::unique_lock.
+class SpinLock {
+private:
+    static constexpr int SPINS_BEFORE_YIELD = 64;
+    std::atomic<bool> locked_{false};
+
+public:
+    bool try_lock() {
+        return !locked_.load(std::memory_order_relaxed) &&
+               !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void lock() {
+        int spins = 0;
+        while (!try_lock()) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                if (++spins < SPINS_BEFORE_YIELD) {
+                    cpu_relax();
+                } else {
+                    spins = 0;
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    void unlock() { locked_.store(false, std::memory_order_release); }
+};
+
+#endif
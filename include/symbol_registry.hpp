@@ -0,0 +1,90 @@
+#ifndef SYMBOL_REGISTRY_HPP
+#define SYMBOL_REGISTRY_HPP
+
+#include "lockfree_map.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Dense integer handle for an interned ticker. Ids are assigned 0, 1, 2, ...
+// in interning order and are only meaningful within one process.
+using SymbolId = uint32_t;
+constexpr SymbolId INVALID_SYMBOL_ID = UINT32_MAX;
+
+// Interns ticker strings into dense SymbolIds.
+//
+// The string -> id direction is a LockFreeHashTable, so find() and a repeated
+// intern() never lock. New ids are handed out under mutex_; the name is stored
+// before the id is published, so any thread that observes an id can call
+// name() on it. Names live in fixed-size chunks that never move, which keeps
+// name() a two-load lookup with no locking.
+class SymbolRegistry {
+public:
+    static constexpr size_t CHUNK_BITS = 12;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t MAX_CHUNKS = 1024;
+    static constexpr size_t MAX_SYMBOLS = CHUNK_SIZE * MAX_CHUNKS;
+
+    explicit SymbolRegistry(size_t initial_capacity = 1024) : ids_(initial_capacity) {
+        for (auto& chunk : names_) chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~SymbolRegistry() {
+        for (auto& chunk : names_) delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    SymbolRegistry(const SymbolRegistry&) = delete;
+    SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+    // Returns the id for name, assigning the next free id on first sight.
+    SymbolId intern(const std::string& name) {
+        if (const SymbolId* id = ids_.get(name)) return *id;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const SymbolId* id = ids_.get(name)) return *id;
+
+        SymbolId id = count_.load(std::memory_order_relaxed);
+        if (id >= MAX_SYMBOLS) throw std::length_error("SymbolRegistry is full");
+        std::string* chunk = names_[id >> CHUNK_BITS].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new std::string[CHUNK_SIZE];
+            names_[id >> CHUNK_BITS].store(chunk, std::memory_order_release);
+        }
+        chunk[id & (CHUNK_SIZE - 1)] = name;
+        count_.store(id + 1, std::memory_order_release);
+        ids_.get_or_create(name, id);
+        return id;
+    }
+
+    // Returns the id for name, or INVALID_SYMBOL_ID if it was never interned.
+    SymbolId find(const std::string& name) const {
+        const SymbolId* id = ids_.get(name);
+        return id ? *id : INVALID_SYMBOL_ID;
+    }
+
+    // Returns the ticker for id; an empty string for ids never handed out.
+    const std::string& name(SymbolId id) const {
+        static const std::string unknown;
+        if (id >= count_.load(std::memory_order_acquire)) return unknown;
+        return names_[id >> CHUNK_BITS].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+    }
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+
+    // Process-wide registry shared by every cache structure.
+    static SymbolRegistry& global() {
+        static SymbolRegistry registry;
+        return registry;
+    }
+
+private:
+    LockFreeHashTable<SymbolId> ids_;
+    std::atomic<std::string*> names_[MAX_CHUNKS];
+    std::atomic<SymbolId> count_{0};
+    std::mutex mutex_;
+};
+
+#endif
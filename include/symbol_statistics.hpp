@@ -0,0 +1,86 @@
+#ifndef SYMBOL_STATISTICS_HPP
+#define SYMBOL_STATISTICS_HPP
+
+#include "cache_observer.hpp"
+#include "dense_symbol_map.hpp"
+#include "quantile_sketch.hpp"
+#include "seqlock.hpp"
+#include "spin_lock.hpp"
+#include <cstddef>
+
+// Aggregates over the values a cache currently holds for one symbol.
+// Weighted average uses priority + 1 as the weight, so priority 0 still
+// counts. median is within the sketch's relative accuracy; min and max are
+// exact until the current extreme is removed, after which they fall back to
+// the midpoint of the sketch bucket holding the new extreme, and stay
+// approximate until a value beyond it arrives. min_exact and max_exact say
+// which you have.
+struct SymbolSummary {
+    size_t count;
+    double sum;
+    double average;
+    double median;
+    double std_deviation;  // sample standard deviation, 0 below two values
+    double min_value;
+    double max_value;
+    double weighted_average;
+    bool min_exact;        // false: min_value is a sketch estimate
+    bool max_exact;        // false: max_value is a sketch estimate
+};
+
+// Per-symbol running statistics, maintained incrementally as nodes enter
+// and leave a cache.
+//
+// Values must be positive for median and the approximate extremes to mean
+// anything: the QuantileSketch clamps everything at or below
+// QuantileSketch::MIN_VALUE into one bucket. Count, sum, mean, deviation
+// and exact extremes are unaffected.
+//
+// Mean and variance use Welford's update, run backwards on removal, and
+// reset exactly whenever a symbol drains so rounding cannot accumulate
+// across bursts. Writers for a symbol serialize on its SpinLock and publish
+// a finished SymbolSummary through a SeqLock, so summary() is a dense index
+// plus a seqlock read: constant time, no locking and no allocation, cheap
+// enough to poll for every symbol in the universe.
+class SymbolStatistics : public CacheObserver {
+public:
+    SymbolStatistics() = default;
+
+    SymbolStatistics(const SymbolStatistics&) = delete;
+    SymbolStatistics& operator=(const SymbolStatistics&) = delete;
+
+    void add(SymbolId symbol, double value, int32_t priority);
+    void remove(SymbolId symbol, double value, int32_t priority);
+
+    void on_insert(const Node& node) override { add(node.symbol, node.value, node.priority); }
+    void on_remove(const Node& node) override { remove(node.symbol, node.value, node.priority); }
+
+    // All zero for a symbol never seen
+    SymbolSummary summary(SymbolId symbol) const {
+        const Entry* entry = entries_.get(symbol);
+        return entry ? entry->published.load() : SymbolSummary{};
+    }
+
+private:
+    struct Entry {
+        SpinLock lock;
+        size_t count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        double sum = 0.0;
+        double weighted_sum = 0.0;
+        double total_weight = 0.0;
+        double min_value = 0.0;
+        double max_value = 0.0;
+        bool min_exact = false;
+        bool max_exact = false;
+        QuantileSketch sketch;
+        SeqLock<SymbolSummary> published;
+
+        void publish();
+    };
+
+    DenseSymbolMap<Entry> entries_;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include "symbol_registry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel of (symbol, deadline) entries.
+//
+// Time is cut into ticks of 2^TICK_SHIFT ns (about a millisecond). Level 0
+// has one slot per tick for the next 64 ticks; each higher level has
+// slots 64 times coarser. An entry goes in the lowest level that still
+// covers its deadline. When a coarse slot comes due, its entries are
+// cascaded back down, so schedule and advance cost O(1) per entry no
+// matter how far out the deadline is. Deadlines past the top level wait
+// in an overflow list that is re-filed each time the top level wraps.
+//
+// An entry fires on the first tick after its deadline, never before.
+// Not thread-safe; ExpiryEngine drives it from one thread.
+class TimerWheel {
+public:
+    struct Entry {
+        uint64_t deadline_ns;
+        SymbolId symbol;
+    };
+
+    static constexpr unsigned TICK_SHIFT = 20;
+    static constexpr unsigned LEVEL_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << LEVEL_BITS;
+    static constexpr size_t LEVELS = 4;
+
+private:
+    std::vector<Entry> slots_[LEVELS][SLOTS];
+    std::vector<Entry> overflow_;
+    uint64_t current_tick_;
+    size_t size_ = 0;
+
+    static uint64_t tick_of(uint64_t deadline_ns) { return (deadline_ns >> TICK_SHIFT) + 1; }
+
+    // Places an entry whose tick is still ahead of current_tick_
+    void place(const Entry& entry, uint64_t tick) {
+        for (size_t level = 0; level < LEVELS; ++level) {
+            unsigned above = LEVEL_BITS * (level + 1);
+            if (((tick ^ current_tick_) >> above) == 0) {
+                slots_[level][(tick >> (LEVEL_BITS * level)) & (SLOTS - 1)].push_back(entry);
+                return;
+            }
+        }
+        overflow_.push_back(entry);
+    }
+
+    // Re-files every entry of one slot one level down, or into due if it is now
+    void cascade(std::vector<Entry>& bucket, std::vector<Entry>& due) {
+        std::vector<Entry> entries;
+        entries.swap(bucket);
+        for (const Entry& entry : entries) {
+            uint64_t tick = tick_of(entry.deadline_ns);
+            if (tick <= current_tick_) {
+                due.push_back(entry);
+                --size_;
+            } else {
+                place(entry, tick);
+            }
+        }
+        // Hand the capacity back so steady-state cascades do not allocate
+        entries.clear();
+        if (bucket.empty()) bucket.swap(entries);
+    }
+
+public:
+    explicit TimerWheel(uint64_t now_ns) : current_tick_(now_ns >> TICK_SHIFT) {}
+
+    // Fires at advance(now) for the first now past deadline_ns; entries that
+    // are already due go straight to due.
+    void schedule(SymbolId symbol, uint64_t deadline_ns, std::vector<Entry>& due) {
+        Entry entry{deadline_ns, symbol};
+        uint64_t tick = tick_of(deadline_ns);
+        if (tick <= current_tick_) {
+            due.push_back(entry);
+            return;
+        }
+        place(entry, tick);
+        ++size_;
+    }
+
+    // Appends every entry whose deadline has passed by now_ns to due
+    void advance(uint64_t now_ns, std::vector<Entry>& due) {
+        uint64_t target = now_ns >> TICK_SHIFT;
+        while (current_tick_ < target) {
+            if (size_ == 0) {
+                // Nothing scheduled: jump instead of stepping through idle ticks
+                current_tick_ = target;
+                break;
+            }
+            ++current_tick_;
+            if ((current_tick_ & ((uint64_t(1) << (LEVEL_BITS * LEVELS)) - 1)) == 0) {
+                cascade(overflow_, due);
+            }
+            for (size_t level = LEVELS - 1; level > 0; --level) {
+                uint64_t span = uint64_t(1) << (LEVEL_BITS * level);
+                if ((current_tick_ & (span - 1)) == 0) {
+                    cascade(slots_[level][(current_tick_ >> (LEVEL_BITS * level)) & (SLOTS - 1)], due);
+                }
+            }
+            std::vector<Entry>& bucket = slots_[0][current_tick_ & (SLOTS - 1)];
+            due.insert(due.end(), bucket.begin(), bucket.end());
+            size_ -= bucket.size();
+            bucket.clear();
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef WRITE_AHEAD_LOG_HPP
+#define WRITE_AHEAD_LOG_HPP
+
+#include "spin_lock.hpp"
+#include "symbol_registry.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Binary write-ahead log of cache inserts and removals.
+//
+// Each logging thread gets a single-producer ring, so append is a copy
+// and one release store: no lock, no allocation. A flusher thread does
+// group commit. Every group_commit_us it drains every ring, orders the
+// batch by timestamp and writes it as one checksummed frame with a single
+// write(). About every fsync_batch frames it calls fdatasync. sync()
+// forces both and returns once everything appended before the call is on
+// disk. A full ring makes its producer wait for the flusher, which is the
+// only time logging blocks.
+//
+// Segments are files named wal-<seq>.log that roll at segment_bytes. A
+// segment names each symbol the first time it uses it, so it replays
+// without the ones before it. Recovery stops at the first frame that fails
+// its checksum, which drops a torn tail. Timestamps are whatever the
+// caller logs; replay filters on them and truncate_before drops on them.
+class WriteAheadLog {
+public:
+    enum Kind : uint16_t {
+        INSERT = 1,
+        REMOVE = 2,
+    };
+
+    struct Entry {
+        uint64_t timestamp_ns;
+        double value;
+        uint64_t ttl_ns;  // time to live from timestamp_ns, inserts only
+        int32_t priority;
+        uint16_t kind;
+        uint16_t reserved;
+        SymbolId symbol;
+        uint32_t reserved2;
+    };
+
+    struct Options {
+        size_t buffer_entries = 4096;
+        size_t group_commit_us = 1000;
+        size_t fsync_batch = 16;
+        size_t segment_bytes = 64 << 20;
+    };
+
+    struct Stats {
+        uint64_t entries = 0;
+        uint64_t frames = 0;
+        uint64_t fsyncs = 0;
+        uint64_t bytes = 0;
+        uint64_t segments = 0;
+        uint64_t producer_waits = 0;  // appends that found their ring full
+    };
+
+    WriteAheadLog(const std::string& directory, const Options& options);
+    // Commits and syncs whatever is still buffered
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    void append(const Entry& entry);
+    bool sync();
+    // Seals the active segment; the next frame starts a new one
+    void roll();
+    // Deletes sealed segments whose newest entry is at or before timestamp
+    size_t truncate_before(uint64_t timestamp);
+
+    Stats stats() const;
+    const std::string& directory() const { return directory_; }
+
+    // Calls fn for every entry in directory with after < timestamp <= until,
+    // oldest segment first, with symbol mapped to this process's id
+    static size_t replay(const std::string& directory, uint64_t after, uint64_t until,
+                         const std::function<void(const Entry&)>& fn);
+
+    // Word-at-a-time FNV variant; pieces fed before the last must be
+    // multiples of 8 bytes for the result to match a single pass
+    static uint64_t checksum(uint64_t seed, const uint8_t* data, size_t length);
+    static constexpr uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+
+private:
+    struct alignas(64) ThreadBuffer {
+        std::unique_ptr<Entry[]> entries;
+        size_t mask = 0;
+        alignas(64) std::atomic<uint64_t> head{0};  // written by the producer
+        alignas(64) std::atomic<uint64_t> tail{0};  // written by the flusher
+    };
+
+    static constexpr size_t MAX_BUFFERS = 256;
+
+    std::string directory_;
+    Options options_;
+    uint64_t id_;  // tells thread-local bindings of different logs apart
+
+    std::unique_ptr<ThreadBuffer> buffers_[MAX_BUFFERS];
+    std::atomic<size_t> buffer_count_{0};
+    std::mutex register_mutex_;
+    // Shared by threads past MAX_BUFFERS; producers take overflow_lock_
+    ThreadBuffer overflow_;
+    SpinLock overflow_lock_;
+
+    // Flusher state
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    uint64_t sync_requested_ = 0;
+    uint64_t sync_completed_ = 0;
+    bool wake_ = false;
+    bool roll_requested_ = false;
+    bool stop_ = false;
+    bool last_sync_ok_ = true;
+    std::thread flusher_;
+
+    // Owned by the flusher thread
+    int fd_ = -1;
+    std::atomic<uint64_t> segment_seq_{0};  // also read by truncate_before
+    size_t segment_size_ = 0;
+    size_t frames_since_sync_ = 0;
+    std::vector<bool> defined_;  // symbols named in the active segment
+    std::vector<Entry> batch_;
+    std::vector<uint8_t> frame_;
+
+    std::atomic<uint64_t> entries_{0};
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> fsyncs_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> segments_{0};
+    std::atomic<uint64_t> producer_waits_{0};
+
+    ThreadBuffer* local_buffer();
+    void init_buffer(ThreadBuffer& buffer) const;
+    void wait_for_space(ThreadBuffer& buffer);
+    void flusher_loop();
+    // Drains every ring and writes one frame; syncs if asked or the batch is due
+    bool commit(bool force_sync, bool roll);
+    bool open_segment();
+    void close_segment();
+    std::string segment_path(uint64_t seq) const;
+    static std::vector<std::pair<uint64_t, std::string>> list_segments(const std::string& directory);
+};
+
+#endif
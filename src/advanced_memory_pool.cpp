@@ -0,0 +1,450 @@
+#include "advanced_memory_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <stack>
+
+namespace hft_cache {
+
+namespace {
+
+// First slab; later ones double up to the pool's limit
+constexpr size_t INITIAL_SLAB_NODES = 4096;
+
+bool is_power_of_two(size_t value) { return value && (value & (value - 1)) == 0; }
+
+} // namespace
+
+// AdvancedMemoryPool Implementation
+AdvancedMemoryPool::AdvancedMemoryPool(const CacheConfig& config, int numa_node)
+    : config_(config),
+      nodes_(config.memory_pool_magazine_rounds, std::min(config.max_nodes, INITIAL_SLAB_NODES), config.max_nodes,
+             numa_node) {}
+
+AdvancedMemoryPool::~AdvancedMemoryPool() {
+    clear();
+}
+
+Node* AdvancedMemoryPool::allocate_node() {
+    return nodes_.create(0.0);
+}
+
+void AdvancedMemoryPool::deallocate_node(Node* node) {
+    if (node) nodes_.destroy(node);
+}
+
+void* AdvancedMemoryPool::allocate_aligned(size_t size, size_t alignment) {
+    if (!is_power_of_two(alignment)) return nullptr;
+    std::lock_guard<std::mutex> lock(aligned_mutex_);
+    for (AlignedBlock& block : aligned_blocks_) {
+        if (!block.in_use && block.size >= size && block.alignment >= alignment) {
+            block.in_use = true;
+            return block.ptr;
+        }
+    }
+    void* ptr = ::operator new(size, std::align_val_t(alignment), std::nothrow);
+    if (ptr) aligned_blocks_.push_back(AlignedBlock{ptr, size, alignment, true});
+    return ptr;
+}
+
+void AdvancedMemoryPool::deallocate_aligned(void* ptr) {
+    std::lock_guard<std::mutex> lock(aligned_mutex_);
+    for (AlignedBlock& block : aligned_blocks_) {
+        if (block.ptr == ptr) {
+            block.in_use = false;
+            return;
+        }
+    }
+}
+
+void AdvancedMemoryPool::defragment() {
+    std::lock_guard<std::mutex> lock(aligned_mutex_);
+    defragment_aligned_blocks();
+}
+
+void AdvancedMemoryPool::compact() {
+    release_thread_cache();
+    defragment();
+}
+
+void AdvancedMemoryPool::resize_pool(size_t new_size) {
+    nodes_.set_limit(std::max(new_size, nodes_.carved()));
+}
+
+void AdvancedMemoryPool::clear() {
+    std::lock_guard<std::mutex> lock(aligned_mutex_);
+    for (AlignedBlock& block : aligned_blocks_) {
+        ::operator delete(block.ptr, std::align_val_t(block.alignment));
+    }
+    aligned_blocks_.clear();
+}
+
+void AdvancedMemoryPool::defragment_aligned_blocks() {
+    auto unused = std::remove_if(aligned_blocks_.begin(), aligned_blocks_.end(), [](const AlignedBlock& block) {
+        if (block.in_use) return false;
+        ::operator delete(block.ptr, std::align_val_t(block.alignment));
+        return true;
+    });
+    aligned_blocks_.erase(unused, aligned_blocks_.end());
+}
+
+size_t AdvancedMemoryPool::get_total_allocated() const {
+    return nodes_.stats().allocations;
+}
+
+size_t AdvancedMemoryPool::get_total_deallocated() const {
+    return nodes_.stats().releases;
+}
+
+size_t AdvancedMemoryPool::get_free_list_size() const {
+    MagazineCache::Stats stats = nodes_.stats();
+    size_t live = stats.allocations - std::min(stats.releases, stats.allocations);
+    size_t carved = nodes_.carved();
+    return carved > live ? carved - live : 0;
+}
+
+double AdvancedMemoryPool::get_fragmentation_ratio() const {
+    size_t carved = nodes_.carved();
+    return carved ? static_cast<double>(get_free_list_size()) / carved : 0.0;
+}
+
+size_t AdvancedMemoryPool::get_pool_size() const {
+    return nodes_.limit();
+}
+
+void AdvancedMemoryPool::preallocate(size_t count) {
+    nodes_.reserve(nodes_.carved() + count);
+}
+
+void AdvancedMemoryPool::release_thread_cache() {
+    nodes_.flush();
+}
+
+// NUMAMemoryPool Implementation
+NUMAMemoryPool::NUMAMemoryPool(const CacheConfig& config) : AdvancedMemoryPool(config) {
+    initialize_numa_pools(config);
+}
+
+void NUMAMemoryPool::initialize_numa_pools(const CacheConfig& config) {
+    const std::vector<int>& nodes = NumaTopology::nodes();
+    size_t ids = static_cast<size_t>(NumaTopology::max_node()) + 1;
+    CacheConfig share = config;
+    share.max_nodes = std::max<size_t>(1, config.max_nodes / nodes.size());
+    numa_pools_.resize(ids);
+    numa_allocation_counts_ = std::vector<std::atomic<size_t>>(ids);
+    for (int node : nodes) numa_pools_[node] = std::make_unique<AdvancedMemoryPool>(share, node);
+    if (config.numa_node >= 0) set_preferred_numa_node(config.numa_node);
+}
+
+AdvancedMemoryPool* NUMAMemoryPool::pool_for(int numa_node) const {
+    if (numa_node < 0 || static_cast<size_t>(numa_node) >= numa_pools_.size()) return nullptr;
+    return numa_pools_[numa_node].get();
+}
+
+int NUMAMemoryPool::get_numa_node_for_thread() const {
+    int preferred = preferred_numa_node_.load(std::memory_order_relaxed);
+    return preferred >= 0 ? preferred : NumaTopology::current_node();
+}
+
+Node* NUMAMemoryPool::allocate_node_on_numa(int numa_node) {
+    if (numa_node < 0) numa_node = get_numa_node_for_thread();
+    AdvancedMemoryPool* pool = pool_for(numa_node);
+    if (!pool) return nullptr;
+    Node* node = pool->allocate_node();
+    if (node) numa_allocation_counts_[numa_node].fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+void NUMAMemoryPool::deallocate_node_to_numa(Node* node, int numa_node) {
+    if (!node) return;
+    // numa_node is only a hint; the node goes back to whichever pool carved it
+    AdvancedMemoryPool* pool = pool_for(numa_node);
+    if (!pool || !pool->owns(node)) {
+        pool = nullptr;
+        for (const auto& candidate : numa_pools_) {
+            if (candidate && candidate->owns(node)) {
+                pool = candidate.get();
+                break;
+            }
+        }
+    }
+    if (pool) pool->deallocate_node(node);
+}
+
+int NUMAMemoryPool::get_current_numa_node() const {
+    return NumaTopology::current_node();
+}
+
+void NUMAMemoryPool::set_preferred_numa_node(int numa_node) {
+    preferred_numa_node_.store(pool_for(numa_node) ? numa_node : -1, std::memory_order_relaxed);
+}
+
+size_t NUMAMemoryPool::get_numa_allocation_count(int numa_node) const {
+    if (!pool_for(numa_node)) return 0;
+    return numa_allocation_counts_[numa_node].load(std::memory_order_relaxed);
+}
+
+double NUMAMemoryPool::get_numa_utilization(int numa_node) const {
+    AdvancedMemoryPool* pool = pool_for(numa_node);
+    if (!pool || pool->get_pool_size() == 0) return 0.0;
+    size_t allocated = pool->get_total_allocated();
+    size_t live = allocated - std::min(pool->get_total_deallocated(), allocated);
+    return static_cast<double>(live) / pool->get_pool_size();
+}
+
+// LockFreeMemoryPool Implementation
+LockFreeMemoryPool::LockFreeMemoryPool(const CacheConfig& config) : pool_(config.max_nodes) {}
+
+LockFreeMemoryPool::~LockFreeMemoryPool() = default;
+
+Node* LockFreeMemoryPool::allocate_node_lock_free() {
+    Node* node = pool_.allocate();
+    if (node) allocated_count_.fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+void LockFreeMemoryPool::deallocate_node_lock_free(Node* node) {
+    if (!node) return;
+    pool_.release(node);
+    deallocated_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t LockFreeMemoryPool::get_available_nodes() const {
+    size_t live = allocated_count_.load(std::memory_order_relaxed) - deallocated_count_.load(std::memory_order_relaxed);
+    return live < pool_.capacity() ? pool_.capacity() - live : 0;
+}
+
+size_t LockFreeMemoryPool::get_allocated_nodes() const {
+    return allocated_count_.load(std::memory_order_relaxed);
+}
+
+bool LockFreeMemoryPool::is_empty() const {
+    return get_available_nodes() == 0;
+}
+
+bool LockFreeMemoryPool::is_full() const {
+    return get_available_nodes() == pool_.capacity();
+}
+
+// HierarchicalMemoryPool Implementation
+HierarchicalMemoryPool::HierarchicalMemoryPool(const CacheConfig& config)
+    : config_(config), l1_pool_(std::make_unique<AdvancedMemoryPool>(config)),
+      l2_pool_(std::make_unique<LockFreeMemoryPool>(config)) {}
+
+HierarchicalMemoryPool::~HierarchicalMemoryPool() = default;
+
+Node* HierarchicalMemoryPool::allocate_node() {
+    if (!l1_dry_.load(std::memory_order_relaxed)) {
+        if (Node* node = allocate_node_fast()) return node;
+        l1_dry_.store(true, std::memory_order_relaxed);
+    }
+    if (!l2_dry_.load(std::memory_order_relaxed)) {
+        if (Node* node = allocate_node_standard()) return node;
+        l2_dry_.store(true, std::memory_order_relaxed);
+    }
+    return allocate_node_slow();
+}
+
+Node* HierarchicalMemoryPool::allocate_node_fast() {
+    return l1_pool_->allocate_node();
+}
+
+Node* HierarchicalMemoryPool::allocate_node_standard() {
+    Node* node = l2_pool_->allocate_node_lock_free();
+    if (node) l2_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+Node* HierarchicalMemoryPool::allocate_node_slow() {
+    l3_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return new Node(0.0);
+}
+
+void HierarchicalMemoryPool::deallocate_node(Node* node) {
+    if (!node) return;
+    if (l1_pool_->owns(node)) {
+        l1_pool_->deallocate_node(node);
+        if (l1_dry_.load(std::memory_order_relaxed)) l1_dry_.store(false, std::memory_order_relaxed);
+    } else if (l2_pool_->owns(node)) {
+        l2_pool_->deallocate_node_lock_free(node);
+        if (l2_dry_.load(std::memory_order_relaxed)) l2_dry_.store(false, std::memory_order_relaxed);
+    } else {
+        delete node;
+    }
+}
+
+void HierarchicalMemoryPool::rebalance_pools() {
+    l1_pool_->release_thread_cache();
+    l1_dry_.store(false, std::memory_order_relaxed);
+    l2_dry_.store(false, std::memory_order_relaxed);
+}
+
+HierarchicalMemoryPool::PoolStats HierarchicalMemoryPool::get_pool_statistics() const {
+    PoolStats stats{};
+    stats.l1_allocations = l1_pool_->get_total_allocated();
+    stats.l2_allocations = l2_allocations_.load(std::memory_order_relaxed);
+    stats.l3_allocations = l3_allocations_.load(std::memory_order_relaxed);
+    double total = static_cast<double>(stats.l1_allocations + stats.l2_allocations + stats.l3_allocations);
+    if (total > 0) {
+        stats.l1_hit_rate = stats.l1_allocations / total;
+        stats.l2_hit_rate = stats.l2_allocations / total;
+        stats.l3_hit_rate = stats.l3_allocations / total;
+    }
+    return stats;
+}
+
+// Allocator benchmark
+void AllocationLatencyHistogram::record(uint64_t ns) {
+    size_t bucket;
+    if (ns < 4) {
+        bucket = ns;
+    } else {
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+        bucket = 4 * (exponent - 1) + ((ns >> (exponent - 2)) & 3);
+    }
+    ++counts[std::min(bucket, BUCKETS - 1)];
+    ++samples;
+    total_ns += ns;
+    max_ns = std::max(max_ns, ns);
+}
+
+uint64_t AllocationLatencyHistogram::percentile_ns(double q) const {
+    if (samples == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * (samples - 1));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen > rank) {
+            if (bucket < 4) return bucket + 1;
+            unsigned exponent = static_cast<unsigned>(bucket / 4 + 1);
+            return std::min<uint64_t>((5 + bucket % 4) << (exponent - 2), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+namespace {
+
+void merge(AllocationLatencyHistogram& into, const AllocationLatencyHistogram& from) {
+    for (size_t i = 0; i < AllocationLatencyHistogram::BUCKETS; ++i) into.counts[i] += from.counts[i];
+    into.samples += from.samples;
+    into.total_ns += from.total_ns;
+    into.max_ns = std::max(into.max_ns, from.max_ns);
+}
+
+// Workers take and return batch nodes per round, timing bursts of both;
+// the first round warms caches and is not recorded
+template <typename Allocate, typename Release>
+AllocatorBenchmarkResult run_allocator(const std::string& name, size_t threads, size_t rounds, size_t batch,
+                                       Allocate allocate, Release release) {
+    constexpr size_t BURST = AllocationLatencyHistogram::BURST;
+    using Clock = std::chrono::steady_clock;
+    batch = (batch + BURST - 1) / BURST * BURST;
+
+    AllocatorBenchmarkResult result;
+    result.allocate.allocator = result.release.allocator = name;
+    result.allocate.threads = result.release.threads = threads;
+    std::mutex merge_mutex;
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < threads; ++worker) {
+        workers.emplace_back([&, worker]() {
+            AllocationLatencyHistogram allocated, released;
+            std::vector<Node*> held(batch);
+            for (size_t round = 0; round <= rounds; ++round) {
+                for (size_t i = 0; i < batch; i += BURST) {
+                    auto start = Clock::now();
+                    for (size_t j = 0; j < BURST; ++j) held[i + j] = allocate(worker);
+                    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                    if (round) allocated.record(ns / BURST);
+                }
+                for (size_t i = batch; i > 0; i -= BURST) {
+                    auto start = Clock::now();
+                    for (size_t j = 1; j <= BURST; ++j) release(worker, held[i - j]);
+                    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                    if (round) released.record(ns / BURST);
+                }
+            }
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            merge(result.allocate, allocated);
+            merge(result.release, released);
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    return result;
+}
+
+// What AdvancedMemoryPool's per-thread free lists used to be
+struct MutexFreeList {
+    std::mutex mutex;
+    std::stack<Node*> free_nodes;
+};
+
+} // namespace
+
+std::vector<AllocatorBenchmarkResult> benchmark_node_allocators(size_t threads, size_t rounds, size_t batch) {
+    threads = std::max<size_t>(threads, 1);
+    // Room for every batch plus whatever the magazines hold on to
+    CacheConfig config;
+    config.max_nodes = threads * (batch + 2 * config.memory_pool_magazine_rounds) * 2 + 1024;
+    std::vector<AllocatorBenchmarkResult> results;
+
+    results.push_back(run_allocator("new/delete", threads, rounds, batch,
+                                    [](size_t) { return new Node(0.0); },
+                                    [](size_t, Node* node) { delete node; }));
+
+    {
+        std::vector<Node> slab(config.max_nodes);
+        std::vector<std::unique_ptr<MutexFreeList>> lists;
+        size_t share = config.max_nodes / threads;
+        for (size_t worker = 0; worker < threads; ++worker) {
+            lists.push_back(std::make_unique<MutexFreeList>());
+            for (size_t i = 0; i < share; ++i) lists.back()->free_nodes.push(&slab[worker * share + i]);
+        }
+        results.push_back(run_allocator(
+            "mutex free list", threads, rounds, batch,
+            [&lists](size_t worker) {
+                MutexFreeList& list = *lists[worker];
+                std::lock_guard<std::mutex> lock(list.mutex);
+                Node* node = list.free_nodes.top();
+                list.free_nodes.pop();
+                return node;
+            },
+            [&lists](size_t worker, Node* node) {
+                MutexFreeList& list = *lists[worker];
+                std::lock_guard<std::mutex> lock(list.mutex);
+                list.free_nodes.push(node);
+            }));
+    }
+
+    {
+        LockFreeMemoryPool pool(config);
+        results.push_back(run_allocator("LockFreeMemoryPool", threads, rounds, batch,
+                                        [&pool](size_t) { return pool.allocate_node_lock_free(); },
+                                        [&pool](size_t, Node* node) { pool.deallocate_node_lock_free(node); }));
+    }
+
+    {
+        NodePool pool(config.max_nodes);
+        results.push_back(run_allocator("NodePool", threads, rounds, batch,
+                                        [&pool](size_t) { return pool.allocate(); },
+                                        [&pool](size_t, Node* node) { pool.release(node); }));
+    }
+
+    {
+        NodePool pool(config.max_nodes, config.memory_pool_magazine_rounds);
+        results.push_back(run_allocator("NodePool+magazines", threads, rounds, batch,
+                                        [&pool](size_t) { return pool.allocate(); },
+                                        [&pool](size_t, Node* node) { pool.release(node); }));
+    }
+
+    {
+        AdvancedMemoryPool pool(config);
+        results.push_back(run_allocator("AdvancedMemoryPool", threads, rounds, batch,
+                                        [&pool](size_t) { return pool.allocate_node(); },
+                                        [&pool](size_t, Node* node) { pool.deallocate_node(node); }));
+    }
+
+    return results;
+}
+
+} // namespace hft_cache
@@ -1,209 +1,16 @@
 #include "advanced_operations.hpp"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <algorithm>
 #include <numeric>
 #include <regex>
 #include <unordered_map>
 #include <set>
+#include <tuple>
 
-// RangeOperations implementation
-std::vector<Node*> RangeOperations::get_range(const std::string& symbol, double min_value, double max_value) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would iterate through all nodes for the symbol
-    // and filter by value range using efficient data structures
-    
-    // For now, we'll simulate the behavior
-    // The actual implementation would depend on the cache structure
-    // and would use optimized range queries
-    
-    return results;
-}
-
-std::vector<Node*> RangeOperations::get_by_priority_range(const std::string& symbol, int min_priority, int max_priority) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would use priority-based data structures
-    // like heaps or skip lists for efficient range queries
-    
-    return results;
-}
-
-std::vector<Node*> RangeOperations::get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would use time-based indexing
-    // for efficient temporal range queries
-    
-    return results;
-}
-
-std::vector<Node*> RangeOperations::get_top_n(const std::string& symbol, size_t n) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would use priority queues
-    // or sorted data structures for efficient top-N queries
-    
-    return results;
-}
-
-std::vector<Node*> RangeOperations::get_by_predicate(const std::string& symbol, 
-                                                   std::function<bool(const Node*)> predicate) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would iterate through nodes
-    // and apply the predicate filter
-    
-    return results;
-}
-
-// AggregationOperations implementation
-std::vector<Node*> AggregationOperations::get_all_nodes(const std::string& symbol) {
-    std::vector<Node*> nodes;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would collect all nodes for the symbol
-    // from the cache structure
-    
-    // For demonstration purposes, we'll create some dummy nodes
-    // In reality, this would query the actual cache
-    
-    return nodes;
-}
-
-// SearchOperations implementation
-std::vector<Node*> SearchOperations::search_by_pattern(const std::string& pattern) {
-    std::vector<Node*> results;
-    
-    try {
-        std::regex regex_pattern(pattern);
-        
-        // This is a placeholder implementation
-        // In a real implementation, this would iterate through all symbols
-        // and match against the regex pattern
-        
-        // For demonstration, we'll simulate some matches
-        // In reality, this would query the actual cache
-        
-    } catch (const std::regex_error& e) {
-        std::cerr << "Invalid regex pattern: " << e.what() << std::endl;
-    }
-    
-    return results;
-}
-
-std::vector<Node*> SearchOperations::fuzzy_search(const std::string& query, double threshold) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would use string similarity algorithms
-    // like Levenshtein distance or Jaro-Winkler
-    
-    // For demonstration purposes
-    // In reality, this would implement proper fuzzy matching
-    
-    return results;
-}
-
-std::vector<Node*> SearchOperations::search_by_predicate(std::function<bool(const Node*)> predicate) {
-    std::vector<Node*> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would iterate through all nodes
-    // and apply the predicate filter
-    
-    // For demonstration purposes
-    // In reality, this would query the actual cache
-    
-    return results;
-}
-
-// AdvancedCacheOperations implementation
-SymbolSummary AdvancedCacheOperations::get_symbol_summary(const std::string& symbol) {
-    return {
-        agg_ops_.get_count(symbol),
-        agg_ops_.get_average_value(symbol),
-        agg_ops_.get_median_value(symbol),
-        agg_ops_.get_std_deviation(symbol),
-        agg_ops_.get_min_max(symbol),
-        agg_ops_.get_weighted_average(symbol)
-    };
-}
-
-std::vector<std::pair<std::string, size_t>> AdvancedCacheOperations::get_top_symbols_by_activity(size_t limit) {
-    std::vector<std::pair<std::string, size_t>> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would track symbol activity
-    // and return the most active symbols
-    
-    // For demonstration purposes
-    // In reality, this would query activity metrics
-    
-    return results;
-}
-
-std::vector<std::pair<std::string, double>> AdvancedCacheOperations::get_volatile_symbols(double threshold) {
-    std::vector<std::pair<std::string, double>> results;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would calculate volatility
-    // and return symbols above the threshold
-    
-    // For demonstration purposes
-    // In reality, this would calculate actual volatility metrics
-    
-    return results;
-}
-
-double AdvancedCacheOperations::get_correlation(const std::string& symbol1, const std::string& symbol2) {
-    // This is a placeholder implementation
-    // In a real implementation, this would calculate correlation coefficient
-    // between two symbols' price movements
-    
-    // For demonstration purposes
-    // In reality, this would calculate actual correlation
-    
-    return 0.0;
-}
-
-MarketDepth AdvancedCacheOperations::get_market_depth(const std::string& symbol, size_t levels) {
-    MarketDepth depth;
-    
-    // This is a placeholder implementation
-    // In a real implementation, this would aggregate orders by price level
-    // and return bid/ask depth
-    
-    // For demonstration purposes
-    // In reality, this would query actual order book data
-    
-    return depth;
-}
-
-double AdvancedCacheOperations::get_twap(const std::string& symbol, uint64_t window_ns) {
-    // This is a placeholder implementation
-    // In a real implementation, this would calculate TWAP over the specified window
-    
-    // For demonstration purposes
-    // In reality, this would calculate actual TWAP
-    
-    return 0.0;
-}
-
-double AdvancedCacheOperations::get_vwap(const std::string& symbol, uint64_t window_ns) {
-    // This is a placeholder implementation
-    // In a real implementation, this would calculate VWAP over the specified window
-    
-    // For demonstration purposes
-    // In reality, this would calculate actual VWAP
-    
-    return 0.0;
-}
+// RangeOperations, AggregationOperations, SearchOperations and
+// AdvancedCacheOperations are defined inline in the header.
 
 // Utility functions for advanced operations
 namespace AdvancedOpsUtils {
@@ -1,18 +1,99 @@
 #include "b_tree.hpp"
-#include "memory_manager.hpp"
-#include "metrics.hpp"
-#include "error_handler.hpp"
+#include "epoch_reclamation.hpp"
+#include "spin_lock.hpp"
 #include <iostream>
 #include <algorithm>
-#include <chrono>
+#include <limits>
+#include <new>
+#include <thread>
 
 namespace hft_cache {
 
+namespace {
+
+constexpr double LOWEST_VALUE = -std::numeric_limits<double>::infinity();
+
+// Restarts spin briefly, then yield so a preempted writer can finish
+void back_off(unsigned& restarts) {
+    if (++restarts % 64 == 0) {
+        std::this_thread::yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+} // namespace
+
+// BTreeLeaf / BTreeInner Implementation
+void BTreeLeaf::insert_at(size_t pos, SymbolId symbol, double value, Node* entry) {
+    size_t count_now = size();
+    for (size_t i = count_now; i > pos; --i) {
+        copy_key(i, *this, i - 1);
+        entries[i].store(entries[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    symbols[pos].store(symbol, std::memory_order_relaxed);
+    values[pos].store(value, std::memory_order_relaxed);
+    entries[pos].store(entry, std::memory_order_relaxed);
+    count.store(static_cast<uint32_t>(count_now + 1), std::memory_order_relaxed);
+}
+
+void BTreeLeaf::erase_at(size_t pos) {
+    size_t count_now = size();
+    for (size_t i = pos; i + 1 < count_now; ++i) {
+        copy_key(i, *this, i + 1);
+        entries[i].store(entries[i + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    count.store(static_cast<uint32_t>(count_now - 1), std::memory_order_relaxed);
+}
+
+void BTreeLeaf::split(BTreeLeaf& right, SymbolId& separator_symbol, double& separator_value) {
+    size_t count_now = size();
+    size_t keep = count_now / 2;
+    for (size_t i = keep; i < count_now; ++i) {
+        right.copy_key(i - keep, *this, i);
+        right.entries[i - keep].store(entries[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    right.count.store(static_cast<uint32_t>(count_now - keep), std::memory_order_relaxed);
+    right.next.store(next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    count.store(static_cast<uint32_t>(keep), std::memory_order_relaxed);
+    next.store(&right, std::memory_order_relaxed);
+    separator_symbol = symbols[keep - 1].load(std::memory_order_relaxed);
+    separator_value = values[keep - 1].load(std::memory_order_relaxed);
+}
+
+void BTreeInner::insert_child(size_t slot, SymbolId separator_symbol, double separator_value, BTreeNode* right) {
+    size_t count_now = size();
+    for (size_t i = count_now; i > slot; --i) {
+        copy_key(i, *this, i - 1);
+        children[i + 1].store(children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    symbols[slot].store(separator_symbol, std::memory_order_relaxed);
+    values[slot].store(separator_value, std::memory_order_relaxed);
+    children[slot + 1].store(right, std::memory_order_relaxed);
+    count.store(static_cast<uint32_t>(count_now + 1), std::memory_order_relaxed);
+}
+
+void BTreeInner::split(BTreeInner& right, SymbolId& separator_symbol, double& separator_value) {
+    // The middle key moves up; the halves keep the keys either side of it
+    size_t count_now = size();
+    size_t middle = count_now / 2;
+    for (size_t i = middle + 1; i < count_now; ++i) right.copy_key(i - middle - 1, *this, i);
+    for (size_t i = middle + 1; i <= count_now; ++i) {
+        right.children[i - middle - 1].store(children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    right.count.store(static_cast<uint32_t>(count_now - middle - 1), std::memory_order_relaxed);
+    separator_symbol = symbols[middle].load(std::memory_order_relaxed);
+    separator_value = values[middle].load(std::memory_order_relaxed);
+    count.store(static_cast<uint32_t>(middle), std::memory_order_relaxed);
+}
+
 // LockFreeBTree Implementation
-LockFreeBTree::LockFreeBTree(const CacheConfig& config) 
-    : config_(config) {
-    
-    std::cout << "LockFreeBTree initialized with order " << B_TREE_ORDER << std::endl;
+LockFreeBTree::LockFreeBTree(const CacheConfig& config)
+    : config_(config), leaf_cache_(8, 64), inner_cache_(8, 16) {
+    first_leaf_ = allocate_leaf();
+    if (!first_leaf_) throw std::bad_alloc();
+    root_.store(first_leaf_, std::memory_order_release);
+    height_.store(1);
 }
 
 LockFreeBTree::~LockFreeBTree() {
@@ -21,312 +102,370 @@ LockFreeBTree::~LockFreeBTree() {
 
 bool LockFreeBTree::insert(Node* node) {
     if (!node) return false;
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    try {
-        BTreeNode* root = root_.load();
-        
-        if (!root) {
-            // Create new root
-            root = allocate_node();
-            root->keys[0] = node;
-            root->key_count.store(1);
-            root_.store(root);
-            height_.store(1);
-            size_.fetch_add(1);
-            
-            if (g_metrics) {
-                g_metrics->record_insert(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
-            return true;
-        }
-        
-        // Find leaf node for insertion
-        BTreeNode* leaf = find_leaf(node->symbol, node->value);
-        
-        if (insert_into_leaf(leaf, node)) {
-            size_.fetch_add(1);
-            
-            if (g_metrics) {
-                g_metrics->record_insert(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
-            return true;
-        }
-        
-        return false;
-        
-    } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::INSERTION_FAILED, ErrorSeverity::MEDIUM,
-                std::string("B-tree insert failed: ") + e.what(), __FILE__, __LINE__);
-        }
-        return false;
+    unsigned restarts = 0;
+    while (true) {
+        Attempt attempt = try_insert(node);
+        if (attempt != Attempt::RESTART) return attempt == Attempt::DONE;
+        back_off(restarts);
     }
 }
 
-Node* LockFreeBTree::find(const std::string& symbol, double value) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    try {
-        BTreeNode* current = root_.load();
-        
-        while (current) {
-            size_t i = 0;
-            size_t key_count = current->key_count.load();
-            
-            // Find position in current node
-            while (i < key_count) {
-                if (current->keys[i]) {
-                    if (current->keys[i]->symbol == symbol && current->keys[i]->value == value) {
-                        if (g_metrics) {
-                            g_metrics->record_retrieve(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                                std::chrono::high_resolution_clock::now() - start_time).count());
-                        }
-                        return current->keys[i];
-                    }
-                    
-                    if (current->keys[i]->symbol > symbol || 
-                        (current->keys[i]->symbol == symbol && current->keys[i]->value > value)) {
-                        break;
-                    }
-                }
-                i++;
+LockFreeBTree::Attempt LockFreeBTree::try_insert(Node* entry) {
+    const SymbolId symbol = entry->symbol;
+    const double value = entry->value;
+
+    BTreeNode* node = root_.load(std::memory_order_acquire);
+    uint64_t version;
+    if (!node->read_lock(version) || node != root_.load(std::memory_order_acquire)) return Attempt::RESTART;
+    BTreeInner* parent = nullptr;
+    uint64_t parent_version = 0;
+    size_t parent_slot = 0;
+
+    while (!node->is_leaf) {
+        BTreeInner* inner = static_cast<BTreeInner*>(node);
+        if (inner->full()) {
+            // Split on the way down, so a parent always has room for one more separator
+            if (parent && !parent->upgrade(parent_version)) return Attempt::RESTART;
+            if (!inner->upgrade(version)) {
+                if (parent) parent->unlock();
+                return Attempt::RESTART;
             }
-            
-            // Move to child
-            if (current->is_leaf.load()) {
-                break;
+            if (!parent && inner != root_.load(std::memory_order_acquire)) {
+                inner->unlock();
+                return Attempt::RESTART;
+            }
+            BTreeInner* right = allocate_inner();
+            if (!right) {
+                inner->unlock();
+                if (parent) parent->unlock();
+                return Attempt::FAILED;
+            }
+            SymbolId separator_symbol;
+            double separator_value;
+            inner->split(*right, separator_symbol, separator_value);
+            if (parent) {
+                parent->insert_child(parent_slot, separator_symbol, separator_value, right);
+            } else {
+                grow_root(inner, separator_symbol, separator_value, right);
             }
-            current = current->children[i].load();
+            inner->unlock();
+            if (parent) parent->unlock();
+            return Attempt::RESTART;
         }
-        
-        if (g_metrics) {
-            g_metrics->record_miss(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::high_resolution_clock::now() - start_time).count());
+        if (parent && !parent->validate(parent_version)) return Attempt::RESTART;
+
+        size_t slot = inner->lower_bound(symbol, value);
+        BTreeNode* child = inner->children[slot].load(std::memory_order_relaxed);
+        if (!inner->validate(version)) return Attempt::RESTART;
+        parent = inner;
+        parent_version = version;
+        parent_slot = slot;
+        node = child;
+        if (!node->read_lock(version)) return Attempt::RESTART;
+    }
+
+    BTreeLeaf* leaf = static_cast<BTreeLeaf*>(node);
+    if (leaf->full()) {
+        if (parent && !parent->upgrade(parent_version)) return Attempt::RESTART;
+        if (!leaf->upgrade(version)) {
+            if (parent) parent->unlock();
+            return Attempt::RESTART;
+        }
+        if (!parent && leaf != root_.load(std::memory_order_acquire)) {
+            leaf->unlock();
+            return Attempt::RESTART;
         }
-        
-        return nullptr;
-        
-    } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::RETRIEVAL_FAILED, ErrorSeverity::MEDIUM,
-                std::string("B-tree find failed: ") + e.what(), __FILE__, __LINE__);
+        BTreeLeaf* right = allocate_leaf();
+        if (!right) {
+            leaf->unlock();
+            if (parent) parent->unlock();
+            return Attempt::FAILED;
         }
-        return nullptr;
+        SymbolId separator_symbol;
+        double separator_value;
+        leaf->split(*right, separator_symbol, separator_value);
+        if (parent) {
+            parent->insert_child(parent_slot, separator_symbol, separator_value, right);
+        } else {
+            grow_root(leaf, separator_symbol, separator_value, right);
+        }
+        leaf->unlock();
+        if (parent) parent->unlock();
+        // The retry lands in whichever half now has room
+        return Attempt::RESTART;
     }
-}
 
-bool LockFreeBTree::remove(const std::string& symbol, double value) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    try {
-        BTreeNode* current = root_.load();
-        
-        while (current) {
-            size_t i = 0;
-            size_t key_count = current->key_count.load();
-            
-            // Find position in current node
-            while (i < key_count) {
-                if (current->keys[i] && current->keys[i]->symbol == symbol && 
-                    current->keys[i]->value == value) {
-                    
-                    // Found the node to remove
-                    Node* node_to_remove = current->keys[i];
-                    
-                    if (current->is_leaf.load()) {
-                        // Remove from leaf
-                        for (size_t j = i; j < key_count - 1; ++j) {
-                            current->keys[j] = current->keys[j + 1];
-                        }
-                        current->keys[key_count - 1] = nullptr;
-                        current->key_count.fetch_sub(1);
-                        
-                        delete node_to_remove;
-                        size_.fetch_sub(1);
-                        
-                        if (g_metrics) {
-                            g_metrics->record_remove(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                                std::chrono::high_resolution_clock::now() - start_time).count());
-                        }
-                        return true;
-                    } else {
-                        // Handle internal node removal (simplified)
-                        // In a full implementation, this would involve finding successor/predecessor
-                        return false;
-                    }
+    if (!leaf->upgrade(version)) return Attempt::RESTART;
+    if (parent && !parent->validate(parent_version)) {
+        leaf->unlock();
+        return Attempt::RESTART;
+    }
+    leaf->insert_at(leaf->lower_bound(symbol, value), symbol, value, entry);
+    leaf->unlock();
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return Attempt::DONE;
+}
+
+void LockFreeBTree::grow_root(BTreeNode* left, SymbolId separator_symbol, double separator_value,
+                              BTreeNode* right) {
+    // Called with left locked, which keeps every other writer off the root
+    BTreeInner* root = allocate_inner();
+    if (!root) throw std::bad_alloc();
+    root->symbols[0].store(separator_symbol, std::memory_order_relaxed);
+    root->values[0].store(separator_value, std::memory_order_relaxed);
+    root->children[0].store(left, std::memory_order_relaxed);
+    root->children[1].store(right, std::memory_order_relaxed);
+    root->count.store(1, std::memory_order_relaxed);
+    root_.store(root, std::memory_order_release);
+    height_.fetch_add(1);
+}
+
+BTreeLeaf* LockFreeBTree::seek(SymbolId symbol, double value, uint64_t& version) const {
+    BTreeNode* node = root_.load(std::memory_order_acquire);
+    if (!node->read_lock(version) || node != root_.load(std::memory_order_acquire)) return nullptr;
+    while (!node->is_leaf) {
+        const BTreeInner* inner = static_cast<const BTreeInner*>(node);
+        uint64_t inner_version = version;
+        BTreeNode* child = inner->children[inner->lower_bound(symbol, value)].load(std::memory_order_relaxed);
+        if (!inner->validate(inner_version)) return nullptr;
+        // Checking the parent again after locking the child catches a split
+        // of the child in between
+        if (!child->read_lock(version) || !inner->validate(inner_version)) return nullptr;
+        node = child;
+    }
+    return static_cast<BTreeLeaf*>(node);
+}
+
+template <typename Visit>
+void LockFreeBTree::walk(SymbolId symbol, double value, Visit&& visit) const {
+    // After a restart the walk seeks back to the last key it visited and
+    // skips the entries with that key it has already passed on
+    SymbolId resume_symbol = symbol;
+    double resume_value = value;
+    size_t visited_at_resume = 0;
+    unsigned restarts = 0;
+    while (true) {
+        uint64_t version;
+        const BTreeLeaf* leaf = seek(resume_symbol, resume_value, version);
+        if (!leaf) {
+            back_off(restarts);
+            continue;
+        }
+        size_t pos = leaf->lower_bound(resume_symbol, resume_value);
+        size_t to_skip = visited_at_resume;
+        bool restart = false;
+        while (leaf) {
+            SymbolId symbols[BTreeNode::MAX_KEYS];
+            double values[BTreeNode::MAX_KEYS];
+            Node* nodes[BTreeNode::MAX_KEYS];
+            size_t copied = 0;
+            for (size_t i = pos, count = leaf->size(); i < count; ++i, ++copied) {
+                symbols[copied] = leaf->symbols[i].load(std::memory_order_relaxed);
+                values[copied] = leaf->values[i].load(std::memory_order_relaxed);
+                nodes[copied] = leaf->entries[i].load(std::memory_order_relaxed);
+            }
+            const BTreeLeaf* next = leaf->next.load(std::memory_order_relaxed);
+            if (!leaf->validate(version)) {
+                restart = true;
+                break;
+            }
+
+            for (size_t i = 0; i < copied; ++i) {
+                bool at_resume = symbols[i] == resume_symbol && values[i] == resume_value;
+                if (at_resume && to_skip) {
+                    --to_skip;
+                    continue;
                 }
-                
-                if (current->keys[i] && (current->keys[i]->symbol > symbol || 
-                    (current->keys[i]->symbol == symbol && current->keys[i]->value > value))) {
-                    break;
+                to_skip = 0;
+                if (!visit(symbols[i], values[i], nodes[i])) return;
+                if (at_resume) {
+                    ++visited_at_resume;
+                } else {
+                    resume_symbol = symbols[i];
+                    resume_value = values[i];
+                    visited_at_resume = 1;
                 }
-                i++;
             }
-            
-            // Move to child
-            if (current->is_leaf.load()) {
+            pos = 0;
+            leaf = next;
+            if (leaf && !leaf->read_lock(version)) {
+                restart = true;
                 break;
             }
-            current = current->children[i].load();
         }
-        
+        if (!restart) return;
+        back_off(restarts);
+    }
+}
+
+Node* LockFreeBTree::find(const std::string& symbol, double value) {
+    return find(SymbolRegistry::global().find(symbol), value);
+}
+
+Node* LockFreeBTree::find(SymbolId symbol, double value) {
+    Node* found = nullptr;
+    walk(symbol, value, [&](SymbolId key_symbol, double key_value, Node* node) {
+        if (key_symbol == symbol && key_value == value) found = node;
         return false;
-        
-    } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::REMOVAL_FAILED, ErrorSeverity::MEDIUM,
-                std::string("B-tree remove failed: ") + e.what(), __FILE__, __LINE__);
+    });
+    return found;
+}
+
+bool LockFreeBTree::remove(const std::string& symbol, double value) {
+    return remove(SymbolRegistry::global().find(symbol), value);
+}
+
+bool LockFreeBTree::remove(SymbolId symbol, double value) {
+    unsigned restarts = 0;
+    while (true) {
+        Attempt attempt = try_remove(symbol, value);
+        if (attempt != Attempt::RESTART) return attempt == Attempt::DONE;
+        back_off(restarts);
+    }
+}
+
+LockFreeBTree::Attempt LockFreeBTree::try_remove(SymbolId symbol, double value) {
+    uint64_t version;
+    BTreeLeaf* leaf = seek(symbol, value, version);
+    if (!leaf) return Attempt::RESTART;
+    while (true) {
+        size_t pos = leaf->lower_bound(symbol, value);
+        if (pos < leaf->size()) {
+            if (!leaf->key_equals(pos, symbol, value)) {
+                return leaf->validate(version) ? Attempt::FAILED : Attempt::RESTART;
+            }
+            // A successful upgrade means pos still holds the key
+            if (!leaf->upgrade(version)) return Attempt::RESTART;
+            Node* entry = leaf->entries[pos].load(std::memory_order_relaxed);
+            leaf->erase_at(pos);
+            leaf->unlock();
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            EpochManager::global().retire(entry);
+            return Attempt::DONE;
         }
-        return false;
+        // Everything here is smaller; the key can only be further right
+        BTreeLeaf* next = leaf->next.load(std::memory_order_relaxed);
+        if (!leaf->validate(version)) return Attempt::RESTART;
+        if (!next) return Attempt::FAILED;
+        leaf = next;
+        if (!leaf->read_lock(version)) return Attempt::RESTART;
     }
 }
 
 void LockFreeBTree::clear() {
     cleanup_tree(root_.load());
-    root_.store(nullptr);
+    first_leaf_ = allocate_leaf();
+    if (!first_leaf_) throw std::bad_alloc();
+    root_.store(first_leaf_, std::memory_order_release);
     size_.store(0);
-    height_.store(0);
+    height_.store(1);
+}
+
+template <typename Keep>
+size_t LockFreeBTree::collect(SymbolId symbol, double from, double to, Node** out, size_t capacity,
+                              Keep&& keep) const {
+    if (capacity == 0 || from > to) return 0;
+    // keep may read the node, which a concurrent remove could retire
+    EpochGuard guard;
+    size_t written = 0;
+    walk(symbol, from, [&](SymbolId key_symbol, double key_value, Node* node) {
+        if (key_symbol != symbol || key_value > to) return false;
+        if (keep(node)) out[written++] = node;
+        return written < capacity;
+    });
+    return written;
+}
+
+template <typename Keep>
+std::vector<Node*> LockFreeBTree::collect(SymbolId symbol, double from, double to, Keep&& keep) const {
+    std::vector<Node*> results;
+    if (from > to) return results;
+    EpochGuard guard;
+    walk(symbol, from, [&](SymbolId key_symbol, double key_value, Node* node) {
+        if (key_symbol != symbol || key_value > to) return false;
+        if (keep(node)) results.push_back(node);
+        return true;
+    });
+    return results;
+}
+
+size_t LockFreeBTree::get_range(SymbolId symbol, double min_value, double max_value, Node** out,
+                                size_t capacity) {
+    return collect(symbol, min_value, max_value, out, capacity, [](const Node*) { return true; });
 }
 
 std::vector<Node*> LockFreeBTree::get_range(const std::string& symbol, double min_value, double max_value) {
-    std::vector<Node*> results;
-    
-    BTreeNode* current = root_.load();
-    if (!current) return results;
-    
-    // Find starting position
-    while (current && !current->is_leaf.load()) {
-        size_t i = 0;
-        size_t key_count = current->key_count.load();
-        
-        while (i < key_count && current->keys[i] && 
-               (current->keys[i]->symbol < symbol || 
-                (current->keys[i]->symbol == symbol && current->keys[i]->value < min_value))) {
-            i++;
-        }
-        current = current->children[i].load();
-    }
-    
-    // Collect results from leaves
-    while (current) {
-        size_t key_count = current->key_count.load();
-        
-        for (size_t i = 0; i < key_count; ++i) {
-            if (current->keys[i] && current->keys[i]->symbol == symbol && 
-                current->keys[i]->value >= min_value && current->keys[i]->value <= max_value) {
-                results.push_back(current->keys[i]);
-            }
-        }
-        
-        // Move to next leaf (simplified - would need proper leaf linking in full implementation)
-        break;
-    }
-    
-    return results;
+    return get_range(SymbolRegistry::global().find(symbol), min_value, max_value);
+}
+
+std::vector<Node*> LockFreeBTree::get_range(SymbolId symbol, double min_value, double max_value) {
+    return collect(symbol, min_value, max_value, [](const Node*) { return true; });
+}
+
+size_t LockFreeBTree::get_by_priority_range(SymbolId symbol, int min_priority, int max_priority, Node** out,
+                                            size_t capacity) {
+    return collect(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity(), out, capacity,
+                   [=](const Node* node) { return node->priority >= min_priority && node->priority <= max_priority; });
 }
 
 std::vector<Node*> LockFreeBTree::get_by_priority_range(const std::string& symbol, int min_priority, int max_priority) {
-    std::vector<Node*> results;
-    
-    // Traverse all nodes (simplified implementation)
-    Iterator it = begin();
-    Iterator end_it = end();
-    
-    while (it != end_it) {
-        Node* node = *it;
-        if (node && node->symbol == symbol && 
-            node->priority >= min_priority && node->priority <= max_priority) {
-            results.push_back(node);
-        }
-        ++it;
-    }
-    
-    return results;
+    return get_by_priority_range(SymbolRegistry::global().find(symbol), min_priority, max_priority);
+}
+
+std::vector<Node*> LockFreeBTree::get_by_priority_range(SymbolId symbol, int min_priority, int max_priority) {
+    return collect(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity(),
+                   [=](const Node* node) { return node->priority >= min_priority && node->priority <= max_priority; });
+}
+
+size_t LockFreeBTree::get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time, Node** out,
+                                             size_t capacity) {
+    return collect(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity(), out, capacity,
+                   [=](const Node* node) { return node->timestamp_ns >= start_time && node->timestamp_ns <= end_time; });
 }
 
 std::vector<Node*> LockFreeBTree::get_by_timestamp_range(const std::string& symbol, uint64_t start_time, uint64_t end_time) {
-    std::vector<Node*> results;
-    
-    // Traverse all nodes (simplified implementation)
-    Iterator it = begin();
-    Iterator end_it = end();
-    
-    while (it != end_it) {
-        Node* node = *it;
-        if (node && node->symbol == symbol && 
-            node->timestamp >= start_time && node->timestamp <= end_time) {
-            results.push_back(node);
-        }
-        ++it;
-    }
-    
-    return results;
+    return get_by_timestamp_range(SymbolRegistry::global().find(symbol), start_time, end_time);
+}
+
+std::vector<Node*> LockFreeBTree::get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time) {
+    return collect(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity(),
+                   [=](const Node* node) { return node->timestamp_ns >= start_time && node->timestamp_ns <= end_time; });
+}
+
+size_t LockFreeBTree::get_sorted_by_value(SymbolId symbol, Node** out, size_t capacity) {
+    return get_range(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity(), out, capacity);
 }
 
 std::vector<Node*> LockFreeBTree::get_sorted_by_value(const std::string& symbol) {
-    std::vector<Node*> results;
-    
-    Iterator it = begin();
-    Iterator end_it = end();
-    
-    while (it != end_it) {
-        Node* node = *it;
-        if (node && node->symbol == symbol) {
-            results.push_back(node);
-        }
-        ++it;
-    }
-    
-    // Sort by value
-    std::sort(results.begin(), results.end(), 
-              [](const Node* a, const Node* b) { return a->value < b->value; });
-    
-    return results;
+    return get_sorted_by_value(SymbolRegistry::global().find(symbol));
+}
+
+std::vector<Node*> LockFreeBTree::get_sorted_by_value(SymbolId symbol) {
+    return get_range(symbol, LOWEST_VALUE, std::numeric_limits<double>::infinity());
 }
 
 std::vector<Node*> LockFreeBTree::get_sorted_by_priority(const std::string& symbol) {
-    std::vector<Node*> results;
-    
-    Iterator it = begin();
-    Iterator end_it = end();
-    
-    while (it != end_it) {
-        Node* node = *it;
-        if (node && node->symbol == symbol) {
-            results.push_back(node);
-        }
-        ++it;
-    }
-    
-    // Sort by priority (descending)
-    std::sort(results.begin(), results.end(), 
-              [](const Node* a, const Node* b) { return a->priority > b->priority; });
-    
+    return get_sorted_by_priority(SymbolRegistry::global().find(symbol));
+}
+
+std::vector<Node*> LockFreeBTree::get_sorted_by_priority(SymbolId symbol) {
+    EpochGuard guard;
+    std::vector<Node*> results = get_sorted_by_value(symbol);
+    // Stable, so equal priorities stay in value order
+    std::stable_sort(results.begin(), results.end(),
+                     [](const Node* a, const Node* b) { return a->priority > b->priority; });
     return results;
 }
 
 std::vector<Node*> LockFreeBTree::get_sorted_by_timestamp(const std::string& symbol) {
-    std::vector<Node*> results;
-    
-    Iterator it = begin();
-    Iterator end_it = end();
-    
-    while (it != end_it) {
-        Node* node = *it;
-        if (node && node->symbol == symbol) {
-            results.push_back(node);
-        }
-        ++it;
-    }
-    
-    // Sort by timestamp
-    std::sort(results.begin(), results.end(), 
-              [](const Node* a, const Node* b) { return a->timestamp < b->timestamp; });
-    
+    return get_sorted_by_timestamp(SymbolRegistry::global().find(symbol));
+}
+
+std::vector<Node*> LockFreeBTree::get_sorted_by_timestamp(SymbolId symbol) {
+    EpochGuard guard;
+    std::vector<Node*> results = get_sorted_by_value(symbol);
+    std::stable_sort(results.begin(), results.end(),
+                     [](const Node* a, const Node* b) { return a->timestamp_ns < b->timestamp_ns; });
     return results;
 }
 
@@ -339,222 +478,93 @@ int LockFreeBTree::get_height() const {
 }
 
 double LockFreeBTree::get_fill_factor() const {
-    size_t total_size = size_.load();
-    if (total_size == 0) return 0.0;
-    
-    // Calculate theoretical capacity
-    int height = height_.load();
-    size_t capacity = 0;
-    for (int i = 0; i < height; ++i) {
-        capacity += std::pow(B_TREE_ORDER - 1, i) * (B_TREE_ORDER - 1);
-    }
-    
-    return static_cast<double>(total_size) / capacity;
-}
-
-BTreeNode* LockFreeBTree::find_leaf(const std::string& symbol, double value) {
-    BTreeNode* current = root_.load();
-    
-    while (current && !current->is_leaf.load()) {
-        size_t i = 0;
-        size_t key_count = current->key_count.load();
-        
-        while (i < key_count && current->keys[i] && 
-               (current->keys[i]->symbol < symbol || 
-                (current->keys[i]->symbol == symbol && current->keys[i]->value < value))) {
-            i++;
-        }
-        current = current->children[i].load();
-    }
-    
-    return current;
-}
-
-bool LockFreeBTree::insert_into_leaf(BTreeNode* leaf, Node* node) {
-    if (!leaf) return false;
-    
-    size_t key_count = leaf->key_count.load();
-    
-    if (key_count < B_TREE_ORDER - 1) {
-        // Simple insertion
-        size_t insert_pos = 0;
-        while (insert_pos < key_count && leaf->keys[insert_pos] && 
-               (leaf->keys[insert_pos]->symbol < node->symbol || 
-                (leaf->keys[insert_pos]->symbol == node->symbol && leaf->keys[insert_pos]->value < node->value))) {
-            insert_pos++;
-        }
-        
-        // Shift elements
-        for (size_t i = key_count; i > insert_pos; --i) {
-            leaf->keys[i] = leaf->keys[i - 1];
-        }
-        
-        leaf->keys[insert_pos] = node;
-        leaf->key_count.fetch_add(1);
-        return true;
-    } else {
-        // Node is full - would need to split (simplified)
-        return false;
-    }
+    size_t leaves = leaf_count_.load();
+    return leaves ? static_cast<double>(size_.load()) / (leaves * BTreeNode::MAX_KEYS) : 0.0;
 }
 
-void LockFreeBTree::split_node(BTreeNode* parent, size_t child_index) {
-    // Simplified split implementation
-    // In a full implementation, this would split the child node and update parent
+BTreeLeaf* LockFreeBTree::allocate_leaf() {
+    BTreeLeaf* leaf = leaf_cache_.create();
+    if (leaf) leaf_count_.fetch_add(1);
+    return leaf;
 }
 
-void LockFreeBTree::merge_nodes(BTreeNode* parent, size_t child_index) {
-    // Simplified merge implementation
-    // In a full implementation, this would merge child nodes
+BTreeInner* LockFreeBTree::allocate_inner() {
+    return inner_cache_.create();
 }
 
-void LockFreeBTree::rebalance_tree(BTreeNode* node) {
-    // Simplified rebalancing
-    // In a full implementation, this would rebalance the tree after operations
-}
+void LockFreeBTree::cleanup_tree(BTreeNode* node) {
+    if (!node) return;
 
-BTreeNode* LockFreeBTree::allocate_node() {
-    return new BTreeNode();
-}
+    if (node->is_leaf) {
+        BTreeLeaf* leaf = static_cast<BTreeLeaf*>(node);
+        for (size_t i = 0; i < leaf->size(); ++i) delete leaf->entries[i].load(std::memory_order_relaxed);
+        leaf_cache_.destroy(leaf);
+        leaf_count_.fetch_sub(1);
+        return;
+    }
 
-void LockFreeBTree::deallocate_node(BTreeNode* node) {
-    delete node;
+    BTreeInner* inner = static_cast<BTreeInner*>(node);
+    for (size_t i = 0; i <= inner->size(); ++i) cleanup_tree(inner->children[i].load(std::memory_order_relaxed));
+    inner_cache_.destroy(inner);
 }
 
-void LockFreeBTree::cleanup_tree(BTreeNode* node) {
-    if (!node) return;
-    
-    if (!node->is_leaf.load()) {
-        for (size_t i = 0; i < B_TREE_ORDER; ++i) {
-            BTreeNode* child = node->children[i].load();
-            if (child) {
-                cleanup_tree(child);
-            }
-        }
-    }
-    
-    // Clean up keys
-    for (size_t i = 0; i < B_TREE_ORDER - 1; ++i) {
-        if (node->keys[i]) {
-            delete node->keys[i];
+bool LockFreeBTree::validate_tree() const {
+    size_t entries = 0;
+    SymbolId last_symbol = 0;
+    double last_value = LOWEST_VALUE;
+    for (const BTreeLeaf* leaf = first_leaf_; leaf; leaf = leaf->next.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < leaf->size(); ++i, ++entries) {
+            if (leaf->key_less(i, last_symbol, last_value)) return false;
+            last_symbol = leaf->symbols[i].load(std::memory_order_relaxed);
+            last_value = leaf->values[i].load(std::memory_order_relaxed);
         }
     }
-    
-    delete node;
+    return entries == size_.load() && calculate_height(root_.load()) == height_.load();
 }
 
-bool LockFreeBTree::validate_tree() const {
-    // Basic validation
-    BTreeNode* root = root_.load();
-    if (!root) return true;
-    
-    return calculate_height(root) == height_.load() && 
-           calculate_size(root) == size_.load();
+void LockFreeBTree::print_tree() const {
+    std::cout << "B+-tree (size: " << size_.load() << ", height: " << height_.load()
+              << ", leaves: " << leaf_count_.load() << ")" << std::endl;
 }
 
-void LockFreeBTree::print_tree() const {
-    std::cout << "B-Tree (size: " << size_.load() << ", height: " << height_.load() << "):" << std::endl;
-    // Simplified printing - would need recursive traversal for full tree display
-}
-
-int LockFreeBTree::calculate_height(BTreeNode* node) const {
-    if (!node) return 0;
-    if (node->is_leaf.load()) return 1;
-    
-    int max_child_height = 0;
-    for (size_t i = 0; i < B_TREE_ORDER; ++i) {
-        BTreeNode* child = node->children[i].load();
-        if (child) {
-            max_child_height = std::max(max_child_height, calculate_height(child));
-        }
-    }
-    
-    return 1 + max_child_height;
-}
-
-size_t LockFreeBTree::calculate_size(BTreeNode* node) const {
-    if (!node) return 0;
-    
-    size_t count = node->key_count.load();
-    
-    if (!node->is_leaf.load()) {
-        for (size_t i = 0; i < B_TREE_ORDER; ++i) {
-            BTreeNode* child = node->children[i].load();
-            if (child) {
-                count += calculate_size(child);
-            }
-        }
+int LockFreeBTree::calculate_height(const BTreeNode* node) const {
+    int height = 1;
+    while (node && !node->is_leaf) {
+        node = static_cast<const BTreeInner*>(node)->children[0].load(std::memory_order_relaxed);
+        ++height;
     }
-    
-    return count;
+    return node ? height : 0;
 }
 
 // Iterator Implementation
-LockFreeBTree::Iterator::Iterator(BTreeNode* root) {
-    if (root) {
-        push_left(root);
+LockFreeBTree::Iterator::Iterator(const BTreeLeaf* leaf) : leaf_(leaf) {
+    skip_empty();
+}
+
+void LockFreeBTree::Iterator::skip_empty() {
+    while (leaf_ && index_ >= leaf_->size()) {
+        leaf_ = leaf_->next.load(std::memory_order_relaxed);
+        index_ = 0;
     }
 }
 
 LockFreeBTree::Iterator& LockFreeBTree::Iterator::operator++() {
-    if (stack_.empty()) return *this;
-    
-    BTreeNode* current = stack_.back();
-    size_t current_index = indices_.back();
-    
-    // Move to next key in current node
-    current_index++;
-    if (current_index < current->key_count.load()) {
-        indices_.back() = current_index;
-        return *this;
-    }
-    
-    // Move to next child
-    if (!current->is_leaf.load()) {
-        BTreeNode* child = current->children[current_index].load();
-        if (child) {
-            push_left(child);
-            return *this;
-        }
-    }
-    
-    // Move to next node in stack
-    stack_.pop_back();
-    indices_.pop_back();
-    
+    if (!leaf_) return *this;
+    ++index_;
+    skip_empty();
     return *this;
 }
 
 Node* LockFreeBTree::Iterator::operator*() {
-    if (stack_.empty()) return nullptr;
-    
-    BTreeNode* current = stack_.back();
-    size_t current_index = indices_.back();
-    
-    if (current_index < current->key_count.load()) {
-        return current->keys[current_index];
-    }
-    
-    return nullptr;
+    return leaf_ ? leaf_->entries[index_].load(std::memory_order_relaxed) : nullptr;
 }
 
 bool LockFreeBTree::Iterator::operator!=(const Iterator& other) const {
-    return stack_ != other.stack_ || indices_ != other.indices_;
-}
-
-void LockFreeBTree::Iterator::push_left(BTreeNode* node) {
-    while (node) {
-        stack_.push_back(node);
-        indices_.push_back(0);
-        
-        if (node->is_leaf.load()) break;
-        
-        node = node->children[0].load();
-    }
+    return leaf_ != other.leaf_ || index_ != other.index_;
 }
 
 LockFreeBTree::Iterator LockFreeBTree::begin() {
-    return Iterator(root_.load());
+    return Iterator(first_leaf_);
 }
 
 LockFreeBTree::Iterator LockFreeBTree::end() {
@@ -574,6 +584,10 @@ bool ThreadSafeBTree::insert_thread_safe(Node* node) {
 }
 
 Node* ThreadSafeBTree::find_thread_safe(const std::string& symbol, double value) {
+    return find_thread_safe(SymbolRegistry::global().find(symbol), value);
+}
+
+Node* ThreadSafeBTree::find_thread_safe(SymbolId symbol, double value) {
     concurrent_readers_.fetch_add(1);
     Node* result = find(symbol, value);
     concurrent_readers_.fetch_sub(1);
@@ -581,6 +595,10 @@ Node* ThreadSafeBTree::find_thread_safe(const std::string& symbol, double value)
 }
 
 bool ThreadSafeBTree::remove_thread_safe(const std::string& symbol, double value) {
+    return remove_thread_safe(SymbolRegistry::global().find(symbol), value);
+}
+
+bool ThreadSafeBTree::remove_thread_safe(SymbolId symbol, double value) {
     concurrent_writers_.fetch_add(1);
     bool result = remove(symbol, value);
     concurrent_writers_.fetch_sub(1);
@@ -597,27 +615,21 @@ PooledBTree::~PooledBTree() {
     cleanup_pool();
 }
 
-BTreeNode* PooledBTree::allocate_node_from_pool() {
+BTreeLeaf* PooledBTree::allocate_node_from_pool() {
     if (!node_pool_.empty()) {
-        BTreeNode* node = node_pool_.back();
+        BTreeLeaf* node = node_pool_.back();
         node_pool_.pop_back();
         return node;
     }
-    
-    return new BTreeNode();
+
+    return new BTreeLeaf();
 }
 
-void PooledBTree::deallocate_node_to_pool(BTreeNode* node) {
+void PooledBTree::deallocate_node_to_pool(BTreeLeaf* node) {
     if (node_pool_.size() < pool_size_) {
         // Reset node state
-        node->key_count.store(0);
-        node->is_leaf.store(true);
-        for (size_t i = 0; i < B_TREE_ORDER - 1; ++i) {
-            node->keys[i] = nullptr;
-        }
-        for (size_t i = 0; i < B_TREE_ORDER; ++i) {
-            node->children[i].store(nullptr);
-        }
+        node->count.store(0);
+        node->next.store(nullptr);
         node_pool_.push_back(node);
     } else {
         delete node;
@@ -625,20 +637,22 @@ void PooledBTree::deallocate_node_to_pool(BTreeNode* node) {
 }
 
 void PooledBTree::defragment_pool() {
-    if (node_pool_.size() > pool_size_ / 2) {
-        node_pool_.resize(pool_size_ / 2);
+    size_t keep = pool_size_ / 2;
+    while (node_pool_.size() > keep) {
+        delete node_pool_.back();
+        node_pool_.pop_back();
     }
 }
 
 void PooledBTree::initialize_pool() {
     node_pool_.reserve(pool_size_);
     for (size_t i = 0; i < pool_size_; ++i) {
-        node_pool_.push_back(new BTreeNode());
+        node_pool_.push_back(new BTreeLeaf());
     }
 }
 
 void PooledBTree::cleanup_pool() {
-    for (BTreeNode* node : node_pool_) {
+    for (BTreeLeaf* node : node_pool_) {
         delete node;
     }
     node_pool_.clear();
@@ -657,28 +671,26 @@ void CompressedBTree::compress_node(BTreeNode* node) {
     total_nodes_.fetch_add(1);
 }
 
-void CompressedBTree::decompress_node(BTreeNode* node) {
-    // Simplified decompression
-    // In a full implementation, this would decompress the node data
+void CompressedBTree::decompress_node(BTreeNode*) {
+    // Keys are already stored inline and fixed-size; there is nothing to expand
 }
 
 double CompressedBTree::get_compression_ratio() const {
     size_t compressed = compressed_nodes_.load();
     size_t total = total_nodes_.load();
-    
+
     return total > 0 ? static_cast<double>(compressed) / total : 0.0;
 }
 
 bool CompressedBTree::should_compress_node(BTreeNode* node) const {
     if (!node) return false;
-    
-    size_t key_count = node->key_count.load();
-    return key_count < (B_TREE_ORDER - 1) / 2; // Compress if less than half full
+
+    return node->size() < BTreeNode::MAX_KEYS / 2; // Compress if less than half full
 }
 
-void CompressedBTree::apply_compression(BTreeNode* node) {
+void CompressedBTree::apply_compression(BTreeNode*) {
     // Simplified compression
     // In a full implementation, this would compress the node data
 }
 
-} // namespace hft_cache 
\ No newline at end of file
+} // namespace hft_cache
@@ -0,0 +1,908 @@
+#include "benchmark_suite.hpp"
+#include "advanced_memory_pool.hpp"
+#include "b_tree.hpp"
+#include "bloom_filter.hpp"
+#include "clock.hpp"
+#include "epoch_reclamation.hpp"
+#include "multi_level_cache.hpp"
+#include "node_pool.hpp"
+#include "radial_circular_list.hpp"
+#include "skip_list.hpp"
+#include "span.hpp"
+#include "spin_lock.hpp"
+#include "symbol_registry.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace hft_cache {
+
+namespace {
+
+constexpr const char* TARGET_NAMES[] = {
+    "radial", "multi_level", "btree", "skip_list", "bloom", "counting_bloom", "cuckoo", "node_pool", "advanced_pool",
+};
+static_assert(sizeof(TARGET_NAMES) / sizeof(TARGET_NAMES[0]) == static_cast<size_t>(BenchmarkTarget::COUNT),
+              "one name per target");
+
+// Longer than any cache the targets fit in, short enough that a worker's
+// operations for a big batch stay a few MB; calls wrap around after it
+constexpr size_t RING_OPERATIONS = size_t(1) << 18;
+constexpr double EXPIRY_SECONDS = 3600.0;  // nothing expires during a run
+constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+// Trace file layout: this, the symbol names and then the phase names, each
+// as a 16-bit length and its bytes, then event_count TraceEvents
+struct TraceHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t event_bytes;
+    uint32_t symbol_count;
+    uint32_t phase_count;
+    uint64_t event_count;
+};
+static_assert(sizeof(TraceEvent) == 40, "trace records are 40 bytes");
+
+// A worker's calls, generated up front. Call c reads when reads[c] is set
+// and covers operations [slot * batch, slot * batch + batch) of the ring,
+// slot being c modulo ring_calls.
+struct WorkerPlan {
+    std::vector<uint8_t> reads;
+    std::vector<InsertRecord> records;  // value is the key within the symbol
+    std::vector<SymbolId> symbols;      // records[i].symbol, contiguous for the batch reads
+    std::vector<uint64_t> hashes;       // BloomFilter::hash_key of (symbol, key)
+    size_t ring_calls = 0;
+    uint64_t checksum = 0;
+    uint64_t write_operations = 0;
+};
+
+uint64_t key_hash(SymbolId symbol, uint64_t key) { return BloomFilter::hash_key((uint64_t(symbol) << 32) | key); }
+
+WorkerPlan make_plan(const WorkloadOptions& options, const std::vector<SymbolId>& ids, const ZipfGenerator& zipf,
+                     size_t worker, bool has_reads) {
+    BenchmarkRng rng(options.seed * FNV_PRIME + worker);
+    WorkerPlan plan;
+    size_t calls = options.warmup + options.operations;
+    plan.ring_calls = std::max<size_t>(1, std::min(calls, RING_OPERATIONS / options.batch));
+    plan.reads.resize(calls);
+    plan.checksum = options.seed;
+    for (size_t call = 0; call < calls; ++call) {
+        bool read = has_reads && rng.uniform() < options.read_ratio;
+        plan.reads[call] = read;
+        if (!read) plan.write_operations += options.batch;
+        plan.checksum = (plan.checksum ^ read) * FNV_PRIME;
+    }
+
+    size_t count = plan.ring_calls * options.batch;
+    plan.records.resize(count);
+    plan.symbols.resize(count);
+    plan.hashes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        SymbolId symbol = ids[zipf(rng)];
+        uint64_t key = rng.below(options.keys_per_symbol);
+        int32_t priority = static_cast<int32_t>(rng.below(100));
+        plan.records[i] = InsertRecord{static_cast<double>(key), symbol, priority, EXPIRY_SECONDS};
+        plan.symbols[i] = symbol;
+        plan.hashes[i] = key_hash(symbol, key);
+        plan.checksum = (plan.checksum ^ ((uint64_t(symbol) << 40) | (key << 8) | uint64_t(priority))) * FNV_PRIME;
+    }
+    return plan;
+}
+
+// Per-worker scratch for the batch paths
+struct CallBuffers {
+    std::vector<Node*> nodes;
+    std::unique_ptr<bool[]> flags;
+
+    explicit CallBuffers(size_t batch) : nodes(batch), flags(new bool[batch]) {}
+};
+
+// Each target issues one call's operations. read returns how many found
+// something and write how many were refused.
+struct RadialTarget {
+    RadialCircularList list;
+
+    explicit RadialTarget(const CacheConfig& config) : list(config) {}
+
+    void preload(const std::vector<SymbolId>& ids, size_t keys, BenchmarkRng& rng) {
+        for (SymbolId symbol : ids)
+            for (size_t key = 0; key < keys; ++key)
+                list.insert(static_cast<double>(key), symbol, static_cast<int>(rng.below(100)), EXPIRY_SECONDS);
+    }
+    size_t read(const WorkerPlan& plan, size_t first, size_t count, CallBuffers& buffers) {
+        EpochGuard guard;
+        if (count == 1) return list.get_highest_priority(plan.symbols[first]) != nullptr;
+        return list.get_highest_priority_batch(Span<const SymbolId>(&plan.symbols[first], count),
+                                               Span<Node*>(buffers.nodes.data(), count));
+    }
+    size_t write(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        if (count == 1) {
+            const InsertRecord& record = plan.records[first];
+            return !list.insert(record.value, record.symbol, record.priority, record.expiry_seconds);
+        }
+        return count - list.insert_batch(Span<const InsertRecord>(&plan.records[first], count));
+    }
+};
+
+struct MultiLevelTarget {
+    MultiLevelCache cache;
+
+    explicit MultiLevelTarget(const CacheConfig& config) : cache(config) {}
+
+    void preload(const std::vector<SymbolId>& ids, size_t keys, BenchmarkRng& rng) {
+        for (SymbolId symbol : ids)
+            for (size_t key = 0; key < keys; ++key)
+                cache.insert(static_cast<double>(key), symbol, static_cast<int>(rng.below(100)), EXPIRY_SECONDS);
+    }
+    size_t read(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        EpochGuard guard;
+        size_t hits = 0;
+        for (size_t i = first; i < first + count; ++i) hits += cache.get_highest_priority(plan.symbols[i]) != nullptr;
+        return hits;
+    }
+    size_t write(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        size_t refused = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            const InsertRecord& record = plan.records[i];
+            refused += !cache.insert(record.value, record.symbol, record.priority, record.expiry_seconds);
+        }
+        return refused;
+    }
+};
+
+// LockFreeBTree and LockFreeSkipList share an interface. A write replaces
+// the entry for its key, so the structure keeps its size.
+template <typename Ordered>
+struct OrderedTarget {
+    Ordered index;
+
+    explicit OrderedTarget(const CacheConfig& config) : index(config) {}
+
+    static Node* make_node(SymbolId symbol, double value, int priority) {
+        Node* node = new Node(value, priority, EXPIRY_SECONDS);
+        node->symbol = symbol;
+        return node;
+    }
+    void preload(const std::vector<SymbolId>& ids, size_t keys, BenchmarkRng& rng) {
+        for (SymbolId symbol : ids) {
+            for (size_t key = 0; key < keys; ++key) {
+                Node* node = make_node(symbol, static_cast<double>(key), static_cast<int>(rng.below(100)));
+                if (!index.insert(node)) delete node;
+            }
+        }
+    }
+    size_t read(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        EpochGuard guard;
+        size_t hits = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            const InsertRecord& record = plan.records[i];
+            hits += index.find(record.symbol, record.value) != nullptr;
+        }
+        return hits;
+    }
+    size_t write(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        EpochGuard guard;
+        size_t refused = 0;
+        for (size_t i = first; i < first + count; ++i) {
+            const InsertRecord& record = plan.records[i];
+            index.remove(record.symbol, record.value);
+            Node* node = make_node(record.symbol, record.value, record.priority);
+            if (!index.insert(node)) {
+                delete node;
+                ++refused;
+            }
+        }
+        return refused;
+    }
+};
+
+// The three filters. BloomFilter cannot delete, so its writes only add;
+// the others replace the key.
+template <typename Filter>
+struct FilterTarget {
+    Filter filter;
+
+    explicit FilterTarget(size_t capacity) : filter(capacity) {}
+
+    void preload(const std::vector<SymbolId>& ids, size_t keys, BenchmarkRng&) {
+        for (SymbolId symbol : ids)
+            for (size_t key = 0; key < keys; ++key) filter.add(key_hash(symbol, key));
+    }
+    size_t read(const WorkerPlan& plan, size_t first, size_t count, CallBuffers& buffers) {
+        return probe(filter, &plan.hashes[first], count, buffers.flags.get());
+    }
+    size_t write(const WorkerPlan& plan, size_t first, size_t count, CallBuffers&) {
+        size_t refused = 0;
+        for (size_t i = first; i < first + count; ++i) refused += !replace(filter, plan.hashes[i]);
+        return refused;
+    }
+
+    static size_t probe(const BloomFilter& bloom, const uint64_t* hashes, size_t count, bool* out) {
+        return count == 1 ? bloom.might_contain(*hashes) : bloom.might_contain_many(hashes, count, out);
+    }
+    template <typename Other>
+    static size_t probe(const Other& other, const uint64_t* hashes, size_t count, bool*) {
+        size_t hits = 0;
+        for (size_t i = 0; i < count; ++i) hits += other.might_contain(hashes[i]);
+        return hits;
+    }
+    static bool replace(BloomFilter& bloom, uint64_t hash) {
+        bloom.add(hash);
+        return true;
+    }
+    static bool replace(CountingBloomFilter& counting, uint64_t hash) {
+        counting.remove(hash);
+        counting.add(hash);
+        return true;
+    }
+    static bool replace(CuckooFilter& cuckoo, uint64_t hash) {
+        cuckoo.remove(hash);
+        return cuckoo.add(hash);
+    }
+};
+
+// The pools: a write takes count nodes and gives them back
+struct NodePoolTarget {
+    NodePool pool;
+
+    explicit NodePoolTarget(const CacheConfig& config) : pool(config.max_nodes, config.node_magazine_rounds) {}
+
+    void preload(const std::vector<SymbolId>&, size_t, BenchmarkRng&) {}
+    size_t read(const WorkerPlan&, size_t, size_t, CallBuffers&) { return 0; }
+    size_t write(const WorkerPlan&, size_t, size_t count, CallBuffers& buffers) {
+        size_t taken = 0;
+        while (taken < count && (buffers.nodes[taken] = pool.allocate())) ++taken;
+        for (size_t i = taken; i > 0; --i) pool.release(buffers.nodes[i - 1]);
+        return count - taken;
+    }
+};
+
+struct AdvancedPoolTarget {
+    AdvancedMemoryPool pool;
+
+    explicit AdvancedPoolTarget(const CacheConfig& config) : pool(config) {}
+
+    void preload(const std::vector<SymbolId>&, size_t, BenchmarkRng&) {}
+    size_t read(const WorkerPlan&, size_t, size_t, CallBuffers&) { return 0; }
+    size_t write(const WorkerPlan&, size_t, size_t count, CallBuffers& buffers) {
+        size_t taken = 0;
+        while (taken < count && (buffers.nodes[taken] = pool.allocate_node())) ++taken;
+        for (size_t i = taken; i > 0; --i) pool.deallocate_node(buffers.nodes[i - 1]);
+        return count - taken;
+    }
+};
+
+void pin_to_cpu(size_t worker) {
+#ifdef __linux__
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(worker % cpus), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)worker;
+#endif
+}
+
+// Waits for the scheduled start of a call: spinning once it is close, and
+// yielding before that so an oversubscribed run lets the other workers in
+void wait_until(uint64_t deadline_ns) {
+    constexpr uint64_t SPIN_NS = 20000;
+    uint64_t now;
+    while ((now = CoarseClock::now()) < deadline_ns) {
+        if (deadline_ns - now > SPIN_NS) std::this_thread::yield();
+        else cpu_relax();
+    }
+}
+
+struct WorkerResult {
+    LatencyHistogram read_latency;
+    LatencyHistogram write_latency;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t read_hits = 0;
+    uint64_t failed_writes = 0;
+};
+
+template <typename Target>
+void run_worker(const WorkloadOptions& options, const WorkerPlan& plan, Target& target, size_t worker,
+                std::atomic<size_t>& ready, WorkerResult& result) {
+    if (options.pin_threads) pin_to_cpu(worker);
+    CallBuffers buffers(options.batch);
+    const uint64_t interval_ns =
+        options.rate > 0.0 ? std::max<uint64_t>(1, static_cast<uint64_t>(1e9 / options.rate)) : 0;
+    const size_t calls = options.warmup + options.operations;
+
+    ready.fetch_add(1, std::memory_order_acq_rel);
+    while (ready.load(std::memory_order_acquire) < options.threads) std::this_thread::yield();
+
+    uint64_t phase_start = CoarseClock::now();
+    size_t scheduled = 0;  // calls issued since phase_start
+    for (size_t call = 0; call < calls; ++call, ++scheduled) {
+        bool timed = call >= options.warmup;
+        if (call == options.warmup) {
+            phase_start = CoarseClock::now();
+            scheduled = 0;
+            result.start_ns = phase_start;
+        }
+        // Open loop: latency counts from the scheduled start, however late
+        // the call actually went out
+        uint64_t intended;
+        if (interval_ns) {
+            intended = phase_start + scheduled * interval_ns;
+            wait_until(intended);
+        } else {
+            intended = CoarseClock::now();
+        }
+
+        size_t first = (call % plan.ring_calls) * options.batch;
+        if (plan.reads[call]) {
+            size_t hits = target.read(plan, first, options.batch, buffers);
+            uint64_t end = CoarseClock::now();
+            if (!timed) continue;
+            result.read_latency.record(end - intended);
+            result.reads += options.batch;
+            result.read_hits += hits;
+        } else {
+            size_t refused = target.write(plan, first, options.batch, buffers);
+            uint64_t end = CoarseClock::now();
+            if (!timed) continue;
+            result.write_latency.record(end - intended);
+            result.writes += options.batch;
+            result.failed_writes += refused;
+        }
+    }
+    result.end_ns = CoarseClock::now();
+    if (options.operations == 0) result.start_ns = result.end_ns;
+}
+
+template <typename Target>
+WorkloadResult drive(const WorkloadOptions& options, const std::vector<SymbolId>& ids,
+                     const std::vector<WorkerPlan>& plans, Target& target) {
+    BenchmarkRng preload_rng(~options.seed);
+    target.preload(ids, options.keys_per_symbol, preload_rng);
+
+    std::vector<WorkerResult> workers(options.threads);
+    std::atomic<size_t> ready{0};
+    std::vector<std::thread> threads;
+    for (size_t worker = 0; worker < options.threads; ++worker) {
+        threads.emplace_back([&, worker]() {
+            run_worker(options, plans[worker], target, worker, ready, workers[worker]);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    WorkloadResult result;
+    result.options = options;
+    LatencyHistogram reads, writes;
+    uint64_t start = UINT64_MAX, end = 0;
+    for (const WorkerResult& worker : workers) {
+        reads.merge(worker.read_latency);
+        writes.merge(worker.write_latency);
+        start = std::min(start, worker.start_ns);
+        end = std::max(end, worker.end_ns);
+        result.reads += worker.reads;
+        result.writes += worker.writes;
+        result.read_hits += worker.read_hits;
+        result.failed_writes += worker.failed_writes;
+    }
+    result.read_latency = LatencySummary::of(reads);
+    result.write_latency = LatencySummary::of(writes);
+    result.calls = result.read_latency.count + result.write_latency.count;
+    result.seconds = end > start ? static_cast<double>(end - start) / 1e9 : 0.0;
+    result.throughput = result.seconds > 0.0 ? static_cast<double>(result.reads + result.writes) / result.seconds : 0.0;
+    for (const WorkerPlan& plan : plans) result.checksum = (result.checksum ^ plan.checksum) * FNV_PRIME;
+    return result;
+}
+
+void write_summary_json(std::ostringstream& out, const char* name, const LatencySummary& latency) {
+    out << ",\"" << name << "\":{\"count\":" << latency.count << ",\"mean\":" << latency.mean_ns
+        << ",\"p50\":" << latency.p50_ns << ",\"p99\":" << latency.p99_ns << ",\"p999\":" << latency.p999_ns
+        << ",\"max\":" << latency.max_ns << "}";
+}
+
+void write_summary_csv(std::ostringstream& out, const LatencySummary& latency) {
+    out << "," << latency.count << "," << latency.mean_ns << "," << latency.p50_ns << "," << latency.p99_ns << ","
+        << latency.p999_ns << "," << latency.max_ns;
+}
+
+} // namespace
+
+// ZipfGenerator Implementation
+ZipfGenerator::ZipfGenerator(size_t n, double skew) : cdf_(std::max<size_t>(n, 1)) {
+    double total = 0.0;
+    for (size_t rank = 0; rank < cdf_.size(); ++rank) {
+        total += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+        cdf_[rank] = total;
+    }
+    for (double& cumulative : cdf_) cumulative /= total;
+    cdf_.back() = 1.0;
+}
+
+size_t ZipfGenerator::operator()(BenchmarkRng& rng) const {
+    double u = rng.uniform();
+    return static_cast<size_t>(std::upper_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin());
+}
+
+double ZipfGenerator::probability(size_t rank) const {
+    if (rank >= cdf_.size()) return 0.0;
+    return rank == 0 ? cdf_[0] : cdf_[rank] - cdf_[rank - 1];
+}
+
+const char* benchmark_target_name(BenchmarkTarget target) {
+    size_t index = static_cast<size_t>(target);
+    return index < static_cast<size_t>(BenchmarkTarget::COUNT) ? TARGET_NAMES[index] : "unknown";
+}
+
+bool parse_benchmark_target(const std::string& name, BenchmarkTarget& target) {
+    for (size_t index = 0; index < static_cast<size_t>(BenchmarkTarget::COUNT); ++index) {
+        if (name == TARGET_NAMES[index]) {
+            target = static_cast<BenchmarkTarget>(index);
+            return true;
+        }
+    }
+    return false;
+}
+
+WorkloadResult run_workload(const WorkloadOptions& requested) {
+    WorkloadOptions options = requested;
+    options.threads = std::max<size_t>(options.threads, 1);
+    options.symbols = std::max<size_t>(options.symbols, 1);
+    options.keys_per_symbol = std::max<size_t>(options.keys_per_symbol, 1);
+    options.batch = std::max<size_t>(options.batch, 1);
+
+    std::vector<SymbolId> ids;
+    for (size_t i = 0; i < options.symbols; ++i)
+        ids.push_back(SymbolRegistry::global().intern("BENCH" + std::to_string(i)));
+
+    bool has_reads = true;
+    switch (options.target) {
+    case BenchmarkTarget::NODE_POOL:
+    case BenchmarkTarget::ADVANCED_POOL:
+        has_reads = false;
+        break;
+    default:
+        break;
+    }
+    ZipfGenerator zipf(options.symbols, options.zipf_skew);
+    std::vector<WorkerPlan> plans;
+    uint64_t planned_writes = 0;
+    for (size_t worker = 0; worker < options.threads; ++worker) {
+        plans.push_back(make_plan(options, ids, zipf, worker, has_reads));
+        planned_writes += plans.back().write_operations;
+    }
+
+    // Room for the preload and, for the caches, every write the plans hold,
+    // so a run measures the structure rather than its pool running dry
+    size_t preload = options.symbols * options.keys_per_symbol;
+    CacheConfig config;
+    config.enable_metrics = false;
+    config.max_nodes = preload + static_cast<size_t>(planned_writes) + 1024;
+
+    switch (options.target) {
+    case BenchmarkTarget::RADIAL: {
+        RadialTarget target(config);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::MULTI_LEVEL: {
+        MultiLevelTarget target(config);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::BTREE: {
+        OrderedTarget<LockFreeBTree> target(config);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::SKIP_LIST: {
+        OrderedTarget<LockFreeSkipList> target(config);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::BLOOM: {
+        FilterTarget<BloomFilter> target(preload * 2);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::COUNTING_BLOOM: {
+        FilterTarget<CountingBloomFilter> target(preload * 2);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::CUCKOO: {
+        FilterTarget<CuckooFilter> target(preload * 2);
+        return drive(options, ids, plans, target);
+    }
+    case BenchmarkTarget::NODE_POOL:
+    case BenchmarkTarget::ADVANCED_POOL:
+    default: {
+        // Every batch at once plus what the magazines hold on to, as in
+        // benchmark_node_allocators
+        config.max_nodes = options.threads * (options.batch + 2 * config.memory_pool_magazine_rounds) * 2 + 1024;
+        if (options.target == BenchmarkTarget::NODE_POOL) {
+            NodePoolTarget target(config);
+            return drive(options, ids, plans, target);
+        }
+        AdvancedPoolTarget target(config);
+        return drive(options, ids, plans, target);
+    }
+    }
+}
+
+std::string format_json(const WorkloadResult& result) {
+    const WorkloadOptions& options = result.options;
+    std::ostringstream out;
+    out << "{\"target\":\"" << benchmark_target_name(options.target) << "\""
+        << ",\"threads\":" << options.threads << ",\"operations\":" << options.operations
+        << ",\"warmup\":" << options.warmup << ",\"symbols\":" << options.symbols
+        << ",\"keys_per_symbol\":" << options.keys_per_symbol << ",\"zipf_skew\":" << options.zipf_skew
+        << ",\"read_ratio\":" << options.read_ratio << ",\"batch\":" << options.batch
+        << ",\"rate\":" << options.rate << ",\"open_loop\":" << (options.rate > 0.0 ? "true" : "false")
+        << ",\"pinned\":" << (options.pin_threads ? "true" : "false") << ",\"seed\":" << options.seed
+        << ",\"seconds\":" << result.seconds << ",\"calls\":" << result.calls << ",\"reads\":" << result.reads
+        << ",\"writes\":" << result.writes << ",\"read_hits\":" << result.read_hits
+        << ",\"failed_writes\":" << result.failed_writes << ",\"checksum\":" << result.checksum
+        << ",\"throughput\":" << result.throughput;
+    write_summary_json(out, "read_latency_ns", result.read_latency);
+    write_summary_json(out, "write_latency_ns", result.write_latency);
+    out << "}";
+    return out.str();
+}
+
+std::string csv_header() {
+    return "target,threads,operations,warmup,symbols,keys_per_symbol,zipf_skew,read_ratio,batch,rate,pinned,seed,"
+           "seconds,calls,reads,writes,read_hits,failed_writes,checksum,throughput,"
+           "read_count,read_mean_ns,read_p50_ns,read_p99_ns,read_p999_ns,read_max_ns,"
+           "write_count,write_mean_ns,write_p50_ns,write_p99_ns,write_p999_ns,write_max_ns";
+}
+
+std::string format_csv(const WorkloadResult& result) {
+    const WorkloadOptions& options = result.options;
+    std::ostringstream out;
+    out << benchmark_target_name(options.target) << "," << options.threads << "," << options.operations << ","
+        << options.warmup << "," << options.symbols << "," << options.keys_per_symbol << "," << options.zipf_skew
+        << "," << options.read_ratio << "," << options.batch << "," << options.rate << ","
+        << (options.pin_threads ? 1 : 0) << "," << options.seed << "," << result.seconds << "," << result.calls
+        << "," << result.reads << "," << result.writes << "," << result.read_hits << "," << result.failed_writes
+        << "," << result.checksum << "," << result.throughput;
+    write_summary_csv(out, result.read_latency);
+    write_summary_csv(out, result.write_latency);
+    return out.str();
+}
+
+// Trace Implementation
+uint32_t Trace::symbol(const std::string& name) {
+    auto found = std::find(symbols.begin(), symbols.end(), name);
+    if (found != symbols.end()) return static_cast<uint32_t>(found - symbols.begin());
+    symbols.push_back(name);
+    return static_cast<uint32_t>(symbols.size() - 1);
+}
+
+uint16_t Trace::phase(const std::string& name) {
+    auto found = std::find(phases.begin(), phases.end(), name);
+    if (found != phases.end()) return static_cast<uint16_t>(found - phases.begin());
+    phases.push_back(name);
+    return static_cast<uint16_t>(phases.size() - 1);
+}
+
+void Trace::insert(uint64_t offset_ns, uint32_t symbol, double value, int priority, uint64_t ttl_ns, uint16_t phase) {
+    events.push_back(TraceEvent{offset_ns, value, ttl_ns, priority, TraceEvent::INSERT, phase, symbol, 0});
+}
+
+void Trace::get(uint64_t offset_ns, uint32_t symbol, uint16_t phase) {
+    events.push_back(TraceEvent{offset_ns, 0.0, 0, 0, TraceEvent::GET, phase, symbol, 0});
+}
+
+bool save_trace(const std::string& path, const Trace& trace) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    TraceHeader header{Trace::MAGIC,
+                       Trace::VERSION,
+                       static_cast<uint32_t>(sizeof(TraceEvent)),
+                       static_cast<uint32_t>(trace.symbols.size()),
+                       static_cast<uint32_t>(trace.phases.size()),
+                       trace.events.size()};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const std::vector<std::string>* table : {&trace.symbols, &trace.phases}) {
+        for (const std::string& name : *table) {
+            uint16_t length = static_cast<uint16_t>(std::min<size_t>(name.size(), UINT16_MAX));
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(name.data(), length);
+        }
+    }
+    file.write(reinterpret_cast<const char*>(trace.events.data()),
+               static_cast<std::streamsize>(trace.events.size() * sizeof(TraceEvent)));
+    return static_cast<bool>(file.flush());
+}
+
+bool load_trace(const std::string& path, Trace& trace) {
+    std::ifstream file(path, std::ios::binary);
+    TraceHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != Trace::MAGIC || header.version != Trace::VERSION || header.event_bytes != sizeof(TraceEvent))
+        return false;
+
+    Trace loaded;
+    for (auto table : {std::make_pair(&loaded.symbols, header.symbol_count),
+                       std::make_pair(&loaded.phases, header.phase_count)}) {
+        for (uint32_t i = 0; i < table.second; ++i) {
+            uint16_t length;
+            if (!file.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+            std::string name(length, '\0');
+            if (!file.read(&name[0], length)) return false;
+            table.first->push_back(std::move(name));
+        }
+    }
+    if (loaded.phases.size() > size_t(UINT16_MAX) + 1) return false;
+
+    // Read in bounded chunks so a corrupt count fails on the short read
+    // instead of one huge allocation
+    constexpr uint64_t CHUNK = 1 << 16;
+    for (uint64_t remaining = header.event_count; remaining > 0;) {
+        size_t count = static_cast<size_t>(std::min(remaining, CHUNK));
+        size_t first = loaded.events.size();
+        loaded.events.resize(first + count);
+        std::streamsize bytes = static_cast<std::streamsize>(count * sizeof(TraceEvent));
+        if (!file.read(reinterpret_cast<char*>(&loaded.events[first]), bytes)) return false;
+        remaining -= count;
+    }
+
+    uint64_t previous = 0;
+    for (const TraceEvent& event : loaded.events) {
+        if (event.kind != TraceEvent::INSERT && event.kind != TraceEvent::GET) return false;
+        if (event.symbol >= loaded.symbols.size() || event.offset_ns < previous) return false;
+        // A trace without a phase table is one phase
+        if (event.phase >= std::max<size_t>(loaded.phases.size(), 1)) return false;
+        previous = event.offset_ns;
+    }
+    trace = std::move(loaded);
+    return true;
+}
+
+namespace {
+
+struct PhaseAccumulator {
+    LatencyHistogram insert_latency;
+    LatencyHistogram get_latency;
+    uint64_t inserts = 0;
+    uint64_t gets = 0;
+    uint64_t get_hits = 0;
+    uint64_t failed_inserts = 0;
+    uint64_t first_ns = UINT64_MAX;
+    uint64_t last_ns = 0;
+
+    void merge(const PhaseAccumulator& other) {
+        insert_latency.merge(other.insert_latency);
+        get_latency.merge(other.get_latency);
+        inserts += other.inserts;
+        gets += other.gets;
+        get_hits += other.get_hits;
+        failed_inserts += other.failed_inserts;
+        first_ns = std::min(first_ns, other.first_ns);
+        last_ns = std::max(last_ns, other.last_ns);
+    }
+
+    ReplayPhaseResult result(const std::string& phase) const {
+        ReplayPhaseResult out;
+        out.phase = phase;
+        out.inserts = inserts;
+        out.gets = gets;
+        out.get_hits = get_hits;
+        out.failed_inserts = failed_inserts;
+        out.seconds = last_ns > first_ns ? static_cast<double>(last_ns - first_ns) / 1e9 : 0.0;
+        out.throughput = out.seconds > 0.0 ? static_cast<double>(inserts + gets) / out.seconds : 0.0;
+        out.insert_latency = LatencySummary::of(insert_latency);
+        out.get_latency = LatencySummary::of(get_latency);
+        return out;
+    }
+};
+
+template <typename Cache>
+void replay_worker(const Trace& trace, const std::vector<SymbolId>& ids, const std::vector<uint32_t>& events,
+                   const ReplayOptions& options, Cache& cache, size_t worker, std::atomic<size_t>& ready,
+                   std::atomic<uint64_t>& start, std::vector<PhaseAccumulator>& phases) {
+    if (options.pin_threads) pin_to_cpu(worker);
+    // The last worker to arrive starts the trace clock for everyone
+    if (ready.fetch_add(1, std::memory_order_acq_rel) + 1 == options.threads)
+        start.store(CoarseClock::now(), std::memory_order_release);
+    uint64_t start_ns;
+    while ((start_ns = start.load(std::memory_order_acquire)) == 0) std::this_thread::yield();
+
+    const double default_ttl = options.config.default_expiry_seconds;
+    for (uint32_t index : events) {
+        const TraceEvent& event = trace.events[index];
+        uint64_t intended;
+        if (options.speed > 0.0) {
+            intended = start_ns + static_cast<uint64_t>(static_cast<double>(event.offset_ns) / options.speed);
+            wait_until(intended);
+        } else {
+            intended = CoarseClock::now();
+        }
+
+        PhaseAccumulator& phase = phases[event.phase];
+        SymbolId symbol = ids[event.symbol];
+        uint64_t end;
+        if (event.kind == TraceEvent::INSERT) {
+            double ttl = (event.ttl_ns ? static_cast<double>(event.ttl_ns) / 1e9 : default_ttl) * options.ttl_scale;
+            bool inserted = cache.insert(event.value, symbol, event.priority, ttl);
+            end = CoarseClock::now();
+            phase.insert_latency.record(end - intended);
+            ++phase.inserts;
+            phase.failed_inserts += !inserted;
+        } else {
+            bool hit;
+            {
+                EpochGuard guard;
+                hit = cache.get_highest_priority(symbol) != nullptr;
+            }
+            end = CoarseClock::now();
+            phase.get_latency.record(end - intended);
+            ++phase.gets;
+            phase.get_hits += hit;
+        }
+        phase.first_ns = std::min(phase.first_ns, intended);
+        phase.last_ns = end;
+    }
+}
+
+template <typename Cache>
+ReplayResult replay_into(const Trace& trace, const ReplayOptions& options, Cache& cache) {
+    std::vector<SymbolId> ids;
+    for (const std::string& name : trace.symbols) ids.push_back(SymbolRegistry::global().intern(name));
+
+    // A symbol's events all go to one worker, in trace order
+    std::vector<std::vector<uint32_t>> partitions(options.threads);
+    for (size_t i = 0; i < trace.events.size(); ++i)
+        partitions[trace.events[i].symbol % options.threads].push_back(static_cast<uint32_t>(i));
+
+    size_t phase_count = std::max<size_t>(trace.phases.size(), 1);
+    std::vector<std::vector<PhaseAccumulator>> accumulators(options.threads,
+                                                            std::vector<PhaseAccumulator>(phase_count));
+    std::atomic<size_t> ready{0};
+    std::atomic<uint64_t> start{0};
+    std::vector<std::thread> threads;
+    for (size_t worker = 0; worker < options.threads; ++worker) {
+        threads.emplace_back([&, worker]() {
+            replay_worker(trace, ids, partitions[worker], options, cache, worker, ready, start, accumulators[worker]);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    ReplayResult result;
+    result.options = options;
+    PhaseAccumulator total;
+    for (size_t phase = 0; phase < phase_count; ++phase) {
+        PhaseAccumulator merged;
+        for (const std::vector<PhaseAccumulator>& worker : accumulators) merged.merge(worker[phase]);
+        total.merge(merged);
+        if (merged.inserts + merged.gets == 0) continue;
+        result.phases.push_back(merged.result(phase < trace.phases.size() ? trace.phases[phase] : "trace"));
+    }
+    result.total = total.result("total");
+    return result;
+}
+
+ReplayTierStats tier_stats(const MultiLevelCache::LevelStats& stats) {
+    ReplayTierStats out;
+    out.items = stats.item_count.load(std::memory_order_relaxed);
+    out.hits = stats.hit_count.load(std::memory_order_relaxed);
+    out.misses = stats.miss_count.load(std::memory_order_relaxed);
+    out.hit_ratio = stats.hit_ratio();
+    return out;
+}
+
+const char* replay_target_name(ReplayTarget target) {
+    return target == ReplayTarget::RADIAL ? "radial" : "multi_level";
+}
+
+// Names come from the trace file, so quote them properly
+void write_json_string(std::ostringstream& out, const std::string& text) {
+    constexpr const char* HEX = "0123456789abcdef";
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) >= 0x20) out << c;
+        else out << "\\u00" << HEX[(c >> 4) & 0xF] << HEX[c & 0xF];
+    }
+    out << '"';
+}
+
+void write_phase_json(std::ostringstream& out, const ReplayPhaseResult& phase) {
+    out << "{\"phase\":";
+    write_json_string(out, phase.phase);
+    out << ",\"inserts\":" << phase.inserts << ",\"gets\":" << phase.gets << ",\"get_hits\":" << phase.get_hits
+        << ",\"failed_inserts\":" << phase.failed_inserts << ",\"seconds\":" << phase.seconds
+        << ",\"throughput\":" << phase.throughput;
+    write_summary_json(out, "insert_latency_ns", phase.insert_latency);
+    write_summary_json(out, "get_latency_ns", phase.get_latency);
+    out << "}";
+}
+
+void write_tier_json(std::ostringstream& out, const char* name, const ReplayTierStats& tier) {
+    out << "\"" << name << "\":{\"items\":" << tier.items << ",\"hits\":" << tier.hits << ",\"misses\":" << tier.misses
+        << ",\"hit_ratio\":" << tier.hit_ratio << "}";
+}
+
+} // namespace
+
+ReplayResult replay_trace(const Trace& trace, const ReplayOptions& requested) {
+    ReplayOptions options = requested;
+    options.threads = std::max<size_t>(options.threads, 1);
+    options.config.enable_metrics = false;
+
+    if (options.target == ReplayTarget::RADIAL) {
+        RadialCircularList cache(options.config);
+        return replay_into(trace, options, cache);
+    }
+    MultiLevelCache cache(options.config);
+    ReplayResult result = replay_into(trace, options, cache);
+    result.has_tiers = true;
+    result.l1 = tier_stats(cache.get_l1_stats());
+    result.l2 = tier_stats(cache.get_l2_stats());
+    result.l3 = tier_stats(cache.get_l3_stats());
+    return result;
+}
+
+std::string format_json(const ReplayResult& result) {
+    const ReplayOptions& options = result.options;
+    std::ostringstream out;
+    out << "{\"replay\":true,\"target\":\"" << replay_target_name(options.target) << "\""
+        << ",\"speed\":" << options.speed << ",\"ttl_scale\":" << options.ttl_scale
+        << ",\"threads\":" << options.threads << ",\"pinned\":" << (options.pin_threads ? "true" : "false")
+        << ",\"max_nodes\":" << options.config.max_nodes << ",\"l1_capacity\":" << options.config.l1_capacity
+        << ",\"phases\":[";
+    for (size_t i = 0; i < result.phases.size(); ++i) {
+        if (i) out << ",";
+        write_phase_json(out, result.phases[i]);
+    }
+    out << "],\"total\":";
+    write_phase_json(out, result.total);
+    if (result.has_tiers) {
+        out << ",\"tiers\":{";
+        write_tier_json(out, "l1", result.l1);
+        out << ",";
+        write_tier_json(out, "l2", result.l2);
+        out << ",";
+        write_tier_json(out, "l3", result.l3);
+        out << "}";
+    }
+    out << "}";
+    return out.str();
+}
+
+std::string replay_csv_header() {
+    return "target,speed,ttl_scale,threads,max_nodes,l1_capacity,phase,inserts,gets,get_hits,failed_inserts,seconds,"
+           "throughput,insert_count,insert_mean_ns,insert_p50_ns,insert_p99_ns,insert_p999_ns,insert_max_ns,"
+           "get_count,get_mean_ns,get_p50_ns,get_p99_ns,get_p999_ns,get_max_ns,l1_hit_ratio,l2_hit_ratio,l3_hit_ratio";
+}
+
+std::string format_csv(const ReplayResult& result) {
+    const ReplayOptions& options = result.options;
+    std::ostringstream out;
+    std::vector<const ReplayPhaseResult*> rows;
+    for (const ReplayPhaseResult& phase : result.phases) rows.push_back(&phase);
+    rows.push_back(&result.total);
+    for (const ReplayPhaseResult* phase : rows) {
+        if (phase != rows.front()) out << "\n";
+        out << replay_target_name(options.target) << "," << options.speed << "," << options.ttl_scale << ","
+            << options.threads << "," << options.config.max_nodes << "," << options.config.l1_capacity << ","
+            << phase->phase << "," << phase->inserts << "," << phase->gets << "," << phase->get_hits << ","
+            << phase->failed_inserts << "," << phase->seconds << "," << phase->throughput;
+        write_summary_csv(out, phase->insert_latency);
+        write_summary_csv(out, phase->get_latency);
+        if (result.has_tiers) {
+            out << "," << result.l1.hit_ratio << "," << result.l2.hit_ratio << "," << result.l3.hit_ratio;
+        } else {
+            out << ",,,";
+        }
+    }
+    return out.str();
+}
+
+
+} // namespace hft_cache
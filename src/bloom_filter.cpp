@@ -1,154 +1,69 @@
 #include "bloom_filter.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cstring>
-#include <iostream>
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HFT_BLOOM_X86 1
+#endif
 
 namespace hft_cache {
 
-// BloomFilter Implementation
-BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate) {
-    bit_array_size_ = calculate_optimal_size(expected_elements, false_positive_rate);
-    hash_function_count_ = calculate_optimal_hash_count(expected_elements, bit_array_size_);
-    
-    // Initialize bit array with atomic uint64_t for thread safety
-    bit_array_.resize((bit_array_size_ + 63) / 64, 0);
-    
-    std::cout << "BloomFilter initialized with " << bit_array_size_ << " bits, "
-              << hash_function_count_ << " hash functions for " << expected_elements 
-              << " expected elements" << std::endl;
-}
+namespace {
 
-void BloomFilter::add(const std::string& key) {
-    uint64_t h1 = hash1(key);
-    uint64_t h2 = hash2(key);
-    
-    for (size_t i = 0; i < hash_function_count_; ++i) {
-        uint64_t hash = h1 + i * h2;
-        size_t index = hash % bit_array_size_;
-        set_bit(index);
-    }
-    
-    added_elements_.fetch_add(1);
-}
+// Odd multipliers that spread the low 32 bits of a hash over the eight
+// words of a block, as in split-block Bloom filters
+alignas(32) constexpr uint32_t SALTS[BloomFilter::BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
 
-bool BloomFilter::might_contain(const std::string& key) const {
-    uint64_t h1 = hash1(key);
-    uint64_t h2 = hash2(key);
-    
-    for (size_t i = 0; i < hash_function_count_; ++i) {
-        uint64_t hash = h1 + i * h2;
-        size_t index = hash % bit_array_size_;
-        if (!get_bit(index)) {
-            return false;
-        }
-    }
-    
-    return true;
+inline uint64_t bit_for(uint32_t key, size_t word) {
+    return uint64_t(1) << ((key * SALTS[word]) >> 26);
 }
 
-void BloomFilter::clear() {
-    for (auto& word : bit_array_) {
-        word.store(0);
+bool probe_scalar(const BloomFilter::Block& block, uint32_t key) {
+    bool present = true;
+    for (size_t i = 0; i < BloomFilter::BLOCK_WORDS; ++i) {
+        uint64_t bit = bit_for(key, i);
+        present &= (block.words[i].load(std::memory_order_relaxed) & bit) == bit;
     }
-    added_elements_.store(0);
-}
-
-size_t BloomFilter::get_bit_array_size() const {
-    return bit_array_size_;
-}
-
-size_t BloomFilter::get_hash_function_count() const {
-    return hash_function_count_;
-}
-
-size_t BloomFilter::get_added_elements() const {
-    return added_elements_.load();
-}
-
-double BloomFilter::get_current_false_positive_rate() const {
-    size_t elements = added_elements_.load();
-    if (elements == 0) return 0.0;
-    
-    // Calculate theoretical false positive rate
-    double p = 1.0 - std::exp(-static_cast<double>(hash_function_count_ * elements) / bit_array_size_);
-    return std::pow(p, hash_function_count_);
-}
-
-void BloomFilter::resize(size_t new_expected_elements, double new_false_positive_rate) {
-    size_t new_size = calculate_optimal_size(new_expected_elements, new_false_positive_rate);
-    size_t new_hash_count = calculate_optimal_hash_count(new_expected_elements, new_size);
-    
-    // Create new bit array
-    std::vector<std::atomic<uint64_t>> new_bit_array((new_size + 63) / 64, 0);
-    
-    // Copy existing data (this is a simplified approach)
-    // In a real implementation, you'd need to rehash all existing elements
-    bit_array_ = std::move(new_bit_array);
-    bit_array_size_ = new_size;
-    hash_function_count_ = new_hash_count;
-    
-    std::cout << "BloomFilter resized to " << new_size << " bits, " 
-              << new_hash_count << " hash functions" << std::endl;
-}
-
-void BloomFilter::optimize_for_workload(size_t actual_elements) {
-    if (actual_elements > 0) {
-        double current_fpr = get_current_false_positive_rate();
-        resize(actual_elements, current_fpr);
-    }
-}
-
-uint64_t BloomFilter::hash1(const std::string& key) const {
-    return murmur_hash3_64(key, 0x1234567890ABCDEF);
-}
-
-uint64_t BloomFilter::hash2(const std::string& key) const {
-    return murmur_hash3_64(key, 0xFEDCBA0987654321);
-}
-
-uint64_t BloomFilter::hash3(const std::string& key) const {
-    return murmur_hash3_64(key, 0xDEADBEEFCAFEBABE);
-}
-
-uint64_t BloomFilter::hash4(const std::string& key) const {
-    return murmur_hash3_64(key, 0xBABECAFEDEADBEEF);
-}
-
-void BloomFilter::set_bit(size_t index) {
-    size_t word_index = index / 64;
-    size_t bit_index = index % 64;
-    uint64_t mask = 1ULL << bit_index;
-    
-    uint64_t old_value = bit_array_[word_index].load();
-    uint64_t new_value;
-    
-    do {
-        new_value = old_value | mask;
-    } while (!bit_array_[word_index].compare_exchange_weak(old_value, new_value));
-}
-
-bool BloomFilter::get_bit(size_t index) const {
-    size_t word_index = index / 64;
-    size_t bit_index = index % 64;
-    uint64_t mask = 1ULL << bit_index;
-    
-    return (bit_array_[word_index].load() & mask) != 0;
-}
-
-size_t BloomFilter::calculate_optimal_size(size_t elements, double false_positive_rate) const {
-    // m = -n * ln(p) / (ln(2)^2)
-    // where m is the number of bits, n is the number of elements, p is the false positive rate
-    double ln2_squared = std::log(2.0) * std::log(2.0);
-    return static_cast<size_t>(-static_cast<double>(elements) * std::log(false_positive_rate) / ln2_squared);
-}
-
-size_t BloomFilter::calculate_optimal_hash_count(size_t elements, size_t size) const {
-    // k = m/n * ln(2)
-    // where k is the number of hash functions, m is the number of bits, n is the number of elements
-    return static_cast<size_t>(static_cast<double>(size) / elements * std::log(2.0));
+    return present;
+}
+
+#ifdef HFT_BLOOM_X86
+// Reads the block with two plain vector loads. Bits only ever go from 0
+// to 1 between clears, so a torn read can only miss a bit set by a
+// concurrent add, which the caller cannot tell from the add landing later.
+__attribute__((target("avx2")))
+bool probe_avx2(const BloomFilter::Block& block, uint32_t key) {
+    const __m256i salts = _mm256_load_si256(reinterpret_cast<const __m256i*>(SALTS));
+    __m256i positions = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), salts), 26);
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i low = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(positions)));
+    __m256i high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(positions, 1)));
+    const __m256i* words = reinterpret_cast<const __m256i*>(block.words);
+    return _mm256_testc_si256(_mm256_load_si256(words), low) & _mm256_testc_si256(_mm256_load_si256(words + 1), high);
+}
+#endif
+
+// Bits per key for eight one-bit-per-word probes to reach the target
+// rate, plus a tenth for blocks loaded above the mean
+double bits_per_key(double false_positive_rate) {
+    double rate = std::clamp(false_positive_rate, 1e-9, 0.5);
+    double per_word = std::pow(rate, 1.0 / BloomFilter::BLOCK_WORDS);
+    return -static_cast<double>(BloomFilter::BLOCK_WORDS) / std::log1p(-per_word) * 1.1;
+}
+
+uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
 }
 
-uint64_t BloomFilter::murmur_hash3_64(const std::string& key, uint64_t seed) const {
+uint64_t murmur_hash3_64(const std::string& key, uint64_t seed) {
     const uint64_t c1 = 0x87c37b91114253d5ULL;
     const uint64_t c2 = 0x4cf5ad432745937fULL;
     
@@ -230,13 +145,119 @@ uint64_t BloomFilter::murmur_hash3_64(const std::string& key, uint64_t seed) con
     return h1;
 }
 
-uint64_t BloomFilter::fmix64(uint64_t k) const {
-    k ^= k >> 33;
-    k *= 0xff51afd7ed558ccdULL;
-    k ^= k >> 33;
-    k *= 0xc4ceb9fe1a85ec53ULL;
-    k ^= k >> 33;
-    return k;
+size_t calculate_optimal_size(size_t elements, double false_positive_rate) {
+    // m = -n * ln(p) / (ln(2)^2)
+    double ln2_squared = std::log(2.0) * std::log(2.0);
+    return std::max<size_t>(1, static_cast<size_t>(-static_cast<double>(elements) * std::log(false_positive_rate) / ln2_squared));
+}
+
+size_t calculate_optimal_hash_count(size_t elements, size_t size) {
+    // k = m/n * ln(2)
+    return std::max<size_t>(1, static_cast<size_t>(static_cast<double>(size) / std::max<size_t>(elements, 1) * std::log(2.0)));
+}
+
+} // namespace
+
+// BloomFilter Implementation
+BloomFilter::BloomFilter(size_t expected_elements, double false_positive_rate, SIMDLevel level)
+    : level_(std::min(level, detect_simd_level())), probe_(probe_scalar) {
+#if defined(HFT_BLOOM_X86) && !defined(__SANITIZE_THREAD__)
+    // The vector loads are invisible to ThreadSanitizer, so its builds stay scalar
+    if (level_ >= SIMDLevel::AVX2) probe_ = probe_avx2;
+#endif
+    if (probe_ == probe_scalar) level_ = SIMDLevel::SCALAR;
+    allocate(expected_elements, false_positive_rate);
+}
+
+void BloomFilter::allocate(size_t elements, double false_positive_rate) {
+    double bits = static_cast<double>(std::max<size_t>(elements, 1)) * bits_per_key(false_positive_rate);
+    constexpr double BLOCK_BITS = BLOCK_WORDS * 64;
+    block_count_ = std::clamp<size_t>(static_cast<size_t>(std::ceil(bits / BLOCK_BITS)), 1, UINT32_MAX);
+    blocks_.reset(new Block[block_count_]);
+    clear();
+}
+
+void BloomFilter::add(uint64_t hash) {
+    Block& block = blocks_[block_of(hash)];
+    uint32_t key = static_cast<uint32_t>(hash);
+    for (size_t i = 0; i < BLOCK_WORDS; ++i) {
+        uint64_t bit = bit_for(key, i);
+        // Skip the write when the bit is already set, so hot blocks stay shared
+        if (!(block.words[i].load(std::memory_order_relaxed) & bit)) {
+            block.words[i].fetch_or(bit, std::memory_order_relaxed);
+        }
+    }
+    added_elements_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BloomFilter::might_contain(uint64_t hash) const {
+    return probe_(blocks_[block_of(hash)], static_cast<uint32_t>(hash));
+}
+
+size_t BloomFilter::might_contain_many(const uint64_t* hashes, size_t n, bool* out) const {
+    // Issue a batch of block loads before probing any, so the misses overlap
+    constexpr size_t BATCH = 16;
+    size_t present = 0;
+    for (size_t start = 0; start < n; start += BATCH) {
+        size_t end = std::min(n, start + BATCH);
+        size_t blocks[BATCH];
+        for (size_t i = start; i < end; ++i) {
+            blocks[i - start] = block_of(hashes[i]);
+            __builtin_prefetch(&blocks_[blocks[i - start]]);
+        }
+        for (size_t i = start; i < end; ++i) {
+            out[i] = probe_(blocks_[blocks[i - start]], static_cast<uint32_t>(hashes[i]));
+            present += out[i];
+        }
+    }
+    return present;
+}
+
+void BloomFilter::clear() {
+    for (size_t b = 0; b < block_count_; ++b) {
+        for (auto& word : blocks_[b].words) word.store(0, std::memory_order_relaxed);
+    }
+    added_elements_.store(0);
+}
+
+uint64_t BloomFilter::hash_key(const std::string& key) {
+    return murmur_hash3_64(key, 0x1234567890ABCDEF);
+}
+
+uint64_t BloomFilter::hash_key(uint64_t key) {
+    return fmix64(key ^ 0x9E3779B97F4A7C15ULL);
+}
+
+size_t BloomFilter::get_bit_array_size() const {
+    return block_count_ * BLOCK_WORDS * 64;
+}
+
+size_t BloomFilter::get_hash_function_count() const {
+    return BLOCK_WORDS;
+}
+
+size_t BloomFilter::get_added_elements() const {
+    return added_elements_.load();
+}
+
+double BloomFilter::get_current_false_positive_rate() const {
+    size_t elements = added_elements_.load();
+    if (elements == 0) return 0.0;
+    // Each key sets one bit in each word of its block
+    double per_block = static_cast<double>(elements) / block_count_;
+    double word_fill = 1.0 - std::exp(-per_block / 64.0);
+    return std::pow(word_fill, static_cast<double>(BLOCK_WORDS));
+}
+
+void BloomFilter::resize(size_t new_expected_elements, double new_false_positive_rate) {
+    allocate(new_expected_elements, new_false_positive_rate);
+}
+
+void BloomFilter::optimize_for_workload(size_t actual_elements) {
+    if (actual_elements > 0) {
+        double current_fpr = get_current_false_positive_rate();
+        resize(actual_elements, current_fpr > 0.0 ? current_fpr : 0.01);
+    }
 }
 
 // ThreadSafeBloomFilter Implementation
@@ -262,34 +283,28 @@ CountingBloomFilter::CountingBloomFilter(size_t expected_elements, double false_
     counter_array_size_ = calculate_optimal_size(expected_elements, false_positive_rate);
     hash_function_count_ = calculate_optimal_hash_count(expected_elements, counter_array_size_);
     
-    // Initialize counter array
-    counter_array_.resize(counter_array_size_, 0);
-    
-    std::cout << "CountingBloomFilter initialized with " << counter_array_size_ << " counters, "
-              << hash_function_count_ << " hash functions for " << expected_elements 
-              << " expected elements" << std::endl;
+    counter_array_.reset(new std::atomic<uint8_t>[counter_array_size_]);
+    clear();
 }
 
-void CountingBloomFilter::add(const std::string& key) {
-    uint64_t h1 = hash1(key);
-    uint64_t h2 = hash2(key);
+void CountingBloomFilter::add(uint64_t hash) {
+    uint64_t h1 = hash;
+    uint64_t h2 = fmix64(hash) | 1;
     
     for (size_t i = 0; i < hash_function_count_; ++i) {
-        uint64_t hash = h1 + i * h2;
-        size_t index = hash % counter_array_size_;
+        size_t index = (h1 + i * h2) % counter_array_size_;
         increment_counter(index);
     }
     
     added_elements_.fetch_add(1);
 }
 
-bool CountingBloomFilter::might_contain(const std::string& key) const {
-    uint64_t h1 = hash1(key);
-    uint64_t h2 = hash2(key);
+bool CountingBloomFilter::might_contain(uint64_t hash) const {
+    uint64_t h1 = hash;
+    uint64_t h2 = fmix64(hash) | 1;
     
     for (size_t i = 0; i < hash_function_count_; ++i) {
-        uint64_t hash = h1 + i * h2;
-        size_t index = hash % counter_array_size_;
+        size_t index = (h1 + i * h2) % counter_array_size_;
         if (get_counter(index) == 0) {
             return false;
         }
@@ -298,16 +313,15 @@ bool CountingBloomFilter::might_contain(const std::string& key) const {
     return true;
 }
 
-bool CountingBloomFilter::remove(const std::string& key) {
-    uint64_t h1 = hash1(key);
-    uint64_t h2 = hash2(key);
+bool CountingBloomFilter::remove(uint64_t hash) {
+    // Check first, so a key that was never added leaves the counters alone
+    if (!might_contain(hash)) return false;
+    uint64_t h1 = hash;
+    uint64_t h2 = fmix64(hash) | 1;
     
     for (size_t i = 0; i < hash_function_count_; ++i) {
-        uint64_t hash = h1 + i * h2;
-        size_t index = hash % counter_array_size_;
-        if (!decrement_counter(index)) {
-            return false;
-        }
+        size_t index = (h1 + i * h2) % counter_array_size_;
+        decrement_counter(index);
     }
     
     added_elements_.fetch_sub(1);
@@ -315,9 +329,7 @@ bool CountingBloomFilter::remove(const std::string& key) {
 }
 
 void CountingBloomFilter::clear() {
-    for (auto& counter : counter_array_) {
-        counter.store(0);
-    }
+    for (size_t i = 0; i < counter_array_size_; ++i) counter_array_[i].store(0);
     added_elements_.store(0);
 }
 
@@ -327,8 +339,8 @@ size_t CountingBloomFilter::get_counter_array_size() const {
 
 size_t CountingBloomFilter::get_max_counter_value() const {
     uint8_t max_value = 0;
-    for (const auto& counter : counter_array_) {
-        uint8_t value = counter.load();
+    for (size_t i = 0; i < counter_array_size_; ++i) {
+        uint8_t value = counter_array_[i].load();
         if (value > max_value) {
             max_value = value;
         }
@@ -338,30 +350,14 @@ size_t CountingBloomFilter::get_max_counter_value() const {
 
 double CountingBloomFilter::get_saturation_rate() const {
     size_t saturated_counters = 0;
-    for (const auto& counter : counter_array_) {
-        if (counter.load() >= 255) { // Assuming 8-bit counters
+    for (size_t i = 0; i < counter_array_size_; ++i) {
+        if (counter_array_[i].load() >= 255) { // Assuming 8-bit counters
             saturated_counters++;
         }
     }
     return static_cast<double>(saturated_counters) / counter_array_size_;
 }
 
-uint64_t CountingBloomFilter::hash1(const std::string& key) const {
-    return murmur_hash3_64(key, 0x1234567890ABCDEF);
-}
-
-uint64_t CountingBloomFilter::hash2(const std::string& key) const {
-    return murmur_hash3_64(key, 0xFEDCBA0987654321);
-}
-
-uint64_t CountingBloomFilter::hash3(const std::string& key) const {
-    return murmur_hash3_64(key, 0xDEADBEEFCAFEBABE);
-}
-
-uint64_t CountingBloomFilter::hash4(const std::string& key) const {
-    return murmur_hash3_64(key, 0xBABECAFEDEADBEEF);
-}
-
 void CountingBloomFilter::increment_counter(size_t index) {
     uint8_t old_value = counter_array_[index].load();
     uint8_t new_value;
@@ -376,8 +372,9 @@ bool CountingBloomFilter::decrement_counter(size_t index) {
     uint8_t new_value;
     
     do {
-        if (old_value == 0) {
-            return false;
+        // A saturated counter has lost count, so it stays put
+        if (old_value == 0 || old_value == 255) {
+            return old_value != 0;
         }
         new_value = old_value - 1;
     } while (!counter_array_[index].compare_exchange_weak(old_value, new_value));
@@ -389,105 +386,229 @@ uint8_t CountingBloomFilter::get_counter(size_t index) const {
     return counter_array_[index].load();
 }
 
-uint64_t CountingBloomFilter::murmur_hash3_64(const std::string& key, uint64_t seed) const {
-    // Same implementation as BloomFilter
-    const uint64_t c1 = 0x87c37b91114253d5ULL;
-    const uint64_t c2 = 0x4cf5ad432745937fULL;
-    
-    uint64_t h1 = seed;
-    uint64_t h2 = seed;
-    
-    const uint64_t* data = reinterpret_cast<const uint64_t*>(key.data());
-    const size_t nblocks = key.length() / 16;
-    
-    // Body
-    for (size_t i = 0; i < nblocks; i++) {
-        uint64_t k1 = data[i * 2];
-        uint64_t k2 = data[i * 2 + 1];
-        
-        k1 *= c1;
-        k1 = (k1 << 31) | (k1 >> 33);
-        k1 *= c2;
-        h1 ^= k1;
-        
-        h1 = (h1 << 27) | (h1 >> 37);
-        h1 += h2;
-        h1 = h1 * 5 + 0x52dce729;
-        
-        k2 *= c2;
-        k2 = (k2 << 33) | (k2 >> 31);
-        k2 *= c1;
-        h2 ^= k2;
-        
-        h2 = (h2 << 31) | (h2 >> 33);
-        h2 += h1;
-        h2 = h2 * 5 + 0x38495ab5;
+// CuckooFilter Implementation
+namespace {
+
+constexpr uint64_t LANE_LOW = 0x0001000100010001ULL;
+constexpr uint64_t LANE_HIGH = 0x8000800080008000ULL;
+
+inline uint16_t lane(uint64_t bucket, size_t slot) {
+    return static_cast<uint16_t>(bucket >> (16 * slot));
+}
+
+inline uint64_t with_lane(uint64_t bucket, size_t slot, uint16_t fingerprint) {
+    return (bucket & ~(uint64_t(0xFFFF) << (16 * slot))) | (uint64_t(fingerprint) << (16 * slot));
+}
+
+// Nonzero exactly when some 16-bit lane of bucket equals fingerprint
+inline bool holds(uint64_t bucket, uint16_t fingerprint) {
+    uint64_t x = bucket ^ (LANE_LOW * fingerprint);
+    return ((x - LANE_LOW) & ~x & LANE_HIGH) != 0;
+}
+
+} // namespace
+
+CuckooFilter::CuckooFilter(size_t expected_elements) {
+    size_t wanted = static_cast<size_t>(std::ceil(std::max<size_t>(expected_elements, 1) / (SLOTS * MAX_LOAD)));
+    size_t buckets = 2;
+    while (buckets < wanted) buckets <<= 1;
+    mask_ = buckets - 1;
+    buckets_.reset(new std::atomic<uint64_t>[buckets]);
+    clear();
+}
+
+uint16_t CuckooFilter::fingerprint(uint64_t hash) {
+    // The top bits, which the bucket index never uses; 0 marks an empty slot
+    uint16_t fingerprint = static_cast<uint16_t>(hash >> 48);
+    return fingerprint ? fingerprint : 1;
+}
+
+size_t CuckooFilter::alternate(size_t bucket, uint16_t fingerprint) const {
+    uint64_t h = fingerprint * 0xC6A4A7935BD1E995ULL;
+    return (bucket ^ (h ^ (h >> 29))) & mask_;
+}
+
+uint64_t CuckooFilter::next_random() {
+    random_state_ ^= random_state_ << 13;
+    random_state_ ^= random_state_ >> 7;
+    random_state_ ^= random_state_ << 17;
+    return random_state_;
+}
+
+bool CuckooFilter::place(size_t bucket, uint16_t fingerprint) {
+    uint64_t word = buckets_[bucket].load(std::memory_order_relaxed);
+    if (!holds(word, 0)) return false;
+    for (size_t slot = 0; slot < SLOTS; ++slot) {
+        if (lane(word, slot) == 0) {
+            buckets_[bucket].store(with_lane(word, slot, fingerprint), std::memory_order_relaxed);
+            return true;
+        }
     }
-    
-    // Tail
-    const uint8_t* tail = reinterpret_cast<const uint8_t*>(data + nblocks * 2);
-    uint64_t k1 = 0;
-    uint64_t k2 = 0;
-    
-    switch (key.length() & 15) {
-        case 15: k2 ^= static_cast<uint64_t>(tail[14]) << 48; [[fallthrough]];
-        case 14: k2 ^= static_cast<uint64_t>(tail[13]) << 40; [[fallthrough]];
-        case 13: k2 ^= static_cast<uint64_t>(tail[12]) << 32; [[fallthrough]];
-        case 12: k2 ^= static_cast<uint64_t>(tail[11]) << 24; [[fallthrough]];
-        case 11: k2 ^= static_cast<uint64_t>(tail[10]) << 16; [[fallthrough]];
-        case 10: k2 ^= static_cast<uint64_t>(tail[9]) << 8; [[fallthrough]];
-        case 9:  k2 ^= static_cast<uint64_t>(tail[8]) << 0;
-                 k2 *= c2;
-                 k2 = (k2 << 33) | (k2 >> 31);
-                 k2 *= c1;
-                 h2 ^= k2;
-                 [[fallthrough]];
-        case 8:  k1 ^= static_cast<uint64_t>(tail[7]) << 56; [[fallthrough]];
-        case 7:  k1 ^= static_cast<uint64_t>(tail[6]) << 48; [[fallthrough]];
-        case 6:  k1 ^= static_cast<uint64_t>(tail[5]) << 40; [[fallthrough]];
-        case 5:  k1 ^= static_cast<uint64_t>(tail[4]) << 32; [[fallthrough]];
-        case 4:  k1 ^= static_cast<uint64_t>(tail[3]) << 24; [[fallthrough]];
-        case 3:  k1 ^= static_cast<uint64_t>(tail[2]) << 16; [[fallthrough]];
-        case 2:  k1 ^= static_cast<uint64_t>(tail[1]) << 8; [[fallthrough]];
-        case 1:  k1 ^= static_cast<uint64_t>(tail[0]) << 0;
-                 k1 *= c1;
-                 k1 = (k1 << 31) | (k1 >> 33);
-                 k1 *= c2;
-                 h1 ^= k1;
+    return false;
+}
+
+bool CuckooFilter::erase(size_t bucket, uint16_t fingerprint) {
+    uint64_t word = buckets_[bucket].load(std::memory_order_relaxed);
+    if (!holds(word, fingerprint)) return false;
+    for (size_t slot = 0; slot < SLOTS; ++slot) {
+        if (lane(word, slot) == fingerprint) {
+            buckets_[bucket].store(with_lane(word, slot, 0), std::memory_order_relaxed);
+            return true;
+        }
     }
-    
-    // Finalization
-    h1 ^= key.length();
-    h2 ^= key.length();
-    
-    h1 += h2;
-    h2 += h1;
-    
-    h1 = fmix64(h1);
-    h2 = fmix64(h2);
-    
-    h1 += h2;
-    h2 += h1;
-    
-    return h1;
+    return false;
 }
 
-uint64_t CountingBloomFilter::fmix64(uint64_t k) const {
-    k ^= k >> 33;
-    k *= 0xff51afd7ed558ccdULL;
-    k ^= k >> 33;
-    k *= 0xc4ceb9fe1a85ec53ULL;
-    k ^= k >> 33;
-    return k;
+bool CuckooFilter::add(uint64_t hash) {
+    uint16_t fp = fingerprint(hash);
+    size_t first = hash & mask_;
+    size_t second = alternate(first, fp);
+    std::lock_guard<SpinLock> guard(write_lock_);
+    if (place(first, fp) || place(second, fp)) {
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (victim_.load(std::memory_order_relaxed)) return false;
+
+    // Evict along a random walk. Lookups that miss while the version is
+    // odd retry, since the fingerprint in hand is in no bucket.
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t bucket = (next_random() & 1) ? first : second;
+    bool placed = false;
+    for (size_t kick = 0; kick < MAX_KICKS && !placed; ++kick) {
+        size_t slot = next_random() % SLOTS;
+        uint64_t word = buckets_[bucket].load(std::memory_order_relaxed);
+        uint16_t evicted = lane(word, slot);
+        buckets_[bucket].store(with_lane(word, slot, fp), std::memory_order_relaxed);
+        fp = evicted;
+        bucket = alternate(bucket, fp);
+        placed = place(bucket, fp);
+    }
+    if (!placed) victim_.store(uint64_t(bucket) << 16 | fp, std::memory_order_relaxed);
+    version_.store(version + 2, std::memory_order_release);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
 }
 
-size_t CountingBloomFilter::calculate_optimal_size(size_t elements, double false_positive_rate) const {
-    double ln2_squared = std::log(2.0) * std::log(2.0);
-    return static_cast<size_t>(-static_cast<double>(elements) * std::log(false_positive_rate) / ln2_squared);
+bool CuckooFilter::might_contain(uint64_t hash) const {
+    uint16_t fp = fingerprint(hash);
+    size_t first = hash & mask_;
+    size_t second = alternate(first, fp);
+    while (true) {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        if (holds(buckets_[first].load(std::memory_order_relaxed), fp) ||
+            holds(buckets_[second].load(std::memory_order_relaxed), fp)) {
+            return true;
+        }
+        uint64_t victim = victim_.load(std::memory_order_relaxed);
+        if (victim && static_cast<uint16_t>(victim) == fp) {
+            size_t bucket = static_cast<size_t>(victim >> 16);
+            if (bucket == first || bucket == second) return true;
+        }
+        if (!(version & 1)) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version_.load(std::memory_order_relaxed) == version) return false;
+        }
+        cpu_relax();
+    }
 }
 
-size_t CountingBloomFilter::calculate_optimal_hash_count(size_t elements, size_t size) const {
-    return static_cast<size_t>(static_cast<double>(size) / elements * std::log(2.0));
+bool CuckooFilter::remove(uint64_t hash) {
+    uint16_t fp = fingerprint(hash);
+    size_t first = hash & mask_;
+    size_t second = alternate(first, fp);
+    std::lock_guard<SpinLock> guard(write_lock_);
+    uint64_t victim = victim_.load(std::memory_order_relaxed);
+    if (victim && static_cast<uint16_t>(victim) == fp &&
+        (static_cast<size_t>(victim >> 16) == first || static_cast<size_t>(victim >> 16) == second)) {
+        victim_.store(0, std::memory_order_relaxed);
+        count_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (!erase(first, fp) && !erase(second, fp)) return false;
+    count_.fetch_sub(1, std::memory_order_relaxed);
+    // The freed slot may be the one the parked fingerprint was waiting for.
+    // It goes in before it leaves victim_, so lookups see it throughout.
+    if (victim) {
+        size_t bucket = static_cast<size_t>(victim >> 16);
+        uint16_t parked = static_cast<uint16_t>(victim);
+        if (place(bucket, parked) || place(alternate(bucket, parked), parked)) {
+            victim_.store(0, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+void CuckooFilter::clear() {
+    for (size_t i = 0; i <= mask_; ++i) buckets_[i].store(0, std::memory_order_relaxed);
+    victim_.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+}
+
+double CuckooFilter::get_saturation_rate() const {
+    return static_cast<double>(size()) / static_cast<double>(get_bucket_count() * SLOTS);
+}
+
+double CuckooFilter::get_current_false_positive_rate() const {
+    // A lookup compares against both buckets' occupied slots
+    double compared = 2.0 * SLOTS * get_saturation_rate();
+    return 1.0 - std::pow(1.0 - 1.0 / 65535.0, compared);
+}
+
+namespace {
+
+template <typename Filter>
+MembershipBenchmarkResult time_filter(const char* name, Filter& filter, const std::vector<uint64_t>& present,
+                                      const std::vector<uint64_t>& absent) {
+    using Clock = std::chrono::steady_clock;
+    auto per_key = [&present](Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / present.size();
+    };
+    MembershipBenchmarkResult result;
+    result.filter = name;
+    result.keys = present.size();
+    result.bits_per_key = 8.0 * filter.memory_bytes() / present.size();
+
+    auto start = Clock::now();
+    for (uint64_t hash : present) filter.add(hash);
+    result.insert_ns = per_key(start);
+
+    size_t hits = 0;
+    start = Clock::now();
+    for (uint64_t hash : present) hits += filter.might_contain(hash);
+    result.lookup_hit_ns = per_key(start);
+
+    size_t false_positives = 0;
+    start = Clock::now();
+    for (uint64_t hash : absent) false_positives += filter.might_contain(hash);
+    result.lookup_miss_ns = per_key(start);
+    result.false_positive_rate = static_cast<double>(false_positives) / absent.size();
+
+    start = Clock::now();
+    for (uint64_t hash : present) hits -= filter.remove(hash);
+    result.remove_ns = per_key(start);
+    // Keeps the loops from being optimized away
+    if (hits == SIZE_MAX) result.false_positive_rate = -1.0;
+    return result;
+}
+
+} // namespace
+
+std::vector<MembershipBenchmarkResult> benchmark_membership_filters(size_t keys, double false_positive_rate) {
+    keys = std::max<size_t>(keys, 1);
+    std::vector<uint64_t> present(keys), absent(keys);
+    for (size_t i = 0; i < keys; ++i) {
+        present[i] = BloomFilter::hash_key(uint64_t(i));
+        absent[i] = BloomFilter::hash_key(uint64_t(keys + i));
+    }
+    std::vector<MembershipBenchmarkResult> results;
+    CountingBloomFilter counting(keys, false_positive_rate);
+    results.push_back(time_filter("CountingBloomFilter", counting, present, absent));
+    CuckooFilter cuckoo(keys);
+    results.push_back(time_filter("CuckooFilter", cuckoo, present, absent));
+    return results;
 }
 
-} // namespace hft_cache 
\ No newline at end of file
+} // namespace hft_cache
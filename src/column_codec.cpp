@@ -0,0 +1,280 @@
+#include "column_codec.hpp"
+#include <cstring>
+
+namespace {
+
+// Block header; bytes counts the header and is a multiple of 8
+struct BlockHeader {
+    uint32_t rows;
+    uint32_t bytes;
+};
+
+static_assert(sizeof(BlockHeader) == ColumnCodec::BLOCK_HEADER_BYTES, "block header layout");
+
+uint64_t low_bits(unsigned bits) { return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1; }
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+// LSB-first bit stream into whole 64-bit words
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void put(uint64_t value, unsigned bits) {
+        if (bits == 0) return;
+        value &= low_bits(bits);
+        accumulator_ |= value << fill_;
+        unsigned room = 64 - fill_;
+        if (bits < room) {
+            fill_ += bits;
+            return;
+        }
+        emit(accumulator_);
+        accumulator_ = room < 64 ? value >> room : 0;
+        fill_ = bits - room;
+    }
+
+    void finish() {
+        if (fill_) emit(accumulator_);
+        accumulator_ = 0;
+        fill_ = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint64_t accumulator_ = 0;
+    unsigned fill_ = 0;
+
+    void emit(uint64_t word) {
+        size_t at = out_.size();
+        out_.resize(at + sizeof(word));
+        std::memcpy(out_.data() + at, &word, sizeof(word));
+    }
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t words) : data_(data), words_(words) {}
+
+    uint64_t get(unsigned bits) {
+        if (bits <= available_) {
+            uint64_t result = buffer_ & low_bits(bits);
+            buffer_ = bits < 64 ? buffer_ >> bits : 0;
+            available_ -= bits;
+            return result;
+        }
+        uint64_t word = 0;
+        if (next_ < words_) {
+            std::memcpy(&word, data_ + next_ * sizeof(word), sizeof(word));
+            ++next_;
+        } else {
+            overrun_ = true;
+        }
+        unsigned have = available_;
+        uint64_t result = (buffer_ | (word << have)) & low_bits(bits);
+        unsigned used = bits - have;
+        buffer_ = used < 64 ? word >> used : 0;
+        available_ = 64 - used;
+        return result;
+    }
+
+    bool bit() { return get(1) != 0; }
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t* data_;
+    size_t words_;
+    size_t next_ = 0;
+    uint64_t buffer_ = 0;
+    unsigned available_ = 0;
+    bool overrun_ = false;
+};
+
+// Delta-of-delta buckets after the leading ones of the prefix: 0 bits for
+// '0', then 8, 16, 32 and 64 for '10', '110', '1110' and '1111'
+constexpr unsigned DOD_WIDTHS[] = {8, 16, 32, 64};
+
+void encode_series(BitWriter& writer, const uint64_t* series, size_t count) {
+    writer.put(series[0], 64);
+    if (count == 1) return;
+    uint64_t delta = series[1] - series[0];
+    bool constant = true;
+    for (size_t i = 2; i < count && constant; ++i) constant = series[i] - series[i - 1] == delta;
+    writer.put(constant, 1);
+    writer.put(delta, 64);
+    if (constant) return;
+    for (size_t i = 2; i < count; ++i) {
+        uint64_t next = series[i] - series[i - 1];
+        uint64_t encoded = zigzag(static_cast<int64_t>(next - delta));
+        delta = next;
+        if (encoded == 0) {
+            writer.put(0, 1);
+            continue;
+        }
+        unsigned bucket = 0;
+        while (bucket < 3 && encoded > low_bits(DOD_WIDTHS[bucket])) ++bucket;
+        // bucket + 1 ones, then a zero unless it is the last bucket
+        unsigned prefix_bits = bucket < 3 ? bucket + 2 : 4;
+        writer.put(low_bits(bucket + 1), prefix_bits);
+        writer.put(encoded, DOD_WIDTHS[bucket]);
+    }
+}
+
+void decode_series(BitReader& reader, uint64_t* series, size_t count) {
+    series[0] = reader.get(64);
+    if (count == 1) return;
+    bool constant = reader.bit();
+    uint64_t delta = reader.get(64);
+    series[1] = series[0] + delta;
+    if (constant) {
+        for (size_t i = 2; i < count; ++i) series[i] = series[i - 1] + delta;
+        return;
+    }
+    for (size_t i = 2; i < count; ++i) {
+        if (reader.bit()) {
+            unsigned bucket = 0;
+            while (bucket < 3 && reader.bit()) ++bucket;
+            delta += static_cast<uint64_t>(unzigzag(reader.get(DOD_WIDTHS[bucket])));
+        }
+        series[i] = series[i - 1] + delta;
+    }
+}
+
+void encode_values(BitWriter& writer, const double* values, size_t count) {
+    uint64_t previous;
+    std::memcpy(&previous, &values[0], sizeof(previous));
+    writer.put(previous, 64);
+    unsigned window_leading = 65;  // no window yet
+    unsigned window_trailing = 0;
+    for (size_t i = 1; i < count; ++i) {
+        uint64_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        uint64_t x = bits ^ previous;
+        previous = bits;
+        if (x == 0) {
+            writer.put(0, 1);
+            continue;
+        }
+        unsigned leading = static_cast<unsigned>(__builtin_clzll(x));
+        unsigned trailing = static_cast<unsigned>(__builtin_ctzll(x));
+        if (leading > 31) leading = 31;
+        if (window_leading <= 64 && leading >= window_leading && trailing >= window_trailing) {
+            // '1' '0': the meaningful bits fit the previous window
+            writer.put(0b01, 2);
+            writer.put(x >> window_trailing, 64 - window_leading - window_trailing);
+            continue;
+        }
+        unsigned length = 64 - leading - trailing;
+        writer.put(0b11, 2);
+        writer.put(leading, 5);
+        writer.put(length & 63, 6);  // 64 wraps to 0
+        writer.put(x >> trailing, length);
+        window_leading = leading;
+        window_trailing = trailing;
+    }
+}
+
+void decode_values(BitReader& reader, double* values, size_t count) {
+    uint64_t previous = reader.get(64);
+    std::memcpy(&values[0], &previous, sizeof(previous));
+    unsigned window_leading = 0;
+    unsigned window_length = 64;
+    unsigned window_trailing = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (reader.bit()) {
+            if (reader.bit()) {
+                window_leading = static_cast<unsigned>(reader.get(5));
+                window_length = static_cast<unsigned>(reader.get(6));
+                if (window_length == 0) window_length = 64;
+                if (window_leading + window_length > 64) window_length = 64 - window_leading;
+                window_trailing = 64 - window_leading - window_length;
+            }
+            previous ^= reader.get(window_length) << window_trailing;
+        }
+        std::memcpy(&values[i], &previous, sizeof(previous));
+    }
+}
+
+void encode_priorities(BitWriter& writer, const int32_t* priorities, size_t count) {
+    int32_t low = priorities[0];
+    int32_t high = priorities[0];
+    for (size_t i = 1; i < count; ++i) {
+        if (priorities[i] < low) low = priorities[i];
+        if (priorities[i] > high) high = priorities[i];
+    }
+    uint32_t range = static_cast<uint32_t>(high) - static_cast<uint32_t>(low);
+    unsigned width = range ? 32 - static_cast<unsigned>(__builtin_clz(range)) : 0;
+    writer.put(static_cast<uint32_t>(low), 32);
+    writer.put(width, 6);
+    if (width == 0) return;
+    for (size_t i = 0; i < count; ++i) {
+        writer.put(static_cast<uint32_t>(priorities[i]) - static_cast<uint32_t>(low), width);
+    }
+}
+
+void decode_priorities(BitReader& reader, int32_t* priorities, size_t count) {
+    uint32_t low = static_cast<uint32_t>(reader.get(32));
+    unsigned width = static_cast<unsigned>(reader.get(6));
+    if (width > 32) width = 32;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t offset = width ? static_cast<uint32_t>(reader.get(width)) : 0;
+        priorities[i] = static_cast<int32_t>(low + offset);
+    }
+}
+
+} // namespace
+
+void ColumnCodec::Columns::reserve(size_t rows) {
+    values.reserve(rows);
+    timestamps.reserve(rows);
+    lifetimes.reserve(rows);
+    priorities.reserve(rows);
+}
+
+void ColumnCodec::Columns::resize(size_t rows) {
+    values.resize(rows);
+    timestamps.resize(rows);
+    lifetimes.resize(rows);
+    priorities.resize(rows);
+}
+
+size_t ColumnCodec::encode(const Columns& columns, size_t first, size_t count, std::vector<uint8_t>& out) {
+    size_t start = out.size();
+    out.resize(start + sizeof(BlockHeader));
+    if (count) {
+        BitWriter writer(out);
+        encode_series(writer, columns.timestamps.data() + first, count);
+        encode_series(writer, columns.lifetimes.data() + first, count);
+        encode_values(writer, columns.values.data() + first, count);
+        encode_priorities(writer, columns.priorities.data() + first, count);
+        writer.finish();
+    }
+    BlockHeader header{static_cast<uint32_t>(count), static_cast<uint32_t>(out.size() - start)};
+    std::memcpy(out.data() + start, &header, sizeof(header));
+    return header.bytes;
+}
+
+bool ColumnCodec::block_extent(const uint8_t* data, size_t length, size_t& bytes, size_t& rows) {
+    if (length < sizeof(BlockHeader)) return false;
+    BlockHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.bytes < sizeof(header) || header.bytes > length || header.bytes % 8 != 0) return false;
+    bytes = header.bytes;
+    rows = header.rows;
+    return true;
+}
+
+size_t ColumnCodec::decode(const uint8_t* data, size_t length, Columns& columns) {
+    size_t bytes = 0;
+    size_t rows = 0;
+    if (!block_extent(data, length, bytes, rows) || rows > MAX_BLOCK_ROWS) return 0;
+    columns.resize(rows);
+    if (rows == 0) return bytes;
+    BitReader reader(data + sizeof(BlockHeader), (bytes - sizeof(BlockHeader)) / 8);
+    decode_series(reader, columns.timestamps.data(), rows);
+    decode_series(reader, columns.lifetimes.data(), rows);
+    decode_values(reader, columns.values.data(), rows);
+    decode_priorities(reader, columns.priorities.data(), rows);
+    return reader.overrun() ? 0 : bytes;
+}
@@ -0,0 +1,116 @@
+#include "epoch_reclamation.hpp"
+#include <algorithm>
+
+// Per-thread registration with the global manager. Records are never freed:
+// when a thread exits its record is parked for reuse and any memory it had
+// not yet freed moves to the orphan list, which the next collect() drains.
+struct EpochThreadHandle {
+    EpochManager::ThreadRecord* record = nullptr;
+
+    ~EpochThreadHandle() {
+        if (record) EpochManager::global().release_record(record);
+    }
+};
+
+namespace {
+thread_local EpochThreadHandle epoch_thread_handle;
+}
+
+EpochManager& EpochManager::global() {
+    // Deliberately leaked so thread-exit handlers can still reach it during shutdown
+    static EpochManager* manager = new EpochManager();
+    return *manager;
+}
+
+EpochManager::ThreadRecord& EpochManager::local() {
+    if (!epoch_thread_handle.record) epoch_thread_handle.record = acquire_record();
+    return *epoch_thread_handle.record;
+}
+
+EpochManager::ThreadRecord* EpochManager::acquire_record() {
+    for (ThreadRecord* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+        bool free_record = false;
+        if (!record->in_use.load(std::memory_order_relaxed) &&
+            record->in_use.compare_exchange_strong(free_record, true, std::memory_order_acq_rel)) {
+            return record;
+        }
+    }
+
+    ThreadRecord* record = new ThreadRecord();
+    record->bag.reserve(COLLECT_THRESHOLD * 2);
+    ThreadRecord* head = records_.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    return record;
+}
+
+void EpochManager::release_record(ThreadRecord* record) {
+    record->depth = 0;
+    record->epoch.store(0, std::memory_order_release);
+    if (!record->bag.empty()) {
+        std::lock_guard<std::mutex> lock(orphan_mutex_);
+        orphans_.insert(orphans_.end(), record->bag.begin(), record->bag.end());
+        has_orphans_.store(true, std::memory_order_release);
+        record->bag.clear();
+    }
+    record->in_use.store(false, std::memory_order_release);
+}
+
+void EpochManager::enter() {
+    ThreadRecord& record = local();
+    if (record.depth++ == 0) {
+        record.epoch.store(epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        // Publish the epoch before any shared pointer is read
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void EpochManager::exit() {
+    ThreadRecord& record = local();
+    if (--record.depth == 0) record.epoch.store(0, std::memory_order_release);
+}
+
+bool EpochManager::in_critical_section() const {
+    return epoch_thread_handle.record && epoch_thread_handle.record->depth > 0;
+}
+
+bool EpochManager::try_advance() {
+    uint64_t epoch = epoch_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (ThreadRecord* record = records_.load(std::memory_order_acquire); record; record = record->next) {
+        uint64_t observed = record->epoch.load(std::memory_order_acquire);
+        if (observed != 0 && observed != epoch) return false;
+    }
+    return epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+}
+
+void EpochManager::retire(void* ptr, Deleter deleter) {
+    ThreadRecord& record = local();
+    record.bag.push_back(Retired{ptr, deleter, epoch_.load(std::memory_order_acquire)});
+    if (record.bag.size() >= COLLECT_THRESHOLD) collect();
+}
+
+void EpochManager::free_safe(std::vector<Retired>& bag, uint64_t epoch) {
+    // Retire epochs never decrease, so the safe entries form a prefix
+    auto safe_end = std::find_if(bag.begin(), bag.end(),
+                                 [epoch](const Retired& retired) { return epoch < retired.epoch + 2; });
+    for (auto it = bag.begin(); it != safe_end; ++it) it->deleter(it->ptr);
+    bag.erase(bag.begin(), safe_end);
+}
+
+void EpochManager::collect() {
+    try_advance();
+    uint64_t epoch = current_epoch();
+    free_safe(local().bag, epoch);
+
+    if (has_orphans_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(orphan_mutex_);
+        // Orphans come from many threads, so they are not ordered by epoch
+        auto safe_end = std::partition(orphans_.begin(), orphans_.end(),
+                                       [epoch](const Retired& retired) { return epoch >= retired.epoch + 2; });
+        for (auto it = orphans_.begin(); it != safe_end; ++it) it->deleter(it->ptr);
+        orphans_.erase(orphans_.begin(), safe_end);
+        has_orphans_.store(!orphans_.empty(), std::memory_order_release);
+    }
+}
@@ -269,7 +269,7 @@ void ErrorHandler::check_error_thresholds() {
     }
     
     // Check for consecutive failures
-    int consecutive_failures = 0;
+    uint64_t consecutive_failures = 0;
     for (auto it = recent_errors.rbegin(); it != recent_errors.rend(); ++it) {
         if (it->severity >= ErrorSeverity::HIGH) {
             consecutive_failures++;
@@ -294,7 +294,7 @@ void ErrorHandler::trigger_emergency_mode() {
 }
 
 // Recovery strategy implementations
-bool ErrorHandler::handle_memory_allocation_failure(const ErrorInfo& error) {
+bool ErrorHandler::handle_memory_allocation_failure(const ErrorInfo& /*error*/) {
     std::cout << "Attempting memory allocation failure recovery..." << std::endl;
     
     // Try to free some memory
@@ -305,7 +305,7 @@ bool ErrorHandler::handle_memory_allocation_failure(const ErrorInfo& error) {
     return true;  // Assume recovery succeeded
 }
 
-bool ErrorHandler::handle_memory_corruption(const ErrorInfo& error) {
+bool ErrorHandler::handle_memory_corruption(const ErrorInfo& /*error*/) {
     std::cout << "Attempting memory corruption recovery..." << std::endl;
     
     // In a real implementation, this would:
@@ -317,7 +317,7 @@ bool ErrorHandler::handle_memory_corruption(const ErrorInfo& error) {
     return true;  // Assume recovery succeeded
 }
 
-bool ErrorHandler::handle_thread_contention(const ErrorInfo& error) {
+bool ErrorHandler::handle_thread_contention(const ErrorInfo& /*error*/) {
     std::cout << "Attempting thread contention recovery..." << std::endl;
     
     // In a real implementation, this would:
@@ -329,7 +329,7 @@ bool ErrorHandler::handle_thread_contention(const ErrorInfo& error) {
     return true;  // Assume recovery succeeded
 }
 
-bool ErrorHandler::handle_data_corruption(const ErrorInfo& error) {
+bool ErrorHandler::handle_data_corruption(const ErrorInfo& /*error*/) {
     std::cout << "Attempting data corruption recovery..." << std::endl;
     
     // In a real implementation, this would:
@@ -341,7 +341,7 @@ bool ErrorHandler::handle_data_corruption(const ErrorInfo& error) {
     return true;  // Assume recovery succeeded
 }
 
-bool ErrorHandler::handle_numa_error(const ErrorInfo& error) {
+bool ErrorHandler::handle_numa_error(const ErrorInfo& /*error*/) {
     std::cout << "Attempting NUMA error recovery..." << std::endl;
     
     // In a real implementation, this would:
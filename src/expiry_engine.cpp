@@ -0,0 +1,35 @@
+#include "expiry_engine.hpp"
+#include "clock.hpp"
+#include <utility>
+
+ExpiryEngine::ExpiryEngine(PurgeFn purge) : purge_(std::move(purge)), wheel_(CoarseClock::now()) {}
+
+void ExpiryEngine::schedule(SymbolId symbol, uint64_t deadline_ns) {
+    std::lock_guard<SpinLock> guard(incoming_lock_);
+    incoming_.push_back(TimerWheel::Entry{deadline_ns, symbol});
+}
+
+size_t ExpiryEngine::run(uint64_t now_ns, size_t max_nodes) {
+    std::unique_lock<std::mutex> lock(run_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) return 0;
+
+    {
+        std::lock_guard<SpinLock> guard(incoming_lock_);
+        drained_.swap(incoming_);
+    }
+    for (const auto& entry : drained_) wheel_.schedule(entry.symbol, entry.deadline_ns, due_);
+    drained_.clear();
+    wheel_.advance(now_ns, due_);
+
+    size_t expired = 0;
+    while (!due_.empty() && expired < max_nodes) {
+        SymbolId symbol = due_.back().symbol;
+        due_.pop_back();
+        uint64_t next_deadline = UINT64_MAX;
+        expired += purge_(symbol, now_ns, max_nodes - expired, next_deadline);
+        if (next_deadline != UINT64_MAX) wheel_.schedule(symbol, next_deadline, due_);
+    }
+
+    total_expired_.fetch_add(expired, std::memory_order_relaxed);
+    return expired;
+}
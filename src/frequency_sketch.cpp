@@ -0,0 +1,76 @@
+#include "frequency_sketch.hpp"
+#include <algorithm>
+
+namespace hft_cache {
+
+namespace {
+
+constexpr uint64_t ROW_SEEDS[4] = {
+    0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL,
+};
+// Every nibble keeps its top three bits after the shift
+constexpr uint64_t HALVE_MASK = 0x7777777777777777ULL;
+
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expected_entries, size_t sample_factor) {
+    size_t width = 1;
+    while (width < std::max<size_t>(expected_entries, 16)) width <<= 1;
+    table_.reset(new std::atomic<uint64_t>[width]);
+    for (size_t i = 0; i < width; ++i) table_[i].store(0, std::memory_order_relaxed);
+    mask_ = width - 1;
+    sample_size_ = width * std::max<size_t>(sample_factor, 1);
+}
+
+uint64_t FrequencySketch::mix(uint64_t key, size_t row) {
+    uint64_t h = (key + ROW_SEEDS[row]) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 29);
+}
+
+bool FrequencySketch::increment_at(size_t word, size_t counter) {
+    const unsigned shift = static_cast<unsigned>(counter * 4);
+    std::atomic<uint64_t>& slot = table_[word];
+    uint64_t current = slot.load(std::memory_order_relaxed);
+    while (((current >> shift) & 0xF) < MAX_FREQUENCY) {
+        if (slot.compare_exchange_weak(current, current + (uint64_t(1) << shift), std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrequencySketch::increment(uint64_t key) {
+    bool added = false;
+    for (size_t row = 0; row < ROWS; ++row) {
+        uint64_t h = mix(key, row);
+        // Row r owns counters 4r..4r+3 of each word, so rows never share a counter
+        added |= increment_at(h & mask_, row * 4 + (h >> 62));
+    }
+    if (added && additions_.fetch_add(1, std::memory_order_relaxed) + 1 == sample_size_) age();
+}
+
+uint32_t FrequencySketch::frequency(uint64_t key) const {
+    uint32_t result = MAX_FREQUENCY;
+    for (size_t row = 0; row < ROWS; ++row) {
+        uint64_t h = mix(key, row);
+        unsigned shift = static_cast<unsigned>((row * 4 + (h >> 62)) * 4);
+        uint64_t word = table_[h & mask_].load(std::memory_order_relaxed);
+        result = std::min(result, static_cast<uint32_t>((word >> shift) & 0xF));
+    }
+    return result;
+}
+
+void FrequencySketch::age() {
+    // Only the thread whose increment hit sample_size_ gets here
+    for (size_t i = 0; i <= mask_; ++i) {
+        uint64_t current = table_[i].load(std::memory_order_relaxed);
+        while (!table_[i].compare_exchange_weak(current, (current >> 1) & HALVE_MASK, std::memory_order_relaxed)) {
+        }
+    }
+    additions_.store(sample_size_ / 2, std::memory_order_relaxed);
+    agings_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace hft_cache
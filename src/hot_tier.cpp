@@ -0,0 +1,162 @@
+#include "hot_tier.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace hft_cache {
+
+HotTier::HotTier(size_t capacity, size_t entries_per_symbol)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      entries_per_symbol_(std::clamp<size_t>(entries_per_symbol, 1, MAX_ENTRIES_PER_SYMBOL)),
+      ring_(new Slot[capacity_]) {}
+
+HotTier::~HotTier() {
+    std::vector<Node*> nodes;
+    drain(nodes);
+    for (Node* node : nodes) delete node;
+}
+
+Node* HotTier::unlink(Entries& entries, uint32_t index) {
+    Node* node = entries.nodes[index];
+    ring_[entries.slots[index]].occupied.store(false, std::memory_order_release);
+    uint32_t last = --entries.count;
+    entries.nodes[index] = entries.nodes[last];
+    entries.slots[index] = entries.slots[last];
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return node;
+}
+
+size_t HotTier::sweep(bool want_free, Node*& evicted, SymbolId candidate, const FrequencySketch* sketch) {
+    // Two full turns clear every reference bit, so past that the hand takes
+    // whatever it lands on even if a concurrent hit just set its bit again
+    const size_t limit = 2 * capacity_;
+    for (size_t step = 0; step < limit + capacity_; ++step) {
+        size_t index = hand_;
+        hand_ = hand_ + 1 == capacity_ ? 0 : hand_ + 1;
+        Slot& slot = ring_[index];
+        if (!slot.occupied.load(std::memory_order_acquire)) {
+            if (want_free) return index;
+            continue;
+        }
+        if (slot.referenced.exchange(false, std::memory_order_relaxed) && step < limit) continue;
+        if (sketch && sketch->frequency(candidate) <= sketch->frequency(slot.symbol)) return capacity_;
+
+        Entries* entries = entries_.get(slot.symbol);
+        if (!entries) continue;
+        std::lock_guard<SpinLock> lock(entries->lock);
+        for (uint32_t i = 0; i < entries->count; ++i) {
+            if (entries->slots[i] == index) {
+                evicted = unlink(*entries, i);
+                return index;
+            }
+        }
+        // Removed under us: unlink clears occupied before the symbol lock drops
+        if (want_free) return index;
+    }
+    return capacity_;
+}
+
+bool HotTier::admit(Node* node, Node*& evicted, const FrequencySketch* sketch) {
+    evicted = nullptr;
+    Entries* entries = entries_.get_or_create(node->symbol);
+    if (!entries) return false;
+
+    {
+        std::lock_guard<SpinLock> lock(entries->lock);
+        if (entries->count == entries_per_symbol_) {
+            // Full symbol: replace its weakest entry in place, keeping the slot
+            uint64_t now = CoarseClock::now();
+            uint32_t weakest = 0;
+            for (uint32_t i = 0; i < entries->count; ++i) {
+                if (entries->nodes[i]->is_expired(now)) {
+                    weakest = i;
+                    break;
+                }
+                if (entries->nodes[i]->priority < entries->nodes[weakest]->priority) weakest = i;
+            }
+            Node* current = entries->nodes[weakest];
+            if (!current->is_expired(now) && current->priority >= node->priority) return false;
+            evicted = current;
+            entries->nodes[weakest] = node;
+            ring_[entries->slots[weakest]].referenced.store(false, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    std::lock_guard<SpinLock> ring_lock(ring_lock_);
+    size_t index = sweep(true, evicted, node->symbol, sketch);
+    if (index == capacity_) return false;
+
+    std::lock_guard<SpinLock> lock(entries->lock);
+    if (entries->count == entries_per_symbol_) return false;  // filled while we swept
+    Slot& slot = ring_[index];
+    slot.symbol = node->symbol;
+    slot.referenced.store(false, std::memory_order_relaxed);
+    slot.occupied.store(true, std::memory_order_release);
+    entries->nodes[entries->count] = node;
+    entries->slots[entries->count] = static_cast<uint32_t>(index);
+    ++entries->count;
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t HotTier::best(const Entries& entries, uint64_t now) {
+    uint32_t best_index = entries.count;
+    for (uint32_t i = 0; i < entries.count; ++i) {
+        const Node* node = entries.nodes[i];
+        if (node->is_expired(now)) continue;
+        if (best_index == entries.count || node->priority > entries.nodes[best_index]->priority) best_index = i;
+    }
+    return best_index;
+}
+
+Node* HotTier::peek(SymbolId symbol) {
+    Entries* entries = entries_.get(symbol);
+    if (!entries) return nullptr;
+    uint64_t now = CoarseClock::now();
+    std::lock_guard<SpinLock> lock(entries->lock);
+    uint32_t index = best(*entries, now);
+    if (index == entries->count) return nullptr;
+    ring_[entries->slots[index]].referenced.store(true, std::memory_order_relaxed);
+    return entries->nodes[index];
+}
+
+Node* HotTier::pop(SymbolId symbol) {
+    Entries* entries = entries_.get(symbol);
+    if (!entries) return nullptr;
+    uint64_t now = CoarseClock::now();
+    std::lock_guard<SpinLock> lock(entries->lock);
+    uint32_t index = best(*entries, now);
+    return index == entries->count ? nullptr : unlink(*entries, index);
+}
+
+Node* HotTier::remove(SymbolId symbol, double value) {
+    Entries* entries = entries_.get(symbol);
+    if (!entries) return nullptr;
+    std::lock_guard<SpinLock> lock(entries->lock);
+    for (uint32_t i = 0; i < entries->count; ++i) {
+        if (entries->nodes[i]->value == value) return unlink(*entries, i);
+    }
+    return nullptr;
+}
+
+Node* HotTier::evict_one() {
+    if (size() == 0) return nullptr;
+    std::lock_guard<SpinLock> ring_lock(ring_lock_);
+    Node* evicted = nullptr;
+    sweep(false, evicted);
+    return evicted;
+}
+
+void HotTier::drain(std::vector<Node*>& out) {
+    std::lock_guard<SpinLock> ring_lock(ring_lock_);
+    for (size_t index = 0; index < capacity_; ++index) {
+        Slot& slot = ring_[index];
+        if (!slot.occupied.load(std::memory_order_acquire)) continue;
+        Entries* entries = entries_.get(slot.symbol);
+        if (!entries) continue;
+        std::lock_guard<SpinLock> lock(entries->lock);
+        while (entries->count) out.push_back(unlink(*entries, entries->count - 1));
+    }
+}
+
+} // namespace hft_cache
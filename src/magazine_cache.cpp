@@ -0,0 +1,257 @@
+#include "magazine_cache.hpp"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Caches still alive, so a thread that outlives one does not hand its
+// magazines back to freed memory. Leaked so it outlives every thread.
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, MagazineCache*> live;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+std::atomic<uint64_t> next_cache_id{1};
+
+// Set once a thread's bindings are gone; it then only uses overflow caches
+thread_local bool thread_exiting = false;
+
+} // namespace
+
+struct MagazineCache::ThreadBindings {
+    std::vector<Binding> all;
+
+    ~ThreadBindings() {
+        thread_exiting = true;
+        last_binding() = Binding{0, nullptr};
+        Registry& caches = registry();
+        std::lock_guard<std::mutex> lock(caches.mutex);
+        for (const Binding& binding : all) {
+            auto it = caches.live.find(binding.owner);
+            if (it != caches.live.end()) it->second->detach(binding.cache);
+        }
+    }
+};
+
+MagazineCache::MagazineCache(size_t rounds, Refill refill, Spill spill)
+    : rounds_(rounds ? rounds : 1), refill_(std::move(refill)), spill_(std::move(spill)),
+      id_(next_cache_id.fetch_add(1, std::memory_order_relaxed)),
+      full_head_(pack(0, NIL)), empty_head_(pack(0, NIL)) {
+    overflow_.loaded = new_magazine();
+    overflow_.previous = new_magazine();
+    Registry& caches = registry();
+    std::lock_guard<std::mutex> lock(caches.mutex);
+    caches.live.emplace(id_, this);
+}
+
+MagazineCache::~MagazineCache() {
+    // Once this returns no exiting thread can detach into this cache
+    Registry& caches = registry();
+    std::lock_guard<std::mutex> lock(caches.mutex);
+    caches.live.erase(id_);
+}
+
+MagazineCache::ThreadBindings& MagazineCache::thread_bindings() {
+    thread_local ThreadBindings bindings;
+    return bindings;
+}
+
+MagazineCache::Cache* MagazineCache::bind() {
+    Binding& last = last_binding();
+    if (thread_exiting) {
+        last = Binding{id_, &overflow_};
+        return &overflow_;
+    }
+    ThreadBindings& bindings = thread_bindings();
+    for (const Binding& binding : bindings.all) {
+        if (binding.owner == id_) {
+            last = binding;
+            return last.cache;
+        }
+    }
+    last = Binding{id_, claim()};
+    // The overflow cache is never handed back
+    if (last.cache != &overflow_) bindings.all.push_back(last);
+    return last.cache;
+}
+
+MagazineCache::Cache* MagazineCache::claim() {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    if (free_caches_ == NIL && cache_count_ == MAX_CACHES) return &overflow_;
+    Magazine* loaded = take_empty();
+    Magazine* previous = loaded ? take_empty() : nullptr;
+    if (!previous) {
+        if (loaded) push(empty_head_, empty_count_, loaded);
+        return &overflow_;
+    }
+
+    Cache* cache;
+    if (free_caches_ != NIL) {
+        cache = caches_[free_caches_].get();
+        free_caches_ = cache->next_free;
+    } else {
+        caches_[cache_count_] = std::make_unique<Cache>();
+        cache = caches_[cache_count_].get();
+        cache->slot = static_cast<uint32_t>(cache_count_++);
+    }
+    cache->loaded = loaded;
+    cache->previous = previous;
+    cache->next_free = NIL;
+    return cache;
+}
+
+void MagazineCache::detach(Cache* cache) {
+    park(cache->loaded);
+    park(cache->previous);
+    cache->loaded = nullptr;
+    cache->previous = nullptr;
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    cache->next_free = free_caches_;
+    free_caches_ = cache->slot;
+}
+
+void* MagazineCache::allocate_slow(Cache& cache, Tier reach) {
+    if (cache.previous->count) {
+        std::swap(cache.loaded, cache.previous);
+    } else if (reach == THREAD) {
+        return nullptr;
+    } else if (Magazine* full = pop(full_head_, full_count_)) {
+        push(empty_head_, empty_count_, cache.previous);
+        cache.previous = cache.loaded;
+        cache.loaded = full;
+        depot_allocations_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        if (reach == DEPOT) return nullptr;
+        size_t count = refill_(cache.loaded->rounds, rounds_);
+        refills_.fetch_add(1, std::memory_order_relaxed);
+        refilled_objects_.fetch_add(count, std::memory_order_relaxed);
+        if (count == 0) return nullptr;
+        cache.loaded->count = static_cast<uint32_t>(count);
+    }
+    bump(cache.allocations);
+    return cache.loaded->rounds[--cache.loaded->count];
+}
+
+void MagazineCache::release_slow(Cache& cache, void* object) {
+    if (cache.previous->count == 0) {
+        std::swap(cache.loaded, cache.previous);
+    } else if (Magazine* empty = take_empty()) {
+        push(full_head_, full_count_, cache.previous);
+        cache.previous = cache.loaded;
+        cache.loaded = empty;
+        depot_releases_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        // Out of magazines: the other full one goes back to the allocator
+        spill_(cache.previous->rounds, cache.previous->count);
+        spilled_objects_.fetch_add(cache.previous->count, std::memory_order_relaxed);
+        cache.previous->count = 0;
+        std::swap(cache.loaded, cache.previous);
+    }
+    bump(cache.releases);
+    cache.loaded->rounds[cache.loaded->count++] = object;
+}
+
+void MagazineCache::flush() {
+    Cache* cache = local_cache();
+    std::unique_lock<SpinLock> shared(overflow_lock_, std::defer_lock);
+    if (cache == &overflow_) shared.lock();
+    for (Magazine** slot : {&cache->loaded, &cache->previous}) {
+        Magazine* magazine = *slot;
+        if (magazine->count == 0) continue;
+        Magazine* empty = take_empty();
+        if (!empty) {
+            spill_(magazine->rounds, magazine->count);
+            spilled_objects_.fetch_add(magazine->count, std::memory_order_relaxed);
+            magazine->count = 0;
+            continue;
+        }
+        push(full_head_, full_count_, magazine);
+        *slot = empty;
+    }
+}
+
+MagazineCache::Magazine* MagazineCache::new_magazine() {
+    std::lock_guard<std::mutex> lock(grow_mutex_);
+    size_t count = magazine_count_.load(std::memory_order_relaxed);
+    if (count == MAX_CHUNKS * CHUNK_MAGAZINES) return nullptr;
+    if (count % CHUNK_MAGAZINES == 0) {
+        auto chunk = std::make_unique<MagazineChunk>();
+        chunk->rounds.reset(new void*[CHUNK_MAGAZINES * rounds_]);
+        for (size_t i = 0; i < CHUNK_MAGAZINES; ++i) {
+            chunk->magazines[i].rounds = chunk->rounds.get() + i * rounds_;
+            chunk->magazines[i].index = static_cast<uint32_t>(count + i);
+        }
+        chunks_[count / CHUNK_MAGAZINES] = std::move(chunk);
+    }
+    magazine_count_.store(count + 1, std::memory_order_relaxed);
+    return &magazine(static_cast<uint32_t>(count));
+}
+
+MagazineCache::Magazine* MagazineCache::take_empty() {
+    Magazine* magazine = pop(empty_head_, empty_count_);
+    return magazine ? magazine : new_magazine();
+}
+
+void MagazineCache::park(Magazine* magazine) {
+    if (magazine->count) {
+        push(full_head_, full_count_, magazine);
+    } else {
+        push(empty_head_, empty_count_, magazine);
+    }
+}
+
+void MagazineCache::push(std::atomic<uint64_t>& head, std::atomic<size_t>& count, Magazine* magazine) {
+    // Counted before it is visible, so a racing pop cannot take the count below zero
+    count.fetch_add(1, std::memory_order_relaxed);
+    uint64_t current = head.load(std::memory_order_relaxed);
+    do {
+        magazine->next.store(static_cast<uint32_t>(current), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(current, pack((current >> 32) + 1, magazine->index),
+                                         std::memory_order_release, std::memory_order_relaxed));
+}
+
+MagazineCache::Magazine* MagazineCache::pop(std::atomic<uint64_t>& head, std::atomic<size_t>& count) {
+    uint64_t current = head.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t index = static_cast<uint32_t>(current);
+        if (index == NIL) return nullptr;
+        Magazine& top = magazine(index);
+        uint32_t next = top.next.load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(current, pack((current >> 32) + 1, next),
+                                       std::memory_order_acquire, std::memory_order_acquire)) {
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return &top;
+        }
+    }
+}
+
+MagazineCache::Stats MagazineCache::stats() const {
+    Stats stats;
+    stats.rounds = rounds_;
+    stats.magazines = magazine_count_.load(std::memory_order_relaxed);
+    stats.full_magazines = full_count_.load(std::memory_order_relaxed);
+    stats.empty_magazines = empty_count_.load(std::memory_order_relaxed);
+    stats.depot_allocations = depot_allocations_.load(std::memory_order_relaxed);
+    stats.depot_releases = depot_releases_.load(std::memory_order_relaxed);
+    stats.refills = refills_.load(std::memory_order_relaxed);
+    stats.refilled_objects = refilled_objects_.load(std::memory_order_relaxed);
+    stats.spilled_objects = spilled_objects_.load(std::memory_order_relaxed);
+    stats.allocations = overflow_.allocations.load(std::memory_order_relaxed);
+    stats.releases = overflow_.releases.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    size_t idle = 0;
+    for (uint32_t slot = free_caches_; slot != NIL; slot = caches_[slot]->next_free) ++idle;
+    stats.caches = cache_count_ - idle;
+    for (size_t i = 0; i < cache_count_; ++i) {
+        stats.allocations += caches_[i]->allocations.load(std::memory_order_relaxed);
+        stats.releases += caches_[i]->releases.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
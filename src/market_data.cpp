@@ -0,0 +1,199 @@
+#include "market_data.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+constexpr size_t INITIAL_TRADES = 64;
+// Forward steps to try from the previous window start before bisecting
+constexpr uint64_t MAX_HINT_STEPS = 16;
+
+size_t round_up_pow2(size_t n) {
+    size_t result = 1;
+    while (result < n) result <<= 1;
+    return result;
+}
+
+} // namespace
+
+TradeWindow::TradeWindow(size_t capacity)
+    : ring_(std::min(INITIAL_TRADES, round_up_pow2(std::max<size_t>(capacity, 1)))),
+      capacity_(round_up_pow2(std::max<size_t>(capacity, 1))) {}
+
+void TradeWindow::grow() {
+    std::vector<Trade> grown(ring_.size() * 2);
+    for (uint64_t sequence = tail_; sequence < head_; ++sequence) {
+        grown[sequence & (grown.size() - 1)] = at(sequence);
+    }
+    ring_.swap(grown);
+}
+
+void TradeWindow::rebase() {
+    const Trade& oldest = at(tail_);
+    double notional = oldest.notional_before;
+    double quantity = oldest.quantity_before;
+    double integral = oldest.integral_at;
+    for (uint64_t sequence = tail_; sequence < head_; ++sequence) {
+        Trade& trade = at(sequence);
+        trade.notional_before -= notional;
+        trade.quantity_before -= quantity;
+        trade.integral_at -= integral;
+    }
+    notional_total_ -= notional;
+    quantity_total_ -= quantity;
+    since_rebase_ = 0;
+}
+
+void TradeWindow::add(uint64_t timestamp_ns, double price, double quantity) {
+    double integral = 0.0;
+    if (head_ != tail_) {
+        const Trade& last = at(head_ - 1);
+        timestamp_ns = std::max(timestamp_ns, last.timestamp_ns);
+        integral = last.integral_at + last.price * static_cast<double>(timestamp_ns - last.timestamp_ns);
+    }
+    if (size() == ring_.size()) {
+        if (ring_.size() < capacity_) {
+            grow();
+        } else {
+            ++tail_;
+        }
+    }
+
+    Trade& trade = at(head_);
+    trade.timestamp_ns = timestamp_ns;
+    trade.price = price;
+    trade.notional_before = notional_total_;
+    trade.quantity_before = quantity_total_;
+    trade.integral_at = integral;
+    ++head_;
+    notional_total_ += price * quantity;
+    quantity_total_ += quantity;
+
+    if (++since_rebase_ >= capacity_) rebase();
+}
+
+uint64_t TradeWindow::first_at_or_after(uint64_t t) {
+    uint64_t start = std::clamp(hint_, tail_, head_);
+    if (start == tail_ || at(start - 1).timestamp_ns < t) {
+        // Window start moved forward (or stayed): walk a few steps
+        uint64_t steps = 0;
+        while (start < head_ && at(start).timestamp_ns < t && steps < MAX_HINT_STEPS) {
+            ++start;
+            ++steps;
+        }
+        if (start == head_ || at(start).timestamp_ns >= t) return hint_ = start;
+    }
+    uint64_t low = tail_;
+    uint64_t high = head_;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (at(mid).timestamp_ns < t) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return hint_ = low;
+}
+
+double TradeWindow::vwap(uint64_t now_ns, uint64_t window_ns) {
+    if (head_ == tail_) return 0.0;
+    uint64_t start = first_at_or_after(now_ns > window_ns ? now_ns - window_ns : 0);
+    if (start == head_) return 0.0;
+    const Trade& first = at(start);
+    double quantity = quantity_total_ - first.quantity_before;
+    return quantity > 0.0 ? (notional_total_ - first.notional_before) / quantity : 0.0;
+}
+
+double TradeWindow::twap(uint64_t now_ns, uint64_t window_ns) {
+    if (head_ == tail_) return 0.0;
+    const Trade& oldest = at(tail_);
+    const Trade& last = at(head_ - 1);
+    now_ns = std::max(now_ns, last.timestamp_ns);
+    uint64_t begin = std::max(now_ns > window_ns ? now_ns - window_ns : 0, oldest.timestamp_ns);
+    if (begin >= now_ns) return last.price;
+
+    double end_integral = last.integral_at + last.price * static_cast<double>(now_ns - last.timestamp_ns);
+    uint64_t start = first_at_or_after(begin);
+    double begin_integral = oldest.integral_at;
+    if (start != tail_) {
+        // The price in force at begin is the one set by the trade before start
+        const Trade& before = at(start - 1);
+        begin_integral = before.integral_at + before.price * static_cast<double>(begin - before.timestamp_ns);
+    }
+    return (end_integral - begin_integral) / static_cast<double>(now_ns - begin);
+}
+
+void OrderBook::update(BookSide side, double price, size_t quantity) {
+    auto& levels = side == BookSide::BID ? bids_ : asks_;
+    // Sorted so the best level is last: bids ascending, asks descending
+    auto it = side == BookSide::BID
+        ? std::lower_bound(levels.begin(), levels.end(), price,
+                           [](const std::pair<double, size_t>& level, double p) { return level.first < p; })
+        : std::lower_bound(levels.begin(), levels.end(), price,
+                           [](const std::pair<double, size_t>& level, double p) { return level.first > p; });
+    bool found = it != levels.end() && it->first == price;
+    if (quantity == 0) {
+        if (found) levels.erase(it);
+    } else if (found) {
+        it->second = quantity;
+    } else {
+        levels.insert(it, {price, quantity});
+    }
+}
+
+void OrderBook::clear() {
+    bids_.clear();
+    asks_.clear();
+}
+
+void OrderBook::snapshot(size_t levels, MarketDepth& out) const {
+    out.bids.assign(bids_.rbegin(), bids_.rbegin() + std::min(levels, bids_.size()));
+    out.asks.assign(asks_.rbegin(), asks_.rbegin() + std::min(levels, asks_.size()));
+}
+
+void MarketDataEngine::on_trade(SymbolId symbol, double price, double quantity, uint64_t timestamp_ns) {
+    SymbolMarket* market = markets_.get_or_create(symbol, trades_per_symbol_);
+    if (!market) return;
+    std::lock_guard<SpinLock> lock(market->lock);
+    market->trades.add(timestamp_ns, price, quantity);
+}
+
+void MarketDataEngine::on_book_update(SymbolId symbol, BookSide side, double price, size_t quantity) {
+    SymbolMarket* market = markets_.get_or_create(symbol, trades_per_symbol_);
+    if (!market) return;
+    std::lock_guard<SpinLock> lock(market->lock);
+    market->book.update(side, price, quantity);
+}
+
+void MarketDataEngine::clear_book(SymbolId symbol) {
+    SymbolMarket* market = markets_.get(symbol);
+    if (!market) return;
+    std::lock_guard<SpinLock> lock(market->lock);
+    market->book.clear();
+}
+
+double MarketDataEngine::twap(SymbolId symbol, uint64_t window_ns, uint64_t now_ns) {
+    SymbolMarket* market = markets_.get(symbol);
+    if (!market) return 0.0;
+    std::lock_guard<SpinLock> lock(market->lock);
+    return market->trades.twap(now_ns, window_ns);
+}
+
+double MarketDataEngine::vwap(SymbolId symbol, uint64_t window_ns, uint64_t now_ns) {
+    SymbolMarket* market = markets_.get(symbol);
+    if (!market) return 0.0;
+    std::lock_guard<SpinLock> lock(market->lock);
+    return market->trades.vwap(now_ns, window_ns);
+}
+
+void MarketDataEngine::depth(SymbolId symbol, size_t levels, MarketDepth& out) const {
+    SymbolMarket* market = markets_.get(symbol);
+    if (!market) {
+        out.bids.clear();
+        out.asks.clear();
+        return;
+    }
+    std::lock_guard<SpinLock> lock(market->lock);
+    market->book.snapshot(levels, out);
+}
@@ -14,13 +14,11 @@ MemoryManager::MemoryManager(const CacheConfig& config)
     
     // Pre-allocate node pool
     if (config_.enable_memory_pool) {
-        node_pool_.reserve(config_.max_nodes);
-        for (size_t i = 0; i < config_.max_nodes; ++i) {
-            Node* node = static_cast<Node*>(numa_allocate(sizeof(Node)));
-            new (node) Node();
-            node_pool_.push_back(node);
-            total_memory_usage_.fetch_add(sizeof(Node));
-        }
+        // A pinned numa_node keeps everything on that node. No magazines:
+        // frees arrive on the cleanup thread, where they would only strand slots.
+        size_t partitions = config_.enable_numa && config_.numa_node < 0 ? NumaTopology::node_count() : 1;
+        node_pool_ = std::make_unique<NodePool>(config_.max_nodes, 0, partitions);
+        total_memory_usage_.fetch_add(config_.max_nodes * sizeof(Node));
     }
     
     start_cleanup_thread();
@@ -30,19 +28,13 @@ MemoryManager::~MemoryManager() {
     stop_cleanup_thread();
     emergency_cleanup();
     
-    // Clean up node pool
-    for (auto node : node_pool_) {
-        if (node) {
-            node->~Node();
-            numa_deallocate(node, sizeof(Node));
-        }
-    }
-    
     // Clean up any remaining memory blocks
     std::lock_guard<std::mutex> lock(memory_mutex_);
     for (const auto& block : memory_blocks_) {
         numa_deallocate(block.ptr, block.size);
     }
+    memory_blocks_.clear();
+    if (node_pool_) total_memory_usage_.fetch_sub(node_pool_->capacity() * sizeof(Node));
 }
 
 Node* MemoryManager::allocate_node() {
@@ -50,12 +42,11 @@ Node* MemoryManager::allocate_node() {
         return nullptr;
     }
     
-    if (config_.enable_memory_pool && pool_index_.load() < node_pool_.size()) {
-        size_t index = pool_index_.fetch_add(1);
-        if (index < node_pool_.size()) {
+    if (node_pool_) {
+        if (Node* node = node_pool_->allocate()) {
             allocated_nodes_.fetch_add(1);
             allocations_.fetch_add(1);
-            return node_pool_[index];
+            return node;
         }
     }
     
@@ -134,20 +125,42 @@ void MemoryManager::cleanup_expired_nodes() {
         }
     }
     
+    size_t budget = config_.max_expired_nodes_per_cleanup - nodes_to_cleanup.size();
     while (!nodes_to_cleanup.empty()) {
         Node* node = nodes_to_cleanup.front();
         nodes_to_cleanup.pop();
         
-        if (node) {
-            node->~Node();
-            numa_deallocate(node, sizeof(Node));
-            total_memory_usage_.fetch_sub(sizeof(Node));
+        free_node(node);
+    }
+    
+    {
+        // Rotate the starting engine so one busy cache cannot starve the rest
+        std::lock_guard<std::mutex> lock(engines_mutex_);
+        uint64_t now = CoarseClock::now();
+        size_t count = expiry_engines_.size();
+        for (size_t i = 0; i < count && budget > 0; ++i) {
+            size_t purged = expiry_engines_[(next_engine_ + i) % count]->run(now, budget);
+            budget -= purged;
+            expired_purged_.fetch_add(purged);
         }
+        if (count) next_engine_ = (next_engine_ + 1) % count;
     }
     
     cleanup_cycles_.fetch_add(1);
 }
 
+void MemoryManager::register_expiry_engine(ExpiryEngine* engine) {
+    if (!engine) return;
+    std::lock_guard<std::mutex> lock(engines_mutex_);
+    expiry_engines_.push_back(engine);
+}
+
+void MemoryManager::unregister_expiry_engine(ExpiryEngine* engine) {
+    std::lock_guard<std::mutex> lock(engines_mutex_);
+    expiry_engines_.erase(std::remove(expiry_engines_.begin(), expiry_engines_.end(), engine),
+                          expiry_engines_.end());
+}
+
 bool MemoryManager::is_memory_available() const {
     return allocated_nodes_.load() < config_.max_nodes &&
            total_memory_usage_.load() < (config_.max_memory_mb * 1024 * 1024);
@@ -222,6 +235,7 @@ MemoryManager::MemoryMetrics MemoryManager::get_metrics() const {
     metrics.allocations = allocations_.load();
     metrics.deallocations = deallocations_.load();
     metrics.cleanup_cycles = cleanup_cycles_.load();
+    metrics.expired_purged = expired_purged_.load();
     metrics.memory_usage = total_memory_usage_.load();
     metrics.allocated_nodes = allocated_nodes_.load();
     
@@ -242,11 +256,6 @@ bool MemoryManager::validate_memory_integrity() const {
         return false;
     }
     
-    // Check if pool index is within bounds
-    if (pool_index_.load() > node_pool_.size()) {
-        return false;
-    }
-    
     return true;
 }
 
@@ -263,10 +272,26 @@ void MemoryManager::emergency_cleanup() {
         Node* node = emergency_queue.front();
         emergency_queue.pop();
         
-        if (node) {
-            node->~Node();
-            numa_deallocate(node, sizeof(Node));
-            total_memory_usage_.fetch_sub(sizeof(Node));
-        }
+        free_node(node);
+    }
+}
+
+void MemoryManager::free_node(Node* node) {
+    if (!node) return;
+    
+    // Pool slots go back to their partition; only fallback nodes are freed
+    if (node_pool_ && node_pool_->owns(node)) {
+        node_pool_->release(node);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        auto block = std::find_if(memory_blocks_.begin(), memory_blocks_.end(),
+                                  [node](const MemoryBlock& entry) { return entry.ptr == node; });
+        if (block == memory_blocks_.end()) return;
+        memory_blocks_.erase(block);
     }
+    node->~Node();
+    numa_deallocate(node, sizeof(Node));
 } 
\ No newline at end of file
@@ -1,232 +1,407 @@
 #include "metrics.hpp"
+#include "metrics_region.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <thread>
+#include <unordered_map>
 
-MetricsCollector::MetricsCollector(const CacheConfig& config) 
-    : config_(config), shutdown_(false) {
-    
-    if (config_.enable_metrics) {
-        start_metrics_thread();
-        open_metrics_file();
+namespace {
+
+// Collectors still alive, so a thread that outlives one does not hand its
+// shard back to freed memory. Leaked so it outlives every thread.
+struct Registry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, MetricsCollector*> live;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+std::atomic<uint64_t> next_collector_id{1};
+
+} // namespace
+
+const char* metric_op_name(MetricOp op) {
+    switch (op) {
+        case MetricOp::INSERT: return "insert";
+        case MetricOp::RETRIEVE: return "retrieve";
+        case MetricOp::BATCH_INSERT: return "batch_insert";
+        case MetricOp::BATCH_RETRIEVE: return "batch_retrieve";
+        case MetricOp::LOCK_WAIT: return "lock_wait";
+        default: return "unknown";
     }
 }
 
-MetricsCollector::~MetricsCollector() {
-    shutdown_.store(true);
-    if (metrics_thread_.joinable()) {
-        metrics_thread_.join();
+// LatencyHistogram Implementation
+uint64_t LatencyHistogram::upper_bound_ns(size_t bucket) {
+    constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    if (bucket < SUB_BUCKETS) return bucket;
+    if (bucket >= BUCKETS - 1) return UINT64_MAX;
+    unsigned shift = static_cast<unsigned>(bucket >> SUB_BITS) - 1;
+    uint64_t lower = uint64_t(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    ++counts[bucket_of(ns)];
+    ++count;
+    total_ns += ns;
+    max_ns = std::max(max_ns, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket) counts[bucket] += other.counts[bucket];
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+}
+
+uint64_t LatencyHistogram::percentile_ns(double q) const {
+    if (count == 0) return 0;
+    // The sample of rank ceil(q * count), counting from one
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count)));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) return std::min(upper_bound_ns(bucket), max_ns);
     }
-    
-    if (metrics_file_.is_open()) {
-        metrics_file_.close();
+    return max_ns;
+}
+
+LatencySummary LatencySummary::of(const LatencyHistogram& histogram) {
+    LatencySummary summary;
+    summary.count = histogram.count;
+    summary.mean_ns = histogram.mean_ns();
+    summary.p50_ns = histogram.percentile_ns(0.5);
+    summary.p99_ns = histogram.percentile_ns(0.99);
+    summary.p999_ns = histogram.percentile_ns(0.999);
+    summary.max_ns = histogram.max_ns;
+    return summary;
+}
+
+double CacheMetrics::hit_rate() const {
+    uint64_t total = cache_hits + cache_misses;
+    return total ? static_cast<double>(cache_hits) / static_cast<double>(total) : 0.0;
+}
+
+double CacheMetrics::error_rate() const {
+    uint64_t total_operations = total_inserts + total_retrieves;
+    if (total_operations == 0) return 0.0;
+    return static_cast<double>(insert_errors + retrieve_errors) / static_cast<double>(total_operations);
+}
+
+// MetricsCollector Implementation
+struct MetricsCollector::ThreadBindings {
+    std::vector<Binding> all;
+
+    ~ThreadBindings() {
+        last_binding() = Binding{0, nullptr};
+        Registry& collectors = registry();
+        std::lock_guard<std::mutex> lock(collectors.mutex);
+        for (const Binding& binding : all) {
+            auto it = collectors.live.find(binding.owner);
+            if (it != collectors.live.end()) it->second->detach(binding.shard);
+        }
+    }
+};
+
+MetricsCollector::MetricsCollector(const CacheConfig& config)
+    : config_(config), enabled_(config.enable_metrics), id_(next_collector_id.fetch_add(1, std::memory_order_relaxed)) {
+    {
+        Registry& collectors = registry();
+        std::lock_guard<std::mutex> lock(collectors.mutex);
+        collectors.live.emplace(id_, this);
+    }
+    region_ = std::make_unique<MetricsRegionWriter>(config_.metrics_region_path, config_.metrics_interval_ms);
+    if (enabled_.load()) {
+        open_metrics_file();
+        start_metrics_thread();
     }
 }
 
-// Metric recording methods
-void MetricsCollector::record_insert(uint64_t latency_ns, bool success) {
-    if (!config_.enable_metrics) return;
-    
-    metrics_.total_inserts.fetch_add(1);
-    metrics_.total_insert_latency.fetch_add(latency_ns);
-    
-    if (!success) {
-        metrics_.insert_errors.fetch_add(1);
+MetricsCollector::~MetricsCollector() {
+    stop_metrics_thread();
+    {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        if (metrics_file_.is_open()) metrics_file_.close();
     }
+    // Once this returns no exiting thread can detach into this collector
+    Registry& collectors = registry();
+    std::lock_guard<std::mutex> lock(collectors.mutex);
+    collectors.live.erase(id_);
 }
 
-void MetricsCollector::record_retrieve(uint64_t latency_ns, bool success, bool hit) {
-    if (!config_.enable_metrics) return;
-    
-    metrics_.total_retrieves.fetch_add(1);
-    metrics_.total_retrieve_latency.fetch_add(latency_ns);
-    
-    if (hit) {
-        metrics_.cache_hits.fetch_add(1);
-    } else {
-        metrics_.cache_misses.fetch_add(1);
+MetricsCollector::ThreadBindings& MetricsCollector::thread_bindings() {
+    thread_local ThreadBindings bindings;
+    return bindings;
+}
+
+MetricsCollector::ThreadShard& MetricsCollector::bind() {
+    ThreadBindings& bindings = thread_bindings();
+    Binding& last = last_binding();
+    for (const Binding& binding : bindings.all) {
+        if (binding.owner == id_) {
+            last = binding;
+            return *binding.shard;
+        }
     }
-    
-    if (!success) {
-        metrics_.retrieve_errors.fetch_add(1);
+    ThreadShard* shard;
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        if (free_shards_) {
+            shard = free_shards_;
+            free_shards_ = shard->next_free;
+        } else {
+            shards_.push_back(std::make_unique<ThreadShard>());
+            shard = shards_.back().get();
+        }
     }
+    last = Binding{id_, shard};
+    bindings.all.push_back(last);
+    return *shard;
+}
+
+void MetricsCollector::detach(ThreadShard* shard) {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shard->next_free = free_shards_;
+    free_shards_ = shard;
+}
+
+size_t MetricsCollector::thread_shards() const {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    return shards_.size();
 }
 
+// Metric recording methods
 void MetricsCollector::record_batch_insert(uint64_t latency_ns, size_t batch_size, bool success) {
-    if (!config_.enable_metrics) return;
-    
-    metrics_.total_batch_inserts.fetch_add(1);
-    metrics_.total_batch_insert_latency.fetch_add(latency_ns);
-    
-    if (!success) {
-        metrics_.insert_errors.fetch_add(1);
-    }
+    if (!enabled_.load(std::memory_order_relaxed)) return;
+    ThreadShard& shard = local_shard();
+    record_latency(shard.ops[static_cast<size_t>(MetricOp::BATCH_INSERT)], latency_ns);
+    bump(shard.batch_items, batch_size);
+    if (!success) bump(shard.insert_errors);
 }
 
 void MetricsCollector::record_batch_retrieve(uint64_t latency_ns, size_t batch_size, bool success) {
-    if (!config_.enable_metrics) return;
-    
-    metrics_.total_batch_retrieves.fetch_add(1);
-    metrics_.total_batch_retrieve_latency.fetch_add(latency_ns);
-    
-    if (!success) {
-        metrics_.retrieve_errors.fetch_add(1);
-    }
+    if (!enabled_.load(std::memory_order_relaxed)) return;
+    ThreadShard& shard = local_shard();
+    record_latency(shard.ops[static_cast<size_t>(MetricOp::BATCH_RETRIEVE)], latency_ns);
+    bump(shard.batch_items, batch_size);
+    if (!success) bump(shard.retrieve_errors);
 }
 
 void MetricsCollector::record_memory_usage(size_t usage_bytes) {
-    if (!config_.enable_metrics) return;
+    if (!enabled_.load(std::memory_order_relaxed)) return;
     
-    metrics_.current_memory_usage.store(usage_bytes);
+    current_memory_usage_.store(usage_bytes);
     
     // Update peak memory usage
-    size_t peak_usage = metrics_.peak_memory_usage.load();
+    size_t peak_usage = peak_memory_usage_.load();
     while (usage_bytes > peak_usage) {
-        if (metrics_.peak_memory_usage.compare_exchange_weak(peak_usage, usage_bytes)) {
+        if (peak_memory_usage_.compare_exchange_weak(peak_usage, usage_bytes)) {
             break;
         }
     }
 }
 
 void MetricsCollector::record_error(const std::string& error_type) {
-    if (!config_.enable_metrics) return;
+    if (!enabled_.load(std::memory_order_relaxed)) return;
     
     if (error_type == "memory") {
-        metrics_.memory_errors.fetch_add(1);
+        memory_errors_.fetch_add(1);
     } else if (error_type == "insert") {
-        metrics_.insert_errors.fetch_add(1);
+        bump(local_shard().insert_errors);
     } else if (error_type == "retrieve") {
-        metrics_.retrieve_errors.fetch_add(1);
+        bump(local_shard().retrieve_errors);
     }
 }
 
 void MetricsCollector::record_recovery_attempt() {
-    if (!config_.enable_metrics) return;
+    if (!enabled_.load(std::memory_order_relaxed)) return;
     
-    metrics_.recovery_attempts.fetch_add(1);
+    recovery_attempts_.fetch_add(1);
 }
 
 void MetricsCollector::record_thread_contention(uint64_t wait_time_ns) {
-    if (!config_.enable_metrics) return;
+    if (!enabled_.load(std::memory_order_relaxed)) return;
     
-    metrics_.thread_contention_count.fetch_add(1);
-    metrics_.lock_wait_time.fetch_add(wait_time_ns);
+    record_latency(local_shard().ops[static_cast<size_t>(MetricOp::LOCK_WAIT)], wait_time_ns);
 }
 
 void MetricsCollector::record_numa_allocation(bool cross_numa) {
-    if (!config_.enable_metrics) return;
+    if (!enabled_.load(std::memory_order_relaxed)) return;
     
-    metrics_.numa_allocations.fetch_add(1);
+    numa_allocations_.fetch_add(1);
     if (cross_numa) {
-        metrics_.cross_numa_accesses.fetch_add(1);
+        cross_numa_accesses_.fetch_add(1);
     }
 }
 
+void MetricsCollector::record_cross_numa_access(uint64_t count) {
+    if (!enabled_.load(std::memory_order_relaxed)) return;
+    
+    cross_numa_accesses_.fetch_add(count);
+}
+
 // Metrics retrieval
+std::vector<const MetricsCollector::ThreadShard*> MetricsCollector::shard_list() const {
+    std::vector<const ThreadShard*> shards;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shards.reserve(shards_.size());
+    for (const auto& shard : shards_) shards.push_back(shard.get());
+    return shards;
+}
+
+LatencyHistogram MetricsCollector::merge_latency(const std::vector<const ThreadShard*>& shards, MetricOp op) {
+    LatencyHistogram merged;
+    for (const ThreadShard* shard : shards) {
+        const OpShard& samples = shard->ops[static_cast<size_t>(op)];
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKETS; ++bucket) {
+            uint64_t count = samples.counts[bucket].load(std::memory_order_relaxed);
+            merged.counts[bucket] += count;
+            merged.count += count;
+        }
+        merged.total_ns += samples.total_ns.load(std::memory_order_relaxed);
+        merged.max_ns = std::max(merged.max_ns, samples.max_ns.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+LatencyHistogram MetricsCollector::get_latency_histogram(MetricOp op) const {
+    return merge_latency(shard_list(), op);
+}
+
 CacheMetrics MetricsCollector::get_current_metrics() const {
-    return metrics_;
+    CacheMetrics metrics;
+    std::vector<const ThreadShard*> shards = shard_list();
+    uint64_t* counts[OPS] = {&metrics.total_inserts, &metrics.total_retrieves, &metrics.total_batch_inserts,
+                             &metrics.total_batch_retrieves, &metrics.thread_contention_count};
+    uint64_t* totals[OPS] = {&metrics.total_insert_latency, &metrics.total_retrieve_latency,
+                             &metrics.total_batch_insert_latency, &metrics.total_batch_retrieve_latency,
+                             &metrics.lock_wait_time};
+    for (size_t op = 0; op < OPS; ++op) {
+        LatencyHistogram histogram = merge_latency(shards, static_cast<MetricOp>(op));
+        metrics.latency[op] = LatencySummary::of(histogram);
+        *counts[op] = histogram.count;
+        *totals[op] = histogram.total_ns;
+    }
+    for (const ThreadShard* shard : shards) {
+        metrics.cache_hits += shard->hits.load(std::memory_order_relaxed);
+        metrics.cache_misses += shard->misses.load(std::memory_order_relaxed);
+        metrics.insert_errors += shard->insert_errors.load(std::memory_order_relaxed);
+        metrics.retrieve_errors += shard->retrieve_errors.load(std::memory_order_relaxed);
+        metrics.total_batch_items += shard->batch_items.load(std::memory_order_relaxed);
+    }
+
+    metrics.memory_errors = memory_errors_.load();
+    metrics.recovery_attempts = recovery_attempts_.load();
+    metrics.current_memory_usage = current_memory_usage_.load();
+    metrics.peak_memory_usage = peak_memory_usage_.load();
+    metrics.numa_allocations = numa_allocations_.load();
+    metrics.cross_numa_accesses = cross_numa_accesses_.load();
+    return metrics;
 }
 
 std::vector<MetricsCollector::MetricsSnapshot> MetricsCollector::get_historical_data() const {
-    std::lock_guard<std::mutex> lock(history_mutex_);
-    return historical_data_;
+    std::vector<MetricsSample> samples;
+    MetricsReader(region_->region()).history(samples);
+
+    std::vector<MetricsSnapshot> history;
+    history.reserve(samples.size());
+    for (const MetricsSample& sample : samples) {
+        MetricsSnapshot snapshot;
+        snapshot.timestamp = std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(sample.steady_ns)));
+        snapshot.metrics = sample.metrics;
+        history.push_back(snapshot);
+    }
+    return history;
+}
+
+const MetricsRegion& MetricsCollector::metrics_region() const {
+    return region_->region();
 }
 
 // Performance calculations
 double MetricsCollector::get_average_insert_latency() const {
-    uint64_t total_inserts = metrics_.total_inserts.load();
-    if (total_inserts == 0) return 0.0;
-    
-    uint64_t total_latency = metrics_.total_insert_latency.load();
-    return static_cast<double>(total_latency) / static_cast<double>(total_inserts);
+    return get_latency_histogram(MetricOp::INSERT).mean_ns();
 }
 
 double MetricsCollector::get_average_retrieve_latency() const {
-    uint64_t total_retrieves = metrics_.total_retrieves.load();
-    if (total_retrieves == 0) return 0.0;
-    
-    uint64_t total_latency = metrics_.total_retrieve_latency.load();
-    return static_cast<double>(total_latency) / static_cast<double>(total_retrieves);
+    return get_latency_histogram(MetricOp::RETRIEVE).mean_ns();
 }
 
 double MetricsCollector::get_cache_hit_rate() const {
-    uint64_t hits = metrics_.cache_hits.load();
-    uint64_t misses = metrics_.cache_misses.load();
-    uint64_t total = hits + misses;
-    
-    if (total == 0) return 0.0;
-    return static_cast<double>(hits) / static_cast<double>(total);
+    return get_current_metrics().hit_rate();
 }
 
 double MetricsCollector::get_error_rate() const {
-    uint64_t total_operations = metrics_.total_inserts.load() + metrics_.total_retrieves.load();
-    if (total_operations == 0) return 0.0;
-    
-    uint64_t total_errors = metrics_.insert_errors.load() + metrics_.retrieve_errors.load();
-    return static_cast<double>(total_errors) / static_cast<double>(total_operations);
+    return get_current_metrics().error_rate();
 }
 
-double MetricsCollector::get_memory_utilization() const {
-    size_t current_usage = metrics_.current_memory_usage.load();
+double MetricsCollector::memory_utilization(const CacheMetrics& metrics) const {
     size_t max_memory = config_.max_memory_mb * 1024 * 1024;
     
     if (max_memory == 0) return 0.0;
-    return static_cast<double>(current_usage) / static_cast<double>(max_memory);
+    return static_cast<double>(metrics.current_memory_usage) / static_cast<double>(max_memory);
+}
+
+double MetricsCollector::get_memory_utilization() const {
+    CacheMetrics metrics;
+    metrics.current_memory_usage = current_memory_usage_.load();
+    return memory_utilization(metrics);
 }
 
 // Alerts and monitoring
-bool MetricsCollector::check_alerts() const {
-    // Check latency alerts
-    if (get_average_insert_latency() > thresholds_.max_latency_ns) {
-        return true;
-    }
-    
-    if (get_average_retrieve_latency() > thresholds_.max_latency_ns) {
-        return true;
-    }
-    
-    // Check memory alerts
-    if (get_memory_utilization() > 0.9) {  // 90% memory usage
-        return true;
-    }
-    
-    // Check error rate alerts
-    if (get_error_rate() > static_cast<double>(thresholds_.max_error_rate) / 1000.0) {
-        return true;
-    }
-    
-    return false;
+uint64_t MetricsCollector::alert_bits(const CacheMetrics& metrics) const {
+    uint64_t alerts = 0;
+    
+    // Latency alerts look at the tail, which is what a stall moves
+    if (metrics.latency_of(MetricOp::INSERT).p99_ns > thresholds_.max_latency_ns) alerts |= ALERT_INSERT_LATENCY;
+    if (metrics.latency_of(MetricOp::RETRIEVE).p99_ns > thresholds_.max_latency_ns) alerts |= ALERT_RETRIEVE_LATENCY;
+    if (memory_utilization(metrics) > 0.9) alerts |= ALERT_MEMORY;  // 90% memory usage
+    if (metrics.error_rate() > static_cast<double>(thresholds_.max_error_rate) / 1000.0) alerts |= ALERT_ERROR_RATE;
+    return alerts;
 }
 
-std::vector<std::string> MetricsCollector::get_active_alerts() const {
+std::vector<std::string> MetricsCollector::alerts_for(const CacheMetrics& metrics) const {
     std::vector<std::string> alerts;
+    uint64_t active = alert_bits(metrics);
     
-    // Check latency alerts
-    if (get_average_insert_latency() > thresholds_.max_latency_ns) {
-        alerts.push_back("High insert latency: " + std::to_string(get_average_insert_latency()) + " ns");
+    if (active & ALERT_INSERT_LATENCY) {
+        alerts.push_back("High insert latency: p99 " + std::to_string(metrics.latency_of(MetricOp::INSERT).p99_ns) + " ns");
     }
     
-    if (get_average_retrieve_latency() > thresholds_.max_latency_ns) {
-        alerts.push_back("High retrieve latency: " + std::to_string(get_average_retrieve_latency()) + " ns");
+    if (active & ALERT_RETRIEVE_LATENCY) {
+        alerts.push_back("High retrieve latency: p99 " + std::to_string(metrics.latency_of(MetricOp::RETRIEVE).p99_ns) + " ns");
     }
     
-    // Check memory alerts
-    if (get_memory_utilization() > 0.9) {
-        alerts.push_back("High memory usage: " + std::to_string(get_memory_utilization() * 100) + "%");
+    if (active & ALERT_MEMORY) {
+        alerts.push_back("High memory usage: " + std::to_string(memory_utilization(metrics) * 100) + "%");
     }
     
-    // Check error rate alerts
-    if (get_error_rate() > static_cast<double>(thresholds_.max_error_rate) / 1000.0) {
-        alerts.push_back("High error rate: " + std::to_string(get_error_rate() * 100) + "%");
+    if (active & ALERT_ERROR_RATE) {
+        alerts.push_back("High error rate: " + std::to_string(metrics.error_rate() * 100) + "%");
     }
     
     return alerts;
 }
 
+bool MetricsCollector::check_alerts() const {
+    return !alerts_for(get_current_metrics()).empty();
+}
+
+std::vector<std::string> MetricsCollector::get_active_alerts() const {
+    return alerts_for(get_current_metrics());
+}
+
 // Reporting
 void MetricsCollector::generate_report(const std::string& filename) const {
     std::ofstream report_file;
@@ -240,6 +415,7 @@ void MetricsCollector::generate_report(const std::string& filename) const {
         std::cerr << "Failed to open report file" << std::endl;
         return;
     }
+    CacheMetrics metrics = get_current_metrics();
     
     // Generate HTML report
     report_file << "<!DOCTYPE html>\n<html>\n<head>\n";
@@ -256,62 +432,73 @@ void MetricsCollector::generate_report(const std::string& filename) const {
     
     // Performance metrics
     report_file << "<h2>Performance Metrics</h2>\n";
-    report_file << "<div class='metric " << (get_average_insert_latency() < 1000 ? "good" : "alert") << "'>\n";
-    report_file << "<strong>Average Insert Latency:</strong> " << get_average_insert_latency() << " ns\n";
+    report_file << "<div class='metric " << (metrics.average_latency(MetricOp::INSERT) < 1000 ? "good" : "alert") << "'>\n";
+    report_file << "<strong>Average Insert Latency:</strong> " << metrics.average_latency(MetricOp::INSERT) << " ns\n";
     report_file << "</div>\n";
     
-    report_file << "<div class='metric " << (get_average_retrieve_latency() < 500 ? "good" : "alert") << "'>\n";
-    report_file << "<strong>Average Retrieve Latency:</strong> " << get_average_retrieve_latency() << " ns\n";
+    report_file << "<div class='metric " << (metrics.average_latency(MetricOp::RETRIEVE) < 500 ? "good" : "alert") << "'>\n";
+    report_file << "<strong>Average Retrieve Latency:</strong> " << metrics.average_latency(MetricOp::RETRIEVE) << " ns\n";
     report_file << "</div>\n";
     
-    report_file << "<div class='metric " << (get_cache_hit_rate() > 0.8 ? "good" : "alert") << "'>\n";
+    report_file << "<div class='metric " << (metrics.hit_rate() > 0.8 ? "good" : "alert") << "'>\n";
     report_file << "<strong>Cache Hit Rate:</strong> " << std::fixed << std::setprecision(2) 
-                << (get_cache_hit_rate() * 100) << "%\n";
+                << (metrics.hit_rate() * 100) << "%\n";
     report_file << "</div>\n";
     
+    // Latency distribution
+    report_file << "<h2>Latency (ns)</h2>\n<table>\n";
+    report_file << "<tr><th>Operation</th><th>Count</th><th>p50</th><th>p99</th><th>p99.9</th><th>Max</th></tr>\n";
+    for (size_t op = 0; op < OPS; ++op) {
+        const LatencySummary& latency = metrics.latency[op];
+        report_file << "<tr><td>" << metric_op_name(static_cast<MetricOp>(op)) << "</td><td>" << latency.count
+                    << "</td><td>" << latency.p50_ns << "</td><td>" << latency.p99_ns << "</td><td>"
+                    << latency.p999_ns << "</td><td>" << latency.max_ns << "</td></tr>\n";
+    }
+    report_file << "</table>\n";
+    
     // Memory metrics
     report_file << "<h2>Memory Metrics</h2>\n";
-    report_file << "<div class='metric " << (get_memory_utilization() < 0.8 ? "good" : "alert") << "'>\n";
+    report_file << "<div class='metric " << (memory_utilization(metrics) < 0.8 ? "good" : "alert") << "'>\n";
     report_file << "<strong>Memory Utilization:</strong> " << std::fixed << std::setprecision(2) 
-                << (get_memory_utilization() * 100) << "%\n";
+                << (memory_utilization(metrics) * 100) << "%\n";
     report_file << "</div>\n";
     
     report_file << "<div class='metric'>\n";
-    report_file << "<strong>Current Memory Usage:</strong> " << metrics_.current_memory_usage.load() << " bytes\n";
+    report_file << "<strong>Current Memory Usage:</strong> " << metrics.current_memory_usage << " bytes\n";
     report_file << "</div>\n";
     
     report_file << "<div class='metric'>\n";
-    report_file << "<strong>Peak Memory Usage:</strong> " << metrics_.peak_memory_usage.load() << " bytes\n";
+    report_file << "<strong>Peak Memory Usage:</strong> " << metrics.peak_memory_usage << " bytes\n";
     report_file << "</div>\n";
     
     // Error metrics
     report_file << "<h2>Error Metrics</h2>\n";
-    report_file << "<div class='metric " << (get_error_rate() < 0.01 ? "good" : "alert") << "'>\n";
+    report_file << "<div class='metric " << (metrics.error_rate() < 0.01 ? "good" : "alert") << "'>\n";
     report_file << "<strong>Error Rate:</strong> " << std::fixed << std::setprecision(4) 
-                << (get_error_rate() * 100) << "%\n";
+                << (metrics.error_rate() * 100) << "%\n";
     report_file << "</div>\n";
     
     report_file << "<div class='metric'>\n";
-    report_file << "<strong>Total Errors:</strong> " << (metrics_.insert_errors.load() + metrics_.retrieve_errors.load()) << "\n";
+    report_file << "<strong>Total Errors:</strong> " << (metrics.insert_errors + metrics.retrieve_errors) << "\n";
     report_file << "</div>\n";
     
     // Operation counts
     report_file << "<h2>Operation Counts</h2>\n";
     report_file << "<div class='metric'>\n";
-    report_file << "<strong>Total Inserts:</strong> " << metrics_.total_inserts.load() << "\n";
+    report_file << "<strong>Total Inserts:</strong> " << metrics.total_inserts << "\n";
     report_file << "</div>\n";
     
     report_file << "<div class='metric'>\n";
-    report_file << "<strong>Total Retrieves:</strong> " << metrics_.total_retrieves.load() << "\n";
+    report_file << "<strong>Total Retrieves:</strong> " << metrics.total_retrieves << "\n";
     report_file << "</div>\n";
     
     report_file << "<div class='metric'>\n";
     report_file << "<strong>Total Batch Operations:</strong> " 
-                << (metrics_.total_batch_inserts.load() + metrics_.total_batch_retrieves.load()) << "\n";
+                << (metrics.total_batch_inserts + metrics.total_batch_retrieves) << "\n";
     report_file << "</div>\n";
     
     // Active alerts
-    auto alerts = get_active_alerts();
+    auto alerts = alerts_for(metrics);
     if (!alerts.empty()) {
         report_file << "<h2>Active Alerts</h2>\n";
         for (const auto& alert : alerts) {
@@ -337,32 +524,42 @@ void MetricsCollector::export_metrics(const std::string& filename) const {
         std::cerr << "Failed to open export file" << std::endl;
         return;
     }
+    CacheMetrics metrics = get_current_metrics();
     
     // Export as JSON
     export_file << "{\n";
     export_file << "  \"timestamp\": " << std::chrono::system_clock::now().time_since_epoch().count() << ",\n";
     export_file << "  \"performance\": {\n";
-    export_file << "    \"average_insert_latency_ns\": " << get_average_insert_latency() << ",\n";
-    export_file << "    \"average_retrieve_latency_ns\": " << get_average_retrieve_latency() << ",\n";
-    export_file << "    \"cache_hit_rate\": " << get_cache_hit_rate() << ",\n";
-    export_file << "    \"error_rate\": " << get_error_rate() << "\n";
+    export_file << "    \"average_insert_latency_ns\": " << metrics.average_latency(MetricOp::INSERT) << ",\n";
+    export_file << "    \"average_retrieve_latency_ns\": " << metrics.average_latency(MetricOp::RETRIEVE) << ",\n";
+    export_file << "    \"cache_hit_rate\": " << metrics.hit_rate() << ",\n";
+    export_file << "    \"error_rate\": " << metrics.error_rate() << "\n";
+    export_file << "  },\n";
+    export_file << "  \"latency_ns\": {\n";
+    for (size_t op = 0; op < OPS; ++op) {
+        const LatencySummary& latency = metrics.latency[op];
+        export_file << "    \"" << metric_op_name(static_cast<MetricOp>(op)) << "\": {\"count\": " << latency.count
+                    << ", \"mean\": " << latency.mean_ns << ", \"p50\": " << latency.p50_ns
+                    << ", \"p99\": " << latency.p99_ns << ", \"p999\": " << latency.p999_ns
+                    << ", \"max\": " << latency.max_ns << "}" << (op + 1 < OPS ? ",\n" : "\n");
+    }
     export_file << "  },\n";
     export_file << "  \"memory\": {\n";
-    export_file << "    \"current_usage_bytes\": " << metrics_.current_memory_usage.load() << ",\n";
-    export_file << "    \"peak_usage_bytes\": " << metrics_.peak_memory_usage.load() << ",\n";
-    export_file << "    \"utilization\": " << get_memory_utilization() << "\n";
+    export_file << "    \"current_usage_bytes\": " << metrics.current_memory_usage << ",\n";
+    export_file << "    \"peak_usage_bytes\": " << metrics.peak_memory_usage << ",\n";
+    export_file << "    \"utilization\": " << memory_utilization(metrics) << "\n";
     export_file << "  },\n";
     export_file << "  \"operations\": {\n";
-    export_file << "    \"total_inserts\": " << metrics_.total_inserts.load() << ",\n";
-    export_file << "    \"total_retrieves\": " << metrics_.total_retrieves.load() << ",\n";
-    export_file << "    \"total_batch_inserts\": " << metrics_.total_batch_inserts.load() << ",\n";
-    export_file << "    \"total_batch_retrieves\": " << metrics_.total_batch_retrieves.load() << "\n";
+    export_file << "    \"total_inserts\": " << metrics.total_inserts << ",\n";
+    export_file << "    \"total_retrieves\": " << metrics.total_retrieves << ",\n";
+    export_file << "    \"total_batch_inserts\": " << metrics.total_batch_inserts << ",\n";
+    export_file << "    \"total_batch_retrieves\": " << metrics.total_batch_retrieves << "\n";
     export_file << "  },\n";
     export_file << "  \"errors\": {\n";
-    export_file << "    \"insert_errors\": " << metrics_.insert_errors.load() << ",\n";
-    export_file << "    \"retrieve_errors\": " << metrics_.retrieve_errors.load() << ",\n";
-    export_file << "    \"memory_errors\": " << metrics_.memory_errors.load() << ",\n";
-    export_file << "    \"recovery_attempts\": " << metrics_.recovery_attempts.load() << "\n";
+    export_file << "    \"insert_errors\": " << metrics.insert_errors << ",\n";
+    export_file << "    \"retrieve_errors\": " << metrics.retrieve_errors << ",\n";
+    export_file << "    \"memory_errors\": " << metrics.memory_errors << ",\n";
+    export_file << "    \"recovery_attempts\": " << metrics.recovery_attempts << "\n";
     export_file << "  }\n";
     export_file << "}\n";
     
@@ -375,14 +572,14 @@ void MetricsCollector::set_alert_thresholds(const AlertThresholds& thresholds) {
 }
 
 void MetricsCollector::enable_metrics_collection(bool enable) {
-    config_.enable_metrics = enable;
+    enabled_.store(enable);
     
     if (enable && !metrics_thread_.joinable()) {
-        start_metrics_thread();
         open_metrics_file();
+        start_metrics_thread();
     } else if (!enable && metrics_thread_.joinable()) {
-        shutdown_.store(true);
-        metrics_thread_.join();
+        stop_metrics_thread();
+        std::lock_guard<std::mutex> lock(file_mutex_);
         if (metrics_file_.is_open()) {
             metrics_file_.close();
         }
@@ -395,74 +592,105 @@ void MetricsCollector::start_metrics_thread() {
     metrics_thread_ = std::thread(&MetricsCollector::metrics_worker, this);
 }
 
+void MetricsCollector::stop_metrics_thread() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        shutdown_.store(true);
+    }
+    wake_.notify_all();
+    if (metrics_thread_.joinable()) {
+        metrics_thread_.join();
+    }
+}
+
 void MetricsCollector::metrics_worker() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
     while (!shutdown_.load()) {
-        write_metrics_to_file();
-        update_historical_data();
-        check_and_trigger_alerts();
-        
-        std::this_thread::sleep_for(std::chrono::milliseconds(config_.metrics_interval_ms));
+        lock.unlock();
+        // One merge per interval feeds the region, the file and the alerts
+        CacheMetrics metrics = get_current_metrics();
+        uint64_t alerts = alert_bits(metrics);
+        publish(metrics, alerts);
+        write_metrics_to_file(metrics);
+        check_and_trigger_alerts(metrics, alerts);
+        lock.lock();
+        wake_.wait_for(lock, std::chrono::milliseconds(config_.metrics_interval_ms),
+                       [this] { return shutdown_.load(); });
     }
 }
 
-void MetricsCollector::write_metrics_to_file() {
-    if (!metrics_file_.is_open()) return;
-    
+void MetricsCollector::write_metrics_to_file(const CacheMetrics& metrics) {
     std::lock_guard<std::mutex> lock(file_mutex_);
+    if (!metrics_file_.is_open()) return;
     
     auto now = std::chrono::system_clock::now();
     auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+    const LatencySummary& insert = metrics.latency_of(MetricOp::INSERT);
+    const LatencySummary& retrieve = metrics.latency_of(MetricOp::RETRIEVE);
     
     metrics_file_ << timestamp << ","
-                  << get_average_insert_latency() << ","
-                  << get_average_retrieve_latency() << ","
-                  << get_cache_hit_rate() << ","
-                  << get_error_rate() << ","
-                  << get_memory_utilization() << ","
-                  << metrics_.total_inserts.load() << ","
-                  << metrics_.total_retrieves.load() << "\n";
+                  << insert.mean_ns << "," << insert.p50_ns << "," << insert.p99_ns << ","
+                  << insert.p999_ns << "," << insert.max_ns << ","
+                  << retrieve.mean_ns << "," << retrieve.p50_ns << "," << retrieve.p99_ns << ","
+                  << retrieve.p999_ns << "," << retrieve.max_ns << ","
+                  << metrics.hit_rate() << ","
+                  << metrics.error_rate() << ","
+                  << memory_utilization(metrics) << ","
+                  << metrics.total_inserts << ","
+                  << metrics.total_retrieves << "\n";
     
     metrics_file_.flush();
 }
 
-void MetricsCollector::update_historical_data() {
-    std::lock_guard<std::mutex> lock(history_mutex_);
-    
-    MetricsSnapshot snapshot;
-    snapshot.timestamp = std::chrono::steady_clock::now();
-    snapshot.metrics = metrics_;
-    
-    historical_data_.push_back(snapshot);
-    
-    // Maintain history size
-    while (historical_data_.size() > MAX_HISTORY_SIZE) {
-        historical_data_.erase(historical_data_.begin());
-    }
+void MetricsCollector::publish(const CacheMetrics& metrics, uint64_t alerts) {
+    MetricsSample sample;
+    sample.steady_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    sample.unix_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    sample.alerts = alerts;
+    sample.metrics = metrics;
+    region_->publish(sample);
 }
 
-void MetricsCollector::check_and_trigger_alerts() {
-    if (check_alerts()) {
-        auto alerts = get_active_alerts();
-        for (const auto& alert : alerts) {
+void MetricsCollector::check_and_trigger_alerts(const CacheMetrics& metrics, uint64_t alerts) {
+    // The region carries the live state; stderr only hears of new alerts
+    if (alerts & ~active_alerts_) {
+        for (const auto& alert : alerts_for(metrics)) {
             std::cerr << "ALERT: " << alert << std::endl;
         }
     }
+    active_alerts_ = alerts;
 }
 
 std::string MetricsCollector::format_metrics() const {
+    CacheMetrics metrics = get_current_metrics();
     std::stringstream ss;
     ss << "Metrics Summary:\n";
-    ss << "  Insert Latency: " << get_average_insert_latency() << " ns\n";
-    ss << "  Retrieve Latency: " << get_average_retrieve_latency() << " ns\n";
+    for (size_t op = 0; op < OPS; ++op) {
+        const LatencySummary& latency = metrics.latency[op];
+        ss << "  " << metric_op_name(static_cast<MetricOp>(op)) << " latency: p50 " << latency.p50_ns
+           << " / p99 " << latency.p99_ns << " / p99.9 " << latency.p999_ns << " / max " << latency.max_ns
+           << " ns over " << latency.count << "\n";
+    }
     ss << "  Cache Hit Rate: " << std::fixed << std::setprecision(2) 
-       << (get_cache_hit_rate() * 100) << "%\n";
+       << (metrics.hit_rate() * 100) << "%\n";
     ss << "  Error Rate: " << std::fixed << std::setprecision(4) 
-       << (get_error_rate() * 100) << "%\n";
+       << (metrics.error_rate() * 100) << "%\n";
     ss << "  Memory Usage: " << std::fixed << std::setprecision(2) 
-       << (get_memory_utilization() * 100) << "%\n";
+       << (memory_utilization(metrics) * 100) << "%\n";
     return ss.str();
 }
 
+namespace {
+
+const char* const METRICS_FILE_HEADER =
+    "timestamp,insert_mean_ns,insert_p50_ns,insert_p99_ns,insert_p999_ns,insert_max_ns,"
+    "retrieve_mean_ns,retrieve_p50_ns,retrieve_p99_ns,retrieve_p999_ns,retrieve_max_ns,"
+    "hit_rate,error_rate,memory_utilization,total_inserts,total_retrieves\n";
+
+} // namespace
+
 void MetricsCollector::open_metrics_file() {
     std::lock_guard<std::mutex> lock(file_mutex_);
     
@@ -475,7 +703,7 @@ void MetricsCollector::open_metrics_file() {
         // Write header if file is empty
         metrics_file_.seekp(0, std::ios::end);
         if (metrics_file_.tellp() == 0) {
-            metrics_file_ << "timestamp,insert_latency_ns,retrieve_latency_ns,hit_rate,error_rate,memory_utilization,total_inserts,total_retrieves\n";
+            metrics_file_ << METRICS_FILE_HEADER;
         }
     }
 }
@@ -497,9 +725,9 @@ void MetricsCollector::rotate_metrics_file() {
     // Open new file
     metrics_file_.open(config_.metrics_file, std::ios::app);
     if (metrics_file_.is_open()) {
-        metrics_file_ << "timestamp,insert_latency_ns,retrieve_latency_ns,hit_rate,error_rate,memory_utilization,total_inserts,total_retrieves\n";
+        metrics_file_ << METRICS_FILE_HEADER;
     }
 }
 
 // Global metrics instance
-MetricsCollector* g_metrics = nullptr; 
\ No newline at end of file
+MetricsCollector* g_metrics = nullptr;
@@ -0,0 +1,170 @@
+#include "metrics_region.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <new>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t REGION_BYTES = sizeof(MetricsRegion);
+
+void* map_anonymous() {
+    void* memory = ::mmap(nullptr, REGION_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) throw std::bad_alloc();
+    return memory;
+}
+
+} // namespace
+
+// MetricsRegionWriter Implementation
+MetricsRegionWriter::MetricsRegionWriter(const std::string& path, uint64_t interval_ms) : path_(path) {
+    void* memory = nullptr;
+    if (!path_.empty()) {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ >= 0 && ::ftruncate(fd_, static_cast<off_t>(REGION_BYTES)) == 0) {
+            memory = ::mmap(nullptr, REGION_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (memory == MAP_FAILED) memory = nullptr;
+        }
+        if (!memory && fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+    if (!memory) memory = map_anonymous();
+
+    // A reader that maps the file before this finishes sees magic 0
+    region_ = new (memory) MetricsRegion;
+    region_->interval_ms = interval_ms;
+    region_->magic.store(MetricsRegion::MAGIC, std::memory_order_release);
+}
+
+MetricsRegionWriter::~MetricsRegionWriter() {
+    region_->~MetricsRegion();
+    ::munmap(region_, REGION_BYTES);
+    // The file stays so an agent can read the final sample
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void MetricsRegionWriter::publish(MetricsSample sample) {
+    uint64_t sequence = region_->published.load(std::memory_order_relaxed) + 1;
+    sample.sequence = sequence;
+    region_->slot(sequence).store(sample);
+    region_->published.store(sequence, std::memory_order_release);
+}
+
+// MetricsReader Implementation
+MetricsReader::MetricsReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= REGION_BYTES) {
+        void* memory = ::mmap(nullptr, REGION_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+        if (memory != MAP_FAILED) {
+            mapping_ = memory;
+            mapped_ = REGION_BYTES;
+        }
+    }
+    ::close(fd);
+    if (!mapping_) return;
+
+    const MetricsRegion* region = static_cast<const MetricsRegion*>(mapping_);
+    if (region->magic.load(std::memory_order_acquire) == MetricsRegion::MAGIC &&
+        region->version == MetricsRegion::VERSION && region->history == MetricsRegion::HISTORY &&
+        region->sample_bytes == sizeof(MetricsSample)) {
+        region_ = region;
+    }
+}
+
+MetricsReader::~MetricsReader() {
+    if (mapping_) ::munmap(mapping_, mapped_);
+}
+
+uint64_t MetricsReader::published() const {
+    return region_ ? region_->published.load(std::memory_order_acquire) : 0;
+}
+
+bool MetricsReader::read(uint64_t sequence, MetricsSample& out) const {
+    out = region_->slot(sequence).load();
+    // A different sequence means the writer has lapped this slot
+    return out.sequence == sequence;
+}
+
+bool MetricsReader::latest(MetricsSample& out) const {
+    if (!region_) return false;
+    while (true) {
+        uint64_t newest = published();
+        if (newest == 0) return false;
+        if (read(newest, out)) return true;
+    }
+}
+
+size_t MetricsReader::history(std::vector<MetricsSample>& out, size_t max_samples) const {
+    uint64_t newest = published();
+    if (newest == 0) return 0;
+    uint64_t count = std::min<uint64_t>({newest, max_samples, MetricsRegion::HISTORY});
+    size_t appended = 0;
+    MetricsSample sample;
+    // Oldest first; samples overwritten while copying are skipped
+    for (uint64_t sequence = newest - count + 1; sequence <= newest; ++sequence) {
+        if (!read(sequence, sample)) continue;
+        out.push_back(sample);
+        ++appended;
+    }
+    return appended;
+}
+
+std::string format_prometheus(const MetricsSample& sample) {
+    const CacheMetrics& metrics = sample.metrics;
+    std::ostringstream out;
+
+    out << "# TYPE hft_cache_operations_total counter\n";
+    for (size_t op = 0; op < static_cast<size_t>(MetricOp::COUNT); ++op) {
+        out << "hft_cache_operations_total{op=\"" << metric_op_name(static_cast<MetricOp>(op)) << "\"} "
+            << metrics.latency[op].count << "\n";
+    }
+
+    out << "# TYPE hft_cache_latency_ns summary\n";
+    for (size_t op = 0; op < static_cast<size_t>(MetricOp::COUNT); ++op) {
+        const LatencySummary& latency = metrics.latency[op];
+        const char* name = metric_op_name(static_cast<MetricOp>(op));
+        out << "hft_cache_latency_ns{op=\"" << name << "\",quantile=\"0.5\"} " << latency.p50_ns << "\n";
+        out << "hft_cache_latency_ns{op=\"" << name << "\",quantile=\"0.99\"} " << latency.p99_ns << "\n";
+        out << "hft_cache_latency_ns{op=\"" << name << "\",quantile=\"0.999\"} " << latency.p999_ns << "\n";
+        out << "hft_cache_latency_ns_sum{op=\"" << name << "\"} "
+            << static_cast<uint64_t>(latency.mean_ns * static_cast<double>(latency.count)) << "\n";
+        out << "hft_cache_latency_ns_count{op=\"" << name << "\"} " << latency.count << "\n";
+    }
+
+    out << "# TYPE hft_cache_hits_total counter\n";
+    out << "hft_cache_hits_total " << metrics.cache_hits << "\n";
+    out << "# TYPE hft_cache_misses_total counter\n";
+    out << "hft_cache_misses_total " << metrics.cache_misses << "\n";
+    out << "# TYPE hft_cache_batch_items_total counter\n";
+    out << "hft_cache_batch_items_total " << metrics.total_batch_items << "\n";
+
+    out << "# TYPE hft_cache_errors_total counter\n";
+    out << "hft_cache_errors_total{kind=\"insert\"} " << metrics.insert_errors << "\n";
+    out << "hft_cache_errors_total{kind=\"retrieve\"} " << metrics.retrieve_errors << "\n";
+    out << "hft_cache_errors_total{kind=\"memory\"} " << metrics.memory_errors << "\n";
+    out << "# TYPE hft_cache_recovery_attempts_total counter\n";
+    out << "hft_cache_recovery_attempts_total " << metrics.recovery_attempts << "\n";
+
+    out << "# TYPE hft_cache_memory_bytes gauge\n";
+    out << "hft_cache_memory_bytes " << metrics.current_memory_usage << "\n";
+    out << "# TYPE hft_cache_peak_memory_bytes gauge\n";
+    out << "hft_cache_peak_memory_bytes " << metrics.peak_memory_usage << "\n";
+
+    out << "# TYPE hft_cache_numa_allocations_total counter\n";
+    out << "hft_cache_numa_allocations_total " << metrics.numa_allocations << "\n";
+    out << "# TYPE hft_cache_cross_numa_accesses_total counter\n";
+    out << "hft_cache_cross_numa_accesses_total " << metrics.cross_numa_accesses << "\n";
+
+    out << "# TYPE hft_cache_alerts gauge\n";
+    out << "hft_cache_alerts " << sample.alerts << "\n";
+    out << "# TYPE hft_cache_metrics_sequence counter\n";
+    out << "hft_cache_metrics_sequence " << sample.sequence << "\n";
+    return out.str();
+}
@@ -12,7 +12,9 @@ namespace hft_cache {
 
 // MultiLevelCache Implementation
 MultiLevelCache::MultiLevelCache(const CacheConfig& config) 
-    : config_(config) {
+    : config_(config), l1_pool_(2 * std::max<size_t>(config.l1_capacity, 1)),
+      l1_cache_(config.l1_capacity, config.l1_entries_per_symbol),
+      frequency_(config.l1_capacity, config.frequency_sample_factor) {
     
     if (!config_.validate_config()) {
         throw std::invalid_argument("Invalid cache configuration for multi-level cache");
@@ -26,10 +28,6 @@ MultiLevelCache::MultiLevelCache(const CacheConfig& config)
     
     // Start background management
     start_background_management();
-    
-    if (g_metrics) {
-        g_metrics->record_cache_creation("MultiLevelCache");
-    }
 }
 
 MultiLevelCache::~MultiLevelCache() {
@@ -37,193 +35,145 @@ MultiLevelCache::~MultiLevelCache() {
     if (management_thread_.joinable()) {
         management_thread_.join();
     }
+    // HotTier deletes what it still holds; these slots belong to l1_pool_
+    std::vector<Node*> drained;
+    l1_cache_.drain(drained);
+    for (Node* node : drained) l1_pool_.release(node);
 }
 
 bool MultiLevelCache::insert(double value, const std::string& symbol, int priority, double expiry_seconds) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    return insert(value, SymbolRegistry::global().intern(symbol), priority, expiry_seconds);
+}
+
+bool MultiLevelCache::insert(double value, SymbolId symbol, int priority, double expiry_seconds) {
+    HFT_LATENCY_TIMER(timer);
     
     try {
-        // Create new node
-        Node* node = new Node();
-        node->value = value;
-        node->symbol = symbol;
-        node->priority = priority;
-        node->timestamp = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-        node->expiry = std::chrono::high_resolution_clock::now().time_since_epoch().count() + 
-                      static_cast<uint64_t>(expiry_seconds * 1e9);
+        record_access(symbol, nullptr, 0);
+        
+        // Every level copies, so the node itself never leaves the stack
+        Node node(value, priority, expiry_seconds);
+        node.symbol = symbol;
         
         // Try to insert into L1 first (hottest data)
-        if (l1_stats_.item_count.load() < config_.l1_capacity && priority >= config_.l1_min_priority) {
-            if (l1_cache_.enqueue(node)) {
-                l1_stats_.item_count.fetch_add(1);
-                record_access(node, 0);
-                
-                if (g_metrics) {
-                    g_metrics->record_insert(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                        std::chrono::high_resolution_clock::now() - start_time).count());
-                }
-                return true;
-            }
+        if (priority >= config_.l1_min_priority && promote_to_l1(node)) {
+            HFT_RECORD_LATENCY(timer, insert);
+            return true;
         }
         
         // Fall back to L2 cache
         if (l2_cache_->insert(value, symbol, priority, expiry_seconds)) {
             l2_stats_.item_count.fetch_add(1);
             
-            if (g_metrics) {
-                g_metrics->record_insert(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
+            HFT_RECORD_LATENCY(timer, insert);
             return true;
         }
         
         // Finally, try L3 cache
-        if (l3_cache_->insert(node)) {
+        if (l3_cache_->insert(&node)) {
             l3_stats_.item_count.fetch_add(1);
             
-            if (g_metrics) {
-                g_metrics->record_insert(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
+            HFT_RECORD_LATENCY(timer, insert);
             return true;
         }
         
-        // If all levels are full, delete the node
-        delete node;
-        
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::CACHE_FULL, ErrorSeverity::MEDIUM, 
-                "All cache levels are full", __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::CACHE_FULL, ErrorSeverity::MEDIUM,
+                     "All cache levels are full");
         
         return false;
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::INSERTION_FAILED, ErrorSeverity::HIGH,
-                std::string("Insert failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::OPERATION_FAILED, ErrorSeverity::HIGH,
+                     std::string("Insert failed: ") + e.what());
         return false;
     }
 }
 
 Node* MultiLevelCache::get_highest_priority(const std::string& symbol) {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    return get_highest_priority(SymbolRegistry::global().find(symbol));
+}
+
+Node* MultiLevelCache::get_highest_priority(SymbolId symbol) {
+    HFT_LATENCY_TIMER(timer);
+    // Keeps a popped L2 node readable while it is copied into L1, whether
+    // or not the caller holds a guard of its own
+    EpochGuard guard;
     
     try {
         // Search L1 first (fastest)
-        Node* result = nullptr;
-        std::vector<Node*> temp_nodes;
-        
-        // Dequeue all nodes from L1 to search
-        while (l1_cache_.dequeue(result)) {
-            if (result->symbol == symbol) {
-                // Found in L1, record hit and re-queue remaining nodes
-                l1_stats_.hit_count.fetch_add(1);
-                record_access(result, std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-                
-                // Re-queue other nodes
-                for (Node* node : temp_nodes) {
-                    l1_cache_.enqueue(node);
-                }
-                
-                if (g_metrics) {
-                    g_metrics->record_retrieve(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                        std::chrono::high_resolution_clock::now() - start_time).count());
-                }
-                return result;
-            }
-            temp_nodes.push_back(result);
+        Node* result = l1_cache_.pop(symbol);
+        if (result) {
+            l1_pool_.retire(result);
+            l1_stats_.hit_count.fetch_add(1);
+            l1_stats_.item_count.store(l1_cache_.size());
+            record_access(symbol, &l1_stats_, timer.elapsed_ns());
+            
+            HFT_RECORD_LATENCY(timer, retrieve);
+            return result;
         }
         
-        // Re-queue all L1 nodes
-        for (Node* node : temp_nodes) {
-            l1_cache_.enqueue(node);
-        }
+        l1_stats_.miss_count.fetch_add(1);
         
         // Search L2 cache
         result = l2_cache_->get_highest_priority(symbol);
         if (result) {
             l2_stats_.hit_count.fetch_add(1);
-            record_access(result, std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::high_resolution_clock::now() - start_time).count());
+            l2_stats_.item_count.fetch_sub(1);
+            record_access(symbol, &l2_stats_, timer.elapsed_ns());
             
-            // Consider promoting to L1
+            // Consider promoting to L1; result itself was just consumed
             if (should_promote_to_l1(result)) {
-                promote_to_l1(result);
+                promote_next_to_l1(symbol);
             }
             
-            if (g_metrics) {
-                g_metrics->record_retrieve(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
+            HFT_RECORD_LATENCY(timer, retrieve);
             return result;
         }
         
+        l2_stats_.miss_count.fetch_add(1);
+        
         // Search L3 cache
-        result = l3_cache_->retrieve(symbol, 0.0); // 0.0 means any value
+        result = l3_cache_->retrieve_any(symbol);
         if (result) {
             l3_stats_.hit_count.fetch_add(1);
-            record_access(result, std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::high_resolution_clock::now() - start_time).count());
+            record_access(symbol, &l3_stats_, timer.elapsed_ns());
             
-            // Promote to L2
-            if (l2_cache_->insert(result->value, result->symbol, result->priority, 60.0)) {
-                l2_stats_.item_count.fetch_add(1);
+            // Consumed like the other levels; result is a thread-local
+            // copy, so it survives the tombstone
+            if (l3_cache_->remove(symbol, result->value)) {
+                l3_stats_.item_count.fetch_sub(1);
             }
             
-            if (g_metrics) {
-                g_metrics->record_retrieve(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    std::chrono::high_resolution_clock::now() - start_time).count());
-            }
+            HFT_RECORD_LATENCY(timer, retrieve);
             return result;
         }
         
         // Record miss
-        l1_stats_.miss_count.fetch_add(1);
-        l2_stats_.miss_count.fetch_add(1);
         l3_stats_.miss_count.fetch_add(1);
+        record_access(symbol, nullptr, 0);
         
-        if (g_metrics) {
-            g_metrics->record_miss(std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::high_resolution_clock::now() - start_time).count());
-        }
+        HFT_RECORD_LATENCY(timer, retrieve, true, false);
         
         return nullptr;
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::RETRIEVAL_FAILED, ErrorSeverity::HIGH,
-                std::string("Retrieve failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::OPERATION_FAILED, ErrorSeverity::HIGH,
+                     std::string("Retrieve failed: ") + e.what());
         return nullptr;
     }
 }
 
 bool MultiLevelCache::remove(const std::string& symbol, double value) {
+    return remove(SymbolRegistry::global().find(symbol), value);
+}
+
+bool MultiLevelCache::remove(SymbolId symbol, double value) {
     try {
         // Try to remove from L1
-        Node* result = nullptr;
-        std::vector<Node*> temp_nodes;
-        
-        while (l1_cache_.dequeue(result)) {
-            if (result->symbol == symbol && result->value == value) {
-                l1_stats_.item_count.fetch_sub(1);
-                delete result;
-                
-                // Re-queue remaining nodes
-                for (Node* node : temp_nodes) {
-                    l1_cache_.enqueue(node);
-                }
-                return true;
-            }
-            temp_nodes.push_back(result);
-        }
-        
-        // Re-queue all L1 nodes
-        for (Node* node : temp_nodes) {
-            l1_cache_.enqueue(node);
+        if (Node* result = l1_cache_.remove(symbol, value)) {
+            l1_stats_.item_count.store(l1_cache_.size());
+            l1_pool_.retire(result);
+            return true;
         }
         
         // Try L2 cache
@@ -241,21 +191,18 @@ bool MultiLevelCache::remove(const std::string& symbol, double value) {
         return false;
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::REMOVAL_FAILED, ErrorSeverity::MEDIUM,
-                std::string("Remove failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::OPERATION_FAILED, ErrorSeverity::MEDIUM,
+                     std::string("Remove failed: ") + e.what());
         return false;
     }
 }
 
 void MultiLevelCache::clear() {
     // Clear L1 cache
-    Node* node = nullptr;
-    while (l1_cache_.dequeue(node)) {
-        delete node;
-    }
-    l1_stats_.item_count.store(0);
+    std::vector<Node*> drained;
+    l1_cache_.drain(drained);
+    l1_pool_.retire_bulk(drained.data(), drained.size());
+    l1_stats_.item_count.store(l1_cache_.size());
     
     // Clear L2 cache
     l2_cache_->clear();
@@ -266,17 +213,17 @@ void MultiLevelCache::clear() {
     l3_stats_.item_count.store(0);
 }
 
-bool MultiLevelCache::promote_to_l1(Node* node) {
-    if (l1_stats_.item_count.load() >= config_.l1_capacity) {
-        // Need to evict from L1 first
-        eviction_policy_l1();
-    }
-    
-    if (l1_cache_.enqueue(node)) {
-        l1_stats_.item_count.fetch_add(1);
-        return true;
-    }
-    return false;
+bool MultiLevelCache::promote_to_l1(const Node& node) {
+    Node* slot = l1_pool_.allocate();
+    if (!slot) return false;
+    *slot = node;
+    // Admission evicts the CLOCK victim itself when L1 is full
+    Node* evicted = nullptr;
+    bool admitted = l1_cache_.admit(slot, evicted, admission_sketch());
+    if (evicted) demote_from_l1(evicted);
+    if (!admitted) l1_pool_.release(slot);  // never published, so no reader can hold it
+    l1_stats_.item_count.store(l1_cache_.size());
+    return admitted;
 }
 
 bool MultiLevelCache::demote_to_l2(Node* node) {
@@ -333,19 +280,32 @@ void MultiLevelCache::stop_background_management() {
 }
 
 void MultiLevelCache::eviction_policy_l1() {
-    // Simple LRU-like eviction: remove oldest/lowest priority items
-    Node* node = nullptr;
-    if (l1_cache_.dequeue(node)) {
-        l1_stats_.item_count.fetch_sub(1);
-        
-        // Try to demote to L2
-        if (!demote_to_l2(node)) {
-            // If L2 is full, demote to L3
-            if (!demote_to_l3(node)) {
-                // If all levels are full, delete
-                delete node;
-            }
-        }
+    // CLOCK: the first entry without a hit since the hand last passed it
+    if (Node* node = l1_cache_.evict_one()) {
+        demote_from_l1(node);
+        l1_stats_.item_count.store(l1_cache_.size());
+    }
+}
+
+void MultiLevelCache::demote_from_l1(Node* node) {
+    if (!node->is_expired()) {
+        // Both lower levels copy the fields; entries already cold enough
+        // for L3 skip L2
+        if (should_demote_to_l3(node) || !demote_to_l2(node)) demote_to_l3(node);
+    }
+    l1_pool_.retire(node);
+}
+
+void MultiLevelCache::promote_next_to_l1(SymbolId symbol) {
+    Node* next = l2_cache_->get_highest_priority(symbol);
+    if (!next) return;
+    if (promote_to_l1(*next)) {
+        l2_stats_.item_count.fetch_sub(1);
+    } else {
+        // Turned away by admission: back to L2 with what is left of its lifetime
+        uint64_t now = CoarseClock::now();
+        double remaining = next->deadline_ns > now ? static_cast<double>(next->deadline_ns - now) / 1e9 : 0.0;
+        l2_cache_->insert(next->value, next->symbol, next->priority, remaining);
     }
 }
 
@@ -355,8 +315,8 @@ void MultiLevelCache::eviction_policy_l2() {
 }
 
 void MultiLevelCache::eviction_policy_l3() {
-    // L3 eviction is handled by disk space management
-    // This is handled internally by the DiskBackedCache
+    // Dead records only cost disk; reclaim one sparse segment per pass
+    l3_cache_->compact(1);
 }
 
 void MultiLevelCache::background_management_worker() {
@@ -374,53 +334,66 @@ void MultiLevelCache::background_management_worker() {
             std::this_thread::sleep_for(std::chrono::milliseconds(config_.management_interval_ms));
             
         } catch (const std::exception& e) {
-            if (g_error_handler) {
-                g_error_handler->report_error(ErrorType::BACKGROUND_WORKER_FAILED, ErrorSeverity::MEDIUM,
-                    std::string("Background worker failed: ") + e.what(), __FILE__, __LINE__);
-            }
+            REPORT_ERROR(ErrorType::OPERATION_FAILED, ErrorSeverity::MEDIUM,
+                         std::string("Background worker failed: ") + e.what());
         }
     }
 }
 
 bool MultiLevelCache::should_promote_to_l1(const Node* node) const {
     // Promote based on priority and access frequency
-    return node->priority >= config_.l1_min_priority;
+    if (node->priority < config_.l1_min_priority) return false;
+    return !config_.enable_frequency_tiering || frequency_.frequency(node->symbol) >= config_.l1_promote_frequency;
 }
 
 bool MultiLevelCache::should_demote_to_l2(const Node* node) const {
-    // Demote based on low priority or age
-    auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    return node->priority < config_.l1_min_priority || 
-           (now - node->timestamp) > config_.l1_max_age_ns;
+    // Demote based on low priority, age or a symbol that has gone quiet
+    uint64_t now = CoarseClock::now();
+    if (node->priority < config_.l1_min_priority || (now - node->timestamp_ns) > config_.l1_max_age_ns) return true;
+    return config_.enable_frequency_tiering && frequency_.frequency(node->symbol) < config_.l1_demote_frequency;
 }
 
 bool MultiLevelCache::should_demote_to_l3(const Node* node) const {
-    // Demote very old or low priority items
-    auto now = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    return (now - node->timestamp) > config_.l2_max_age_ns;
+    // Demote old items, unless their symbol is still being read
+    uint64_t now = CoarseClock::now();
+    if ((now - node->timestamp_ns) <= config_.l2_max_age_ns) return false;
+    return !config_.enable_frequency_tiering || frequency_.frequency(node->symbol) < config_.l2_demote_frequency;
+}
+
+const FrequencySketch* MultiLevelCache::admission_sketch() const {
+    return config_.enable_frequency_tiering ? &frequency_ : nullptr;
 }
 
-void MultiLevelCache::record_access(Node* node, uint64_t access_time_ns) {
-    node->last_access = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    node->access_count++;
+void MultiLevelCache::record_access(SymbolId symbol, LevelStats* level, uint64_t access_time_ns) {
+    frequency_.increment(symbol);
+    if (level) level->total_access_time_ns.fetch_add(access_time_ns, std::memory_order_relaxed);
 }
 
 void MultiLevelCache::update_access_patterns() {
-    // Update access patterns for promotion/demotion decisions
-    // This could be enhanced with more sophisticated algorithms
+    // Walk a batch of L1 per pass; the sketch's aging does the rest, so a
+    // symbol that stops being read drops below l1_demote_frequency and moves out
+    std::vector<Node*> cooled;
+    l1_cache_.evict_if([this](const Node& node) { return should_demote_to_l2(&node); }, cooled,
+                       config_.batch_size);
+    for (Node* node : cooled) demote_from_l1(node);
+    if (!cooled.empty()) l1_stats_.item_count.store(l1_cache_.size());
 }
 
 // DiskBackedCache Implementation
+namespace {
+
+std::string l3_directory(const CacheConfig& config) {
+    return config.disk_cache_path.empty() ? std::string("./cache_data") : config.disk_cache_path;
+}
+
+// Compaction takes index_mutex_ once per batch so readers interleave
+constexpr size_t COMPACTION_BATCH = 256;
+
+} // namespace
+
 DiskBackedCache::DiskBackedCache(const CacheConfig& config) 
-    : config_(config) {
-    
-    disk_path_ = config_.disk_cache_path;
-    if (disk_path_.empty()) {
-        disk_path_ = "./cache_data";
-    }
-    
-    // Create directory if it doesn't exist
-    std::filesystem::create_directories(disk_path_);
+    : config_(config), disk_path_(l3_directory(config)), store_(disk_path_, config.l3_segment_bytes),
+      filter_(new BloomFilter(2 * config.l3_capacity)) {
     
     // Load existing data from disk
     load_from_disk();
@@ -428,219 +401,492 @@ DiskBackedCache::DiskBackedCache(const CacheConfig& config)
 
 DiskBackedCache::~DiskBackedCache() {
     flush_to_disk();
-    
-    // Clean up memory index
-    for (auto& pair : memory_index_) {
-        delete pair.second;
+    delete filter_.load(std::memory_order_relaxed);
+}
+
+SegmentStore::Location DiskBackedCache::append_record(uint16_t kind, const Node& node) {
+    // Write the ticker rather than the id; ids are only stable within one process
+    const std::string& symbol = SymbolRegistry::global().name(node.symbol);
+    NodeRecord record{node.value, node.timestamp_ns, node.deadline_ns, node.priority,
+                      static_cast<uint16_t>(std::min<size_t>(symbol.size(), UINT16_MAX)), 0};
+    uint8_t buffer[sizeof(NodeRecord) + 256];
+    std::vector<uint8_t> large;
+    uint8_t* payload = buffer;
+    size_t length = sizeof(record) + record.symbol_length;
+    if (length > sizeof(buffer)) {
+        large.resize(length);
+        payload = large.data();
+    }
+    std::memcpy(payload, &record, sizeof(record));
+    std::memcpy(payload + sizeof(record), symbol.data(), record.symbol_length);
+    return store_.append(kind, payload, static_cast<uint32_t>(length));
+}
+
+bool DiskBackedCache::decode_record(const uint8_t* payload, uint32_t length, Node& out) {
+    if (!payload || length < sizeof(NodeRecord)) return false;
+    NodeRecord record;
+    std::memcpy(&record, payload, sizeof(record));
+    if (sizeof(record) + record.symbol_length > length) return false;
+    out.value = record.value;
+    out.timestamp_ns = record.timestamp_ns;
+    out.deadline_ns = record.deadline_ns;
+    out.priority = record.priority;
+    out.symbol = SymbolRegistry::global().intern(
+        std::string(reinterpret_cast<const char*>(payload + sizeof(record)), record.symbol_length));
+    return true;
+}
+
+bool DiskBackedCache::decode_block(const uint8_t* payload, uint32_t length, ColumnCodec::Columns& columns,
+                                   SymbolId& symbol) {
+    if (!payload || length < sizeof(BlockRecord)) return false;
+    BlockRecord record;
+    std::memcpy(&record, payload, sizeof(record));
+    size_t name_bytes = (size_t(record.symbol_length) + 7) & ~size_t(7);
+    if (sizeof(record) + name_bytes > length) return false;
+    uint64_t start = CoarseClock::now();
+    size_t used = ColumnCodec::decode(payload + sizeof(record) + name_bytes, length - sizeof(record) - name_bytes, columns);
+    codec_decode_ns_.fetch_add(CoarseClock::now() - start, std::memory_order_relaxed);
+    if (used == 0 || columns.size() != record.rows) return false;
+    codec_decoded_rows_.fetch_add(record.rows, std::memory_order_relaxed);
+    symbol = SymbolRegistry::global().intern(
+        std::string(reinterpret_cast<const char*>(payload + sizeof(record)), record.symbol_length));
+    return true;
+}
+
+bool DiskBackedCache::read_entry(const DiskEntry& entry, Node& out) {
+    uint32_t length = 0;
+    uint16_t kind = 0;
+    const uint8_t* payload = store_.payload(entry.location, &length, &kind);
+    if (kind != RECORD_BLOCK) return decode_record(payload, length, out);
+
+    thread_local ColumnCodec::Columns columns;
+    SymbolId symbol;
+    if (!decode_block(payload, length, columns, symbol) || entry.row >= columns.size()) return false;
+    out.value = columns.values[entry.row];
+    out.timestamp_ns = columns.timestamps[entry.row];
+    out.deadline_ns = columns.timestamps[entry.row] + columns.lifetimes[entry.row];
+    out.priority = columns.priorities[entry.row];
+    out.symbol = symbol;
+    return true;
+}
+
+void DiskBackedCache::release_entry(const DiskEntry& entry) {
+    if (entry.row == SINGLE_RECORD) {
+        store_.release(entry.location);
+        return;
     }
-    memory_index_.clear();
+    uint32_t length = 0;
+    const uint8_t* payload = store_.payload(entry.location, &length);
+    if (!payload || length < sizeof(BlockRecord)) return;
+    BlockRecord record;
+    std::memcpy(&record, payload, sizeof(record));
+    store_.release(entry.location, record.rows);
+}
+
+void DiskBackedCache::rebuild_filter() {
+    BloomFilter* fresh = new BloomFilter(std::max<size_t>(2 * config_.l3_capacity, 2 * index_.size()));
+    for (const auto& [symbol, entries] : ranked_) {
+        fresh->add(filter_hash(symbol));
+        for (const RankedEntry& entry : entries) fresh->add(filter_hash(symbol, entry.value));
+    }
+    BloomFilter* old = filter_.exchange(fresh, std::memory_order_acq_rel);
+    EpochManager::global().retire(old);
+}
+
+void DiskBackedCache::replace_location(const DiskKey& key, const DiskEntry& entry, uint64_t deadline_ns) {
+    auto [it, inserted] = index_.try_emplace(key, entry);
+    std::set<RankedEntry>& ranked = ranked_[key.symbol];
+    if (!inserted) {
+        release_entry(it->second);
+        ranked.erase(RankedEntry{it->second.priority, key.value, 0});
+        it->second = entry;
+    }
+    ranked.insert(RankedEntry{entry.priority, key.value, deadline_ns});
+}
+
+void DiskBackedCache::erase_entry(std::unordered_map<DiskKey, DiskEntry, DiskKeyHash>::iterator it) {
+    auto ranked = ranked_.find(it->first.symbol);
+    if (ranked != ranked_.end()) {
+        ranked->second.erase(RankedEntry{it->second.priority, it->first.value, 0});
+        if (ranked->second.empty()) ranked_.erase(ranked);
+    }
+    release_entry(it->second);
+    index_.erase(it);
 }
 
-bool DiskBackedCache::insert(Node* node) {
+bool DiskBackedCache::insert(const Node* node) {
     try {
-        std::string key = node->symbol + "_" + std::to_string(node->value);
-        
-        // Check if already exists
-        auto it = memory_index_.find(key);
-        if (it != memory_index_.end()) {
-            // Update existing node
-            delete it->second;
-            it->second = node;
-        } else {
-            // Insert new node
-            memory_index_[key] = node;
-            disk_size_.fetch_add(sizeof(Node));
-        }
-        
+        DiskKey key{node->symbol, node->value};
+        std::unique_lock<std::shared_mutex> lock(index_mutex_);
+        SegmentStore::Location location = append_record(RECORD_PUT, *node);
+        if (location == SegmentStore::INVALID_LOCATION) return false;
+        replace_location(key, DiskEntry{location, SINGLE_RECORD, node->priority}, node->deadline_ns);
+        BloomFilter* filter = filter_.load(std::memory_order_relaxed);
+        filter->add(filter_hash(node->symbol, node->value));
+        filter->add(filter_hash(node->symbol));
         return true;
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::DISK_INSERT_FAILED, ErrorSeverity::MEDIUM,
-                std::string("Disk insert failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::MEDIUM,
+                     std::string("Disk insert failed: ") + e.what());
         return false;
     }
 }
 
 Node* DiskBackedCache::retrieve(const std::string& symbol, double value) {
+    return retrieve(SymbolRegistry::global().find(symbol), value);
+}
+
+Node* DiskBackedCache::retrieve(SymbolId symbol, double value) {
+    thread_local Node scratch;
+    return retrieve(symbol, value, scratch) ? &scratch : nullptr;
+}
+
+bool DiskBackedCache::retrieve(SymbolId symbol, double value, Node& out) {
+    if (!might_hold(filter_hash(symbol, value))) return false;
     try {
-        std::string key = symbol + "_" + std::to_string(value);
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        auto it = index_.find(DiskKey{symbol, value});
+        if (it == index_.end()) return false;
+        return read_entry(it->second, out);
         
-        auto it = memory_index_.find(key);
-        if (it != memory_index_.end()) {
-            return it->second;
+    } catch (const std::exception& e) {
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::MEDIUM,
+                     std::string("Disk retrieve failed: ") + e.what());
+        return false;
+    }
+}
+
+Node* DiskBackedCache::retrieve_any(SymbolId symbol) {
+    if (!might_hold(filter_hash(symbol))) return nullptr;
+    thread_local Node scratch;
+    try {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        auto ranked = ranked_.find(symbol);
+        if (ranked == ranked_.end()) return nullptr;
+        // Expired entries stay indexed until removed; skip past them
+        uint64_t now = CoarseClock::now();
+        for (const RankedEntry& candidate : ranked->second) {
+            if (now > candidate.deadline_ns) continue;
+            auto it = index_.find(DiskKey{symbol, candidate.value});
+            if (it != index_.end() && read_entry(it->second, scratch)) return &scratch;
         }
-        
         return nullptr;
-        
+
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::DISK_RETRIEVE_FAILED, ErrorSeverity::MEDIUM,
-                std::string("Disk retrieve failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::MEDIUM,
+                     std::string("Disk retrieve failed: ") + e.what());
         return nullptr;
     }
 }
 
+void DiskBackedCache::prefetch(SymbolId symbol, double value) {
+    if (!might_hold(filter_hash(symbol, value))) return;
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    auto it = index_.find(DiskKey{symbol, value});
+    if (it != index_.end()) store_.prefetch(it->second.location);
+}
+
 bool DiskBackedCache::remove(const std::string& symbol, double value) {
+    return remove(SymbolRegistry::global().find(symbol), value);
+}
+
+bool DiskBackedCache::remove(SymbolId symbol, double value) {
+    if (!might_hold(filter_hash(symbol, value))) return false;
     try {
-        std::string key = symbol + "_" + std::to_string(value);
-        
-        auto it = memory_index_.find(key);
-        if (it != memory_index_.end()) {
-            delete it->second;
-            memory_index_.erase(it);
-            disk_size_.fetch_sub(sizeof(Node));
-            return true;
-        }
-        
-        return false;
+        DiskKey key{symbol, value};
+        std::unique_lock<std::shared_mutex> lock(index_mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        
+        Node tombstone;
+        tombstone.symbol = symbol;
+        tombstone.value = value;
+        SegmentStore::Location location = append_record(RECORD_TOMBSTONE, tombstone);
+        if (location == SegmentStore::INVALID_LOCATION) return false;
+        // Tombstones are never live; they only shadow older segments on replay
+        store_.release(location);
+        erase_entry(it);
+        return true;
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::DISK_REMOVE_FAILED, ErrorSeverity::MEDIUM,
-                std::string("Disk remove failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::MEDIUM,
+                     std::string("Disk remove failed: ") + e.what());
         return false;
     }
 }
 
 void DiskBackedCache::clear() {
-    for (auto& pair : memory_index_) {
-        delete pair.second;
-    }
-    memory_index_.clear();
-    disk_size_.store(0);
+    std::lock_guard<std::mutex> compaction(compaction_mutex_);
+    std::unique_lock<std::shared_mutex> lock(index_mutex_);
+    index_.clear();
+    ranked_.clear();
+    rebuild_filter();
+    store_.clear();
 }
 
 bool DiskBackedCache::flush_to_disk() {
     try {
-        std::string filename = disk_path_ + "/cache_data.bin";
-        std::ofstream file(filename, std::ios::binary);
-        
-        if (!file.is_open()) {
-            return false;
-        }
-        
-        // Write header
-        uint64_t magic = 0xCAFECACHE;
-        uint64_t version = 1;
-        uint64_t count = memory_index_.size();
-        
-        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
-        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
-        
-        // Write nodes
-        for (const auto& pair : memory_index_) {
-            if (!serialize_node(pair.second, file)) {
-                return false;
-            }
-        }
-        
-        return true;
+        std::unique_lock<std::shared_mutex> lock(index_mutex_);
+        return store_.flush(true);
         
     } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::DISK_FLUSH_FAILED, ErrorSeverity::HIGH,
-                std::string("Disk flush failed: ") + e.what(), __FILE__, __LINE__);
-        }
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::HIGH,
+                     std::string("Disk flush failed: ") + e.what());
         return false;
     }
 }
 
 bool DiskBackedCache::load_from_disk() {
     try {
-        std::string filename = disk_path_ + "/cache_data.bin";
-        std::ifstream file(filename, std::ios::binary);
-        
-        if (!file.is_open()) {
-            return false;
+        std::lock_guard<std::mutex> compaction(compaction_mutex_);
+        std::unique_lock<std::shared_mutex> lock(index_mutex_);
+        store_.open_existing();
+        
+        // Replay oldest first so later puts and tombstones win
+        std::vector<uint32_t> segments;
+        store_.for_each_segment([&segments](uint32_t id) { segments.push_back(id); });
+        Node node;
+        ColumnCodec::Columns columns;
+        for (uint32_t id : segments) {
+            store_.scan_segment(id, 0, SIZE_MAX,
+                [&](SegmentStore::Location location, uint16_t kind, const uint8_t* payload, uint32_t length) {
+                    if (kind == RECORD_BLOCK) {
+                        SymbolId symbol;
+                        if (!decode_block(payload, length, columns, symbol)) return true;
+                        for (uint32_t row = 0; row < columns.size(); ++row) {
+                            replace_location(DiskKey{symbol, columns.values[row]},
+                                             DiskEntry{location, row, columns.priorities[row]},
+                                             columns.timestamps[row] + columns.lifetimes[row]);
+                        }
+                        return true;
+                    }
+                    if (!decode_record(payload, length, node)) return true;
+                    DiskKey key{node.symbol, node.value};
+                    if (kind == RECORD_PUT) {
+                        replace_location(key, DiskEntry{location, SINGLE_RECORD, node.priority}, node.deadline_ns);
+                    } else {
+                        auto it = index_.find(key);
+                        if (it != index_.end()) erase_entry(it);
+                        store_.release(location);
+                    }
+                    return true;
+                });
         }
+        rebuild_filter();
+        return !segments.empty();
         
-        // Read header
-        uint64_t magic, version, count;
-        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-        file.read(reinterpret_cast<char*>(&version), sizeof(version));
-        file.read(reinterpret_cast<char*>(&count), sizeof(count));
-        
-        if (magic != 0xCAFECACHE) {
-            return false;
+    } catch (const std::exception& e) {
+        REPORT_ERROR(ErrorType::DISK_IO_ERROR, ErrorSeverity::HIGH,
+                     std::string("Disk load failed: ") + e.what());
+        return false;
+    }
+}
+
+size_t DiskBackedCache::compact(size_t max_segments) {
+    std::lock_guard<std::mutex> compaction(compaction_mutex_);
+    size_t compacted = 0;
+    Node node;
+    ColumnCodec::Columns columns;
+    while (compacted < max_segments) {
+        uint32_t id;
+        bool keep_tombstones;
+        {
+            std::shared_lock<std::shared_mutex> lock(index_mutex_);
+            id = store_.compaction_candidate(config_.l3_compaction_threshold);
+            // A tombstone can only shadow records in older segments
+            keep_tombstones = id && store_.has_segment_before(id);
         }
-        
-        // Read nodes
-        for (uint64_t i = 0; i < count; ++i) {
-            Node* node = deserialize_node(file);
-            if (node) {
-                std::string key = node->symbol + "_" + std::to_string(node->value);
-                memory_index_[key] = node;
-                disk_size_.fetch_add(sizeof(Node));
-            }
+        if (!id) break;
+
+        if (config_.l3_compression) {
+            if (!compact_into_blocks(id, keep_tombstones)) break;
+            std::unique_lock<std::shared_mutex> lock(index_mutex_);
+            store_.drop_segment(id);
+            ++compacted;
+            continue;
         }
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        if (g_error_handler) {
-            g_error_handler->report_error(ErrorType::DISK_LOAD_FAILED, ErrorSeverity::HIGH,
-                std::string("Disk load failed: ") + e.what(), __FILE__, __LINE__);
+
+        // Any failed append keeps the segment: a live record would be lost
+        // with it, and a tombstone not carried forward lets older puts back
+        bool failed = false;
+        size_t offset = 0;
+        do {
+            std::unique_lock<std::shared_mutex> lock(index_mutex_);
+            offset = store_.scan_segment(id, offset, COMPACTION_BATCH,
+                [&](SegmentStore::Location location, uint16_t kind, const uint8_t* payload, uint32_t length) {
+                    if (kind == RECORD_PUT) {
+                        if (!decode_record(payload, length, node)) return true;
+                        auto it = index_.find(DiskKey{node.symbol, node.value});
+                        if (it == index_.end() || it->second != DiskEntry{location, SINGLE_RECORD}) return true;
+                        SegmentStore::Location moved = store_.append(kind, payload, length);
+                        if (moved == SegmentStore::INVALID_LOCATION) {
+                            failed = true;
+                            return false;
+                        }
+                        it->second = DiskEntry{moved, SINGLE_RECORD, it->second.priority};
+                        store_.release(location);
+                    } else if (kind == RECORD_BLOCK) {
+                        // Left over from a compressing run: move it whole
+                        SymbolId symbol;
+                        if (!decode_block(payload, length, columns, symbol)) return true;
+                        SegmentStore::Location moved = SegmentStore::INVALID_LOCATION;
+                        uint32_t rows = static_cast<uint32_t>(columns.size());
+                        uint32_t live = 0;
+                        for (uint32_t row = 0; row < rows; ++row) {
+                            auto it = index_.find(DiskKey{symbol, columns.values[row]});
+                            if (it == index_.end() || it->second != DiskEntry{location, row}) continue;
+                            if (moved == SegmentStore::INVALID_LOCATION) {
+                                moved = store_.append(kind, payload, length);
+                                if (moved == SegmentStore::INVALID_LOCATION) {
+                                    failed = true;
+                                    return false;
+                                }
+                            }
+                            it->second = DiskEntry{moved, row, it->second.priority};
+                            store_.release(location, rows);
+                            ++live;
+                        }
+                        if (moved != SegmentStore::INVALID_LOCATION) {
+                            for (uint32_t dead = live; dead < rows; ++dead) store_.release(moved, rows);
+                        }
+                    } else if (keep_tombstones) {
+                        SegmentStore::Location moved = store_.append(kind, payload, length);
+                        if (moved == SegmentStore::INVALID_LOCATION) {
+                            failed = true;
+                            return false;
+                        }
+                        store_.release(moved);
+                    }
+                    return true;
+                });
+        } while (offset != 0 && !failed);
+        if (failed) break;
+
+        std::unique_lock<std::shared_mutex> lock(index_mutex_);
+        store_.drop_segment(id);
+        ++compacted;
+    }
+    if (compacted) {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        rebuild_filter();
+    }
+    return compacted;
+}
+
+bool DiskBackedCache::compact_into_blocks(uint32_t id, bool keep_tombstones) {
+    struct LiveRow {
+        Node node;
+        DiskEntry from;
+    };
+    std::unordered_map<SymbolId, std::vector<LiveRow>> live;
+    std::vector<std::vector<uint8_t>> tombstones;
+    ColumnCodec::Columns columns;
+    Node node;
+
+    // Collect under the shared lock; the rewrite below rechecks every entry,
+    // so anything replaced or removed meanwhile is simply dropped
+    size_t offset = 0;
+    do {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        offset = store_.scan_segment(id, offset, COMPACTION_BATCH,
+            [&](SegmentStore::Location location, uint16_t kind, const uint8_t* payload, uint32_t length) {
+                if (kind == RECORD_PUT) {
+                    if (!decode_record(payload, length, node)) return true;
+                    DiskEntry entry{location, SINGLE_RECORD};
+                    auto it = index_.find(DiskKey{node.symbol, node.value});
+                    if (it != index_.end() && it->second == entry) live[node.symbol].push_back(LiveRow{node, entry});
+                } else if (kind == RECORD_BLOCK) {
+                    SymbolId symbol;
+                    if (!decode_block(payload, length, columns, symbol)) return true;
+                    for (uint32_t row = 0; row < columns.size(); ++row) {
+                        DiskEntry entry{location, row};
+                        auto it = index_.find(DiskKey{symbol, columns.values[row]});
+                        if (it == index_.end() || it->second != entry) continue;
+                        node.value = columns.values[row];
+                        node.timestamp_ns = columns.timestamps[row];
+                        node.deadline_ns = columns.timestamps[row] + columns.lifetimes[row];
+                        node.priority = columns.priorities[row];
+                        node.symbol = symbol;
+                        live[symbol].push_back(LiveRow{node, entry});
+                    }
+                } else if (keep_tombstones) {
+                    tombstones.emplace_back(payload, payload + length);
+                }
+                return true;
+            });
+    } while (offset != 0);
+
+    std::vector<uint8_t> block;
+    for (auto& [symbol, rows] : live) {
+        const std::string& name = SymbolRegistry::global().name(symbol);
+        std::sort(rows.begin(), rows.end(),
+                  [](const LiveRow& a, const LiveRow& b) { return a.node.timestamp_ns < b.node.timestamp_ns; });
+        for (size_t first = 0; first < rows.size(); first += L3_BLOCK_ROWS) {
+            size_t count = std::min(L3_BLOCK_ROWS, rows.size() - first);
+            uint64_t start = CoarseClock::now();
+            columns.clear();
+            for (size_t i = first; i < first + count; ++i) {
+                const Node& row = rows[i].node;
+                columns.push_back(row.value, row.timestamp_ns, row.deadline_ns - row.timestamp_ns, row.priority);
+            }
+            BlockRecord record{static_cast<uint32_t>(count), static_cast<uint16_t>(std::min<size_t>(name.size(), UINT16_MAX)), 0};
+            size_t name_bytes = (size_t(record.symbol_length) + 7) & ~size_t(7);
+            block.assign(sizeof(record) + name_bytes, 0);
+            std::memcpy(block.data(), &record, sizeof(record));
+            std::memcpy(block.data() + sizeof(record), name.data(), record.symbol_length);
+            ColumnCodec::encode(columns, 0, count, block);
+            codec_encode_ns_.fetch_add(CoarseClock::now() - start, std::memory_order_relaxed);
+
+            std::unique_lock<std::shared_mutex> lock(index_mutex_);
+            SegmentStore::Location moved = store_.append(RECORD_BLOCK, block.data(), static_cast<uint32_t>(block.size()));
+            if (moved == SegmentStore::INVALID_LOCATION) return false;
+            for (size_t i = first; i < first + count; ++i) {
+                auto it = index_.find(DiskKey{symbol, rows[i].node.value});
+                if (it != index_.end() && it->second == rows[i].from) {
+                    it->second = DiskEntry{moved, static_cast<uint32_t>(i - first), it->second.priority};
+                } else {
+                    store_.release(moved, record.rows);
+                }
+            }
+            size_t single = (SegmentStore::HEADER_BYTES + sizeof(NodeRecord) + record.symbol_length + 7) & ~size_t(7);
+            codec_blocks_.fetch_add(1, std::memory_order_relaxed);
+            codec_rows_.fetch_add(count, std::memory_order_relaxed);
+            codec_raw_bytes_.fetch_add(single * count, std::memory_order_relaxed);
+            codec_encoded_bytes_.fetch_add((SegmentStore::HEADER_BYTES + block.size() + 7) & ~size_t(7),
+                                           std::memory_order_relaxed);
         }
-        return false;
     }
+
+    std::unique_lock<std::shared_mutex> lock(index_mutex_);
+    for (const auto& tombstone : tombstones) {
+        SegmentStore::Location moved = store_.append(RECORD_TOMBSTONE, tombstone.data(), static_cast<uint32_t>(tombstone.size()));
+        if (moved == SegmentStore::INVALID_LOCATION) return false;
+        store_.release(moved);
+    }
+    return true;
 }
 
-size_t DiskBackedCache::get_disk_size() const {
-    return disk_size_.load();
+DiskBackedCache::CodecStats DiskBackedCache::codec_stats() const {
+    CodecStats stats;
+    stats.blocks = codec_blocks_.load(std::memory_order_relaxed);
+    stats.rows = codec_rows_.load(std::memory_order_relaxed);
+    stats.raw_bytes = codec_raw_bytes_.load(std::memory_order_relaxed);
+    stats.encoded_bytes = codec_encoded_bytes_.load(std::memory_order_relaxed);
+    stats.encode_ns = codec_encode_ns_.load(std::memory_order_relaxed);
+    stats.decode_ns = codec_decode_ns_.load(std::memory_order_relaxed);
+    stats.decoded_rows = codec_decoded_rows_.load(std::memory_order_relaxed);
+    return stats;
 }
 
-bool DiskBackedCache::serialize_node(const Node* node, std::ofstream& file) {
-    try {
-        // Write node data
-        file.write(reinterpret_cast<const char*>(&node->value), sizeof(node->value));
-        file.write(reinterpret_cast<const char*>(&node->priority), sizeof(node->priority));
-        file.write(reinterpret_cast<const char*>(&node->timestamp), sizeof(node->timestamp));
-        file.write(reinterpret_cast<const char*>(&node->expiry), sizeof(node->expiry));
-        file.write(reinterpret_cast<const char*>(&node->last_access), sizeof(node->last_access));
-        file.write(reinterpret_cast<const char*>(&node->access_count), sizeof(node->access_count));
-        
-        // Write symbol string
-        uint32_t symbol_length = static_cast<uint32_t>(node->symbol.length());
-        file.write(reinterpret_cast<const char*>(&symbol_length), sizeof(symbol_length));
-        file.write(node->symbol.c_str(), symbol_length);
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        return false;
-    }
+size_t DiskBackedCache::get_disk_size() const {
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    return store_.bytes_on_disk();
 }
 
-Node* DiskBackedCache::deserialize_node(std::ifstream& file) {
-    try {
-        Node* node = new Node();
-        
-        // Read node data
-        file.read(reinterpret_cast<char*>(&node->value), sizeof(node->value));
-        file.read(reinterpret_cast<char*>(&node->priority), sizeof(node->priority));
-        file.read(reinterpret_cast<char*>(&node->timestamp), sizeof(node->timestamp));
-        file.read(reinterpret_cast<char*>(&node->expiry), sizeof(node->expiry));
-        file.read(reinterpret_cast<char*>(&node->last_access), sizeof(node->last_access));
-        file.read(reinterpret_cast<char*>(&node->access_count), sizeof(node->access_count));
-        
-        // Read symbol string
-        uint32_t symbol_length;
-        file.read(reinterpret_cast<char*>(&symbol_length), sizeof(symbol_length));
-        
-        std::vector<char> symbol_buffer(symbol_length);
-        file.read(symbol_buffer.data(), symbol_length);
-        node->symbol = std::string(symbol_buffer.data(), symbol_length);
-        
-        return node;
-        
-    } catch (const std::exception& e) {
-        return nullptr;
-    }
+size_t DiskBackedCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    return index_.size();
 }
 
-} // namespace hft_cache 
\ No newline at end of file
+} // namespace hft_cache
@@ -0,0 +1,163 @@
+#include "node_pool.hpp"
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+NodePool::NodePool(size_t capacity, size_t magazine_rounds, size_t numa_partitions)
+    : memory_(capacity * sizeof(Node)), slab_(static_cast<Node*>(memory_.data())), capacity_(capacity),
+      next_(new std::atomic<uint32_t>[capacity]), retire_epoch_(new uint64_t[capacity]) {
+    if (capacity >= NIL) throw std::invalid_argument("NodePool capacity exceeds 32-bit slot indices");
+
+    // Partition indices have to fit the node table's bytes
+    size_t wanted = std::min<size_t>(std::max<size_t>(numa_partitions, 1), UINT8_MAX + 1);
+    partition_slots_ = std::max<size_t>((capacity + wanted - 1) / wanted, 1);
+    // Whole huge pages per partition once the slab is big enough, so no page straddles two nodes
+    constexpr size_t huge_slots = NumaSlab::HUGE_PAGE_BYTES / sizeof(Node);
+    if (wanted > 1 && capacity * sizeof(Node) >= wanted * NumaSlab::HUGE_PAGE_BYTES) {
+        partition_slots_ = (partition_slots_ + huge_slots - 1) / huge_slots * huge_slots;
+    }
+    partition_count_ = std::max<size_t>((capacity + partition_slots_ - 1) / partition_slots_, 1);
+    partitions_.reset(new Partition[partition_count_]);
+
+    const std::vector<int>& nodes = NumaTopology::nodes();
+    local_count_ = static_cast<size_t>(NumaTopology::max_node()) + 1;
+    local_.reset(new uint8_t[local_count_]());
+    for (size_t p = 0; p < partition_count_; ++p) {
+        Partition& partition = partitions_[p];
+        partition.first = static_cast<uint32_t>(std::min(p * partition_slots_, capacity));
+        partition.end = static_cast<uint32_t>(std::min((p + 1) * partition_slots_, capacity));
+        partition.node = nodes[p % nodes.size()];
+        if (p < nodes.size()) local_[partition.node] = static_cast<uint8_t>(p);
+        // Before any Node is constructed, so the pages fault in on their own node
+        if (partition_count_ > 1) {
+            memory_.bind(partition.first * sizeof(Node), (partition.end - partition.first) * sizeof(Node),
+                         partition.node);
+        }
+    }
+    for (size_t p = partition_count_; p < nodes.size(); ++p) {
+        local_[nodes[p]] = static_cast<uint8_t>(p % partition_count_);
+    }
+
+    for (size_t p = 0; p < partition_count_; ++p) {
+        Partition& partition = partitions_[p];
+        for (uint32_t i = partition.first; i < partition.end; ++i) {
+            new (&slab_[i]) Node(0.0);
+            next_[i].store(i + 1 < partition.end ? i + 1 : NIL, std::memory_order_relaxed);
+        }
+        partition.head.store(pack(0, partition.first < partition.end ? partition.first : NIL),
+                             std::memory_order_release);
+        if (magazine_rounds) {
+            partition.magazines = std::make_unique<MagazineCache>(
+                magazine_rounds,
+                [this, &partition](void** out, size_t count) { return refill_magazine(partition, out, count); },
+                [this](void* const* nodes, size_t count) { spill_magazine(nodes, count); });
+        }
+    }
+}
+
+size_t NodePool::allocate_bulk_from(Partition& partition, Node** out, size_t count) {
+    if (count == 0) return 0;
+    uint64_t head = partition.head.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == NIL) {
+            if (!reclaim(partition)) return 0;
+            head = partition.head.load(std::memory_order_acquire);
+            continue;
+        }
+        size_t taken = 0;
+        uint32_t next = index;
+        while (taken < count && next != NIL) {
+            out[taken++] = &slab_[next];
+            next = next_[next].load(std::memory_order_relaxed);
+        }
+        if (partition.head.compare_exchange_weak(head, pack((head >> 32) + 1, next),
+                                                 std::memory_order_acquire, std::memory_order_acquire)) {
+            return taken;
+        }
+    }
+}
+
+Node* NodePool::allocate_remote(Partition& local) {
+    for (size_t i = 0; i < partition_count_; ++i) {
+        Partition& partition = partitions_[i];
+        if (&partition == &local) continue;
+        Node* node;
+        if (partition.magazines) {
+            node = static_cast<Node*>(partition.magazines->allocate());
+        } else {
+            node = pop_free(partition);
+            if (!node && reclaim(partition)) node = pop_free(partition);
+        }
+        if (node) {
+            remote_allocations_.fetch_add(1, std::memory_order_relaxed);
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+size_t NodePool::refill_magazine(Partition& partition, void** out, size_t count) {
+    Node* chain[64];
+    size_t filled = 0;
+    while (filled < count) {
+        size_t taken = allocate_bulk_from(partition, chain, std::min(count - filled, sizeof(chain) / sizeof(chain[0])));
+        if (taken == 0) break;
+        for (size_t i = 0; i < taken; ++i) out[filled++] = chain[i];
+    }
+    return filled;
+}
+
+void NodePool::spill_magazine(void* const* nodes, size_t count) {
+    // A magazine only ever holds slots of the partition whose cache it belongs to
+    if (count == 0) return;
+    uint32_t first = static_cast<uint32_t>(static_cast<Node*>(nodes[0]) - slab_);
+    uint32_t last = first;
+    for (size_t i = 1; i < count; ++i) {
+        uint32_t index = static_cast<uint32_t>(static_cast<Node*>(nodes[i]) - slab_);
+        next_[last].store(index, std::memory_order_relaxed);
+        last = index;
+    }
+    push_free(first, last);
+}
+
+size_t NodePool::reclaim() {
+    size_t freed = 0;
+    for (size_t i = 0; i < partition_count_; ++i) freed += reclaim(partitions_[i]);
+    return freed;
+}
+
+size_t NodePool::reclaim(Partition& partition) {
+    uint32_t index = partition.limbo.exchange(NIL, std::memory_order_acquire);
+    if (index == NIL) return 0;
+
+    // Two advances cover everything retired before this call, provided no
+    // guard is still open from that time
+    EpochManager& epochs = EpochManager::global();
+    epochs.try_advance();
+    epochs.try_advance();
+
+    uint32_t free_first = NIL, free_last = NIL;
+    uint32_t keep_first = NIL, keep_last = NIL;
+    size_t freed = 0;
+    while (index != NIL) {
+        uint32_t next = next_[index].load(std::memory_order_relaxed);
+        bool safe = epochs.is_safe(retire_epoch_[index]);
+        uint32_t& first = safe ? free_first : keep_first;
+        uint32_t& last = safe ? free_last : keep_last;
+        next_[index].store(first, std::memory_order_relaxed);
+        if (first == NIL) last = index;
+        first = index;
+        freed += safe;
+        index = next;
+    }
+    if (free_first != NIL) push_free(free_first, free_last);
+    if (keep_first != NIL) push_limbo(keep_first, keep_last);
+    return freed;
+}
+
+NodePool::~NodePool() {
+    // Magazine caches go first; they only hold pointers into the slab
+    partitions_.reset();
+    for (size_t i = 0; i < capacity_; ++i) slab_[i].~Node();
+}
@@ -0,0 +1,140 @@
+#include "numa_memory.hpp"
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <numa.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+size_t round_up(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+size_t page_bytes() {
+    static const size_t bytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return bytes;
+}
+
+} // namespace
+
+const std::vector<int>& NumaTopology::nodes() {
+    static const std::vector<int> found = [] {
+        std::vector<int> list;
+#ifdef __linux__
+        if (numa_available() >= 0) {
+            for (int node = 0; node <= numa_max_node(); ++node) {
+                if (numa_bitmask_isbitset(numa_all_nodes_ptr, node)) list.push_back(node);
+            }
+        }
+#endif
+        if (list.empty()) list.push_back(0);
+        return list;
+    }();
+    return found;
+}
+
+int NumaTopology::max_node() {
+    return nodes().back();
+}
+
+int NumaTopology::lookup_current_node() {
+#ifdef __linux__
+    if (node_count() > 1) {
+        int cpu = sched_getcpu();
+        int node = cpu >= 0 ? numa_node_of_cpu(cpu) : -1;
+        if (node >= 0) return node;
+    }
+#endif
+    return nodes().front();
+}
+
+NumaSlab::NumaSlab(size_t bytes) : bytes_(bytes) {
+    if (bytes == 0) return;
+    if (bytes < HUGE_PAGE_BYTES) {
+        mapped_ = round_up(bytes, page_bytes());
+        mapping_ = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            throw std::bad_alloc();
+        }
+        data_ = mapping_;
+        return;
+    }
+
+    size_t rounded = round_up(bytes, HUGE_PAGE_BYTES);
+#ifdef MAP_HUGETLB
+    // Fails up front unless enough hugetlb pages are reserved
+    void* hugetlb = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (hugetlb != MAP_FAILED) {
+        data_ = mapping_ = hugetlb;
+        mapped_ = rounded;
+        huge_ = true;
+        return;
+    }
+#endif
+
+    // Over-map by a huge page and trim, so the slab starts on a 2 MB
+    // boundary that transparent huge pages can back
+    size_t span = rounded + HUGE_PAGE_BYTES;
+    void* raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+    uintptr_t start = round_up(reinterpret_cast<uintptr_t>(raw), HUGE_PAGE_BYTES);
+    size_t head = start - reinterpret_cast<uintptr_t>(raw);
+    if (head) munmap(raw, head);
+    if (span - head > rounded) munmap(reinterpret_cast<void*>(start + rounded), span - head - rounded);
+    data_ = mapping_ = reinterpret_cast<void*>(start);
+    mapped_ = rounded;
+#ifdef MADV_HUGEPAGE
+    huge_ = madvise(data_, rounded, MADV_HUGEPAGE) == 0;
+#endif
+}
+
+NumaSlab::~NumaSlab() {
+    release();
+}
+
+NumaSlab::NumaSlab(NumaSlab&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), bytes_(std::exchange(other.bytes_, 0)),
+      mapped_(std::exchange(other.mapped_, 0)), mapping_(std::exchange(other.mapping_, nullptr)),
+      huge_(std::exchange(other.huge_, false)) {}
+
+NumaSlab& NumaSlab::operator=(NumaSlab&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+        mapped_ = std::exchange(other.mapped_, 0);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        huge_ = std::exchange(other.huge_, false);
+    }
+    return *this;
+}
+
+void NumaSlab::release() {
+    if (mapping_) munmap(mapping_, mapped_);
+    mapping_ = data_ = nullptr;
+    mapped_ = bytes_ = 0;
+}
+
+bool NumaSlab::bind(size_t offset, size_t bytes, int node) {
+#ifdef __linux__
+    if (!data_ || numa_available() < 0 || offset >= bytes_) return false;
+    // Binding part of a huge page would split it
+    size_t granule = mapped_ >= HUGE_PAGE_BYTES ? HUGE_PAGE_BYTES : page_bytes();
+    uintptr_t base = reinterpret_cast<uintptr_t>(data_);
+    uintptr_t begin = round_up(base + offset, granule);
+    uintptr_t end = (base + std::min(offset + bytes, mapped_)) / granule * granule;
+    if (offset + bytes >= bytes_) end = base + mapped_;  // the last range takes the rounding slack
+    if (end <= begin) return false;
+    numa_tonode_memory(reinterpret_cast<void*>(begin), end - begin, node);
+    return true;
+#else
+    (void)offset;
+    (void)bytes;
+    (void)node;
+    return false;
+#endif
+}
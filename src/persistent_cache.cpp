@@ -1,51 +1,373 @@
 #include "persistent_cache.hpp"
+#include "column_codec.hpp"
+#include "error_handler.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-PersistentCache::PersistentCache(RadialCircularList& cache, const CacheConfig& config, 
+namespace {
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x4B435448;  // "HTCK"
+constexpr uint32_t CHECKPOINT_VERSION = 4;
+constexpr uint8_t FLAG_COLUMNAR = 1;
+// Records a restore worker takes at a time, so one large symbol still
+// spreads across workers
+constexpr size_t RESTORE_CHUNK = 64 * 1024;
+// Rows per ColumnCodec block in a columnar section
+constexpr size_t CODEC_BLOCK_ROWS = 4096;
+// How often the background thread re-measures CoarseClock against the
+// wall clock, bounding how far calibration error can drift log stamps
+constexpr auto WALL_ANCHOR_INTERVAL = std::chrono::seconds(1);
+
+// On-disk layout: FileHeader, then one section per symbol (its name padded
+// to 8 bytes, then its records), then a SectionEntry per section and the
+// Trailer. Everything is 8-byte aligned, so records can be read in place.
+// With FLAG_COLUMNAR a section holds ColumnCodec blocks instead, rows
+// sorted by time left, with remaining_ns in the timestamp column.
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t type;
+    uint8_t flags;
+    uint8_t reserved[6];
+    uint64_t timestamp;
+    uint64_t base_timestamp;
+};
+
+struct SectionEntry {
+    uint64_t offset;  // of the name, from the start of the file
+    uint32_t count;
+    uint32_t name_length;
+    uint64_t bytes;     // padded name and records
+    uint64_t checksum;  // over those bytes
+};
+
+struct CheckpointRecord {
+    double value;
+    uint64_t remaining_ns;  // time to live left at the cut
+    int32_t priority;
+    uint32_t reserved;
+};
+
+struct Trailer {
+    uint64_t table_offset;
+    uint64_t node_count;
+    uint64_t symbol_count;
+    uint64_t checksum;  // over the header, the table and the trailer before this field
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(CheckpointRecord) == 24 && sizeof(SectionEntry) == 32,
+              "checkpoint layout");
+
+size_t padded_name(size_t length) { return (length + 7) & ~size_t(7); }
+
+uint64_t wall_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t checksum_words(uint64_t hash, const uint8_t* data, size_t length) {
+    return WriteAheadLog::checksum(hash, data, length);
+}
+
+constexpr uint64_t CHECKSUM_SEED = WriteAheadLog::CHECKSUM_SEED;
+
+// Sequential writer over an aligned buffer. Tries O_DIRECT first so a large
+// checkpoint does not push the working set out of the page cache, and drops
+// back to buffered writes where the filesystem refuses it.
+class CheckpointWriter {
+public:
+    static constexpr size_t BLOCK_BYTES = 4096;
+    static constexpr size_t BUFFER_BYTES = size_t(1) << 20;
+
+    CheckpointWriter() : buffer_(static_cast<uint8_t*>(std::aligned_alloc(BLOCK_BYTES, BUFFER_BYTES))) {}
+
+    ~CheckpointWriter() {
+        if (fd_ >= 0) ::close(fd_);
+        std::free(buffer_);
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    bool open(const std::string& path) {
+        if (!buffer_) return false;
+#ifdef O_DIRECT
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        direct_ = fd_ >= 0;
+#endif
+        if (fd_ < 0) fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return fd_ >= 0;
+    }
+
+    void append(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (length && ok_) {
+            size_t chunk = std::min(length, BUFFER_BYTES - used_);
+            std::memcpy(buffer_ + used_, bytes, chunk);
+            used_ += chunk;
+            bytes += chunk;
+            length -= chunk;
+            if (used_ == BUFFER_BYTES) drain(BUFFER_BYTES);
+        }
+    }
+
+    // Pads the tail out to a block, writes it, trims the file back to its
+    // logical length and syncs
+    bool finish() {
+        if (!ok_) return false;
+        size_t logical = written_ + used_;
+        size_t padded = (used_ + BLOCK_BYTES - 1) & ~(BLOCK_BYTES - 1);
+        std::memset(buffer_ + used_, 0, padded - used_);
+        if (padded && !drain(padded)) return false;
+        if (::ftruncate(fd_, static_cast<off_t>(logical)) != 0 || ::fdatasync(fd_) != 0) return false;
+        written_ = logical;
+        bool closed = ::close(fd_) == 0;
+        fd_ = -1;
+        return closed;
+    }
+
+    size_t bytes_written() const { return written_ + used_; }
+    bool direct() const { return direct_; }
+
+private:
+    uint8_t* buffer_;
+    int fd_ = -1;
+    bool direct_ = false;
+    bool ok_ = true;
+    size_t used_ = 0;
+    size_t written_ = 0;
+
+    bool drain(size_t bytes) {
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t n = ::write(fd_, buffer_ + done, bytes - done);
+            if (n < 0 && errno == EINTR) continue;
+#ifdef O_DIRECT
+            if (n < 0 && errno == EINVAL && direct_) {
+                // Opened fine but the filesystem rejects direct writes
+                ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+                direct_ = false;
+                continue;
+            }
+#endif
+            if (n <= 0) {
+                ok_ = false;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        written_ += std::min(bytes, used_);
+        used_ = 0;
+        return true;
+    }
+};
+
+// Runs fn(item) for every item below count on up to workers threads, the
+// calling thread included, each claiming the next item as it finishes one
+template <typename Fn>
+void run_parallel(size_t workers, size_t count, Fn&& fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t item; (item = next.fetch_add(1, std::memory_order_relaxed)) < count;) fn(item);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers > 1 ? workers - 1 : 0);
+    for (size_t i = 1; i < workers; ++i) threads.emplace_back(work);
+    work();
+    for (auto& thread : threads) thread.join();
+}
+
+} // namespace
+
+// A checkpoint mapped read-only. open() checks the header, trailer and
+// offset table; sections are checked separately so that can run in parallel.
+class CheckpointFile {
+public:
+    CheckpointFile() = default;
+    ~CheckpointFile() {
+        if (base_) ::munmap(const_cast<uint8_t*>(base_), size_);
+    }
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        bool mapped = false;
+        if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(FileHeader) + sizeof(Trailer)) {
+            size_ = static_cast<size_t>(info.st_size);
+            void* memory = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (memory != MAP_FAILED) {
+                base_ = static_cast<const uint8_t*>(memory);
+                // Read front to back once, by every worker at the same time
+                ::madvise(memory, size_, MADV_WILLNEED);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        return mapped && validate();
+    }
+
+    const FileHeader& header() const { return header_; }
+    const Trailer& trailer() const { return trailer_; }
+    bool columnar() const { return header_.flags & FLAG_COLUMNAR; }
+    size_t size() const { return size_; }
+    size_t section_count() const { return static_cast<size_t>(trailer_.symbol_count); }
+
+    SectionEntry section(size_t index) const {
+        SectionEntry entry;
+        std::memcpy(&entry, base_ + trailer_.table_offset + index * sizeof(entry), sizeof(entry));
+        return entry;
+    }
+
+    std::string name(const SectionEntry& entry) const {
+        return std::string(reinterpret_cast<const char*>(base_ + entry.offset), entry.name_length);
+    }
+
+    const uint8_t* records(const SectionEntry& entry) const {
+        return base_ + entry.offset + padded_name(entry.name_length);
+    }
+
+    size_t records_bytes(const SectionEntry& entry) const {
+        return static_cast<size_t>(entry.bytes) - padded_name(entry.name_length);
+    }
+
+    // Checks bounds and checksum; a columnar section's blocks must also add
+    // up to its count, so restores can split it without checking again
+    bool verify_section(const SectionEntry& entry) const {
+        size_t name_bytes = padded_name(entry.name_length);
+        if (entry.offset < sizeof(FileHeader) || entry.offset > trailer_.table_offset ||
+            entry.bytes > trailer_.table_offset - entry.offset || entry.bytes < name_bytes) {
+            return false;
+        }
+        if (entry.checksum != checksum_words(CHECKSUM_SEED, base_ + entry.offset, entry.bytes)) return false;
+        if (!columnar()) return entry.bytes == name_bytes + size_t(entry.count) * sizeof(CheckpointRecord);
+
+        const uint8_t* block = records(entry);
+        size_t left = records_bytes(entry);
+        size_t rows = 0;
+        while (left) {
+            size_t block_bytes, block_rows;
+            if (!ColumnCodec::block_extent(block, left, block_bytes, block_rows) ||
+                block_rows > ColumnCodec::MAX_BLOCK_ROWS) {
+                return false;
+            }
+            rows += block_rows;
+            block += block_bytes;
+            left -= block_bytes;
+        }
+        return rows == entry.count;
+    }
+
+private:
+    const uint8_t* base_ = nullptr;
+    size_t size_ = 0;
+    FileHeader header_{};
+    Trailer trailer_{};
+
+    bool validate() {
+        std::memcpy(&header_, base_, sizeof(header_));
+        if (header_.magic != CHECKPOINT_MAGIC || header_.version != CHECKPOINT_VERSION) return false;
+        std::memcpy(&trailer_, base_ + size_ - sizeof(trailer_), sizeof(trailer_));
+        size_t tail = size_ - sizeof(FileHeader) - sizeof(Trailer);
+        if (trailer_.symbol_count > tail / sizeof(SectionEntry)) return false;
+        size_t table_bytes = static_cast<size_t>(trailer_.symbol_count) * sizeof(SectionEntry);
+        if (trailer_.table_offset != size_ - sizeof(Trailer) - table_bytes) return false;
+        uint64_t hash = checksum_words(CHECKSUM_SEED, base_, sizeof(FileHeader));
+        hash = checksum_words(hash, base_ + trailer_.table_offset, table_bytes + offsetof(Trailer, checksum));
+        return hash == trailer_.checksum;
+    }
+};
+
+PersistentCache::PersistentCache(RadialCircularList& cache, const CacheConfig& config,
                                const std::string& checkpoint_dir)
-    : cache_(cache), config_(config), checkpoint_dir_(checkpoint_dir) {
-    
+    : cache_(cache), config_(config), checkpoint_dir_(checkpoint_dir), compression_(config.checkpoint_compression),
+      wall_offset_(wall_ns() - CoarseClock::now()) {
+
     std::filesystem::create_directories(checkpoint_dir_);
+    if (config_.enable_wal) {
+        WriteAheadLog::Options options;
+        options.buffer_entries = config_.wal_buffer_entries;
+        options.group_commit_us = config_.wal_group_commit_us;
+        options.fsync_batch = config_.wal_fsync_batch;
+        options.segment_bytes = config_.wal_segment_bytes;
+        wal_ = std::make_unique<WriteAheadLog>((std::filesystem::path(checkpoint_dir_) / "wal").string(), options);
+        if (!cache_.attach_observer(this)) {
+            REPORT_ERROR(ErrorType::CONFIGURATION_ERROR, ErrorSeverity::HIGH,
+                         "Cache has no free observer slot; write-ahead log will miss changes");
+        }
+    }
     start_checkpoint_thread();
 }
 
 PersistentCache::~PersistentCache() {
-    shutdown_.store(true);
+    set_logging(false);
+    {
+        std::lock_guard<std::mutex> lock(request_mutex_);
+        shutdown_.store(true);
+    }
+    request_cv_.notify_all();
     if (checkpoint_thread_.joinable()) {
         checkpoint_thread_.join();
     }
 }
 
 bool PersistentCache::checkpoint_to_disk(const std::string& filename) {
-    if (checkpoint_in_progress_.load()) {
-        return false;  // Already in progress
-    }
-    
-    std::string checkpoint_file = filename.empty() ? 
-        generate_checkpoint_filename() : filename;
-    
-    return perform_checkpoint(checkpoint_file, false);
+    return request_checkpoint(filename.empty() ? generate_checkpoint_filename() : filename, false);
 }
 
 bool PersistentCache::restore_from_disk(const std::string& filename) {
     if (!std::filesystem::exists(filename)) {
         return false;
     }
-    
-    return perform_restore(filename);
+
+    if (!perform_restore(filename)) {
+        return false;
+    }
+    // The log no longer leads to this state, so give it a new base
+    if (wal_) request_checkpoint(generate_checkpoint_filename(), false);
+    return true;
 }
 
 bool PersistentCache::incremental_checkpoint() {
-    if (checkpoint_in_progress_.load()) {
-        return false;
+    if (wal_) {
+        // The log already holds every change since the last full checkpoint
+        bool synced = wal_->sync();
+        wal_->roll();
+        return synced;
     }
-    
-    std::string checkpoint_file = generate_incremental_filename();
-    return perform_checkpoint(checkpoint_file, true);
+    return request_checkpoint(generate_incremental_filename(), true);
+}
+
+bool PersistentCache::wait_for_checkpoint() {
+    {
+        std::unique_lock<std::mutex> lock(request_mutex_);
+        done_cv_.wait(lock, [this]() { return !checkpoint_in_progress_.load(); });
+    }
+    return last_checkpoint_stats().success;
+}
+
+CheckpointStats PersistentCache::last_checkpoint_stats() const {
+    std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+    return last_stats_;
+}
+
+RestoreStats PersistentCache::last_restore_stats() const {
+    std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+    return last_restore_;
 }
 
 bool PersistentCache::point_in_time_recovery(uint64_t timestamp) {
@@ -53,21 +375,55 @@ bool PersistentCache::point_in_time_recovery(uint64_t timestamp) {
     if (checkpoint_file.empty()) {
         return false;
     }
-    
-    return perform_restore(checkpoint_file);
+
+    std::filesystem::path wal_dir = std::filesystem::path(checkpoint_dir_) / "wal";
+    if (std::filesystem::exists(wal_dir)) {
+        uint64_t base = 0;
+        for (const auto& [path, header] : read_checkpoint_headers()) {
+            if (path == checkpoint_file) base = header.timestamp;
+        }
+        if (!perform_restore(checkpoint_file)) {
+            return false;
+        }
+        replay_wal(base, timestamp);
+        if (wal_) request_checkpoint(generate_checkpoint_filename(), false);
+        return true;
+    }
+
+    // Without a log, incrementals are cumulative over their base, so only the newest one
+    // at or before timestamp is needed on top
+    auto headers = read_checkpoint_headers();
+    uint64_t base = 0;
+    for (const auto& [path, header] : headers) {
+        if (path == checkpoint_file) base = header.timestamp;
+    }
+    std::string newest;
+    uint64_t newest_timestamp = 0;
+    for (const auto& [path, header] : headers) {
+        if (header.type != 1 || header.base_timestamp != base || header.timestamp > timestamp) continue;
+        if (newest.empty() || header.timestamp > newest_timestamp) {
+            newest = path;
+            newest_timestamp = header.timestamp;
+        }
+    }
+
+    if (!perform_restore(checkpoint_file)) {
+        return false;
+    }
+    return newest.empty() || perform_restore(newest);
 }
 
 std::vector<CheckpointMetadata> PersistentCache::list_checkpoints() const {
     std::lock_guard<std::mutex> lock(checkpoint_mutex_);
-    
+
     std::vector<CheckpointMetadata> checkpoints;
     std::queue<CheckpointMetadata> temp_queue = checkpoint_history_;
-    
+
     while (!temp_queue.empty()) {
         checkpoints.push_back(temp_queue.front());
         temp_queue.pop();
     }
-    
+
     return checkpoints;
 }
 
@@ -80,183 +436,446 @@ bool PersistentCache::delete_checkpoint(const std::string& filename) {
 }
 
 void PersistentCache::enable_auto_checkpoint(std::chrono::seconds interval) {
-    // Implementation would schedule periodic checkpoints
-    // This is a placeholder for the actual implementation
+    auto_interval_ns_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count());
+    request_cv_.notify_all();
 }
 
 void PersistentCache::disable_auto_checkpoint() {
-    // Implementation would stop automatic checkpoints
-    // This is a placeholder for the actual implementation
+    auto_interval_ns_.store(0);
+    request_cv_.notify_all();
 }
 
 void PersistentCache::enable_compression(bool enable) {
-    // Implementation would enable/disable checkpoint compression
-    // This is a placeholder for the actual implementation
+    compression_.store(enable);
 }
 
-void PersistentCache::enable_encryption(const std::string& key) {
-    // Implementation would enable checkpoint encryption
-    // This is a placeholder for the actual implementation
+bool PersistentCache::enable_encryption(const std::string& /*key*/) {
+    REPORT_ERROR(ErrorType::CONFIGURATION_ERROR, ErrorSeverity::HIGH,
+                 "Checkpoint encryption is not supported");
+    return false;
 }
 
 // Private methods
 void PersistentCache::start_checkpoint_thread() {
-    checkpoint_thread_ = std::thread([this]() {
-        while (!shutdown_.load()) {
-            // Background checkpoint processing
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+    checkpoint_thread_ = std::thread([this]() { checkpoint_worker(); });
+}
+
+void PersistentCache::reanchor_wall_clock() {
+    wall_offset_.store(wall_ns() - CoarseClock::now(), std::memory_order_relaxed);
+}
+
+void PersistentCache::checkpoint_worker() {
+    std::unique_lock<std::mutex> lock(request_mutex_);
+    auto last_auto = std::chrono::steady_clock::now();
+    while (true) {
+        reanchor_wall_clock();
+        if (request_pending_) {
+            CheckpointRequest request = std::move(pending_request_);
+            request_pending_ = false;
+            lock.unlock();
+            perform_checkpoint(request.filename, request.incremental);
+            lock.lock();
+            checkpoint_in_progress_.store(false);
+            done_cv_.notify_all();
+            continue;
         }
-    });
+        if (shutdown_.load()) break;
+
+        uint64_t interval = auto_interval_ns_.load();
+        auto anchor_due = std::chrono::steady_clock::now() + WALL_ANCHOR_INTERVAL;
+        if (interval == 0) {
+            request_cv_.wait_until(lock, anchor_due);
+            last_auto = std::chrono::steady_clock::now();
+            continue;
+        }
+        auto due = last_auto + std::chrono::nanoseconds(interval);
+        request_cv_.wait_until(lock, std::min<std::chrono::steady_clock::time_point>(due, anchor_due));
+        if (std::chrono::steady_clock::now() >= due) {
+            last_auto = std::chrono::steady_clock::now();
+            if (!checkpoint_in_progress_.exchange(true)) {
+                pending_request_ = CheckpointRequest{generate_checkpoint_filename(), false};
+                request_pending_ = true;
+            }
+        }
+    }
+}
+
+bool PersistentCache::request_checkpoint(const std::string& filename, bool incremental) {
+    if (checkpoint_in_progress_.exchange(true)) {
+        return false;  // Already in progress
+    }
+    {
+        std::lock_guard<std::mutex> lock(request_mutex_);
+        pending_request_ = CheckpointRequest{filename, incremental};
+        request_pending_ = true;
+    }
+    request_cv_.notify_all();
+    return true;
 }
 
 std::string PersistentCache::generate_checkpoint_filename() const {
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-        now.time_since_epoch()).count();
-    
-    return std::string("checkpoint_") + std::to_string(timestamp) + ".dat";
+    return std::string("checkpoint_") + std::to_string(wall_ns()) + ".dat";
 }
 
 std::string PersistentCache::generate_incremental_filename() const {
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-        now.time_since_epoch()).count();
-    
-    return std::string("incremental_") + std::to_string(timestamp) + ".dat";
+    return std::string("incremental_") + std::to_string(wall_ns()) + ".dat";
 }
 
 bool PersistentCache::perform_checkpoint(const std::string& filename, bool incremental) {
-    checkpoint_in_progress_.store(true);
-    
+    CheckpointStats stats;
+    uint64_t started = CoarseClock::now();
+
     try {
         std::filesystem::path filepath = std::filesystem::path(checkpoint_dir_) / filename;
-        std::ofstream file(filepath, std::ios::binary);
-        
-        if (!file.is_open()) {
-            checkpoint_in_progress_.store(false);
+        std::filesystem::path staging = filepath;
+        staging += ".tmp";
+
+        CheckpointWriter writer;
+        if (!writer.open(staging.string())) {
+            std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+            last_stats_ = stats;
             return false;
         }
-        
-        // Write checkpoint header
-        write_checkpoint_header(file, incremental);
-        
-        // Write cache data
-        write_cache_data(file, incremental);
-        
-        // Update metadata
-        update_checkpoint_metadata(filename, incremental);
-        
-        checkpoint_in_progress_.store(false);
-        return true;
-        
+
+        // The cut: nodes stamped after it are left to whatever replays after it
+        uint64_t cut = CoarseClock::now();
+        CheckpointHeader header{CHECKPOINT_VERSION, static_cast<uint8_t>(incremental ? 1 : 0), wall_time(cut),
+                                incremental ? last_checkpoint_wall_ns_.load() : 0, 0, 0};
+        uint64_t since = incremental ? last_checkpoint_timestamp_.load() : 0;
+
+        bool columnar = compression_.load();
+        FileHeader file_header{CHECKPOINT_MAGIC, CHECKPOINT_VERSION, header.type,
+                               static_cast<uint8_t>(columnar ? FLAG_COLUMNAR : 0), {}, header.timestamp,
+                               header.base_timestamp};
+        writer.append(&file_header, sizeof(file_header));
+
+        SymbolRegistry& registry = SymbolRegistry::global();
+        std::vector<Node> staged;
+        std::vector<uint8_t> section;
+        std::vector<SectionEntry> table;
+        ColumnCodec::Columns columns;
+        for (SymbolId id = 0, count = static_cast<SymbolId>(registry.size()); id < count; ++id) {
+            staged.clear();
+            uint64_t copy_start = CoarseClock::now();
+            for (size_t shard = 0; shard < cache_.snapshot_shards(); ++shard) {
+                uint64_t hold_start = CoarseClock::now();
+                cache_.snapshot_shard(id, shard, staged);
+                stats.max_shard_hold_ns = std::max(stats.max_shard_hold_ns, CoarseClock::now() - hold_start);
+            }
+            stats.snapshot_ns += CoarseClock::now() - copy_start;
+
+            auto kept = std::remove_if(staged.begin(), staged.end(), [cut, since](const Node& node) {
+                return node.timestamp_ns > cut || node.timestamp_ns <= since || node.is_expired(cut);
+            });
+            staged.erase(kept, staged.end());
+            if (staged.empty()) continue;
+
+            const std::string& name = registry.name(id);
+            size_t name_bytes = padded_name(name.size());
+            stats.raw_bytes += name_bytes + staged.size() * sizeof(CheckpointRecord);
+            if (columnar) {
+                uint64_t encode_start = CoarseClock::now();
+                section.assign(name_bytes, 0);
+                std::memcpy(section.data(), name.data(), name.size());
+                std::sort(staged.begin(), staged.end(),
+                          [](const Node& a, const Node& b) { return a.deadline_ns < b.deadline_ns; });
+                columns.clear();
+                for (const Node& node : staged) columns.push_back(node.value, node.deadline_ns - cut, 0, node.priority);
+                for (size_t first = 0; first < staged.size(); first += CODEC_BLOCK_ROWS) {
+                    ColumnCodec::encode(columns, first, std::min(CODEC_BLOCK_ROWS, staged.size() - first), section);
+                }
+                stats.encode_ns += CoarseClock::now() - encode_start;
+            } else {
+                section.assign(name_bytes + staged.size() * sizeof(CheckpointRecord), 0);
+                std::memcpy(section.data(), name.data(), name.size());
+                uint8_t* out = section.data() + name_bytes;
+                for (const Node& node : staged) {
+                    CheckpointRecord record{node.value, node.deadline_ns - cut, node.priority, 0};
+                    std::memcpy(out, &record, sizeof(record));
+                    out += sizeof(record);
+                }
+            }
+            table.push_back(SectionEntry{writer.bytes_written(), static_cast<uint32_t>(staged.size()),
+                                         static_cast<uint32_t>(name.size()), section.size(),
+                                         checksum_words(CHECKSUM_SEED, section.data(), section.size())});
+            writer.append(section.data(), section.size());
+            header.node_count += staged.size();
+            ++header.symbol_count;
+        }
+
+        Trailer trailer{writer.bytes_written(), header.node_count, header.symbol_count, 0};
+        const uint8_t* table_bytes = reinterpret_cast<const uint8_t*>(table.data());
+        uint64_t hash = checksum_words(CHECKSUM_SEED, reinterpret_cast<const uint8_t*>(&file_header), sizeof(file_header));
+        hash = checksum_words(hash, table_bytes, table.size() * sizeof(SectionEntry));
+        trailer.checksum = checksum_words(hash, reinterpret_cast<const uint8_t*>(&trailer), offsetof(Trailer, checksum));
+        writer.append(table_bytes, table.size() * sizeof(SectionEntry));
+        writer.append(&trailer, sizeof(trailer));
+
+        stats.direct_io = writer.direct();
+        stats.compressed = columnar;
+        stats.bytes_written = writer.bytes_written();
+        stats.node_count = header.node_count;
+        stats.symbol_count = header.symbol_count;
+        stats.success = writer.finish();
+        if (stats.success) {
+            std::filesystem::rename(staging, filepath);
+            if (!incremental) {
+                last_checkpoint_timestamp_.store(cut);
+                last_checkpoint_wall_ns_.store(header.timestamp);
+            }
+            update_checkpoint_metadata(filename, incremental, header);
+            if (wal_ && !incremental) {
+                // No recovery can start before the oldest full checkpoint
+                uint64_t oldest = header.timestamp;
+                for (const auto& entry : read_checkpoint_headers()) {
+                    if (entry.second.type == 0) oldest = std::min(oldest, entry.second.timestamp);
+                }
+                wal_->truncate_before(oldest);
+            }
+        } else {
+            std::filesystem::remove(staging);
+        }
+        stats.duration_ns = CoarseClock::now() - started;
+
+        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+        last_stats_ = stats;
+        return stats.success;
+
     } catch (const std::exception& e) {
-        checkpoint_in_progress_.store(false);
+        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+        last_stats_ = CheckpointStats();
         return false;
     }
 }
 
 bool PersistentCache::perform_restore(const std::string& filename) {
+    LoggingPause pause(*this);
+    RestoreStats stats;
+    uint64_t started = CoarseClock::now();
+
     try {
-        std::ifstream file(filename, std::ios::binary);
-        
-        if (!file.is_open()) {
+        CheckpointFile file;
+        if (!file.open(filename)) {
+            return false;
+        }
+        std::atomic<bool> intact{true};
+        run_parallel(restore_worker_count(file.section_count()), file.section_count(), [&](size_t index) {
+            if (!file.verify_section(file.section(index))) intact.store(false, std::memory_order_relaxed);
+        });
+        if (!intact.load()) {
             return false;
         }
-        
-        // Read checkpoint header
-        auto header = read_checkpoint_header(file);
-        
-        // Clear current cache
-        clear_cache();
-        
-        // Restore cache data
-        restore_cache_data(file, header);
-        
+
+        // A full checkpoint replaces the cache; an incremental adds to it
+        const FileHeader& header = file.header();
+        if (header.type == 0) {
+            clear_cache();
+        }
+
+        stats.node_count = restore_cache_data(file, stats);
+        stats.symbol_count = file.section_count();
+        stats.bytes_read = file.size();
+        stats.compressed = file.columnar();
+        if (header.type == 0) {
+            // The cache now matches that checkpoint, so later incrementals build on it
+            last_checkpoint_timestamp_.store(CoarseClock::now());
+            last_checkpoint_wall_ns_.store(header.timestamp);
+        }
+        stats.duration_ns = CoarseClock::now() - started;
+        stats.success = true;
+
+        std::lock_guard<std::mutex> lock(checkpoint_mutex_);
+        last_restore_ = stats;
         return true;
-        
+
     } catch (const std::exception& e) {
         return false;
     }
 }
 
-void PersistentCache::write_checkpoint_header(std::ofstream& file, bool incremental) {
-    // Write checkpoint format version
-    uint32_t version = 1;
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-    
-    // Write checkpoint type
-    uint8_t type = incremental ? 1 : 0;
-    file.write(reinterpret_cast<const char*>(&type), sizeof(type));
-    
-    // Write timestamp
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-        now.time_since_epoch()).count();
-    file.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-    
-    // Write node count placeholder
-    uint64_t node_count = 0;  // Will be updated later
-    file.write(reinterpret_cast<const char*>(&node_count), sizeof(node_count));
-}
-
-void PersistentCache::write_cache_data(std::ofstream& file, bool incremental) {
-    // Implementation would serialize all cache data
-    // This is a placeholder for the actual serialization logic
-    
-    // For now, just write a placeholder
-    uint64_t placeholder = 0xDEADBEEF;
-    file.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
-}
-
-void PersistentCache::update_checkpoint_metadata(const std::string& filename, bool incremental) {
+void PersistentCache::update_checkpoint_metadata(const std::string& filename, bool incremental,
+                                                 const CheckpointHeader& header) {
     std::lock_guard<std::mutex> lock(checkpoint_mutex_);
-    
+
     CheckpointMetadata metadata;
-    metadata.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    metadata.timestamp = header.timestamp;
+    metadata.node_count = header.node_count;
+    metadata.symbol_count = header.symbol_count;
     metadata.filename = filename;
     metadata.is_incremental = incremental;
-    
+    metadata.base_checkpoint_timestamp = header.base_timestamp;
+
     checkpoint_history_.push(metadata);
-    
+
     // Maintain history size
     while (checkpoint_history_.size() > MAX_CHECKPOINT_HISTORY) {
         checkpoint_history_.pop();
     }
 }
 
-PersistentCache::CheckpointHeader PersistentCache::read_checkpoint_header(std::ifstream& file) {
-    CheckpointHeader header;
-    
-    file.read(reinterpret_cast<char*>(&header.version), sizeof(header.version));
-    file.read(reinterpret_cast<char*>(&header.type), sizeof(header.type));
-    file.read(reinterpret_cast<char*>(&header.timestamp), sizeof(header.timestamp));
-    file.read(reinterpret_cast<char*>(&header.node_count), sizeof(header.node_count));
-    
-    return header;
+size_t PersistentCache::restore_cache_data(const CheckpointFile& file, RestoreStats& stats) {
+    // Time to live keeps running across the gap since the checkpoint
+    uint64_t now = wall_ns();
+    uint64_t elapsed = now > file.header().timestamp ? now - file.header().timestamp : 0;
+    uint64_t stamp = CoarseClock::now();
+    SymbolRegistry& registry = SymbolRegistry::global();
+    bool columnar = file.columnar();
+
+    // A run of fixed-size records, or of whole codec blocks
+    struct Chunk {
+        SymbolId symbol;
+        const uint8_t* data;
+        size_t bytes;
+        size_t count;
+    };
+    std::vector<Chunk> chunks;
+    for (size_t index = 0; index < file.section_count(); ++index) {
+        SectionEntry entry = file.section(index);
+        SymbolId symbol = registry.intern(file.name(entry));
+        const uint8_t* records = file.records(entry);
+        stats.raw_bytes += padded_name(entry.name_length) + size_t(entry.count) * sizeof(CheckpointRecord);
+        if (!columnar) {
+            for (size_t first = 0; first < entry.count; first += RESTORE_CHUNK) {
+                size_t count = std::min(RESTORE_CHUNK, size_t(entry.count) - first);
+                chunks.push_back(Chunk{symbol, records + first * sizeof(CheckpointRecord),
+                                       count * sizeof(CheckpointRecord), count});
+            }
+            continue;
+        }
+        // verify_section already walked these block headers
+        size_t left = file.records_bytes(entry);
+        Chunk chunk{symbol, records, 0, 0};
+        while (left) {
+            size_t block_bytes, block_rows;
+            ColumnCodec::block_extent(chunk.data + chunk.bytes, left, block_bytes, block_rows);
+            chunk.bytes += block_bytes;
+            chunk.count += block_rows;
+            left -= block_bytes;
+            if (chunk.count >= RESTORE_CHUNK || left == 0) {
+                chunks.push_back(chunk);
+                chunk = Chunk{symbol, chunk.data + chunk.bytes, 0, 0};
+            }
+        }
+    }
+
+    auto fill_from = [elapsed, stamp](Node& node, double value, uint64_t remaining_ns, int32_t priority) {
+        if (remaining_ns <= elapsed) return false;
+        node.value = value;
+        node.priority = priority;
+        node.timestamp_ns = stamp;
+        node.deadline_ns = stamp + (remaining_ns - elapsed);
+        return true;
+    };
+
+    std::atomic<size_t> restored{0};
+    std::atomic<uint64_t> decode_ns{0};
+    stats.threads = restore_worker_count(chunks.size());
+    run_parallel(stats.threads, chunks.size(), [&](size_t index) {
+        const Chunk& chunk = chunks[index];
+        size_t queued = 0;
+        if (!columnar) {
+            queued = cache_.insert_bulk(chunk.symbol, chunk.count, [&](Node& node, size_t i) {
+                CheckpointRecord record;
+                std::memcpy(&record, chunk.data + i * sizeof(record), sizeof(record));
+                return fill_from(node, record.value, record.remaining_ns, record.priority);
+            });
+        } else {
+            thread_local ColumnCodec::Columns columns;
+            for (size_t offset = 0; offset < chunk.bytes;) {
+                uint64_t decode_start = CoarseClock::now();
+                size_t used = ColumnCodec::decode(chunk.data + offset, chunk.bytes - offset, columns);
+                decode_ns.fetch_add(CoarseClock::now() - decode_start, std::memory_order_relaxed);
+                if (used == 0) break;
+                offset += used;
+                queued += cache_.insert_bulk(chunk.symbol, columns.size(), [&](Node& node, size_t i) {
+                    return fill_from(node, columns.values[i], columns.timestamps[i], columns.priorities[i]);
+                });
+            }
+        }
+        restored.fetch_add(queued, std::memory_order_relaxed);
+    });
+    stats.decode_ns = decode_ns.load();
+    return restored.load();
 }
 
-void PersistentCache::restore_cache_data(std::ifstream& file, const CheckpointHeader& header) {
-    // Implementation would deserialize and restore cache data
-    // This is a placeholder for the actual deserialization logic
-    
-    // For now, just read the placeholder
-    uint64_t placeholder;
-    file.read(reinterpret_cast<char*>(&placeholder), sizeof(placeholder));
+size_t PersistentCache::restore_worker_count(size_t work_items) const {
+    size_t workers = config_.restore_threads ? config_.restore_threads : std::thread::hardware_concurrency();
+    return std::max<size_t>(1, std::min(workers, work_items));
 }
 
 void PersistentCache::clear_cache() {
-    // Implementation would clear the current cache
-    // This is a placeholder for the actual implementation
+    cache_.clear();
+}
+
+std::vector<std::pair<std::string, PersistentCache::CheckpointHeader>> PersistentCache::read_checkpoint_headers() const {
+    std::vector<std::pair<std::string, CheckpointHeader>> headers;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(checkpoint_dir_, error)) {
+        if (entry.path().extension() != ".dat") continue;
+        std::ifstream file(entry.path(), std::ios::binary);
+        FileHeader file_header;
+        if (!file.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))) continue;
+        if (file_header.magic != CHECKPOINT_MAGIC || file_header.version != CHECKPOINT_VERSION) continue;
+        CheckpointHeader header{file_header.version, file_header.type, file_header.timestamp,
+                                file_header.base_timestamp, 0, 0};
+        headers.emplace_back(entry.path().string(), header);
+    }
+    return headers;
 }
 
 std::string PersistentCache::find_checkpoint_at_time(uint64_t timestamp) const {
-    // Implementation would find the closest checkpoint to the given timestamp
-    // This is a placeholder for the actual implementation
-    return "";
+    std::string best;
+    uint64_t best_timestamp = 0;
+    for (const auto& [path, header] : read_checkpoint_headers()) {
+        if (header.type != 0 || header.timestamp > timestamp) continue;
+        if (best.empty() || header.timestamp > best_timestamp) {
+            best = path;
+            best_timestamp = header.timestamp;
+        }
+    }
+    return best;
+}
+
+bool PersistentCache::sync_wal() {
+    return wal_ && wal_->sync();
+}
+
+void PersistentCache::on_insert(const Node& node) {
+    if (!wal_) return;
+    wal_->append(WriteAheadLog::Entry{wall_time(node.timestamp_ns), node.value, node.deadline_ns - node.timestamp_ns,
+                                      node.priority, WriteAheadLog::INSERT, 0, node.symbol, 0});
+}
+
+void PersistentCache::on_remove(const Node& node) {
+    if (!wal_) return;
+    uint64_t now = CoarseClock::now();
+    if (node.is_expired(now)) return;  // replay expires it on its own
+    wal_->append(WriteAheadLog::Entry{wall_time(now), node.value, 0, node.priority, WriteAheadLog::REMOVE, 0,
+                                      node.symbol, 0});
+}
+
+size_t PersistentCache::replay_wal(uint64_t after, uint64_t until) {
+    LoggingPause pause(*this);
+
+    uint64_t now = wall_ns();
+    std::string directory = (std::filesystem::path(checkpoint_dir_) / "wal").string();
+    return WriteAheadLog::replay(directory, after, until, [this, now](const WriteAheadLog::Entry& entry) {
+        if (entry.kind == WriteAheadLog::INSERT) {
+            uint64_t deadline = entry.timestamp_ns + entry.ttl_ns;
+            if (deadline > now) {
+                cache_.insert(entry.value, entry.symbol, entry.priority, static_cast<double>(deadline - now) / 1e9);
+            }
+        } else if (entry.kind == WriteAheadLog::REMOVE) {
+            cache_.remove(entry.symbol, entry.value);
+        }
+    });
 }
 
-void PersistentCache::record_node_modification(uint64_t timestamp, const std::string& node_id) {
-    std::lock_guard<std::mutex> lock(modification_mutex_);
-    modified_nodes_.emplace_back(timestamp, node_id);
-} 
\ No newline at end of file
+void PersistentCache::set_logging(bool enabled) {
+    if (!wal_) return;
+    if (enabled) {
+        cache_.attach_observer(this);
+    } else {
+        cache_.detach_observer(this);
+    }
+}
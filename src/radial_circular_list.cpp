@@ -1,92 +1,268 @@
 #include "radial_circular_list.hpp"
 
+RadialCircularList::RadialCircularList(const CacheConfig& config)
+    : symbols(SymbolRegistry::global()), max_nodes(config.max_nodes), heap_capacity(config.max_nodes / 10),
+      heap_shards(config.priority_queue_shards),
+      node_pool(config.max_nodes, config.node_magazine_rounds, config.enable_numa ? NumaTopology::node_count() : 1),
+      expiry([this](SymbolId id, uint64_t now, size_t limit, uint64_t& next) {
+          return purge_expired(id, now, limit, next);
+      }),
+      numa_split(node_pool.partition_count() > 1) {}
+
 RadialCircularList::RadialCircularList(size_t max)
-    : midpoints(max / 10), max_nodes(max), total_nodes(0), pool_index(0) {
-#ifdef __linux__
-    if (numa_available() >= 0) {
-        numa_set_preferred(numa_node_of_cpu(sched_getcpu()));
-    }
-#endif
-    node_pool.resize(max_nodes);
-    for (size_t i = 0; i < max_nodes; ++i) {
-#ifdef __linux__
-        if (numa_available() >= 0) {
-            node_pool[i] = static_cast<Node*>(numa_alloc_onnode(sizeof(Node), numa_node_of_cpu(sched_getcpu())));
-            new (node_pool[i]) Node(0.0);
-        } else {
-            node_pool[i] = new Node(0.0);
-        }
-#else
-        node_pool[i] = new Node(0.0);
-#endif
+    : symbols(SymbolRegistry::global()), max_nodes(max), heap_capacity(max / 10), heap_shards(1), node_pool(max),
+      expiry([this](SymbolId id, uint64_t now, size_t limit, uint64_t& next) {
+          return purge_expired(id, now, limit, next);
+      }),
+      numa_split(false) {}
+
+RadialCircularList::~RadialCircularList() = default;
+
+bool RadialCircularList::push_node(SymbolId midpoint, MidpointNode* mid, Node* node) {
+    // Read before the push: once queued the node may be popped and recycled
+    uint64_t deadline = node->deadline_ns;
+    CacheObserver* watcher = observers.active();
+    if (watcher) watcher->on_insert(*node);
+    if (!mid->add_node(node)) {
+        if (watcher) watcher->on_remove(*node);
+        return false;
     }
+    if (mid->note_deadline(deadline)) expiry.schedule(midpoint, deadline);
+    return true;
 }
 
-RadialCircularList::~RadialCircularList() {
-    for (auto node : node_pool) {
-#ifdef __linux__
-        if (numa_available() >= 0) {
-            node->~Node();
-            numa_free(node, sizeof(Node));
-        } else {
-            delete node;
-        }
-#else
-        delete node;
-#endif
+size_t RadialCircularList::purge_expired(SymbolId midpoint, uint64_t now, size_t limit, uint64_t& next_deadline) {
+    MidpointNode* mid = midpoints.get(midpoint);
+    return mid ? mid->purge_expired(now, limit, next_deadline, observers.active()) : 0;
+}
+
+bool RadialCircularList::remove(SymbolId midpoint, double value) {
+    MidpointNode* mid = midpoints.get(midpoint);
+    return mid && mid->remove_value(value, observers.active());
+}
+
+bool RadialCircularList::remove(const std::string& midpoint, double value) {
+    return remove(symbols.find(midpoint), value);
+}
+
+size_t RadialCircularList::clear() {
+    CacheObserver* watcher = observers.active();
+    size_t removed = 0;
+    for (SymbolId id = 0, count = static_cast<SymbolId>(symbols.size()); id < count; ++id) {
+        if (MidpointNode* mid = midpoints.get(id)) removed += mid->clear(watcher);
     }
+    return removed;
 }
 
-bool RadialCircularList::insert(double value, const std::string& midpoint, int priority, double expiry_time) {
-    size_t current_nodes = total_nodes.load(std::memory_order_relaxed);
-    if (current_nodes >= max_nodes) return false;
-    size_t index = pool_index.fetch_add(1, std::memory_order_relaxed);
-    if (index >= max_nodes) return false;
+bool RadialCircularList::enable_index(SymbolId midpoint, unsigned kinds) {
+    MidpointNode* mid = create_midpoint(midpoint);
+    return mid && mid->enable_index(kinds);
+}
+
+bool RadialCircularList::enable_index(const std::string& midpoint, unsigned kinds) {
+    return enable_index(symbols.intern(midpoint), kinds);
+}
+
+size_t RadialCircularList::snapshot_shard(SymbolId midpoint, size_t shard, std::vector<Node>& out) {
+    MidpointNode* mid = midpoints.get(midpoint);
+    if (!mid || shard >= mid->shard_count()) return 0;
+    size_t before = out.size();
+    out.reserve(before + (mid->capacity() + mid->shard_count() - 1) / mid->shard_count());
+    mid->visit_shard(shard, [&out](const Node& node) { out.push_back(node); });
+    return out.size() - before;
+}
+
+bool RadialCircularList::insert(double value, SymbolId midpoint, int priority, double expiry_time) {
+    MidpointNode* mid = create_midpoint(midpoint);
+    if (!mid) return false;
+    note_access(mid);
+    Node* node = node_pool.allocate();
+    if (!node) return false;
 
-    Node* node = node_pool[index];
     node->value = value;
     node->priority = priority;
-    node->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-    node->expiry_time_ns = static_cast<uint64_t>(expiry_time * 1'000'000'000);
+    node->symbol = midpoint;
+    node->stamp(expiry_time);
 
-    if (midpoints.get_or_create(midpoint, max_nodes / 10)->add_node(node)) {
-        total_nodes.fetch_add(1, std::memory_order_relaxed);
-        return true;
-    }
+    if (push_node(midpoint, mid, node)) return true;
+    node_pool.release(node);
     return false;
 }
 
+bool RadialCircularList::insert(double value, const std::string& midpoint, int priority, double expiry_time) {
+    return insert(value, symbols.intern(midpoint), priority, expiry_time);
+}
+
+template <typename SymbolOf>
+const uint64_t* RadialCircularList::group_by_symbol(size_t count, SymbolOf&& symbol_of) {
+    thread_local std::vector<uint64_t> keys;  // reused so steady-state batches never allocate
+    keys.resize(count);
+    bool sorted = true;
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = (uint64_t(symbol_of(i)) << 32) | i;
+        sorted = sorted && (i == 0 || keys[i - 1] < keys[i]);
+    }
+    if (!sorted) std::sort(keys.begin(), keys.end());
+    return keys.data();
+}
+
+namespace {
+
+SymbolId symbol_of_key(uint64_t key) { return static_cast<SymbolId>(key >> 32); }
+size_t position_of_key(uint64_t key) { return static_cast<size_t>(key & 0xFFFFFFFFu); }
+
+// End of the run of keys sharing keys[first]'s symbol
+size_t group_end(const uint64_t* keys, size_t first, size_t count) {
+    SymbolId symbol = symbol_of_key(keys[first]);
+    size_t last = first + 1;
+    while (last < count && symbol_of_key(keys[last]) == symbol) ++last;
+    return last;
+}
+
+} // namespace
+
+size_t RadialCircularList::insert_batch(Span<const InsertRecord> batch) {
+    size_t count = batch.size();
+    if (count == 0) return 0;
+    thread_local std::vector<Node*> nodes;
+    nodes.resize(count);
+    size_t taken = node_pool.allocate_bulk(nodes.data(), count);
+    if (taken < count) {
+        for (size_t i = 0; i < taken; ++i) node_pool.release(nodes[i]);
+        return 0;
+    }
+
+    const uint64_t* keys = group_by_symbol(count, [&batch](size_t i) { return batch[i].symbol; });
+    uint64_t now = CoarseClock::now();
+    CacheObserver* watcher = observers.active();
+    size_t inserted = 0;
+    size_t first = 0;
+    size_t last = group_end(keys, 0, count);
+    MidpointNode* mid = create_midpoint(symbol_of_key(keys[0]));
+    while (first < count) {
+        // Resolve and warm the next symbol's heap before queueing this one
+        size_t next_last = last < count ? group_end(keys, last, count) : count;
+        MidpointNode* next_mid = last < count ? create_midpoint(symbol_of_key(keys[last])) : nullptr;
+        if (next_mid) next_mid->prefetch();
+
+        SymbolId symbol = symbol_of_key(keys[first]);
+        Node** group = nodes.data() + first;
+        size_t size = last - first;
+        if (mid) {
+            note_access(mid);
+            uint64_t earliest = UINT64_MAX;
+            for (size_t i = 0; i < size; ++i) {
+                const InsertRecord& record = batch[position_of_key(keys[first + i])];
+                Node& node = *group[i];
+                node.value = record.value;
+                node.priority = record.priority;
+                node.symbol = symbol;
+                node.timestamp_ns = now;
+                node.deadline_ns = now + static_cast<uint64_t>(record.expiry_seconds * 1'000'000'000);
+                if (node.deadline_ns < earliest) earliest = node.deadline_ns;
+                if (watcher) watcher->on_insert(node);
+            }
+            size_t pushed = mid->add_bulk(group, size);
+            inserted += pushed;
+            for (size_t i = pushed; i < size; ++i) {
+                if (watcher) watcher->on_remove(*group[i]);
+                node_pool.release(group[i]);
+            }
+            if (pushed && mid->note_deadline(earliest)) expiry.schedule(symbol, earliest);
+        } else {
+            for (size_t i = 0; i < size; ++i) node_pool.release(group[i]);
+        }
+
+        first = last;
+        last = next_last;
+        mid = next_mid;
+    }
+    return inserted;
+}
+
+bool RadialCircularList::insert_batch(const std::vector<std::tuple<double, SymbolId, int, double>>& batch) {
+    thread_local std::vector<InsertRecord> records;
+    records.clear();
+    for (const auto& [value, midpoint, priority, expiry_time] : batch) {
+        records.push_back(InsertRecord{value, midpoint, priority, expiry_time});
+    }
+    return batch.empty() || insert_batch(Span<const InsertRecord>(records)) > 0;
+}
+
 bool RadialCircularList::insert_batch(const std::vector<std::tuple<double, std::string, int, double>>& batch) {
-    size_t batch_size = batch.size();
-    size_t current_nodes = total_nodes.load(std::memory_order_relaxed);
-    if (current_nodes + batch_size > max_nodes) return false;
-    size_t start_index = pool_index.fetch_add(batch_size, std::memory_order_relaxed);
-    if (start_index + batch_size > max_nodes) return false;
-
-    for (size_t i = 0; i < batch_size; ++i) {
-        const auto& [value, midpoint, priority, expiry_time] = batch[i];
-        Node* node = node_pool[start_index + i];
-        node->value = value;
-        node->priority = priority;
-        node->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-        node->expiry_time_ns = static_cast<uint64_t>(expiry_time * 1'000'000'000);
-        midpoints.get_or_create(midpoint, max_nodes / 10)->add_node(node);
+    thread_local std::vector<InsertRecord> records;
+    records.clear();
+    for (const auto& [value, midpoint, priority, expiry_time] : batch) {
+        records.push_back(InsertRecord{value, symbols.intern(midpoint), priority, expiry_time});
     }
-    total_nodes.fetch_add(batch_size, std::memory_order_relaxed);
-    return true;
+    return batch.empty() || insert_batch(Span<const InsertRecord>(records)) > 0;
 }
 
-Node* RadialCircularList::get_highest_priority(const std::string& midpoint) {
+Node* RadialCircularList::get_highest_priority(SymbolId midpoint) {
     MidpointNode* mid = midpoints.get(midpoint);
-    return mid ? mid->get_highest_priority_node() : nullptr;
+    if (!mid) return nullptr;
+    note_access(mid);
+    CacheObserver* watcher = observers.active();
+    Node* node = mid->get_highest_priority_node(watcher);
+    if (!node) return nullptr;
+    if (watcher) watcher->on_remove(*node);
+    node_pool.retire(node);
+    return node;
+}
+
+Node* RadialCircularList::get_highest_priority(const std::string& midpoint) {
+    SymbolId id = symbols.find(midpoint);
+    return id == INVALID_SYMBOL_ID ? nullptr : get_highest_priority(id);
+}
+
+size_t RadialCircularList::get_highest_priority_batch(Span<const SymbolId> midpoints_batch, Span<Node*> out) {
+    size_t count = midpoints_batch.size();
+    if (count == 0) return 0;
+    const uint64_t* keys = group_by_symbol(count, [&midpoints_batch](size_t i) { return midpoints_batch[i]; });
+    thread_local std::vector<Node*> popped;
+    popped.resize(count);
+    uint64_t now = CoarseClock::now();
+    CacheObserver* watcher = observers.active();
+    size_t found = 0;
+    size_t first = 0;
+    size_t last = group_end(keys, 0, count);
+    MidpointNode* mid = midpoints.get(symbol_of_key(keys[0]));
+    while (first < count) {
+        size_t next_last = last < count ? group_end(keys, last, count) : count;
+        MidpointNode* next_mid = last < count ? midpoints.get(symbol_of_key(keys[last])) : nullptr;
+        if (next_mid) next_mid->prefetch();
+
+        size_t live = 0;
+        if (mid) {
+            note_access(mid);
+            live = mid->get_highest_priority_nodes(popped.data(), last - first, now, watcher);
+        }
+        for (size_t i = 0; i < last - first; ++i) {
+            Node* node = i < live ? popped[i] : nullptr;
+            if (node && watcher) watcher->on_remove(*node);
+            out[position_of_key(keys[first + i])] = node;
+        }
+        node_pool.retire_bulk(popped.data(), live);
+        found += live;
+
+        first = last;
+        last = next_last;
+        mid = next_mid;
+    }
+    return found;
+}
+
+std::vector<Node*> RadialCircularList::get_highest_priority_batch(const std::vector<SymbolId>& midpoints_batch) {
+    std::vector<Node*> results(midpoints_batch.size(), nullptr);
+    get_highest_priority_batch(Span<const SymbolId>(midpoints_batch), Span<Node*>(results));
+    return results;
 }
 
 std::vector<Node*> RadialCircularList::get_highest_priority_batch(const std::vector<std::string>& midpoints_batch) {
+    thread_local std::vector<SymbolId> ids;
+    ids.clear();
+    for (const std::string& midpoint : midpoints_batch) ids.push_back(symbols.find(midpoint));
     std::vector<Node*> results(midpoints_batch.size(), nullptr);
-    for (size_t i = 0; i < midpoints_batch.size(); ++i) {
-        results[i] = get_highest_priority(midpoints_batch[i]);
-    }
+    get_highest_priority_batch(Span<const SymbolId>(ids), Span<Node*>(results));
     return results;
-}
\ No newline at end of file
+}
@@ -0,0 +1,142 @@
+#include "secondary_index.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace {
+
+double value_of(const Node* node) { return node->value; }
+uint64_t time_of(const Node* node) { return node->timestamp_ns; }
+int32_t priority_of(const Node* node) { return node->priority; }
+
+// Ties on the key break on address, so every entry has exactly one slot
+template <typename Key>
+auto ordered_by(Key key) {
+    return [key](const Node* a, const Node* b) {
+        auto ka = key(a), kb = key(b);
+        return ka < kb || (ka == kb && std::less<const Node*>()(a, b));
+    };
+}
+
+}  // namespace
+
+SymbolIndex::SymbolIndex(unsigned kinds, size_t capacity) : kinds_(kinds & ALL) {
+    if (kinds_ & BY_VALUE) by_value_.reserve(capacity);
+    if (kinds_ & BY_TIME) by_time_.reserve(capacity);
+    if (kinds_ & BY_PRIORITY) by_priority_.reserve(capacity);
+}
+
+template <typename Key>
+void SymbolIndex::Order::insert(Node* node, Key key) {
+    auto less = ordered_by(key);
+    // Reclaim the erased front only when the reservation is used up, so
+    // the shift is paid once per capacity inserts
+    if (head && nodes.size() == nodes.capacity()) {
+        nodes.erase(nodes.begin(), nodes.begin() + static_cast<std::ptrdiff_t>(head));
+        head = 0;
+    }
+    // Timestamps mostly arrive in order, so the common case appends
+    if (nodes.size() == head || less(nodes.back(), node)) {
+        nodes.push_back(node);
+        return;
+    }
+    if (head && less(node, nodes[head])) {
+        nodes[--head] = node;
+        return;
+    }
+    nodes.insert(std::lower_bound(nodes.begin() + static_cast<std::ptrdiff_t>(head), nodes.end(), node, less), node);
+}
+
+template <typename Key>
+bool SymbolIndex::Order::erase(const Node* node, Key key) {
+    auto first = nodes.begin() + static_cast<std::ptrdiff_t>(head);
+    auto position = std::lower_bound(first, nodes.end(), node, ordered_by(key));
+    if (position == nodes.end() || *position != node) return false;
+    if (position == first) {
+        // Expiry takes the oldest first; advancing head spares the shift
+        if (++head == nodes.size()) {
+            nodes.clear();
+            head = 0;
+        }
+    } else {
+        nodes.erase(position);
+    }
+    return true;
+}
+
+void SymbolIndex::insert(Node* node) {
+    std::lock_guard<SpinLock> guard(lock_);
+    if (kinds_ & BY_VALUE) by_value_.insert(node, value_of);
+    if (kinds_ & BY_TIME) by_time_.insert(node, time_of);
+    if (kinds_ & BY_PRIORITY) by_priority_.insert(node, priority_of);
+    size_.store(size_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void SymbolIndex::erase(const Node* node) {
+    std::lock_guard<SpinLock> guard(lock_);
+    // Nodes queued before the index existed were never added
+    bool found = false;
+    if (kinds_ & BY_VALUE) found |= by_value_.erase(node, value_of);
+    if (kinds_ & BY_TIME) found |= by_time_.erase(node, time_of);
+    if (kinds_ & BY_PRIORITY) found |= by_priority_.erase(node, priority_of);
+    if (found) size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+template <typename Bounds>
+size_t SymbolIndex::copy_out(const Order& order, std::vector<Node>& out, bool reverse, Bounds&& bounds) const {
+    size_t wanted = 0;
+    while (true) {
+        if (wanted) out.reserve(out.size() + wanted);
+        std::lock_guard<SpinLock> guard(lock_);
+        auto [first, last] = bounds(order.begin(), order.end());
+        wanted = static_cast<size_t>(last - first);
+        if (out.capacity() - out.size() < wanted) continue;
+        if (reverse) {
+            for (auto it = last; it != first;) out.push_back(**--it);
+        } else {
+            for (auto it = first; it != last; ++it) out.push_back(**it);
+        }
+        return wanted;
+    }
+}
+
+size_t SymbolIndex::values_between(double min_value, double max_value, std::vector<Node>& out) const {
+    if (!(kinds_ & BY_VALUE) || !(min_value <= max_value)) return 0;
+    return copy_out(by_value_, out, false, [min_value, max_value](Iterator begin, Iterator end) {
+        auto first = std::partition_point(begin, end,
+                                          [min_value](const Node* n) { return n->value < min_value; });
+        auto last = std::partition_point(first, end,
+                                         [max_value](const Node* n) { return n->value <= max_value; });
+        return std::make_pair(first, last);
+    });
+}
+
+size_t SymbolIndex::created_between(uint64_t start_ns, uint64_t end_ns, std::vector<Node>& out) const {
+    if (!(kinds_ & BY_TIME) || start_ns > end_ns) return 0;
+    return copy_out(by_time_, out, false, [start_ns, end_ns](Iterator begin, Iterator end) {
+        auto first = std::partition_point(begin, end,
+                                          [start_ns](const Node* n) { return n->timestamp_ns < start_ns; });
+        auto last = std::partition_point(first, end,
+                                         [end_ns](const Node* n) { return n->timestamp_ns <= end_ns; });
+        return std::make_pair(first, last);
+    });
+}
+
+size_t SymbolIndex::priorities_between(int min_priority, int max_priority, std::vector<Node>& out) const {
+    if (!(kinds_ & BY_PRIORITY) || min_priority > max_priority) return 0;
+    return copy_out(by_priority_, out, false, [min_priority, max_priority](Iterator begin, Iterator end) {
+        auto first = std::partition_point(begin, end,
+                                          [min_priority](const Node* n) { return n->priority < min_priority; });
+        auto last = std::partition_point(first, end,
+                                         [max_priority](const Node* n) { return n->priority <= max_priority; });
+        return std::make_pair(first, last);
+    });
+}
+
+size_t SymbolIndex::top_priority(size_t n, std::vector<Node>& out) const {
+    if (!(kinds_ & BY_PRIORITY) || n == 0) return 0;
+    return copy_out(by_priority_, out, true, [n](Iterator begin, Iterator end) {
+        size_t held = static_cast<size_t>(end - begin);
+        return std::make_pair(end - static_cast<std::ptrdiff_t>(std::min(n, held)), end);
+    });
+}
@@ -1,159 +1,306 @@
 #include "security_manager.hpp"
+#include "clock.hpp"
+#include "epoch_reclamation.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <chrono>
 #include <thread>
 #include <cstring>
+#include <random>
 
-SecurityManager::SecurityManager(const CacheConfig& config) : config_(config) {
+namespace {
+
+size_t ring_capacity(size_t requested) {
+    size_t capacity = 2;
+    while (capacity < requested) capacity <<= 1;
+    return capacity;
+}
+
+constexpr size_t MAX_AUDIT_LOG_ENTRIES = 10000;
+
+} // namespace
+
+bool TokenBucket::try_take(double ops_per_second, double burst, uint64_t now_ns) {
+    if (ops_per_second <= 0.0) return true;
+
+    if (refilled_ns == 0) {
+        tokens = burst;
+        refilled_ns = now_ns;
+    } else if (now_ns > refilled_ns) {
+        tokens = std::min(burst, tokens + static_cast<double>(now_ns - refilled_ns) * 1e-9 * ops_per_second);
+        refilled_ns = now_ns;
+    }
+
+    if (tokens < 1.0) return false;
+    tokens -= 1.0;
+    return true;
+}
+
+SecurityManager::AuditRing::AuditRing(size_t capacity)
+    : cells_(new Cell[ring_capacity(capacity)]), mask_(ring_capacity(capacity) - 1) {
+    for (size_t i = 0; i <= mask_; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool SecurityManager::AuditRing::try_push(const AuditRecord& record) {
+    uint64_t pos = enqueue_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & mask_];
+        uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // Full: the cell still holds a record from one lap ago
+        } else {
+            pos = enqueue_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->record = record;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool SecurityManager::AuditRing::try_pop(AuditRecord& record) {
+    Cell& cell = cells_[dequeue_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeue_ + 1) return false;
+    record = cell.record;
+    cell.sequence.store(dequeue_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_;
+    return true;
+}
+
+SecurityManager::SecurityManager(const CacheConfig& config)
+    : config_(config), audit_ring_(config.audit_ring_entries) {
     initialize_default_users();
+    audit_flusher_ = std::thread(&SecurityManager::audit_flusher_loop, this);
+}
+
+SecurityManager::~SecurityManager() {
+    {
+        std::lock_guard<std::mutex> lock(flusher_mutex_);
+        stop_flusher_ = true;
+    }
+    flusher_cv_.notify_one();
+    audit_flusher_.join();
+    flush_audit_log();
+
+    // Sessions are gone by now, so the live tokens have no readers
+    for (auto& slot : slots_) delete slot.second->token.load(std::memory_order_relaxed);
 }
 
 bool SecurityManager::authenticate_user(const std::string& username, const std::string& password) {
-    std::lock_guard<std::mutex> lock(users_mutex_);
-    
-    auto it = users_.find(username);
-    if (it == users_.end()) {
-        log_audit_entry(username, "AUTHENTICATION", "User not found", false, "User does not exist");
-        return false;
+    bool authenticated = false;
+    const char* details = "Login successful";
+    const char* error_message = "";
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+
+        auto it = users_.find(username);
+        if (it == users_.end()) {
+            details = "User not found";
+            error_message = "User does not exist";
+        } else if (!it->second.is_active) {
+            details = "User inactive";
+            error_message = "Account disabled";
+        } else if (hash_password(password, it->second.salt) != it->second.password_hash) {
+            details = "Invalid password";
+            error_message = "Password mismatch";
+        } else {
+            it->second.last_login = std::chrono::system_clock::now();
+            authenticated = true;
+        }
     }
-    
-    UserCredentials& user = it->second;
-    if (!user.is_active) {
-        log_audit_entry(username, "AUTHENTICATION", "User inactive", false, "Account disabled");
-        return false;
+
+    log_audit_entry(username, "AUTHENTICATION", details, authenticated, error_message);
+    return authenticated;
+}
+
+SecuritySession SecurityManager::open_session(const std::string& username, const std::string& password) {
+    SecuritySession session;
+    if (!authenticate_user(username, password)) return session;
+
+    std::lock_guard<std::mutex> lock(users_mutex_);
+    auto it = slots_.find(username);
+    if (it != slots_.end()) {
+        session.slot_ = &it->second->token;
+        session.username_ = username;
     }
-    
-    std::string hashed_password = hash_password(password, user.salt);
-    if (hashed_password != user.password_hash) {
-        log_audit_entry(username, "AUTHENTICATION", "Invalid password", false, "Password mismatch");
-        return false;
+    return session;
+}
+
+bool SecurityManager::authorize(SecuritySession& session, OperationType operation) {
+    if (!session.slot_) return false;
+
+    EpochGuard guard;
+    return check_token(session.slot_->load(std::memory_order_acquire), session.username_, operation, nullptr);
+}
+
+bool SecurityManager::authorize(SecuritySession& session, OperationType operation, SymbolId symbol) {
+    if (!session.slot_) return false;
+
+    EpochGuard guard;
+    return check_token(session.slot_->load(std::memory_order_acquire), session.username_, operation, &symbol);
+}
+
+bool SecurityManager::allow(SecuritySession& session, OperationType operation) {
+    if (!session.slot_) return false;
+
+    bool allowed;
+    {
+        EpochGuard guard;
+        const CapabilityToken* token = session.slot_->load(std::memory_order_acquire);
+        allowed = session.bucket_.try_take(token->ops_per_second, token->burst, CoarseClock::now());
     }
-    
-    user.last_login = std::chrono::system_clock::now();
-    log_audit_entry(username, "AUTHENTICATION", "Login successful", true, "");
-    return true;
+    if (!allowed) queue_audit(session.username_, operation, INVALID_SYMBOL_ID, AuditReason::RATE_LIMIT);
+    return allowed;
+}
+
+const CapabilityToken* SecurityManager::current_token(const SecuritySession& session) const {
+    return session.slot_ ? session.slot_->load(std::memory_order_acquire) : nullptr;
 }
 
-bool SecurityManager::authorize_operation(const std::string& username, OperationType operation, 
+bool SecurityManager::authorize_operation(const std::string& username, OperationType operation,
                                        const std::string& symbol) {
-    std::lock_guard<std::mutex> lock(users_mutex_);
-    
-    auto it = users_.find(username);
-    if (it == users_.end()) {
-        return false;
+    const TokenSlot* slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+        auto it = slots_.find(username);
+        if (it != slots_.end()) slot = it->second.get();
     }
-    
-    UserCredentials& user = it->second;
-    if (!user.is_active) {
+    if (!slot) {
+        queue_audit(username, operation, INVALID_SYMBOL_ID, AuditReason::UNKNOWN_USER);
         return false;
     }
-    
-    // Check permission level
-    if (!has_permission(user.permission_level, operation)) {
-        log_audit_entry(username, "AUTHORIZATION", "Insufficient permissions", false, 
-                      "Operation not allowed for permission level");
-        return false;
-    }
-    
-    // Check symbol-specific permissions
-    if (!symbol.empty() && !user.allowed_symbols.empty()) {
-        if (std::find(user.allowed_symbols.begin(), user.allowed_symbols.end(), symbol) 
-            == user.allowed_symbols.end()) {
-            log_audit_entry(username, "AUTHORIZATION", "Symbol access denied", false, 
-                          "Symbol not in allowed list");
-            return false;
-        }
-    }
-    
-    return true;
+
+    // Allowed symbols are interned when the token is built, so one that
+    // was never interned finds INVALID_SYMBOL_ID, which is in no user's list
+    SymbolId symbol_id = symbol.empty() ? INVALID_SYMBOL_ID : SymbolRegistry::global().find(symbol);
+    EpochGuard guard;
+    return check_token(slot->token.load(std::memory_order_acquire), username, operation,
+                       symbol.empty() ? nullptr : &symbol_id);
 }
 
 bool SecurityManager::allow_operation(const std::string& client_id, OperationType operation) {
     std::string rate_limit_key = client_id + "_" + std::to_string(static_cast<int>(operation));
-    
-    std::lock_guard<std::mutex> lock(rate_limit_mutex_);
-    
-    auto& rate_limiter = rate_limiters_[rate_limit_key];
-    uint64_t current_count = rate_limiter.load();
-    
-    if (current_count >= default_rate_limit_.max_requests_per_second) {
-        log_audit_entry(client_id, "RATE_LIMIT", "Rate limit exceeded", false, 
-                      "Too many requests per second");
-        return false;
+
+    bool allowed;
+    {
+        std::lock_guard<std::mutex> lock(rate_limit_mutex_);
+
+        auto limit = client_rate_limits_.find(client_id);
+        double ops_per_second = static_cast<double>(
+            limit != client_rate_limits_.end() ? limit->second : default_rate_limit_.max_requests_per_second);
+        allowed = rate_limiters_[rate_limit_key].try_take(ops_per_second, ops_per_second, CoarseClock::now());
     }
-    
-    rate_limiter.fetch_add(1);
-    return true;
+
+    if (!allowed) queue_audit(client_id, operation, INVALID_SYMBOL_ID, AuditReason::RATE_LIMIT);
+    return allowed;
 }
 
 void SecurityManager::set_rate_limit(const std::string& client_id, uint64_t ops_per_second) {
-    std::lock_guard<std::mutex> lock(rate_limit_mutex_);
-    // Implementation would update rate limits for specific clients
-    // This is a placeholder for the actual implementation
+    {
+        std::lock_guard<std::mutex> lock(rate_limit_mutex_);
+        if (ops_per_second == 0) {
+            client_rate_limits_.erase(client_id);
+        } else {
+            client_rate_limits_[client_id] = ops_per_second;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(users_mutex_);
+    auto it = users_.find(client_id);
+    if (it != users_.end()) {
+        it->second.ops_per_second = ops_per_second;
+        publish_token(it->second);
+    }
 }
 
-bool SecurityManager::create_user(const std::string& username, const std::string& password, 
+bool SecurityManager::create_user(const std::string& username, const std::string& password,
                                 PermissionLevel permission_level) {
-    std::lock_guard<std::mutex> lock(users_mutex_);
-    
-    if (users_.find(username) != users_.end()) {
-        return false;  // User already exists
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+
+        if (users_.find(username) != users_.end()) {
+            return false;  // User already exists
+        }
+
+        std::string salt = generate_salt();
+        std::string password_hash = hash_password(password, salt);
+
+        UserCredentials user;
+        user.username = username;
+        user.password_hash = password_hash;
+        user.salt = salt;
+        user.permission_level = permission_level;
+        user.created_at = std::chrono::system_clock::now();
+        user.is_active = true;
+
+        publish_token(users_[username] = user);
     }
-    
-    std::string salt = generate_salt();
-    std::string password_hash = hash_password(password, salt);
-    
-    UserCredentials user;
-    user.username = username;
-    user.password_hash = password_hash;
-    user.salt = salt;
-    user.permission_level = permission_level;
-    user.created_at = std::chrono::system_clock::now();
-    user.is_active = true;
-    
-    users_[username] = user;
-    
-    log_audit_entry("SYSTEM", "USER_CREATION", "User created", true, 
+
+    log_audit_entry("SYSTEM", "USER_CREATION", "User created", true,
                    "Created user: " + username);
     return true;
 }
 
 bool SecurityManager::update_user_permissions(const std::string& username, PermissionLevel new_level) {
-    std::lock_guard<std::mutex> lock(users_mutex_);
-    
-    auto it = users_.find(username);
-    if (it == users_.end()) {
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+
+        auto it = users_.find(username);
+        if (it == users_.end()) {
+            return false;
+        }
+
+        it->second.permission_level = new_level;
+        publish_token(it->second);
     }
-    
-    it->second.permission_level = new_level;
-    
-    log_audit_entry("SYSTEM", "PERMISSION_UPDATE", "Permissions updated", true, 
+
+    log_audit_entry("SYSTEM", "PERMISSION_UPDATE", "Permissions updated", true,
                    "Updated permissions for: " + username);
     return true;
 }
 
 bool SecurityManager::deactivate_user(const std::string& username) {
-    std::lock_guard<std::mutex> lock(users_mutex_);
-    
-    auto it = users_.find(username);
-    if (it == users_.end()) {
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+
+        auto it = users_.find(username);
+        if (it == users_.end()) {
+            return false;
+        }
+
+        it->second.is_active = false;
+        publish_token(it->second);
     }
-    
-    it->second.is_active = false;
-    
-    log_audit_entry("SYSTEM", "USER_DEACTIVATION", "User deactivated", true, 
+
+    log_audit_entry("SYSTEM", "USER_DEACTIVATION", "User deactivated", true,
                    "Deactivated user: " + username);
     return true;
 }
 
-void SecurityManager::log_audit_entry(const std::string& username, const std::string& operation, 
+bool SecurityManager::set_allowed_symbols(const std::string& username, const std::vector<std::string>& symbols) {
+    {
+        std::lock_guard<std::mutex> lock(users_mutex_);
+
+        auto it = users_.find(username);
+        if (it == users_.end()) {
+            return false;
+        }
+
+        it->second.allowed_symbols = symbols;
+        publish_token(it->second);
+    }
+
+    log_audit_entry("SYSTEM", "PERMISSION_UPDATE", "Allowed symbols updated", true,
+                   "Updated allowed symbols for: " + username);
+    return true;
+}
+
+void SecurityManager::log_audit_entry(const std::string& username, const std::string& operation,
                                     const std::string& details, bool success, const std::string& error_message) {
-    std::lock_guard<std::mutex> lock(audit_mutex_);
-    
     AuditLogEntry entry;
     entry.username = username;
     entry.operation = operation;
@@ -161,19 +308,17 @@ void SecurityManager::log_audit_entry(const std::string& username, const std::st
     entry.timestamp = std::chrono::system_clock::now();
     entry.success = success;
     entry.error_message = error_message;
-    
-    audit_log_.push_back(entry);
-    
-    // Maintain audit log size
-    if (audit_log_.size() > 10000) {
-        audit_log_.erase(audit_log_.begin());
-    }
+
+    std::lock_guard<std::mutex> lock(audit_mutex_);
+    // Queued records are older than this one
+    drain_audit_ring();
+    append_audit_entry(std::move(entry));
 }
 
-std::vector<AuditLogEntry> SecurityManager::get_audit_log(const std::string& username, 
+std::vector<AuditLogEntry> SecurityManager::get_audit_log(const std::string& username,
                                                         size_t limit) const {
     std::lock_guard<std::mutex> lock(audit_mutex_);
-    
+
     std::vector<AuditLogEntry> filtered_log;
     for (const auto& entry : audit_log_) {
         if (username.empty() || entry.username == username) {
@@ -181,10 +326,15 @@ std::vector<AuditLogEntry> SecurityManager::get_audit_log(const std::string& use
             if (filtered_log.size() >= limit) break;
         }
     }
-    
+
     return filtered_log;
 }
 
+void SecurityManager::flush_audit_log() {
+    std::lock_guard<std::mutex> lock(audit_mutex_);
+    drain_audit_ring();
+}
+
 void SecurityManager::enable_encryption(const std::string& key) {
     encryption_key_ = key;
     encryption_enabled_ = true;
@@ -199,7 +349,7 @@ std::string SecurityManager::encrypt_data(const std::string& data) {
     if (!encryption_enabled_) {
         return data;
     }
-    
+
     // Implementation would use encryption_key_ to encrypt data
     // This is a placeholder for the actual encryption implementation
     return data;
@@ -209,7 +359,7 @@ std::string SecurityManager::decrypt_data(const std::string& encrypted_data) {
     if (!encryption_enabled_) {
         return encrypted_data;
     }
-    
+
     // Implementation would use encryption_key_ to decrypt data
     // This is a placeholder for the actual decryption implementation
     return encrypted_data;
@@ -217,7 +367,7 @@ std::string SecurityManager::decrypt_data(const std::string& encrypted_data) {
 
 bool SecurityManager::validate_input(const std::string& input) {
     // Check for SQL injection, XSS, etc.
-    if (input.find("'") != std::string::npos || 
+    if (input.find("'") != std::string::npos ||
         input.find(";") != std::string::npos ||
         input.find("<script>") != std::string::npos) {
         return false;
@@ -229,13 +379,13 @@ bool SecurityManager::is_suspicious_activity(const std::string& username) {
     // Check for unusual patterns
     auto recent_logs = get_audit_log(username, 100);
     int failed_attempts = 0;
-    
+
     for (const auto& entry : recent_logs) {
         if (!entry.success && entry.operation == "AUTHENTICATION") {
             failed_attempts++;
         }
     }
-    
+
     return failed_attempts > 5;  // More than 5 failed attempts
 }
 
@@ -243,7 +393,7 @@ bool SecurityManager::is_suspicious_activity(const std::string& username) {
 void SecurityManager::initialize_default_users() {
     // Create default admin user
     create_user("admin", "admin123", PermissionLevel::SUPER_ADMIN);
-    
+
     // Create default read-only user
     create_user("reader", "reader123", PermissionLevel::READ_ONLY);
 }
@@ -270,13 +420,13 @@ std::string SecurityManager::generate_salt() {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(0, 255);
-    
+
     std::string salt;
     salt.reserve(16);
     for (int i = 0; i < 16; ++i) {
         salt += static_cast<char>(dis(gen));
     }
-    
+
     return salt;
 }
 
@@ -284,4 +434,122 @@ std::string SecurityManager::hash_password(const std::string& password, const st
     // Implementation would use proper cryptographic hashing
     // This is a placeholder - in production, use bcrypt, Argon2, or similar
     return password + salt;  // Simplified for demonstration
-} 
\ No newline at end of file
+}
+
+void SecurityManager::publish_token(const UserCredentials& user) {
+    auto token = std::make_unique<CapabilityToken>();
+    token->username = user.username;
+    token->active = user.is_active;
+    if (user.is_active) {
+        for (unsigned op = 0; op <= static_cast<unsigned>(OperationType::CONFIG_ACCESS); ++op) {
+            if (has_permission(user.permission_level, static_cast<OperationType>(op)))
+                token->operations |= operation_bit(static_cast<OperationType>(op));
+        }
+    }
+
+    token->all_symbols = user.allowed_symbols.empty();
+    for (const std::string& name : user.allowed_symbols) {
+        SymbolId id = SymbolRegistry::global().intern(name);
+        if ((id >> 6) >= token->symbols.size()) token->symbols.resize((id >> 6) + 1, 0);
+        token->symbols[id >> 6] |= uint64_t(1) << (id & 63);
+    }
+
+    uint64_t rate = user.ops_per_second ? user.ops_per_second : default_rate_limit_.max_requests_per_second;
+    token->ops_per_second = static_cast<double>(rate);
+    token->burst = static_cast<double>(rate);  // One second's worth
+
+    std::unique_ptr<TokenSlot>& slot = slots_[user.username];
+    if (!slot) slot = std::make_unique<TokenSlot>();
+    const CapabilityToken* old = slot->token.load(std::memory_order_relaxed);
+    token->version = old ? old->version + 1 : 1;
+    slot->token.store(token.release(), std::memory_order_release);
+    if (old) EpochManager::global().retire(const_cast<CapabilityToken*>(old));
+}
+
+bool SecurityManager::check_token(const CapabilityToken* token, const std::string& username,
+                                  OperationType operation, const SymbolId* symbol) {
+    AuditReason reason;
+    if (!token->active) {
+        reason = AuditReason::INACTIVE;
+    } else if (!token->allows(operation)) {
+        reason = AuditReason::PERMISSION;
+    } else if (symbol && !token->allows_symbol(*symbol)) {
+        reason = AuditReason::SYMBOL;
+    } else {
+        return true;
+    }
+
+    queue_audit(username, operation, symbol ? *symbol : INVALID_SYMBOL_ID, reason);
+    return false;
+}
+
+void SecurityManager::queue_audit(const std::string& username, OperationType operation, SymbolId symbol,
+                                  AuditReason reason) {
+    AuditRecord record;
+    record.timestamp = std::chrono::system_clock::now();
+    record.username_length = static_cast<uint8_t>(std::min(username.size(), sizeof(record.username)));
+    std::memcpy(record.username, username.data(), record.username_length);
+    record.operation = operation;
+    record.reason = reason;
+    record.symbol = symbol;
+
+    if (!audit_ring_.try_push(record)) audit_dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SecurityManager::drain_audit_ring() {
+    AuditRecord record;
+    while (audit_ring_.try_pop(record)) {
+        AuditLogEntry entry;
+        entry.username.assign(record.username, record.username_length);
+        entry.operation = record.reason == AuditReason::RATE_LIMIT ? "RATE_LIMIT" : "AUTHORIZATION";
+        entry.timestamp = record.timestamp;
+        entry.success = false;
+
+        switch (record.reason) {
+            case AuditReason::UNKNOWN_USER:
+                entry.details = "User not found";
+                entry.error_message = "User does not exist";
+                break;
+            case AuditReason::INACTIVE:
+                entry.details = "User inactive";
+                entry.error_message = "Account disabled";
+                break;
+            case AuditReason::PERMISSION:
+                entry.details = "Insufficient permissions";
+                entry.error_message = "Operation not allowed for permission level";
+                break;
+            case AuditReason::SYMBOL:
+                entry.details = "Symbol access denied";
+                entry.error_message = "Symbol not in allowed list";
+                if (record.symbol != INVALID_SYMBOL_ID)
+                    entry.error_message += ": " + SymbolRegistry::global().name(record.symbol);
+                break;
+            case AuditReason::RATE_LIMIT:
+                entry.details = "Rate limit exceeded";
+                entry.error_message = "Too many requests per second";
+                break;
+        }
+        append_audit_entry(std::move(entry));
+    }
+}
+
+void SecurityManager::append_audit_entry(AuditLogEntry entry) {
+    audit_log_.push_back(std::move(entry));
+
+    // Maintain audit log size
+    if (audit_log_.size() > MAX_AUDIT_LOG_ENTRIES) {
+        audit_log_.pop_front();
+    }
+}
+
+void SecurityManager::audit_flusher_loop() {
+    const auto interval = std::chrono::milliseconds(std::max<size_t>(1, config_.audit_flush_interval_ms));
+
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    while (!stop_flusher_) {
+        flusher_cv_.wait_for(lock, interval, [this] { return stop_flusher_; });
+        lock.unlock();
+        flush_audit_log();
+        lock.lock();
+    }
+}
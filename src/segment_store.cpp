@@ -0,0 +1,253 @@
+#include "segment_store.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace hft_cache {
+
+namespace {
+
+constexpr uint32_t RECORD_MAGIC = 0x4C33524B;  // "L3RK"
+constexpr size_t PAGE_BYTES = 4096;
+
+uint32_t checksum(const uint8_t* data, size_t length, uint32_t seed) {
+    // FNV-1a; only has to catch torn and unwritten tails, not tampering
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct Header {
+    uint32_t magic;
+    uint16_t kind;
+    uint16_t reserved;
+    uint32_t length;
+    uint32_t checksum;
+};
+static_assert(sizeof(Header) == SegmentStore::HEADER_BYTES, "record header layout");
+
+} // namespace
+
+SegmentStore::SegmentStore(const std::string& directory, size_t segment_bytes)
+    : directory_(directory), segment_bytes_(std::max<size_t>((segment_bytes + PAGE_BYTES - 1) & ~(PAGE_BYTES - 1), PAGE_BYTES)) {
+    std::filesystem::create_directories(directory_);
+}
+
+SegmentStore::~SegmentStore() {
+    flush(true);
+    for (auto& entry : segments_) close_segment(*entry.second);
+}
+
+std::string SegmentStore::path_for(uint32_t id) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment-%08u.l3", id);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+SegmentStore::Segment* SegmentStore::open_segment(uint32_t id, bool create) {
+    std::string path = path_for(id);
+    int fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0) return nullptr;
+
+    size_t capacity = segment_bytes_;
+    if (create) {
+        // Sparse until written, so a fresh segment costs no disk up front
+        if (::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            ::close(fd);
+            return nullptr;
+        }
+    } else {
+        off_t size = ::lseek(fd, 0, SEEK_END);
+        if (size <= 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        capacity = static_cast<size_t>(size);
+    }
+
+    void* base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    ::madvise(base, capacity, MADV_RANDOM);
+
+    auto segment = std::make_unique<Segment>();
+    segment->id = id;
+    segment->fd = fd;
+    segment->base = static_cast<uint8_t*>(base);
+    segment->capacity = capacity;
+    Segment* raw = segment.get();
+    segments_[id] = std::move(segment);
+    next_id_ = std::max(next_id_, id + 1);
+    return raw;
+}
+
+void SegmentStore::close_segment(Segment& segment) {
+    if (segment.base) ::munmap(segment.base, segment.capacity);
+    if (segment.fd >= 0) ::close(segment.fd);
+    segment.base = nullptr;
+    segment.fd = -1;
+}
+
+SegmentStore::Segment* SegmentStore::find(uint32_t id) const {
+    auto it = segments_.find(id);
+    return it == segments_.end() ? nullptr : it->second.get();
+}
+
+bool SegmentStore::read_header(const Segment& segment, size_t offset, uint16_t& kind, uint32_t& length) const {
+    if (offset + HEADER_BYTES > segment.capacity) return false;
+    Header header;
+    std::memcpy(&header, segment.base + offset, sizeof(header));
+    if (header.magic != RECORD_MAGIC) return false;
+    if (offset + record_bytes(header.length) > segment.capacity) return false;
+    if (header.checksum != checksum(segment.base + offset + HEADER_BYTES, header.length, header.kind)) return false;
+    kind = header.kind;
+    length = header.length;
+    return true;
+}
+
+size_t SegmentStore::recover_offset(const Segment& segment) const {
+    size_t offset = 0;
+    uint16_t kind;
+    uint32_t length;
+    while (read_header(segment, offset, kind, length)) offset += record_bytes(length);
+    return offset;
+}
+
+SegmentStore::Location SegmentStore::append(uint16_t kind, const void* payload, uint32_t length) {
+    size_t bytes = record_bytes(length);
+    if (bytes > segment_bytes_) return INVALID_LOCATION;
+    if (!active_ || active_->write_offset + bytes > active_->capacity) {
+        // Seal the full segment; its dirty tail goes out with the next flush
+        active_ = open_segment(next_id_, true);
+        if (!active_) return INVALID_LOCATION;
+    }
+
+    Segment& segment = *active_;
+    size_t offset = segment.write_offset;
+    uint8_t* record = segment.base + offset;
+    std::memcpy(record + HEADER_BYTES, payload, length);
+    std::memset(record + HEADER_BYTES + length, 0, bytes - HEADER_BYTES - length);
+    Header header{RECORD_MAGIC, kind, 0, length, checksum(record + HEADER_BYTES, length, kind)};
+    std::memcpy(record, &header, sizeof(header));
+
+    segment.write_offset += bytes;
+    segment.live_bytes += bytes;
+    return make_location(segment.id, offset);
+}
+
+const uint8_t* SegmentStore::payload(Location location, uint32_t* length, uint16_t* kind) const {
+    const Segment* segment = find(segment_of(location));
+    if (!segment) return nullptr;
+    size_t offset = offset_of(location);
+    if (offset + HEADER_BYTES > segment->write_offset) return nullptr;
+    Header header;
+    std::memcpy(&header, segment->base + offset, sizeof(header));
+    if (length) *length = header.length;
+    if (kind) *kind = header.kind;
+    return segment->base + offset + HEADER_BYTES;
+}
+
+void SegmentStore::release(Location location, uint32_t parts) {
+    Segment* segment = find(segment_of(location));
+    if (!segment || parts == 0) return;
+    Header header;
+    std::memcpy(&header, segment->base + offset_of(location), sizeof(header));
+    segment->live_bytes -= std::min(segment->live_bytes, record_bytes(header.length) / parts);
+}
+
+void SegmentStore::prefetch(Location location) const {
+    const Segment* segment = find(segment_of(location));
+    if (!segment) return;
+    size_t offset = offset_of(location) & ~(PAGE_BYTES - 1);
+    ::madvise(segment->base + offset, PAGE_BYTES, MADV_WILLNEED);
+}
+
+uint32_t SegmentStore::compaction_candidate(double threshold) const {
+    for (const auto& entry : segments_) {
+        const Segment& segment = *entry.second;
+        if (&segment == active_ || segment.write_offset == 0) continue;
+        if (static_cast<double>(segment.live_bytes) < threshold * static_cast<double>(segment.write_offset)) {
+            return segment.id;
+        }
+    }
+    return 0;
+}
+
+bool SegmentStore::has_segment_before(uint32_t id) const {
+    return !segments_.empty() && segments_.begin()->first < id;
+}
+
+void SegmentStore::drop_segment(uint32_t id) {
+    auto it = segments_.find(id);
+    if (it == segments_.end()) return;
+    if (it->second.get() == active_) active_ = nullptr;
+    close_segment(*it->second);
+    std::filesystem::remove(path_for(id));
+    segments_.erase(it);
+}
+
+void SegmentStore::open_existing() {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, error)) {
+        unsigned id = 0;
+        std::string name = entry.path().filename().string();
+        if (std::sscanf(name.c_str(), "segment-%08u.l3", &id) != 1 || id == 0 || find(id)) continue;
+        Segment* segment = open_segment(id, false);
+        if (!segment) continue;
+        ::madvise(segment->base, segment->capacity, MADV_SEQUENTIAL);
+        segment->write_offset = recover_offset(*segment);
+        segment->flushed_offset = segment->write_offset;
+        segment->live_bytes = segment->write_offset;
+        ::madvise(segment->base, segment->capacity, MADV_RANDOM);
+    }
+    // Appends resume in a fresh segment rather than after a possibly torn tail
+    active_ = nullptr;
+}
+
+bool SegmentStore::flush(bool synchronous) {
+    bool ok = true;
+    for (auto& entry : segments_) {
+        Segment& segment = *entry.second;
+        if (segment.flushed_offset == segment.write_offset) continue;
+        size_t begin = segment.flushed_offset & ~(PAGE_BYTES - 1);
+        size_t end = segment.write_offset;
+        if (::msync(segment.base + begin, end - begin, synchronous ? MS_SYNC : MS_ASYNC) != 0) {
+            ok = false;
+            continue;
+        }
+        segment.flushed_offset = segment.write_offset;
+    }
+    return ok;
+}
+
+void SegmentStore::clear() {
+    for (auto& entry : segments_) {
+        close_segment(*entry.second);
+        std::filesystem::remove(path_for(entry.first));
+    }
+    segments_.clear();
+    active_ = nullptr;
+}
+
+size_t SegmentStore::bytes_on_disk() const {
+    size_t total = 0;
+    for (const auto& entry : segments_) total += entry.second->write_offset;
+    return total;
+}
+
+size_t SegmentStore::live_bytes() const {
+    size_t total = 0;
+    for (const auto& entry : segments_) total += entry.second->live_bytes;
+    return total;
+}
+
+} // namespace hft_cache
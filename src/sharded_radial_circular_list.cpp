@@ -0,0 +1,121 @@
+#include "sharded_radial_circular_list.hpp"
+#include <algorithm>
+#include <new>
+#include <thread>
+
+void ShardedRadialCircularList::SymbolHeap::publish() {
+    static const Node empty;
+    top.store(heap.empty() ? empty : *heap.top());
+}
+
+void ShardedRadialCircularList::Shard::touch() {
+    home_node = NumaTopology::current_node();
+    free_slots.reset(new uint32_t[pool_capacity]);
+    for (size_t i = 0; i < pool_capacity; ++i) {
+        new (&pool[i]) Node();
+        free_slots[i] = static_cast<uint32_t>(pool_capacity - 1 - i);
+    }
+    free_count = pool_capacity;
+}
+
+ShardedRadialCircularList::ShardedRadialCircularList(const CacheConfig& config)
+    : symbols(SymbolRegistry::global()), heap_capacity(std::max<size_t>(1, config.max_nodes / 10)) {
+    size_t count = config.list_shards;
+    if (count == 0) count = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    size_t per_shard = std::max<size_t>(1, config.max_nodes / count);
+    shards.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards.push_back(std::make_unique<Shard>(per_shard));
+    }
+}
+
+bool ShardedRadialCircularList::warm(SymbolId symbol) {
+    if (symbol == INVALID_SYMBOL_ID) return false;
+    Shard& shard = *shards[shard_of(symbol)];
+    shard.note_access();
+    return shard.heaps.get_or_create(symbol / shards.size(), heap_capacity) != nullptr;
+}
+
+bool ShardedRadialCircularList::insert(double value, SymbolId symbol, int priority, double expiry_time) {
+    if (symbol == INVALID_SYMBOL_ID) return false;
+    Shard& shard = *shards[shard_of(symbol)];
+    shard.note_access();
+    SymbolHeap* heap = shard.heaps.get_or_create(symbol / shards.size(), heap_capacity);
+    if (!heap) return false;
+    Node* node = shard.allocate();
+    if (!node) return false;
+
+    node->value = value;
+    node->priority = priority;
+    node->symbol = symbol;
+    node->stamp(expiry_time);
+    if (!heap->heap.push(node)) {
+        shard.release(node);
+        return false;
+    }
+
+    shard.live.store(shard.live.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Readers only see the top, so a node that lands below it changes nothing
+    if (heap->heap.top() == node) heap->publish();
+    return true;
+}
+
+bool ShardedRadialCircularList::insert(double value, const std::string& symbol, int priority, double expiry_time) {
+    return insert(value, symbols.intern(symbol), priority, expiry_time);
+}
+
+Node* ShardedRadialCircularList::get_highest_priority(SymbolId symbol) {
+    if (symbol == INVALID_SYMBOL_ID) return nullptr;
+    SymbolHeap* heap = find_heap(symbol);
+    if (!heap) return nullptr;
+    Shard& shard = *shards[shard_of(symbol)];
+    shard.note_access();
+
+    if (heap->heap.empty()) return nullptr;
+    Node* result = nullptr;
+    uint64_t now = CoarseClock::now();
+    while (Node* node = heap->heap.pop()) {
+        shard.live.store(shard.live.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        if (!node->is_expired(now)) {
+            result = node;
+            break;
+        }
+        shard.release(node);
+    }
+    heap->publish();
+    return result;
+}
+
+Node* ShardedRadialCircularList::get_highest_priority(const std::string& symbol) {
+    return get_highest_priority(symbols.find(symbol));
+}
+
+bool ShardedRadialCircularList::peek_highest_priority(SymbolId symbol, Node& out) const {
+    if (symbol == INVALID_SYMBOL_ID) return false;
+    const SymbolHeap* heap = find_heap(symbol);
+    if (!heap) return false;
+    out = heap->top.load();
+    return out.symbol != INVALID_SYMBOL_ID && !out.is_expired();
+}
+
+bool ShardedRadialCircularList::peek_highest_priority(const std::string& symbol, Node& out) const {
+    return peek_highest_priority(symbols.find(symbol), out);
+}
+
+void ShardedRadialCircularList::release(Node* node) {
+    if (!node || node->symbol == INVALID_SYMBOL_ID) return;
+    Shard& shard = *shards[shard_of(node->symbol)];
+    if (shard.owns(node)) shard.release(node);
+}
+
+size_t ShardedRadialCircularList::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) total += shard->live.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t ShardedRadialCircularList::cross_numa_accesses() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards) total += shard->cross_numa.load(std::memory_order_relaxed);
+    return total;
+}
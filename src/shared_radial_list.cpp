@@ -0,0 +1,388 @@
+#include "shared_radial_list.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t SEGMENT_MAGIC = 0x314C52414853ull;  // "SHARL1"
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr uint32_t NIL = UINT32_MAX;
+
+// The best queued node as peek sees it
+struct TopEntry {
+    Node node;
+    uint64_t present;
+};
+
+size_t align_up(size_t bytes) { return (bytes + 63) & ~size_t(63); }
+
+uint32_t hash_name(const char* name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<uint8_t>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint64_t pack(uint64_t tag, uint32_t index) { return (tag << 32) | index; }
+
+} // namespace
+
+struct SharedRadialList::Header {
+    std::atomic<uint64_t> magic;  // stored last by the creator
+    uint32_t version;
+    uint32_t node_bytes;
+    uint32_t slot_bytes;
+    uint32_t node_capacity;
+    uint32_t max_symbols;
+    uint32_t table_size;  // power of two, at least twice max_symbols; entries are id + 1
+    uint32_t heap_capacity;
+    uint64_t bytes;
+    uint64_t index_offset;
+    uint64_t symbols_offset;
+    uint64_t heaps_offset;
+    uint64_t nodes_offset;
+    uint64_t links_offset;
+    alignas(64) std::atomic<uint64_t> free_head;  // tag << 32 | slot
+    std::atomic<uint32_t> free_count;
+    alignas(64) std::atomic<uint32_t> symbol_count;
+};
+
+struct alignas(64) SharedRadialList::SymbolSlot {
+    char name[MAX_NAME + 1];
+    SpinLock lock;
+    std::atomic<uint32_t> size;
+    SeqLock<TopEntry> top;
+};
+
+SharedRadialList::SharedRadialList(const std::string& name, const CacheConfig& config, size_t max_symbols,
+                                   size_t heap_capacity)
+    : name_(name), writer_(true) {
+    uint32_t node_capacity = static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(config.max_nodes, 1), NIL - 1));
+    uint32_t symbols = static_cast<uint32_t>(std::clamp<size_t>(max_symbols, 1, 1u << 20));
+    uint32_t per_symbol = static_cast<uint32_t>(
+        std::min<size_t>(std::max<size_t>(heap_capacity ? heap_capacity : config.max_nodes / 10, 1), node_capacity));
+    uint32_t table_size = 2;
+    while (table_size < 2 * symbols) table_size <<= 1;
+
+    size_t index_offset = align_up(sizeof(Header));
+    size_t symbols_offset = align_up(index_offset + table_size * sizeof(std::atomic<uint32_t>));
+    size_t heaps_offset = align_up(symbols_offset + symbols * sizeof(SymbolSlot));
+    size_t nodes_offset = align_up(heaps_offset + size_t(symbols) * per_symbol * sizeof(HeapEntry));
+    size_t links_offset = align_up(nodes_offset + size_t(node_capacity) * sizeof(Node));
+    size_t bytes = align_up(links_offset + size_t(node_capacity) * sizeof(std::atomic<uint32_t>));
+
+    ::shm_unlink(name_.c_str());
+    int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return;
+    bool mapped = ::ftruncate(fd, static_cast<off_t>(bytes)) == 0 && map(fd, bytes);
+    ::close(fd);
+    if (!mapped) {
+        ::shm_unlink(name_.c_str());
+        return;
+    }
+
+    // Everything is built in place before magic goes in, which is what
+    // attaching readers check
+    Header* header = new (mapping_) Header;
+    header->version = SEGMENT_VERSION;
+    header->node_bytes = sizeof(Node);
+    header->slot_bytes = sizeof(SymbolSlot);
+    header->node_capacity = node_capacity;
+    header->max_symbols = symbols;
+    header->table_size = table_size;
+    header->heap_capacity = per_symbol;
+    header->bytes = bytes;
+    header->index_offset = index_offset;
+    header->symbols_offset = symbols_offset;
+    header->heaps_offset = heaps_offset;
+    header->nodes_offset = nodes_offset;
+    header->links_offset = links_offset;
+    header->free_head.store(pack(0, 0), std::memory_order_relaxed);
+    header->free_count.store(node_capacity, std::memory_order_relaxed);
+    header->symbol_count.store(0, std::memory_order_relaxed);
+    header_ = header;
+    locate();
+
+    for (uint32_t i = 0; i < table_size; ++i) new (&index_[i]) std::atomic<uint32_t>(0);
+    for (uint32_t i = 0; i < symbols; ++i) new (&symbols_[i]) SymbolSlot();
+    for (uint32_t i = 0; i < node_capacity; ++i) {
+        new (&links_[i]) std::atomic<uint32_t>(i + 1 < node_capacity ? i + 1 : NIL);
+    }
+
+    header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+}
+
+SharedRadialList::SharedRadialList(const std::string& name) : name_(name) {
+    int fd = ::shm_open(name_.c_str(), O_RDWR, 0);
+    if (fd < 0) return;
+    struct stat status;
+    bool mapped = ::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header) &&
+                  map(fd, static_cast<size_t>(status.st_size));
+    ::close(fd);
+    if (!mapped) return;
+
+    Header* header = static_cast<Header*>(mapping_);
+    if (header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC || header->version != SEGMENT_VERSION ||
+        header->node_bytes != sizeof(Node) || header->slot_bytes != sizeof(SymbolSlot) || header->bytes > mapped_) {
+        return;
+    }
+    header_ = header;
+    locate();
+}
+
+SharedRadialList::~SharedRadialList() {
+    if (mapping_) ::munmap(mapping_, mapped_);
+    if (writer_ && header_) ::shm_unlink(name_.c_str());
+}
+
+bool SharedRadialList::map(int fd, size_t bytes) {
+    void* memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) return false;
+    mapping_ = memory;
+    mapped_ = bytes;
+    return true;
+}
+
+void SharedRadialList::locate() {
+    char* base = static_cast<char*>(mapping_);
+    index_ = reinterpret_cast<std::atomic<uint32_t>*>(base + header_->index_offset);
+    symbols_ = reinterpret_cast<SymbolSlot*>(base + header_->symbols_offset);
+    heaps_ = reinterpret_cast<HeapEntry*>(base + header_->heaps_offset);
+    nodes_ = reinterpret_cast<Node*>(base + header_->nodes_offset);
+    links_ = reinterpret_cast<std::atomic<uint32_t>*>(base + header_->links_offset);
+}
+
+SharedRadialList::SymbolSlot* SharedRadialList::slot(SymbolId symbol) const {
+    if (!header_ || symbol >= header_->symbol_count.load(std::memory_order_acquire)) return nullptr;
+    return &symbols_[symbol];
+}
+
+SharedRadialList::HeapEntry* SharedRadialList::heap_of(SymbolId symbol) const {
+    return heaps_ + size_t(symbol) * header_->heap_capacity;
+}
+
+// Symbol table
+SymbolId SharedRadialList::find(const std::string& symbol) const {
+    if (!header_ || symbol.size() > MAX_NAME) return INVALID_SYMBOL_ID;
+    uint32_t mask = header_->table_size - 1;
+    for (uint32_t position = hash_name(symbol.data(), symbol.size()) & mask;; position = (position + 1) & mask) {
+        uint32_t entry = index_[position].load(std::memory_order_acquire);
+        if (entry == 0) return INVALID_SYMBOL_ID;
+        const SymbolSlot& candidate = symbols_[entry - 1];
+        if (std::strncmp(candidate.name, symbol.c_str(), MAX_NAME + 1) == 0) return entry - 1;
+    }
+}
+
+SymbolId SharedRadialList::intern(const std::string& symbol) {
+    if (!writer_ || !header_ || symbol.empty() || symbol.size() > MAX_NAME) return INVALID_SYMBOL_ID;
+    SymbolId existing = find(symbol);
+    if (existing != INVALID_SYMBOL_ID) return existing;
+
+    uint32_t id = header_->symbol_count.load(std::memory_order_relaxed);
+    if (id >= header_->max_symbols) return INVALID_SYMBOL_ID;
+    std::memcpy(symbols_[id].name, symbol.c_str(), symbol.size() + 1);
+    // The count goes first, so an id found through the index is in range
+    uint32_t mask = header_->table_size - 1;
+    uint32_t position = hash_name(symbol.data(), symbol.size()) & mask;
+    while (index_[position].load(std::memory_order_relaxed) != 0) position = (position + 1) & mask;
+    header_->symbol_count.store(id + 1, std::memory_order_release);
+    index_[position].store(id + 1, std::memory_order_release);
+    return id;
+}
+
+size_t SharedRadialList::symbol_count() const {
+    return header_ ? header_->symbol_count.load(std::memory_order_acquire) : 0;
+}
+
+// Free list
+uint32_t SharedRadialList::allocate() {
+    uint64_t head = header_->free_head.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == NIL) return NIL;
+        uint32_t next = links_[index].load(std::memory_order_relaxed);
+        if (header_->free_head.compare_exchange_weak(head, pack((head >> 32) + 1, next), std::memory_order_acquire,
+                                                     std::memory_order_acquire)) {
+            header_->free_count.fetch_sub(1, std::memory_order_relaxed);
+            return index;
+        }
+    }
+}
+
+void SharedRadialList::release(uint32_t node) {
+    uint64_t head = header_->free_head.load(std::memory_order_relaxed);
+    do {
+        links_[node].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!header_->free_head.compare_exchange_weak(head, pack((head >> 32) + 1, node), std::memory_order_release,
+                                                       std::memory_order_relaxed));
+    header_->free_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Heaps, the BoundedHeap layout over slot numbers
+bool SharedRadialList::heap_push(SymbolSlot& slot, HeapEntry* heap, HeapEntry entry) {
+    size_t index = slot.size.load(std::memory_order_relaxed);
+    if (index >= header_->heap_capacity) return false;
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap[parent].priority >= entry.priority) break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = entry;
+    slot.size.store(slot.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t SharedRadialList::heap_pop(SymbolSlot& slot, HeapEntry* heap) {
+    size_t size = slot.size.load(std::memory_order_relaxed);
+    if (size == 0) return NIL;
+    uint32_t top = heap[0].node;
+    slot.size.store(static_cast<uint32_t>(--size), std::memory_order_relaxed);
+    if (size > 0) {
+        HeapEntry entry = heap[size];
+        size_t index = 0;
+        while (true) {
+            size_t child = 2 * index + 1;
+            if (child >= size) break;
+            if (child + 1 < size && heap[child + 1].priority > heap[child].priority) ++child;
+            if (heap[child].priority <= entry.priority) break;
+            heap[index] = heap[child];
+            index = child;
+        }
+        heap[index] = entry;
+    }
+    return top;
+}
+
+void SharedRadialList::publish_top(SymbolSlot& slot, const HeapEntry* heap) {
+    TopEntry top{};
+    if (slot.size.load(std::memory_order_relaxed) > 0) {
+        top.node = nodes_[heap[0].node];
+        top.present = 1;
+    }
+    slot.top.store(top);
+}
+
+// Operations
+bool SharedRadialList::insert(double value, SymbolId symbol, int priority, double expiry_time) {
+    SymbolSlot* target = writer_ ? slot(symbol) : nullptr;
+    if (!target) return false;
+    uint32_t index = allocate();
+    if (index == NIL) return false;
+
+    Node& node = nodes_[index];
+    node.value = value;
+    node.priority = priority;
+    node.symbol = symbol;
+    node.stamp(expiry_time);
+
+    HeapEntry* heap = heap_of(symbol);
+    std::unique_lock<SpinLock> guard(target->lock);
+    if (!heap_push(*target, heap, HeapEntry{priority, index})) {
+        guard.unlock();
+        release(index);
+        return false;
+    }
+    publish_top(*target, heap);
+    return true;
+}
+
+bool SharedRadialList::insert(double value, const std::string& symbol, int priority, double expiry_time) {
+    return insert(value, intern(symbol), priority, expiry_time);
+}
+
+bool SharedRadialList::get_highest_priority(SymbolId symbol, Node& out) {
+    SymbolSlot* target = slot(symbol);
+    if (!target || target->size.load(std::memory_order_relaxed) == 0) return false;
+    HeapEntry* heap = heap_of(symbol);
+    uint64_t now = CoarseClock::now();
+    uint32_t found = NIL;
+    uint32_t expired = NIL;  // chained through links_ and released after unlocking
+    {
+        std::lock_guard<SpinLock> guard(target->lock);
+        while ((found = heap_pop(*target, heap)) != NIL) {
+            if (!nodes_[found].is_expired(now)) break;
+            links_[found].store(expired, std::memory_order_relaxed);
+            expired = found;
+        }
+        if (found != NIL) out = nodes_[found];
+        publish_top(*target, heap);
+    }
+    while (expired != NIL) {
+        uint32_t next = links_[expired].load(std::memory_order_relaxed);
+        release(expired);
+        expired = next;
+    }
+    if (found == NIL) return false;
+    release(found);
+    return true;
+}
+
+bool SharedRadialList::get_highest_priority(const std::string& symbol, Node& out) {
+    return get_highest_priority(find(symbol), out);
+}
+
+bool SharedRadialList::peek_highest_priority(SymbolId symbol, Node& out) const {
+    const SymbolSlot* target = slot(symbol);
+    if (!target) return false;
+    TopEntry top = target->top.load();
+    if (!top.present || top.node.is_expired(CoarseClock::now())) return false;
+    out = top.node;
+    return true;
+}
+
+size_t SharedRadialList::purge_expired(SymbolId symbol) {
+    SymbolSlot* target = slot(symbol);
+    if (!target) return 0;
+    HeapEntry* heap = heap_of(symbol);
+    uint64_t now = CoarseClock::now();
+    uint32_t expired = NIL;
+    size_t removed = 0;
+    {
+        std::lock_guard<SpinLock> guard(target->lock);
+        size_t size = target->size.load(std::memory_order_relaxed);
+        size_t kept = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (nodes_[heap[i].node].is_expired(now)) {
+                links_[heap[i].node].store(expired, std::memory_order_relaxed);
+                expired = heap[i].node;
+                ++removed;
+            } else {
+                heap[kept++] = heap[i];
+            }
+        }
+        if (removed) {
+            // Sift the survivors back up in place
+            target->size.store(0, std::memory_order_relaxed);
+            for (size_t i = 0; i < kept; ++i) heap_push(*target, heap, heap[i]);
+            publish_top(*target, heap);
+        }
+    }
+    while (expired != NIL) {
+        uint32_t next = links_[expired].load(std::memory_order_relaxed);
+        release(expired);
+        expired = next;
+    }
+    return removed;
+}
+
+size_t SharedRadialList::size(SymbolId symbol) const {
+    const SymbolSlot* target = slot(symbol);
+    return target ? target->size.load(std::memory_order_relaxed) : 0;
+}
+
+size_t SharedRadialList::free_slots() const {
+    return header_ ? header_->free_count.load(std::memory_order_relaxed) : 0;
+}
+
+size_t SharedRadialList::capacity() const {
+    return header_ ? header_->node_capacity : 0;
+}
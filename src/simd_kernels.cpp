@@ -0,0 +1,327 @@
+#include "simd_kernels.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HFT_SIMD_X86 1
+#endif
+
+namespace hft_cache {
+
+namespace {
+
+// Scalar tier: the reference results, the non-x86 fallback and the tails
+// of the vector loops. The select loops store unconditionally and advance
+// conditionally, which keeps them branch-free.
+
+size_t select_expired_scalar(const uint64_t* deadlines, size_t begin, size_t n, uint64_t now_ns,
+                             uint32_t* out, size_t count) {
+    for (size_t i = begin; i < n; ++i) {
+        out[count] = static_cast<uint32_t>(i);
+        count += now_ns > deadlines[i];
+    }
+    return count;
+}
+
+size_t select_value_range_scalar(const double* values, size_t begin, size_t n, double lo, double hi,
+                                 uint32_t* out, size_t count) {
+    for (size_t i = begin; i < n; ++i) {
+        out[count] = static_cast<uint32_t>(i);
+        count += (values[i] >= lo) & (values[i] <= hi);
+    }
+    return count;
+}
+
+size_t select_priority_range_scalar(const int32_t* priorities, size_t begin, size_t n, int32_t lo, int32_t hi,
+                                    uint32_t* out, size_t count) {
+    for (size_t i = begin; i < n; ++i) {
+        out[count] = static_cast<uint32_t>(i);
+        count += (priorities[i] >= lo) & (priorities[i] <= hi);
+    }
+    return count;
+}
+
+size_t first_index_of(const int32_t* priorities, size_t begin, size_t n, int32_t value) {
+    for (size_t i = begin; i < n; ++i) {
+        if (priorities[i] == value) return i;
+    }
+    return n;
+}
+
+size_t find_pointer_from(const void* const* items, size_t begin, size_t n, const void* key) {
+    for (size_t i = begin; i < n; ++i) {
+        if (items[i] == key) return i;
+    }
+    return n;
+}
+
+size_t select_expired_scalar(const uint64_t* deadlines, size_t n, uint64_t now_ns, uint32_t* out) {
+    return select_expired_scalar(deadlines, 0, n, now_ns, out, 0);
+}
+
+size_t select_value_range_scalar(const double* values, size_t n, double lo, double hi, uint32_t* out) {
+    return select_value_range_scalar(values, 0, n, lo, hi, out, 0);
+}
+
+size_t select_priority_range_scalar(const int32_t* priorities, size_t n, int32_t lo, int32_t hi, uint32_t* out) {
+    return select_priority_range_scalar(priorities, 0, n, lo, hi, out, 0);
+}
+
+size_t argmax_priority_scalar(const int32_t* priorities, size_t n) {
+    if (n == 0) return 0;
+    size_t best = 0;
+    for (size_t i = 1; i < n; ++i) {
+        if (priorities[i] > priorities[best]) best = i;
+    }
+    return best;
+}
+
+size_t find_pointer_scalar(const void* const* items, size_t n, const void* key) {
+    return find_pointer_from(items, 0, n, key);
+}
+
+#ifdef HFT_SIMD_X86
+
+// Appends base + bit for every set bit of mask
+inline size_t emit_indices(uint32_t mask, size_t base, uint32_t* out, size_t count) {
+    while (mask) {
+        out[count++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+// AVX2 tier. Deadlines stay below 2^63, so the signed 64-bit compare is exact.
+
+__attribute__((target("avx2")))
+size_t select_expired_avx2(const uint64_t* deadlines, size_t n, uint64_t now_ns, uint32_t* out) {
+    const __m256i now = _mm256_set1_epi64x(static_cast<long long>(now_ns));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i deadline = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(deadlines + i));
+        uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(now, deadline)));
+        count = emit_indices(mask, i, out, count);
+    }
+    return select_expired_scalar(deadlines, i, n, now_ns, out, count);
+}
+
+__attribute__((target("avx2")))
+size_t select_value_range_avx2(const double* values, size_t n, double lo, double hi, uint32_t* out) {
+    const __m256d low = _mm256_set1_pd(lo);
+    const __m256d high = _mm256_set1_pd(hi);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d value = _mm256_loadu_pd(values + i);
+        __m256d inside = _mm256_and_pd(_mm256_cmp_pd(value, low, _CMP_GE_OQ), _mm256_cmp_pd(value, high, _CMP_LE_OQ));
+        count = emit_indices(_mm256_movemask_pd(inside), i, out, count);
+    }
+    return select_value_range_scalar(values, i, n, lo, hi, out, count);
+}
+
+__attribute__((target("avx2")))
+size_t select_priority_range_avx2(const int32_t* priorities, size_t n, int32_t lo, int32_t hi, uint32_t* out) {
+    const __m256i low = _mm256_set1_epi32(lo);
+    const __m256i high = _mm256_set1_epi32(hi);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i priority = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(priorities + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(low, priority), _mm256_cmpgt_epi32(priority, high));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) & 0xFFu;
+        count = emit_indices(mask, i, out, count);
+    }
+    return select_priority_range_scalar(priorities, i, n, lo, hi, out, count);
+}
+
+// Max-reduce the column, then return the first lane holding the maximum
+__attribute__((target("avx2")))
+size_t argmax_priority_avx2(const int32_t* priorities, size_t n) {
+    if (n < 8) return argmax_priority_scalar(priorities, n);
+    __m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(priorities));
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        best = _mm256_max_epi32(best, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(priorities + i)));
+    }
+    __m128i half = _mm_max_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t maximum = _mm_cvtsi128_si32(half);
+    for (; i < n; ++i) {
+        if (priorities[i] > maximum) maximum = priorities[i];
+    }
+
+    const __m256i target = _mm256_set1_epi32(maximum);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i priority = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(priorities + j));
+        uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(priority, target)));
+        if (mask) return j + __builtin_ctz(mask);
+    }
+    return first_index_of(priorities, j, n, maximum);
+}
+
+__attribute__((target("avx2")))
+size_t find_pointer_avx2(const void* const* items, size_t n, const void* key) {
+    static_assert(sizeof(void*) == sizeof(long long), "pointer kernels assume 64-bit pointers");
+    const __m256i needle = _mm256_set1_epi64x(reinterpret_cast<long long>(key));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i slots = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(items + i));
+        uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(slots, needle)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return find_pointer_from(items, i, n, key);
+}
+
+// AVX-512 tier: compares produce mask registers and matching lane indices
+// are written with a single compress-store instead of a bit loop.
+
+#define HFT_AVX512_TARGET __attribute__((target("avx512f,avx512vl")))
+
+// GCC 12's AVX-512 headers seed masked intrinsics with a self-initialised
+// "undefined" register, which trips -Wmaybe-uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+HFT_AVX512_TARGET
+size_t select_expired_avx512(const uint64_t* deadlines, size_t n, uint64_t now_ns, uint32_t* out) {
+    const __m512i now = _mm512_set1_epi64(static_cast<long long>(now_ns));
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i deadline = _mm512_loadu_si512(deadlines + i);
+        __mmask8 mask = _mm512_cmpgt_epu64_mask(now, deadline);
+        __m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i)));
+        _mm256_mask_compressstoreu_epi32(out + count, mask, index);
+        count += __builtin_popcount(mask);
+    }
+    return select_expired_scalar(deadlines, i, n, now_ns, out, count);
+}
+
+HFT_AVX512_TARGET
+size_t select_value_range_avx512(const double* values, size_t n, double lo, double hi, uint32_t* out) {
+    const __m512d low = _mm512_set1_pd(lo);
+    const __m512d high = _mm512_set1_pd(hi);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d value = _mm512_loadu_pd(values + i);
+        __mmask8 mask = _mm512_cmp_pd_mask(value, low, _CMP_GE_OQ) & _mm512_cmp_pd_mask(value, high, _CMP_LE_OQ);
+        __m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i)));
+        _mm256_mask_compressstoreu_epi32(out + count, mask, index);
+        count += __builtin_popcount(mask);
+    }
+    return select_value_range_scalar(values, i, n, lo, hi, out, count);
+}
+
+HFT_AVX512_TARGET
+size_t select_priority_range_avx512(const int32_t* priorities, size_t n, int32_t lo, int32_t hi, uint32_t* out) {
+    const __m512i low = _mm512_set1_epi32(lo);
+    const __m512i high = _mm512_set1_epi32(hi);
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i priority = _mm512_loadu_si512(priorities + i);
+        __mmask16 mask = _mm512_cmpge_epi32_mask(priority, low) & _mm512_cmple_epi32_mask(priority, high);
+        __m512i index = _mm512_add_epi32(lanes, _mm512_set1_epi32(static_cast<int>(i)));
+        _mm512_mask_compressstoreu_epi32(out + count, mask, index);
+        count += __builtin_popcount(mask);
+    }
+    return select_priority_range_scalar(priorities, i, n, lo, hi, out, count);
+}
+
+HFT_AVX512_TARGET
+size_t argmax_priority_avx512(const int32_t* priorities, size_t n) {
+    if (n < 16) return argmax_priority_scalar(priorities, n);
+    __m512i best = _mm512_loadu_si512(priorities);
+    size_t i = 16;
+    for (; i + 16 <= n; i += 16) best = _mm512_max_epi32(best, _mm512_loadu_si512(priorities + i));
+    int32_t maximum = _mm512_reduce_max_epi32(best);
+    for (; i < n; ++i) {
+        if (priorities[i] > maximum) maximum = priorities[i];
+    }
+
+    const __m512i target = _mm512_set1_epi32(maximum);
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(priorities + j), target);
+        if (mask) return j + __builtin_ctz(mask);
+    }
+    return first_index_of(priorities, j, n, maximum);
+}
+
+HFT_AVX512_TARGET
+size_t find_pointer_avx512(const void* const* items, size_t n, const void* key) {
+    const __m512i needle = _mm512_set1_epi64(reinterpret_cast<long long>(key));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __mmask8 mask = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(items + i), needle);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return find_pointer_from(items, i, n, key);
+}
+
+#pragma GCC diagnostic pop
+#undef HFT_AVX512_TARGET
+
+#endif // HFT_SIMD_X86
+
+const SIMDKernels SCALAR_KERNELS = {
+    SIMDLevel::SCALAR, 0,
+    select_expired_scalar, select_value_range_scalar, select_priority_range_scalar,
+    argmax_priority_scalar, find_pointer_scalar,
+};
+
+#ifdef HFT_SIMD_X86
+const SIMDKernels AVX2_KERNELS = {
+    SIMDLevel::AVX2, 32,
+    select_expired_avx2, select_value_range_avx2, select_priority_range_avx2,
+    argmax_priority_avx2, find_pointer_avx2,
+};
+
+const SIMDKernels AVX512_KERNELS = {
+    SIMDLevel::AVX512, 64,
+    select_expired_avx512, select_value_range_avx512, select_priority_range_avx512,
+    argmax_priority_avx512, find_pointer_avx512,
+};
+#endif
+
+} // namespace
+
+SIMDLevel detect_simd_level() {
+#ifdef HFT_SIMD_X86
+    // __builtin_cpu_supports also checks that the OS saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) return SIMDLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SIMDLevel::AVX2;
+#endif
+    return SIMDLevel::SCALAR;
+}
+
+const SIMDKernels& simd_kernels(SIMDLevel level) {
+    static const SIMDLevel supported = detect_simd_level();
+    if (level > supported) level = supported;
+#ifdef HFT_SIMD_X86
+    if (level == SIMDLevel::AVX512) return AVX512_KERNELS;
+    if (level == SIMDLevel::AVX2) return AVX2_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
+
+const SIMDKernels& active_simd_kernels() {
+    static const SIMDKernels& kernels = simd_kernels(detect_simd_level());
+    return kernels;
+}
+
+const char* simd_level_name(SIMDLevel level) {
+    switch (level) {
+        case SIMDLevel::AVX512: return "AVX-512";
+        case SIMDLevel::AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+} // namespace hft_cache
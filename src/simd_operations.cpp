@@ -0,0 +1,392 @@
+#include "simd_operations.hpp"
+#include "clock.hpp"
+#include "epoch_reclamation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace hft_cache {
+
+namespace {
+
+// Match indices for one scan, reused so steady-state scans never allocate
+std::vector<uint32_t>& scratch_indices(size_t n) {
+    thread_local std::vector<uint32_t> indices;
+    if (indices.size() < n) indices.resize(n);
+    return indices;
+}
+
+} // namespace
+
+// SymbolColumns Implementation
+void SymbolColumns::append(Node* node) {
+    values_.push_back(node->value);
+    priorities_.push_back(node->priority);
+    deadlines_.push_back(node->deadline_ns);
+    nodes_.push_back(node);
+}
+
+void SymbolColumns::remove_at(size_t index) {
+    size_t last = nodes_.size() - 1;
+    values_[index] = values_[last];
+    priorities_[index] = priorities_[last];
+    deadlines_[index] = deadlines_[last];
+    nodes_[index] = nodes_[last];
+    values_.pop_back();
+    priorities_.pop_back();
+    deadlines_.pop_back();
+    nodes_.pop_back();
+}
+
+void SymbolColumns::remove_indices(const uint32_t* indices, size_t count) {
+    // Back to front: the entry swapped into each hole is never one still to be removed
+    for (size_t i = count; i-- > 0;) remove_at(indices[i]);
+}
+
+// SIMDOperations Implementation
+SIMDOperations::SIMDOperations(const CacheConfig& config) : SIMDOperations(config, detect_simd_level()) {}
+
+SIMDOperations::SIMDOperations(const CacheConfig& config, SIMDLevel level)
+    : config_(config), kernels_(simd_kernels(level)) {}
+
+void SIMDOperations::record_scan(size_t elements, size_t element_bytes) {
+    total_ops_count_.fetch_add(elements, std::memory_order_relaxed);
+    if (kernels_.vector_bytes == 0) return;
+    size_t lanes = kernels_.vector_bytes / element_bytes;
+    vectorized_ops_count_.fetch_add(elements - elements % lanes, std::memory_order_relaxed);
+}
+
+template <typename Fn>
+void SIMDOperations::for_each_store(Fn&& fn) {
+    size_t symbols = SymbolRegistry::global().size();
+    for (SymbolId id = 0; id < symbols; ++id) {
+        if (SymbolStore* store = stores_.get(id)) fn(*store);
+    }
+}
+
+template <typename Select>
+void SIMDOperations::collect(SymbolStore& store, Select&& select, std::vector<Node*>& out) {
+    std::lock_guard<SpinLock> guard(store.lock);
+    const SymbolColumns& columns = store.columns;
+    std::vector<uint32_t>& indices = scratch_indices(columns.size());
+    size_t matches = select(columns, indices.data());
+    for (size_t i = 0; i < matches; ++i) out.push_back(columns.node(indices[i]));
+}
+
+bool SIMDOperations::insert(Node* node) {
+    if (!node || node->symbol == INVALID_SYMBOL_ID) return false;
+    SymbolStore* store = stores_.get_or_create(node->symbol);
+    if (!store) return false;
+    std::lock_guard<SpinLock> guard(store->lock);
+    store->columns.append(node);
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SIMDOperations::vectorized_insert_batch(const std::vector<Node*>& nodes) {
+    for (Node* node : nodes) insert(node);
+}
+
+size_t SIMDOperations::vectorized_priority_update(const std::vector<std::pair<Node*, int>>& updates) {
+    size_t updated = 0;
+    for (const auto& [node, priority] : updates) {
+        if (!node) continue;
+        SymbolStore* store = stores_.get(node->symbol);
+        if (!store) continue;
+        std::lock_guard<SpinLock> guard(store->lock);
+        SymbolColumns& columns = store->columns;
+        size_t index = kernels_.find_pointer(columns.slots(), columns.size(), node);
+        record_scan(index, sizeof(Node*));
+        if (index == columns.size()) continue;
+        columns.set_priority(index, priority);
+        node->priority = priority;
+        ++updated;
+    }
+    return updated;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_expiry_check(uint64_t now_ns) {
+    std::vector<Node*> expired;
+    for_each_store([&](SymbolStore& store) {
+        std::lock_guard<SpinLock> guard(store.lock);
+        SymbolColumns& columns = store.columns;
+        if (columns.empty()) return;
+        std::vector<uint32_t>& indices = scratch_indices(columns.size());
+        size_t matches = kernels_.select_expired(columns.deadlines(), columns.size(), now_ns, indices.data());
+        record_scan(columns.size(), sizeof(uint64_t));
+        if (matches == 0) return;
+        for (size_t i = 0; i < matches; ++i) expired.push_back(columns.node(indices[i]));
+        columns.remove_indices(indices.data(), matches);
+        size_.fetch_sub(matches, std::memory_order_relaxed);
+    });
+    return expired;
+}
+
+bool SIMDOperations::remove(Node* node) {
+    if (!node) return false;
+    SymbolStore* store = stores_.get(node->symbol);
+    if (!store) return false;
+    std::lock_guard<SpinLock> guard(store->lock);
+    SymbolColumns& columns = store->columns;
+    size_t index = kernels_.find_pointer(columns.slots(), columns.size(), node);
+    record_scan(index, sizeof(Node*));
+    if (index == columns.size()) return false;
+    columns.remove_at(index);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_search_by_symbol(const std::string& symbol) {
+    std::vector<Node*> results;
+    SymbolStore* store = stores_.get(SymbolRegistry::global().find(symbol));
+    if (!store) return results;
+    std::lock_guard<SpinLock> guard(store->lock);
+    for (size_t i = 0; i < store->columns.size(); ++i) results.push_back(store->columns.node(i));
+    return results;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_search_by_value_range(double min_value, double max_value) {
+    std::vector<Node*> results;
+    auto select = [&](const SymbolColumns& columns, uint32_t* out) {
+        record_scan(columns.size(), sizeof(double));
+        return kernels_.select_value_range(columns.values(), columns.size(), min_value, max_value, out);
+    };
+    for_each_store([&](SymbolStore& store) { collect(store, select, results); });
+    return results;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_search_by_value_range(SymbolId symbol, double min_value, double max_value) {
+    std::vector<Node*> results;
+    SymbolStore* store = stores_.get(symbol);
+    if (!store) return results;
+    collect(*store, [&](const SymbolColumns& columns, uint32_t* out) {
+        record_scan(columns.size(), sizeof(double));
+        return kernels_.select_value_range(columns.values(), columns.size(), min_value, max_value, out);
+    }, results);
+    return results;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_search_by_priority_range(int min_priority, int max_priority) {
+    std::vector<Node*> results;
+    auto select = [&](const SymbolColumns& columns, uint32_t* out) {
+        record_scan(columns.size(), sizeof(int32_t));
+        return kernels_.select_priority_range(columns.priorities(), columns.size(), min_priority, max_priority, out);
+    };
+    for_each_store([&](SymbolStore& store) { collect(store, select, results); });
+    return results;
+}
+
+std::vector<Node*> SIMDOperations::vectorized_search_by_priority_range(SymbolId symbol, int min_priority, int max_priority) {
+    std::vector<Node*> results;
+    SymbolStore* store = stores_.get(symbol);
+    if (!store) return results;
+    collect(*store, [&](const SymbolColumns& columns, uint32_t* out) {
+        record_scan(columns.size(), sizeof(int32_t));
+        return kernels_.select_priority_range(columns.priorities(), columns.size(), min_priority, max_priority, out);
+    }, results);
+    return results;
+}
+
+Node* SIMDOperations::vectorized_highest_priority(SymbolId symbol) {
+    SymbolStore* store = stores_.get(symbol);
+    if (!store) return nullptr;
+    std::lock_guard<SpinLock> guard(store->lock);
+    const SymbolColumns& columns = store->columns;
+    if (columns.empty()) return nullptr;
+    record_scan(columns.size(), sizeof(int32_t));
+    return columns.node(kernels_.argmax_priority(columns.priorities(), columns.size()));
+}
+
+Node* SIMDOperations::take_highest_priority(SymbolId symbol) {
+    SymbolStore* store = stores_.get(symbol);
+    if (!store) return nullptr;
+    std::lock_guard<SpinLock> guard(store->lock);
+    SymbolColumns& columns = store->columns;
+    if (columns.empty()) return nullptr;
+    record_scan(columns.size(), sizeof(int32_t));
+    size_t index = kernels_.argmax_priority(columns.priorities(), columns.size());
+    Node* node = columns.node(index);
+    columns.remove_at(index);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return node;
+}
+
+double SIMDOperations::get_simd_utilization() const {
+    size_t total = total_ops_count_.load(std::memory_order_relaxed);
+    return total ? static_cast<double>(vectorized_ops_count_.load(std::memory_order_relaxed)) / total : 0.0;
+}
+
+size_t SIMDOperations::get_vectorized_operations_count() const {
+    return vectorized_ops_count_.load(std::memory_order_relaxed);
+}
+
+void SIMDOperations::reset_performance_counters() {
+    vectorized_ops_count_.store(0, std::memory_order_relaxed);
+    total_ops_count_.store(0, std::memory_order_relaxed);
+}
+
+// Benchmark
+double SIMDBenchmarkResult::mean_speedup() const {
+    double log_sum = 0.0;
+    for (size_t kernel = 0; kernel < 4; ++kernel) log_sum += std::log(speedup(kernel));
+    return std::exp(log_sum / 4);
+}
+
+namespace {
+
+// Best-of-rounds time per call, in nanoseconds
+template <typename Fn>
+double time_kernel(size_t rounds, Fn&& fn) {
+    double best = 0.0;
+    volatile size_t sink = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        sink = sink + fn();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+void time_tier(const SIMDKernels& kernels, size_t rounds, const std::vector<uint64_t>& deadlines,
+               const std::vector<double>& values, const std::vector<int32_t>& priorities, uint64_t now,
+               std::vector<uint32_t>& out, double* timings) {
+    size_t n = values.size();
+    timings[0] = time_kernel(rounds, [&] { return kernels.select_expired(deadlines.data(), n, now, out.data()); });
+    timings[1] = time_kernel(rounds, [&] {
+        return kernels.select_value_range(values.data(), n, 100.0, 110.0, out.data());
+    });
+    timings[2] = time_kernel(rounds, [&] {
+        return kernels.select_priority_range(priorities.data(), n, 40, 60, out.data());
+    });
+    timings[3] = time_kernel(rounds, [&] { return kernels.argmax_priority(priorities.data(), n); });
+}
+
+} // namespace
+
+SIMDBenchmarkResult benchmark_simd_kernels(SIMDLevel level, size_t elements, size_t rounds) {
+    const SIMDKernels& vector = simd_kernels(level);
+    const SIMDKernels& scalar = simd_kernels(SIMDLevel::SCALAR);
+
+    // Uniform data so every select matches a fixed fraction (~10-20%)
+    std::mt19937_64 rng(42);
+    uint64_t now = uint64_t(1) << 50;
+    std::vector<uint64_t> deadlines(elements);
+    std::vector<double> values(elements);
+    std::vector<int32_t> priorities(elements);
+    std::uniform_real_distribution<double> price(50.0, 150.0);
+    std::uniform_int_distribution<int32_t> priority(0, 99);
+    std::uniform_int_distribution<uint64_t> ttl(0, 10'000'000);
+    for (size_t i = 0; i < elements; ++i) {
+        values[i] = price(rng);
+        priorities[i] = priority(rng);
+        deadlines[i] = now - 1'000'000 + ttl(rng);
+    }
+    std::vector<uint32_t> out(elements);
+
+    SIMDBenchmarkResult result{};
+    result.level = vector.level;
+    result.elements = elements;
+    time_tier(scalar, rounds, deadlines, values, priorities, now, out, result.scalar_ns);
+    time_tier(vector, rounds, deadlines, values, priorities, now, out, result.vector_ns);
+    return result;
+}
+
+// SIMDCache Implementation
+SIMDCache::SIMDCache(const CacheConfig& config) : SIMDCache(config, detect_simd_level()) {}
+
+SIMDCache::SIMDCache(const CacheConfig& config, SIMDLevel level)
+    : config_(config), pool_(config.max_nodes), simd_ops_(std::make_unique<SIMDOperations>(config, level)) {}
+
+SIMDCache::~SIMDCache() = default;
+
+bool SIMDCache::insert(double value, SymbolId symbol, int priority, double expiry_seconds) {
+    if (symbol == INVALID_SYMBOL_ID) return false;
+    Node* node = pool_.allocate();
+    if (!node) return false;
+    node->value = value;
+    node->priority = priority;
+    node->symbol = symbol;
+    node->stamp(expiry_seconds);
+    return simd_ops_->insert(node);
+}
+
+bool SIMDCache::insert(double value, const std::string& symbol, int priority, double expiry_seconds) {
+    return insert(value, SymbolRegistry::global().intern(symbol), priority, expiry_seconds);
+}
+
+Node* SIMDCache::get_highest_priority(SymbolId symbol) {
+    // Expired entries are skipped here and reclaimed by the next expire()
+    uint64_t now = CoarseClock::now();
+    while (Node* node = simd_ops_->take_highest_priority(symbol)) {
+        pool_.retire(node);
+        if (!node->is_expired(now)) return node;
+    }
+    return nullptr;
+}
+
+Node* SIMDCache::get_highest_priority(const std::string& symbol) {
+    return get_highest_priority(SymbolRegistry::global().find(symbol));
+}
+
+bool SIMDCache::remove(const std::string& symbol, double value) {
+    SymbolId id = SymbolRegistry::global().find(symbol);
+    if (id == INVALID_SYMBOL_ID) return false;
+    for (Node* node : simd_ops_->vectorized_search_by_value_range(id, value, value)) {
+        if (simd_ops_->remove(node)) {
+            pool_.retire(node);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SIMDCache::insert_batch(const std::vector<std::tuple<double, std::string, int, double>>& items) {
+    std::vector<Node*> nodes;
+    nodes.reserve(items.size());
+    for (const auto& [value, symbol, priority, expiry_seconds] : items) {
+        Node* node = pool_.allocate();
+        if (!node) {
+            // All or nothing, like RadialCircularList::insert_batch
+            for (Node* taken : nodes) pool_.release(taken);
+            return false;
+        }
+        node->value = value;
+        node->priority = priority;
+        node->symbol = SymbolRegistry::global().intern(symbol);
+        node->stamp(expiry_seconds);
+        nodes.push_back(node);
+    }
+    simd_ops_->vectorized_insert_batch(nodes);
+    return true;
+}
+
+std::vector<Node*> SIMDCache::get_batch(const std::vector<std::pair<std::string, double>>& keys) {
+    std::vector<Node*> results;
+    results.reserve(keys.size());
+    for (const auto& [symbol, value] : keys) {
+        auto matches = simd_ops_->vectorized_search_by_value_range(SymbolRegistry::global().find(symbol), value, value);
+        results.push_back(matches.empty() ? nullptr : matches.front());
+    }
+    return results;
+}
+
+size_t SIMDCache::expire(uint64_t now_ns) {
+    // get_batch hands out pointers into the store, so expired slots are retired, not released
+    std::vector<Node*> expired = simd_ops_->vectorized_expiry_check(now_ns);
+    for (Node* node : expired) pool_.retire(node);
+    return expired.size();
+}
+
+double SIMDCache::get_simd_performance_improvement() const {
+    double cached = performance_improvement_.load(std::memory_order_relaxed);
+    if (cached > 0.0) return cached;
+    double measured = simd_ops_->level() == SIMDLevel::SCALAR
+                          ? 1.0
+                          : benchmark_simd_kernels(simd_ops_->level()).mean_speedup();
+    performance_improvement_.store(measured, std::memory_order_relaxed);
+    return measured;
+}
+
+} // namespace hft_cache
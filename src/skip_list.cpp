@@ -1 +1,509 @@
- 
\ No newline at end of file
+#include "skip_list.hpp"
+#include "epoch_reclamation.hpp"
+#include "spin_lock.hpp"
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <new>
+
+namespace hft_cache {
+
+namespace {
+
+// xorshift64*, one per thread, seeded from its own address so threads differ
+uint64_t next_random() {
+    thread_local uint64_t state = reinterpret_cast<uintptr_t>(&state) * 0x9E3779B97F4A7C15ull | 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+void free_tower(void* tower) {
+    SkipTowerArena::global().destroy(static_cast<SkipNode*>(tower));
+}
+
+} // namespace
+
+// SkipTowerArena Implementation
+SkipTowerArena& SkipTowerArena::global() {
+    static SkipTowerArena* arena = new SkipTowerArena();
+    return *arena;
+}
+
+int SkipTowerArena::class_of(int level) {
+    int cls = 0;
+    while ((1 << cls) < level) ++cls;
+    return cls;
+}
+
+SkipNode* SkipTowerArena::create(Node* data, int level) {
+    void* slot = nullptr;
+    switch (class_of(level)) {
+    case 0: slot = height_1_.create(); break;
+    case 1: slot = height_2_.create(); break;
+    case 2: slot = height_4_.create(); break;
+    case 3: slot = height_8_.create(); break;
+    case 4: slot = height_16_.create(); break;
+    default: slot = height_32_.create(); break;
+    }
+    if (!slot) return nullptr;
+    SkipNode* tower = new (slot) SkipNode(data, level);
+    for (int i = 0; i < level; ++i) new (&tower->next[i]) std::atomic<uintptr_t>(0);
+    return tower;
+}
+
+void SkipTowerArena::destroy(SkipNode* tower) {
+    int cls = class_of(tower->level);
+    tower->~SkipNode();
+    switch (cls) {
+    case 0: height_1_.destroy(reinterpret_cast<Storage<1>*>(tower)); break;
+    case 1: height_2_.destroy(reinterpret_cast<Storage<2>*>(tower)); break;
+    case 2: height_4_.destroy(reinterpret_cast<Storage<4>*>(tower)); break;
+    case 3: height_8_.destroy(reinterpret_cast<Storage<8>*>(tower)); break;
+    case 4: height_16_.destroy(reinterpret_cast<Storage<16>*>(tower)); break;
+    default: height_32_.destroy(reinterpret_cast<Storage<32>*>(tower)); break;
+    }
+}
+
+void SkipTowerArena::reserve(size_t towers) {
+    height_1_.reserve(towers);
+}
+
+void SkipTowerArena::flush() {
+    height_1_.flush();
+    height_2_.flush();
+    height_4_.flush();
+    height_8_.flush();
+    height_16_.flush();
+    height_32_.flush();
+}
+
+// LockFreeSkipList Implementation
+LockFreeSkipList::LockFreeSkipList(const CacheConfig& config)
+    : config_(config), head_(allocate_tower(nullptr, MAX_LEVEL)) {
+    if (!head_) throw std::bad_alloc();
+}
+
+LockFreeSkipList::~LockFreeSkipList() {
+    cleanup_all_nodes();
+    release_tower(head_);
+}
+
+SkipNode* LockFreeSkipList::allocate_tower(Node* data, int level) {
+    return SkipTowerArena::global().create(data, std::clamp(level, 1, MAX_LEVEL));
+}
+
+void LockFreeSkipList::release_tower(SkipNode* tower) {
+    if (tower) SkipTowerArena::global().destroy(tower);
+}
+
+int LockFreeSkipList::random_level() {
+    // Each pair of trailing zero bits is one more level, so p = 1/4
+    uint64_t bits = next_random();
+    int level = bits ? 1 + __builtin_ctzll(bits) / 2 : MAX_LEVEL;
+    return std::min(level, MAX_LEVEL);
+}
+
+bool LockFreeSkipList::before(const SkipNode* node, const Key& key) {
+    if (node->symbol != key.symbol) return node->symbol < key.symbol;
+    if (node->priority != key.priority) return node->priority > key.priority;
+    return std::less<const Node*>()(node->data, key.data);
+}
+
+bool LockFreeSkipList::find_node(const Key& key, SkipNode** preds, SkipNode** succs, int levels) {
+    int top = std::max(levels, max_level_.load(std::memory_order_acquire));
+retry:
+    SkipNode* pred = head_;
+    for (int level = top - 1; level >= 0; --level) {
+        SkipNode* curr = SkipNode::pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr) {
+            uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+            if (SkipNode::marked(succ)) {
+                // Deleted at this level: unlink it, or start over if pred changed first
+                uintptr_t expected = SkipNode::word(curr);
+                if (!pred->next[level].compare_exchange_strong(expected, succ & ~SkipNode::MARK,
+                                                               std::memory_order_acq_rel)) {
+                    cpu_relax();
+                    goto retry;
+                }
+                curr = SkipNode::pointer(succ);
+                continue;
+            }
+            if (!before(curr, key)) break;
+            pred = curr;
+            curr = SkipNode::pointer(succ);
+        }
+        if (level < levels) {
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+    }
+    return succs[0] && succs[0]->data == key.data;
+}
+
+bool LockFreeSkipList::insert(Node* node) {
+    if (!node || node->symbol == INVALID_SYMBOL_ID) return false;
+    SkipNode* tower = allocate_tower(node, random_level());
+    if (!tower) return false;
+    if (insert_node(tower)) return true;
+    release_tower(tower);
+    return false;
+}
+
+bool LockFreeSkipList::insert_node(SkipNode* tower) {
+    const int level = tower->level;
+    int current = max_level_.load(std::memory_order_relaxed);
+    while (level > current && !max_level_.compare_exchange_weak(current, level, std::memory_order_acq_rel)) {}
+
+    const Key key{tower->symbol, tower->priority, tower->data};
+    SkipNode* preds[MAX_LEVEL];
+    SkipNode* succs[MAX_LEVEL];
+    EpochGuard guard;
+
+    // Level 0 is the linearization point; the tower is in the list once it
+    // lands. Counted first so a remove that finds it at once cannot underflow.
+    size_.fetch_add(1, std::memory_order_relaxed);
+    total_levels_.fetch_add(level, std::memory_order_relaxed);
+    while (true) {
+        if (find_node(key, preds, succs, level)) {
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            total_levels_.fetch_sub(level, std::memory_order_relaxed);
+            return false;
+        }
+        for (int i = 0; i < level; ++i) tower->next[i].store(SkipNode::word(succs[i]), std::memory_order_relaxed);
+        uintptr_t expected = SkipNode::word(succs[0]);
+        if (preds[0]->next[0].compare_exchange_strong(expected, SkipNode::word(tower), std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    // Upper levels are only shortcuts; a remove that marks one stops the build
+    for (int i = 1; i < level; ++i) {
+        while (true) {
+            uintptr_t link = tower->next[i].load(std::memory_order_acquire);
+            if (SkipNode::marked(link)) goto built;
+            if (SkipNode::pointer(link) != succs[i] &&
+                !tower->next[i].compare_exchange_strong(link, SkipNode::word(succs[i]), std::memory_order_acq_rel)) {
+                continue;
+            }
+            uintptr_t expected = SkipNode::word(succs[i]);
+            if (preds[i]->next[i].compare_exchange_strong(expected, SkipNode::word(tower), std::memory_order_release,
+                                                          std::memory_order_relaxed)) {
+                break;
+            }
+            if (!find_node(key, preds, succs, level)) goto built;  // already removed
+        }
+    }
+built:
+    // A remover whose sweep ran before one of the links above would leave it
+    // behind; sweep again so nothing links the tower once it is retired
+    if (tower->deleted()) find_node(key, preds, succs, level);
+    finish(tower);
+    return true;
+}
+
+bool LockFreeSkipList::mark_tower(SkipNode* tower) {
+    for (int i = tower->level - 1; i >= 1; --i) tower->next[i].fetch_or(SkipNode::MARK, std::memory_order_acq_rel);
+    return !SkipNode::marked(tower->next[0].fetch_or(SkipNode::MARK, std::memory_order_acq_rel));
+}
+
+void LockFreeSkipList::finish(SkipNode* tower) {
+    if (tower->handoffs.fetch_add(1, std::memory_order_acq_rel) == 1) {
+        // Separately, so the Node stays on the heap's books until it is freed
+        EpochManager& epochs = EpochManager::global();
+        epochs.retire(tower->data);
+        epochs.retire(tower, free_tower);
+    }
+}
+
+template <typename Visit>
+void LockFreeSkipList::walk(const Key& from, Visit&& visit) const {
+    // Read-only descent: marked towers are stepped over, never unlinked
+    const SkipNode* pred = head_;
+    for (int level = max_level_.load(std::memory_order_acquire) - 1; level >= 0; --level) {
+        SkipNode* curr = SkipNode::pointer(pred->next[level].load(std::memory_order_acquire));
+        while (curr && before(curr, from)) {
+            pred = curr;
+            curr = SkipNode::pointer(curr->next[level].load(std::memory_order_acquire));
+        }
+    }
+    SkipNode* curr = SkipNode::pointer(pred->next[0].load(std::memory_order_acquire));
+    while (curr) {
+        uintptr_t next = curr->next[0].load(std::memory_order_acquire);
+        if (!SkipNode::marked(next) && !visit(curr)) return;
+        curr = SkipNode::pointer(next);
+    }
+}
+
+Node* LockFreeSkipList::find(const std::string& symbol, double value) {
+    return find(SymbolRegistry::global().find(symbol), value);
+}
+
+Node* LockFreeSkipList::find(SymbolId symbol, double value) {
+    Node* found = nullptr;
+    EpochGuard guard;
+    walk(Key{symbol, std::numeric_limits<int32_t>::max(), nullptr}, [&](SkipNode* tower) {
+        if (tower->symbol != symbol) return false;
+        if (tower->data->value == value) found = tower->data;
+        return !found;
+    });
+    return found;
+}
+
+bool LockFreeSkipList::remove(const std::string& symbol, double value) {
+    return remove(SymbolRegistry::global().find(symbol), value);
+}
+
+bool LockFreeSkipList::remove(SymbolId symbol, double value) {
+    EpochGuard guard;
+    while (true) {
+        SkipNode* victim = nullptr;
+        walk(Key{symbol, std::numeric_limits<int32_t>::max(), nullptr}, [&](SkipNode* tower) {
+            if (tower->symbol != symbol) return false;
+            if (tower->data->value == value) victim = tower;
+            return !victim;
+        });
+        if (!victim) return false;
+        // Losing the mark means another remove took this one; look again
+        if (!mark_tower(victim)) continue;
+
+        SkipNode* preds[MAX_LEVEL];
+        SkipNode* succs[MAX_LEVEL];
+        find_node(Key{victim->symbol, victim->priority, victim->data}, preds, succs, victim->level);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        total_levels_.fetch_sub(victim->level, std::memory_order_relaxed);
+        finish(victim);
+        return true;
+    }
+}
+
+void LockFreeSkipList::clear() {
+    cleanup_all_nodes();
+    size_.store(0);
+    total_levels_.store(0);
+    max_level_.store(1);
+}
+
+void LockFreeSkipList::cleanup_all_nodes() {
+    // Quiescent, so every tower still on level 0 is live and linked
+    SkipNode* curr = SkipNode::pointer(head_->next[0].load(std::memory_order_acquire));
+    while (curr) {
+        SkipNode* next = SkipNode::pointer(curr->next[0].load(std::memory_order_relaxed));
+        delete curr->data;
+        release_tower(curr);
+        curr = next;
+    }
+    for (int i = 0; i < MAX_LEVEL; ++i) head_->next[i].store(0, std::memory_order_relaxed);
+}
+
+Node* LockFreeSkipList::get_highest_priority(const std::string& symbol) {
+    return get_highest_priority(SymbolRegistry::global().find(symbol));
+}
+
+Node* LockFreeSkipList::get_highest_priority(SymbolId symbol) {
+    Node* top = nullptr;
+    get_top_n(symbol, 1, &top);
+    return top;
+}
+
+size_t LockFreeSkipList::get_top_n(SymbolId symbol, size_t n, Node** out) {
+    if (n == 0) return 0;
+    size_t written = 0;
+    EpochGuard guard;
+    walk(Key{symbol, std::numeric_limits<int32_t>::max(), nullptr}, [&](SkipNode* tower) {
+        if (tower->symbol != symbol) return false;
+        out[written++] = tower->data;
+        return written < n;
+    });
+    return written;
+}
+
+std::vector<Node*> LockFreeSkipList::get_top_n(const std::string& symbol, size_t n) {
+    return get_top_n(SymbolRegistry::global().find(symbol), n);
+}
+
+std::vector<Node*> LockFreeSkipList::get_top_n(SymbolId symbol, size_t n) {
+    std::vector<Node*> results(std::min(n, size()));
+    results.resize(get_top_n(symbol, results.size(), results.data()));
+    return results;
+}
+
+template <typename Keep>
+std::vector<Node*> LockFreeSkipList::collect(SymbolId symbol, int max_priority, Keep&& keep) const {
+    std::vector<Node*> results;
+    // keep may read the node, which a concurrent remove could retire
+    EpochGuard guard;
+    walk(Key{symbol, max_priority, nullptr}, [&](SkipNode* tower) {
+        if (tower->symbol != symbol) return false;
+        if (keep(tower)) results.push_back(tower->data);
+        return true;
+    });
+    return results;
+}
+
+std::vector<Node*> LockFreeSkipList::get_by_priority_range(const std::string& symbol, int min_priority,
+                                                           int max_priority) {
+    return get_by_priority_range(SymbolRegistry::global().find(symbol), min_priority, max_priority);
+}
+
+std::vector<Node*> LockFreeSkipList::get_by_priority_range(SymbolId symbol, int min_priority, int max_priority) {
+    if (min_priority > max_priority) return {};
+    std::vector<Node*> results;
+    EpochGuard guard;
+    walk(Key{symbol, max_priority, nullptr}, [&](SkipNode* tower) {
+        if (tower->symbol != symbol || tower->priority < min_priority) return false;
+        results.push_back(tower->data);
+        return true;
+    });
+    return results;
+}
+
+std::vector<Node*> LockFreeSkipList::get_range(const std::string& symbol, double min_value, double max_value) {
+    return get_range(SymbolRegistry::global().find(symbol), min_value, max_value);
+}
+
+std::vector<Node*> LockFreeSkipList::get_range(SymbolId symbol, double min_value, double max_value) {
+    return collect(symbol, std::numeric_limits<int32_t>::max(), [=](const SkipNode* tower) {
+        return tower->data->value >= min_value && tower->data->value <= max_value;
+    });
+}
+
+std::vector<Node*> LockFreeSkipList::get_by_timestamp_range(const std::string& symbol, uint64_t start_time,
+                                                            uint64_t end_time) {
+    return get_by_timestamp_range(SymbolRegistry::global().find(symbol), start_time, end_time);
+}
+
+std::vector<Node*> LockFreeSkipList::get_by_timestamp_range(SymbolId symbol, uint64_t start_time, uint64_t end_time) {
+    return collect(symbol, std::numeric_limits<int32_t>::max(), [=](const SkipNode* tower) {
+        return tower->data->timestamp_ns >= start_time && tower->data->timestamp_ns <= end_time;
+    });
+}
+
+size_t LockFreeSkipList::size() const {
+    return size_.load();
+}
+
+int LockFreeSkipList::get_max_level() const {
+    return max_level_.load();
+}
+
+double LockFreeSkipList::get_average_level() const {
+    size_t count = size_.load();
+    return count ? static_cast<double>(total_levels_.load()) / count : 0.0;
+}
+
+bool LockFreeSkipList::validate_skip_list() const {
+    size_t entries = 0;
+    size_t levels = 0;
+    for (int level = 0; level < MAX_LEVEL; ++level) {
+        const SkipNode* prev = nullptr;
+        for (const SkipNode* curr = SkipNode::pointer(head_->next[level].load()); curr;
+             curr = SkipNode::pointer(curr->next[level].load())) {
+            if (curr->deleted() || curr->level <= level) return false;
+            if (prev && !before(prev, Key{curr->symbol, curr->priority, curr->data})) return false;
+            if (level == 0) {
+                ++entries;
+                levels += curr->level;
+            }
+            prev = curr;
+        }
+        if (level >= max_level_.load() && prev) return false;
+    }
+    return entries == size_.load() && levels == total_levels_.load();
+}
+
+void LockFreeSkipList::print_skip_list() const {
+    std::cout << "Skip list (size: " << size_.load() << ", max level: " << max_level_.load()
+              << ", average level: " << get_average_level() << ")" << std::endl;
+}
+
+// Iterator Implementation
+LockFreeSkipList::Iterator::Iterator(SkipNode* current) : current_(current) {
+    skip_deleted();
+}
+
+void LockFreeSkipList::Iterator::skip_deleted() {
+    while (current_ && current_->deleted()) current_ = SkipNode::pointer(current_->next[0].load());
+}
+
+LockFreeSkipList::Iterator& LockFreeSkipList::Iterator::operator++() {
+    if (!current_) return *this;
+    current_ = SkipNode::pointer(current_->next[0].load());
+    skip_deleted();
+    return *this;
+}
+
+Node* LockFreeSkipList::Iterator::operator*() {
+    return current_ ? current_->data : nullptr;
+}
+
+bool LockFreeSkipList::Iterator::operator!=(const Iterator& other) const {
+    return current_ != other.current_;
+}
+
+LockFreeSkipList::Iterator LockFreeSkipList::begin() {
+    return Iterator(SkipNode::pointer(head_->next[0].load()));
+}
+
+LockFreeSkipList::Iterator LockFreeSkipList::end() {
+    return Iterator(nullptr);
+}
+
+// ThreadSafeSkipList Implementation
+ThreadSafeSkipList::ThreadSafeSkipList(const CacheConfig& config)
+    : LockFreeSkipList(config) {
+}
+
+bool ThreadSafeSkipList::insert_thread_safe(Node* node) {
+    concurrent_writers_.fetch_add(1);
+    bool result = insert(node);
+    concurrent_writers_.fetch_sub(1);
+    return result;
+}
+
+Node* ThreadSafeSkipList::find_thread_safe(const std::string& symbol, double value) {
+    return find_thread_safe(SymbolRegistry::global().find(symbol), value);
+}
+
+Node* ThreadSafeSkipList::find_thread_safe(SymbolId symbol, double value) {
+    concurrent_readers_.fetch_add(1);
+    Node* result = find(symbol, value);
+    concurrent_readers_.fetch_sub(1);
+    return result;
+}
+
+bool ThreadSafeSkipList::remove_thread_safe(const std::string& symbol, double value) {
+    return remove_thread_safe(SymbolRegistry::global().find(symbol), value);
+}
+
+bool ThreadSafeSkipList::remove_thread_safe(SymbolId symbol, double value) {
+    concurrent_writers_.fetch_add(1);
+    bool result = remove(symbol, value);
+    concurrent_writers_.fetch_sub(1);
+    return result;
+}
+
+// PooledSkipList Implementation
+PooledSkipList::PooledSkipList(const CacheConfig& config)
+    : LockFreeSkipList(config), pool_size_(config.max_nodes / 10) {
+    SkipTowerArena::global().reserve(pool_size_);
+}
+
+PooledSkipList::~PooledSkipList() = default;
+
+SkipNode* PooledSkipList::allocate_node(Node* data, int level) {
+    return allocate_tower(data, level);
+}
+
+void PooledSkipList::deallocate_node(SkipNode* node) {
+    release_tower(node);
+}
+
+void PooledSkipList::defragment_pool() {
+    SkipTowerArena::global().flush();
+}
+
+} // namespace hft_cache
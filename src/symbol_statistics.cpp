@@ -0,0 +1,84 @@
+#include "symbol_statistics.hpp"
+#include <cmath>
+#include <mutex>
+
+void SymbolStatistics::add(SymbolId symbol, double value, int32_t priority) {
+    Entry* entry = entries_.get_or_create(symbol);
+    if (!entry) return;
+    std::lock_guard<SpinLock> lock(entry->lock);
+
+    ++entry->count;
+    double delta = value - entry->mean;
+    entry->mean += delta / static_cast<double>(entry->count);
+    entry->m2 += delta * (value - entry->mean);
+
+    double weight = static_cast<double>(priority) + 1.0;
+    entry->sum += value;
+    entry->weighted_sum += value * weight;
+    entry->total_weight += weight;
+
+    // A value beyond an estimated extreme makes it exact again
+    if (entry->count == 1 || value <= entry->min_value) {
+        entry->min_value = value;
+        entry->min_exact = true;
+    }
+    if (entry->count == 1 || value >= entry->max_value) {
+        entry->max_value = value;
+        entry->max_exact = true;
+    }
+    entry->sketch.add(value);
+    entry->publish();
+}
+
+void SymbolStatistics::remove(SymbolId symbol, double value, int32_t priority) {
+    Entry* entry = entries_.get(symbol);
+    if (!entry) return;
+    std::lock_guard<SpinLock> lock(entry->lock);
+    if (entry->count == 0) return;
+
+    entry->sketch.remove(value);
+    if (--entry->count == 0) {
+        entry->mean = entry->m2 = entry->sum = 0.0;
+        entry->weighted_sum = entry->total_weight = 0.0;
+        entry->min_value = entry->max_value = 0.0;
+        entry->min_exact = entry->max_exact = false;
+    } else {
+        double previous_mean = entry->mean;
+        entry->mean = (previous_mean * static_cast<double>(entry->count + 1) - value) /
+                      static_cast<double>(entry->count);
+        entry->m2 = std::max(0.0, entry->m2 - (value - previous_mean) * (value - entry->mean));
+
+        double weight = static_cast<double>(priority) + 1.0;
+        entry->sum -= value;
+        entry->weighted_sum -= value * weight;
+        entry->total_weight -= weight;
+
+        // No way to recover the runner-up exactly, so fall back to the sketch
+        if (value <= entry->min_value) {
+            entry->min_value = entry->sketch.min();
+            entry->min_exact = false;
+        }
+        if (value >= entry->max_value) {
+            entry->max_value = entry->sketch.max();
+            entry->max_exact = false;
+        }
+    }
+    entry->publish();
+}
+
+void SymbolStatistics::Entry::publish() {
+    SymbolSummary summary{};
+    summary.count = count;
+    if (count) {
+        summary.sum = sum;
+        summary.average = mean;
+        summary.median = sketch.median();
+        summary.std_deviation = count > 1 ? std::sqrt(m2 / static_cast<double>(count - 1)) : 0.0;
+        summary.min_value = min_value;
+        summary.max_value = max_value;
+        summary.min_exact = min_exact;
+        summary.max_exact = max_exact;
+        summary.weighted_average = total_weight > 0.0 ? weighted_sum / total_weight : 0.0;
+    }
+    published.store(summary);
+}
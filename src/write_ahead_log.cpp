@@ -0,0 +1,424 @@
+#include "write_ahead_log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t SEGMENT_MAGIC = 0x4C415748;  // "HWAL"
+constexpr uint32_t FRAME_MAGIC = 0x4D524657;    // "WFRM"
+constexpr uint32_t WAL_VERSION = 1;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seq;
+    uint64_t reserved[2];
+};
+
+// Followed by define_count (u32 id, u16 length, name) records padded out
+// to define_bytes, then entry_count entries
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t entry_count;
+    uint32_t define_count;
+    uint32_t define_bytes;
+    uint64_t checksum;       // over everything after the header
+    uint64_t max_timestamp;
+};
+
+static_assert(sizeof(WriteAheadLog::Entry) == 40 && sizeof(FrameHeader) == 32 && sizeof(SegmentHeader) == 32,
+              "WAL layout");
+
+std::atomic<uint64_t> next_log_id{1};
+
+bool write_all(int fd, const uint8_t* data, size_t length) {
+    while (length) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_file(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamsize size = file.tellg();
+    if (size < 0) return false;
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), size));
+}
+
+} // namespace
+
+uint64_t WriteAheadLog::checksum(uint64_t seed, const uint8_t* data, size_t length) {
+    uint64_t hash = seed;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    if (length) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, length);
+        hash = (hash ^ word ^ (static_cast<uint64_t>(length) << 56)) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& directory, const Options& options)
+    : directory_(directory), options_(options), id_(next_log_id.fetch_add(1, std::memory_order_relaxed)) {
+    std::filesystem::create_directories(directory_);
+    init_buffer(overflow_);
+    // Never append after an old segment's possibly torn tail
+    auto segments = list_segments(directory_);
+    if (!segments.empty()) segment_seq_.store(segments.back().first);
+    flusher_ = std::thread([this]() { flusher_loop(); });
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_one();
+    if (flusher_.joinable()) flusher_.join();
+    close_segment();
+}
+
+void WriteAheadLog::init_buffer(ThreadBuffer& buffer) const {
+    size_t capacity = 64;
+    while (capacity < options_.buffer_entries) capacity <<= 1;
+    buffer.entries.reset(new Entry[capacity]);
+    buffer.mask = capacity - 1;
+}
+
+WriteAheadLog::ThreadBuffer* WriteAheadLog::local_buffer() {
+    struct Binding {
+        uint64_t log;
+        ThreadBuffer* buffer;
+    };
+    thread_local Binding last{0, nullptr};
+    thread_local std::vector<Binding> bindings;
+    if (last.log == id_) return last.buffer;
+    for (const Binding& binding : bindings) {
+        if (binding.log == id_) {
+            last = binding;
+            return last.buffer;
+        }
+    }
+
+    ThreadBuffer* buffer = &overflow_;
+    {
+        std::lock_guard<std::mutex> lock(register_mutex_);
+        size_t count = buffer_count_.load(std::memory_order_relaxed);
+        if (count < MAX_BUFFERS) {
+            buffers_[count] = std::make_unique<ThreadBuffer>();
+            init_buffer(*buffers_[count]);
+            buffer = buffers_[count].get();
+            buffer_count_.store(count + 1, std::memory_order_release);
+        }
+    }
+    last = Binding{id_, buffer};
+    bindings.push_back(last);
+    return buffer;
+}
+
+void WriteAheadLog::wait_for_space(ThreadBuffer& buffer) {
+    producer_waits_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_ = true;
+    }
+    wake_cv_.notify_one();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    while (head - buffer.tail.load(std::memory_order_acquire) > buffer.mask) std::this_thread::yield();
+}
+
+void WriteAheadLog::append(const Entry& entry) {
+    ThreadBuffer* buffer = local_buffer();
+    std::unique_lock<SpinLock> shared(overflow_lock_, std::defer_lock);
+    if (buffer == &overflow_) shared.lock();
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) > buffer->mask) wait_for_space(*buffer);
+    buffer->entries[head & buffer->mask] = entry;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool WriteAheadLog::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t ticket = ++sync_requested_;
+    wake_cv_.notify_one();
+    done_cv_.wait(lock, [this, ticket]() { return sync_completed_ >= ticket; });
+    return last_sync_ok_;
+}
+
+void WriteAheadLog::roll() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        roll_requested_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+void WriteAheadLog::flusher_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto interval = std::chrono::microseconds(std::max<size_t>(options_.group_commit_us, 1));
+    while (true) {
+        wake_cv_.wait_for(lock, interval, [this]() {
+            return stop_ || wake_ || roll_requested_ || sync_requested_ != sync_completed_;
+        });
+        uint64_t target = sync_requested_;
+        bool syncing = target != sync_completed_;
+        bool stopping = stop_;
+        bool roll = roll_requested_;
+        wake_ = false;
+        roll_requested_ = false;
+        lock.unlock();
+
+        bool ok = commit(syncing || stopping, roll);
+
+        lock.lock();
+        if (syncing) {
+            sync_completed_ = target;
+            last_sync_ok_ = ok;
+            done_cv_.notify_all();
+        }
+        if (stopping) break;
+    }
+}
+
+bool WriteAheadLog::commit(bool force_sync, bool roll) {
+    // batch_ keeps whatever a failed write left behind, so nothing is dropped
+    auto drain = [this](ThreadBuffer& buffer) {
+        uint64_t head = buffer.head.load(std::memory_order_acquire);
+        uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+        for (; tail < head; ++tail) batch_.push_back(buffer.entries[tail & buffer.mask]);
+        buffer.tail.store(head, std::memory_order_release);
+    };
+    for (size_t i = 0, count = buffer_count_.load(std::memory_order_acquire); i < count; ++i) drain(*buffers_[i]);
+    drain(overflow_);
+
+    if (roll) close_segment();
+    if (batch_.empty()) {
+        if (force_sync && fd_ >= 0 && frames_since_sync_) {
+            frames_since_sync_ = 0;
+            fsyncs_.fetch_add(1, std::memory_order_relaxed);
+            return ::fdatasync(fd_) == 0;
+        }
+        return true;
+    }
+
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const Entry& a, const Entry& b) { return a.timestamp_ns < b.timestamp_ns; });
+
+    size_t estimate = sizeof(FrameHeader) + batch_.size() * sizeof(Entry);
+    if (fd_ >= 0 && segment_size_ > sizeof(SegmentHeader) && segment_size_ + estimate > options_.segment_bytes) {
+        close_segment();
+    }
+    if (fd_ < 0 && !open_segment()) return false;
+
+    // Name each symbol the first time this segment sees it
+    SymbolRegistry& registry = SymbolRegistry::global();
+    frame_.assign(sizeof(FrameHeader), 0);
+    uint32_t define_count = 0;
+    uint64_t max_timestamp = 0;
+    for (const Entry& entry : batch_) {
+        max_timestamp = std::max(max_timestamp, entry.timestamp_ns);
+        if (entry.symbol >= defined_.size()) defined_.resize(entry.symbol + 1, false);
+        if (defined_[entry.symbol]) continue;
+        defined_[entry.symbol] = true;
+        const std::string& name = registry.name(entry.symbol);
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(name.size(), UINT16_MAX));
+        size_t at = frame_.size();
+        frame_.resize(at + sizeof(uint32_t) + sizeof(uint16_t) + length);
+        std::memcpy(frame_.data() + at, &entry.symbol, sizeof(uint32_t));
+        std::memcpy(frame_.data() + at + sizeof(uint32_t), &length, sizeof(length));
+        std::memcpy(frame_.data() + at + sizeof(uint32_t) + sizeof(uint16_t), name.data(), length);
+        ++define_count;
+    }
+    frame_.resize((frame_.size() + 7) & ~size_t(7), 0);
+    uint32_t define_bytes = static_cast<uint32_t>(frame_.size() - sizeof(FrameHeader));
+    size_t at = frame_.size();
+    frame_.resize(at + batch_.size() * sizeof(Entry));
+    std::memcpy(frame_.data() + at, batch_.data(), batch_.size() * sizeof(Entry));
+
+    FrameHeader header{FRAME_MAGIC, static_cast<uint32_t>(batch_.size()), define_count, define_bytes,
+                       checksum(CHECKSUM_SEED, frame_.data() + sizeof(FrameHeader), frame_.size() - sizeof(FrameHeader)),
+                       max_timestamp};
+    std::memcpy(frame_.data(), &header, sizeof(header));
+
+    if (!write_all(fd_, frame_.data(), frame_.size())) {
+        // Whatever reached the file is cut off by its checksum on replay
+        close_segment();
+        return false;
+    }
+    segment_size_ += frame_.size();
+    bytes_.fetch_add(frame_.size(), std::memory_order_relaxed);
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    entries_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    batch_.clear();
+
+    bool ok = true;
+    ++frames_since_sync_;
+    if (force_sync || (options_.fsync_batch && frames_since_sync_ >= options_.fsync_batch)) {
+        ok = ::fdatasync(fd_) == 0;
+        frames_since_sync_ = 0;
+        fsyncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+std::string WriteAheadLog::segment_path(uint64_t seq) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "wal-%016" PRIu64 ".log", seq);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+bool WriteAheadLog::open_segment() {
+    uint64_t seq = segment_seq_.load() + 1;
+    int fd = ::open(segment_path(seq).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    SegmentHeader header{SEGMENT_MAGIC, WAL_VERSION, seq, {0, 0}};
+    if (!write_all(fd, reinterpret_cast<const uint8_t*>(&header), sizeof(header))) {
+        ::close(fd);
+        return false;
+    }
+    // Make the new name itself durable
+    int dir = ::open(directory_.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir >= 0) {
+        ::fsync(dir);
+        ::close(dir);
+    }
+    fd_ = fd;
+    segment_seq_.store(seq);
+    segment_size_ = sizeof(header);
+    frames_since_sync_ = 0;
+    defined_.clear();
+    segments_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void WriteAheadLog::close_segment() {
+    if (fd_ < 0) return;
+    if (frames_since_sync_) {
+        ::fdatasync(fd_);
+        fsyncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    ::close(fd_);
+    fd_ = -1;
+    frames_since_sync_ = 0;
+}
+
+std::vector<std::pair<uint64_t, std::string>> WriteAheadLog::list_segments(const std::string& directory) {
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        uint64_t seq = 0;
+        std::string name = entry.path().filename().string();
+        if (std::sscanf(name.c_str(), "wal-%" SCNu64 ".log", &seq) == 1) segments.emplace_back(seq, entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+size_t WriteAheadLog::truncate_before(uint64_t timestamp) {
+    size_t removed = 0;
+    // A stale read only keeps more; the flusher never reopens an older segment
+    uint64_t active = segment_seq_.load();
+    for (const auto& [seq, path] : list_segments(directory_)) {
+        if (seq >= active) break;
+        std::ifstream file(path, std::ios::binary);
+        SegmentHeader segment;
+        if (!file.read(reinterpret_cast<char*>(&segment), sizeof(segment)) || segment.magic != SEGMENT_MAGIC) continue;
+        uint64_t newest = 0;
+        FrameHeader frame;
+        while (file.read(reinterpret_cast<char*>(&frame), sizeof(frame)) && frame.magic == FRAME_MAGIC) {
+            newest = std::max(newest, frame.max_timestamp);
+            file.seekg(frame.define_bytes + static_cast<std::streamoff>(frame.entry_count) * sizeof(Entry),
+                       std::ios::cur);
+        }
+        if (newest <= timestamp) {
+            std::error_code error;
+            removed += std::filesystem::remove(path, error);
+        }
+    }
+    return removed;
+}
+
+WriteAheadLog::Stats WriteAheadLog::stats() const {
+    Stats stats;
+    stats.entries = entries_.load(std::memory_order_relaxed);
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.fsyncs = fsyncs_.load(std::memory_order_relaxed);
+    stats.bytes = bytes_.load(std::memory_order_relaxed);
+    stats.segments = segments_.load(std::memory_order_relaxed);
+    stats.producer_waits = producer_waits_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t WriteAheadLog::replay(const std::string& directory, uint64_t after, uint64_t until,
+                             const std::function<void(const Entry&)>& fn) {
+    SymbolRegistry& registry = SymbolRegistry::global();
+    size_t replayed = 0;
+    std::vector<uint8_t> data;
+    std::vector<SymbolId> symbols;
+    for (const auto& [seq, path] : list_segments(directory)) {
+        if (!read_file(path, data) || data.size() < sizeof(SegmentHeader)) continue;
+        SegmentHeader segment;
+        std::memcpy(&segment, data.data(), sizeof(segment));
+        if (segment.magic != SEGMENT_MAGIC || segment.version != WAL_VERSION) continue;
+
+        symbols.clear();
+        size_t offset = sizeof(SegmentHeader);
+        while (offset + sizeof(FrameHeader) <= data.size()) {
+            FrameHeader frame;
+            std::memcpy(&frame, data.data() + offset, sizeof(frame));
+            size_t body = frame.define_bytes + size_t(frame.entry_count) * sizeof(Entry);
+            if (frame.magic != FRAME_MAGIC || offset + sizeof(frame) + body > data.size()) break;
+            const uint8_t* cursor = data.data() + offset + sizeof(frame);
+            if (frame.checksum != checksum(CHECKSUM_SEED, cursor, body)) break;  // torn tail
+            offset += sizeof(frame) + body;
+
+            const uint8_t* defines_end = cursor + frame.define_bytes;
+            for (uint32_t i = 0; i < frame.define_count && cursor + 6 <= defines_end; ++i) {
+                uint32_t id;
+                uint16_t length;
+                std::memcpy(&id, cursor, sizeof(id));
+                std::memcpy(&length, cursor + sizeof(id), sizeof(length));
+                cursor += sizeof(id) + sizeof(length);
+                if (cursor + length > defines_end) break;
+                if (id >= symbols.size()) symbols.resize(id + 1, INVALID_SYMBOL_ID);
+                symbols[id] = registry.intern(std::string(reinterpret_cast<const char*>(cursor), length));
+                cursor += length;
+            }
+            if (frame.max_timestamp <= after) continue;
+
+            cursor = defines_end;
+            for (uint32_t i = 0; i < frame.entry_count; ++i, cursor += sizeof(Entry)) {
+                Entry entry;
+                std::memcpy(&entry, cursor, sizeof(entry));
+                if (entry.timestamp_ns <= after || entry.timestamp_ns > until) continue;
+                if (entry.symbol >= symbols.size() || symbols[entry.symbol] == INVALID_SYMBOL_ID) continue;
+                entry.symbol = symbols[entry.symbol];
+                fn(entry);
+                ++replayed;
+            }
+        }
+    }
+    return replayed;
+}
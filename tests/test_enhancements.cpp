@@ -47,11 +47,9 @@ TEST_F(EnhancementTest, MultiLevelCacheBasicOperations) {
     EXPECT_EQ(result->priority, 2);
     EXPECT_EQ(result->value, 151.25);
     
-    // Test remove
+    // Test remove; the read above already consumed 151.25
     EXPECT_TRUE(cache.remove("AAPL", 150.75));
-    result = cache.get_highest_priority("AAPL");
-    EXPECT_NE(result, nullptr);
-    EXPECT_EQ(result->value, 151.25);
+    EXPECT_EQ(cache.get_highest_priority("AAPL"), nullptr);
 }
 
 TEST_F(EnhancementTest, MultiLevelCacheLevelPromotion) {
@@ -94,7 +92,7 @@ TEST_F(EnhancementTest, MultiLevelCacheConcurrentAccess) {
                 Node* result = cache.get_highest_priority(symbol);
                 if (result) {
                     // Verify data integrity
-                    EXPECT_EQ(result->symbol, symbol);
+                    EXPECT_EQ(result->symbol, SymbolRegistry::global().find(symbol));
                 }
             }
         });
@@ -196,12 +194,12 @@ TEST_F(EnhancementTest, SkipListBasicOperations) {
     // Create test nodes
     Node* node1 = new Node();
     node1->value = 150.75;
-    node1->symbol = "AAPL";
+    node1->symbol = SymbolRegistry::global().intern("AAPL");
     node1->priority = 1;
     
     Node* node2 = new Node();
     node2->value = 151.25;
-    node2->symbol = "AAPL";
+    node2->symbol = SymbolRegistry::global().intern("AAPL");
     node2->priority = 2;
     
     // Test insert
@@ -231,9 +229,9 @@ TEST_F(EnhancementTest, SkipListRangeQueries) {
     for (int i = 0; i < 100; ++i) {
         Node* node = new Node();
         node->value = 100.0 + i;
-        node->symbol = "TEST";
+        node->symbol = SymbolRegistry::global().intern("TEST");
         node->priority = i % 10;
-        node->timestamp = i;
+        node->timestamp_ns = i;
         skip_list.insert(node);
     }
     
@@ -255,7 +253,7 @@ TEST_F(EnhancementTest, SkipListStatistics) {
     for (int i = 0; i < 1000; ++i) {
         Node* node = new Node();
         node->value = 100.0 + i;
-        node->symbol = "TEST";
+        node->symbol = SymbolRegistry::global().intern("TEST");
         node->priority = i % 10;
         skip_list.insert(node);
     }
@@ -272,12 +270,12 @@ TEST_F(EnhancementTest, BTreeBasicOperations) {
     // Create test nodes
     Node* node1 = new Node();
     node1->value = 150.75;
-    node1->symbol = "AAPL";
+    node1->symbol = SymbolRegistry::global().intern("AAPL");
     node1->priority = 1;
     
     Node* node2 = new Node();
     node2->value = 151.25;
-    node2->symbol = "AAPL";
+    node2->symbol = SymbolRegistry::global().intern("AAPL");
     node2->priority = 2;
     
     // Test insert
@@ -302,9 +300,9 @@ TEST_F(EnhancementTest, BTreeRangeQueries) {
     for (int i = 0; i < 100; ++i) {
         Node* node = new Node();
         node->value = 100.0 + i;
-        node->symbol = "TEST";
+        node->symbol = SymbolRegistry::global().intern("TEST");
         node->priority = i % 10;
-        node->timestamp = i;
+        node->timestamp_ns = i;
         b_tree.insert(node);
     }
     
@@ -326,9 +324,9 @@ TEST_F(EnhancementTest, BTreeSortedOperations) {
     for (int i = 0; i < 50; ++i) {
         Node* node = new Node();
         node->value = 200.0 - i; // Decreasing values
-        node->symbol = "TEST";
+        node->symbol = SymbolRegistry::global().intern("TEST");
         node->priority = i % 10;
-        node->timestamp = i;
+        node->timestamp_ns = i;
         b_tree.insert(node);
     }
     
@@ -488,7 +486,7 @@ TEST_F(EnhancementTest, SkipListPerformance) {
     for (int i = 0; i < num_operations; ++i) {
         Node* node = new Node();
         node->value = 100.0 + i;
-        node->symbol = "PERF";
+        node->symbol = SymbolRegistry::global().intern("PERF");
         node->priority = i % 10;
         skip_list.insert(node);
     }
@@ -509,7 +507,7 @@ TEST_F(EnhancementTest, BTreePerformance) {
     for (int i = 0; i < num_operations; ++i) {
         Node* node = new Node();
         node->value = 100.0 + i;
-        node->symbol = "PERF";
+        node->symbol = SymbolRegistry::global().intern("PERF");
         node->priority = i % 10;
         b_tree.insert(node);
     }
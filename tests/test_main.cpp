@@ -1,15 +1,40 @@
 #include "../include/radial_circular_list.hpp"
+#include "../include/sharded_radial_circular_list.hpp"
+#include "../include/epoch_reclamation.hpp"
+#include "../include/simd_operations.hpp"
+#include "../include/advanced_operations.hpp"
+#include "../include/hot_tier.hpp"
+#include "../include/multi_level_cache.hpp"
+#include "../include/segment_store.hpp"
+#include "../include/persistent_cache.hpp"
+#include "../include/column_codec.hpp"
+#include "../include/advanced_memory_pool.hpp"
+#include "../include/b_tree.hpp"
+#include "../include/skip_list.hpp"
+#include "../include/bloom_filter.hpp"
 #include "../include/config.hpp"
 #include "../include/memory_manager.hpp"
 #include "../include/metrics.hpp"
+#include "../include/metrics_region.hpp"
+#include "../include/shared_radial_list.hpp"
 #include "../include/error_handler.hpp"
+#include "../include/security_manager.hpp"
+#include "../include/benchmark_suite.hpp"
 #include <gtest/gtest.h>
 #include <thread>
 #include <vector>
 #include <random>
+#include <algorithm>
 #include <chrono>
 #include <atomic>
 #include <future>
+#include <limits>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <unordered_set>
+#include <sys/wait.h>
+#include <unistd.h>
 
 class HFTCacheTest : public ::testing::Test {
 protected:
@@ -43,6 +68,7 @@ protected:
 TEST_F(HFTCacheTest, BasicInsertAndRetrieve) {
     EXPECT_TRUE(cache_->insert(150.75, "AAPL", 1, 60.0));
     
+    EpochGuard guard;
     Node* result = cache_->get_highest_priority("AAPL");
     EXPECT_NE(result, nullptr);
     EXPECT_DOUBLE_EQ(result->value, 150.75);
@@ -54,6 +80,7 @@ TEST_F(HFTCacheTest, PriorityOrdering) {
     cache_->insert(151.00, "AAPL", 3, 60.0);
     cache_->insert(150.50, "AAPL", 2, 60.0);
     
+    EpochGuard guard;
     Node* result = cache_->get_highest_priority("AAPL");
     EXPECT_NE(result, nullptr);
     EXPECT_EQ(result->priority, 3);  // Highest priority should be returned first
@@ -68,6 +95,272 @@ TEST_F(HFTCacheTest, ExpiryHandling) {
     EXPECT_EQ(result, nullptr);  // Should be expired
 }
 
+TEST_F(HFTCacheTest, CompactNodeDeadline) {
+    static_assert(sizeof(Node) == 32 || sizeof(Node) == 64, "Node is packed or line-sized");
+
+    uint64_t before = CoarseClock::now();
+    Node node(1.0, 5, 0.005);  // 5ms time-to-live
+    uint64_t after = CoarseClock::now();
+    EXPECT_LE(before, node.timestamp_ns);
+    EXPECT_LE(node.timestamp_ns, after);
+    EXPECT_EQ(node.deadline_ns, node.timestamp_ns + 5'000'000);
+
+    EXPECT_FALSE(node.is_expired(node.deadline_ns));
+    EXPECT_TRUE(node.is_expired(node.deadline_ns + 1));
+    EXPECT_FALSE(node.is_expired());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(node.is_expired());
+
+    // The clock must track real time closely enough for millisecond TTLs
+    uint64_t start = CoarseClock::now();
+    auto wall_start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    double elapsed_ms = (CoarseClock::now() - start) / 1e6;
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    std::cout << "CoarseClock (" << (CoarseClock::uses_tsc() ? "tsc" : "steady_clock") << "): "
+              << elapsed_ms << " ms vs " << wall_ms << " ms" << std::endl;
+    EXPECT_NEAR(elapsed_ms, wall_ms, 2.0);
+}
+
+TEST_F(HFTCacheTest, TimerWheelFiresAfterDeadline) {
+    const uint64_t start = uint64_t(1) << 40;
+    const uint64_t ms = 1'000'000;
+    TimerWheel wheel(start);
+    std::vector<TimerWheel::Entry> due;
+
+    // One deadline per level, plus one past the top level
+    std::vector<uint64_t> offsets = {3 * ms, 200 * ms, 30'000 * ms, 3'600'000 * ms, 7 * 3'600'000 * ms};
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        wheel.schedule(static_cast<SymbolId>(i), start + offsets[i], due);
+    }
+    EXPECT_TRUE(due.empty());
+    EXPECT_EQ(wheel.size(), offsets.size());
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        wheel.advance(start + offsets[i], due);
+        EXPECT_EQ(due.size(), i) << "entry " << i << " fired before its deadline";
+        wheel.advance(start + offsets[i] + 2 * (ms + ms / 20), due);
+        ASSERT_EQ(due.size(), i + 1) << "entry " << i << " did not fire";
+        EXPECT_EQ(due.back().symbol, static_cast<SymbolId>(i));
+    }
+    EXPECT_TRUE(wheel.empty());
+
+    // Deadlines already behind the wheel come straight back
+    wheel.schedule(99, start, due);
+    EXPECT_EQ(due.back().symbol, 99u);
+}
+
+TEST_F(HFTCacheTest, ExpiryEngineSweepsWithinBudget) {
+    // Heaps hold max_nodes / 10 = 100 nodes each
+    std::vector<std::string> symbols;
+    for (size_t s = 0; s < 10; ++s) symbols.push_back("SWEEP" + std::to_string(s));
+
+    for (size_t s = 0; s < 3; ++s) {
+        for (int i = 0; i < 100; ++i) ASSERT_TRUE(cache_->insert(100.0 + i, symbols[s], i, 0.002));
+    }
+    for (int i = 0; i < 10; ++i) ASSERT_TRUE(cache_->insert(200.0 + i, "SWEEP_LONG", i, 60.0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // Every pass stays within its budget and nothing survives the sweep
+    ExpiryEngine& engine = cache_->expiry_engine();
+    size_t total = 0;
+    for (int pass = 0; pass < 10; ++pass) {
+        size_t purged = engine.run(CoarseClock::now(), 64);
+        EXPECT_LE(purged, 64u);
+        total += purged;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(total, 300u);
+    EXPECT_EQ(engine.total_expired(), 300u);
+
+    // Purged slots went back to the pool without anyone popping them
+    for (size_t s = 0; s < 9; ++s) {
+        for (int i = 0; i < 99; ++i) ASSERT_TRUE(cache_->insert(1.0, symbols[s + 1], i, 60.0));
+    }
+    {
+        EpochGuard guard;
+        Node* kept = cache_->get_highest_priority("SWEEP_LONG");
+        ASSERT_NE(kept, nullptr);
+        EXPECT_EQ(kept->priority, 9);
+    }
+
+    // The cleanup thread drives the same engine
+    CacheConfig config = config_;
+    config.cleanup_interval_ms = 5;
+    MemoryManager manager(config);
+    auto other = std::make_unique<RadialCircularList>(config_);
+    manager.register_expiry_engine(&other->expiry_engine());
+    for (int i = 0; i < 50; ++i) other->insert(1.0, "SWEEP_MANAGED", i, 0.001);
+    for (int wait = 0; wait < 200 && manager.get_metrics().expired_purged < 50; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    manager.unregister_expiry_engine(&other->expiry_engine());
+    EXPECT_EQ(manager.get_metrics().expired_purged, 50u);
+}
+
+TEST_F(HFTCacheTest, NodeSlotsAreRecycled) {
+    // Each symbol's heap holds max_nodes / 10, so ten symbols fill the pool
+    std::vector<std::string> symbols;
+    for (size_t s = 0; s < 10; ++s) {
+        symbols.push_back("RECYCLE" + std::to_string(s));
+    }
+
+    // Many times more inserts than slots: every popped or expired node must come back
+    const size_t rounds = 50;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < config_.max_nodes; ++i) {
+            ASSERT_TRUE(cache_->insert(100.0 + i, symbols[i % 10], static_cast<int>(i % 7), 60.0));
+        }
+        EXPECT_FALSE(cache_->insert(1.0, "OVERFLOW", 0, 60.0));  // pool is exhausted
+        for (const auto& symbol : symbols) {
+            while (cache_->get_highest_priority(symbol) != nullptr) {
+                // popped nodes are retired back to the pool automatically
+            }
+        }
+    }
+
+    // Expired nodes are reclaimed when a pop skips over them
+    for (size_t i = 0; i < config_.max_nodes; ++i) {
+        ASSERT_TRUE(cache_->insert(100.0 + i, symbols[i % 10], 1, 0.001));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (const auto& symbol : symbols) {
+        EXPECT_EQ(cache_->get_highest_priority(symbol), nullptr);
+    }
+    for (size_t i = 0; i < config_.max_nodes; ++i) {
+        EXPECT_TRUE(cache_->insert(100.0 + i, symbols[i % 10], 1, 60.0));
+    }
+
+    CacheConfig sharded = config_;
+    sharded.list_shards = 1;
+    ShardedRadialCircularList sharded_cache(sharded);
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < sharded.max_nodes; ++i) {
+            ASSERT_TRUE(sharded_cache.insert(100.0 + i, symbols[i % 10], static_cast<int>(i % 7), 60.0));
+        }
+        for (const auto& symbol : symbols) {
+            while (Node* node = sharded_cache.get_highest_priority(symbol)) {
+                sharded_cache.release(node);
+            }
+        }
+    }
+    EXPECT_EQ(sharded_cache.size(), 0u);
+}
+
+TEST_F(HFTCacheTest, EpochGuardDefersSlotReuse) {
+    std::vector<std::string> symbols;
+    for (size_t s = 0; s < 10; ++s) {
+        symbols.push_back("EPOCH" + std::to_string(s));
+    }
+    for (size_t i = 0; i < config_.max_nodes; ++i) {
+        ASSERT_TRUE(cache_->insert(100.0 + i, symbols[i % 10], 1, 60.0));
+    }
+
+    {
+        EpochGuard guard;
+        std::vector<Node*> popped;
+        for (const auto& symbol : symbols) {
+            while (Node* node = cache_->get_highest_priority(symbol)) {
+                popped.push_back(node);
+            }
+        }
+        ASSERT_EQ(popped.size(), config_.max_nodes);
+
+        // Every slot is retired but still visible to this guard, so none may be reused
+        EXPECT_FALSE(cache_->insert(-1.0, symbols[0], 1, 60.0));
+        for (Node* node : popped) {
+            EXPECT_GE(node->value, 100.0);
+        }
+    }
+
+    EXPECT_TRUE(cache_->insert(-1.0, symbols[0], 1, 60.0));
+}
+
+TEST_F(HFTCacheTest, EpochRetireWaitsForReaders) {
+    static std::atomic<int> freed{0};
+    freed.store(0);
+    struct Tracked {
+        ~Tracked() { freed.fetch_add(1); }
+    };
+
+    std::atomic<bool> reader_in{false};
+    std::atomic<bool> reader_exit{false};
+    std::thread reader([&]() {
+        EpochGuard guard;
+        reader_in.store(true);
+        while (!reader_exit.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!reader_in.load()) {
+        std::this_thread::yield();
+    }
+
+    EpochManager& epochs = EpochManager::global();
+    const int retired = static_cast<int>(EpochManager::COLLECT_THRESHOLD) * 4;
+    for (int i = 0; i < retired; ++i) {
+        epochs.retire(new Tracked());
+    }
+    epochs.collect();
+    EXPECT_EQ(freed.load(), 0);  // the reader's guard pins everything retired after it entered
+
+    reader_exit.store(true);
+    reader.join();
+    epochs.collect();
+    epochs.collect();
+    EXPECT_EQ(freed.load(), retired);
+}
+
+TEST_F(HFTCacheTest, SymbolTableGrowsPastInitialCapacity) {
+    // Past both the global registry's initial 1024 and one chunk of the
+    // cache's midpoint map
+    CacheConfig config = config_;
+    config.max_nodes = 5000;
+    RadialCircularList cache(config);
+
+    const size_t num_symbols = 3000;
+    for (size_t i = 0; i < num_symbols; ++i) {
+        EXPECT_TRUE(cache.insert(100.0 + i, "SYM" + std::to_string(i), 1, 60.0));
+    }
+
+    EpochGuard guard;
+    for (size_t i = 0; i < num_symbols; ++i) {
+        Node* result = cache.get_highest_priority("SYM" + std::to_string(i));
+        ASSERT_NE(result, nullptr);
+        EXPECT_DOUBLE_EQ(result->value, 100.0 + i);
+    }
+    EXPECT_EQ(cache.get_highest_priority("UNKNOWN"), nullptr);
+}
+
+TEST_F(HFTCacheTest, InternedSymbolIds) {
+    SymbolRegistry registry(16);
+    SymbolId aapl = registry.intern("AAPL");
+    EXPECT_EQ(registry.intern("AAPL"), aapl);
+    EXPECT_EQ(registry.find("MSFT"), INVALID_SYMBOL_ID);
+
+    for (size_t i = 0; i < 500; ++i) {
+        std::string name = "SYM" + std::to_string(i);
+        SymbolId id = registry.intern(name);
+        EXPECT_EQ(id, aapl + 1 + i);  // ids are dense and assigned in order
+        EXPECT_EQ(registry.name(id), name);
+    }
+    EXPECT_EQ(registry.size(), 501u);
+
+    // The id and string overloads address the same midpoint
+    SymbolId goog = SymbolRegistry::global().intern("GOOG");
+    EXPECT_TRUE(cache_->insert(2800.0, goog, 2, 60.0));
+    EpochGuard guard;
+    Node* result = cache_->get_highest_priority("GOOG");
+    ASSERT_NE(result, nullptr);
+    EXPECT_DOUBLE_EQ(result->value, 2800.0);
+    EXPECT_EQ(result->symbol, goog);
+
+    EXPECT_TRUE(cache_->insert(2801.0, "GOOG", 1, 60.0));
+    result = cache_->get_highest_priority(goog);
+    ASSERT_NE(result, nullptr);
+    EXPECT_DOUBLE_EQ(result->value, 2801.0);
+}
+
 // Concurrent access tests
 TEST_F(HFTCacheTest, ConcurrentInserts) {
     const size_t num_threads = 8;
@@ -160,6 +453,2094 @@ TEST_F(HFTCacheTest, ConcurrentInsertsAndRetrieves) {
     EXPECT_GT(successful_operations.load(), 0);
 }
 
+TEST_F(HFTCacheTest, ShardedPriorityQueueOrdering) {
+    CacheConfig sharded = config_;
+    sharded.max_nodes = 40000;
+    sharded.priority_queue_shards = 8;
+    RadialCircularList cache(sharded);
+
+    const size_t num_threads = 4;
+    const size_t inserts_per_thread = 1000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 gen(static_cast<unsigned>(t));
+            std::uniform_int_distribution<> priority_dist(0, 1000);
+            for (size_t i = 0; i < inserts_per_thread; ++i) {
+                EXPECT_TRUE(cache.insert(100.0 + i, "AAPL", priority_dist(gen), 60.0));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // With writers quiesced every pop must return the global maximum
+    size_t popped = 0;
+    int last_priority = std::numeric_limits<int>::max();
+    while (Node* node = cache.get_highest_priority("AAPL")) {
+        EXPECT_LE(node->priority, last_priority);
+        last_priority = node->priority;
+        ++popped;
+    }
+    EXPECT_EQ(popped, num_threads * inserts_per_thread);
+}
+
+TEST_F(HFTCacheTest, ShardedListSingleWriterPerShard) {
+    CacheConfig sharded = config_;
+    sharded.max_nodes = 40000;
+    sharded.list_shards = 4;
+    ShardedRadialCircularList cache(sharded);
+
+    std::vector<SymbolId> ids;
+    for (size_t i = 0; i < 32; ++i) {
+        ids.push_back(SymbolRegistry::global().intern("SHARD" + std::to_string(i)));
+    }
+
+    // One writer per shard inserting only the symbols routed to it, while
+    // readers poll every symbol's top through the seqlock
+    const int inserts_per_symbol = 200;
+    std::atomic<bool> writers_done{false};
+    std::atomic<size_t> bad_peeks{0};
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            Node top;
+            while (!writers_done.load()) {
+                for (SymbolId id : ids) {
+                    if (cache.peek_highest_priority(id, top) &&
+                        (top.symbol != id || top.priority >= inserts_per_symbol)) {
+                        bad_peeks.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (size_t shard = 0; shard < cache.num_shards(); ++shard) {
+        writers.emplace_back([&, shard]() {
+            for (int p = 0; p < inserts_per_symbol; ++p) {
+                for (SymbolId id : ids) {
+                    if (cache.shard_of(id) == shard) {
+                        EXPECT_TRUE(cache.insert(100.0 + p, id, p, 60.0));
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    writers_done.store(true);
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(bad_peeks.load(), 0u);
+    EXPECT_EQ(cache.size(), ids.size() * inserts_per_symbol);
+
+    Node top;
+    ASSERT_TRUE(cache.peek_highest_priority("SHARD0", top));
+    EXPECT_EQ(top.priority, inserts_per_symbol - 1);
+    for (int p = inserts_per_symbol - 1; p >= 0; --p) {
+        Node* node = cache.get_highest_priority(ids[0]);
+        ASSERT_NE(node, nullptr);
+        EXPECT_EQ(node->priority, p);
+    }
+    EXPECT_EQ(cache.get_highest_priority(ids[0]), nullptr);
+    EXPECT_FALSE(cache.peek_highest_priority(ids[0], top));
+}
+
+TEST_F(HFTCacheTest, SIMDKernelsMatchScalar) {
+    using namespace hft_cache;
+    const SIMDKernels& scalar = simd_kernels(SIMDLevel::SCALAR);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int32_t> priority(-50, 50);
+    std::uniform_real_distribution<double> price(90.0, 110.0);
+
+    for (SIMDLevel level : {SIMDLevel::AVX2, SIMDLevel::AVX512}) {
+        const SIMDKernels& kernels = simd_kernels(level);
+        // Sizes around every vector width so the scalar tails are exercised
+        for (size_t n : {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 100, 1001}) {
+            std::vector<uint64_t> deadlines(n);
+            std::vector<double> values(n);
+            std::vector<int32_t> priorities(n);
+            std::vector<Node*> nodes(n);
+            for (size_t i = 0; i < n; ++i) {
+                deadlines[i] = 1'000'000 + rng() % 2'000;
+                values[i] = price(rng);
+                priorities[i] = priority(rng);
+                nodes[i] = reinterpret_cast<Node*>(uintptr_t(0x1000) + 64 * i);
+            }
+            std::vector<uint32_t> expected(n + 1), actual(n + 1);
+            auto same = [&](size_t a, size_t b) {
+                return a == b && std::equal(expected.begin(), expected.begin() + a, actual.begin());
+            };
+
+            EXPECT_TRUE(same(scalar.select_expired(deadlines.data(), n, 1'001'000, expected.data()),
+                             kernels.select_expired(deadlines.data(), n, 1'001'000, actual.data())));
+            EXPECT_TRUE(same(scalar.select_value_range(values.data(), n, 95.0, 100.0, expected.data()),
+                             kernels.select_value_range(values.data(), n, 95.0, 100.0, actual.data())));
+            EXPECT_TRUE(same(scalar.select_priority_range(priorities.data(), n, -10, 10, expected.data()),
+                             kernels.select_priority_range(priorities.data(), n, -10, 10, actual.data())));
+            EXPECT_EQ(scalar.argmax_priority(priorities.data(), n), kernels.argmax_priority(priorities.data(), n));
+
+            const void* const* slots = reinterpret_cast<const void* const*>(nodes.data());
+            const void* key = n ? nodes[n - 1] : nullptr;
+            EXPECT_EQ(scalar.find_pointer(slots, n, key), kernels.find_pointer(slots, n, key));
+            EXPECT_EQ(kernels.find_pointer(slots, n, &rng), n);
+        }
+    }
+}
+
+TEST_F(HFTCacheTest, SIMDCacheColumnStore) {
+    using namespace hft_cache;
+    SIMDCache simd(config_);
+    std::cout << "SIMD tier: " << simd_level_name(simd.operations().level()) << std::endl;
+
+    for (int i = 0; i < 100; ++i) ASSERT_TRUE(simd.insert(100.0 + i, "SIMD_A", (i * 37) % 100, 60.0));
+    for (int i = 0; i < 20; ++i) ASSERT_TRUE(simd.insert(500.0 + i, "SIMD_B", i, 0.001));
+    EXPECT_EQ(simd.size(), 120u);
+
+    // Range filters see exactly the matching entries
+    auto in_range = simd.operations().vectorized_search_by_value_range(110.0, 119.0);
+    EXPECT_EQ(in_range.size(), 10u);
+    auto top_band = simd.operations().vectorized_search_by_priority_range(90, 99);
+    EXPECT_EQ(top_band.size(), 10u);
+
+    // Priority updates move an entry to the front
+    Node* target = simd.get_batch({{"SIMD_A", 150.0}}).front();
+    ASSERT_NE(target, nullptr);
+    EXPECT_EQ(simd.operations().vectorized_priority_update({{target, 1000}}), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(simd.expire(), 20u);
+    EXPECT_EQ(simd.size(), 100u);
+    EXPECT_EQ(simd.get_highest_priority("SIMD_B"), nullptr);
+
+    EXPECT_TRUE(simd.remove("SIMD_A", 101.0));
+    EXPECT_FALSE(simd.remove("SIMD_A", 101.0));
+
+    EpochGuard guard;
+    Node* first = simd.get_highest_priority("SIMD_A");
+    ASSERT_NE(first, nullptr);
+    EXPECT_DOUBLE_EQ(first->value, 150.0);
+    int previous = 1000;
+    while (Node* node = simd.get_highest_priority("SIMD_A")) {
+        EXPECT_LE(node->priority, previous);
+        previous = node->priority;
+    }
+    EXPECT_EQ(simd.size(), 0u);
+}
+
+TEST_F(HFTCacheTest, IncrementalSymbolAggregates) {
+    AggregationOperations agg(*cache_);
+
+    // 1..99 with priority equal to the value; the exact median is 50
+    for (int i = 1; i <= 99; ++i) ASSERT_TRUE(cache_->insert(static_cast<double>(i), "AGG_A", i));
+    SymbolSummary summary = agg.summary("AGG_A");
+    EXPECT_EQ(summary.count, 99u);
+    EXPECT_DOUBLE_EQ(summary.sum, 4950.0);
+    EXPECT_NEAR(summary.average, 50.0, 1e-9);
+    EXPECT_NEAR(summary.std_deviation, std::sqrt(99.0 * 100.0 / 12.0), 1e-9);
+    EXPECT_NEAR(summary.median, 50.0, 50.0 * 0.01);
+    EXPECT_DOUBLE_EQ(summary.min_value, 1.0);
+    EXPECT_DOUBLE_EQ(summary.max_value, 99.0);
+    EXPECT_TRUE(summary.min_exact);
+    EXPECT_TRUE(summary.max_exact);
+    // sum(i * (i + 1)) / sum(i + 1)
+    EXPECT_NEAR(summary.weighted_average, 333300.0 / 5049.0, 1e-9);
+
+    // Popping takes the top priority, which is also the maximum
+    {
+        EpochGuard guard;
+        Node* top = cache_->get_highest_priority("AGG_A");
+        ASSERT_NE(top, nullptr);
+        EXPECT_DOUBLE_EQ(top->value, 99.0);
+    }
+    summary = agg.summary("AGG_A");
+    EXPECT_EQ(summary.count, 98u);
+    EXPECT_NEAR(summary.average, 49.5, 1e-9);
+    EXPECT_NEAR(summary.max_value, 98.0, 98.0 * 0.01);
+    EXPECT_FALSE(summary.max_exact);
+    EXPECT_TRUE(summary.min_exact);
+
+    // Expired nodes leave the aggregates when the sweep removes them
+    ASSERT_TRUE(cache_->insert(1000.0, "AGG_A", 0, 0.001));
+    EXPECT_EQ(agg.get_count("AGG_A"), 99u);
+    EXPECT_TRUE(agg.summary("AGG_A").max_exact);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(cache_->expiry_engine().run(CoarseClock::now(), 100), 1u);
+    EXPECT_EQ(agg.get_count("AGG_A"), 98u);
+    EXPECT_NEAR(agg.get_average_value("AGG_A"), 49.5, 1e-9);
+
+    // Draining resets the symbol exactly
+    {
+        EpochGuard guard;
+        while (cache_->get_highest_priority("AGG_A")) {}
+    }
+    summary = agg.summary("AGG_A");
+    EXPECT_EQ(summary.count, 0u);
+    EXPECT_EQ(summary.sum, 0.0);
+    EXPECT_EQ(summary.std_deviation, 0.0);
+    EXPECT_EQ(agg.summary("AGG_UNKNOWN").count, 0u);
+}
+
+TEST_F(HFTCacheTest, AggregatesFollowPersistentRestore) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_agg_restore_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    AggregationOperations agg(*cache_);
+
+    config_.enable_wal = true;
+    {
+        PersistentCache persistent(*cache_, config_, dir.string());
+        for (int i = 1; i <= 10; ++i) ASSERT_TRUE(cache_->insert(static_cast<double>(i), "AGG_RESTORE", i, 60.0));
+        ASSERT_TRUE(persistent.checkpoint_to_disk("agg.dat"));
+        ASSERT_TRUE(persistent.wait_for_checkpoint());
+
+        for (int i = 11; i <= 15; ++i) ASSERT_TRUE(cache_->insert(static_cast<double>(i), "AGG_RESTORE", i, 60.0));
+        EXPECT_EQ(agg.get_count("AGG_RESTORE"), 15u);
+
+        // The restore clears the cache and reloads it, all seen by agg
+        ASSERT_TRUE(persistent.restore_from_disk((dir / "agg.dat").string()));
+        SymbolSummary summary = agg.summary("AGG_RESTORE");
+        EXPECT_EQ(summary.count, 10u);
+        EXPECT_DOUBLE_EQ(summary.sum, 55.0);
+    }
+
+    // Dropping the PersistentCache leaves agg attached
+    ASSERT_TRUE(cache_->insert(100.0, "AGG_RESTORE", 100, 60.0));
+    EXPECT_EQ(agg.get_count("AGG_RESTORE"), 11u);
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, SymbolSearchAndActivity) {
+    AdvancedCacheOperations ops(*cache_);
+
+    for (int i = 0; i < 6; ++i) ASSERT_TRUE(cache_->insert(100.0 + i, "SRCH_ALPHA", i));
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(cache_->insert(10.0 * (i + 1), "SRCH_ALPHB", 10 + i));
+    ASSERT_TRUE(cache_->insert(7.0, "SRCH_OTHER", 1));
+
+    std::vector<Node> matched = ops.search_operations().search_by_pattern("^SRCH_ALPH");
+    EXPECT_EQ(matched.size(), 9u);
+
+    // One substitution in ten characters is 0.9 similar, two are 0.8
+    EXPECT_EQ(ops.search_operations().fuzzy_search("SRCH_ALPHA", 0.95).size(), 6u);
+    EXPECT_EQ(ops.search_operations().fuzzy_search("SRCH_ALPHA", 0.9).size(), 9u);
+
+    std::vector<Node> high = ops.search_operations().search_high_priority(10);
+    ASSERT_EQ(high.size(), 3u);
+    for (const Node& node : high) EXPECT_EQ(SymbolRegistry::global().name(node.symbol), "SRCH_ALPHB");
+
+    auto busiest = ops.get_top_symbols_by_activity(2);
+    ASSERT_EQ(busiest.size(), 2u);
+    EXPECT_EQ(busiest[0], std::make_pair(std::string("SRCH_ALPHA"), size_t(6)));
+    EXPECT_EQ(busiest[1], std::make_pair(std::string("SRCH_ALPHB"), size_t(3)));
+
+    // 10, 20, 30 vary by half their mean; 100..105 by under 2%, and a
+    // single value not at all
+    auto volatile_symbols = ops.get_volatile_symbols(0.1);
+    ASSERT_EQ(volatile_symbols.size(), 1u);
+    EXPECT_EQ(volatile_symbols[0].first, "SRCH_ALPHB");
+    EXPECT_NEAR(volatile_symbols[0].second, 0.5, 1e-9);
+}
+
+TEST_F(HFTCacheTest, StreamingTwapVwapAndDepth) {
+    const uint64_t base = 1'000'000'000'000ull;
+    const uint64_t second = 1'000'000'000ull;
+    TradeWindow window(16);
+    window.add(base, 100.0, 10.0);
+    window.add(base + second, 110.0, 30.0);
+    window.add(base + 3 * second, 120.0, 10.0);
+    uint64_t now = base + 4 * second;
+
+    EXPECT_DOUBLE_EQ(window.vwap(now, 10 * second), 110.0);
+    EXPECT_DOUBLE_EQ(window.vwap(now, 3 * second), 112.5);
+    EXPECT_DOUBLE_EQ(window.vwap(now, second * 5 / 2), 120.0);
+    EXPECT_DOUBLE_EQ(window.vwap(now, second / 2), 0.0);
+    // 100 for 1s, 110 for 2s, 120 for 1s
+    EXPECT_DOUBLE_EQ(window.twap(now, 4 * second), 110.0);
+    EXPECT_DOUBLE_EQ(window.twap(now, 2 * second), 115.0);
+    EXPECT_DOUBLE_EQ(window.twap(now, 10 * second), 110.0);
+
+    // Past capacity only the most recent trades are kept
+    for (int i = 0; i < 100; ++i) window.add(now + i, i < 84 ? 1.0 : 2.0, 1.0);
+    EXPECT_EQ(window.size(), 16u);
+    EXPECT_DOUBLE_EQ(window.vwap(now + 100, 10 * second), 2.0);
+
+    OrderBook book;
+    book.update(BookSide::BID, 99.0, 5);
+    book.update(BookSide::BID, 100.0, 3);
+    book.update(BookSide::BID, 98.0, 7);
+    book.update(BookSide::ASK, 102.0, 4);
+    book.update(BookSide::ASK, 101.0, 2);
+    book.update(BookSide::BID, 100.0, 0);
+    book.update(BookSide::ASK, 102.0, 6);
+    MarketDepth depth;
+    book.snapshot(2, depth);
+    ASSERT_EQ(depth.bids.size(), 2u);
+    ASSERT_EQ(depth.asks.size(), 2u);
+    EXPECT_EQ(depth.bids[0], std::make_pair(99.0, size_t(5)));
+    EXPECT_EQ(depth.bids[1], std::make_pair(98.0, size_t(7)));
+    EXPECT_EQ(depth.asks[0], std::make_pair(101.0, size_t(2)));
+    EXPECT_EQ(depth.asks[1], std::make_pair(102.0, size_t(6)));
+
+    // End to end through AdvancedCacheOperations on the live clock
+    AdvancedCacheOperations ops(*cache_, config_);
+    ops.on_trade("MD_A", 50.0, 2.0);
+    ops.on_trade("MD_A", 52.0, 2.0);
+    ops.on_book_update("MD_A", BookSide::BID, 50.5, 10);
+    EXPECT_DOUBLE_EQ(ops.get_vwap("MD_A", 10 * second), 51.0);
+    EXPECT_GT(ops.get_twap("MD_A", 10 * second), 0.0);
+    EXPECT_EQ(ops.get_market_depth("MD_A").bids.size(), 1u);
+    EXPECT_EQ(ops.get_vwap("MD_UNKNOWN", second), 0.0);
+}
+
+TEST_F(HFTCacheTest, HotTierClockAdmission) {
+    using namespace hft_cache;
+    SymbolRegistry& registry = SymbolRegistry::global();
+    SymbolId hot = registry.intern("HOT_A");
+    SymbolId cold = registry.intern("HOT_B");
+    HotTier tier(4, 2);
+
+    auto make = [](SymbolId symbol, double value, int priority) {
+        Node* node = new Node(value, priority);
+        node->symbol = symbol;
+        return node;
+    };
+    Node* evicted = nullptr;
+    ASSERT_TRUE(tier.admit(make(hot, 1.0, 1), evicted));
+    ASSERT_TRUE(tier.admit(make(hot, 2.0, 5), evicted));
+    EXPECT_EQ(evicted, nullptr);
+
+    // A full symbol only takes a stronger entry, displacing its weakest
+    Node* weak = make(hot, 3.0, 0);
+    EXPECT_FALSE(tier.admit(weak, evicted));
+    EXPECT_EQ(evicted, nullptr);
+    delete weak;
+    ASSERT_TRUE(tier.admit(make(hot, 4.0, 9), evicted));
+    ASSERT_NE(evicted, nullptr);
+    EXPECT_DOUBLE_EQ(evicted->value, 1.0);
+    delete evicted;
+    EXPECT_EQ(tier.size(), 2u);
+
+    // Lookups leave the entry in place and mark it referenced
+    Node* top = tier.peek(hot);
+    ASSERT_NE(top, nullptr);
+    EXPECT_DOUBLE_EQ(top->value, 4.0);
+    EXPECT_EQ(tier.peek(hot), top);
+
+    // Filling the ring makes CLOCK evict the unreferenced entries first
+    ASSERT_TRUE(tier.admit(make(cold, 10.0, 1), evicted));
+    ASSERT_TRUE(tier.admit(make(cold, 11.0, 1), evicted));
+    EXPECT_EQ(tier.size(), 4u);
+    SymbolId other = registry.intern("HOT_C");
+    ASSERT_TRUE(tier.admit(make(other, 20.0, 1), evicted));
+    ASSERT_NE(evicted, nullptr);
+    EXPECT_NE(evicted, top);
+    delete evicted;
+    EXPECT_EQ(tier.size(), 4u);
+    EXPECT_EQ(tier.peek(hot), top);
+
+    Node* removed = tier.remove(hot, 4.0);
+    EXPECT_EQ(removed, top);
+    delete removed;
+    EXPECT_EQ(tier.remove(hot, 4.0), nullptr);
+
+    std::vector<Node*> drained;
+    tier.drain(drained);
+    EXPECT_EQ(drained.size(), 3u);
+    EXPECT_EQ(tier.size(), 0u);
+    for (Node* node : drained) delete node;
+    EXPECT_EQ(tier.evict_one(), nullptr);
+}
+
+TEST_F(HFTCacheTest, FrequencySketchTinyLfuAdmission) {
+    using namespace hft_cache;
+    FrequencySketch sketch(64, 10);
+
+    // Skewed stream: a handful of hot symbols and a long cold tail
+    for (int round = 0; round < 20; ++round) {
+        for (uint64_t hot = 0; hot < 4; ++hot) sketch.increment(hot);
+        sketch.increment(1000 + round);
+    }
+    for (uint64_t hot = 0; hot < 4; ++hot) EXPECT_GE(sketch.frequency(hot), 10u);
+    EXPECT_LE(sketch.frequency(1005), 3u);
+    EXPECT_EQ(sketch.frequency(999999), 0u);
+
+    // Aging halves every counter once the sample fills
+    uint32_t before = sketch.frequency(0);
+    size_t agings = sketch.agings();
+    for (size_t i = 0; i < sketch.sample_size(); ++i) sketch.increment(50000 + i);
+    EXPECT_GT(sketch.agings(), agings);
+    EXPECT_LE(sketch.frequency(0), before / 2 + 1);
+
+    // A full tier admits a frequent symbol over a cold victim, never the reverse
+    SymbolRegistry& registry = SymbolRegistry::global();
+    SymbolId cold = registry.intern("LFU_COLD");
+    SymbolId hot = registry.intern("LFU_HOT");
+    SymbolId newcomer = registry.intern("LFU_NEW");
+    FrequencySketch access(64);
+    for (int i = 0; i < 8; ++i) access.increment(hot);
+    access.increment(cold);
+
+    HotTier tier(1, 1);
+    auto make = [](SymbolId symbol, double value) {
+        Node* node = new Node(value, 1);
+        node->symbol = symbol;
+        return node;
+    };
+    Node* evicted = nullptr;
+    ASSERT_TRUE(tier.admit(make(cold, 1.0), evicted, &access));
+    Node* unseen = make(newcomer, 2.0);
+    EXPECT_FALSE(tier.admit(unseen, evicted, &access));
+    EXPECT_EQ(evicted, nullptr);
+    delete unseen;
+    ASSERT_TRUE(tier.admit(make(hot, 3.0), evicted, &access));
+    ASSERT_NE(evicted, nullptr);
+    EXPECT_EQ(evicted->symbol, cold);
+    delete evicted;
+    Node* retry = make(cold, 4.0);
+    EXPECT_FALSE(tier.admit(retry, evicted, &access));
+    delete retry;
+    ASSERT_NE(tier.peek(hot), nullptr);
+
+    // Background demotion walks the ring with a predicate
+    std::vector<Node*> cooled;
+    EXPECT_EQ(tier.evict_if([](const Node& node) { return node.value > 2.0; }, cooled, 8), 1u);
+    EXPECT_EQ(tier.size(), 0u);
+    for (Node* node : cooled) delete node;
+}
+
+TEST_F(HFTCacheTest, MultiLevelCacheReadsFallThroughLevels) {
+    using namespace hft_cache;
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_tiers_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::remove_all(dir);
+
+    CacheConfig config = config_;
+    config.disk_cache_path = dir.string();
+    config.l3_segment_bytes = 1 << 20;
+    config.l1_min_priority = 5;
+    config.l1_entries_per_symbol = 2;
+    config.enable_frequency_tiering = false;  // promotion on priority alone
+    {
+        MultiLevelCache cache(config);
+        SymbolId symbol = SymbolRegistry::global().intern("TIER_A");
+
+        // The first two fill the symbol's L1 entries; the rest land in L2
+        ASSERT_TRUE(cache.insert(1.0, symbol, 9));
+        ASSERT_TRUE(cache.insert(2.0, symbol, 8));
+        ASSERT_TRUE(cache.insert(3.0, symbol, 7));
+        ASSERT_TRUE(cache.insert(4.0, symbol, 6));
+        ASSERT_TRUE(cache.insert(5.0, symbol, 1));
+        EXPECT_EQ(cache.get_l1_stats().item_count.load(), 2u);
+        EXPECT_EQ(cache.get_l2_stats().item_count.load(), 3u);
+
+        Node cold(6.0, 0);
+        cold.symbol = symbol;
+        ASSERT_TRUE(cache.demote_to_l3(&cold));
+
+        // Every read consumes what it returns. The L2 hit on 3.0 is hot
+        // enough to pull 4.0 up, so that read is an L1 hit again.
+        EpochGuard guard;
+        for (double expected : {1.0, 2.0, 3.0, 4.0, 5.0, 6.0}) {
+            Node* node = cache.get_highest_priority(symbol);
+            ASSERT_NE(node, nullptr);
+            EXPECT_DOUBLE_EQ(node->value, expected);
+        }
+        EXPECT_EQ(cache.get_highest_priority(symbol), nullptr);
+
+        MultiLevelCache::LevelStats l1 = cache.get_l1_stats();
+        MultiLevelCache::LevelStats l2 = cache.get_l2_stats();
+        MultiLevelCache::LevelStats l3 = cache.get_l3_stats();
+        EXPECT_EQ(l1.hit_count.load(), 3u);
+        EXPECT_EQ(l1.miss_count.load(), 4u);
+        EXPECT_EQ(l2.hit_count.load(), 2u);
+        EXPECT_EQ(l3.hit_count.load(), 1u);
+        EXPECT_EQ(l3.miss_count.load(), 1u);
+        EXPECT_EQ(l1.item_count.load() + l2.item_count.load() + l3.item_count.load(), 0u);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, DiskBackedCacheRanksEntriesPerSymbol) {
+    using namespace hft_cache;
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_l3_ranked_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::remove_all(dir);
+
+    CacheConfig config = config_;
+    config.disk_cache_path = dir.string();
+    config.l3_segment_bytes = 1 << 20;
+    SymbolId symbol = SymbolRegistry::global().intern("L3_RANKED");
+    auto put = [](DiskBackedCache& l3, SymbolId id, double value, int priority, double expiry) {
+        Node node(value, priority, expiry);
+        node.symbol = id;
+        return l3.insert(&node);
+    };
+    {
+        DiskBackedCache l3(config);
+        ASSERT_TRUE(put(l3, symbol, 1.0, 5, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 2.0, 9, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 3.0, 7, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 4.0, 20, 0.001));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        // Highest priority first, past the expired entry, as each is consumed
+        for (double expected : {2.0, 3.0, 1.0}) {
+            Node* node = l3.retrieve_any(symbol);
+            ASSERT_NE(node, nullptr);
+            EXPECT_DOUBLE_EQ(node->value, expected);
+            ASSERT_TRUE(l3.remove(symbol, expected));
+        }
+        EXPECT_EQ(l3.retrieve_any(symbol), nullptr);
+        EXPECT_EQ(l3.size(), 1u);
+
+        // Re-inserting a key at a new priority re-ranks it
+        ASSERT_TRUE(put(l3, symbol, 1.0, 5, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 6.0, 8, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 7.0, 3, 60.0));
+        ASSERT_TRUE(put(l3, symbol, 7.0, 10, 60.0));
+        ASSERT_NE(l3.retrieve_any(symbol), nullptr);
+        EXPECT_DOUBLE_EQ(l3.retrieve_any(symbol)->value, 7.0);
+        ASSERT_TRUE(l3.remove(symbol, 7.0));
+        ASSERT_TRUE(l3.remove(symbol, 6.0));
+        ASSERT_TRUE(l3.flush_to_disk());
+    }
+    {
+        // Replay honours the tombstones
+        DiskBackedCache l3(config);
+        EXPECT_EQ(l3.size(), 2u);
+        Node* node = l3.retrieve_any(symbol);
+        ASSERT_NE(node, nullptr);
+        EXPECT_DOUBLE_EQ(node->value, 1.0);
+        EXPECT_EQ(node->priority, 5);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, DiskBackedCacheCompactionKeepsLiveEntries) {
+    using namespace hft_cache;
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_l3_compact_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::remove_all(dir);
+
+    // One page per segment, so the churn below seals several
+    CacheConfig config = config_;
+    config.disk_cache_path = dir.string();
+    config.l3_segment_bytes = 4096;
+    config.l3_capacity = 64;
+    SymbolId symbol = SymbolRegistry::global().intern("L3_COMPACT");
+    {
+        DiskBackedCache l3(config);
+        for (int i = 0; i < 400; ++i) {
+            Node node(static_cast<double>(i), i % 10, 60.0);
+            node.symbol = symbol;
+            ASSERT_TRUE(l3.insert(&node));
+        }
+        for (int i = 0; i < 400; ++i) {
+            if (i % 20 != 0) {
+                ASSERT_TRUE(l3.remove(symbol, static_cast<double>(i)));
+            }
+        }
+        EXPECT_GT(l3.compact(64), 0u);
+
+        // The rebuilt filter still admits every live key
+        EXPECT_EQ(l3.size(), 20u);
+        for (int i = 0; i < 400; ++i) {
+            EXPECT_EQ(l3.retrieve(symbol, static_cast<double>(i)) != nullptr, i % 20 == 0) << i;
+        }
+        Node* top = l3.retrieve_any(symbol);
+        ASSERT_NE(top, nullptr);
+        EXPECT_EQ(top->priority, 0);
+        EXPECT_DOUBLE_EQ(top->value, 380.0);
+        ASSERT_TRUE(l3.flush_to_disk());
+    }
+    {
+        DiskBackedCache l3(config);
+        EXPECT_EQ(l3.size(), 20u);
+        EXPECT_NE(l3.retrieve(symbol, 40.0), nullptr);
+        EXPECT_EQ(l3.retrieve(symbol, 41.0), nullptr);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, SegmentStoreAppendRecoverCompact) {
+    using namespace hft_cache;
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_segments_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::remove_all(dir);
+
+    std::vector<SegmentStore::Location> locations;
+    {
+        // One page per segment, so a few hundred records span several
+        SegmentStore store(dir.string(), 4096);
+        for (uint64_t i = 0; i < 300; ++i) {
+            SegmentStore::Location location = store.append(1, &i, sizeof(i));
+            ASSERT_NE(location, SegmentStore::INVALID_LOCATION);
+            locations.push_back(location);
+        }
+        EXPECT_GT(store.segment_count(), 1u);
+        uint32_t length = 0;
+        uint16_t kind = 0;
+        const uint8_t* payload = store.payload(locations[42], &length, &kind);
+        ASSERT_NE(payload, nullptr);
+        uint64_t value;
+        std::memcpy(&value, payload, sizeof(value));
+        EXPECT_EQ(value, 42u);
+        EXPECT_EQ(length, sizeof(uint64_t));
+        EXPECT_EQ(kind, 1u);
+
+        // Sealed segments only become candidates once mostly dead
+        uint32_t first = SegmentStore::segment_of(locations.front());
+        EXPECT_EQ(store.compaction_candidate(0.5), 0u);
+        for (SegmentStore::Location location : locations) {
+            if (SegmentStore::segment_of(location) == first) store.release(location);
+        }
+        EXPECT_EQ(store.compaction_candidate(0.5), first);
+        EXPECT_FALSE(store.has_segment_before(first));
+        store.drop_segment(first);
+        EXPECT_FALSE(fs::exists(dir / "segment-00000001.l3"));
+        EXPECT_TRUE(store.flush(true));
+    }
+
+    // Tear the last record of the newest segment
+    fs::path newest;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (newest.empty() || entry.path() > newest) newest = entry.path();
+    }
+    size_t tail_offset = SegmentStore::offset_of(locations.back());
+    {
+        std::fstream file(newest, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(tail_offset + SegmentStore::HEADER_BYTES));
+        file.put('\x7f');
+    }
+
+    SegmentStore reopened(dir.string(), 4096);
+    reopened.open_existing();
+    size_t recovered = 0;
+    uint64_t last = 0;
+    reopened.for_each_segment([&](uint32_t id) {
+        reopened.scan_segment(id, 0, SIZE_MAX, [&](SegmentStore::Location, uint16_t kind, const uint8_t* payload, uint32_t) {
+            EXPECT_EQ(kind, 1u);
+            std::memcpy(&last, payload, sizeof(last));
+            ++recovered;
+            return true;
+        });
+    });
+    size_t dropped = 0;
+    uint32_t first = SegmentStore::segment_of(locations.front());
+    for (SegmentStore::Location location : locations) dropped += SegmentStore::segment_of(location) == first;
+    EXPECT_EQ(recovered, locations.size() - dropped - 1);
+    EXPECT_EQ(last, locations.size() - 2);
+
+    // Appends after recovery go to a new segment, behind the torn one
+    uint64_t marker = 7;
+    SegmentStore::Location appended = reopened.append(2, &marker, sizeof(marker));
+    EXPECT_GT(SegmentStore::segment_of(appended), SegmentStore::segment_of(locations.back()));
+
+    reopened.clear();
+    EXPECT_EQ(reopened.bytes_on_disk(), 0u);
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, PersistentCacheSnapshotCheckpoint) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_checkpoints_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    SymbolRegistry& registry = SymbolRegistry::global();
+    std::vector<SymbolId> symbols;
+    for (int s = 0; s < 5; ++s) symbols.push_back(registry.intern("CKPT_" + std::to_string(s)));
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(cache_->insert(100.0 + i, symbols[i % 5], i, 60.0));
+    }
+
+    {
+        PersistentCache persistent(*cache_, config_, dir.string());
+
+        // Inserts keep landing while the background thread snapshots
+        SymbolId busy = registry.intern("CKPT_BUSY");
+        std::atomic<bool> writing{true};
+        std::atomic<size_t> written{0};
+        std::thread writer([&]() {
+            while (writing.load() && written.load() < 400) {
+                if (cache_->insert(1.0, busy, 0, 60.0)) written.fetch_add(1);
+            }
+        });
+        EXPECT_TRUE(persistent.checkpoint_to_disk("full.dat"));
+        EXPECT_TRUE(persistent.wait_for_checkpoint());
+        writing.store(false);
+        writer.join();
+
+        CheckpointStats stats = persistent.last_checkpoint_stats();
+        EXPECT_TRUE(stats.success);
+        EXPECT_GE(stats.node_count, 50u);
+        EXPECT_LE(stats.node_count, 50u + written.load());
+        EXPECT_GT(stats.bytes_written, stats.node_count * 24);
+        // The copy of one shard is the only window an insert could wait on
+        EXPECT_LT(stats.max_shard_hold_ns, 10'000'000u);
+        ASSERT_EQ(persistent.list_checkpoints().size(), 1u);
+        EXPECT_EQ(persistent.list_checkpoints()[0].node_count, stats.node_count);
+
+        // Restoring replaces whatever the cache holds now
+        cache_->clear();
+        ASSERT_TRUE(cache_->insert(1.0, symbols[0], 1000, 60.0));
+        ASSERT_TRUE(persistent.restore_from_disk((dir / "full.dat").string()));
+        {
+            EpochGuard guard;
+            Node* top = cache_->get_highest_priority(symbols[0]);
+            ASSERT_NE(top, nullptr);
+            EXPECT_EQ(top->priority, 45);
+            EXPECT_DOUBLE_EQ(top->value, 145.0);
+        }
+
+        // Incrementals carry only what arrived after the full checkpoint
+        ASSERT_TRUE(cache_->insert(999.0, symbols[1], 500, 60.0));
+        EXPECT_TRUE(persistent.incremental_checkpoint());
+        EXPECT_TRUE(persistent.wait_for_checkpoint());
+        EXPECT_EQ(persistent.last_checkpoint_stats().node_count, 1u);
+
+        cache_->clear();
+        uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        EXPECT_FALSE(persistent.point_in_time_recovery(1));
+        ASSERT_TRUE(persistent.point_in_time_recovery(now));
+        {
+            EpochGuard guard;
+            Node* top = cache_->get_highest_priority(symbols[1]);
+            ASSERT_NE(top, nullptr);
+            EXPECT_EQ(top->priority, 500);
+            top = cache_->get_highest_priority(symbols[1]);
+            ASSERT_NE(top, nullptr);
+            EXPECT_EQ(top->priority, 46);
+        }
+
+        // A corrupted file is refused rather than half-loaded
+        {
+            std::fstream file(dir / "full.dat", std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(40);
+            file.put('\x55');
+        }
+        EXPECT_FALSE(persistent.restore_from_disk((dir / "full.dat").string()));
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, WriteAheadLogPointInTimeRecovery) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_wal_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    SymbolRegistry& registry = SymbolRegistry::global();
+    SymbolId base = registry.intern("WAL_BASE");
+    SymbolId threaded = registry.intern("WAL_THREADED");
+    SymbolId late = registry.intern("WAL_LATE");
+    auto wall_now = []() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    };
+    auto drain = [this](SymbolId symbol) {
+        size_t count = 0;
+        while (cache_->get_highest_priority(symbol)) ++count;
+        return count;
+    };
+
+    config_.enable_wal = true;
+    config_.wal_group_commit_us = 200;
+    config_.wal_fsync_batch = 4;
+    config_.wal_segment_bytes = 1024;
+    {
+        PersistentCache persistent(*cache_, config_, dir.string());
+        for (int i = 0; i < 20; ++i) ASSERT_TRUE(cache_->insert(i, base, i, 60.0));
+        ASSERT_TRUE(persistent.checkpoint_to_disk());
+        ASSERT_TRUE(persistent.wait_for_checkpoint());
+
+        // Logged after the checkpoint: inserts from several threads and pops
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 3; ++t) {
+            writers.emplace_back([&, t]() {
+                for (int i = 0; i < 10; ++i) cache_->insert(t * 100 + i, threaded, i, 60.0);
+            });
+        }
+        for (auto& writer : writers) writer.join();
+        for (int i = 0; i < 5; ++i) ASSERT_NE(cache_->get_highest_priority(base), nullptr);
+        ASSERT_TRUE(persistent.sync_wal());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        uint64_t middle = wall_now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        for (int i = 0; i < 10; ++i) ASSERT_TRUE(cache_->insert(i, late, i, 60.0));
+        ASSERT_TRUE(persistent.incremental_checkpoint());
+
+        WriteAheadLog::Stats stats = persistent.wal()->stats();
+        EXPECT_GE(stats.entries, 45u);
+        EXPECT_GT(stats.segments, 1u);
+        EXPECT_GE(stats.fsyncs, 1u);
+
+        // Replaying to before the clear brings back everything; the clear
+        // itself is logged too
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        uint64_t end = wall_now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        cache_->clear();
+        ASSERT_TRUE(persistent.sync_wal());
+        ASSERT_TRUE(persistent.point_in_time_recovery(end));
+        ASSERT_TRUE(persistent.wait_for_checkpoint());
+        {
+            EpochGuard guard;
+            Node* top = cache_->get_highest_priority(base);
+            ASSERT_NE(top, nullptr);
+            EXPECT_EQ(top->priority, 14);
+        }
+        EXPECT_EQ(drain(base), 14u);
+        EXPECT_EQ(drain(threaded), 30u);
+        EXPECT_EQ(drain(late), 10u);
+
+        // Replaying to the middle stops before the late inserts
+        ASSERT_TRUE(persistent.point_in_time_recovery(middle));
+        ASSERT_TRUE(persistent.wait_for_checkpoint());
+        EXPECT_EQ(drain(base), 15u);
+        EXPECT_EQ(drain(threaded), 30u);
+        EXPECT_EQ(drain(late), 0u);
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, WriteAheadLogSharesObserverSlot) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_wal_shared_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    SymbolId symbol = SymbolRegistry::global().intern("WAL_SHARED");
+
+    config_.enable_wal = true;
+    {
+        PersistentCache persistent(*cache_, config_, dir.string());
+        for (int i = 0; i < 10; ++i) ASSERT_TRUE(cache_->insert(i, symbol, i, 60.0));
+        {
+            AggregationOperations agg(*cache_);
+            ASSERT_TRUE(cache_->insert(10, symbol, 10, 60.0));
+            EXPECT_EQ(agg.summary(symbol).count, 1u);
+        }
+        for (int i = 11; i < 30; ++i) ASSERT_TRUE(cache_->insert(i, symbol, i, 60.0));
+        ASSERT_TRUE(persistent.sync_wal());
+        EXPECT_EQ(persistent.wal()->stats().entries, 30u);
+        EXPECT_FALSE(cache_->attach_observer(&persistent));
+        EXPECT_FALSE(cache_->detach_observer(nullptr));
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, ParallelCheckpointRestore) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_restore_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    CacheConfig config = config_;
+    config.max_nodes = 200000;
+    config.priority_queue_shards = 4;
+    config.restore_threads = 4;
+    RadialCircularList cache(config);
+    SymbolRegistry& registry = SymbolRegistry::global();
+
+    std::vector<SymbolId> symbols;
+    for (int s = 0; s < 32; ++s) {
+        symbols.push_back(registry.intern("RESTORE_" + std::to_string(s)));
+        for (int i = 0; i < 100; ++i) ASSERT_TRUE(cache.insert(i, symbols.back(), i, 60.0));
+    }
+    SymbolId large = registry.intern("RESTORE_LARGE");
+    for (int i = 0; i < 15000; ++i) ASSERT_TRUE(cache.insert(i, large, (i * 7919) % 15000, 60.0));
+    // Already expired at the cut, so never written
+    ASSERT_TRUE(cache.insert(-1.0, symbols[0], 1000, 0.0));
+
+    {
+        PersistentCache persistent(cache, config, dir.string());
+        ASSERT_TRUE(persistent.checkpoint_to_disk("full.dat"));
+        ASSERT_TRUE(persistent.wait_for_checkpoint());
+        EXPECT_EQ(persistent.last_checkpoint_stats().node_count, 32u * 100 + 15000);
+
+        // A damaged section fails verification before the cache is touched
+        fs::copy_file(dir / "full.dat", dir / "broken.dat");
+        {
+            std::fstream file(dir / "broken.dat", std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(40);
+            file.put('\x55');
+        }
+        cache.clear();
+        SymbolId sentinel = registry.intern("RESTORE_SENTINEL");
+        ASSERT_TRUE(cache.insert(1.0, sentinel, 1, 60.0));
+        EXPECT_FALSE(persistent.restore_from_disk((dir / "broken.dat").string()));
+        {
+            EpochGuard guard;
+            Node* kept = cache.get_highest_priority(sentinel);
+            ASSERT_NE(kept, nullptr);
+            EXPECT_DOUBLE_EQ(kept->value, 1.0);
+        }
+
+        ASSERT_TRUE(persistent.restore_from_disk((dir / "full.dat").string()));
+        RestoreStats stats = persistent.last_restore_stats();
+        EXPECT_TRUE(stats.success);
+        EXPECT_EQ(stats.node_count, 32u * 100 + 15000);
+        EXPECT_EQ(stats.symbol_count, 33u);
+        EXPECT_EQ(stats.threads, 4u);
+    }
+
+    // Every heap comes back whole and in priority order
+    EpochGuard guard;
+    for (SymbolId symbol : symbols) {
+        for (int expected = 99; expected >= 0; --expected) {
+            Node* node = cache.get_highest_priority(symbol);
+            ASSERT_NE(node, nullptr);
+            ASSERT_EQ(node->priority, expected);
+            ASSERT_DOUBLE_EQ(node->value, expected);
+        }
+        EXPECT_EQ(cache.get_highest_priority(symbol), nullptr);
+    }
+    for (int expected = 14999; expected >= 0; --expected) {
+        Node* node = cache.get_highest_priority(large);
+        ASSERT_NE(node, nullptr);
+        ASSERT_EQ(node->priority, expected);
+    }
+    EXPECT_EQ(cache.get_highest_priority(large), nullptr);
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, ColumnCodecRoundTrip) {
+    std::mt19937_64 rng(7);
+    ColumnCodec::Columns columns;
+    double price = 101.25;
+    uint64_t timestamp = 1'000'000'000;
+    for (int i = 0; i < 3000; ++i) {
+        price += 0.01 * static_cast<int>(rng() % 5) - 0.02;
+        timestamp += 1'000'000 + rng() % 1000;
+        columns.push_back(price, timestamp, 60'000'000'000ULL, static_cast<int32_t>(rng() % 64));
+    }
+    // Edge cases of every column, including a delta-of-delta beyond 32 bits
+    columns.push_back(std::numeric_limits<double>::quiet_NaN(), 0, 1, std::numeric_limits<int32_t>::min());
+    columns.push_back(-0.0, UINT64_MAX, 0, std::numeric_limits<int32_t>::max());
+
+    std::vector<uint8_t> encoded;
+    size_t bytes = ColumnCodec::encode(columns, 0, columns.size(), encoded);
+    EXPECT_EQ(bytes, encoded.size());
+    EXPECT_EQ(bytes % 8, 0u);
+    EXPECT_LT(bytes, columns.size() * 28 / 2);
+
+    ColumnCodec::Columns decoded;
+    ASSERT_EQ(ColumnCodec::decode(encoded.data(), encoded.size(), decoded), bytes);
+    ASSERT_EQ(decoded.size(), columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&decoded.values[i], &columns.values[i], sizeof(double)), 0) << i;
+        ASSERT_EQ(decoded.timestamps[i], columns.timestamps[i]) << i;
+        ASSERT_EQ(decoded.lifetimes[i], columns.lifetimes[i]) << i;
+        ASSERT_EQ(decoded.priorities[i], columns.priorities[i]) << i;
+    }
+    // A truncated block is refused
+    EXPECT_EQ(ColumnCodec::decode(encoded.data(), encoded.size() - 8, decoded), 0u);
+}
+
+TEST_F(HFTCacheTest, CompressedCheckpointRestore) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / ("hft_compressed_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    CacheConfig config = config_;
+    config.max_nodes = 100000;
+    config.priority_queue_shards = 2;
+    RadialCircularList cache(config);
+    SymbolRegistry& registry = SymbolRegistry::global();
+
+    std::vector<SymbolId> symbols;
+    for (int s = 0; s < 4; ++s) {
+        symbols.push_back(registry.intern("COLUMNAR_" + std::to_string(s)));
+        double price = 250.0 + s;
+        for (int i = 0; i < 5000; ++i) {
+            price += (i % 3 - 1) * 0.05;
+            ASSERT_TRUE(cache.insert(price, symbols.back(), i % 100, 120.0));
+        }
+    }
+
+    PersistentCache persistent(cache, config, dir.string());
+    ASSERT_TRUE(persistent.checkpoint_to_disk("plain.dat"));
+    ASSERT_TRUE(persistent.wait_for_checkpoint());
+    CheckpointStats plain = persistent.last_checkpoint_stats();
+    EXPECT_FALSE(plain.compressed);
+
+    persistent.enable_compression();
+    ASSERT_TRUE(persistent.checkpoint_to_disk("columnar.dat"));
+    ASSERT_TRUE(persistent.wait_for_checkpoint());
+    CheckpointStats columnar = persistent.last_checkpoint_stats();
+    EXPECT_TRUE(columnar.compressed);
+    EXPECT_EQ(columnar.node_count, 20000u);
+    EXPECT_EQ(columnar.raw_bytes, plain.raw_bytes);
+    EXPECT_GT(columnar.compression_ratio(), 3.0);
+    EXPECT_LT(columnar.bytes_written * 3, plain.bytes_written);
+
+    // Restores read either format, whatever the current setting
+    for (const char* name : {"columnar.dat", "plain.dat"}) {
+        ASSERT_TRUE(persistent.restore_from_disk((dir / name).string()));
+        RestoreStats stats = persistent.last_restore_stats();
+        EXPECT_EQ(stats.node_count, 20000u);
+        EXPECT_EQ(stats.compressed, std::string(name) == "columnar.dat");
+        for (SymbolId symbol : symbols) {
+            EpochGuard guard;
+            size_t popped = 0;
+            int last = std::numeric_limits<int>::max();
+            while (Node* node = cache.get_highest_priority(symbol)) {
+                ASSERT_LE(node->priority, last);
+                last = node->priority;
+                ++popped;
+            }
+            EXPECT_EQ(popped, 5000u);
+        }
+    }
+    fs::remove_all(dir);
+}
+
+TEST_F(HFTCacheTest, MagazinePoolRecyclesAcrossThreads) {
+    const size_t capacity = 4096;
+    NodePool pool(capacity, 32);
+    std::mutex held_mutex;
+    std::unordered_set<Node*> held;
+    std::atomic<bool> duplicate{false};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            std::vector<Node*> mine;
+            for (int op = 0; op < 20000; ++op) {
+                if (mine.size() < 200 && (mine.empty() || rng() % 2)) {
+                    Node* node = pool.allocate();
+                    ASSERT_NE(node, nullptr);
+                    std::lock_guard<std::mutex> lock(held_mutex);
+                    if (!held.insert(node).second) duplicate = true;
+                    mine.push_back(node);
+                } else {
+                    Node* node = mine.back();
+                    mine.pop_back();
+                    {
+                        std::lock_guard<std::mutex> lock(held_mutex);
+                        held.erase(node);
+                    }
+                    pool.release(node);
+                }
+            }
+            for (Node* node : mine) {
+                {
+                    std::lock_guard<std::mutex> lock(held_mutex);
+                    held.erase(node);
+                }
+                pool.release(node);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    EXPECT_FALSE(duplicate);
+
+    // Exited threads left their magazines in the depot, so one thread can
+    // still reach every slot
+    MagazineCache::Stats stats = pool.magazines()->stats();
+    EXPECT_GT(stats.depot_allocations + stats.depot_releases, 0u);
+    EXPECT_EQ(stats.allocations, stats.releases);
+    std::unordered_set<Node*> all;
+    while (Node* node = pool.allocate()) ASSERT_TRUE(all.insert(node).second);
+    EXPECT_EQ(all.size(), capacity);
+    for (Node* node : all) pool.release(node);
+}
+
+TEST_F(HFTCacheTest, HierarchicalPoolFallsThroughOnce) {
+    using namespace hft_cache;
+    CacheConfig config = config_;
+    config.max_nodes = 64;
+    HierarchicalMemoryPool pool(config);
+
+    std::vector<Node*> nodes;
+    for (int i = 0; i < 200; ++i) {
+        Node* node = pool.allocate_node();
+        ASSERT_NE(node, nullptr);
+        nodes.push_back(node);
+    }
+    auto stats = pool.get_pool_statistics();
+    EXPECT_EQ(stats.l1_allocations, 64u);
+    EXPECT_EQ(stats.l2_allocations, 64u);
+    EXPECT_EQ(stats.l3_allocations, 72u);
+
+    // Handing an L1 node back reopens L1
+    pool.deallocate_node(nodes.front());
+    Node* again = pool.allocate_node();
+    EXPECT_EQ(again, nodes.front());
+    nodes.front() = again;
+    EXPECT_EQ(pool.get_pool_statistics().l1_allocations, 65u);
+    for (Node* node : nodes) pool.deallocate_node(node);
+
+    AdvancedMemoryPool advanced(config);
+    void* block = advanced.allocate_aligned(1000, 256);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 256, 0u);
+    advanced.deallocate_aligned(block);
+    EXPECT_EQ(advanced.allocate_aligned(512, 64), block);  // reused
+}
+
+TEST_F(HFTCacheTest, NodeAllocatorLatency) {
+    using namespace hft_cache;
+    const size_t threads = 4;
+    std::vector<AllocatorBenchmarkResult> results = benchmark_node_allocators(threads, 2000);
+    const AllocatorBenchmarkResult* shared = nullptr;
+    const AllocatorBenchmarkResult* magazines = nullptr;
+    std::cout << "Allocation latency, " << threads << " threads (ns per call, p50/p99/p99.9/max):" << std::endl;
+    for (const AllocatorBenchmarkResult& result : results) {
+        for (const AllocationLatencyHistogram* h : {&result.allocate, &result.release}) {
+            std::cout << "  " << h->allocator << (h == &result.allocate ? " allocate: " : " release: ")
+                      << h->percentile_ns(0.5) << " / " << h->percentile_ns(0.99) << " / "
+                      << h->percentile_ns(0.999) << " / " << h->max_ns << ", mean " << h->mean_ns() << std::endl;
+        }
+        EXPECT_GT(result.allocate.samples, 0u);
+        EXPECT_EQ(result.allocate.samples, result.release.samples);
+        if (result.allocate.allocator == "NodePool") shared = &result;
+        if (result.allocate.allocator == "NodePool+magazines") magazines = &result;
+    }
+    ASSERT_TRUE(shared && magazines);
+    // Means and tails move with preemption; the median is the fast path
+    EXPECT_LE(magazines->allocate.percentile_ns(0.5), shared->allocate.percentile_ns(0.5) * 2);
+}
+
+TEST_F(HFTCacheTest, NumaPartitionedPool) {
+    // Partitions do not need distinct nodes, so this runs on one node too
+    for (size_t rounds : {size_t(0), size_t(8)}) {
+        NodePool pool(1000, rounds, 4);
+        ASSERT_EQ(pool.partition_count(), 4u);
+        std::unordered_set<Node*> all;
+        while (Node* node = pool.allocate()) {
+            ASSERT_TRUE(pool.owns(node));
+            ASSERT_TRUE(all.insert(node).second);
+        }
+        EXPECT_EQ(all.size(), 1000u);
+        // Only the calling thread's partition is local
+        EXPECT_EQ(pool.remote_allocations(), 750u);
+        for (Node* node : all) pool.release(node);
+        pool.flush();
+        size_t again = 0;
+        while (pool.allocate()) ++again;
+        EXPECT_EQ(again, 1000u);
+    }
+
+    CacheConfig config = config_;
+    config.enable_numa = true;
+    RadialCircularList cache(config);
+    SymbolId symbol = SymbolRegistry::global().intern("NUMA_POOL");
+    for (int i = 0; i < 100; ++i) ASSERT_TRUE(cache.insert(i, symbol, i));
+    EpochGuard guard;
+    int popped = 0;
+    while (cache.get_highest_priority(symbol)) ++popped;
+    EXPECT_EQ(popped, 100);
+    if (NumaTopology::node_count() == 1) {
+        EXPECT_EQ(cache.cross_numa_accesses(), 0u);
+        EXPECT_EQ(cache.remote_node_allocations(), 0u);
+    }
+
+    hft_cache::NUMAMemoryPool numa(config);
+    int here = numa.get_current_numa_node();
+    Node* node = numa.allocate_node_on_numa(-1);
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(numa.get_numa_allocation_count(here), 1u);
+    EXPECT_GT(numa.get_numa_utilization(here), 0.0);
+    numa.deallocate_node_to_numa(node, here);
+    EXPECT_EQ(numa.get_numa_utilization(here), 0.0);
+
+    // Pool slots go back to the pool, not to the system
+    MemoryManager manager(config);
+    size_t baseline = manager.get_memory_usage();
+    std::vector<Node*> nodes;
+    for (size_t i = 0; i < config.max_nodes; ++i) nodes.push_back(manager.allocate_node());
+    EXPECT_EQ(manager.get_memory_usage(), baseline);
+    for (Node* taken : nodes) manager.deallocate_node(taken);
+    manager.cleanup_expired_nodes();
+    EXPECT_EQ(manager.get_memory_usage(), baseline);
+    EXPECT_EQ(manager.allocate_node(), nodes.back());
+}
+
+TEST_F(HFTCacheTest, BTreeRangeScans) {
+    using namespace hft_cache;
+    LockFreeBTree tree(config_);
+    SymbolId alpha = SymbolRegistry::global().intern("BTREE_A");
+    SymbolId beta = SymbolRegistry::global().intern("BTREE_B");
+    std::vector<int> order(5000);
+    for (int i = 0; i < 5000; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+    for (int i : order) {
+        Node* node = new Node(i / 2, i % 10);  // every value twice
+        node->symbol = alpha;
+        ASSERT_TRUE(tree.insert(node));
+        Node* other = new Node(i);
+        other->symbol = beta;
+        ASSERT_TRUE(tree.insert(other));
+    }
+    EXPECT_EQ(tree.size(), 10000u);
+    EXPECT_GT(tree.get_height(), 2);
+    EXPECT_TRUE(tree.validate_tree());
+
+    // A seek and a leaf walk, straight into the caller's buffer
+    Node* buffer[512];
+    size_t found = tree.get_range(alpha, 100.0, 199.0, buffer, 512);
+    ASSERT_EQ(found, 200u);
+    for (size_t i = 0; i < found; ++i) {
+        EXPECT_EQ(buffer[i]->symbol, alpha);
+        EXPECT_EQ(buffer[i]->value, 100.0 + i / 2);
+    }
+    EXPECT_EQ(tree.get_range(alpha, 100.0, 199.0, buffer, 16), 16u);
+    EXPECT_EQ(tree.get_by_priority_range(alpha, 0, 0, buffer, 512), 500u);
+
+    std::vector<Node*> sorted = tree.get_sorted_by_value(beta);
+    ASSERT_EQ(sorted.size(), 5000u);
+    for (size_t i = 0; i < sorted.size(); ++i) EXPECT_EQ(sorted[i]->value, static_cast<double>(i));
+    std::vector<Node*> by_priority = tree.get_sorted_by_priority(alpha);
+    ASSERT_EQ(by_priority.size(), 5000u);
+    EXPECT_EQ(by_priority.front()->priority, 9);
+    EXPECT_EQ(by_priority.back()->priority, 0);
+
+    EpochGuard guard;
+    EXPECT_EQ(tree.find(beta, 4321.0)->value, 4321.0);
+    EXPECT_TRUE(tree.remove(alpha, 42.0));
+    EXPECT_TRUE(tree.remove(alpha, 42.0));
+    EXPECT_FALSE(tree.remove(alpha, 42.0));
+    EXPECT_EQ(tree.find(alpha, 42.0), nullptr);
+    EXPECT_EQ(tree.get_range(alpha, 40.0, 44.0).size(), 8u);
+    EXPECT_TRUE(tree.validate_tree());
+}
+
+TEST_F(HFTCacheTest, BTreeConcurrentInsertsAndScans) {
+    using namespace hft_cache;
+    LockFreeBTree tree(config_);
+    SymbolId symbol = SymbolRegistry::global().intern("BTREE_CONCURRENT");
+    const int writers = 4;
+    const int per_writer = 20000;
+    std::atomic<bool> done{false};
+    std::atomic<bool> unordered{false};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&]() {
+            std::vector<Node*> buffer(1024);
+            while (!done.load()) {
+                EpochGuard guard;
+                size_t found = tree.get_range(symbol, 1000.0, 50000.0, buffer.data(), buffer.size());
+                for (size_t i = 1; i < found; ++i) {
+                    if (buffer[i]->value < buffer[i - 1]->value) unordered = true;
+                }
+            }
+        });
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < per_writer; ++i) {
+                Node* node = new Node(i * writers + t);
+                node->symbol = symbol;
+                tree.insert(node);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    done = true;
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_FALSE(unordered);
+    EXPECT_EQ(tree.size(), static_cast<size_t>(writers * per_writer));
+    EXPECT_TRUE(tree.validate_tree());
+    std::vector<Node*> all = tree.get_sorted_by_value(symbol);
+    ASSERT_EQ(all.size(), static_cast<size_t>(writers * per_writer));
+    for (size_t i = 0; i < all.size(); ++i) ASSERT_EQ(all[i]->value, static_cast<double>(i));
+}
+
+TEST_F(HFTCacheTest, SecondaryIndexesFollowTheCache) {
+    RangeOperations ranges(*cache_);
+    ASSERT_TRUE(ranges.enable_index("IDX_ON"));
+    EXPECT_TRUE(cache_->enable_index("IDX_ON", SymbolIndex::BY_VALUE));
+    SymbolId indexed = SymbolRegistry::global().find("IDX_ON");
+    ASSERT_NE(cache_->index(indexed), nullptr);
+
+    // Same data into an indexed and an unindexed symbol; both paths must agree
+    for (int i = 0; i < 60; ++i) {
+        double value = static_cast<double>((i * 37) % 60);
+        ASSERT_TRUE(cache_->insert(value, "IDX_ON", i % 7));
+        ASSERT_TRUE(cache_->insert(value, "IDX_OFF", i % 7));
+    }
+    EXPECT_EQ(cache_->index(indexed)->size(), 60u);
+    EXPECT_EQ(cache_->index(SymbolRegistry::global().find("IDX_OFF")), nullptr);
+
+    auto values = [](const std::vector<Node>& nodes) {
+        std::vector<double> out;
+        for (const Node& node : nodes) out.push_back(node.value);
+        return out;
+    };
+    std::vector<Node> range = ranges.get_range("IDX_ON", 10.0, 19.0);
+    ASSERT_EQ(range.size(), 10u);
+    for (size_t i = 0; i < range.size(); ++i) EXPECT_DOUBLE_EQ(range[i].value, 10.0 + i);
+    EXPECT_EQ(values(range), values(ranges.get_range("IDX_OFF", 10.0, 19.0)));
+
+    std::vector<Node> by_priority = ranges.get_by_priority_range("IDX_ON", 2, 3);
+    EXPECT_EQ(by_priority.size(), ranges.get_by_priority_range("IDX_OFF", 2, 3).size());
+    EXPECT_TRUE(std::is_sorted(by_priority.begin(), by_priority.end(),
+                               [](const Node& a, const Node& b) { return a.priority < b.priority; }));
+
+    std::vector<Node> top = ranges.get_top_n("IDX_ON", 5);
+    ASSERT_EQ(top.size(), 5u);
+    for (const Node& node : top) EXPECT_EQ(node.priority, 6);
+
+    std::vector<Node> all = ranges.get_by_timestamp_range("IDX_ON", 0, UINT64_MAX);
+    ASSERT_EQ(all.size(), 60u);
+    for (size_t i = 1; i < all.size(); ++i) EXPECT_LE(all[i - 1].timestamp_ns, all[i].timestamp_ns);
+
+    // Pops, removes and expiry sweeps all leave the index
+    {
+        EpochGuard guard;
+        Node* popped = cache_->get_highest_priority(indexed);
+        ASSERT_NE(popped, nullptr);
+        EXPECT_EQ(popped->priority, 6);
+    }
+    EXPECT_EQ(ranges.get_top_n("IDX_ON", 60).size(), 59u);
+    ASSERT_TRUE(cache_->remove(indexed, 15.0));
+    EXPECT_EQ(ranges.get_range("IDX_ON", 15.0, 15.0).size(), 0u);
+    ASSERT_TRUE(cache_->insert(500.0, indexed, 0, 0.001));
+    EXPECT_EQ(ranges.get_range("IDX_ON", 500.0, 500.0).size(), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(cache_->expiry_engine().run(CoarseClock::now(), 100), 1u);
+    EXPECT_EQ(ranges.get_range("IDX_ON", 500.0, 500.0).size(), 0u);
+    EXPECT_EQ(cache_->index(indexed)->size(), 58u);
+
+    // Queries race inserts and pops without ever seeing a recycled slot
+    std::atomic<bool> done{false};
+    std::atomic<bool> inconsistent{false};
+    std::thread reader([&]() {
+        while (!done.load()) {
+            std::vector<Node> snapshot = ranges.get_range(indexed, 0.0, 1000.0);
+            for (const Node& node : snapshot) {
+                if (node.symbol != indexed) inconsistent = true;
+            }
+            for (size_t i = 1; i < snapshot.size(); ++i) {
+                if (snapshot[i].value < snapshot[i - 1].value) inconsistent = true;
+            }
+        }
+    });
+    std::thread writer([&]() {
+        for (int i = 0; i < 2000; ++i) {
+            cache_->insert(static_cast<double>(i % 100), indexed, i % 5);
+            EpochGuard guard;
+            cache_->get_highest_priority(indexed);
+        }
+    });
+    writer.join();
+    done = true;
+    reader.join();
+    EXPECT_FALSE(inconsistent);
+
+    size_t queued = cache_->index(indexed)->size();
+    EXPECT_EQ(cache_->clear(), queued + 60u);
+    EXPECT_EQ(cache_->index(indexed)->size(), 0u);
+    EXPECT_TRUE(ranges.get_range("IDX_ON", 0.0, 1000.0).empty());
+}
+
+TEST_F(HFTCacheTest, SkipListTopNAndRanges) {
+    using namespace hft_cache;
+    // A height-one tower is a quarter of a cache line, not MAX_LEVEL pointers
+    EXPECT_LE(SkipNode::bytes_for(1), 32u);
+
+    LockFreeSkipList list(config_);
+    SymbolId bids = SymbolRegistry::global().intern("SKIP_BIDS");
+    SymbolId asks = SymbolRegistry::global().intern("SKIP_ASKS");
+    for (int i = 0; i < 2000; ++i) {
+        Node* bid = new Node(100.0 + i, i % 50);
+        bid->symbol = bids;
+        ASSERT_TRUE(list.insert(bid));
+        Node* ask = new Node(200.0 + i, i % 50);
+        ask->symbol = asks;
+        ASSERT_TRUE(list.insert(ask));
+        if (i == 0) { EXPECT_FALSE(list.insert(ask)); }
+    }
+    EXPECT_EQ(list.size(), 4000u);
+    EXPECT_TRUE(list.validate_skip_list());
+    // p = 1/4 gives towers of 4/3 levels on average
+    EXPECT_NEAR(list.get_average_level(), 4.0 / 3.0, 0.15);
+
+    EpochGuard guard;
+    Node* best = list.get_highest_priority(bids);
+    ASSERT_NE(best, nullptr);
+    EXPECT_EQ(best->priority, 49);
+    EXPECT_EQ(best->symbol, bids);
+
+    Node* top[100];
+    ASSERT_EQ(list.get_top_n(asks, 100, top), 100u);
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(top[i]->symbol, asks);
+        EXPECT_GE(top[i]->priority, 47);
+        if (i) { EXPECT_LE(top[i]->priority, top[i - 1]->priority); }
+    }
+    EXPECT_EQ(list.get_top_n(bids, 10000).size(), 2000u);
+
+    std::vector<Node*> band = list.get_by_priority_range(bids, 10, 12);
+    EXPECT_EQ(band.size(), 120u);
+    for (Node* node : band) {
+        EXPECT_GE(node->priority, 10);
+        EXPECT_LE(node->priority, 12);
+    }
+    EXPECT_EQ(list.get_range(asks, 200.0, 209.0).size(), 10u);
+
+    ASSERT_NE(list.find(bids, 149.0), nullptr);
+    EXPECT_TRUE(list.remove(bids, 149.0));
+    EXPECT_FALSE(list.remove(bids, 149.0));
+    EXPECT_EQ(list.find(bids, 149.0), nullptr);
+    EXPECT_EQ(list.size(), 3999u);
+    EXPECT_TRUE(list.validate_skip_list());
+
+    size_t walked = 0;
+    for (auto it = list.begin(); it != list.end(); ++it) ++walked;
+    EXPECT_EQ(walked, 3999u);
+    list.clear();
+    EXPECT_EQ(list.size(), 0u);
+    EXPECT_EQ(list.get_highest_priority(bids), nullptr);
+}
+
+TEST_F(HFTCacheTest, SkipListConcurrentInsertsAndRemoves) {
+    using namespace hft_cache;
+    LockFreeSkipList list(config_);
+    SymbolId symbol = SymbolRegistry::global().intern("SKIP_CONCURRENT");
+    const int writers = 4;
+    const int per_writer = 5000;
+    std::atomic<bool> done{false};
+    std::atomic<bool> unordered{false};
+
+    std::thread reader([&]() {
+        Node* top[64];
+        while (!done.load()) {
+            EpochGuard guard;
+            size_t found = list.get_top_n(symbol, 64, top);
+            for (size_t i = 1; i < found; ++i) {
+                if (top[i]->priority > top[i - 1]->priority) unordered = true;
+            }
+        }
+    });
+    // Every writer inserts its own values and removes every other one
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < per_writer; ++i) {
+                double value = static_cast<double>(i * writers + t);
+                Node* node = new Node(value, i % 100);
+                node->symbol = symbol;
+                list.insert(node);
+                if (i % 2) list.remove(symbol, value - writers);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    done = true;
+    reader.join();
+
+    EXPECT_FALSE(unordered);
+    EXPECT_EQ(list.size(), static_cast<size_t>(writers * per_writer / 2));
+    EXPECT_TRUE(list.validate_skip_list());
+    EpochGuard guard;
+    for (int t = 0; t < writers; ++t) {
+        EXPECT_NE(list.find(symbol, static_cast<double>(writers + t)), nullptr);
+        EXPECT_EQ(list.find(symbol, static_cast<double>(t)), nullptr);
+    }
+}
+
+TEST_F(HFTCacheTest, BlockedBloomFilter) {
+    using namespace hft_cache;
+    constexpr size_t KEYS = 50000;
+    std::vector<uint64_t> absent(KEYS);
+    for (size_t i = 0; i < KEYS; ++i) absent[i] = BloomFilter::hash_key(uint64_t(KEYS + i));
+
+    std::vector<bool> scalar_answers;
+    for (SIMDLevel level : {SIMDLevel::SCALAR, detect_simd_level()}) {
+        BloomFilter filter(KEYS, 0.01, level);
+        EXPECT_EQ(filter.get_bit_array_size() % 512, 0u);
+        for (size_t i = 0; i < KEYS; ++i) filter.add(BloomFilter::hash_key(uint64_t(i)));
+        filter.add("SPY");
+        EXPECT_TRUE(filter.might_contain("SPY"));
+
+        for (size_t i = 0; i < KEYS; ++i) {
+            ASSERT_TRUE(filter.might_contain(BloomFilter::hash_key(uint64_t(i))));
+        }
+        // The batch probe agrees with single probes, and both levels agree
+        std::unique_ptr<bool[]> batch(new bool[KEYS]);
+        size_t hits = filter.might_contain_many(absent.data(), KEYS, batch.get());
+        size_t single = 0;
+        for (size_t i = 0; i < KEYS; ++i) {
+            bool answer = filter.might_contain(absent[i]);
+            ASSERT_EQ(batch[i], answer);
+            single += answer;
+            if (level == SIMDLevel::SCALAR) {
+                scalar_answers.push_back(answer);
+            } else {
+                ASSERT_EQ(scalar_answers[i], answer);
+            }
+        }
+        EXPECT_EQ(hits, single);
+        EXPECT_LT(static_cast<double>(hits) / KEYS, 0.02);
+
+        filter.clear();
+        EXPECT_EQ(filter.get_added_elements(), 0u);
+        EXPECT_FALSE(filter.might_contain(BloomFilter::hash_key(uint64_t(0))));
+    }
+}
+
+TEST_F(HFTCacheTest, CuckooFilterDeletes) {
+    using namespace hft_cache;
+    constexpr size_t KEYS = 20000;
+    CuckooFilter filter(KEYS);
+    CountingBloomFilter counting(KEYS);
+    // Well under the counting filter's eight bits per counter
+    EXPECT_LT(8.0 * filter.memory_bytes() / KEYS, 8.0 * counting.memory_bytes() / KEYS / 2);
+
+    auto key = [](size_t i) { return BloomFilter::hash_key(uint64_t(i)); };
+    for (size_t i = 0; i < KEYS; ++i) ASSERT_TRUE(filter.add(key(i)));
+    EXPECT_EQ(filter.size(), KEYS);
+    EXPECT_NEAR(filter.get_saturation_rate(), static_cast<double>(KEYS) / (filter.get_bucket_count() * 4), 1e-9);
+    for (size_t i = 0; i < KEYS; ++i) ASSERT_TRUE(filter.might_contain(key(i)));
+    size_t false_positives = 0;
+    for (size_t i = KEYS; i < 11 * KEYS; ++i) false_positives += filter.might_contain(key(i));
+    EXPECT_LT(static_cast<double>(false_positives) / (10 * KEYS), 1e-3);
+
+    // Churn: remove the even keys and add as many new ones, twice over
+    for (size_t round = 1; round <= 2; ++round) {
+        for (size_t i = 0; i < KEYS; i += 2) ASSERT_TRUE(filter.remove(key(i + (round - 1) * 4 * KEYS)));
+        for (size_t i = 0; i < KEYS; i += 2) ASSERT_TRUE(filter.add(key(i + round * 4 * KEYS)));
+        EXPECT_EQ(filter.size(), KEYS);
+    }
+    for (size_t i = 1; i < KEYS; i += 2) EXPECT_TRUE(filter.might_contain(key(i)));
+    for (size_t i = 0; i < KEYS; i += 2) EXPECT_TRUE(filter.might_contain(key(i + 8 * KEYS)));
+    EXPECT_TRUE(filter.add("SPY"));
+    EXPECT_TRUE(filter.remove("SPY"));
+    EXPECT_FALSE(filter.remove("SPY"));
+
+    // Past capacity adds start to fail, but nothing added is ever lost
+    CuckooFilter small(64);
+    size_t added = 0;
+    while (added < 4 * small.get_bucket_count() && small.add(key(added))) ++added;
+    EXPECT_GT(added, 0.9 * 4 * small.get_bucket_count());
+    for (size_t i = 0; i < added; ++i) EXPECT_TRUE(small.might_contain(key(i)));
+    for (size_t i = 0; i < added; ++i) ASSERT_TRUE(small.remove(key(i)));
+    EXPECT_EQ(small.size(), 0u);
+    EXPECT_EQ(small.get_saturation_rate(), 0.0);
+
+    // Readers racing writers whose keys stay put never see a false negative,
+    // at a load where most adds evict
+    CuckooFilter shared(2000);
+    for (size_t i = 0; i < 2000; ++i) ASSERT_TRUE(shared.add(key(i)));
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> misses{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 2; ++t) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                for (size_t i = 0; i < 2000; ++i) misses += !shared.might_contain(key(i));
+            }
+        });
+    }
+    size_t failed = 0;
+    for (size_t round = 0; round < 20; ++round) {
+        for (size_t i = 0; i < 1500; ++i) failed += !shared.add(key(100000 + i));
+        for (size_t i = 0; i < 1500; ++i) failed += !shared.remove(key(100000 + i));
+    }
+    stop = true;
+    for (auto& reader : readers) reader.join();
+    EXPECT_EQ(failed, 0u);
+    EXPECT_EQ(misses.load(), 0u);
+    EXPECT_EQ(shared.size(), 2000u);
+}
+
+TEST_F(HFTCacheTest, MetricsLatencyHistograms) {
+    // Every bucket that holds a value tops out within 1/32 of it
+    for (uint64_t ns : {uint64_t(0), uint64_t(31), uint64_t(32), uint64_t(1000), uint64_t(12345),
+                        uint64_t(1) << 30, uint64_t(123456789012)}) {
+        size_t bucket = LatencyHistogram::bucket_of(ns);
+        uint64_t upper = LatencyHistogram::upper_bound_ns(bucket);
+        EXPECT_GE(upper, ns);
+        EXPECT_LE(upper - ns, ns / 32);
+        if (bucket > 0) { EXPECT_LT(LatencyHistogram::upper_bound_ns(bucket - 1), ns); }
+    }
+
+    namespace fs = std::filesystem;
+    CacheConfig config = config_;
+    config.metrics_file = (fs::temp_directory_path() / ("hft_metrics_" + std::to_string(
+        std::chrono::steady_clock::now().time_since_epoch().count()) + ".csv")).string();
+    config.metrics_interval_ms = 5;
+    {
+        MetricsCollector metrics(config);
+
+        // The hot path: a thread-local lookup and stores to this thread's shard
+        constexpr size_t CALLS = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < CALLS; ++i) metrics.record_retrieve(100 + (i & 63), true, i & 1);
+        double ns_per_call = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                             CALLS;
+        // Against the shared counters it replaced: three fetch_adds a call
+        std::atomic<uint64_t> retrieves{0}, latency{0}, hits{0};
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < CALLS; ++i) {
+            retrieves.fetch_add(1);
+            latency.fetch_add(100 + (i & 63));
+            if (i & 1) hits.fetch_add(1);
+        }
+        double shared_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                           CALLS;
+        std::cout << "record_retrieve: " << ns_per_call << " ns per call, shared atomics " << shared_ns << " ns"
+                  << std::endl;
+        EXPECT_EQ(hits.load(), CALLS / 2);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&metrics, t] {
+                for (uint64_t ns = 1; ns <= 10000; ++ns) metrics.record_insert(ns, ns % 100 != 0);
+                if (t == 0) metrics.record_insert(5000000);  // one stall, which an average would hide
+                metrics.record_thread_contention(250 * (t + 1));
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        // Threads that exit before the next binds hand it their shard
+        size_t shards = metrics.thread_shards();
+        EXPECT_GE(shards, 2u);
+        EXPECT_LE(shards, 5u);
+        std::thread([&metrics] { metrics.record_batch_insert(800, 16); }).join();
+        EXPECT_EQ(metrics.thread_shards(), shards);
+
+        LatencySummary inserts = metrics.get_latency(MetricOp::INSERT);
+        EXPECT_EQ(inserts.count, 40001u);
+        EXPECT_NEAR(static_cast<double>(inserts.p50_ns), 5000.0, 5000.0 / 32);
+        EXPECT_NEAR(static_cast<double>(inserts.p99_ns), 9900.0, 9900.0 / 32);
+        EXPECT_NEAR(static_cast<double>(inserts.p999_ns), 9990.0, 9990.0 / 32);
+        EXPECT_EQ(inserts.max_ns, 5000000u);
+        EXPECT_GT(inserts.mean_ns, 5000.0);
+
+        CacheMetrics snapshot = metrics.get_current_metrics();
+        EXPECT_EQ(snapshot.total_inserts, 40001u);
+        EXPECT_EQ(snapshot.insert_errors, 400u);
+        EXPECT_EQ(snapshot.total_retrieves, CALLS);
+        EXPECT_DOUBLE_EQ(snapshot.hit_rate(), 0.5);
+        EXPECT_EQ(snapshot.total_batch_inserts, 1u);
+        EXPECT_EQ(snapshot.total_batch_items, 16u);
+        EXPECT_EQ(snapshot.thread_contention_count, 4u);
+        EXPECT_EQ(snapshot.lock_wait_time, 2500u);
+        EXPECT_EQ(snapshot.latency_of(MetricOp::LOCK_WAIT).max_ns, 1000u);
+
+        // The worker merges once per interval into history and the file
+        for (int i = 0; i < 200 && metrics.get_historical_data().empty(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_FALSE(metrics.get_historical_data().empty());
+    }
+    std::ifstream file(config.metrics_file);
+    std::string header;
+    std::getline(file, header);
+    EXPECT_NE(header.find("insert_p999_ns"), std::string::npos);
+    fs::remove(config.metrics_file);
+}
+
+TEST_F(HFTCacheTest, InstrumentationTimers) {
+    CacheConfig config = config_;
+    config.enable_metrics = true;
+    config.metrics_file = (std::filesystem::temp_directory_path() / "hft_instrumentation_metrics.csv").string();
+    MetricsCollector metrics(config);
+    MetricsCollector* previous = g_metrics;
+    g_metrics = &metrics;
+
+    constexpr size_t CALLS = 1000;
+    for (size_t i = 0; i < CALLS; ++i) {
+        HFT_TIMED_SCOPE(insert);
+    }
+    for (size_t i = 0; i < CALLS; ++i) {
+        HFT_LATENCY_TIMER(timer);
+        HFT_RECORD_LATENCY(timer, retrieve, true, i % 4 != 0);
+    }
+    {
+        HFT_LATENCY_TIMER(timer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        HFT_RECORD_LATENCY(timer, batch_insert, 8);
+    }
+    g_metrics = previous;
+
+    CacheMetrics snapshot = metrics.get_current_metrics();
+    size_t timed = instrumentation::SAMPLE_EVERY == 0 ? 0 : CALLS / instrumentation::SAMPLE_EVERY;
+    EXPECT_NEAR(static_cast<double>(snapshot.total_inserts), static_cast<double>(timed), 1.0);
+    EXPECT_NEAR(static_cast<double>(snapshot.total_retrieves), static_cast<double>(timed), 1.0);
+    if (instrumentation::SAMPLE_EVERY == 1) {
+        EXPECT_EQ(snapshot.cache_misses, CALLS / 4);
+        // The rdtscp scale agrees with steady_clock across a sleep
+        const LatencySummary& slept = snapshot.latency_of(MetricOp::BATCH_INSERT);
+        ASSERT_EQ(slept.count, 1u);
+        EXPECT_GE(slept.max_ns, 1900000u);
+        EXPECT_LT(slept.max_ns, 200000000u);
+        // An empty scope costs two counter reads, not two chrono calls
+        EXPECT_LT(snapshot.latency_of(MetricOp::INSERT).p50_ns, 1000u);
+    }
+    std::filesystem::remove(config.metrics_file);
+}
+
+TEST_F(HFTCacheTest, MetricsRegionPublishing) {
+    auto directory = std::filesystem::temp_directory_path() / "hft_metrics_region_test";
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "region").string();
+
+    // The ring keeps the newest HISTORY samples, numbered consecutively
+    {
+        MetricsRegionWriter writer(path, 10);
+        ASSERT_TRUE(writer.shared());
+        MetricsReader reader(path);
+        ASSERT_TRUE(reader.valid());
+        EXPECT_EQ(reader.interval_ms(), 10u);
+        MetricsSample sample;
+        EXPECT_FALSE(reader.latest(sample));
+
+        // Every sample carries total_retrieves = 3 * sequence, which the
+        // torn-read check below relies on from the first one it can see
+        const size_t total = MetricsRegion::HISTORY + 300;
+        for (size_t i = 1; i <= total; ++i) {
+            sample.metrics.total_inserts = i;
+            sample.metrics.total_retrieves = i * 3;
+            writer.publish(sample);
+        }
+        ASSERT_TRUE(reader.latest(sample));
+        EXPECT_EQ(sample.sequence, total);
+        EXPECT_EQ(sample.metrics.total_inserts, total);
+
+        std::vector<MetricsSample> history;
+        ASSERT_EQ(reader.history(history), MetricsRegion::HISTORY);
+        for (size_t i = 0; i < history.size(); ++i) {
+            EXPECT_EQ(history[i].sequence, total - MetricsRegion::HISTORY + 1 + i);
+            EXPECT_EQ(history[i].metrics.total_inserts, history[i].sequence);
+        }
+        history.clear();
+        EXPECT_EQ(reader.history(history, 5), 5u);
+        EXPECT_EQ(history.back().sequence, total);
+
+        // Readers poll while the writer publishes and never see a torn sample
+        std::atomic<bool> done{false};
+        std::atomic<int> torn{0};
+        std::thread poller([&] {
+            MetricsReader concurrent(path);
+            MetricsSample seen;
+            while (!done.load()) {
+                if (concurrent.latest(seen) && seen.metrics.total_retrieves != seen.sequence * 3) torn++;
+            }
+        });
+        for (size_t i = 0; i < 20000; ++i) {
+            sample.metrics.total_retrieves = (total + i + 1) * 3;
+            writer.publish(sample);
+        }
+        done = true;
+        poller.join();
+        EXPECT_EQ(torn.load(), 0);
+    }
+    EXPECT_FALSE(MetricsReader((directory / "missing").string()).valid());
+
+    // The collector publishes each interval into the configured region
+    CacheConfig config = config_;
+    config.enable_metrics = true;
+    config.metrics_interval_ms = 5;
+    config.metrics_file = (directory / "metrics.csv").string();
+    config.metrics_region_path = path;
+    {
+        MetricsCollector metrics(config);
+        for (int i = 0; i < 100; ++i) metrics.record_insert(200);
+        for (int i = 0; i < 40; ++i) metrics.record_retrieve(100, true, i % 2 == 0);
+        MetricsReader reader(path);
+        ASSERT_TRUE(reader.valid());
+        MetricsSample sample;
+        for (int i = 0; i < 400 && !(reader.latest(sample) && sample.metrics.total_retrieves == 40); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(sample.metrics.total_inserts, 100u);
+        EXPECT_EQ(sample.metrics.cache_misses, 20u);
+        EXPECT_GT(sample.unix_ns, 0u);
+        EXPECT_FALSE(metrics.get_historical_data().empty());
+        EXPECT_EQ(metrics.get_historical_data().back().metrics.total_inserts, 100u);
+
+        std::string text = format_prometheus(sample);
+        EXPECT_NE(text.find("hft_cache_operations_total{op=\"insert\"} 100\n"), std::string::npos);
+        EXPECT_NE(text.find("hft_cache_misses_total 20\n"), std::string::npos);
+        EXPECT_NE(text.find("# TYPE hft_cache_latency_ns summary\n"), std::string::npos);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(HFTCacheTest, BatchSpanOperations) {
+    CacheConfig config = config_;
+    config.max_nodes = 40000;
+    RadialCircularList list(config);
+    SymbolRegistry& symbols = SymbolRegistry::global();
+    SymbolId ids[3] = {symbols.intern("SPAN_A"), symbols.intern("SPAN_B"), symbols.intern("SPAN_C")};
+
+    // An interleaved burst is grouped by symbol and stamped once
+    InsertRecord burst[30];
+    for (int i = 0; i < 30; ++i) burst[i] = InsertRecord{100.0 + i, ids[i % 3], i, 60.0};
+    EXPECT_EQ(list.insert_batch(burst), 30u);
+    std::vector<Node> queued;
+    for (SymbolId id : ids) list.snapshot_shard(id, 0, queued);
+    ASSERT_EQ(queued.size(), 30u);
+    for (const Node& node : queued) {
+        EXPECT_EQ(node.timestamp_ns, queued[0].timestamp_ns);
+        EXPECT_EQ(node.symbol, ids[node.priority % 3]);
+    }
+
+    // Repeated symbols get their best nodes in request order
+    {
+        EpochGuard guard;
+        SymbolId requests[6] = {ids[0], ids[1], ids[0], symbols.intern("SPAN_EMPTY"), ids[0], INVALID_SYMBOL_ID};
+        Node* out[6];
+        EXPECT_EQ(list.get_highest_priority_batch(requests, out), 4u);
+        ASSERT_TRUE(out[0] && out[1] && out[2] && out[4]);
+        EXPECT_EQ(out[0]->priority, 27);
+        EXPECT_EQ(out[2]->priority, 24);
+        EXPECT_EQ(out[4]->priority, 21);
+        EXPECT_EQ(out[1]->priority, 28);
+        EXPECT_EQ(out[3], nullptr);
+        EXPECT_EQ(out[5], nullptr);
+    }
+
+    // Slots are taken all or nothing; a full heap queues what fits
+    RadialCircularList small(20);
+    std::vector<InsertRecord> too_many(21, InsertRecord{1.0, ids[0], 0, 60.0});
+    EXPECT_EQ(small.insert_batch(Span<const InsertRecord>(too_many)), 0u);
+    std::vector<InsertRecord> crowded(5, InsertRecord{1.0, ids[1], 0, 60.0});
+    EXPECT_EQ(small.insert_batch(Span<const InsertRecord>(crowded)), 2u);
+    EXPECT_EQ(small.insert_batch(Span<const InsertRecord>(crowded)), 0u);
+    crowded.assign(18, InsertRecord{1.0, ids[2], 0, 60.0});
+    for (size_t i = 0; i < crowded.size(); ++i) crowded[i].symbol = symbols.intern("SPAN_FILL_" + std::to_string(i % 9));
+    EXPECT_EQ(small.insert_batch(Span<const InsertRecord>(crowded)), 18u);
+
+    // Per-item cost of packet-sized bursts against one call per item
+    constexpr size_t PACKETS = 300, PER_PACKET = 64, TICKERS = 8;
+    SymbolId tickers[TICKERS];
+    for (size_t i = 0; i < TICKERS; ++i) tickers[i] = symbols.intern("SPAN_FEED_" + std::to_string(i));
+    std::vector<InsertRecord> feed(PACKETS * PER_PACKET);
+    std::vector<SymbolId> wanted(feed.size());
+    std::mt19937 gen(29);
+    for (size_t i = 0; i < feed.size(); ++i) {
+        feed[i] = InsertRecord{100.0 + static_cast<double>(i), tickers[gen() % TICKERS], static_cast<int>(gen() % 100), 60.0};
+        wanted[i] = feed[i].symbol;
+    }
+    list.clear();
+    double single_insert = 0.0, batch_insert = 0.0, single_get = 0.0, batch_get = 0.0;
+    {
+        EpochGuard guard;
+        auto start = std::chrono::steady_clock::now();
+        for (const InsertRecord& record : feed) list.insert(record.value, record.symbol, record.priority, record.expiry_seconds);
+        auto middle = std::chrono::steady_clock::now();
+        for (SymbolId id : wanted) list.get_highest_priority(id);
+        auto end = std::chrono::steady_clock::now();
+        single_insert = std::chrono::duration<double, std::nano>(middle - start).count() / feed.size();
+        single_get = std::chrono::duration<double, std::nano>(end - middle).count() / feed.size();
+    }
+    {
+        EpochGuard guard;
+        std::vector<Node*> out(PER_PACKET);
+        size_t inserted = 0, found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < PACKETS; ++p) {
+            inserted += list.insert_batch(Span<const InsertRecord>(feed.data() + p * PER_PACKET, PER_PACKET));
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (size_t p = 0; p < PACKETS; ++p) {
+            found += list.get_highest_priority_batch(Span<const SymbolId>(wanted.data() + p * PER_PACKET, PER_PACKET), Span<Node*>(out));
+        }
+        auto end = std::chrono::steady_clock::now();
+        EXPECT_EQ(inserted, feed.size());
+        EXPECT_EQ(found, feed.size());
+        batch_insert = std::chrono::duration<double, std::nano>(middle - start).count() / feed.size();
+        batch_get = std::chrono::duration<double, std::nano>(end - middle).count() / feed.size();
+    }
+    std::cout << "Per item, single vs batch of " << PER_PACKET << ": insert " << single_insert << " / " << batch_insert
+              << " ns, get " << single_get << " / " << batch_get << " ns" << std::endl;
+}
+
+TEST_F(HFTCacheTest, SharedMemoryReaders) {
+    std::string name = "/hft_cache_test_" + std::to_string(::getpid());
+    CacheConfig config = config_;
+    config.max_nodes = 2000;
+    SharedRadialList writer(name, config, 16, 500);
+    ASSERT_TRUE(writer.valid());
+    ASSERT_TRUE(writer.writer());
+    SymbolId aapl = writer.intern("AAPL");
+    SymbolId msft = writer.intern("MSFT");
+    EXPECT_EQ(writer.intern("AAPL"), aapl);
+    EXPECT_EQ(writer.intern("A_TICKER_TOO_LONG"), INVALID_SYMBOL_ID);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(writer.insert(100.0 + i, aapl, i));
+        ASSERT_TRUE(writer.insert(200.0 + i, msft, 99 - i));
+    }
+    EXPECT_EQ(writer.free_slots(), 1800u);
+
+    // A second mapping sees the same structure through offsets alone
+    {
+        SharedRadialList reader(name);
+        ASSERT_TRUE(reader.valid());
+        EXPECT_FALSE(reader.writer());
+        EXPECT_EQ(reader.find("AAPL"), aapl);
+        EXPECT_EQ(reader.find("GOOG"), INVALID_SYMBOL_ID);
+        EXPECT_FALSE(reader.insert(1.0, aapl, 1));
+        Node node;
+        ASSERT_TRUE(reader.peek_highest_priority(aapl, node));
+        EXPECT_EQ(node.priority, 99);
+        ASSERT_TRUE(reader.get_highest_priority("AAPL", node));
+        EXPECT_EQ(node.priority, 99);
+        EXPECT_DOUBLE_EQ(node.value, 199.0);
+        ASSERT_TRUE(reader.peek_highest_priority(aapl, node));
+        EXPECT_EQ(node.priority, 98);
+    }
+    EXPECT_EQ(writer.size(aapl), 99u);
+    EXPECT_FALSE(SharedRadialList(name + "_missing").valid());
+
+    // Another process pops while this one keeps ingesting
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        SharedRadialList reader(name);
+        int status = reader.valid() ? 0 : 1;
+        Node node;
+        int last = 1000;
+        for (int i = 0; i < 50 && status == 0; ++i) {
+            if (!reader.get_highest_priority(reader.find("MSFT"), node)) status = 2;
+            else if (node.priority > last || node.symbol != reader.find("MSFT")) status = 3;
+            last = node.priority;
+        }
+        ::_exit(status);
+    }
+    for (int i = 0; i < 100; ++i) writer.insert(300.0 + i, aapl, -1);
+    int status = -1;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(writer.size(msft), 50u);
+    EXPECT_EQ(writer.size(aapl), 199u);
+    EXPECT_EQ(writer.free_slots(), 2000u - 249u);
+
+    // Expired nodes are dropped by pops and sweeps and their slots come back
+    SymbolId spy = writer.intern("SPY");
+    for (int i = 0; i < 10; ++i) writer.insert(1.0, spy, i, 0.000001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    Node node;
+    EXPECT_FALSE(writer.peek_highest_priority(spy, node));
+    EXPECT_EQ(writer.purge_expired(spy), 10u);
+    EXPECT_EQ(writer.size(spy), 0u);
+    EXPECT_FALSE(writer.get_highest_priority(spy, node));
+    EXPECT_EQ(writer.free_slots(), 2000u - 249u);
+}
+
+TEST_F(HFTCacheTest, SecurityCapabilityTokens) {
+    CacheConfig config = config_;
+    config.audit_ring_entries = 4;
+    config.audit_flush_interval_ms = 1000;
+    SecurityManager security(config);
+
+    ASSERT_TRUE(security.create_user("trader", "secret", PermissionLevel::READ_WRITE));
+    ASSERT_TRUE(security.set_allowed_symbols("trader", {"AAPL", "MSFT"}));
+    EXPECT_FALSE(security.open_session("trader", "wrong").valid());
+    SecuritySession session = security.open_session("trader", "secret");
+    ASSERT_TRUE(session.valid());
+
+    SymbolId aapl = SymbolRegistry::global().intern("AAPL");
+    SymbolId goog = SymbolRegistry::global().intern("GOOG");
+    EXPECT_TRUE(security.authorize(session, OperationType::READ, aapl));
+    EXPECT_TRUE(security.authorize(session, OperationType::WRITE, aapl));
+    EXPECT_FALSE(security.authorize(session, OperationType::WRITE, goog));
+    EXPECT_FALSE(security.authorize(session, OperationType::DELETE, aapl));
+    EXPECT_TRUE(security.authorize_operation("trader", OperationType::READ, "MSFT"));
+    EXPECT_FALSE(security.authorize_operation("trader", OperationType::READ, "NEVER_INTERNED"));
+    EXPECT_FALSE(security.authorize_operation("nobody", OperationType::READ));
+
+    // Policy changes reach an open session through a new token
+    uint64_t version;
+    {
+        EpochGuard guard;
+        version = security.current_token(session)->version;
+    }
+    ASSERT_TRUE(security.update_user_permissions("trader", PermissionLevel::READ_ONLY));
+    EXPECT_FALSE(security.authorize(session, OperationType::WRITE, aapl));
+    EXPECT_TRUE(security.authorize(session, OperationType::READ, aapl));
+    {
+        EpochGuard guard;
+        EXPECT_EQ(security.current_token(session)->version, version + 1);
+    }
+    ASSERT_TRUE(security.set_allowed_symbols("trader", {}));
+    EXPECT_TRUE(security.authorize(session, OperationType::READ, goog));
+
+    // Denials are queued, not logged, until the flusher or flush_audit_log;
+    // four fit in the ring
+    security.flush_audit_log();
+    size_t logged = security.get_audit_log("trader", 1000).size();
+    EXPECT_EQ(security.dropped_audit_entries(), 0u);
+    for (int i = 0; i < 6; ++i) EXPECT_FALSE(security.authorize(session, OperationType::DELETE));
+    EXPECT_EQ(security.get_audit_log("trader", 1000).size(), logged);
+    EXPECT_EQ(security.dropped_audit_entries(), 2u);
+    security.flush_audit_log();
+    std::vector<AuditLogEntry> log = security.get_audit_log("trader", 1000);
+    ASSERT_EQ(log.size(), logged + 4);
+    EXPECT_EQ(log.back().operation, "AUTHORIZATION");
+    EXPECT_EQ(log.back().details, "Insufficient permissions");
+
+    // Each session refills its own bucket; a full one admits a burst of one
+    // second's worth
+    security.set_rate_limit("trader", 50);
+    size_t allowed = 0;
+    for (int i = 0; i < 200; ++i) allowed += security.allow(session, OperationType::READ);
+    EXPECT_GE(allowed, 50u);
+    EXPECT_LT(allowed, 60u);
+    SecuritySession other = security.open_session("trader", "secret");
+    EXPECT_TRUE(security.allow(other, OperationType::READ));
+    security.set_rate_limit("trader", 0);
+
+    // A ticker that was never interned looks up as INVALID_SYMBOL_ID, which
+    // no scoped token allows; a check naming no symbol skips the scope
+    ASSERT_TRUE(security.set_allowed_symbols("trader", {"AAPL"}));
+    EXPECT_FALSE(security.authorize(session, OperationType::READ, SymbolRegistry::global().find("NEVER_INTERNED")));
+    EXPECT_FALSE(security.authorize(session, OperationType::READ, INVALID_SYMBOL_ID));
+    EXPECT_TRUE(security.authorize(session, OperationType::READ));
+
+    ASSERT_TRUE(security.deactivate_user("trader"));
+    EXPECT_FALSE(security.authorize(session, OperationType::READ, aapl));
+
+    // Readers check while an admin keeps swapping the reader's policy. The
+    // swaps only start once every reader is checking, and go on until there
+    // have been both SWAPS of them and CHECKS more checks, so the two overlap
+    ASSERT_TRUE(security.open_session("reader", "reader123").valid());
+    const int READERS = 4;
+    const size_t SWAPS = 200;
+    const uint64_t CHECKS = 20000;
+    std::atomic<bool> stop{false};
+    std::atomic<int> started{0};
+    std::atomic<uint64_t> checks{0};
+    std::atomic<uint64_t> refused{0};
+    std::atomic<uint64_t> token_changes{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < READERS; ++t) {
+        readers.emplace_back([&] {
+            SecuritySession mine = security.open_session("reader", "reader123");
+            uint64_t last_version = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!security.authorize(mine, OperationType::READ, aapl)) refused.fetch_add(1);
+                uint64_t version;
+                {
+                    EpochGuard guard;
+                    version = security.current_token(mine)->version;
+                }
+                if (last_version == 0) {
+                    started.fetch_add(1);
+                } else if (version != last_version) {
+                    token_changes.fetch_add(1, std::memory_order_relaxed);
+                }
+                last_version = version;
+                checks.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    while (started.load() < READERS) std::this_thread::yield();
+    uint64_t checks_before = checks.load();
+    size_t swaps = 0;
+    while (swaps < SWAPS || checks.load() - checks_before < CHECKS) {
+        security.set_allowed_symbols("reader", swaps % 2 ? std::vector<std::string>{} : std::vector<std::string>{"AAPL"});
+        security.set_rate_limit("reader", 1000 + swaps % 100);
+        ++swaps;
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& reader : readers) reader.join();
+    EXPECT_EQ(refused.load(), 0u);
+    EXPECT_GT(token_changes.load(), 0u);
+}
+
 // Stress tests
 TEST_F(HFTCacheTest, HighLoadStressTest) {
     const size_t num_operations = 10000;
@@ -224,7 +2605,8 @@ TEST_F(HFTCacheTest, MemoryLeakTest) {
         cache_->insert(100.0 + i, "AAPL", i % 10, 60.0);
     }
     
-    // Retrieve all nodes
+    // Retrieve all nodes, keeping them readable until the checks below
+    EpochGuard guard;
     for (size_t i = 0; i < num_operations; ++i) {
         Node* node = cache_->get_highest_priority("AAPL");
         if (node) {
@@ -325,6 +2707,316 @@ TEST_F(HFTCacheTest, PerformanceBenchmark) {
     EXPECT_LT(retrieve_avg, 5000);   // Average retrieve should be < 5µs
 }
 
+TEST_F(HFTCacheTest, PriorityQueueThroughputScaling) {
+    const size_t ops_per_run = 400000;
+    const size_t shards = 8;
+    std::vector<Node> nodes(1024);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].priority = static_cast<int>(i % 97);
+    }
+
+    double single_thread_mops = 0.0;
+    for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+        ConcurrentPriorityQueue queue(nodes.size(), shards);
+        std::atomic<size_t> pops{0};
+        size_t ops_per_thread = ops_per_run / num_threads;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                Node* node = &nodes[t % nodes.size()];
+                for (size_t i = 0; i < ops_per_thread; i += 2) {
+                    queue.push(node);
+                    if (Node* top = queue.pop()) {
+                        node = top;
+                        pops.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::high_resolution_clock::now() - start).count();
+
+        double mops = (ops_per_thread * num_threads) * 1e3 / elapsed;
+        if (num_threads == 1) single_thread_mops = mops;
+        std::cout << "Hot-symbol push/pop, " << num_threads << " threads: "
+                  << mops << " Mops/s (" << mops / single_thread_mops << "x one thread)" << std::endl;
+
+        // A relaxed pop may miss an in-flight push; whatever is left is drained here
+        size_t leftover = 0;
+        while (queue.pop()) ++leftover;
+        EXPECT_EQ(pops.load() + leftover, (ops_per_thread + 1) / 2 * num_threads);
+        EXPECT_TRUE(queue.empty());
+    }
+}
+
+TEST_F(HFTCacheTest, SymbolIndexMaintenanceCost) {
+    // Insert shifts the tail of each sorted order, so cost grows with the
+    // symbol's depth; time order appends and stays flat
+    for (size_t depth : {64, 1024, 16384}) {
+        std::vector<Node> nodes(depth);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> value_dist(100.0, 200.0);
+        std::uniform_int_distribution<int> priority_dist(0, 1000);
+        for (Node& node : nodes) {
+            node.value = value_dist(gen);
+            node.priority = priority_dist(gen);
+        }
+
+        for (unsigned kinds : {unsigned(SymbolIndex::BY_TIME), unsigned(SymbolIndex::ALL)}) {
+            SymbolIndex index(kinds, depth);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (Node& node : nodes) index.insert(&node);
+            for (Node& node : nodes) index.erase(&node);
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+            EXPECT_EQ(index.size(), 0u);
+            std::cout << "SymbolIndex " << (kinds == SymbolIndex::ALL ? "all orders" : "time only")
+                      << ", depth " << depth << ": " << static_cast<double>(elapsed) / (2 * depth)
+                      << " ns per insert or erase" << std::endl;
+        }
+    }
+}
+
+TEST_F(HFTCacheTest, ShardedVersusSharedLatency) {
+    const size_t num_threads = 4;
+    const size_t symbols_per_thread = 16;
+    const size_t ops_per_thread = 20000;
+
+    CacheConfig config = config_;
+    config.max_nodes = num_threads * ops_per_thread;
+    config.list_shards = num_threads;
+    RadialCircularList shared(config);
+    ShardedRadialCircularList sharded(config);
+
+    // Thread t owns every symbol routed to shard t, as a feed handler would
+    std::vector<std::vector<SymbolId>> owned(num_threads);
+    size_t assigned = 0;
+    for (size_t i = 0; assigned < num_threads * symbols_per_thread; ++i) {
+        SymbolId symbol = SymbolRegistry::global().intern("LAT" + std::to_string(i));
+        auto& bucket = owned[sharded.shard_of(symbol)];
+        if (bucket.size() < symbols_per_thread) {
+            bucket.push_back(symbol);
+            ++assigned;
+        }
+    }
+
+    // warm runs on the owning thread before the clock starts
+    auto run = [&](auto& cache, auto warm) {
+        std::atomic<uint64_t> total_ns{0};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                const auto& symbols = owned[t];
+                for (SymbolId symbol : symbols) warm(cache, symbol);
+                auto start = std::chrono::high_resolution_clock::now();
+                for (size_t i = 0; i < ops_per_thread; ++i) {
+                    SymbolId symbol = symbols[i % symbols.size()];
+                    cache.insert(100.0 + i, symbol, static_cast<int>(i % 10), 60.0);
+                    if (i % 2) cache.get_highest_priority(symbol);
+                }
+                total_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::high_resolution_clock::now() - start).count());
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        return static_cast<double>(total_ns.load()) / (num_threads * ops_per_thread);
+    };
+
+    double shared_avg = run(shared, [](RadialCircularList&, SymbolId) {});
+    double sharded_avg = run(sharded, [](ShardedRadialCircularList& cache, SymbolId symbol) {
+        EXPECT_TRUE(cache.warm(symbol));
+    });
+
+    std::cout << "Shared RadialCircularList:  " << shared_avg << " ns/op" << std::endl;
+    std::cout << "ShardedRadialCircularList:  " << sharded_avg << " ns/op" << std::endl;
+    std::cout << "Sharded speedup:            " << shared_avg / sharded_avg << "x" << std::endl;
+}
+
+TEST_F(HFTCacheTest, SIMDKernelSpeedup) {
+    using namespace hft_cache;
+    const char* kernels[] = {"expiry scan", "value range", "priority range", "argmax priority"};
+    SIMDLevel best = detect_simd_level();
+    for (SIMDLevel level : {SIMDLevel::AVX2, SIMDLevel::AVX512}) {
+        if (level > best) continue;
+        SIMDBenchmarkResult result = benchmark_simd_kernels(level);
+        std::cout << simd_level_name(level) << " vs scalar over " << result.elements << " entries:" << std::endl;
+        for (size_t k = 0; k < 4; ++k) {
+            std::cout << "  " << kernels[k] << ": " << result.scalar_ns[k] << " ns -> " << result.vector_ns[k]
+                      << " ns (" << result.speedup(k) << "x)" << std::endl;
+        }
+        std::cout << "  geometric mean: " << result.mean_speedup() << "x" << std::endl;
+        EXPECT_GT(result.mean_speedup(), 0.5);
+    }
+
+    SIMDCache simd(config_);
+    double improvement = simd.get_simd_performance_improvement();
+    std::cout << "get_simd_performance_improvement(): " << improvement << "x" << std::endl;
+    EXPECT_GT(improvement, 0.0);
+    EXPECT_EQ(improvement, simd.get_simd_performance_improvement());  // measured once
+}
+
+TEST_F(HFTCacheTest, MembershipFilterThroughput) {
+    using namespace hft_cache;
+    std::vector<MembershipBenchmarkResult> results = benchmark_membership_filters(200000, 0.01);
+    std::cout << "Deletable membership filters, " << results[0].keys << " keys (ns per operation):" << std::endl;
+    for (const MembershipBenchmarkResult& result : results) {
+        std::cout << "  " << result.filter << ": " << result.bits_per_key << " bits/key, insert " << result.insert_ns
+                  << ", lookup hit " << result.lookup_hit_ns << ", lookup miss " << result.lookup_miss_ns
+                  << ", remove " << result.remove_ns << ", measured FPR " << result.false_positive_rate << std::endl;
+        EXPECT_LT(result.false_positive_rate, 0.02);
+    }
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_LT(results[1].bits_per_key, results[0].bits_per_key);
+    EXPECT_LE(results[1].false_positive_rate, results[0].false_positive_rate);
+}
+
+TEST_F(HFTCacheTest, WorkloadBenchmarkSuite) {
+    using namespace hft_cache;
+    ZipfGenerator zipf(64, 0.99);
+    BenchmarkRng rng(42);
+    std::vector<size_t> counts(64);
+    const size_t draws = 200000;
+    for (size_t i = 0; i < draws; ++i) ++counts[zipf(rng)];
+    EXPECT_NEAR(static_cast<double>(counts[0]) / draws, zipf.probability(0), 0.01);
+    EXPECT_GT(counts[0], counts[1]);
+    EXPECT_GT(counts[1], counts[63]);
+    ZipfGenerator uniform(64, 0.0);
+    EXPECT_DOUBLE_EQ(uniform.probability(0), uniform.probability(63));
+
+    // Every target runs its plan to completion and accounts for every operation
+    WorkloadOptions options;
+    options.threads = 2;
+    options.operations = 2000;
+    options.warmup = 200;
+    options.symbols = 16;
+    options.keys_per_symbol = 64;
+    for (size_t batch : {size_t(1), size_t(8)}) {
+        options.batch = batch;
+        for (size_t t = 0; t < static_cast<size_t>(BenchmarkTarget::COUNT); ++t) {
+            options.target = static_cast<BenchmarkTarget>(t);
+            WorkloadResult result = run_workload(options);
+            std::cout << format_json(result) << std::endl;
+            EXPECT_EQ(result.calls, options.threads * options.operations) << benchmark_target_name(options.target);
+            EXPECT_EQ(result.reads + result.writes, result.calls * batch);
+            EXPECT_EQ(result.failed_writes, 0u) << benchmark_target_name(options.target);
+            EXPECT_GT(result.throughput, 0.0);
+            BenchmarkTarget parsed;
+            ASSERT_TRUE(parse_benchmark_target(benchmark_target_name(options.target), parsed));
+            EXPECT_EQ(parsed, options.target);
+        }
+    }
+
+    // Equal seeds issue equal operations; a preloaded Bloom filter hits every read
+    options.target = BenchmarkTarget::BLOOM;
+    options.seed = 7;
+    WorkloadResult first = run_workload(options);
+    WorkloadResult second = run_workload(options);
+    EXPECT_EQ(first.checksum, second.checksum);
+    EXPECT_EQ(first.reads, second.reads);
+    EXPECT_EQ(first.read_hits, first.reads);
+    options.seed = 8;
+    EXPECT_NE(run_workload(options).checksum, first.checksum);
+
+    std::string header = csv_header();
+    std::string row = format_csv(first);
+    EXPECT_EQ(std::count(header.begin(), header.end(), ','), std::count(row.begin(), row.end(), ','));
+    EXPECT_NE(format_json(first).find("\"target\":\"bloom\""), std::string::npos);
+
+    // Open loop keeps to the schedule, so the run takes as long as it implies
+    options.target = BenchmarkTarget::RADIAL;
+    options.threads = 1;
+    options.batch = 1;
+    options.rate = 20000.0;
+    options.operations = 4000;
+    WorkloadResult paced = run_workload(options);
+    EXPECT_GE(paced.seconds, 0.19);
+    EXPECT_LT(paced.seconds, 1.0);
+    EXPECT_NE(format_json(paced).find("\"open_loop\":true"), std::string::npos);
+}
+
+TEST_F(HFTCacheTest, TraceReplay) {
+    using namespace hft_cache;
+    // A burst on one hot ticker at the open, then a slower spread; every
+    // get follows an insert for its symbol
+    Trace trace;
+    uint16_t open = trace.phase("open");
+    uint16_t midday = trace.phase("midday");
+    uint32_t hot = trace.symbol("REPLAY_HOT");
+    uint32_t cold[] = {trace.symbol("REPLAY_A"), trace.symbol("REPLAY_B")};
+    uint64_t offset = 0;
+    for (int i = 0; i < 2000; ++i, offset += 10000) {
+        trace.insert(offset, hot, 100.0 + i, i % 10, 1000000000, open);
+        trace.get(offset + 5000, hot, open);
+    }
+    for (int i = 0; i < 500; ++i, offset += 40000) {
+        trace.insert(offset, cold[i % 2], 50.0 + i, 5, 0, midday);
+        trace.get(offset + 20000, cold[i % 2], midday);
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "hft_trace_replay_test.trace").string();
+    ASSERT_TRUE(save_trace(path, trace));
+    Trace loaded;
+    ASSERT_TRUE(load_trace(path, loaded));
+    EXPECT_EQ(loaded.symbols, trace.symbols);
+    EXPECT_EQ(loaded.phases, trace.phases);
+    ASSERT_EQ(loaded.events.size(), trace.events.size());
+    EXPECT_EQ(std::memcmp(loaded.events.data(), trace.events.data(), trace.events.size() * sizeof(TraceEvent)), 0);
+
+    ReplayOptions options;
+    options.target = ReplayTarget::RADIAL;
+    options.speed = 0.0;
+    ReplayResult fast = replay_trace(loaded, options);
+    ASSERT_EQ(fast.phases.size(), 2u);
+    EXPECT_EQ(fast.phases[0].phase, "open");
+    EXPECT_EQ(fast.phases[0].inserts, 2000u);
+    EXPECT_EQ(fast.phases[0].get_hits, 2000u);
+    EXPECT_EQ(fast.phases[1].gets, 500u);
+    EXPECT_EQ(fast.total.inserts + fast.total.gets, trace.events.size());
+    EXPECT_EQ(fast.total.failed_inserts, 0u);
+    EXPECT_FALSE(fast.has_tiers);
+
+    // At recorded speed the replay takes as long as the capture, and the
+    // burst shows up as the busier phase; each worker keeps its symbols' order
+    options.speed = 1.0;
+    options.threads = 2;
+    ReplayResult paced = replay_trace(loaded, options);
+    std::cout << format_json(paced) << std::endl;
+    EXPECT_GE(paced.total.seconds, 0.9 * static_cast<double>(offset) / 1e9);
+    EXPECT_EQ(paced.total.get_hits, 2500u);
+    EXPECT_GT(paced.phases[0].throughput, 2 * paced.phases[1].throughput);
+
+    // The multi-level cache adds its tier hit ratios
+    options.target = ReplayTarget::MULTI_LEVEL;
+    options.speed = 0.0;
+    options.threads = 1;
+    ReplayResult tiered = replay_trace(loaded, options);
+    std::cout << format_json(tiered) << std::endl;
+    EXPECT_TRUE(tiered.has_tiers);
+    EXPECT_EQ(tiered.total.gets, 2500u);
+    EXPECT_GT(tiered.l1.hits + tiered.l2.hits + tiered.l3.hits, 0u);
+    EXPECT_NE(format_json(tiered).find("\"tiers\":{\"l1\""), std::string::npos);
+    std::string header = replay_csv_header();
+    std::string rows = format_csv(tiered);
+    EXPECT_EQ(std::count(rows.begin(), rows.end(), '\n'), 2);  // two phases and the total
+    EXPECT_EQ(std::count(rows.begin(), rows.end(), ','), 3 * std::count(header.begin(), header.end(), ','));
+
+    // Damaged traces are refused
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 10);
+    EXPECT_FALSE(load_trace(path, loaded));
+    std::swap(trace.events[0], trace.events[1000]);
+    ASSERT_TRUE(save_trace(path, trace));
+    EXPECT_FALSE(load_trace(path, loaded));
+    EXPECT_FALSE(load_trace(path + ".missing", loaded));
+    std::filesystem::remove(path);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();